@@ -67,6 +67,7 @@ layers_scenes_transitions_nodes/CCTransitionProgress.cpp \
 menu_nodes/CCMenu.cpp \
 menu_nodes/CCMenuItem.cpp \
 misc_nodes/CCClippingNode.cpp \
+misc_nodes/CCClipStack.cpp \
 misc_nodes/CCMotionStreak.cpp \
 misc_nodes/CCProgressTimer.cpp \
 misc_nodes/CCRenderTexture.cpp \
@@ -78,6 +79,8 @@ platform/CCImageCommonWebp.cpp \
 platform/CCSAXParser.cpp \
 platform/CCThread.cpp \
 platform/CCFileUtils.cpp \
+platform/CCPlistParser.cpp \
+platform/CCFilePack.cpp \
 platform/platform.cpp \
 platform/CCEGLViewProtocol.cpp \
 platform/android/CCDevice.cpp \
@@ -129,6 +132,7 @@ textures/CCTextureCache.cpp \
 textures/CCTexturePVR.cpp \
 tilemap_parallax_nodes/CCParallaxNode.cpp \
 tilemap_parallax_nodes/CCTMXLayer.cpp \
+tilemap_parallax_nodes/CCTMXPagedLayer.cpp \
 tilemap_parallax_nodes/CCTMXObjectGroup.cpp \
 tilemap_parallax_nodes/CCTMXTiledMap.cpp \
 tilemap_parallax_nodes/CCTMXXMLParser.cpp \
@@ -44,7 +44,11 @@ THE SOFTWARE.
 #include "CCApplication.h"
 #include "label_nodes/CCLabelBMFont.h"
 #include "label_nodes/CCLabelAtlas.h"
+#if (CC_TARGET_PLATFORM == CC_PLATFORM_LINUX)
+#include "label_nodes/CCFontAtlas.h"
+#endif
 #include "actions/CCActionManager.h"
+#include "effects/CCGrid.h"
 #include "CCConfiguration.h"
 #include "keypad_dispatcher/CCKeypadDispatcher.h"
 #include "CCAccelerometer.h"
@@ -57,6 +61,7 @@ THE SOFTWARE.
 #include "kazmath/GL/matrix.h"
 #include "support/CCProfiling.h"
 #include "CCEGLView.h"
+#include "CCEventType.h"
 #include <string>
 
 /**
@@ -123,6 +128,7 @@ bool CCDirector::init(void)
     m_pFPSLabel = NULL;
     m_pSPFLabel = NULL;
     m_pDrawsLabel = NULL;
+    m_pGLStateLabel = NULL;
     m_bDisplayStats = false;
     m_uTotalFrames = m_uFrames = 0;
     m_pszFPS = new char[10];
@@ -168,6 +174,7 @@ CCDirector::~CCDirector(void)
     CC_SAFE_RELEASE(m_pFPSLabel);
     CC_SAFE_RELEASE(m_pSPFLabel);
     CC_SAFE_RELEASE(m_pDrawsLabel);
+    CC_SAFE_RELEASE(m_pGLStateLabel);
     
     CC_SAFE_RELEASE(m_pRunningScene);
     CC_SAFE_RELEASE(m_pNotificationNode);
@@ -205,6 +212,21 @@ void CCDirector::setGLDefaultValues(void)
     glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
 }
 
+void CCDirector::restoreGLContext(void)
+{
+    ccDrawInit();
+    ccGLInvalidateStateCache();
+
+    CCShaderCache::sharedShaderCache()->reloadDefaultShaders();
+    CCTextureCache::reloadAllTexturesAsync(this, callfunc_selector(CCDirector::glContextTexturesRestored));
+}
+
+void CCDirector::glContextTexturesRestored(void)
+{
+    CCNotificationCenter::sharedNotificationCenter()->postNotification(EVNET_COME_TO_FOREGROUND, NULL);
+    setGLDefaultValues();
+}
+
 // Draw the Scene
 void CCDirector::drawScene(void)
 {
@@ -239,6 +261,9 @@ void CCDirector::drawScene(void)
     {
         m_pNotificationNode->visit();
     }
+
+    // the primitives of a batch left open
+    ccDrawFlush();
     
     if (m_bDisplayStats)
     {
@@ -247,6 +272,8 @@ void CCDirector::drawScene(void)
 
     kmGLPopMatrix();
 
+    ccGLEndStateStatsFrame();
+
     m_uTotalFrames++;
 
     // swap buffers
@@ -403,6 +430,9 @@ void CCDirector::setProjection(ccDirectorProjection kProjection)
 void CCDirector::purgeCachedData(void)
 {
     CCLabelBMFont::purgeCachedData();
+#if (CC_TARGET_PLATFORM == CC_PLATFORM_LINUX)
+    CCFontAtlas::purgeUnusedFontAtlases();
+#endif
     if (s_SharedDirector->getOpenGLView())
     {
         CCTextureCache::sharedTextureCache()->removeUnusedTextures();
@@ -434,13 +464,13 @@ void CCDirector::setDepthTest(bool bOn)
     if (bOn)
     {
         glClearDepth(1.0f);
-        glEnable(GL_DEPTH_TEST);
-        glDepthFunc(GL_LEQUAL);
+        ccGLSetCapability(GL_DEPTH_TEST, true);
+        ccGLDepthFunc(GL_LEQUAL);
 //        glHint(GL_PERSPECTIVE_CORRECTION_HINT, GL_NICEST);
     }
     else
     {
-        glDisable(GL_DEPTH_TEST);
+        ccGLSetCapability(GL_DEPTH_TEST, false);
     }
     CHECK_GL_ERROR_DEBUG();
 }
@@ -641,9 +671,16 @@ void CCDirector::purgeDirector()
     CC_SAFE_RELEASE_NULL(m_pFPSLabel);
     CC_SAFE_RELEASE_NULL(m_pSPFLabel);
     CC_SAFE_RELEASE_NULL(m_pDrawsLabel);
+    CC_SAFE_RELEASE_NULL(m_pGLStateLabel);
 
     // purge bitmap cache
     CCLabelBMFont::purgeCachedData();
+#if (CC_TARGET_PLATFORM == CC_PLATFORM_LINUX)
+    CCFontAtlas::purgeFontAtlases();
+#endif
+
+    // stop the worker threads of the grid effects
+    ccGridStopThreads();
 
     // purge all managed caches
     ccDrawFree();
@@ -748,7 +785,7 @@ void CCDirector::showStats(void)
     
     if (m_bDisplayStats)
     {
-        if (m_pFPSLabel && m_pSPFLabel && m_pDrawsLabel)
+        if (m_pFPSLabel && m_pSPFLabel && m_pDrawsLabel && m_pGLStateLabel)
         {
             if (m_fAccumDt > CC_DIRECTOR_STATS_INTERVAL)
             {
@@ -764,8 +801,22 @@ void CCDirector::showStats(void)
                 
                 sprintf(m_pszFPS, "%4lu", (unsigned long)g_uNumberOfDraws);
                 m_pDrawsLabel->setString(m_pszFPS);
+
+                // GL calls of the last frame, made / skipped by the state cache
+                unsigned int issued = 0, filtered = 0;
+                for (int i = 0; i < kCCGLStateCount; i++)
+                {
+                    unsigned int categoryIssued = 0, categoryFiltered = 0;
+                    ccGLGetStateStats((ccGLStateCategory)i, &categoryIssued, &categoryFiltered);
+                    issued += categoryIssued;
+                    filtered += categoryFiltered;
+                }
+                char glState[32] = {0};
+                sprintf(glState, "%u/%u", issued, filtered);
+                m_pGLStateLabel->setString(glState);
             }
             
+            m_pGLStateLabel->visit();
             m_pDrawsLabel->visit();
             m_pFPSLabel->visit();
             m_pSPFLabel->visit();
@@ -798,6 +849,7 @@ void CCDirector::createStatsLabel()
         CC_SAFE_RELEASE_NULL(m_pFPSLabel);
         CC_SAFE_RELEASE_NULL(m_pSPFLabel);
         CC_SAFE_RELEASE_NULL(m_pDrawsLabel);
+        CC_SAFE_RELEASE_NULL(m_pGLStateLabel);
         CCFileUtils::sharedFileUtils()->purgeCachedEntries();
     }
 
@@ -817,8 +869,13 @@ void CCDirector::createStatsLabel()
     m_pSPFLabel->retain();
     m_pDrawsLabel = CCLabelTTF::create("000", "Arial", fontSize);
     m_pDrawsLabel->retain();
+    m_pGLStateLabel = CCLabelTTF::create("0/0", "Arial", fontSize);
+    m_pGLStateLabel->retain();
 
-    CCSize contentSize = m_pDrawsLabel->getContentSize();
+    CCSize contentSize = m_pGLStateLabel->getContentSize();
+    m_pGLStateLabel->setAnchorPoint(ccp(0, 0.5f));
+    m_pGLStateLabel->setPosition(ccpAdd(ccp(0, contentSize.height*7/2), CC_DIRECTOR_STATS_POSITION));
+    contentSize = m_pDrawsLabel->getContentSize();
     m_pDrawsLabel->setPosition(ccpAdd(ccp(contentSize.width/2, contentSize.height*5/2), CC_DIRECTOR_STATS_POSITION));
     contentSize = m_pSPFLabel->getContentSize();
     m_pSPFLabel->setPosition(ccpAdd(ccp(contentSize.width/2, contentSize.height*3/2), CC_DIRECTOR_STATS_POSITION));
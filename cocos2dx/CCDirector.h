@@ -290,6 +290,14 @@ public:
     /** enables/disables OpenGL depth test */
     void setDepthTest(bool bOn);
 
+    /** Recreates the OpenGL objects of the engine after the OpenGL context was lost,
+     e.g. when an Android application comes back to the foreground.
+     Shaders are reloaded at once and textures asynchronously. EVNET_COME_TO_FOREGROUND is posted
+     and the OpenGL default values are set again once the textures of the running scene are back.
+     @since v2.1.4
+     */
+    void restoreGLContext(void);
+
     virtual void mainLoop(void) = 0;
 
     /** The size in pixels of the surface. It could be different than the screen size.
@@ -346,6 +354,9 @@ protected:
     
     /** calculates delta time since last time it was called */    
     void calculateDeltaTime();
+
+    /** called by restoreGLContext() once the textures of the running scene are restored */
+    void glContextTexturesRestored(void);
 protected:
     /* The CCEGLView, where everything is rendered */
     CCEGLView    *m_pobOpenGLView;
@@ -363,6 +374,8 @@ protected:
     CCLabelTTF *m_pFPSLabel;
     CCLabelTTF *m_pSPFLabel;
     CCLabelTTF *m_pDrawsLabel;
+    //! GL state calls made / skipped by the state cache during the last frame
+    CCLabelTTF *m_pGLStateLabel;
     
     /** Whether or not the Director is paused */
     bool m_bPaused;
@@ -26,9 +26,42 @@ THE SOFTWARE.
 #include "support/CCPointExtension.h"
 #include "CCDirector.h"
 #include "cocoa/CCZone.h"
+#include "effects/CCGrid.h"
 #include <stdlib.h>
 
 NS_CC_BEGIN
+
+// Parameters of the vertex loops of the effects.
+// The loops read the original vertices and write the vertices of the grid directly,
+// the columns of the grid are split between threads by ccGridParallelFor().
+struct ccGrid3DEffectJob
+{
+    const ccVertex3F *pOriginal;
+    ccVertex3F *pVertices;
+    unsigned int uColumns;
+    unsigned int uColumnSize;
+    float fPhase;
+    float fAmplitude;
+    CCPoint tCenter;
+    float fRadius;
+    float fLensEffect;
+    bool bConcave;
+    bool bHorizontal;
+    bool bVertical;
+};
+
+static void ccGrid3DEffectJobInit(ccGrid3DEffectJob *pJob, CCNode *pTarget)
+{
+    CCGrid3D *pGrid = (CCGrid3D*)pTarget->getGrid();
+    const CCSize& gridSize = pGrid->getGridSize();
+
+    *pJob = ccGrid3DEffectJob();
+    pJob->pOriginal = pGrid->getOriginalVertices();
+    pJob->pVertices = pGrid->getVertices();
+    pJob->uColumns = (unsigned int)gridSize.width + 1;
+    pJob->uColumnSize = (unsigned int)gridSize.height + 1;
+}
+
 // implementation of CCWaves3D
 
 CCWaves3D* CCWaves3D::create(float duration, const CCSize& gridSize, unsigned int waves, float amplitude)
@@ -88,21 +121,32 @@ CCObject* CCWaves3D::copyWithZone(CCZone *pZone)
     return pCopy;
 }
 
-void CCWaves3D::update(float time)
+static void waves3DColumns(void *pContext, unsigned int uBegin, unsigned int uEnd)
 {
-    int i, j;
-    for (i = 0; i < m_sGridSize.width + 1; ++i)
+    const ccGrid3DEffectJob *pJob = (const ccGrid3DEffectJob*)pContext;
+    const ccVertex3F *pOriginal = pJob->pOriginal;
+    ccVertex3F *pVertices = pJob->pVertices;
+    float fPhase = pJob->fPhase;
+    float fAmplitude = pJob->fAmplitude;
+
+    for (unsigned int i = uBegin * pJob->uColumnSize, n = uEnd * pJob->uColumnSize; i < n; ++i)
     {
-        for (j = 0; j < m_sGridSize.height + 1; ++j)
-        {
-            ccVertex3F v = originalVertex(ccp(i ,j));
-            v.z += (sinf((float)M_PI * time * m_nWaves * 2 + (v.y+v.x) * 0.01f) * m_fAmplitude * m_fAmplitudeRate);
-            //CCLOG("v.z offset is %f\n", (sinf((float)M_PI * time * m_nWaves * 2 + (v.y+v.x) * .01f) * m_fAmplitude * m_fAmplitudeRate));
-            setVertex(ccp(i, j), v);
-        }
+        ccVertex3F v = pOriginal[i];
+        v.z += sinf(fPhase + (v.y + v.x) * 0.01f) * fAmplitude;
+        pVertices[i] = v;
     }
 }
 
+void CCWaves3D::update(float time)
+{
+    ccGrid3DEffectJob job;
+    ccGrid3DEffectJobInit(&job, m_pTarget);
+    job.fPhase = (float)M_PI * time * m_nWaves * 2;
+    job.fAmplitude = m_fAmplitude * m_fAmplitudeRate;
+
+    ccGridParallelFor(job.uColumns, job.uColumnSize, waves3DColumns, &job);
+}
+
 // implementation of CCFlipX3D
 
 CCFlipX3D* CCFlipX3D::create(float duration)
@@ -408,45 +452,55 @@ void CCLens3D::setPosition(const CCPoint& pos)
     }
 }
 
-void CCLens3D::update(float time)
+static void lens3DColumns(void *pContext, unsigned int uBegin, unsigned int uEnd)
 {
-    CC_UNUSED_PARAM(time);
-    if (m_bDirty)
+    const ccGrid3DEffectJob *pJob = (const ccGrid3DEffectJob*)pContext;
+    const ccVertex3F *pOriginal = pJob->pOriginal;
+    ccVertex3F *pVertices = pJob->pVertices;
+    float cx = pJob->tCenter.x;
+    float cy = pJob->tCenter.y;
+    float fRadius = pJob->fRadius;
+    float fLensEffect = pJob->fLensEffect;
+    float fSign = pJob->bConcave ? -1.0f : 1.0f;
+
+    for (unsigned int i = uBegin * pJob->uColumnSize, n = uEnd * pJob->uColumnSize; i < n; ++i)
     {
-        int i, j;
-        
-        for (i = 0; i < m_sGridSize.width + 1; ++i)
+        ccVertex3F v = pOriginal[i];
+        float dx = cx - v.x;
+        float dy = cy - v.y;
+        float r = sqrtf(dx * dx + dy * dy);
+
+        if (r < fRadius && r > 0)
         {
-            for (j = 0; j < m_sGridSize.height + 1; ++j)
+            float pre_log = (fRadius - r) / fRadius;
+            if ( pre_log == 0 )
             {
-                ccVertex3F v = originalVertex(ccp(i, j));
-                CCPoint vect = ccpSub(m_position, ccp(v.x, v.y));
-                float r = ccpLength(vect);
-                
-                if (r < m_fRadius)
-                {
-                    r = m_fRadius - r;
-                    float pre_log = r / m_fRadius;
-                    if ( pre_log == 0 ) 
-                    {
-                        pre_log = 0.001f;
-                    }
-
-                    float l = logf(pre_log) * m_fLensEffect;
-                    float new_r = expf( l ) * m_fRadius;
-                    
-                    if (ccpLength(vect) > 0)
-                    {
-                        vect = ccpNormalize(vect);
-                        CCPoint new_vect = ccpMult(vect, new_r);
-                        v.z += (m_bConcave ? -1.0f : 1.0f) * ccpLength(new_vect) * m_fLensEffect;
-                    }
-                }
-                
-                setVertex(ccp(i, j), v);
+                pre_log = 0.001f;
             }
+
+            // the length of the displacement is exp(log(pre_log) * lensEffect) * radius
+            float new_r = powf(pre_log, fLensEffect) * fRadius;
+            v.z += fSign * new_r * fLensEffect;
         }
-        
+
+        pVertices[i] = v;
+    }
+}
+
+void CCLens3D::update(float time)
+{
+    CC_UNUSED_PARAM(time);
+    if (m_bDirty)
+    {
+        ccGrid3DEffectJob job;
+        ccGrid3DEffectJobInit(&job, m_pTarget);
+        job.tCenter = m_position;
+        job.fRadius = m_fRadius;
+        job.fLensEffect = m_fLensEffect;
+        job.bConcave = m_bConcave;
+
+        ccGridParallelFor(job.uColumns, job.uColumnSize, lens3DColumns, &job);
+
         m_bDirty = false;
     }
 }
@@ -516,30 +570,47 @@ CCObject* CCRipple3D::copyWithZone(CCZone *pZone)
     return pCopy;
 }
 
-void CCRipple3D::update(float time)
+static void ripple3DColumns(void *pContext, unsigned int uBegin, unsigned int uEnd)
 {
-    int i, j;
+    const ccGrid3DEffectJob *pJob = (const ccGrid3DEffectJob*)pContext;
+    const ccVertex3F *pOriginal = pJob->pOriginal;
+    ccVertex3F *pVertices = pJob->pVertices;
+    float cx = pJob->tCenter.x;
+    float cy = pJob->tCenter.y;
+    float fRadius = pJob->fRadius;
+    float fPhase = pJob->fPhase;
+    float fAmplitude = pJob->fAmplitude;
 
-    for (i = 0; i < (m_sGridSize.width+1); ++i)
+    for (unsigned int i = uBegin * pJob->uColumnSize, n = uEnd * pJob->uColumnSize; i < n; ++i)
     {
-        for (j = 0; j < (m_sGridSize.height+1); ++j)
+        ccVertex3F v = pOriginal[i];
+        float dx = cx - v.x;
+        float dy = cy - v.y;
+        float r = sqrtf(dx * dx + dy * dy);
+
+        if (r < fRadius)
         {
-            ccVertex3F v = originalVertex(ccp(i, j));
-            CCPoint vect = ccpSub(m_position, ccp(v.x,v.y));
-            float r = ccpLength(vect);
-            
-            if (r < m_fRadius)
-            {
-                r = m_fRadius - r;
-                float rate = powf(r / m_fRadius, 2);
-                v.z += (sinf( time*(float)M_PI * m_nWaves * 2 + r * 0.1f) * m_fAmplitude * m_fAmplitudeRate * rate);
-            }
-            
-            setVertex(ccp(i, j), v);
+            r = fRadius - r;
+            float rate = r / fRadius;
+            v.z += sinf(fPhase + r * 0.1f) * fAmplitude * rate * rate;
         }
+
+        pVertices[i] = v;
     }
 }
 
+void CCRipple3D::update(float time)
+{
+    ccGrid3DEffectJob job;
+    ccGrid3DEffectJobInit(&job, m_pTarget);
+    job.tCenter = m_position;
+    job.fRadius = m_fRadius;
+    job.fPhase = time * (float)M_PI * m_nWaves * 2;
+    job.fAmplitude = m_fAmplitude * m_fAmplitudeRate;
+
+    ccGridParallelFor(job.uColumns, job.uColumnSize, ripple3DColumns, &job);
+}
+
 // implementation of Shaky3D
 
 CCShaky3D* CCShaky3D::create(float duration, const CCSize& gridSize, int range, bool shakeZ)
@@ -600,22 +671,22 @@ CCObject* CCShaky3D::copyWithZone(CCZone *pZone)
 void CCShaky3D::update(float time)
 {
     CC_UNUSED_PARAM(time);
-    int i, j;
 
-    for (i = 0; i < (m_sGridSize.width+1); ++i)
+    // rand() is not thread-safe, the vertices are updated by this thread
+    ccGrid3DEffectJob job;
+    ccGrid3DEffectJobInit(&job, m_pTarget);
+
+    for (unsigned int i = 0, n = job.uColumns * job.uColumnSize; i < n; ++i)
     {
-        for (j = 0; j < (m_sGridSize.height+1); ++j)
+        ccVertex3F v = job.pOriginal[i];
+        v.x += (rand() % (m_nRandrange*2)) - m_nRandrange;
+        v.y += (rand() % (m_nRandrange*2)) - m_nRandrange;
+        if (m_bShakeZ)
         {
-            ccVertex3F v = originalVertex(ccp(i ,j));
-            v.x += (rand() % (m_nRandrange*2)) - m_nRandrange;
-            v.y += (rand() % (m_nRandrange*2)) - m_nRandrange;
-            if (m_bShakeZ)
-            {
-                v.z += (rand() % (m_nRandrange*2)) - m_nRandrange;
-            }
-            
-            setVertex(ccp(i, j), v);
+            v.z += (rand() % (m_nRandrange*2)) - m_nRandrange;
         }
+
+        job.pVertices[i] = v;
     }
 }
 
@@ -677,22 +748,41 @@ CCObject* CCLiquid::copyWithZone(CCZone *pZone)
     return pCopy;
 }
 
-void CCLiquid::update(float time)
+static void liquidColumns(void *pContext, unsigned int uBegin, unsigned int uEnd)
 {
-    int i, j;
+    const ccGrid3DEffectJob *pJob = (const ccGrid3DEffectJob*)pContext;
+    float fPhase = pJob->fPhase;
+    float fAmplitude = pJob->fAmplitude;
+    unsigned int uColumnSize = pJob->uColumnSize;
 
-    for (i = 1; i < m_sGridSize.width; ++i)
+    // the vertices on the borders of the grid don't move
+    uBegin = MAX(uBegin, 1);
+    uEnd = MIN(uEnd, pJob->uColumns - 1);
+    for (unsigned int i = uBegin; i < uEnd; ++i)
     {
-        for (j = 1; j < m_sGridSize.height; ++j)
+        const ccVertex3F *pOriginal = pJob->pOriginal + i * uColumnSize;
+        ccVertex3F *pVertices = pJob->pVertices + i * uColumnSize;
+
+        for (unsigned int j = 1; j < uColumnSize - 1; ++j)
         {
-            ccVertex3F v = originalVertex(ccp(i, j));
-            v.x = (v.x + (sinf(time * (float)M_PI * m_nWaves * 2 + v.x * .01f) * m_fAmplitude * m_fAmplitudeRate));
-            v.y = (v.y + (sinf(time * (float)M_PI * m_nWaves * 2 + v.y * .01f) * m_fAmplitude * m_fAmplitudeRate));
-            setVertex(ccp(i, j), v);
+            ccVertex3F v = pOriginal[j];
+            v.x += sinf(fPhase + v.x * .01f) * fAmplitude;
+            v.y += sinf(fPhase + v.y * .01f) * fAmplitude;
+            pVertices[j] = v;
         }
     }
 }
 
+void CCLiquid::update(float time)
+{
+    ccGrid3DEffectJob job;
+    ccGrid3DEffectJobInit(&job, m_pTarget);
+    job.fPhase = time * (float)M_PI * m_nWaves * 2;
+    job.fAmplitude = m_fAmplitude * m_fAmplitudeRate;
+
+    ccGridParallelFor(job.uColumns, job.uColumnSize, liquidColumns, &job);
+}
+
 // implementation of Waves
 
 CCWaves* CCWaves::create(float duration, const CCSize& gridSize, unsigned int waves, float amplitude, bool horizontal, bool vertical)
@@ -753,31 +843,46 @@ CCObject* CCWaves::copyWithZone(CCZone *pZone)
     return pCopy;
 }
 
-void CCWaves::update(float time)
+static void wavesColumns(void *pContext, unsigned int uBegin, unsigned int uEnd)
 {
-    int i, j;
+    const ccGrid3DEffectJob *pJob = (const ccGrid3DEffectJob*)pContext;
+    const ccVertex3F *pOriginal = pJob->pOriginal;
+    ccVertex3F *pVertices = pJob->pVertices;
+    float fPhase = pJob->fPhase;
+    float fAmplitude = pJob->fAmplitude;
+    bool bVertical = pJob->bVertical;
+    bool bHorizontal = pJob->bHorizontal;
 
-    for (i = 0; i < m_sGridSize.width + 1; ++i)
+    for (unsigned int i = uBegin * pJob->uColumnSize, n = uEnd * pJob->uColumnSize; i < n; ++i)
     {
-        for (j = 0; j < m_sGridSize.height + 1; ++j)
-        {
-            ccVertex3F v = originalVertex(ccp(i, j));
+        ccVertex3F v = pOriginal[i];
 
-            if (m_bVertical)
-            {
-                v.x = (v.x + (sinf(time * (float)M_PI * m_nWaves * 2 + v.y * .01f) * m_fAmplitude * m_fAmplitudeRate));
-            }
-
-            if (m_bHorizontal)
-            {
-                v.y = (v.y + (sinf(time * (float)M_PI * m_nWaves * 2 + v.x * .01f) * m_fAmplitude * m_fAmplitudeRate));
-            }
+        if (bVertical)
+        {
+            v.x += sinf(fPhase + v.y * .01f) * fAmplitude;
+        }
 
-            setVertex(ccp(i, j), v);
+        if (bHorizontal)
+        {
+            v.y += sinf(fPhase + v.x * .01f) * fAmplitude;
         }
+
+        pVertices[i] = v;
     }
 }
 
+void CCWaves::update(float time)
+{
+    ccGrid3DEffectJob job;
+    ccGrid3DEffectJobInit(&job, m_pTarget);
+    job.fPhase = time * (float)M_PI * m_nWaves * 2;
+    job.fAmplitude = m_fAmplitude * m_fAmplitudeRate;
+    job.bVertical = m_bVertical;
+    job.bHorizontal = m_bHorizontal;
+
+    ccGridParallelFor(job.uColumns, job.uColumnSize, wavesColumns, &job);
+}
+
 // implementation of Twirl
 
 CCTwirl* CCTwirl::create(float duration, const CCSize& gridSize, CCPoint position, unsigned int twirls, float amplitude)
@@ -843,34 +948,49 @@ CCObject* CCTwirl::copyWithZone(CCZone *pZone)
     return pCopy;
 }
 
-void CCTwirl::update(float time)
+static void twirlColumns(void *pContext, unsigned int uBegin, unsigned int uEnd)
 {
-    int i, j;
-    CCPoint    c = m_position;
-    
-    for (i = 0; i < (m_sGridSize.width+1); ++i)
+    const ccGrid3DEffectJob *pJob = (const ccGrid3DEffectJob*)pContext;
+    float cx = pJob->tCenter.x;
+    float cy = pJob->tCenter.y;
+    // the angle of a vertex is its distance to the center of the grid, in vertices, times the amplitude
+    float fAmplitude = pJob->fAmplitude;
+    unsigned int uColumnSize = pJob->uColumnSize;
+    float fHalfWidth = (pJob->uColumns - 1) / 2.0f;
+    float fHalfHeight = (uColumnSize - 1) / 2.0f;
+
+    for (unsigned int i = uBegin; i < uEnd; ++i)
     {
-        for (j = 0; j < (m_sGridSize.height+1); ++j)
+        const ccVertex3F *pOriginal = pJob->pOriginal + i * uColumnSize;
+        ccVertex3F *pVertices = pJob->pVertices + i * uColumnSize;
+        float ax = i - fHalfWidth;
+
+        for (unsigned int j = 0; j < uColumnSize; ++j)
         {
-            ccVertex3F v = originalVertex(ccp(i ,j));
-            
-            CCPoint    avg = ccp(i-(m_sGridSize.width/2.0f), j-(m_sGridSize.height/2.0f));
-            float r = ccpLength(avg);
-            
-            float amp = 0.1f * m_fAmplitude * m_fAmplitudeRate;
-            float a = r * cosf( (float)M_PI/2.0f + time * (float)M_PI * m_nTwirls * 2 ) * amp;
-            
-            CCPoint d = ccp(
-                sinf(a) * (v.y-c.y) + cosf(a) * (v.x-c.x),
-                cosf(a) * (v.y-c.y) - sinf(a) * (v.x-c.x));
-            
-            v.x = c.x + d.x;
-            v.y = c.y + d.y;
-
-            setVertex(ccp(i ,j), v);
+            ccVertex3F v = pOriginal[j];
+            float ay = j - fHalfHeight;
+            float a = sqrtf(ax * ax + ay * ay) * fAmplitude;
+            float sina = sinf(a);
+            float cosa = cosf(a);
+            float dx = v.x - cx;
+            float dy = v.y - cy;
+
+            v.x = cx + sina * dy + cosa * dx;
+            v.y = cy + cosa * dy - sina * dx;
+            pVertices[j] = v;
         }
     }
 }
 
+void CCTwirl::update(float time)
+{
+    ccGrid3DEffectJob job;
+    ccGrid3DEffectJobInit(&job, m_pTarget);
+    job.tCenter = m_position;
+    job.fAmplitude = cosf( (float)M_PI/2.0f + time * (float)M_PI * m_nTwirls * 2 ) * 0.1f * m_fAmplitude * m_fAmplitudeRate;
+
+    ccGridParallelFor(job.uColumns, job.uColumnSize, twirlColumns, &job);
+}
+
 NS_CC_END
 
@@ -32,6 +32,63 @@ THE SOFTWARE.
 
 NS_CC_BEGIN
 
+// Parameters of the tile loops of the effects.
+// The loops read the original tiles and write the tiles of the grid directly,
+// the columns of the grid are split between threads by ccGridParallelFor().
+struct ccTiledGridEffectJob
+{
+    const ccQuad3 *pOriginal;
+    ccQuad3 *pTiles;
+    unsigned int uColumns;
+    unsigned int uColumnSize;
+    float fPhase;
+    float fAmplitude;
+    float fOddAmplitude;
+};
+
+static void ccTiledGridEffectJobInit(ccTiledGridEffectJob *pJob, CCNode *pTarget)
+{
+    CCTiledGrid3D *pGrid = (CCTiledGrid3D*)pTarget->getGrid();
+    const CCSize& gridSize = pGrid->getGridSize();
+
+    *pJob = ccTiledGridEffectJob();
+    pJob->pOriginal = pGrid->getOriginalTiles();
+    pJob->pTiles = pGrid->getTiles();
+    pJob->uColumns = (unsigned int)gridSize.width;
+    pJob->uColumnSize = (unsigned int)gridSize.height;
+}
+
+// adds a random offset in [-nRange, nRange) to the coordinates of the tiles, rand() is not thread-safe
+static void shakeTiles(const ccTiledGridEffectJob *pJob, int nRange, bool bShakeZ)
+{
+    for (unsigned int i = 0, n = pJob->uColumns * pJob->uColumnSize; i < n; ++i)
+    {
+        ccQuad3 coords = pJob->pOriginal[i];
+
+        // X
+        coords.bl.x += ( rand() % (nRange*2) ) - nRange;
+        coords.br.x += ( rand() % (nRange*2) ) - nRange;
+        coords.tl.x += ( rand() % (nRange*2) ) - nRange;
+        coords.tr.x += ( rand() % (nRange*2) ) - nRange;
+
+        // Y
+        coords.bl.y += ( rand() % (nRange*2) ) - nRange;
+        coords.br.y += ( rand() % (nRange*2) ) - nRange;
+        coords.tl.y += ( rand() % (nRange*2) ) - nRange;
+        coords.tr.y += ( rand() % (nRange*2) ) - nRange;
+
+        if (bShakeZ)
+        {
+            coords.bl.z += ( rand() % (nRange*2) ) - nRange;
+            coords.br.z += ( rand() % (nRange*2) ) - nRange;
+            coords.tl.z += ( rand() % (nRange*2) ) - nRange;
+            coords.tr.z += ( rand() % (nRange*2) ) - nRange;
+        }
+
+        pJob->pTiles[i] = coords;
+    }
+}
+
 struct Tile
 {
     CCPoint    position;
@@ -99,37 +156,10 @@ CCObject* CCShakyTiles3D::copyWithZone(CCZone *pZone)
 void CCShakyTiles3D::update(float time)
 {
     CC_UNUSED_PARAM(time);
-    int i, j;
-
-    for (i = 0; i < m_sGridSize.width; ++i)
-    {
-        for (j = 0; j < m_sGridSize.height; ++j)
-        {
-            ccQuad3 coords = originalTile(ccp(i, j));
-
-            // X
-            coords.bl.x += ( rand() % (m_nRandrange*2) ) - m_nRandrange;
-            coords.br.x += ( rand() % (m_nRandrange*2) ) - m_nRandrange;
-            coords.tl.x += ( rand() % (m_nRandrange*2) ) - m_nRandrange;
-            coords.tr.x += ( rand() % (m_nRandrange*2) ) - m_nRandrange;
-
-            // Y
-            coords.bl.y += ( rand() % (m_nRandrange*2) ) - m_nRandrange;
-            coords.br.y += ( rand() % (m_nRandrange*2) ) - m_nRandrange;
-            coords.tl.y += ( rand() % (m_nRandrange*2) ) - m_nRandrange;
-            coords.tr.y += ( rand() % (m_nRandrange*2) ) - m_nRandrange;
 
-            if (m_bShakeZ)
-            {
-                coords.bl.z += ( rand() % (m_nRandrange*2) ) - m_nRandrange;
-                coords.br.z += ( rand() % (m_nRandrange*2) ) - m_nRandrange;
-                coords.tl.z += ( rand() % (m_nRandrange*2) ) - m_nRandrange;
-                coords.tr.z += ( rand() % (m_nRandrange*2) ) - m_nRandrange;
-            }
-                        
-            setTile(ccp(i, j), coords);
-        }
-    }
+    ccTiledGridEffectJob job;
+    ccTiledGridEffectJobInit(&job, m_pTarget);
+    shakeTiles(&job, m_nRandrange, m_bShakeZ);
 }
 
 // implementation of CCShatteredTiles3D
@@ -193,40 +223,13 @@ CCObject* CCShatteredTiles3D::copyWithZone(CCZone *pZone)
 void CCShatteredTiles3D::update(float time)
 {
     CC_UNUSED_PARAM(time);
-    int i, j;
 
     if (m_bOnce == false)
     {
-        for (i = 0; i < m_sGridSize.width; ++i)
-        {
-            for (j = 0; j < m_sGridSize.height; ++j)
-            {
-                ccQuad3 coords = originalTile(ccp(i ,j));
-                
-                // X
-                coords.bl.x += ( rand() % (m_nRandrange*2) ) - m_nRandrange;
-                coords.br.x += ( rand() % (m_nRandrange*2) ) - m_nRandrange;
-                coords.tl.x += ( rand() % (m_nRandrange*2) ) - m_nRandrange;
-                coords.tr.x += ( rand() % (m_nRandrange*2) ) - m_nRandrange;
-                
-                // Y
-                coords.bl.y += ( rand() % (m_nRandrange*2) ) - m_nRandrange;
-                coords.br.y += ( rand() % (m_nRandrange*2) ) - m_nRandrange;
-                coords.tl.y += ( rand() % (m_nRandrange*2) ) - m_nRandrange;
-                coords.tr.y += ( rand() % (m_nRandrange*2) ) - m_nRandrange;
-
-                if (m_bShatterZ) 
-                {
-                    coords.bl.z += ( rand() % (m_nRandrange*2) ) - m_nRandrange;
-                    coords.br.z += ( rand() % (m_nRandrange*2) ) - m_nRandrange;                
-                    coords.tl.z += ( rand() % (m_nRandrange*2) ) - m_nRandrange;
-                    coords.tr.z += ( rand() % (m_nRandrange*2) ) - m_nRandrange;
-                }
-                
-                setTile(ccp(i, j), coords);
-            }
-        }
-        
+        ccTiledGridEffectJob job;
+        ccTiledGridEffectJobInit(&job, m_pTarget);
+        shakeTiles(&job, m_nRandrange, m_bShatterZ);
+
         m_bOnce = true;
     }
 }
@@ -320,22 +323,27 @@ CCSize CCShuffleTiles::getDelta(const CCSize& pos)
 
 void CCShuffleTiles::placeTile(const CCPoint& pos, Tile *t)
 {
-    ccQuad3 coords = originalTile(pos);
+    CCTiledGrid3D *pGrid = (CCTiledGrid3D*)m_pTarget->getGrid();
+    unsigned int idx = (unsigned int)(pos.x * m_sGridSize.height + pos.y);
+    ccQuad3 coords = pGrid->getOriginalTiles()[idx];
 
-    CCPoint step = m_pTarget->getGrid()->getStep();
-    coords.bl.x += (int)(t->position.x * step.x);
-    coords.bl.y += (int)(t->position.y * step.y);
+    CCPoint step = pGrid->getStep();
+    float dx = (float)(int)(t->position.x * step.x);
+    float dy = (float)(int)(t->position.y * step.y);
 
-    coords.br.x += (int)(t->position.x * step.x);
-    coords.br.y += (int)(t->position.y * step.y);
+    coords.bl.x += dx;
+    coords.bl.y += dy;
 
-    coords.tl.x += (int)(t->position.x * step.x);
-    coords.tl.y += (int)(t->position.y * step.y);
+    coords.br.x += dx;
+    coords.br.y += dy;
 
-    coords.tr.x += (int)(t->position.x * step.x);
-    coords.tr.y += (int)(t->position.y * step.y);
+    coords.tl.x += dx;
+    coords.tl.y += dy;
 
-    setTile(pos, coords);
+    coords.tr.x += dx;
+    coords.tr.y += dy;
+
+    pGrid->getTiles()[idx] = coords;
 }
 
 void CCShuffleTiles::startWithTarget(CCNode *pTarget)
@@ -429,14 +437,16 @@ float CCFadeOutTRTiles::testFunc(const CCSize& pos, float time)
 
 void CCFadeOutTRTiles::turnOnTile(const CCPoint& pos)
 {
-    setTile(pos, originalTile(pos));
+    CCTiledGrid3D *pGrid = (CCTiledGrid3D*)m_pTarget->getGrid();
+    unsigned int idx = (unsigned int)(pos.x * m_sGridSize.height + pos.y);
+    pGrid->getTiles()[idx] = pGrid->getOriginalTiles()[idx];
 }
 
 void CCFadeOutTRTiles::turnOffTile(const CCPoint& pos)
 {
-    ccQuad3 coords;
-    memset(&coords, 0, sizeof(ccQuad3));
-    setTile(pos, coords);
+    CCTiledGrid3D *pGrid = (CCTiledGrid3D*)m_pTarget->getGrid();
+    unsigned int idx = (unsigned int)(pos.x * m_sGridSize.height + pos.y);
+    memset(&pGrid->getTiles()[idx], 0, sizeof(ccQuad3));
 }
 
 void CCFadeOutTRTiles::transformTile(const CCPoint& pos, float distance)
@@ -682,15 +692,16 @@ void CCTurnOffTiles::shuffle(unsigned int *pArray, unsigned int nLen)
 
 void CCTurnOffTiles::turnOnTile(const CCPoint& pos)
 {
-    setTile(pos, originalTile(pos));
+    CCTiledGrid3D *pGrid = (CCTiledGrid3D*)m_pTarget->getGrid();
+    unsigned int idx = (unsigned int)(pos.x * m_sGridSize.height + pos.y);
+    pGrid->getTiles()[idx] = pGrid->getOriginalTiles()[idx];
 }
 
 void CCTurnOffTiles::turnOffTile(const CCPoint& pos)
 {
-    ccQuad3 coords;
-
-    memset(&coords, 0, sizeof(ccQuad3));
-    setTile(pos, coords);
+    CCTiledGrid3D *pGrid = (CCTiledGrid3D*)m_pTarget->getGrid();
+    unsigned int idx = (unsigned int)(pos.x * m_sGridSize.height + pos.y);
+    memset(&pGrid->getTiles()[idx], 0, sizeof(ccQuad3));
 }
 
 void CCTurnOffTiles::startWithTarget(CCNode *pTarget)
@@ -721,18 +732,22 @@ void CCTurnOffTiles::update(float time)
 
     l = (unsigned int)(time * (float)m_nTilesCount);
 
+    // the tiles are in the order of the grid, the index of a tile is its index in the grid
+    CCTiledGrid3D *pGrid = (CCTiledGrid3D*)m_pTarget->getGrid();
+    const ccQuad3 *pOriginal = pGrid->getOriginalTiles();
+    ccQuad3 *pTiles = pGrid->getTiles();
+
     for( i = 0; i < m_nTilesCount; i++ )
     {
         t = m_pTilesOrder[i];
-        CCPoint tilePos = ccp( (unsigned int)(t / m_sGridSize.height), t % (unsigned int)m_sGridSize.height );
 
         if ( i < l )
         {
-            turnOffTile(tilePos);
+            memset(&pTiles[t], 0, sizeof(ccQuad3));
         }
         else
         {
-            turnOnTile(tilePos);
+            pTiles[t] = pOriginal[t];
         }
     }
 }
@@ -794,27 +809,38 @@ CCObject* CCWavesTiles3D::copyWithZone(CCZone *pZone)
     return pCopy;
 }
 
-void CCWavesTiles3D::update(float time)
+static void wavesTiles3DColumns(void *pContext, unsigned int uBegin, unsigned int uEnd)
 {
-    int i, j;
+    const ccTiledGridEffectJob *pJob = (const ccTiledGridEffectJob*)pContext;
+    const ccQuad3 *pOriginal = pJob->pOriginal;
+    ccQuad3 *pTiles = pJob->pTiles;
+    float fPhase = pJob->fPhase;
+    float fAmplitude = pJob->fAmplitude;
 
-    for( i = 0; i < m_sGridSize.width; i++ )
+    for (unsigned int i = uBegin * pJob->uColumnSize, n = uEnd * pJob->uColumnSize; i < n; ++i)
     {
-        for( j = 0; j < m_sGridSize.height; j++ )
-        {
-            ccQuad3 coords = originalTile(ccp(i, j));
+        ccQuad3 coords = pOriginal[i];
+        float z = sinf(fPhase + (coords.bl.y + coords.bl.x) * .01f) * fAmplitude;
 
-            coords.bl.z = (sinf(time * (float)M_PI  *m_nWaves * 2 + 
-                (coords.bl.y+coords.bl.x) * .01f) * m_fAmplitude * m_fAmplitudeRate );
-            coords.br.z    = coords.bl.z;
-            coords.tl.z = coords.bl.z;
-            coords.tr.z = coords.bl.z;
+        coords.bl.z = z;
+        coords.br.z = z;
+        coords.tl.z = z;
+        coords.tr.z = z;
 
-            setTile(ccp(i, j), coords);
-        }
+        pTiles[i] = coords;
     }
 }
 
+void CCWavesTiles3D::update(float time)
+{
+    ccTiledGridEffectJob job;
+    ccTiledGridEffectJobInit(&job, m_pTarget);
+    job.fPhase = time * (float)M_PI * m_nWaves * 2;
+    job.fAmplitude = m_fAmplitude * m_fAmplitudeRate;
+
+    ccGridParallelFor(job.uColumns, job.uColumnSize, wavesTiles3DColumns, &job);
+}
+
 // implementation of CCJumpTiles3D
 
 CCJumpTiles3D* CCJumpTiles3D::create(float duration, const CCSize& gridSize, unsigned int numberOfJumps, float amplitude)
@@ -871,39 +897,41 @@ CCObject* CCJumpTiles3D::copyWithZone(CCZone *pZone)
     return pCopy;
 }
 
-void CCJumpTiles3D::update(float time)
+static void jumpTiles3DColumns(void *pContext, unsigned int uBegin, unsigned int uEnd)
 {
-    int i, j;
+    const ccTiledGridEffectJob *pJob = (const ccTiledGridEffectJob*)pContext;
+    unsigned int uColumnSize = pJob->uColumnSize;
 
-    float sinz =  (sinf((float)M_PI * time * m_nJumps * 2) * m_fAmplitude * m_fAmplitudeRate );
-    float sinz2 = (sinf((float)M_PI * (time * m_nJumps * 2 + 1)) * m_fAmplitude * m_fAmplitudeRate );
-
-    for( i = 0; i < m_sGridSize.width; i++ )
+    for (unsigned int i = uBegin; i < uEnd; ++i)
     {
-        for( j = 0; j < m_sGridSize.height; j++ )
+        const ccQuad3 *pOriginal = pJob->pOriginal + i * uColumnSize;
+        ccQuad3 *pTiles = pJob->pTiles + i * uColumnSize;
+
+        for (unsigned int j = 0; j < uColumnSize; ++j)
         {
-            ccQuad3 coords = originalTile(ccp(i, j));
+            ccQuad3 coords = pOriginal[j];
+            float z = ((i + j) % 2) == 0 ? pJob->fAmplitude : pJob->fOddAmplitude;
 
-            if ( ((i+j) % 2) == 0 )
-            {
-                coords.bl.z += sinz;
-                coords.br.z += sinz;
-                coords.tl.z += sinz;
-                coords.tr.z += sinz;
-            }
-            else
-            {
-                coords.bl.z += sinz2;
-                coords.br.z += sinz2;
-                coords.tl.z += sinz2;
-                coords.tr.z += sinz2;
-            }
+            coords.bl.z += z;
+            coords.br.z += z;
+            coords.tl.z += z;
+            coords.tr.z += z;
 
-            setTile(ccp(i, j), coords);
+            pTiles[j] = coords;
         }
     }
 }
 
+void CCJumpTiles3D::update(float time)
+{
+    ccTiledGridEffectJob job;
+    ccTiledGridEffectJobInit(&job, m_pTarget);
+    job.fAmplitude = (sinf((float)M_PI * time * m_nJumps * 2) * m_fAmplitude * m_fAmplitudeRate );
+    job.fOddAmplitude = (sinf((float)M_PI * (time * m_nJumps * 2 + 1)) * m_fAmplitude * m_fAmplitudeRate );
+
+    ccGridParallelFor(job.uColumns, job.uColumnSize, jumpTiles3DColumns, &job);
+}
+
 // implementation of CCSplitRows
 
 CCSplitRows* CCSplitRows::create(float duration, unsigned int nRows)
@@ -36,6 +36,11 @@ THE SOFTWARE.
 #include "actions/CCActionManager.h"
 #include "script_support/CCScriptSupport.h"
 #include "shaders/CCGLProgram.h"
+#include "misc_nodes/CCRenderTexture.h"
+#include "sprite_nodes/CCSprite.h"
+#include "support/CCNotificationCenter.h"
+#include "CCConfiguration.h"
+#include "CCEventType.h"
 // externals
 #include "kazmath/GL/matrix.h"
 
@@ -51,6 +56,11 @@ NS_CC_BEGIN
 // XXX: Yes, nodes might have a sort problem once every 15 days if the game runs at 60 FPS and each frame sprites are reordered.
 static int s_globalOrderOfArrival = 1;
 
+// number of nodes caching their subtree as a bitmap, nothing is marked dirty when there is none
+static unsigned int s_uBitmapCacheCount = 0;
+// number of bitmap caches being drawn, the cached nodes they contain are drawn directly
+static unsigned int s_uBitmapCacheRenderDepth = 0;
+
 CCNode::CCNode(void)
 : m_fRotationX(0.0f)
 , m_fRotationY(0.0f)
@@ -88,6 +98,11 @@ CCNode::CCNode(void)
 , m_bReorderChildDirty(false)
 , m_nScriptHandler(0)
 , m_nUpdateScriptHandler(0)
+, m_bCacheAsBitmap(false)
+, m_bBitmapCacheDirty(false)
+, m_pBitmapCache(NULL)
+, m_obBitmapCacheRect(CCRectZero)
+, m_uBitmapCacheRenderCount(0)
 {
     // set default scheduler and actionManager
     CCDirector *director = CCDirector::sharedDirector();
@@ -119,6 +134,8 @@ CCNode::~CCNode(void)
     CC_SAFE_RELEASE(m_pShaderProgram);
     CC_SAFE_RELEASE(m_pUserObject);
 
+    setCacheAsBitmap(false);
+
     if(m_pChildren && m_pChildren->count() > 0)
     {
         CCObject* child;
@@ -150,6 +167,7 @@ void CCNode::setSkewX(float newSkewX)
 {
     m_fSkewX = newSkewX;
     m_bTransformDirty = m_bInverseDirty = true;
+    markBitmapCachesDirty(m_pParent);
 }
 
 float CCNode::getSkewY()
@@ -162,6 +180,7 @@ void CCNode::setSkewY(float newSkewY)
     m_fSkewY = newSkewY;
 
     m_bTransformDirty = m_bInverseDirty = true;
+    markBitmapCachesDirty(m_pParent);
 }
 
 /// zOrder getter
@@ -197,6 +216,7 @@ float CCNode::getVertexZ()
 void CCNode::setVertexZ(float var)
 {
     m_fVertexZ = var;
+    markBitmapCachesDirty(m_pParent);
 }
 
 
@@ -212,6 +232,7 @@ void CCNode::setRotation(float newRotation)
 {
     m_fRotationX = m_fRotationY = newRotation;
     m_bTransformDirty = m_bInverseDirty = true;
+    markBitmapCachesDirty(m_pParent);
 }
 
 float CCNode::getRotationX()
@@ -223,6 +244,7 @@ void CCNode::setRotationX(float fRotationX)
 {
     m_fRotationX = fRotationX;
     m_bTransformDirty = m_bInverseDirty = true;
+    markBitmapCachesDirty(m_pParent);
 }
 
 float CCNode::getRotationY()
@@ -234,6 +256,7 @@ void CCNode::setRotationY(float fRotationY)
 {
     m_fRotationY = fRotationY;
     m_bTransformDirty = m_bInverseDirty = true;
+    markBitmapCachesDirty(m_pParent);
 }
 
 /// scale getter
@@ -248,6 +271,7 @@ void CCNode::setScale(float scale)
 {
     m_fScaleX = m_fScaleY = scale;
     m_bTransformDirty = m_bInverseDirty = true;
+    markBitmapCachesDirty(m_pParent);
 }
 
 /// scaleX getter
@@ -261,6 +285,7 @@ void CCNode::setScaleX(float newScaleX)
 {
     m_fScaleX = newScaleX;
     m_bTransformDirty = m_bInverseDirty = true;
+    markBitmapCachesDirty(m_pParent);
 }
 
 /// scaleY getter
@@ -274,6 +299,7 @@ void CCNode::setScaleY(float newScaleY)
 {
     m_fScaleY = newScaleY;
     m_bTransformDirty = m_bInverseDirty = true;
+    markBitmapCachesDirty(m_pParent);
 }
 
 /// position getter
@@ -287,6 +313,7 @@ void CCNode::setPosition(const CCPoint& newPosition)
 {
     m_obPosition = newPosition;
     m_bTransformDirty = m_bInverseDirty = true;
+    markBitmapCachesDirty(m_pParent);
 }
 
 void CCNode::getPosition(float* x, float* y)
@@ -358,6 +385,64 @@ void CCNode::setGrid(CCGridBase* pGrid)
 }
 
 
+void CCNode::setCacheAsBitmap(bool bCacheAsBitmap)
+{
+    if (m_bCacheAsBitmap == bCacheAsBitmap)
+    {
+        return;
+    }
+
+    m_bCacheAsBitmap = bCacheAsBitmap;
+    m_bBitmapCacheDirty = bCacheAsBitmap;
+
+    if (bCacheAsBitmap)
+    {
+        ++s_uBitmapCacheCount;
+#if CC_ENABLE_CACHE_TEXTURE_DATA
+        CCNotificationCenter::sharedNotificationCenter()->addObserver(this,
+                                                                      callfuncO_selector(CCNode::bitmapCacheToForeground),
+                                                                      EVNET_COME_TO_FOREGROUND, // this is misspelt
+                                                                      NULL);
+#endif
+    }
+    else
+    {
+        --s_uBitmapCacheCount;
+#if CC_ENABLE_CACHE_TEXTURE_DATA
+        CCNotificationCenter::sharedNotificationCenter()->removeObserver(this, EVNET_COME_TO_FOREGROUND);
+#endif
+        CC_SAFE_RELEASE_NULL(m_pBitmapCache);
+        m_obBitmapCacheRect = CCRectZero;
+    }
+}
+
+void CCNode::setBitmapCacheDirty()
+{
+    markBitmapCachesDirty(this);
+}
+
+void CCNode::markBitmapCachesDirty(CCNode* pNode)
+{
+    if (s_uBitmapCacheCount == 0)
+    {
+        return;
+    }
+
+    for (; pNode != NULL; pNode = pNode->m_pParent)
+    {
+        if (pNode->m_bCacheAsBitmap)
+        {
+            pNode->m_bBitmapCacheDirty = true;
+        }
+    }
+}
+
+void CCNode::bitmapCacheToForeground(CCObject* pObject)
+{
+    // the render texture is restored, but the textures it was drawn with might have changed
+    m_bBitmapCacheDirty = true;
+}
+
 /// isVisible getter
 bool CCNode::isVisible()
 {
@@ -367,6 +452,10 @@ bool CCNode::isVisible()
 /// isVisible setter
 void CCNode::setVisible(bool var)
 {
+    if (m_bVisible != var)
+    {
+        markBitmapCachesDirty(m_pParent);
+    }
     m_bVisible = var;
 }
 
@@ -388,6 +477,7 @@ void CCNode::setAnchorPoint(const CCPoint& point)
         m_obAnchorPoint = point;
         m_obAnchorPointInPoints = ccp(m_obContentSize.width * m_obAnchorPoint.x, m_obContentSize.height * m_obAnchorPoint.y );
         m_bTransformDirty = m_bInverseDirty = true;
+        markBitmapCachesDirty(m_pParent);
     }
 }
 
@@ -405,6 +495,7 @@ void CCNode::setContentSize(const CCSize & size)
 
         m_obAnchorPointInPoints = ccp(m_obContentSize.width * m_obAnchorPoint.x, m_obContentSize.height * m_obAnchorPoint.y );
         m_bTransformDirty = m_bInverseDirty = true;
+        markBitmapCachesDirty(this);
     }
 }
 
@@ -437,6 +528,7 @@ void CCNode::ignoreAnchorPointForPosition(bool newValue)
     {
 		m_bIgnoreAnchorPointForPosition = newValue;
 		m_bTransformDirty = m_bInverseDirty = true;
+		markBitmapCachesDirty(m_pParent);
 	}
 }
 
@@ -594,6 +686,8 @@ void CCNode::addChild(CCNode *child, int zOrder, int tag)
     child->setParent(this);
     child->setOrderOfArrival(s_globalOrderOfArrival++);
 
+    markBitmapCachesDirty(this);
+
     if( m_bRunning )
     {
         child->onEnter();
@@ -705,6 +799,8 @@ void CCNode::removeAllChildrenWithCleanup(bool cleanup)
         }
         
         m_pChildren->removeAllObjects();
+
+        markBitmapCachesDirty(this);
     }
     
 }
@@ -731,6 +827,8 @@ void CCNode::detachChild(CCNode *child, bool doCleanup)
     child->setParent(NULL);
 
     m_pChildren->removeObject(child);
+
+    markBitmapCachesDirty(this);
 }
 
 
@@ -748,6 +846,7 @@ void CCNode::reorderChild(CCNode *child, int zOrder)
     m_bReorderChildDirty = true;
     child->setOrderOfArrival(s_globalOrderOfArrival++);
     child->_setZOrder(zOrder);
+    markBitmapCachesDirty(this);
 }
 
 void CCNode::sortAllChildren()
@@ -804,6 +903,33 @@ void CCNode::visit()
 
     this->transform();
 
+    // the cached nodes inside a bitmap cache being drawn are drawn directly, a render texture can't be drawn into another
+    if (m_bCacheAsBitmap && s_uBitmapCacheRenderDepth == 0 && !(m_pGrid && m_pGrid->isActive())
+        && (! m_bBitmapCacheDirty || renderBitmapCache()))
+    {
+        if (m_pBitmapCache && m_obBitmapCacheRect.size.width > 0)
+        {
+            m_pBitmapCache->getSprite()->visit();
+        }
+    }
+    else
+    {
+        drawSubtree();
+    }
+
+    // reset for next frame
+    m_uOrderOfArrival = 0;
+
+     if (m_pGrid && m_pGrid->isActive())
+     {
+         m_pGrid->afterDraw(this);
+    }
+ 
+    kmGLPopMatrix();
+}
+
+void CCNode::drawSubtree()
+{
     CCNode* pNode = NULL;
     unsigned int i = 0;
 
@@ -841,16 +967,107 @@ void CCNode::visit()
     {
         this->draw();
     }
+}
 
-    // reset for next frame
-    m_uOrderOfArrival = 0;
+// adds the area of the content of pNode and of its visible children, in the coordinates given by transform
+static void unionSubtreeRect(CCNode* pNode, const CCAffineTransform& transform, float* pMin, float* pMax, bool& bEmpty)
+{
+    const CCSize& size = pNode->getContentSize();
+    if (size.width > 0 && size.height > 0)
+    {
+        CCRect rect = CCRectApplyAffineTransform(CCRectMake(0, 0, size.width, size.height), transform);
+        if (bEmpty)
+        {
+            pMin[0] = rect.getMinX();
+            pMin[1] = rect.getMinY();
+            pMax[0] = rect.getMaxX();
+            pMax[1] = rect.getMaxY();
+            bEmpty = false;
+        }
+        else
+        {
+            pMin[0] = MIN(pMin[0], rect.getMinX());
+            pMin[1] = MIN(pMin[1], rect.getMinY());
+            pMax[0] = MAX(pMax[0], rect.getMaxX());
+            pMax[1] = MAX(pMax[1], rect.getMaxY());
+        }
+    }
 
-     if (m_pGrid && m_pGrid->isActive())
-     {
-         m_pGrid->afterDraw(this);
+    CCArray* pChildren = pNode->getChildren();
+    if (pChildren && pChildren->count() > 0)
+    {
+        CCObject* pObject = NULL;
+        CCARRAY_FOREACH(pChildren, pObject)
+        {
+            CCNode* pChild = (CCNode*)pObject;
+            if (pChild->isVisible())
+            {
+                unionSubtreeRect(pChild, CCAffineTransformConcat(pChild->nodeToParentTransform(), transform), pMin, pMax, bEmpty);
+            }
+        }
     }
- 
-    kmGLPopMatrix();
+}
+
+bool CCNode::renderBitmapCache()
+{
+    float min[2] = { 0, 0 };
+    float max[2] = { 0, 0 };
+    bool bEmpty = true;
+    unionSubtreeRect(this, CCAffineTransformMakeIdentity(), min, max, bEmpty);
+
+    if (bEmpty)
+    {
+        m_obBitmapCacheRect = CCRectZero;
+        m_bBitmapCacheDirty = false;
+        return true;
+    }
+
+    // whole points, so that the texels of the cache match the pixels the subtree would cover
+    float x = floorf(min[0]);
+    float y = floorf(min[1]);
+    int nWidth = (int)(ceilf(max[0]) - x);
+    int nHeight = (int)(ceilf(max[1]) - y);
+
+    int nMaxSize = (int)(CCConfiguration::sharedConfiguration()->getMaxTextureSize() / CC_CONTENT_SCALE_FACTOR());
+    if (nWidth > nMaxSize || nHeight > nMaxSize)
+    {
+        // too large for a texture, the subtree is drawn directly
+        return false;
+    }
+
+    // the texture is only allocated again when it's too small, or much larger than needed
+    CCSize textureSize = m_pBitmapCache ? m_pBitmapCache->getSprite()->getTexture()->getContentSize() : CCSizeZero;
+    if (textureSize.width < nWidth || textureSize.height < nHeight
+        || textureSize.width * textureSize.height > 4.0f * nWidth * nHeight)
+    {
+        CC_SAFE_RELEASE_NULL(m_pBitmapCache);
+        m_pBitmapCache = CCRenderTexture::create(nWidth, nHeight, kCCTexture2DPixelFormat_RGBA8888);
+        if (! m_pBitmapCache)
+        {
+            return false;
+        }
+        m_pBitmapCache->retain();
+    }
+
+    m_obBitmapCacheRect = CCRectMake(x, y, (float)nWidth, (float)nHeight);
+
+    // the subtree is drawn in the coordinates of this node, with the bottom left of the cached area on the texture origin
+    m_pBitmapCache->beginWithClear(0, 0, 0, 0);
+    kmGLTranslatef(-x, -y, 0);
+
+    ++s_uBitmapCacheRenderDepth;
+    drawSubtree();
+    --s_uBitmapCacheRenderDepth;
+
+    m_pBitmapCache->end();
+
+    CCSprite* pSprite = m_pBitmapCache->getSprite();
+    pSprite->setTextureRect(CCRectMake(0, 0, (float)nWidth, (float)nHeight));
+    pSprite->setPosition(ccp(x + nWidth * 0.5f, y + nHeight * 0.5f));
+
+    ++m_uBitmapCacheRenderCount;
+    m_bBitmapCacheDirty = false;
+    return true;
 }
 
 void CCNode::transformAncestors()
@@ -1190,6 +1407,7 @@ void CCNode::setAdditionalTransform(const CCAffineTransform& additionalTransform
     m_sAdditionalTransform = additionalTransform;
     m_bTransformDirty = true;
     m_bAdditionalTransformDirty = true;
+    markBitmapCachesDirty(m_pParent);
 }
 
 CCAffineTransform CCNode::parentToNodeTransform(void)
@@ -1302,6 +1520,7 @@ GLubyte CCNodeRGBA::getDisplayedOpacity(void)
 void CCNodeRGBA::setOpacity(GLubyte opacity)
 {
     _displayedOpacity = _realOpacity = opacity;
+    markBitmapCachesDirty(this);
     
 	if (_cascadeOpacityEnabled)
     {
@@ -1318,6 +1537,7 @@ void CCNodeRGBA::setOpacity(GLubyte opacity)
 void CCNodeRGBA::updateDisplayedOpacity(GLubyte parentOpacity)
 {
 	_displayedOpacity = _realOpacity * parentOpacity/255.0;
+    markBitmapCachesDirty(this);
 	
     if (_cascadeOpacityEnabled)
     {
@@ -1356,6 +1576,7 @@ const ccColor3B& CCNodeRGBA::getDisplayedColor()
 void CCNodeRGBA::setColor(const ccColor3B& color)
 {
 	_displayedColor = _realColor = color;
+    markBitmapCachesDirty(this);
 	
 	if (_cascadeColorEnabled)
     {
@@ -1375,6 +1596,7 @@ void CCNodeRGBA::updateDisplayedColor(const ccColor3B& parentColor)
 	_displayedColor.r = _realColor.r * parentColor.r/255.0;
 	_displayedColor.g = _realColor.g * parentColor.g/255.0;
 	_displayedColor.b = _realColor.b * parentColor.b/255.0;
+    markBitmapCachesDirty(this);
     
     if (_cascadeColorEnabled)
     {
@@ -49,6 +49,7 @@ class CCRGBAProtocol;
 class CCLabelProtocol;
 class CCScheduler;
 class CCActionManager;
+class CCRenderTexture;
 
 /**
  * @addtogroup base_nodes
@@ -721,6 +722,55 @@ public:
     /// @} end of Grid
     
     
+    /// @{
+    /// @name Bitmap cache
+    
+    /**
+     * Sets whether the node and its children are drawn once into a texture, then drawn as a single quad.
+     *
+     * The texture is drawn again when a node of the subtree changes its transform, visibility, color or opacity,
+     * its texture or texture rect if it is a sprite, or when children are added, removed or reordered.
+     * The node itself can be moved, scaled or rotated without drawing the texture again.
+     * Content the setters don't see, like particles, must call setBitmapCacheDirty() when it changes.
+     *
+     * The cached area is the union of the content sizes of the visible nodes of the subtree, in the coordinates of
+     * this node: a node drawing outside of its content size, like a CCDrawNode, must be given a content size covering
+     * what it draws. The texture is blurred when the node is scaled up. It only applies to nodes drawn by CCNode::visit(),
+     * and the subtree is drawn directly while a grid effect is active or if it is larger than the maximum texture size.
+     *
+     * @param bCacheAsBitmap    true to draw the subtree through a texture, false to draw it normally and release the texture
+     * @since v2.1.4
+     */
+    void setCacheAsBitmap(bool bCacheAsBitmap);
+    
+    /**
+     * Returns whether the node and its children are drawn through a texture
+     *
+     * @see setCacheAsBitmap(bool)
+     * @since v2.1.4
+     */
+    inline bool isCacheAsBitmap() { return m_bCacheAsBitmap; }
+    
+    /**
+     * Draws the texture of this node and of the nodes caching it as a bitmap again before they are next drawn.
+     * The setters of CCNode and CCSprite call it, it is needed for the changes they don't see.
+     *
+     * @see setCacheAsBitmap(bool)
+     * @since v2.1.4
+     */
+    void setBitmapCacheDirty();
+    
+    /**
+     * Returns the number of times the subtree was drawn into the texture of the bitmap cache
+     *
+     * @see setCacheAsBitmap(bool)
+     * @since v2.1.4
+     */
+    inline unsigned int getBitmapCacheRenderCount() { return m_uBitmapCacheRenderCount; }
+    
+    /// @} end of Bitmap cache
+    
+    
     /// @{
     /// @name Tag & User data
     
@@ -1312,8 +1362,20 @@ private:
     
     /// Convert cocos2d coordinates to UI windows coordinate.
     CCPoint convertToWindowSpace(const CCPoint& nodePoint);
+    
+    /// Draws the children and the node itself, in z order.
+    void drawSubtree();
+    
+    /// Draws the subtree into the texture of the bitmap cache, returns false if it can't be cached.
+    bool renderBitmapCache();
+    
+    /// The cached subtrees are drawn again when the GL context is recreated.
+    void bitmapCacheToForeground(CCObject* pObject);
 
 protected:
+    /// Marks the bitmap caches of pNode and of its ancestors dirty, pNode can be NULL.
+    static void markBitmapCachesDirty(CCNode* pNode);
+    
     float m_fRotationX;                 ///< rotation angle on x-axis
     float m_fRotationY;                 ///< rotation angle on y-axis
     
@@ -1376,6 +1438,12 @@ protected:
     int m_nScriptHandler;               ///< script handler for onEnter() & onExit(), used in Javascript binding and Lua binding.
     int m_nUpdateScriptHandler;         ///< script handler for update() callback per frame, which is invoked from lua & javascript.
     ccScriptType m_eScriptType;         ///< type of script binding, lua or javascript
+    
+    bool m_bCacheAsBitmap;              ///< the subtree is drawn through m_pBitmapCache
+    bool m_bBitmapCacheDirty;           ///< the subtree must be drawn into m_pBitmapCache again
+    CCRenderTexture *m_pBitmapCache;    ///< texture of the subtree, lazy alloc
+    CCRect m_obBitmapCacheRect;         ///< area of the subtree in m_pBitmapCache, in node coordinates
+    unsigned int m_uBitmapCacheRenderCount; ///< number of times the subtree was drawn into m_pBitmapCache
 };
 
 //#pragma mark - CCNodeRGBA
@@ -415,4 +415,63 @@ CCDictionary* CCDictionary::createWithContentsOfFile(const char *pFileName)
     return pRet;
 }
 
+CCDictionary* CCDictionary::createWithDataThreadSafe(const char *pData, unsigned long uSize)
+{
+    return CCFileUtils::sharedFileUtils()->createCCDictionaryWithData(pData, uSize);
+}
+
+CCDictionary* CCDictionary::createWithData(const char *pData, unsigned long uSize)
+{
+    CCDictionary* pRet = createWithDataThreadSafe(pData, uSize);
+    if (pRet)
+    {
+        pRet->autorelease();
+    }
+    return pRet;
+}
+
+// Receives the contents of the plist from CCFileUtils, which retains it until then
+class CCDictionaryAsyncLoader : public CCObject
+{
+public:
+    CCDictionaryAsyncLoader(CCObject *target, SEL_CallFuncO selector)
+    : m_pTarget(target)
+    , m_pSelector(selector)
+    {
+        CC_SAFE_RETAIN(m_pTarget);
+    }
+
+    virtual ~CCDictionaryAsyncLoader()
+    {
+        CC_SAFE_RELEASE(m_pTarget);
+    }
+
+    void fileDataLoaded(CCObject *pObject)
+    {
+        CCAsyncFileData *pData = (CCAsyncFileData*)pObject;
+        CCDictionary *pDict = NULL;
+        if (pData->getBuffer())
+        {
+            pDict = CCDictionary::createWithData((const char*)pData->getBuffer(), pData->getSize());
+        }
+
+        if (m_pTarget && m_pSelector)
+        {
+            (m_pTarget->*m_pSelector)(pDict);
+        }
+    }
+
+private:
+    CCObject *m_pTarget;
+    SEL_CallFuncO m_pSelector;
+};
+
+unsigned int CCDictionary::createWithContentsOfFileAsync(const char *pFileName, CCObject *target, SEL_CallFuncO selector)
+{
+    CCDictionaryAsyncLoader *pLoader = new CCDictionaryAsyncLoader(target, selector);
+    unsigned int uRequestId = CCFileUtils::sharedFileUtils()->getFileDataAsync(pFileName, pLoader, callfuncO_selector(CCDictionaryAsyncLoader::fileDataLoaded));
+    pLoader->release();
+    return uRequestId;
+}
+
 NS_CC_END
@@ -375,6 +375,39 @@ public:
      */
     static CCDictionary* createWithContentsOfFileThreadSafe(const char *pFileName);
 
+    /**
+     *  Create a dictionary with the contents of a plist file in memory.
+     *
+     *  @param  pData  The contents of the plist file, doesn't need to be NUL terminated.
+     *  @param  uSize  The size of the contents.
+     *  @return A dictionary which is an autorelease object, or NULL if the data can't be parsed.
+     *  @since v2.1.4
+     */
+    static CCDictionary* createWithData(const char *pData, unsigned long uSize);
+
+    /**
+     *  The same meaning as createWithData(), but the returned object is not an autorelease object.
+     *  It can be used off the main thread, and CC_SAFE_RELEASE needs to be invoked on the result.
+     *
+     *  @param  pData  The contents of the plist file, doesn't need to be NUL terminated.
+     *  @param  uSize  The size of the contents.
+     *  @return A dictionary which isn't an autorelease object, or NULL if the data can't be parsed.
+     *  @since v2.1.4
+     */
+    static CCDictionary* createWithDataThreadSafe(const char *pData, unsigned long uSize);
+
+    /**
+     *  Reads a plist file on the I/O threads of CCFileUtils and parses it on the main thread.
+     *  The selector is called with the dictionary, which is an autorelease object, or with NULL
+     *  if the file can't be read.
+     *
+     *  @param  pFileName  The name of the plist file.
+     *  @return The id of the request, it can be cancelled with CCFileUtils::cancelFileDataAsync().
+     *  @see CCFileUtils::getFileDataAsync()
+     *  @since v2.1.4
+     */
+    static unsigned int createWithContentsOfFileAsync(const char *pFileName, CCObject *target, SEL_CallFuncO selector);
+
 private:
     /** 
      *  For internal usage, invoked by setObject.
@@ -24,6 +24,7 @@
 #include "support/CCPointExtension.h"
 #include "shaders/CCShaderCache.h"
 #include "CCGL.h"
+#include <algorithm>
 
 NS_CC_BEGIN
 
@@ -101,6 +102,10 @@ CCDrawNode::CCDrawNode()
 , m_nBufferCount(0)
 , m_pBuffer(NULL)
 , m_bDirty(false)
+, m_uUploadedCapacity(0)
+, m_uLastShape(0)
+, m_nReleasedCount(0)
+, m_uUploadedBytes(0)
 {
     m_sBlendFunc.src = CC_BLEND_SRC;
     m_sBlendFunc.dst = CC_BLEND_DST;
@@ -111,7 +116,7 @@ CCDrawNode::~CCDrawNode()
     free(m_pBuffer);
     m_pBuffer = NULL;
     
-    glDeleteBuffers(1, &m_uVbo);
+    ccGLDeleteBuffers(1, &m_uVbo);
     m_uVbo = 0;
     
 #if CC_TEXTURE_ATLAS_USE_VAO      
@@ -159,8 +164,9 @@ bool CCDrawNode::init()
 #endif
     
     glGenBuffers(1, &m_uVbo);
-    glBindBuffer(GL_ARRAY_BUFFER, m_uVbo);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(ccV2F_C4B_T2F)* m_uBufferCapacity, m_pBuffer, GL_STREAM_DRAW);
+    ccGLBindBuffer(GL_ARRAY_BUFFER, m_uVbo);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(ccV2F_C4B_T2F)* m_uBufferCapacity, m_pBuffer, GL_DYNAMIC_DRAW);
+    m_uUploadedCapacity = m_uBufferCapacity;
     
     glEnableVertexAttribArray(kCCVertexAttrib_Position);
     glVertexAttribPointer(kCCVertexAttrib_Position, 2, GL_FLOAT, GL_FALSE, sizeof(ccV2F_C4B_T2F), (GLvoid *)offsetof(ccV2F_C4B_T2F, vertices));
@@ -171,7 +177,7 @@ bool CCDrawNode::init()
     glEnableVertexAttribArray(kCCVertexAttrib_TexCoords);
     glVertexAttribPointer(kCCVertexAttrib_TexCoords, 2, GL_FLOAT, GL_FALSE, sizeof(ccV2F_C4B_T2F), (GLvoid *)offsetof(ccV2F_C4B_T2F, texCoords));
     
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    ccGLBindBuffer(GL_ARRAY_BUFFER, 0);
     
 #if CC_TEXTURE_ATLAS_USE_VAO 
     ccGLBindVAO(0);
@@ -179,24 +185,47 @@ bool CCDrawNode::init()
     
     CHECK_GL_ERROR_DEBUG();
     
-    m_bDirty = true;
+    m_bDirty = false;
     
     return true;
 }
 
 void CCDrawNode::render()
 {
+    // the released shapes are reclaimed when they take more than half of the buffer
+    if (m_nReleasedCount > CC_DRAW_NODE_COMPACT_MIN_VERTICES && m_nReleasedCount * 2 > m_nBufferCount)
+    {
+        compact();
+    }
+
     if (m_bDirty)
     {
-        glBindBuffer(GL_ARRAY_BUFFER, m_uVbo);
-        glBufferData(GL_ARRAY_BUFFER, sizeof(ccV2F_C4B_T2F)*m_uBufferCapacity, m_pBuffer, GL_STREAM_DRAW);
+        ccGLBindBuffer(GL_ARRAY_BUFFER, m_uVbo);
+        if (m_uUploadedCapacity != m_uBufferCapacity)
+        {
+            // the buffer has grown
+            glBufferData(GL_ARRAY_BUFFER, sizeof(ccV2F_C4B_T2F)*m_uBufferCapacity, m_pBuffer, GL_DYNAMIC_DRAW);
+            m_uUploadedCapacity = m_uBufferCapacity;
+            m_uUploadedBytes += sizeof(ccV2F_C4B_T2F)*m_uBufferCapacity;
+        }
+        else
+        {
+            // only the vertices that changed
+            for (unsigned int i = 0; i < m_tDirtyRanges.size(); i++)
+            {
+                const VertexRange& range = m_tDirtyRanges[i];
+                glBufferSubData(GL_ARRAY_BUFFER, sizeof(ccV2F_C4B_T2F)*range.first, sizeof(ccV2F_C4B_T2F)*range.count, m_pBuffer + range.first);
+                m_uUploadedBytes += sizeof(ccV2F_C4B_T2F)*range.count;
+            }
+        }
+        m_tDirtyRanges.clear();
         m_bDirty = false;
     }
 #if CC_TEXTURE_ATLAS_USE_VAO     
     ccGLBindVAO(m_uVao);
 #else
     ccGLEnableVertexAttribs(kCCVertexAttribFlag_PosColorTex);
-    glBindBuffer(GL_ARRAY_BUFFER, m_uVbo);
+    ccGLBindBuffer(GL_ARRAY_BUFFER, m_uVbo);
     // vertex
     glVertexAttribPointer(kCCVertexAttrib_Position, 2, GL_FLOAT, GL_FALSE, sizeof(ccV2F_C4B_T2F), (GLvoid *)offsetof(ccV2F_C4B_T2F, vertices));
     
@@ -208,7 +237,7 @@ void CCDrawNode::render()
 #endif
 
     glDrawArrays(GL_TRIANGLES, 0, m_nBufferCount);
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    ccGLBindBuffer(GL_ARRAY_BUFFER, 0);
     
     CC_INCREMENT_GL_DRAWS(1);
     CHECK_GL_ERROR_DEBUG();
@@ -224,32 +253,32 @@ void CCDrawNode::draw()
     render();
 }
 
-void CCDrawNode::drawDot(const CCPoint &pos, float radius, const ccColor4F &color)
+// tessellation of the shapes, in triangles written to buffer
+
+static const unsigned int kDotVertexCount = 2*3;
+static const unsigned int kSegmentVertexCount = 6*3;
+
+static inline unsigned int polygonVertexCount(unsigned int count)
+{
+    return 3*(3*count - 2);
+}
+
+static void tessellateDot(ccV2F_C4B_T2F *buffer, const CCPoint &pos, float radius, const ccColor4F &color)
 {
-    unsigned int vertex_count = 2*3;
-    ensureCapacity(vertex_count);
-	
 	ccV2F_C4B_T2F a = {{pos.x - radius, pos.y - radius}, ccc4BFromccc4F(color), {-1.0, -1.0} };
 	ccV2F_C4B_T2F b = {{pos.x - radius, pos.y + radius}, ccc4BFromccc4F(color), {-1.0,  1.0} };
 	ccV2F_C4B_T2F c = {{pos.x + radius, pos.y + radius}, ccc4BFromccc4F(color), { 1.0,  1.0} };
 	ccV2F_C4B_T2F d = {{pos.x + radius, pos.y - radius}, ccc4BFromccc4F(color), { 1.0, -1.0} };
 	
-	ccV2F_C4B_T2F_Triangle *triangles = (ccV2F_C4B_T2F_Triangle *)(m_pBuffer + m_nBufferCount);
+	ccV2F_C4B_T2F_Triangle *triangles = (ccV2F_C4B_T2F_Triangle *)buffer;
     ccV2F_C4B_T2F_Triangle triangle0 = {a, b, c};
     ccV2F_C4B_T2F_Triangle triangle1 = {a, c, d};
 	triangles[0] = triangle0;
 	triangles[1] = triangle1;
-	
-	m_nBufferCount += vertex_count;
-	
-	m_bDirty = true;
 }
 
-void CCDrawNode::drawSegment(const CCPoint &from, const CCPoint &to, float radius, const ccColor4F &color)
+static void tessellateSegment(ccV2F_C4B_T2F *buffer, const CCPoint &from, const CCPoint &to, float radius, const ccColor4F &color)
 {
-    unsigned int vertex_count = 6*3;
-    ensureCapacity(vertex_count);
-	
 	ccVertex2F a = __v2f(from);
 	ccVertex2F b = __v2f(to);
 	
@@ -269,7 +298,7 @@ void CCDrawNode::drawSegment(const CCPoint &from, const CCPoint &to, float radiu
 	ccVertex2F v7 = v2fadd(a, v2fadd(nw, tw));
 	
 	
-	ccV2F_C4B_T2F_Triangle *triangles = (ccV2F_C4B_T2F_Triangle *)(m_pBuffer + m_nBufferCount);
+	ccV2F_C4B_T2F_Triangle *triangles = (ccV2F_C4B_T2F_Triangle *)buffer;
 	
     ccV2F_C4B_T2F_Triangle triangles0 = {
         {v0, ccc4BFromccc4F(color), __t(v2fneg(v2fadd(n, t)))},
@@ -312,13 +341,9 @@ void CCDrawNode::drawSegment(const CCPoint &from, const CCPoint &to, float radiu
         {v5, ccc4BFromccc4F(color), __t(n)},
     };
 	triangles[5] = triangles5;
-	
-	m_nBufferCount += vertex_count;
-	
-	m_bDirty = true;
 }
 
-void CCDrawNode::drawPolygon(CCPoint *verts, unsigned int count, const ccColor4F &fillColor, float borderWidth, const ccColor4F &borderColor)
+static void tessellatePolygon(ccV2F_C4B_T2F *buffer, const CCPoint *verts, unsigned int count, const ccColor4F &fillColor, float borderWidth, const ccColor4F &borderColor)
 {
     struct ExtrudeVerts {ccVertex2F offset, n;};
 	struct ExtrudeVerts* extrude = (struct ExtrudeVerts*)malloc(sizeof(struct ExtrudeVerts)*count);
@@ -340,11 +365,7 @@ void CCDrawNode::drawPolygon(CCPoint *verts, unsigned int count, const ccColor4F
 	
 	bool outline = (fillColor.a > 0.0 && borderWidth > 0.0);
 	
-	unsigned int triangle_count = 3*count - 2;
-	unsigned int vertex_count = 3*triangle_count;
-    ensureCapacity(vertex_count);
-	
-	ccV2F_C4B_T2F_Triangle *triangles = (ccV2F_C4B_T2F_Triangle *)(m_pBuffer + m_nBufferCount);
+	ccV2F_C4B_T2F_Triangle *triangles = (ccV2F_C4B_T2F_Triangle *)buffer;
 	ccV2F_C4B_T2F_Triangle *cursor = triangles;
 	
 	float inset = (outline == 0.0 ? 0.5 : 0.0);
@@ -416,18 +437,247 @@ void CCDrawNode::drawPolygon(CCPoint *verts, unsigned int count, const ccColor4F
 			*cursor++ = tmp2;
 		}
 	}
-	
-	m_nBufferCount += vertex_count;
-	
-	m_bDirty = true;
 
     free(extrude);
 }
 
+void CCDrawNode::drawDot(const CCPoint &pos, float radius, const ccColor4F &color)
+{
+    ensureCapacity(kDotVertexCount);
+    tessellateDot(m_pBuffer + m_nBufferCount, pos, radius, color);
+    markDirty(m_nBufferCount, kDotVertexCount);
+    m_nBufferCount += kDotVertexCount;
+}
+
+void CCDrawNode::drawSegment(const CCPoint &from, const CCPoint &to, float radius, const ccColor4F &color)
+{
+    ensureCapacity(kSegmentVertexCount);
+    tessellateSegment(m_pBuffer + m_nBufferCount, from, to, radius, color);
+    markDirty(m_nBufferCount, kSegmentVertexCount);
+    m_nBufferCount += kSegmentVertexCount;
+}
+
+void CCDrawNode::drawPolygon(CCPoint *verts, unsigned int count, const ccColor4F &fillColor, float borderWidth, const ccColor4F &borderColor)
+{
+    unsigned int vertex_count = polygonVertexCount(count);
+    ensureCapacity(vertex_count);
+    tessellatePolygon(m_pBuffer + m_nBufferCount, verts, count, fillColor, borderWidth, borderColor);
+    markDirty(m_nBufferCount, vertex_count);
+    m_nBufferCount += vertex_count;
+}
+
+unsigned int CCDrawNode::addDot(const CCPoint &pos, float radius, const ccColor4F &color)
+{
+    unsigned int shape = ++m_uLastShape;
+    tessellateDot(shapeVertices(shape, kDotVertexCount), pos, radius, color);
+    return shape;
+}
+
+unsigned int CCDrawNode::addSegment(const CCPoint &from, const CCPoint &to, float radius, const ccColor4F &color)
+{
+    unsigned int shape = ++m_uLastShape;
+    tessellateSegment(shapeVertices(shape, kSegmentVertexCount), from, to, radius, color);
+    return shape;
+}
+
+unsigned int CCDrawNode::addPolygon(const CCPoint *verts, unsigned int count, const ccColor4F &fillColor, float borderWidth, const ccColor4F &borderColor)
+{
+    unsigned int shape = ++m_uLastShape;
+    tessellatePolygon(shapeVertices(shape, polygonVertexCount(count)), verts, count, fillColor, borderWidth, borderColor);
+    return shape;
+}
+
+bool CCDrawNode::updateDot(unsigned int shape, const CCPoint &pos, float radius, const ccColor4F &color)
+{
+    if (! containsShape(shape))
+    {
+        return false;
+    }
+
+    tessellateDot(shapeVertices(shape, kDotVertexCount), pos, radius, color);
+    return true;
+}
+
+bool CCDrawNode::updateSegment(unsigned int shape, const CCPoint &from, const CCPoint &to, float radius, const ccColor4F &color)
+{
+    if (! containsShape(shape))
+    {
+        return false;
+    }
+
+    tessellateSegment(shapeVertices(shape, kSegmentVertexCount), from, to, radius, color);
+    return true;
+}
+
+bool CCDrawNode::updatePolygon(unsigned int shape, const CCPoint *verts, unsigned int count, const ccColor4F &fillColor, float borderWidth, const ccColor4F &borderColor)
+{
+    if (! containsShape(shape))
+    {
+        return false;
+    }
+
+    tessellatePolygon(shapeVertices(shape, polygonVertexCount(count)), verts, count, fillColor, borderWidth, borderColor);
+    return true;
+}
+
+bool CCDrawNode::moveShape(unsigned int shape, const CCPoint &delta)
+{
+    std::map<unsigned int, VertexRange>::iterator it = m_tShapes.find(shape);
+    if (it == m_tShapes.end())
+    {
+        return false;
+    }
+
+    // the tessellation only moves, it is not computed again
+    ccV2F_C4B_T2F *vertices = m_pBuffer + it->second.first;
+    for (GLsizei i = 0; i < it->second.count; i++)
+    {
+        vertices[i].vertices.x += delta.x;
+        vertices[i].vertices.y += delta.y;
+    }
+    markDirty(it->second.first, it->second.count);
+    return true;
+}
+
+bool CCDrawNode::removeShape(unsigned int shape)
+{
+    std::map<unsigned int, VertexRange>::iterator it = m_tShapes.find(shape);
+    if (it == m_tShapes.end())
+    {
+        return false;
+    }
+
+    releaseVertices(it->second);
+    m_tShapes.erase(it);
+    return true;
+}
+
+bool CCDrawNode::containsShape(unsigned int shape)
+{
+    return m_tShapes.find(shape) != m_tShapes.end();
+}
+
+ccV2F_C4B_T2F* CCDrawNode::shapeVertices(unsigned int shape, GLsizei count)
+{
+    VertexRange& s = m_tShapes[shape];
+
+    // a shape keeps its place when its number of vertices doesn't change, it is appended otherwise
+    if (s.count != count)
+    {
+        if (s.count > 0)
+        {
+            releaseVertices(s);
+        }
+
+        ensureCapacity(count);
+        s.first = m_nBufferCount;
+        s.count = count;
+        m_nBufferCount += count;
+    }
+
+    markDirty(s.first, s.count);
+    return m_pBuffer + s.first;
+}
+
+void CCDrawNode::releaseVertices(const VertexRange& range)
+{
+    // the vertices are collapsed to a point, so that nothing is drawn until they are reclaimed by compact()
+    memset(m_pBuffer + range.first, 0, sizeof(ccV2F_C4B_T2F) * range.count);
+    markDirty(range.first, range.count);
+
+    m_tReleased.push_back(range);
+    m_nReleasedCount += range.count;
+}
+
+void CCDrawNode::compact()
+{
+    if (m_tReleased.empty())
+    {
+        return;
+    }
+
+    std::sort(m_tReleased.begin(), m_tReleased.end(), compareRanges);
+
+    // the vertices between the released ranges move down, the shapes after a range move with them
+    std::vector<GLsizei> removedBefore(m_tReleased.size());
+    GLsizei removed = 0;
+    for (unsigned int i = 0; i < m_tReleased.size(); i++)
+    {
+        const VertexRange& released = m_tReleased[i];
+        removed += released.count;
+        removedBefore[i] = removed;
+
+        GLsizei end = i + 1 < m_tReleased.size() ? m_tReleased[i + 1].first : m_nBufferCount;
+        GLsizei from = released.first + released.count;
+        memmove(m_pBuffer + from - removed, m_pBuffer + from, sizeof(ccV2F_C4B_T2F) * (end - from));
+    }
+
+    for (std::map<unsigned int, VertexRange>::iterator it = m_tShapes.begin(); it != m_tShapes.end(); ++it)
+    {
+        VertexRange& shape = it->second;
+        VertexRange key = {shape.first, 0};
+        std::vector<VertexRange>::iterator range = std::upper_bound(m_tReleased.begin(), m_tReleased.end(), key, compareRanges);
+        if (range != m_tReleased.begin())
+        {
+            shape.first -= removedBefore[range - m_tReleased.begin() - 1];
+        }
+    }
+
+    markDirty(m_tReleased[0].first, m_nBufferCount - m_tReleased[0].first);
+    m_nBufferCount -= removed;
+    m_tReleased.clear();
+    m_nReleasedCount = 0;
+}
+
+bool CCDrawNode::compareRanges(const VertexRange& a, const VertexRange& b)
+{
+    return a.first < b.first;
+}
+
+void CCDrawNode::markDirty(GLsizei first, GLsizei count)
+{
+    m_bDirty = true;
+    setBitmapCacheDirty();
+
+    // the ranges are kept sorted and apart, the ones the new range touches are merged with it
+    VertexRange dirty = {first, count};
+    std::vector<VertexRange>::iterator it = std::lower_bound(m_tDirtyRanges.begin(), m_tDirtyRanges.end(), dirty, compareRanges);
+    if (it != m_tDirtyRanges.begin() && (it - 1)->first + (it - 1)->count >= first)
+    {
+        --it;
+    }
+
+    std::vector<VertexRange>::iterator last = it;
+    GLsizei end = first + count;
+    while (last != m_tDirtyRanges.end() && last->first <= end)
+    {
+        dirty.first = MIN(dirty.first, last->first);
+        end = MAX(end, last->first + last->count);
+        ++last;
+    }
+    dirty.count = end - dirty.first;
+
+    it = m_tDirtyRanges.erase(it, last);
+    m_tDirtyRanges.insert(it, dirty);
+
+    if (m_tDirtyRanges.size() > CC_DRAW_NODE_MAX_DIRTY_RANGES)
+    {
+        VertexRange all = {m_tDirtyRanges.front().first, m_tDirtyRanges.back().first + m_tDirtyRanges.back().count - m_tDirtyRanges.front().first};
+        m_tDirtyRanges.clear();
+        m_tDirtyRanges.push_back(all);
+    }
+}
+
 void CCDrawNode::clear()
 {
     m_nBufferCount = 0;
-    m_bDirty = true;
+    m_tShapes.clear();
+    m_tReleased.clear();
+    m_nReleasedCount = 0;
+
+    // nothing is drawn past m_nBufferCount, there is nothing to upload
+    m_tDirtyRanges.clear();
+    setBitmapCacheDirty();
 }
 
 ccBlendFunc CCDrawNode::getBlendFunc() const
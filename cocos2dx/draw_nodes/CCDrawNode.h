@@ -32,12 +32,24 @@
 
 #include "base_nodes/CCNode.h"
 #include "ccTypes.h"
+#include <map>
+#include <vector>
 
 NS_CC_BEGIN
 
+/** number of vertices of removed shapes a CCDrawNode keeps before reclaiming them, when they are more than half of its vertices */
+#define CC_DRAW_NODE_COMPACT_MIN_VERTICES       1024
+
+/** number of separate ranges of vertices a CCDrawNode uploads, more ranges are uploaded as one */
+#define CC_DRAW_NODE_MAX_DIRTY_RANGES           8
+
 /** CCDrawNode
  Node that draws dots, segments and polygons.
  Faster than the "drawing primitives" since they it draws everything in one single batch.
+
+ The geometry added by the draw methods stays until clear(). The shapes added by the add methods
+ can also be updated, moved and removed one by one, by the handle returned when they are added.
+ Only the vertices that changed are uploaded when the node is drawn.
  
  @since v2.1
  */
@@ -54,6 +66,27 @@ protected:
     ccBlendFunc     m_sBlendFunc;
     
     bool            m_bDirty;
+
+    //! capacity of the vertex buffer object, in vertices
+    unsigned int    m_uUploadedCapacity;
+
+    //! vertices in m_pBuffer
+    typedef struct _VertexRange
+    {
+        GLsizei     first;
+        GLsizei     count;
+    } VertexRange;
+
+    //! vertices to upload, by increasing first vertex
+    std::vector<VertexRange>            m_tDirtyRanges;
+    //! vertices of the shapes, by handle
+    std::map<unsigned int, VertexRange> m_tShapes;
+    unsigned int                        m_uLastShape;
+    //! vertices of the removed shapes, not reclaimed yet
+    std::vector<VertexRange>            m_tReleased;
+    GLsizei                             m_nReleasedCount;
+
+    unsigned int                    m_uUploadedBytes;
     
 public:
     static CCDrawNode* create();
@@ -71,7 +104,71 @@ public:
     /** draw a polygon with a fill color and line color */
     void drawPolygon(CCPoint *verts, unsigned int count, const ccColor4F &fillColor, float borderWidth, const ccColor4F &borderColor);
     
-    /** Clear the geometry in the node's buffer. */
+    /** adds a dot shape at a position, with a given radius and color
+     @return the handle of the shape
+     @since v2.1.4
+     */
+    unsigned int addDot(const CCPoint &pos, float radius, const ccColor4F &color);
+
+    /** adds a segment shape with a radius and color
+     @return the handle of the shape
+     @since v2.1.4
+     */
+    unsigned int addSegment(const CCPoint &from, const CCPoint &to, float radius, const ccColor4F &color);
+
+    /** adds a polygon shape with a fill color and line color
+     @return the handle of the shape
+     @since v2.1.4
+     */
+    unsigned int addPolygon(const CCPoint *verts, unsigned int count, const ccColor4F &fillColor, float borderWidth, const ccColor4F &borderColor);
+
+    /** changes a dot shape, or any shape into a dot. Returns false if there is no such shape.
+     @since v2.1.4
+     */
+    bool updateDot(unsigned int shape, const CCPoint &pos, float radius, const ccColor4F &color);
+
+    /** changes a segment shape, or any shape into a segment. Returns false if there is no such shape.
+     @since v2.1.4
+     */
+    bool updateSegment(unsigned int shape, const CCPoint &from, const CCPoint &to, float radius, const ccColor4F &color);
+
+    /** changes a polygon shape, or any shape into a polygon. Returns false if there is no such shape.
+     @since v2.1.4
+     */
+    bool updatePolygon(unsigned int shape, const CCPoint *verts, unsigned int count, const ccColor4F &fillColor, float borderWidth, const ccColor4F &borderColor);
+
+    /** moves a shape, without tessellating it again. Returns false if there is no such shape.
+     @since v2.1.4
+     */
+    bool moveShape(unsigned int shape, const CCPoint &delta);
+
+    /** removes a shape. Its vertices are reclaimed by compact(). Returns false if there is no such shape.
+     @since v2.1.4
+     */
+    bool removeShape(unsigned int shape);
+
+    /** returns whether a shape is in the node
+     @since v2.1.4
+     */
+    bool containsShape(unsigned int shape);
+
+    /** number of shapes in the node
+     @since v2.1.4
+     */
+    inline unsigned int getShapeCount() { return (unsigned int)m_tShapes.size(); }
+
+    /** reclaims the vertices of the removed shapes. It is done when the node is drawn if they are
+     more than half of the vertices and more than CC_DRAW_NODE_COMPACT_MIN_VERTICES.
+     @since v2.1.4
+     */
+    void compact();
+
+    /** bytes uploaded to the vertex buffer object since the node was created
+     @since v2.1.4
+     */
+    inline unsigned int getUploadedBytes() { return m_uUploadedBytes; }
+    
+    /** Clear the geometry in the node's buffer, the shapes too. */
     void clear();
     
     ccBlendFunc getBlendFunc() const;
@@ -82,6 +179,10 @@ public:
 private:
     void ensureCapacity(unsigned int count);
     void render();
+    ccV2F_C4B_T2F* shapeVertices(unsigned int shape, GLsizei count);
+    void releaseVertices(const VertexRange& range);
+    void markDirty(GLsizei first, GLsizei count);
+    static bool compareRanges(const VertexRange& a, const VertexRange& b);
 };
 
 NS_CC_END
@@ -45,8 +45,11 @@ THE SOFTWARE.
 #include "shaders/CCGLProgram.h"
 #include "actions/CCActionCatmullRom.h"
 #include "support/CCPointExtension.h"
+#include "kazmath/GL/matrix.h"
 #include <string.h>
+#include <stddef.h>
 #include <cmath>
+#include <vector>
 
 NS_CC_BEGIN
 #ifndef M_PI
@@ -59,6 +62,40 @@ static int s_nColorLocation = -1;
 static ccColor4F s_tColor = {1.0f,1.0f,1.0f,1.0f};
 static int s_nPointSizeLocation = -1;
 static GLfloat s_fPointSize = 1.0f;
+static GLfloat s_fLineWidth = 1.0f;
+
+// vertices of the primitive being drawn, reused by every call
+static std::vector<ccVertex2F> s_tVertices;
+
+// batching: the primitives are transformed by the modelview matrix when they are added, and collected
+// in a bucket per kind (points, lines or triangles), line width, point size and color of the points,
+// and projection matrix. ccDrawFlush() uploads the buckets to one streaming buffer and draws each of them.
+typedef struct _ccDrawBatchVertex
+{
+    ccVertex3F      vertices;
+    ccColor4B       colors;
+} ccDrawBatchVertex;
+
+typedef struct _ccDrawBatchBucket
+{
+    GLenum                          mode;
+    GLfloat                         lineWidth;
+    GLfloat                         pointSize;
+    ccColor4F                       pointColor;
+    kmMat4                          projection;
+    std::vector<ccDrawBatchVertex>  vertices;
+} ccDrawBatchBucket;
+
+static int s_nBatchDepth = 0;
+static CCGLProgram* s_pColorShader = NULL;
+static GLuint s_uBatchVBO = 0;
+// the buckets are kept between flushes to reuse their vertices, only the first s_uBucketCount are used
+static std::vector<ccDrawBatchBucket> s_tBuckets;
+static unsigned int s_uBucketCount = 0;
+static unsigned int s_uLastBucket = 0;
+
+static unsigned int s_uPrimitiveCount = 0;
+static unsigned int s_uDrawCount = 0;
 
 static void lazy_init( void )
 {
@@ -75,6 +112,10 @@ static void lazy_init( void )
         s_nPointSizeLocation = glGetUniformLocation( s_pShader->getProgram(), "u_pointSize");
     CHECK_GL_ERROR_DEBUG();
 
+        // batched lines and triangles have a color per vertex
+        s_pColorShader = CCShaderCache::sharedShaderCache()->programForKey(kCCShader_PositionColor);
+        s_pColorShader->retain();
+
         s_bInitialized = true;
     }
 }
@@ -83,225 +124,393 @@ static void lazy_init( void )
 void ccDrawInit()
 {
     lazy_init();
+
+    // the buffer went away with the previous context
+    s_uBatchVBO = 0;
 }
 
 void ccDrawFree()
 {
 	CC_SAFE_RELEASE_NULL(s_pShader);
+	CC_SAFE_RELEASE_NULL(s_pColorShader);
+	if (s_uBatchVBO)
+	{
+	    ccGLDeleteBuffers(1, &s_uBatchVBO);
+	    s_uBatchVBO = 0;
+	}
+	s_tBuckets.clear();
+	s_uBucketCount = 0;
+	s_nBatchDepth = 0;
 	s_bInitialized = false;
 }
 
-void ccDrawPoint( const CCPoint& point )
+static ccDrawBatchBucket& batchBucket(GLenum mode, const ccColor4F& color, const kmMat4& projection)
 {
-    lazy_init();
+    GLfloat lineWidth = mode == GL_LINES ? s_fLineWidth : 0;
+    GLfloat pointSize = mode == GL_POINTS ? s_fPointSize : 0;
+    ccColor4F pointColor = mode == GL_POINTS ? color : ccc4f(0, 0, 0, 0);
 
-    ccVertex2F p;
-    p.x = point.x;
-    p.y = point.y;
-
-    ccGLEnableVertexAttribs( kCCVertexAttribFlag_Position );
-    s_pShader->use();
-    s_pShader->setUniformsForBuiltins();
-
-    s_pShader->setUniformLocationWith4fv(s_nColorLocation, (GLfloat*) &s_tColor.r, 1);
-    s_pShader->setUniformLocationWith1f(s_nPointSizeLocation, s_fPointSize);
-
-    glVertexAttribPointer(kCCVertexAttrib_Position, 2, GL_FLOAT, GL_FALSE, 0, &p);
+    // the last used bucket first, most primitives follow one of the same kind
+    for (unsigned int n = 0; n < s_uBucketCount; ++n)
+    {
+        unsigned int i = (s_uLastBucket + n) % s_uBucketCount;
+        ccDrawBatchBucket& bucket = s_tBuckets[i];
+        if (bucket.mode == mode && bucket.lineWidth == lineWidth && bucket.pointSize == pointSize
+            && memcmp(&bucket.pointColor, &pointColor, sizeof(pointColor)) == 0
+            && memcmp(&bucket.projection, &projection, sizeof(projection)) == 0)
+        {
+            s_uLastBucket = i;
+            return bucket;
+        }
+    }
 
-    glDrawArrays(GL_POINTS, 0, 1);
+    if (s_uBucketCount == s_tBuckets.size())
+    {
+        s_tBuckets.push_back(ccDrawBatchBucket());
+    }
 
-    CC_INCREMENT_GL_DRAWS(1);
+    s_uLastBucket = s_uBucketCount++;
+    ccDrawBatchBucket& bucket = s_tBuckets[s_uLastBucket];
+    bucket.mode = mode;
+    bucket.lineWidth = lineWidth;
+    bucket.pointSize = pointSize;
+    bucket.pointColor = pointColor;
+    bucket.projection = projection;
+    bucket.vertices.clear();
+    return bucket;
 }
 
-void ccDrawPoints( const CCPoint *points, unsigned int numberOfPoints )
+// adds the vertices of a primitive drawn with mode to the batch, as points, lines or triangles
+static void batchVertices(GLenum mode, const ccVertex2F *vertices, unsigned int numberOfVertices, const ccColor4F& color)
 {
-    lazy_init();
+    kmMat4 projection, modelview;
+    kmGLGetMatrix(KM_GL_PROJECTION, &projection);
+    kmGLGetMatrix(KM_GL_MODELVIEW, &modelview);
 
-    ccGLEnableVertexAttribs( kCCVertexAttribFlag_Position );
-    s_pShader->use();
-    s_pShader->setUniformsForBuiltins();
-    s_pShader->setUniformLocationWith4fv(s_nColorLocation, (GLfloat*) &s_tColor.r, 1);
-    s_pShader->setUniformLocationWith1f(s_nPointSizeLocation, s_fPointSize);
-
-    // XXX: Mac OpenGL error. arrays can't go out of scope before draw is executed
-    ccVertex2F* newPoints = new ccVertex2F[numberOfPoints];
-
-    // iPhone and 32-bit machines optimization
-    if( sizeof(CCPoint) == sizeof(ccVertex2F) )
+    GLenum batchMode = GL_LINES;
+    unsigned int numberOfBatchVertices = 0;
+    switch (mode)
     {
-        glVertexAttribPointer(kCCVertexAttrib_Position, 2, GL_FLOAT, GL_FALSE, 0, points);
+    case GL_POINTS:
+        batchMode = GL_POINTS;
+        numberOfBatchVertices = numberOfVertices;
+        break;
+    case GL_LINES:
+        numberOfBatchVertices = numberOfVertices & ~1;
+        break;
+    case GL_LINE_STRIP:
+        numberOfBatchVertices = numberOfVertices > 1 ? (numberOfVertices - 1) * 2 : 0;
+        break;
+    case GL_LINE_LOOP:
+        numberOfBatchVertices = numberOfVertices > 1 ? numberOfVertices * 2 : 0;
+        break;
+    case GL_TRIANGLE_FAN:
+        batchMode = GL_TRIANGLES;
+        numberOfBatchVertices = numberOfVertices > 2 ? (numberOfVertices - 2) * 3 : 0;
+        break;
+    default:
+        CCAssert(0, "ccDraw: mode not supported by the batch");
+        break;
     }
-    else
+
+    if (numberOfBatchVertices == 0)
     {
-        // Mac on 64-bit
-        for( unsigned int i=0; i<numberOfPoints;i++) {
-            newPoints[i].x = points[i].x;
-            newPoints[i].y = points[i].y;
-        }
-        glVertexAttribPointer(kCCVertexAttrib_Position, 2, GL_FLOAT, GL_FALSE, 0, newPoints);
+        return;
     }
 
-    glDrawArrays(GL_POINTS, 0, (GLsizei) numberOfPoints);
+    std::vector<ccDrawBatchVertex>& batch = batchBucket(batchMode, color, projection).vertices;
+    unsigned int first = batch.size();
+    batch.resize(first + numberOfBatchVertices);
+    ccDrawBatchVertex *out = &batch[first];
 
-    CC_SAFE_DELETE_ARRAY(newPoints);
+    ccColor4B color4B = ccc4BFromccc4F(color);
+    const float *m = modelview.mat;
+    for (unsigned int i = 0; i < numberOfBatchVertices; ++i)
+    {
+        // the index of the vertex of the primitive
+        unsigned int v = i;
+        switch (mode)
+        {
+        case GL_LINE_STRIP:
+            v = i / 2 + i % 2;
+            break;
+        case GL_LINE_LOOP:
+            v = (i / 2 + i % 2) % numberOfVertices;
+            break;
+        case GL_TRIANGLE_FAN:
+            v = i % 3 == 0 ? 0 : i / 3 + i % 3;
+            break;
+        }
 
-    CC_INCREMENT_GL_DRAWS(1);
+        float x = vertices[v].x;
+        float y = vertices[v].y;
+        out[i].vertices.x = m[0] * x + m[4] * y + m[12];
+        out[i].vertices.y = m[1] * x + m[5] * y + m[13];
+        out[i].vertices.z = m[2] * x + m[6] * y + m[14];
+        out[i].colors = color4B;
+    }
 }
 
-
-void ccDrawLine( const CCPoint& origin, const CCPoint& destination )
+// draws the vertices of a primitive, or adds them to the batch
+static void drawVertices(GLenum mode, const ccVertex2F *vertices, unsigned int numberOfVertices, const ccColor4F& color)
 {
     lazy_init();
 
-    ccVertex2F vertices[2] = {
-        {origin.x, origin.y},
-        {destination.x, destination.y}
-    };
+    ++s_uPrimitiveCount;
+    if (s_nBatchDepth > 0)
+    {
+        batchVertices(mode, vertices, numberOfVertices, color);
+        return;
+    }
 
     s_pShader->use();
     s_pShader->setUniformsForBuiltins();
-    s_pShader->setUniformLocationWith4fv(s_nColorLocation, (GLfloat*) &s_tColor.r, 1);
+    s_pShader->setUniformLocationWith4fv(s_nColorLocation, (GLfloat*) &color.r, 1);
+    if (mode == GL_POINTS)
+    {
+        s_pShader->setUniformLocationWith1f(s_nPointSizeLocation, s_fPointSize);
+    }
 
     ccGLEnableVertexAttribs( kCCVertexAttribFlag_Position );
     glVertexAttribPointer(kCCVertexAttrib_Position, 2, GL_FLOAT, GL_FALSE, 0, vertices);
-    glDrawArrays(GL_LINES, 0, 2);
+    glDrawArrays(mode, 0, (GLsizei) numberOfVertices);
 
+    ++s_uDrawCount;
     CC_INCREMENT_GL_DRAWS(1);
 }
 
-void ccDrawRect( CCPoint origin, CCPoint destination )
+// the points as vertices, without copying them when they have the same layout
+static const ccVertex2F* verticesWithPoints(const CCPoint *points, unsigned int numberOfPoints)
 {
-    ccDrawLine(CCPointMake(origin.x, origin.y), CCPointMake(destination.x, origin.y));
-    ccDrawLine(CCPointMake(destination.x, origin.y), CCPointMake(destination.x, destination.y));
-    ccDrawLine(CCPointMake(destination.x, destination.y), CCPointMake(origin.x, destination.y));
-    ccDrawLine(CCPointMake(origin.x, destination.y), CCPointMake(origin.x, origin.y));
+    // iPhone and 32-bit machines optimization
+    if( sizeof(CCPoint) == sizeof(ccVertex2F) )
+    {
+        return (const ccVertex2F*) points;
+    }
+
+    // Mac on 64-bit
+    s_tVertices.resize(numberOfPoints);
+    for( unsigned int i=0; i<numberOfPoints;i++) {
+        s_tVertices[i] = vertex2( points[i].x, points[i].y );
+    }
+    return numberOfPoints ? &s_tVertices[0] : NULL;
 }
 
-void ccDrawSolidRect( CCPoint origin, CCPoint destination, ccColor4F color )
+void ccDrawBeginBatch()
 {
-    CCPoint vertices[] = {
-        origin,
-        ccp(destination.x, origin.y),
-        destination,
-        ccp(origin.x, destination.y)
-    };
+    if (s_nBatchDepth++ == 0)
+    {
+        // glLineWidth() may have been called since the last batch
+        glGetFloatv(GL_LINE_WIDTH, &s_fLineWidth);
+    }
+}
 
-    ccDrawSolidPoly(vertices, 4, color );
+void ccDrawEndBatch()
+{
+    CCAssert(s_nBatchDepth > 0, "ccDrawEndBatch: no batch started");
+    if (s_nBatchDepth > 0 && --s_nBatchDepth == 0)
+    {
+        ccDrawFlush();
+    }
 }
 
-void ccDrawPoly( const CCPoint *poli, unsigned int numberOfPoints, bool closePolygon )
+void ccDrawFlush()
 {
-    lazy_init();
+    unsigned int numberOfVertices = 0;
+    for (unsigned int i = 0; i < s_uBucketCount; ++i)
+    {
+        numberOfVertices += s_tBuckets[i].vertices.size();
+    }
 
-    s_pShader->use();
-    s_pShader->setUniformsForBuiltins();
-    s_pShader->setUniformLocationWith4fv(s_nColorLocation, (GLfloat*) &s_tColor.r, 1);
+    if (numberOfVertices == 0)
+    {
+        s_uBucketCount = 0;
+        return;
+    }
 
-    ccGLEnableVertexAttribs( kCCVertexAttribFlag_Position );
+    lazy_init();
 
-    // iPhone and 32-bit machines optimization
-    if( sizeof(CCPoint) == sizeof(ccVertex2F) )
+    if (! s_uBatchVBO)
     {
-        glVertexAttribPointer(kCCVertexAttrib_Position, 2, GL_FLOAT, GL_FALSE, 0, poli);
+        glGenBuffers(1, &s_uBatchVBO);
+    }
 
-        if( closePolygon )
-            glDrawArrays(GL_LINE_LOOP, 0, (GLsizei) numberOfPoints);
-        else
-            glDrawArrays(GL_LINE_STRIP, 0, (GLsizei) numberOfPoints);
+    // the buffer is orphaned and filled again by every flush
+    ccGLBindVAO(0);
+    ccGLBindBuffer(GL_ARRAY_BUFFER, s_uBatchVBO);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(ccDrawBatchVertex) * numberOfVertices, NULL, GL_STREAM_DRAW);
+    unsigned int first = 0;
+    for (unsigned int i = 0; i < s_uBucketCount; ++i)
+    {
+        std::vector<ccDrawBatchVertex>& vertices = s_tBuckets[i].vertices;
+        if (! vertices.empty())
+        {
+            glBufferSubData(GL_ARRAY_BUFFER, sizeof(ccDrawBatchVertex) * first, sizeof(ccDrawBatchVertex) * vertices.size(), &vertices[0]);
+            first += vertices.size();
+        }
     }
-    else
+
+    // the vertices are already transformed by their modelview matrix
+    kmGLMatrixMode(KM_GL_MODELVIEW);
+    kmGLPushMatrix();
+    kmGLLoadIdentity();
+    kmGLMatrixMode(KM_GL_PROJECTION);
+    kmGLPushMatrix();
+
+    first = 0;
+    for (unsigned int i = 0; i < s_uBucketCount; ++i)
     {
-        // Mac on 64-bit
-        // XXX: Mac OpenGL error. arrays can't go out of scope before draw is executed
-        ccVertex2F* newPoli = new ccVertex2F[numberOfPoints];
-        for( unsigned int i=0; i<numberOfPoints;i++) {
-            newPoli[i].x = poli[i].x;
-            newPoli[i].y = poli[i].y;
+        ccDrawBatchBucket& bucket = s_tBuckets[i];
+        if (bucket.vertices.empty())
+        {
+            continue;
         }
-        glVertexAttribPointer(kCCVertexAttrib_Position, 2, GL_FLOAT, GL_FALSE, 0, newPoli);
 
-        if( closePolygon )
-            glDrawArrays(GL_LINE_LOOP, 0, (GLsizei) numberOfPoints);
+        kmGLLoadMatrix(&bucket.projection);
+
+        if (bucket.mode == GL_POINTS)
+        {
+            s_pShader->use();
+            s_pShader->setUniformsForBuiltins();
+            s_pShader->setUniformLocationWith4fv(s_nColorLocation, (GLfloat*) &bucket.pointColor.r, 1);
+            s_pShader->setUniformLocationWith1f(s_nPointSizeLocation, bucket.pointSize);
+            ccGLEnableVertexAttribs( kCCVertexAttribFlag_Position );
+        }
         else
-            glDrawArrays(GL_LINE_STRIP, 0, (GLsizei) numberOfPoints);
+        {
+            s_pColorShader->use();
+            s_pColorShader->setUniformsForBuiltins();
+            ccGLEnableVertexAttribs( kCCVertexAttribFlag_Position | kCCVertexAttribFlag_Color );
+            glVertexAttribPointer(kCCVertexAttrib_Color, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(ccDrawBatchVertex), (GLvoid*) offsetof(ccDrawBatchVertex, colors));
+        }
+        glVertexAttribPointer(kCCVertexAttrib_Position, 3, GL_FLOAT, GL_FALSE, sizeof(ccDrawBatchVertex), (GLvoid*) offsetof(ccDrawBatchVertex, vertices));
 
-        CC_SAFE_DELETE_ARRAY(newPoli);
-    }
+        if (bucket.mode == GL_LINES)
+        {
+            glLineWidth(bucket.lineWidth);
+        }
 
-    CC_INCREMENT_GL_DRAWS(1);
-}
+        glDrawArrays(bucket.mode, (GLint) first, (GLsizei) bucket.vertices.size());
+        first += bucket.vertices.size();
 
-void ccDrawSolidPoly( const CCPoint *poli, unsigned int numberOfPoints, ccColor4F color )
-{
-    lazy_init();
+        ++s_uDrawCount;
+        CC_INCREMENT_GL_DRAWS(1);
+    }
 
-    s_pShader->use();
-    s_pShader->setUniformsForBuiltins();
-    s_pShader->setUniformLocationWith4fv(s_nColorLocation, (GLfloat*) &color.r, 1);
+    kmGLPopMatrix();
+    kmGLMatrixMode(KM_GL_MODELVIEW);
+    kmGLPopMatrix();
 
-    ccGLEnableVertexAttribs( kCCVertexAttribFlag_Position );
+    ccGLBindBuffer(GL_ARRAY_BUFFER, 0);
+    glLineWidth(s_fLineWidth);
 
-    // XXX: Mac OpenGL error. arrays can't go out of scope before draw is executed
-    ccVertex2F* newPoli = new ccVertex2F[numberOfPoints];
+    // the vertices keep their memory for the next batch
+    for (unsigned int i = 0; i < s_uBucketCount; ++i)
+    {
+        s_tBuckets[i].vertices.clear();
+    }
+    s_uBucketCount = 0;
+    s_uLastBucket = 0;
+}
 
-    // iPhone and 32-bit machines optimization
-    if( sizeof(CCPoint) == sizeof(ccVertex2F) )
+void ccDrawGetStats(unsigned int *pPrimitives, unsigned int *pDrawCalls)
+{
+    if (pPrimitives)
     {
-        glVertexAttribPointer(kCCVertexAttrib_Position, 2, GL_FLOAT, GL_FALSE, 0, poli);
+        *pPrimitives = s_uPrimitiveCount;
     }
-    else
+    if (pDrawCalls)
     {
-        // Mac on 64-bit
-        for( unsigned int i=0; i<numberOfPoints;i++)
-        {
-            newPoli[i] = vertex2( poli[i].x, poli[i].y );
-        }
-        glVertexAttribPointer(kCCVertexAttrib_Position, 2, GL_FLOAT, GL_FALSE, 0, newPoli);
-    }    
+        *pDrawCalls = s_uDrawCount;
+    }
+}
 
-    glDrawArrays(GL_TRIANGLE_FAN, 0, (GLsizei) numberOfPoints);
+void ccDrawResetStats()
+{
+    s_uPrimitiveCount = 0;
+    s_uDrawCount = 0;
+}
 
-    CC_SAFE_DELETE_ARRAY(newPoli);
-    CC_INCREMENT_GL_DRAWS(1);
+void ccDrawPoint( const CCPoint& point )
+{
+    ccVertex2F p;
+    p.x = point.x;
+    p.y = point.y;
+
+    drawVertices(GL_POINTS, &p, 1, s_tColor);
 }
 
-void ccDrawCircle( const CCPoint& center, float radius, float angle, unsigned int segments, bool drawLineToCenter, float scaleX, float scaleY)
+void ccDrawPoints( const CCPoint *points, unsigned int numberOfPoints )
 {
-    lazy_init();
+    drawVertices(GL_POINTS, verticesWithPoints(points, numberOfPoints), numberOfPoints, s_tColor);
+}
+
 
+void ccDrawLine( const CCPoint& origin, const CCPoint& destination )
+{
+    ccVertex2F vertices[2] = {
+        {origin.x, origin.y},
+        {destination.x, destination.y}
+    };
+
+    drawVertices(GL_LINES, vertices, 2, s_tColor);
+}
+
+void ccDrawRect( CCPoint origin, CCPoint destination )
+{
+    // one line loop rather than 4 lines
+    CCPoint vertices[] = {
+        origin,
+        ccp(destination.x, origin.y),
+        destination,
+        ccp(origin.x, destination.y)
+    };
+
+    ccDrawPoly(vertices, 4, true);
+}
+
+void ccDrawSolidRect( CCPoint origin, CCPoint destination, ccColor4F color )
+{
+    CCPoint vertices[] = {
+        origin,
+        ccp(destination.x, origin.y),
+        destination,
+        ccp(origin.x, destination.y)
+    };
+
+    ccDrawSolidPoly(vertices, 4, color );
+}
+
+void ccDrawPoly( const CCPoint *poli, unsigned int numberOfPoints, bool closePolygon )
+{
+    drawVertices(closePolygon ? GL_LINE_LOOP : GL_LINE_STRIP, verticesWithPoints(poli, numberOfPoints), numberOfPoints, s_tColor);
+}
+
+void ccDrawSolidPoly( const CCPoint *poli, unsigned int numberOfPoints, ccColor4F color )
+{
+    drawVertices(GL_TRIANGLE_FAN, verticesWithPoints(poli, numberOfPoints), numberOfPoints, color);
+}
+
+void ccDrawCircle( const CCPoint& center, float radius, float angle, unsigned int segments, bool drawLineToCenter, float scaleX, float scaleY)
+{
     int additionalSegment = 1;
     if (drawLineToCenter)
         additionalSegment++;
 
     const float coef = 2.0f * (float)M_PI/segments;
 
-    GLfloat *vertices = (GLfloat*)calloc( sizeof(GLfloat)*2*(segments+2), 1);
-    if( ! vertices )
-        return;
+    s_tVertices.resize(segments + 2);
+    ccVertex2F *vertices = &s_tVertices[0];
 
     for(unsigned int i = 0;i <= segments; i++) {
         float rads = i*coef;
-        GLfloat j = radius * cosf(rads + angle) * scaleX + center.x;
-        GLfloat k = radius * sinf(rads + angle) * scaleY + center.y;
-
-        vertices[i*2] = j;
-        vertices[i*2+1] = k;
+        vertices[i].x = radius * cosf(rads + angle) * scaleX + center.x;
+        vertices[i].y = radius * sinf(rads + angle) * scaleY + center.y;
     }
-    vertices[(segments+1)*2] = center.x;
-    vertices[(segments+1)*2+1] = center.y;
-
-    s_pShader->use();
-    s_pShader->setUniformsForBuiltins();
-    s_pShader->setUniformLocationWith4fv(s_nColorLocation, (GLfloat*) &s_tColor.r, 1);
+    vertices[segments+1].x = center.x;
+    vertices[segments+1].y = center.y;
 
-    ccGLEnableVertexAttribs( kCCVertexAttribFlag_Position );
-
-    glVertexAttribPointer(kCCVertexAttrib_Position, 2, GL_FLOAT, GL_FALSE, 0, vertices);
-    glDrawArrays(GL_LINE_STRIP, 0, (GLsizei) segments+additionalSegment);
-
-    free( vertices );
-
-    CC_INCREMENT_GL_DRAWS(1);
+    drawVertices(GL_LINE_STRIP, vertices, segments + additionalSegment, s_tColor);
 }
 
 void CC_DLL ccDrawCircle( const CCPoint& center, float radius, float angle, unsigned int segments, bool drawLineToCenter)
@@ -311,9 +520,8 @@ void CC_DLL ccDrawCircle( const CCPoint& center, float radius, float angle, unsi
 
 void ccDrawQuadBezier(const CCPoint& origin, const CCPoint& control, const CCPoint& destination, unsigned int segments)
 {
-    lazy_init();
-
-    ccVertex2F* vertices = new ccVertex2F[segments + 1];
+    s_tVertices.resize(segments + 1);
+    ccVertex2F *vertices = &s_tVertices[0];
 
     float t = 0.0f;
     for(unsigned int i = 0; i < segments; i++)
@@ -325,17 +533,7 @@ void ccDrawQuadBezier(const CCPoint& origin, const CCPoint& control, const CCPoi
     vertices[segments].x = destination.x;
     vertices[segments].y = destination.y;
 
-    s_pShader->use();
-    s_pShader->setUniformsForBuiltins();
-    s_pShader->setUniformLocationWith4fv(s_nColorLocation, (GLfloat*) &s_tColor.r, 1);
-
-    ccGLEnableVertexAttribs( kCCVertexAttribFlag_Position );
-
-    glVertexAttribPointer(kCCVertexAttrib_Position, 2, GL_FLOAT, GL_FALSE, 0, vertices);
-    glDrawArrays(GL_LINE_STRIP, 0, (GLsizei) segments + 1);
-    CC_SAFE_DELETE_ARRAY(vertices);
-
-    CC_INCREMENT_GL_DRAWS(1);
+    drawVertices(GL_LINE_STRIP, vertices, segments + 1, s_tColor);
 }
 
 void ccDrawCatmullRom( CCPointArray *points, unsigned int segments )
@@ -345,9 +543,8 @@ void ccDrawCatmullRom( CCPointArray *points, unsigned int segments )
 
 void ccDrawCardinalSpline( CCPointArray *config, float tension,  unsigned int segments )
 {
-    lazy_init();
-
-    ccVertex2F* vertices = new ccVertex2F[segments + 1];
+    s_tVertices.resize(segments + 1);
+    ccVertex2F *vertices = &s_tVertices[0];
 
     unsigned int p;
     float lt;
@@ -377,24 +574,13 @@ void ccDrawCardinalSpline( CCPointArray *config, float tension,  unsigned int se
         vertices[i].y = newPos.y;
     }
 
-    s_pShader->use();
-    s_pShader->setUniformsForBuiltins();
-    s_pShader->setUniformLocationWith4fv(s_nColorLocation, (GLfloat*)&s_tColor.r, 1);
-
-    ccGLEnableVertexAttribs( kCCVertexAttribFlag_Position );
-
-    glVertexAttribPointer(kCCVertexAttrib_Position, 2, GL_FLOAT, GL_FALSE, 0, vertices);
-    glDrawArrays(GL_LINE_STRIP, 0, (GLsizei) segments + 1);
-
-    CC_SAFE_DELETE_ARRAY(vertices);
-    CC_INCREMENT_GL_DRAWS(1);
+    drawVertices(GL_LINE_STRIP, vertices, segments + 1, s_tColor);
 }
 
 void ccDrawCubicBezier(const CCPoint& origin, const CCPoint& control1, const CCPoint& control2, const CCPoint& destination, unsigned int segments)
 {
-    lazy_init();
-
-    ccVertex2F* vertices = new ccVertex2F[segments + 1];
+    s_tVertices.resize(segments + 1);
+    ccVertex2F *vertices = &s_tVertices[0];
 
     float t = 0;
     for(unsigned int i = 0; i < segments; i++)
@@ -406,17 +592,7 @@ void ccDrawCubicBezier(const CCPoint& origin, const CCPoint& control1, const CCP
     vertices[segments].x = destination.x;
     vertices[segments].y = destination.y;
 
-    s_pShader->use();
-    s_pShader->setUniformsForBuiltins();
-    s_pShader->setUniformLocationWith4fv(s_nColorLocation, (GLfloat*) &s_tColor.r, 1);
-
-    ccGLEnableVertexAttribs( kCCVertexAttribFlag_Position );
-
-    glVertexAttribPointer(kCCVertexAttrib_Position, 2, GL_FLOAT, GL_FALSE, 0, vertices);
-    glDrawArrays(GL_LINE_STRIP, 0, (GLsizei) segments + 1);
-    CC_SAFE_DELETE_ARRAY(vertices);
-
-    CC_INCREMENT_GL_DRAWS(1);
+    drawVertices(GL_LINE_STRIP, vertices, segments + 1, s_tColor);
 }
 
 void ccDrawColor4F( GLfloat r, GLfloat g, GLfloat b, GLfloat a )
@@ -435,6 +611,17 @@ void ccPointSize( GLfloat pointSize )
 
 }
 
+void ccLineWidth( GLfloat lineWidth )
+{
+    s_fLineWidth = lineWidth;
+
+    // a batch sets it when its lines are drawn
+    if (s_nBatchDepth == 0)
+    {
+        glLineWidth(lineWidth);
+    }
+}
+
 void ccDrawColor4B( GLubyte r, GLubyte g, GLubyte b, GLubyte a )
 {
     s_tColor.r = r/255.0f;
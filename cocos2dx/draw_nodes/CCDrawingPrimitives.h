@@ -60,9 +60,10 @@ THE SOFTWARE.
  You can change the color, point size, width by calling:
  - ccDrawColor4B(), ccDrawColor4F()
  - ccPointSize()
- - glLineWidth()
+ - ccLineWidth()
  
- @warning These functions draws the Line, Point, Polygon, immediately. They aren't batched. If you are going to make a game that depends on these primitives, I suggest creating a batch. Instead you should use CCDrawNode
+ @warning These functions draws the Line, Point, Polygon, immediately, unless they are between ccDrawBeginBatch() and ccDrawEndBatch().
+ If you are going to make a game that depends on these primitives, you should use CCDrawNode instead.
  
  */
 
@@ -152,6 +153,40 @@ void CC_DLL ccDrawColor4F( GLfloat r, GLfloat g, GLfloat b, GLfloat a );
  */
 void CC_DLL ccPointSize( GLfloat pointSize );
 
+/** set the line width in pixels, like glLineWidth(), but also for the lines of a batch. Default 1.
+ @since v2.1.4
+ */
+void CC_DLL ccLineWidth( GLfloat lineWidth );
+
+/** starts a batch: the primitives drawn until ccDrawEndBatch() are collected and drawn with a few draw calls,
+ one for each kind of primitive (points, lines and solid shapes), line width, point size and color of the points, and projection.
+ The primitives are transformed by the modelview matrix when they are drawn, which must be affine.
+ The primitives of different kinds may be drawn in another order than they were drawn in.
+ Batches can be nested, the primitives are drawn by the outermost ccDrawEndBatch().
+ @since v2.1.4
+ */
+void CC_DLL ccDrawBeginBatch();
+
+/** ends a batch started by ccDrawBeginBatch(), drawing its primitives if it is the outermost one
+ @since v2.1.4
+ */
+void CC_DLL ccDrawEndBatch();
+
+/** draws the primitives collected by the current batch. It is called by CCDirector at the end of each frame.
+ @since v2.1.4
+ */
+void CC_DLL ccDrawFlush();
+
+/** number of primitives drawn and of draw calls made by the drawing primitives since ccDrawResetStats()
+ @since v2.1.4
+ */
+void CC_DLL ccDrawGetStats(unsigned int *pPrimitives, unsigned int *pDrawCalls);
+
+/** resets the numbers of ccDrawGetStats()
+ @since v2.1.4
+ */
+void CC_DLL ccDrawResetStats();
+
 // end of global group
 /// @}
 
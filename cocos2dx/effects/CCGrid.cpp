@@ -35,6 +35,7 @@ THE SOFTWARE.
 #include "support/TransformUtils.h"
 #include "kazmath/kazmath.h"
 #include "kazmath/GL/matrix.h"
+#include <pthread.h>
 
 NS_CC_BEGIN
 // implementation of CCGridBase
@@ -182,7 +183,7 @@ void CCGridBase::set2DProjection()
 
     CCSize    size = director->getWinSizeInPixels();
 
-    glViewport(0, 0, (GLsizei)(size.width * CC_CONTENT_SCALE_FACTOR()), (GLsizei)(size.height * CC_CONTENT_SCALE_FACTOR()) );
+    ccGLViewport(0, 0, (GLsizei)(size.width * CC_CONTENT_SCALE_FACTOR()), (GLsizei)(size.height * CC_CONTENT_SCALE_FACTOR()) );
     kmGLMatrixMode(KM_GL_PROJECTION);
     kmGLLoadIdentity();
 
@@ -657,4 +658,157 @@ void CCTiledGrid3D::reuse(void)
     }
 }
 
+// worker threads of ccGridParallelFor
+
+#define CC_GRID_MAX_THREADS 16
+
+static unsigned int s_uGridThreads = 1;
+static unsigned int s_uGridMinVertices = 8192;
+static unsigned int s_uGridWorkers = 0;
+static pthread_t s_pGridWorkers[CC_GRID_MAX_THREADS];
+// the last job seen by each worker
+static unsigned int s_pGridWorkerGenerations[CC_GRID_MAX_THREADS];
+static pthread_mutex_t s_gridMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t s_gridWorkCond = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t s_gridDoneCond = PTHREAD_COND_INITIALIZER;
+
+// the current job, the worker i updates the part i + 1 and the calling thread the part 0
+static CC_GRID_COLUMNS_FUNC s_pGridFunc = NULL;
+static void *s_pGridContext = NULL;
+static unsigned int s_uGridColumns = 0;
+static unsigned int s_uGridParts = 0;
+static unsigned int s_uGridPending = 0;
+static unsigned int s_uGridGeneration = 0;
+static bool s_bGridQuit = false;
+
+static void gridRunPart(unsigned int uPart)
+{
+    if (uPart >= s_uGridParts)
+    {
+        return;
+    }
+
+    unsigned int uBegin = s_uGridColumns * uPart / s_uGridParts;
+    unsigned int uEnd = s_uGridColumns * (uPart + 1) / s_uGridParts;
+    if (uBegin < uEnd)
+    {
+        s_pGridFunc(s_pGridContext, uBegin, uEnd);
+    }
+}
+
+static void* gridWorker(void *pData)
+{
+    unsigned int uWorker = (unsigned int)(long)pData;
+    unsigned int uGeneration = s_pGridWorkerGenerations[uWorker];
+
+    pthread_mutex_lock(&s_gridMutex);
+    while (true)
+    {
+        while (uGeneration == s_uGridGeneration && !s_bGridQuit)
+        {
+            pthread_cond_wait(&s_gridWorkCond, &s_gridMutex);
+        }
+        if (s_bGridQuit)
+        {
+            break;
+        }
+        uGeneration = s_uGridGeneration;
+        pthread_mutex_unlock(&s_gridMutex);
+
+        gridRunPart(uWorker + 1);
+
+        pthread_mutex_lock(&s_gridMutex);
+        if (--s_uGridPending == 0)
+        {
+            pthread_cond_signal(&s_gridDoneCond);
+        }
+    }
+    pthread_mutex_unlock(&s_gridMutex);
+
+    return NULL;
+}
+
+void ccGridStopThreads(void)
+{
+    if (s_uGridWorkers == 0)
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&s_gridMutex);
+    s_bGridQuit = true;
+    pthread_cond_broadcast(&s_gridWorkCond);
+    pthread_mutex_unlock(&s_gridMutex);
+
+    for (unsigned int i = 0; i < s_uGridWorkers; ++i)
+    {
+        pthread_join(s_pGridWorkers[i], NULL);
+    }
+    s_uGridWorkers = 0;
+    s_bGridQuit = false;
+}
+
+void ccGridParallelFor(unsigned int uColumns, unsigned int uColumnSize, CC_GRID_COLUMNS_FUNC pFunc, void *pContext)
+{
+    unsigned int uParts = MIN(s_uGridThreads, uColumns);
+    if (uParts <= 1 || uColumns * uColumnSize < s_uGridMinVertices)
+    {
+        pFunc(pContext, 0, uColumns);
+        return;
+    }
+
+    // the workers are started on the first large grid
+    while (s_uGridWorkers < s_uGridThreads - 1)
+    {
+        s_pGridWorkerGenerations[s_uGridWorkers] = s_uGridGeneration;
+        if (pthread_create(&s_pGridWorkers[s_uGridWorkers], NULL, gridWorker, (void*)(long)s_uGridWorkers) != 0)
+        {
+            CCLOG("cocos2d: ccGridParallelFor: can't create a worker thread");
+            break;
+        }
+        ++s_uGridWorkers;
+    }
+    uParts = MIN(uParts, s_uGridWorkers + 1);
+
+    pthread_mutex_lock(&s_gridMutex);
+    s_pGridFunc = pFunc;
+    s_pGridContext = pContext;
+    s_uGridColumns = uColumns;
+    s_uGridParts = uParts;
+    s_uGridPending = s_uGridWorkers;
+    ++s_uGridGeneration;
+    pthread_cond_broadcast(&s_gridWorkCond);
+    pthread_mutex_unlock(&s_gridMutex);
+
+    gridRunPart(0);
+
+    pthread_mutex_lock(&s_gridMutex);
+    while (s_uGridPending > 0)
+    {
+        pthread_cond_wait(&s_gridDoneCond, &s_gridMutex);
+    }
+    pthread_mutex_unlock(&s_gridMutex);
+}
+
+void ccGridSetThreads(unsigned int uThreads, unsigned int uMinVertices)
+{
+    uThreads = MAX(1, MIN(uThreads, CC_GRID_MAX_THREADS));
+    if (uThreads != s_uGridThreads)
+    {
+        ccGridStopThreads();
+        s_uGridThreads = uThreads;
+    }
+    s_uGridMinVertices = uMinVertices;
+}
+
+unsigned int ccGridGetThreads(void)
+{
+    return s_uGridThreads;
+}
+
+unsigned int ccGridGetMinVertices(void)
+{
+    return s_uGridMinVertices;
+}
+
 NS_CC_END
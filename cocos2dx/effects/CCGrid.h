@@ -117,6 +117,16 @@ public:
     /** sets a new vertex at a given position */
     void setVertex(const CCPoint& pos, const ccVertex3F& vertex);
 
+    /** the vertices, (gridSize.height + 1) vertices by column from the left column.
+     The vertex at (x, y) is getVertices()[x * (gridSize.height + 1) + y].
+     @since v2.1.4
+     */
+    inline ccVertex3F* getVertices(void) { return (ccVertex3F*)m_pVertices; }
+    /** the original (non-transformed) vertices, in the same order as getVertices()
+     @since v2.1.4
+     */
+    inline const ccVertex3F* getOriginalVertices(void) { return (const ccVertex3F*)m_pOriginalVertices; }
+
     virtual void blit(void);
     virtual void reuse(void);
     virtual void calculateVertexPoints(void);
@@ -151,6 +161,16 @@ public:
     /** sets a new tile */
     void setTile(const CCPoint& pos, const ccQuad3& coords);
 
+    /** the tiles, gridSize.height tiles by column from the left column.
+     The tile at (x, y) is getTiles()[x * gridSize.height + y].
+     @since v2.1.4
+     */
+    inline ccQuad3* getTiles(void) { return (ccQuad3*)m_pVertices; }
+    /** the original (untransformed) tiles, in the same order as getTiles()
+     @since v2.1.4
+     */
+    inline const ccQuad3* getOriginalTiles(void) { return (const ccQuad3*)m_pOriginalVertices; }
+
     virtual void blit(void);
     virtual void reuse(void);
     virtual void calculateVertexPoints(void);
@@ -169,6 +189,44 @@ protected:
     GLushort *m_pIndices;
 };
 
+/** function updating the columns [uBegin, uEnd) of a grid, see ccGridParallelFor()
+ @since v2.1.4
+ */
+typedef void (*CC_GRID_COLUMNS_FUNC)(void *pContext, unsigned int uBegin, unsigned int uEnd);
+
+/** Calls pFunc on the columns of a grid.
+ If the grid has at least the number of vertices set by ccGridSetThreads(), the columns are split
+ between the worker threads and the calling thread, otherwise pFunc is called once for all the columns.
+ Returns when all the columns are done. Must be called from the main thread.
+ @param uColumns number of columns of the grid
+ @param uColumnSize number of vertices or tiles by column
+ @since v2.1.4
+ */
+void CC_DLL ccGridParallelFor(unsigned int uColumns, unsigned int uColumnSize, CC_GRID_COLUMNS_FUNC pFunc, void *pContext);
+
+/** Sets the number of threads updating the large grids, the calling thread included, and the number of
+ vertices from which a grid is large. 1 thread, the default, disables the worker threads.
+ The built-in grid effects update their vertices with ccGridParallelFor().
+ @since v2.1.4
+ */
+void CC_DLL ccGridSetThreads(unsigned int uThreads, unsigned int uMinVertices);
+
+/** Stops and joins the worker threads of ccGridParallelFor(), they are started again by the next large grid.
+ CCDirector::purgeDirector() calls it.
+ @since v2.1.4
+ */
+void CC_DLL ccGridStopThreads(void);
+
+/** returns the number of threads updating the large grids
+ @since v2.1.4
+ */
+unsigned int CC_DLL ccGridGetThreads(void);
+
+/** returns the number of vertices from which a grid is updated by several threads, 8192 by default
+ @since v2.1.4
+ */
+unsigned int CC_DLL ccGridGetMinVertices(void);
+
 // end of effects group
 /// @}
 
@@ -190,6 +190,22 @@ Only valid for cocos2d-mac. Not supported on cocos2d-ios.
     #endif
 #endif
 
+/** @def CC_ENABLE_PROGRAM_BINARY_CACHE
+ If enabled, the programs of CCShaderCache are saved with the GL_OES_get_program_binary extension, when the driver
+ supports it, in files of CCFileUtils::getWritablePath() named by a hash of their sources and of the driver.
+ They are read from there instead of being compiled the next time the game starts or the GL context is recreated.
+
+ Enabled by default on android only, where compiling the shaders takes the longest.
+ @since v2.1.4
+ */
+#ifndef CC_ENABLE_PROGRAM_BINARY_CACHE
+    #if (CC_TARGET_PLATFORM == CC_PLATFORM_ANDROID)
+        #define CC_ENABLE_PROGRAM_BINARY_CACHE 1
+    #else
+        #define CC_ENABLE_PROGRAM_BINARY_CACHE 0
+    #endif
+#endif
+
 
 /** @def CC_USE_LA88_LABELS
  If enabled, it will use LA88 (Luminance Alpha 16-bit textures) for CCLabelTTF objects.
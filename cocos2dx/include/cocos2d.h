@@ -98,6 +98,10 @@ THE SOFTWARE.
 #include "label_nodes/CCLabelAtlas.h"
 #include "label_nodes/CCLabelTTF.h"
 #include "label_nodes/CCLabelBMFont.h"
+#if (CC_TARGET_PLATFORM == CC_PLATFORM_LINUX)
+#include "label_nodes/CCFontAtlas.h"
+#include "label_nodes/CCLabelFontAtlas.h"
+#endif
 
 // layers_scenes_transitions_nodes
 #include "layers_scenes_transitions_nodes/CCLayer.h"
@@ -112,6 +116,7 @@ THE SOFTWARE.
 
 // misc_nodes
 #include "misc_nodes/CCClippingNode.h"
+#include "misc_nodes/CCClipStack.h"
 #include "misc_nodes/CCMotionStreak.h"
 #include "misc_nodes/CCProgressTimer.h"
 #include "misc_nodes/CCRenderTexture.h"
@@ -128,6 +133,7 @@ THE SOFTWARE.
 #include "platform/CCFileUtils.h"
 #include "platform/CCImage.h"
 #include "platform/CCSAXParser.h"
+#include "platform/CCPlistParser.h"
 #include "platform/CCThread.h"
 #include "platform/platform.h"
 #include "platform/CCPlatformConfig.h"
@@ -239,6 +245,7 @@ THE SOFTWARE.
 // tilemap_parallax_nodes
 #include "tilemap_parallax_nodes/CCParallaxNode.h"
 #include "tilemap_parallax_nodes/CCTMXLayer.h"
+#include "tilemap_parallax_nodes/CCTMXPagedLayer.h"
 #include "tilemap_parallax_nodes/CCTMXObjectGroup.h"
 #include "tilemap_parallax_nodes/CCTMXTiledMap.h"
 #include "tilemap_parallax_nodes/CCTMXXMLParser.h"
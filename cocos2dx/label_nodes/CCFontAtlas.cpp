@@ -0,0 +1,477 @@
+/****************************************************************************
+Copyright (c) 2013 cocos2d-x.org
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+#include "CCFontAtlas.h"
+#include "cocoa/CCArray.h"
+#include "cocoa/CCDictionary.h"
+#include "cocoa/CCString.h"
+#include "textures/CCTexture2D.h"
+#include "support/CCPointExtension.h"
+#include "shaders/ccGLStateCache.h"
+#include "support/CCNotificationCenter.h"
+#include "CCEventType.h"
+#include "CCGL.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <ctype.h>
+
+#include "platform/linux/CCFreeType.h"
+
+NS_CC_BEGIN
+
+// font atlases shared by the labels, by "name:size"
+static CCDictionary* s_pFontAtlases = NULL;
+
+static unsigned int nextCharacter(const unsigned char **pp)
+{
+    const unsigned char *p = *pp;
+    unsigned int c = *p++;
+    int nFollowing = 0;
+    if ((c & 0xe0) == 0xc0)
+    {
+        c &= 0x1f;
+        nFollowing = 1;
+    }
+    else if ((c & 0xf0) == 0xe0)
+    {
+        c &= 0x0f;
+        nFollowing = 2;
+    }
+    else if ((c & 0xf8) == 0xf0)
+    {
+        c &= 0x07;
+        nFollowing = 3;
+    }
+
+    for (int i = 0; i < nFollowing && (*p & 0xc0) == 0x80; ++i)
+    {
+        c = (c << 6) | (*p++ & 0x3f);
+    }
+    *pp = p;
+    return c;
+}
+
+static inline bool isBreakPoint(unsigned int uPreviousCharacter)
+{
+    // we can insert a line break after one of these characters
+    return uPreviousCharacter == '-' || uPreviousCharacter == '/' || uPreviousCharacter == '\\';
+}
+
+static inline bool isSpace(unsigned int uCharacter)
+{
+    return uCharacter < 0x80 && isspace(uCharacter);
+}
+
+static void finishLine(ccGlyphLine& line, std::vector<ccGlyphLine>& lines, int *pMaxLineWidth)
+{
+    line.width = 0;
+    if (! line.glyphs.empty())
+    {
+        const ccGlyphPosition& last = line.glyphs.back();
+        line.width = last.x + last.glyph->width;
+    }
+    *pMaxLineWidth = MAX(*pMaxLineWidth, line.width);
+    lines.push_back(line);
+    line.glyphs.clear();
+    line.width = 0;
+}
+
+CCFontAtlas::CCFontAtlas()
+: m_nFontSize(0)
+, m_pFace(NULL)
+, m_bHasKerning(false)
+, m_nLineHeight(0)
+, m_nFontHeight(0)
+, m_nBaseline(0)
+, m_pPages(NULL)
+, m_nPenX(0)
+, m_nPenY(0)
+, m_nShelfHeight(0)
+{
+}
+
+CCFontAtlas::~CCFontAtlas()
+{
+#if CC_ENABLE_CACHE_TEXTURE_DATA
+    CCNotificationCenter::sharedNotificationCenter()->removeObserver(this, EVNET_COME_TO_FOREGROUND);
+#endif
+    if (m_pFace)
+    {
+        FT_Done_Face(m_pFace);
+    }
+    for (unsigned int i = 0; i < m_pageData.size(); ++i)
+    {
+        free(m_pageData[i].pData);
+    }
+    CC_SAFE_RELEASE(m_pPages);
+}
+
+CCFontAtlas* CCFontAtlas::fontAtlas(const char *pFontName, int nFontSize)
+{
+    if (! s_pFontAtlases)
+    {
+        s_pFontAtlases = new CCDictionary();
+    }
+
+    char szSize[16];
+    snprintf(szSize, sizeof(szSize), ":%d", nFontSize);
+    std::string key = std::string(pFontName) + szSize;
+
+    CCFontAtlas *pRet = (CCFontAtlas*)s_pFontAtlases->objectForKey(key);
+    if (! pRet)
+    {
+        pRet = new CCFontAtlas();
+        if (! pRet->initWithFont(pFontName, nFontSize))
+        {
+            CC_SAFE_DELETE(pRet);
+            return NULL;
+        }
+        s_pFontAtlases->setObject(pRet, key);
+        pRet->release();
+    }
+    return pRet;
+}
+
+void CCFontAtlas::purgeUnusedFontAtlases()
+{
+    if (! s_pFontAtlases)
+    {
+        return;
+    }
+
+    CCArray *pUnused = CCArray::create();
+    CCDictElement *pElement = NULL;
+    CCDICT_FOREACH(s_pFontAtlases, pElement)
+    {
+        if (pElement->getObject()->retainCount() == 1)
+        {
+            pUnused->addObject(CCString::create(pElement->getStrKey()));
+        }
+    }
+    s_pFontAtlases->removeObjectsForKeys(pUnused);
+}
+
+void CCFontAtlas::purgeFontAtlases()
+{
+    CC_SAFE_RELEASE_NULL(s_pFontAtlases);
+}
+
+bool CCFontAtlas::initWithFont(const char *pFontName, int nFontSize)
+{
+    m_pFace = ccFreeTypeNewFace(pFontName, nFontSize);
+    if (! m_pFace)
+    {
+        CCLOG("cocos2d: CCFontAtlas: can not load font %s", pFontName);
+        return false;
+    }
+
+    m_sFontName = pFontName;
+    m_nFontSize = nFontSize;
+    m_bHasKerning = FT_HAS_KERNING(m_pFace);
+    m_nLineHeight = m_pFace->size->metrics.height >> 6;
+    m_nFontHeight = ceilf(FT_MulFix(m_pFace->bbox.yMax - m_pFace->bbox.yMin, m_pFace->size->metrics.y_scale) / 64.0f);
+    m_nBaseline = ceilf(FT_MulFix(m_pFace->bbox.yMax, m_pFace->size->metrics.y_scale) / 64.0f);
+
+    m_pPages = new CCArray();
+
+#if CC_ENABLE_CACHE_TEXTURE_DATA
+    // the pages are not in the texture cache, they are uploaded again from their bitmaps
+    CCNotificationCenter::sharedNotificationCenter()->addObserver(this,
+                                                                  callfuncO_selector(CCFontAtlas::listenToForeground),
+                                                                  EVNET_COME_TO_FOREGROUND,
+                                                                  NULL);
+#endif
+    return true;
+}
+
+const ccGlyphDef* CCFontAtlas::glyphForCharacter(unsigned int uCharacter)
+{
+    std::map<unsigned int, ccGlyphDef>::iterator iter = m_glyphs.find(uCharacter);
+    if (iter != m_glyphs.end())
+    {
+        return &iter->second;
+    }
+
+    FT_UInt index = FT_Get_Char_Index(m_pFace, uCharacter);
+    if (FT_Load_Glyph(m_pFace, index, FT_LOAD_RENDER))
+    {
+        return NULL;
+    }
+
+    FT_GlyphSlot slot = m_pFace->glyph;
+    ccGlyphDef glyph;
+    glyph.index = index;
+    glyph.page = kCCFontAtlasNoPage;
+    glyph.rect = CCRectZero;
+    glyph.width = slot->metrics.width >> 6;
+    glyph.bearingX = slot->metrics.horiBearingX >> 6;
+    glyph.bearingY = slot->metrics.horiBearingY >> 6;
+    glyph.advance = slot->metrics.horiAdvance >> 6;
+
+    FT_Bitmap& bitmap = slot->bitmap;
+    CCPoint origin;
+    if (bitmap.width > 0 && bitmap.rows > 0 && bitmap.pixel_mode == FT_PIXEL_MODE_GRAY
+        && placeGlyph(bitmap.width, bitmap.rows, origin))
+    {
+        Page& page = m_pageData.back();
+        int x = (int)origin.x;
+        int y = (int)origin.y;
+        for (int row = 0; row < (int)bitmap.rows; ++row)
+        {
+            memcpy(page.pData + (y + row) * CC_FONT_ATLAS_PAGE_SIZE + x, bitmap.buffer + row * bitmap.pitch, bitmap.width);
+        }
+        page.nDirtyTop = MIN(page.nDirtyTop, y);
+        page.nDirtyBottom = MAX(page.nDirtyBottom, y + (int)bitmap.rows);
+
+        glyph.page = m_pageData.size() - 1;
+        glyph.rect = CCRectMake(x, y, bitmap.width, bitmap.rows);
+    }
+
+    return &(m_glyphs[uCharacter] = glyph);
+}
+
+int CCFontAtlas::kerning(const ccGlyphDef *pLeft, const ccGlyphDef *pRight)
+{
+    FT_Vector delta;
+    if (m_bHasKerning && pLeft->index != 0
+        && ! FT_Get_Kerning(m_pFace, pLeft->index, pRight->index, FT_KERNING_DEFAULT, &delta))
+    {
+        return delta.x >> 6;
+    }
+    return 0;
+}
+
+// Same algorithm as BitmapDC::divideString in platform/linux/CCImage.cpp
+bool CCFontAtlas::layoutString(const char *pText, int nMaxWidth, std::vector<ccGlyphLine>& lines, int *pMaxLineWidth)
+{
+    lines.clear();
+    *pMaxLineWidth = 0;
+
+    ccGlyphLine currentLine;
+    currentLine.width = 0;
+    const ccGlyphDef *pPreviousGlyph = NULL;
+    unsigned int uPreviousCharacter = 0;
+    int nPaintPosition = 0;
+    int nLastBreakIndex = -1;
+
+    const unsigned char *p = (const unsigned char*)pText;
+    while (*p)
+    {
+        unsigned int uCharacter = nextCharacter(&p);
+        if (uCharacter == '\n')
+        {
+            finishLine(currentLine, lines, pMaxLineWidth);
+            pPreviousGlyph = NULL;
+            uPreviousCharacter = 0;
+            nLastBreakIndex = -1;
+            nPaintPosition = 0;
+            continue;
+        }
+
+        if (isBreakPoint(uPreviousCharacter))
+        {
+            nLastBreakIndex = (int)currentLine.glyphs.size() - 1;
+        }
+
+        const ccGlyphDef *pGlyph = glyphForCharacter(uCharacter);
+        if (! pGlyph)
+        {
+            return false;
+        }
+
+        if (isSpace(uCharacter))
+        {
+            nPaintPosition += pGlyph->advance;
+            pPreviousGlyph = pGlyph;
+            uPreviousCharacter = uCharacter;
+            nLastBreakIndex = currentLine.glyphs.size();
+            continue;
+        }
+
+        ccGlyphPosition position;
+        position.glyph = pGlyph;
+        position.kerning = pPreviousGlyph ? kerning(pPreviousGlyph, pGlyph) : 0;
+
+        int nRight = nPaintPosition + pGlyph->bearingX + position.kerning + pGlyph->width;
+        if (nMaxWidth > 0 && nRight > nMaxWidth)
+        {
+            int nGlyphCount = currentLine.glyphs.size();
+            if (nLastBreakIndex >= 0 && nLastBreakIndex < nGlyphCount
+                && nRight - currentLine.glyphs[nLastBreakIndex].x < nMaxWidth)
+            {
+                // we insert a line break at our last break opportunity
+                std::vector<ccGlyphPosition> moved(currentLine.glyphs.begin() + nLastBreakIndex, currentLine.glyphs.end());
+                currentLine.glyphs.erase(currentLine.glyphs.begin() + nLastBreakIndex, currentLine.glyphs.end());
+                finishLine(currentLine, lines, pMaxLineWidth);
+                nPaintPosition = 0;
+                for (unsigned int i = 0; i < moved.size(); ++i)
+                {
+                    ccGlyphPosition& movedPosition = moved[i];
+                    if (currentLine.glyphs.empty())
+                    {
+                        nPaintPosition = -movedPosition.glyph->bearingX;
+                        movedPosition.kerning = 0;
+                    }
+                    movedPosition.x = nPaintPosition + movedPosition.glyph->bearingX + movedPosition.kerning;
+                    currentLine.glyphs.push_back(movedPosition);
+                    nPaintPosition += movedPosition.kerning + movedPosition.glyph->advance;
+                }
+            }
+            else
+            {
+                // the current word is too big to fit into one line, insert line break right here
+                nPaintPosition = 0;
+                position.kerning = 0;
+                finishLine(currentLine, lines, pMaxLineWidth);
+            }
+
+            pPreviousGlyph = NULL;
+            uPreviousCharacter = 0;
+            nLastBreakIndex = -1;
+        }
+        else
+        {
+            pPreviousGlyph = pGlyph;
+            uPreviousCharacter = uCharacter;
+        }
+
+        if (currentLine.glyphs.empty())
+        {
+            nPaintPosition = -pGlyph->bearingX;
+        }
+        position.x = nPaintPosition + pGlyph->bearingX + position.kerning;
+        currentLine.glyphs.push_back(position);
+        nPaintPosition += position.kerning + pGlyph->advance;
+    }
+
+    if (! currentLine.glyphs.empty())
+    {
+        finishLine(currentLine, lines, pMaxLineWidth);
+    }
+    return true;
+}
+
+void CCFontAtlas::updatePages()
+{
+    for (unsigned int i = 0; i < m_pageData.size(); ++i)
+    {
+        Page& page = m_pageData[i];
+        if (page.nDirtyTop >= page.nDirtyBottom)
+        {
+            continue;
+        }
+
+        ccGLBindTexture2D(getPage(i)->getName());
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, page.nDirtyTop, CC_FONT_ATLAS_PAGE_SIZE, page.nDirtyBottom - page.nDirtyTop,
+                        GL_ALPHA, GL_UNSIGNED_BYTE, page.pData + page.nDirtyTop * CC_FONT_ATLAS_PAGE_SIZE);
+
+        page.nDirtyTop = CC_FONT_ATLAS_PAGE_SIZE;
+        page.nDirtyBottom = 0;
+    }
+}
+
+void CCFontAtlas::listenToForeground(CCObject *obj)
+{
+    for (unsigned int i = 0; i < m_pageData.size(); ++i)
+    {
+        Page& page = m_pageData[i];
+        getPage(i)->initWithData(page.pData, kCCTexture2DPixelFormat_A8, CC_FONT_ATLAS_PAGE_SIZE, CC_FONT_ATLAS_PAGE_SIZE,
+                                 CCSizeMake(CC_FONT_ATLAS_PAGE_SIZE, CC_FONT_ATLAS_PAGE_SIZE));
+        page.nDirtyTop = CC_FONT_ATLAS_PAGE_SIZE;
+        page.nDirtyBottom = 0;
+    }
+}
+
+unsigned int CCFontAtlas::getPageCount()
+{
+    return m_pageData.size();
+}
+
+CCTexture2D* CCFontAtlas::getPage(unsigned int uPage)
+{
+    return (CCTexture2D*)m_pPages->objectAtIndex(uPage);
+}
+
+bool CCFontAtlas::addPage()
+{
+    Page page;
+    page.pData = (unsigned char*)calloc(CC_FONT_ATLAS_PAGE_SIZE * CC_FONT_ATLAS_PAGE_SIZE, 1);
+    page.nDirtyTop = CC_FONT_ATLAS_PAGE_SIZE;
+    page.nDirtyBottom = 0;
+    if (! page.pData)
+    {
+        return false;
+    }
+
+    CCTexture2D *pTexture = new CCTexture2D();
+    if (! pTexture->initWithData(page.pData, kCCTexture2DPixelFormat_A8, CC_FONT_ATLAS_PAGE_SIZE, CC_FONT_ATLAS_PAGE_SIZE,
+                                 CCSizeMake(CC_FONT_ATLAS_PAGE_SIZE, CC_FONT_ATLAS_PAGE_SIZE)))
+    {
+        pTexture->release();
+        free(page.pData);
+        return false;
+    }
+    m_pPages->addObject(pTexture);
+    pTexture->release();
+    m_pageData.push_back(page);
+
+    // keep a pixel between glyphs so that they don't bleed into each other when filtered
+    m_nPenX = 1;
+    m_nPenY = 1;
+    m_nShelfHeight = 0;
+    return true;
+}
+
+bool CCFontAtlas::placeGlyph(int nWidth, int nHeight, CCPoint& origin)
+{
+    if (nWidth + 2 > CC_FONT_ATLAS_PAGE_SIZE || nHeight + 2 > CC_FONT_ATLAS_PAGE_SIZE)
+    {
+        return false;
+    }
+
+    if (m_pageData.empty() && ! addPage())
+    {
+        return false;
+    }
+
+    // glyphs fill shelves from left to right, and shelves fill the page from top to bottom
+    if (m_nPenX + nWidth + 1 > CC_FONT_ATLAS_PAGE_SIZE)
+    {
+        m_nPenX = 1;
+        m_nPenY += m_nShelfHeight + 1;
+        m_nShelfHeight = 0;
+    }
+    if (m_nPenY + nHeight + 1 > CC_FONT_ATLAS_PAGE_SIZE && ! addPage())
+    {
+        return false;
+    }
+
+    origin = ccp(m_nPenX, m_nPenY);
+    m_nPenX += nWidth + 1;
+    m_nShelfHeight = MAX(m_nShelfHeight, nHeight);
+    return true;
+}
+
+NS_CC_END
@@ -0,0 +1,201 @@
+/****************************************************************************
+Copyright (c) 2013 cocos2d-x.org
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+#ifndef __CCFONT_ATLAS_H__
+#define __CCFONT_ATLAS_H__
+
+#include "cocoa/CCObject.h"
+#include "cocoa/CCGeometry.h"
+#include <string>
+#include <vector>
+#include <map>
+
+struct FT_FaceRec_;
+
+NS_CC_BEGIN
+
+class CCArray;
+class CCTexture2D;
+
+/**
+ * @addtogroup GUI
+ * @{
+ * @addtogroup label
+ * @{
+ */
+
+/** Width and height of the pages of a CCFontAtlas, in pixels */
+#define CC_FONT_ATLAS_PAGE_SIZE     512
+
+/** Page of the glyphs that have nothing to draw, like spaces */
+#define kCCFontAtlasNoPage          0xffffffff
+
+/** @struct ccGlyphDef
+ A glyph rasterized into a page of a CCFontAtlas. Metrics are in pixels.
+ */
+typedef struct _ccGlyphDef
+{
+    //! glyph index in the font, used for kerning
+    unsigned int index;
+    //! page of the font atlas, or kCCFontAtlasNoPage
+    unsigned int page;
+    //! the bitmap of the glyph in the page
+    CCRect rect;
+    //! width of the glyph outline
+    int width;
+    //! distance from the pen position to the left of the glyph
+    int bearingX;
+    //! distance from the baseline to the top of the glyph
+    int bearingY;
+    //! distance from the pen position to the next one
+    int advance;
+} ccGlyphDef;
+
+/** @struct ccGlyphPosition
+ A glyph placed on a line by CCFontAtlas::layoutString.
+ */
+typedef struct _ccGlyphPosition
+{
+    const ccGlyphDef *glyph;
+    //! left of the glyph, from the start of the line
+    int x;
+    //! kerning with the previous glyph of the line
+    int kerning;
+} ccGlyphPosition;
+
+/** @struct ccGlyphLine
+ A line of glyphs laid out by CCFontAtlas::layoutString.
+ */
+typedef struct _ccGlyphLine
+{
+    std::vector<ccGlyphPosition> glyphs;
+    int width;
+} ccGlyphLine;
+
+/** @brief CCFontAtlas rasterizes the glyphs of a TrueType font on demand into shared texture pages.
+
+ There is one atlas per font name and pixel size, shared by every label using them.
+ Glyphs are rasterized the first time they are used and stay in the atlas, so changing
+ the text of a label only updates its vertices.
+
+ Metrics, kerning and line breaking are the ones CCImage::initWithString uses, so text
+ laid out by the atlas looks like the text of a CCLabelTTF.
+
+ Rasterization uses FreeType, so the font atlas is only built on Linux.
+ @since v2.1.4
+ */
+class CC_DLL CCFontAtlas : public CCObject
+{
+public:
+    CCFontAtlas();
+    virtual ~CCFontAtlas();
+
+    /** Returns the shared atlas of a font name and size in pixels, creating it if needed.
+     @return The atlas, or NULL if the font can not be loaded.
+     */
+    static CCFontAtlas* fontAtlas(const char *pFontName, int nFontSize);
+
+    /** Removes the atlases which are not used by any label */
+    static void purgeUnusedFontAtlases();
+
+    /** Removes all the shared atlases */
+    static void purgeFontAtlases();
+
+    bool initWithFont(const char *pFontName, int nFontSize);
+
+    /** Returns the glyph of a unicode character, rasterizing it if needed.
+     @return The glyph, which stays valid as long as the atlas, or NULL if the font can not load it.
+     */
+    const ccGlyphDef* glyphForCharacter(unsigned int uCharacter);
+
+    /** Horizontal kerning between two glyphs, in pixels */
+    int kerning(const ccGlyphDef *pLeft, const ccGlyphDef *pRight);
+
+    /** Splits an UTF-8 string into lines no wider than nMaxWidth pixels (0 for no limit),
+     breaking them like CCImage::initWithString does.
+     @return false if a character can not be loaded.
+     */
+    bool layoutString(const char *pText, int nMaxWidth, std::vector<ccGlyphLine>& lines, int *pMaxLineWidth);
+
+    /** Uploads the glyphs rasterized since the last call to the page textures */
+    void updatePages();
+
+    /** Listens to the "come to foreground" message and uploads the pages again after the
+     OpenGL context was lost. It only has effect when CC_ENABLE_CACHE_TEXTURE_DATA is set.
+     */
+    void listenToForeground(CCObject *obj);
+
+    /** Number of pages */
+    unsigned int getPageCount();
+
+    /** The texture of a page, in kCCTexture2DPixelFormat_A8 */
+    CCTexture2D* getPage(unsigned int uPage);
+
+    /** Distance between the baselines of two lines, in pixels */
+    inline int getLineHeight() { return m_nLineHeight; }
+
+    /** Height of a line of text, in pixels */
+    inline int getFontHeight() { return m_nFontHeight; }
+
+    /** Distance from the top of a line to its baseline, in pixels */
+    inline int getBaseline() { return m_nBaseline; }
+
+    inline const std::string& getFontName() { return m_sFontName; }
+    inline int getFontSize() { return m_nFontSize; }
+
+private:
+    typedef struct _Page
+    {
+        unsigned char *pData;
+        int            nDirtyTop;
+        int            nDirtyBottom;
+    } Page;
+
+    bool addPage();
+    bool placeGlyph(int nWidth, int nHeight, CCPoint& origin);
+
+    std::string m_sFontName;
+    int m_nFontSize;
+    struct FT_FaceRec_ *m_pFace;
+    bool m_bHasKerning;
+    int m_nLineHeight;
+    int m_nFontHeight;
+    int m_nBaseline;
+
+    std::map<unsigned int, ccGlyphDef> m_glyphs;
+    CCArray *m_pPages;
+    std::vector<Page> m_pageData;
+
+    // shelf packing in the last page
+    int m_nPenX;
+    int m_nPenY;
+    int m_nShelfHeight;
+};
+
+// end of label group
+/// @}
+/// @}
+
+NS_CC_END
+
+#endif //__CCFONT_ATLAS_H__
@@ -114,6 +114,8 @@ bool CCLabelAtlas::initWithString(const char *theString, const char *fntFile)
 //CCLabelAtlas - Atlas generation
 void CCLabelAtlas::updateAtlasValues()
 {
+    setBitmapCacheDirty();
+
     unsigned int n = m_sString.length();
 
     ccV3F_C4B_T2F_Quad quad;
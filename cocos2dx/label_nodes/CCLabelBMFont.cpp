@@ -42,6 +42,9 @@ http://www.angelcode.com/products/bmfont/ (Free, Windows only)
 #include "CCDirector.h"
 #include "textures/CCTextureCache.h"
 #include "support/ccUTF8.h"
+#include "CCScheduler.h"
+#include <algorithm>
+#include <pthread.h>
 
 using namespace std;
 
@@ -87,6 +90,196 @@ CCBMFontConfiguration* FNTConfigLoadFile( const char *fntFile)
     return pRet;
 }
 
+// Parses the FNT file read by CCFileUtils on a worker thread, then waits for the atlas texture
+class CCBMFontConfigurationAsyncLoader : public CCObject
+{
+public:
+    CCBMFontConfigurationAsyncLoader(const char *fntFile, CCObject *target, SEL_CallFuncO selector)
+    : m_sFntFile(fntFile)
+    , m_pTarget(target)
+    , m_pSelector(selector)
+    , m_pConfiguration(NULL)
+    , m_pParsedConfiguration(NULL)
+    , m_pData(NULL)
+    , m_uSize(0)
+    , m_nMaxTextureSize(0)
+    , m_bParsed(false)
+    , m_bParseSucceeded(false)
+    {
+        CC_SAFE_RETAIN(m_pTarget);
+        pthread_mutex_init(&m_mutex, NULL);
+    }
+
+    virtual ~CCBMFontConfigurationAsyncLoader()
+    {
+        CC_SAFE_DELETE_ARRAY(m_pData);
+        CC_SAFE_RELEASE(m_pParsedConfiguration);
+        CC_SAFE_RELEASE(m_pConfiguration);
+        CC_SAFE_RELEASE(m_pTarget);
+        pthread_mutex_destroy(&m_mutex);
+    }
+
+    void fileDataLoaded(CCObject *pObject)
+    {
+        CCAsyncFileData *pData = (CCAsyncFileData*)pObject;
+
+        // it may have been loaded synchronously in the meantime
+        if (! configurationLoaded() && pData->getBuffer())
+        {
+            m_uSize = pData->getSize();
+            m_pData = pData->detachBuffer();
+            m_pParsedConfiguration = new CCBMFontConfiguration();
+            // CCConfiguration queries GL, so it is read on the main thread
+            m_nMaxTextureSize = CCConfiguration::sharedConfiguration()->getMaxTextureSize();
+
+            // kept alive until the parse is done
+            this->retain();
+            if (pthread_create(&m_thread, NULL, parseThread, this) == 0)
+            {
+                CCDirector::sharedDirector()->getScheduler()->scheduleSelector(
+                    schedule_selector(CCBMFontConfigurationAsyncLoader::checkParse), this, 0, false);
+                return;
+            }
+
+            // no thread, parses it now
+            this->release();
+            parse();
+            parseDone();
+            return;
+        }
+
+        loadTexture();
+    }
+
+    void checkParse(float dt)
+    {
+        pthread_mutex_lock(&m_mutex);
+        bool bParsed = m_bParsed;
+        pthread_mutex_unlock(&m_mutex);
+
+        if (bParsed)
+        {
+            CCDirector::sharedDirector()->getScheduler()->unscheduleSelector(
+                schedule_selector(CCBMFontConfigurationAsyncLoader::checkParse), this);
+            pthread_join(m_thread, NULL);
+            parseDone();
+            this->release();
+        }
+    }
+
+    void textureLoaded(CCObject *pTexture)
+    {
+        if (m_pTarget && m_pSelector)
+        {
+            (m_pTarget->*m_pSelector)(m_pConfiguration);
+        }
+    }
+
+private:
+    static void* parseThread(void *pArg)
+    {
+        CCBMFontConfigurationAsyncLoader *pLoader = (CCBMFontConfigurationAsyncLoader*)pArg;
+        pLoader->parse();
+
+        pthread_mutex_lock(&pLoader->m_mutex);
+        pLoader->m_bParsed = true;
+        pthread_mutex_unlock(&pLoader->m_mutex);
+        return NULL;
+    }
+
+    // only touches the configuration, nothing shared with the main thread
+    void parse()
+    {
+        std::string pageFile;
+        m_bParseSucceeded = m_pParsedConfiguration->parseConfigData((const char*)m_pData, m_uSize, m_nMaxTextureSize, pageFile);
+        m_sPageFile = pageFile;
+        CC_SAFE_DELETE_ARRAY(m_pData);
+    }
+
+    void parseDone()
+    {
+        // the configuration loaded synchronously in the meantime wins
+        if (! configurationLoaded() && m_bParseSucceeded)
+        {
+            m_pParsedConfiguration->m_sAtlasName = CCFileUtils::sharedFileUtils()->fullPathFromRelativeFile(m_sPageFile.c_str(), m_sFntFile.c_str());
+            if (s_pConfigurations == NULL)
+            {
+                s_pConfigurations = new CCDictionary();
+            }
+            s_pConfigurations->setObject(m_pParsedConfiguration, m_sFntFile);
+            m_pConfiguration = m_pParsedConfiguration;
+            m_pConfiguration->retain();
+        }
+        CC_SAFE_RELEASE_NULL(m_pParsedConfiguration);
+
+        loadTexture();
+    }
+
+    bool configurationLoaded()
+    {
+        if (! m_pConfiguration && s_pConfigurations)
+        {
+            m_pConfiguration = (CCBMFontConfiguration*)s_pConfigurations->objectForKey(m_sFntFile);
+            CC_SAFE_RETAIN(m_pConfiguration);
+        }
+        return m_pConfiguration != NULL;
+    }
+
+    void loadTexture()
+    {
+        if (m_pConfiguration)
+        {
+            CCTextureCache::sharedTextureCache()->addImageAsync(m_pConfiguration->getAtlasName(), this,
+                callfuncO_selector(CCBMFontConfigurationAsyncLoader::textureLoaded));
+        }
+        else
+        {
+            CCLOG("cocos2d: Error parsing FNTfile %s", m_sFntFile.c_str());
+            textureLoaded(NULL);
+        }
+    }
+
+    std::string m_sFntFile;
+    CCObject *m_pTarget;
+    SEL_CallFuncO m_pSelector;
+    CCBMFontConfiguration *m_pConfiguration;
+
+    // state shared with the parse thread
+    CCBMFontConfiguration *m_pParsedConfiguration;
+    unsigned char *m_pData;
+    unsigned long m_uSize;
+    int m_nMaxTextureSize;
+    std::string m_sPageFile;
+    bool m_bParsed;
+    bool m_bParseSucceeded;
+    pthread_t m_thread;
+    pthread_mutex_t m_mutex;
+};
+
+unsigned int FNTConfigLoadFileAsync( const char *fntFile, CCObject *target, SEL_CallFuncO selector )
+{
+    CCBMFontConfiguration* pRet = NULL;
+    if (s_pConfigurations)
+    {
+        pRet = (CCBMFontConfiguration*)s_pConfigurations->objectForKey(fntFile);
+    }
+
+    if (pRet)
+    {
+        if (target && selector)
+        {
+            (target->*selector)(pRet);
+        }
+        return 0;
+    }
+
+    CCBMFontConfigurationAsyncLoader *pLoader = new CCBMFontConfigurationAsyncLoader(fntFile, target, selector);
+    unsigned int uRequestId = CCFileUtils::sharedFileUtils()->getFileDataAsync(fntFile, pLoader,
+        callfuncO_selector(CCBMFontConfigurationAsyncLoader::fileDataLoaded));
+    pLoader->release();
+    return uRequestId;
+}
+
 void FNTConfigRemoveCache( void )
 {
     if (s_pConfigurations)
@@ -114,38 +307,83 @@ CCBMFontConfiguration * CCBMFontConfiguration::create(const char *FNTfile)
 
 bool CCBMFontConfiguration::initWithFNTfile(const char *FNTfile)
 {
-    m_pKerningDictionary = NULL;
-    m_pFontDefDictionary = NULL;
-    
-    m_pCharacterSet = this->parseConfigFile(FNTfile);
-    
-    if (! m_pCharacterSet)
+    return this->parseConfigFile(FNTfile);
+}
+
+bool CCBMFontConfiguration::initWithFNTfile(const char *FNTfile, const char *pData, unsigned long uSize)
+{
+    std::string pageFile;
+    if (! this->parseConfigData(pData, uSize, CCConfiguration::sharedConfiguration()->getMaxTextureSize(), pageFile))
     {
         return false;
     }
 
+    m_sAtlasName = CCFileUtils::sharedFileUtils()->fullPathFromRelativeFile(pageFile.c_str(), FNTfile);
     return true;
 }
 
 std::set<unsigned int>* CCBMFontConfiguration::getCharacterSet() const
 {
+    if (! m_pCharacterSet)
+    {
+        m_pCharacterSet = new set<unsigned int>();
+        for (unsigned int i = 0; i < m_tFontDefs.size(); ++i)
+        {
+            m_pCharacterSet->insert(m_pCharacterSet->end(), m_tFontDefs[i].charID);
+        }
+    }
     return m_pCharacterSet;
 }
 
+static bool compareFontDefs(const ccBMFontDef& a, const ccBMFontDef& b)
+{
+    return a.charID < b.charID;
+}
+
+static bool compareKernings(const ccBMFontKerning& a, const ccBMFontKerning& b)
+{
+    return a.key < b.key;
+}
+
+const ccBMFontDef* CCBMFontConfiguration::fontDefForCharacter(unsigned int uCharacter) const
+{
+    ccBMFontDef key;
+    key.charID = uCharacter;
+    std::vector<ccBMFontDef>::const_iterator it = std::lower_bound(m_tFontDefs.begin(), m_tFontDefs.end(), key, compareFontDefs);
+    if (it != m_tFontDefs.end() && it->charID == uCharacter)
+    {
+        return &*it;
+    }
+    return NULL;
+}
+
+int CCBMFontConfiguration::kerningAmountForFirst(unsigned short first, unsigned short second) const
+{
+    if (m_tKernings.empty())
+    {
+        return 0;
+    }
+
+    ccBMFontKerning key;
+    key.key = (first<<16) | (second & 0xffff);
+    std::vector<ccBMFontKerning>::const_iterator it = std::lower_bound(m_tKernings.begin(), m_tKernings.end(), key, compareKernings);
+    if (it != m_tKernings.end() && it->key == key.key)
+    {
+        return it->amount;
+    }
+    return 0;
+}
+
 CCBMFontConfiguration::CCBMFontConfiguration()
-: m_pFontDefDictionary(NULL)
-, m_nCommonHeight(0)
-, m_pKerningDictionary(NULL)
+: m_nCommonHeight(0)
 , m_pCharacterSet(NULL)
 {
-
+    m_tPadding.left = m_tPadding.top = m_tPadding.right = m_tPadding.bottom = 0;
 }
 
 CCBMFontConfiguration::~CCBMFontConfiguration()
 {
     CCLOGINFO( "cocos2d: deallocing CCBMFontConfiguration" );
-    this->purgeFontDefDictionary();
-    this->purgeKerningDictionary();
     m_sAtlasName.clear();
     CC_SAFE_DELETE(m_pCharacterSet);
 }
@@ -155,262 +393,400 @@ const char* CCBMFontConfiguration::description(void)
     return CCString::createWithFormat(
         "<CCBMFontConfiguration = %08X | Glphys:%d Kernings:%d | Image = %s>",
         this,
-        HASH_COUNT(m_pFontDefDictionary),
-        HASH_COUNT(m_pKerningDictionary),
+        (int)m_tFontDefs.size(),
+        (int)m_tKernings.size(),
         m_sAtlasName.c_str()
     )->getCString();
 }
 
-void CCBMFontConfiguration::purgeKerningDictionary()
+bool CCBMFontConfiguration::parseConfigFile(const char *controlFile)
+{    
+    std::string fullpath = CCFileUtils::sharedFileUtils()->fullPathForFilename(controlFile);
+    unsigned long uSize = 0;
+    unsigned char *pData = CCFileUtils::sharedFileUtils()->getFileData(fullpath.c_str(), "rb", &uSize);
+
+    CCAssert(pData, "CCBMFontConfiguration::parseConfigFile | Open file error.");
+    
+    if (!pData)
+    {
+        CCLOG("cocos2d: Error parsing FNTfile %s", controlFile);
+        return false;
+    }
+
+    bool bRet = initWithFNTfile(controlFile, (const char*)pData, uSize);
+    delete [] pData;
+    return bRet;
+}
+
+bool CCBMFontConfiguration::parseConfigData(const char *pData, unsigned long uSize, int nMaxTextureSize, std::string& pageFile)
 {
-    tCCKerningHashElement *current;
-    while(m_pKerningDictionary) 
+    m_tFontDefs.clear();
+    m_tKernings.clear();
+    CC_SAFE_DELETE(m_pCharacterSet);
+
+    bool bRet = false;
+    if (uSize >= 4 && memcmp(pData, "BMF", 3) == 0)
+    {
+        bRet = parseBinaryConfigData((const unsigned char*)pData, uSize, nMaxTextureSize, pageFile);
+    }
+    else
+    {
+        bRet = parseTextConfigData(pData, uSize, nMaxTextureSize, pageFile);
+    }
+
+    if (bRet)
     {
-        current = m_pKerningDictionary; 
-        HASH_DEL(m_pKerningDictionary,current);
-        free(current);
+        sortTables();
     }
+    return bRet;
 }
 
-void CCBMFontConfiguration::purgeFontDefDictionary()
-{    
-    tCCFontDefHashElement *current, *tmp;
+// sorts the tables for the binary searches, keeping the last definition of a character or a pair like the hash tables did
+void CCBMFontConfiguration::sortTables()
+{
+    std::stable_sort(m_tFontDefs.begin(), m_tFontDefs.end(), compareFontDefs);
+    unsigned int uCount = 0;
+    for (unsigned int i = 0; i < m_tFontDefs.size(); ++i)
+    {
+        if (uCount > 0 && m_tFontDefs[uCount - 1].charID == m_tFontDefs[i].charID)
+        {
+            --uCount;
+        }
+        m_tFontDefs[uCount++] = m_tFontDefs[i];
+    }
+    m_tFontDefs.resize(uCount);
 
-    HASH_ITER(hh, m_pFontDefDictionary, current, tmp) {
-        HASH_DEL(m_pFontDefDictionary, current);
-        free(current);
+    std::stable_sort(m_tKernings.begin(), m_tKernings.end(), compareKernings);
+    uCount = 0;
+    for (unsigned int i = 0; i < m_tKernings.size(); ++i)
+    {
+        if (uCount > 0 && m_tKernings[uCount - 1].key == m_tKernings[i].key)
+        {
+            --uCount;
+        }
+        m_tKernings[uCount++] = m_tKernings[i];
     }
+    m_tKernings.resize(uCount);
 }
 
-std::set<unsigned int>* CCBMFontConfiguration::parseConfigFile(const char *controlFile)
-{    
-    std::string fullpath = CCFileUtils::sharedFileUtils()->fullPathForFilename(controlFile);
-    CCString *contents = CCString::createWithContentsOfFile(fullpath.c_str());
+//
+// Text format: lines of a tag followed by key=value pairs, values being numbers, lists of numbers or quoted strings.
+// Example: char id=32   x=0     y=0     width=0     height=0     xoffset=0     yoffset=44    xadvance=14     page=0  chnl=0
+//
 
-    CCAssert(contents, "CCBMFontConfiguration::parseConfigFile | Open file error.");
-    
-    set<unsigned int> *validCharsString = new set<unsigned int>();
+static inline bool isFNTSpace(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+static inline bool isFNTToken(const char *p, const char *end, const char *pszToken, unsigned int uLength)
+{
+    return (unsigned int)(end - p) == uLength && memcmp(p, pszToken, uLength) == 0;
+}
 
-    if (!contents)
+// parses a number like strtod, without needing a terminated string
+static const char* parseFNTNumber(const char *p, const char *end, float *pValue)
+{
+    bool bNegative = false;
+    if (p < end && (*p == '-' || *p == '+'))
     {
-        CCLOG("cocos2d: Error parsing FNTfile %s", controlFile);
-        return NULL;
+        bNegative = (*p == '-');
+        ++p;
     }
 
-    // parse spacing / padding
-    std::string line;
-    std::string strLeft = contents->getCString();
-    while (strLeft.length() > 0)
+    float fValue = 0;
+    while (p < end && *p >= '0' && *p <= '9')
     {
-        int pos = strLeft.find('\n');
-
-        if (pos != (int)std::string::npos)
+        fValue = fValue * 10 + (*p - '0');
+        ++p;
+    }
+    if (p < end && *p == '.')
+    {
+        float fScale = 0.1f;
+        for (++p; p < end && *p >= '0' && *p <= '9'; ++p)
         {
-            // the data is more than a line.get one line
-            line = strLeft.substr(0, pos);
-            strLeft = strLeft.substr(pos + 1);
+            fValue += (*p - '0') * fScale;
+            fScale *= 0.1f;
         }
-        else
+    }
+
+    *pValue = bNegative ? -fValue : fValue;
+    return p;
+}
+
+static int parseFNTInt(const char *p, const char *end)
+{
+    float fValue = 0;
+    parseFNTNumber(p, end, &fValue);
+    return (int)fValue;
+}
+
+bool CCBMFontConfiguration::parseTextConfigData(const char *pData, unsigned long uSize, int nMaxTextureSize, std::string& pageFile)
+{
+    const char *p = pData;
+    const char *pEnd = pData + uSize;
+
+    while (p < pEnd)
+    {
+        const char *pLineEnd = (const char*)memchr(p, '\n', pEnd - p);
+        if (! pLineEnd)
         {
-            // get the left data
-            line = strLeft;
-            strLeft.erase();
+            pLineEnd = pEnd;
         }
 
-        if(line.substr(0,strlen("info face")) == "info face") 
+        // tag
+        while (p < pLineEnd && isFNTSpace(*p)) ++p;
+        const char *pTag = p;
+        while (p < pLineEnd && ! isFNTSpace(*p)) ++p;
+        const char *pTagEnd = p;
+
+        enum { kTagOther, kTagInfo, kTagCommon, kTagPage, kTagChar, kTagKerning } tag = kTagOther;
+        if (isFNTToken(pTag, pTagEnd, "char", 4)) tag = kTagChar;
+        else if (isFNTToken(pTag, pTagEnd, "kerning", 7)) tag = kTagKerning;
+        else if (isFNTToken(pTag, pTagEnd, "info", 4)) tag = kTagInfo;
+        else if (isFNTToken(pTag, pTagEnd, "common", 6)) tag = kTagCommon;
+        else if (isFNTToken(pTag, pTagEnd, "page", 4)) tag = kTagPage;
+
+        ccBMFontDef fontDef = ccBMFontDef();
+        int first = 0, second = 0, amount = 0;
+
+        // key=value pairs
+        while (tag != kTagOther && p < pLineEnd)
         {
-            // XXX: info parsing is incomplete
-            // Not needed for the Hiero editors, but needed for the AngelCode editor
-            //            [self parseInfoArguments:line];
-            this->parseInfoArguments(line);
+            while (p < pLineEnd && isFNTSpace(*p)) ++p;
+            const char *pKey = p;
+            while (p < pLineEnd && *p != '=' && ! isFNTSpace(*p)) ++p;
+            const char *pKeyEnd = p;
+            if (p >= pLineEnd || *p != '=')
+            {
+                continue;
+            }
+
+            const char *pValue = ++p;
+            const char *pValueEnd = NULL;
+            if (p < pLineEnd && *p == '"')
+            {
+                pValue = ++p;
+                while (p < pLineEnd && *p != '"') ++p;
+                pValueEnd = p;
+                if (p < pLineEnd) ++p;
+            }
+            else
+            {
+                while (p < pLineEnd && ! isFNTSpace(*p)) ++p;
+                pValueEnd = p;
+            }
+
+            switch (tag)
+            {
+            case kTagChar:
+                if (isFNTToken(pKey, pKeyEnd, "id", 2)) fontDef.charID = (unsigned int)parseFNTInt(pValue, pValueEnd);
+                else if (isFNTToken(pKey, pKeyEnd, "x", 1)) parseFNTNumber(pValue, pValueEnd, &fontDef.rect.origin.x);
+                else if (isFNTToken(pKey, pKeyEnd, "y", 1)) parseFNTNumber(pValue, pValueEnd, &fontDef.rect.origin.y);
+                else if (isFNTToken(pKey, pKeyEnd, "width", 5)) parseFNTNumber(pValue, pValueEnd, &fontDef.rect.size.width);
+                else if (isFNTToken(pKey, pKeyEnd, "height", 6)) parseFNTNumber(pValue, pValueEnd, &fontDef.rect.size.height);
+                else if (isFNTToken(pKey, pKeyEnd, "xoffset", 7)) fontDef.xOffset = (short)parseFNTInt(pValue, pValueEnd);
+                else if (isFNTToken(pKey, pKeyEnd, "yoffset", 7)) fontDef.yOffset = (short)parseFNTInt(pValue, pValueEnd);
+                else if (isFNTToken(pKey, pKeyEnd, "xadvance", 8)) fontDef.xAdvance = (short)parseFNTInt(pValue, pValueEnd);
+                break;
+            case kTagKerning:
+                if (isFNTToken(pKey, pKeyEnd, "first", 5)) first = parseFNTInt(pValue, pValueEnd);
+                else if (isFNTToken(pKey, pKeyEnd, "second", 6)) second = parseFNTInt(pValue, pValueEnd);
+                else if (isFNTToken(pKey, pKeyEnd, "amount", 6)) amount = parseFNTInt(pValue, pValueEnd);
+                break;
+            case kTagInfo:
+                if (isFNTToken(pKey, pKeyEnd, "padding", 7))
+                {
+                    // padding=top,right,bottom,left
+                    float padding[4] = {0, 0, 0, 0};
+                    const char *q = pValue;
+                    for (int i = 0; i < 4 && q < pValueEnd; ++i)
+                    {
+                        q = parseFNTNumber(q, pValueEnd, &padding[i]);
+                        if (q < pValueEnd && *q == ',') ++q;
+                    }
+                    m_tPadding.top = (int)padding[0];
+                    m_tPadding.right = (int)padding[1];
+                    m_tPadding.bottom = (int)padding[2];
+                    m_tPadding.left = (int)padding[3];
+                    CCLOG("cocos2d: padding: %d,%d,%d,%d", m_tPadding.left, m_tPadding.top, m_tPadding.right, m_tPadding.bottom);
+                }
+                break;
+            case kTagCommon:
+                if (isFNTToken(pKey, pKeyEnd, "lineHeight", 10)) m_nCommonHeight = parseFNTInt(pValue, pValueEnd);
+                else if (isFNTToken(pKey, pKeyEnd, "scaleW", 6) || isFNTToken(pKey, pKeyEnd, "scaleH", 6))
+                {
+                    if (parseFNTInt(pValue, pValueEnd) > nMaxTextureSize)
+                    {
+                        CCLOG("cocos2d: CCLabelBMFont: page can't be larger than supported");
+                    }
+                }
+                else if (isFNTToken(pKey, pKeyEnd, "pages", 5))
+                {
+                    if (parseFNTInt(pValue, pValueEnd) != 1)
+                    {
+                        CCLOG("cocos2d: CCBitfontAtlas: only supports 1 page");
+                    }
+                }
+                break;
+            case kTagPage:
+                if (isFNTToken(pKey, pKeyEnd, "id", 2))
+                {
+                    if (parseFNTInt(pValue, pValueEnd) != 0)
+                    {
+                        CCLOG("cocos2d: CCBitfontAtlas: only supports page 0");
+                    }
+                }
+                else if (isFNTToken(pKey, pKeyEnd, "file", 4))
+                {
+                    pageFile.assign(pValue, pValueEnd - pValue);
+                }
+                break;
+            default:
+                break;
+            }
         }
-        // Check to see if the start of the line is something we are interested in
-        else if(line.substr(0,strlen("common lineHeight")) == "common lineHeight")
+
+        if (tag == kTagChar)
         {
-            this->parseCommonArguments(line);
+            m_tFontDefs.push_back(fontDef);
         }
-        else if(line.substr(0,strlen("page id")) == "page id")
+        else if (tag == kTagKerning)
         {
-            this->parseImageFileName(line, controlFile);
+            ccBMFontKerning kerning;
+            kerning.key = (first<<16) | (second&0xffff);
+            kerning.amount = amount;
+            m_tKernings.push_back(kerning);
         }
-        else if(line.substr(0,strlen("chars c")) == "chars c")
+
+        p = pLineEnd + 1;
+    }
+
+    return true;
+}
+
+//
+// Binary format, version 3: "BMF", the version, then blocks made of a type byte, a 32-bit size and the data.
+// All values are little endian.
+//
+
+static inline unsigned int readFNTUInt16(const unsigned char *p)
+{
+    return p[0] | (p[1] << 8);
+}
+
+static inline short readFNTInt16(const unsigned char *p)
+{
+    return (short)readFNTUInt16(p);
+}
+
+static inline unsigned int readFNTUInt32(const unsigned char *p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((unsigned int)p[3] << 24);
+}
+
+enum {
+    kFNTBlockInfo = 1,
+    kFNTBlockCommon = 2,
+    kFNTBlockPages = 3,
+    kFNTBlockChars = 4,
+    kFNTBlockKerningPairs = 5,
+};
+
+bool CCBMFontConfiguration::parseBinaryConfigData(const unsigned char *pData, unsigned long uSize, int nMaxTextureSize, std::string& pageFile)
+{
+    if (pData[3] != 3)
+    {
+        CCLOG("cocos2d: only version 3 of the binary FNT format is supported, not %d", pData[3]);
+        return false;
+    }
+
+    unsigned long uOffset = 4;
+    while (uOffset + 5 <= uSize)
+    {
+        unsigned char blockType = pData[uOffset];
+        unsigned long uBlockSize = readFNTUInt32(pData + uOffset + 1);
+        const unsigned char *pBlock = pData + uOffset + 5;
+        uOffset += 5;
+        if (uBlockSize > uSize - uOffset)
         {
-            // Ignore this line
+            CCLOG("cocos2d: truncated binary FNT block %d", blockType);
+            return false;
         }
-        else if(line.substr(0,strlen("char")) == "char")
-        {
-            // Parse the current line and create a new CharDef
-            tCCFontDefHashElement* element = (tCCFontDefHashElement*)malloc( sizeof(*element) );
-            this->parseCharacterDefinition(line, &element->fontDef);
+        uOffset += uBlockSize;
 
-            element->key = element->fontDef.charID;
-            HASH_ADD_INT(m_pFontDefDictionary, key, element);
-            
-            validCharsString->insert(element->fontDef.charID);
-        }
-//        else if(line.substr(0,strlen("kernings count")) == "kernings count")
-//        {
-//            this->parseKerningCapacity(line);
-//        }
-        else if(line.substr(0,strlen("kerning first")) == "kerning first")
+        switch (blockType)
         {
-            this->parseKerningEntry(line);
+        case kFNTBlockInfo:
+            // fontSize, bitField, charSet, stretchH, aa, paddingUp, paddingRight, paddingDown, paddingLeft, ...
+            if (uBlockSize >= 11)
+            {
+                m_tPadding.top = pBlock[7];
+                m_tPadding.right = pBlock[8];
+                m_tPadding.bottom = pBlock[9];
+                m_tPadding.left = pBlock[10];
+            }
+            break;
+        case kFNTBlockCommon:
+            // lineHeight, base, scaleW, scaleH, pages, ...
+            if (uBlockSize >= 10)
+            {
+                m_nCommonHeight = readFNTUInt16(pBlock);
+                if ((int)readFNTUInt16(pBlock + 4) > nMaxTextureSize || (int)readFNTUInt16(pBlock + 6) > nMaxTextureSize)
+                {
+                    CCLOG("cocos2d: CCLabelBMFont: page can't be larger than supported");
+                }
+                if (readFNTUInt16(pBlock + 8) != 1)
+                {
+                    CCLOG("cocos2d: CCBitfontAtlas: only supports 1 page");
+                }
+            }
+            break;
+        case kFNTBlockPages:
+            // zero terminated file names, the first one is page 0
+            pageFile.assign((const char*)pBlock, strnlen((const char*)pBlock, uBlockSize));
+            break;
+        case kFNTBlockChars:
+            {
+                // id, x, y, width, height, xoffset, yoffset, xadvance, page, chnl
+                unsigned int uCount = uBlockSize / 20;
+                m_tFontDefs.resize(uCount);
+                for (unsigned int i = 0; i < uCount; ++i)
+                {
+                    const unsigned char *pChar = pBlock + i * 20;
+                    ccBMFontDef& fontDef = m_tFontDefs[i];
+                    fontDef.charID = readFNTUInt32(pChar);
+                    fontDef.rect.origin.x = readFNTUInt16(pChar + 4);
+                    fontDef.rect.origin.y = readFNTUInt16(pChar + 6);
+                    fontDef.rect.size.width = readFNTUInt16(pChar + 8);
+                    fontDef.rect.size.height = readFNTUInt16(pChar + 10);
+                    fontDef.xOffset = readFNTInt16(pChar + 12);
+                    fontDef.yOffset = readFNTInt16(pChar + 14);
+                    fontDef.xAdvance = readFNTInt16(pChar + 16);
+                }
+            }
+            break;
+        case kFNTBlockKerningPairs:
+            {
+                // first, second, amount
+                unsigned int uCount = uBlockSize / 10;
+                m_tKernings.resize(uCount);
+                for (unsigned int i = 0; i < uCount; ++i)
+                {
+                    const unsigned char *pPair = pBlock + i * 10;
+                    m_tKernings[i].key = (readFNTUInt32(pPair)<<16) | (readFNTUInt32(pPair + 4)&0xffff);
+                    m_tKernings[i].amount = readFNTInt16(pPair + 8);
+                }
+            }
+            break;
+        default:
+            break;
         }
     }
-    
-    return validCharsString;
-}
-
-void CCBMFontConfiguration::parseImageFileName(std::string line, const char *fntFile)
-{
-    //////////////////////////////////////////////////////////////////////////
-    // line to parse:
-    // page id=0 file="bitmapFontTest.png"
-    //////////////////////////////////////////////////////////////////////////
-
-    // page ID. Sanity check
-    int index = line.find('=')+1;
-    int index2 = line.find(' ', index);
-    std::string value = line.substr(index, index2-index);
-    CCAssert(atoi(value.c_str()) == 0, "LabelBMFont file could not be found");
-    // file 
-    index = line.find('"')+1;
-    index2 = line.find('"', index);
-    value = line.substr(index, index2-index);
-
-    m_sAtlasName = CCFileUtils::sharedFileUtils()->fullPathFromRelativeFile(value.c_str(), fntFile);
-}
-
-void CCBMFontConfiguration::parseInfoArguments(std::string line)
-{
-    //////////////////////////////////////////////////////////////////////////
-    // possible lines to parse:
-    // info face="Script" size=32 bold=0 italic=0 charset="" unicode=1 stretchH=100 smooth=1 aa=1 padding=1,4,3,2 spacing=0,0 outline=0
-    // info face="Cracked" size=36 bold=0 italic=0 charset="" unicode=0 stretchH=100 smooth=1 aa=1 padding=0,0,0,0 spacing=1,1
-    //////////////////////////////////////////////////////////////////////////
-
-    // padding
-    int index = line.find("padding=");
-    int index2 = line.find(' ', index);
-    std::string value = line.substr(index, index2-index);
-    sscanf(value.c_str(), "padding=%d,%d,%d,%d", &m_tPadding.top, &m_tPadding.right, &m_tPadding.bottom, &m_tPadding.left);
-    CCLOG("cocos2d: padding: %d,%d,%d,%d", m_tPadding.left, m_tPadding.top, m_tPadding.right, m_tPadding.bottom);
-}
-
-void CCBMFontConfiguration::parseCommonArguments(std::string line)
-{
-    //////////////////////////////////////////////////////////////////////////
-    // line to parse:
-    // common lineHeight=104 base=26 scaleW=1024 scaleH=512 pages=1 packed=0
-    //////////////////////////////////////////////////////////////////////////
-
-    // Height
-    int index = line.find("lineHeight=");
-    int index2 = line.find(' ', index);
-    std::string value = line.substr(index, index2-index);
-    sscanf(value.c_str(), "lineHeight=%d", &m_nCommonHeight);
-    // scaleW. sanity check
-    index = line.find("scaleW=") + strlen("scaleW=");
-    index2 = line.find(' ', index);
-    value = line.substr(index, index2-index);
-    CCAssert(atoi(value.c_str()) <= CCConfiguration::sharedConfiguration()->getMaxTextureSize(), "CCLabelBMFont: page can't be larger than supported");
-    // scaleH. sanity check
-    index = line.find("scaleH=") + strlen("scaleH=");
-    index2 = line.find(' ', index);
-    value = line.substr(index, index2-index);
-    CCAssert(atoi(value.c_str()) <= CCConfiguration::sharedConfiguration()->getMaxTextureSize(), "CCLabelBMFont: page can't be larger than supported");
-    // pages. sanity check
-    index = line.find("pages=") + strlen("pages=");
-    index2 = line.find(' ', index);
-    value = line.substr(index, index2-index);
-    CCAssert(atoi(value.c_str()) == 1, "CCBitfontAtlas: only supports 1 page");
-
-    // packed (ignore) What does this mean ??
-}
-
-void CCBMFontConfiguration::parseCharacterDefinition(std::string line, ccBMFontDef *characterDefinition)
-{    
-    //////////////////////////////////////////////////////////////////////////
-    // line to parse:
-    // char id=32   x=0     y=0     width=0     height=0     xoffset=0     yoffset=44    xadvance=14     page=0  chnl=0 
-    //////////////////////////////////////////////////////////////////////////
-
-    // Character ID
-    int index = line.find("id=");
-    int index2 = line.find(' ', index);
-    std::string value = line.substr(index, index2-index);
-    sscanf(value.c_str(), "id=%u", &characterDefinition->charID);
-
-    // Character x
-    index = line.find("x=");
-    index2 = line.find(' ', index);
-    value = line.substr(index, index2-index);
-    sscanf(value.c_str(), "x=%f", &characterDefinition->rect.origin.x);
-    // Character y
-    index = line.find("y=");
-    index2 = line.find(' ', index);
-    value = line.substr(index, index2-index);
-    sscanf(value.c_str(), "y=%f", &characterDefinition->rect.origin.y);
-    // Character width
-    index = line.find("width=");
-    index2 = line.find(' ', index);
-    value = line.substr(index, index2-index);
-    sscanf(value.c_str(), "width=%f", &characterDefinition->rect.size.width);
-    // Character height
-    index = line.find("height=");
-    index2 = line.find(' ', index);
-    value = line.substr(index, index2-index);
-    sscanf(value.c_str(), "height=%f", &characterDefinition->rect.size.height);
-    // Character xoffset
-    index = line.find("xoffset=");
-    index2 = line.find(' ', index);
-    value = line.substr(index, index2-index);
-    sscanf(value.c_str(), "xoffset=%hd", &characterDefinition->xOffset);
-    // Character yoffset
-    index = line.find("yoffset=");
-    index2 = line.find(' ', index);
-    value = line.substr(index, index2-index);
-    sscanf(value.c_str(), "yoffset=%hd", &characterDefinition->yOffset);
-    // Character xadvance
-    index = line.find("xadvance=");
-    index2 = line.find(' ', index);
-    value = line.substr(index, index2-index);
-    sscanf(value.c_str(), "xadvance=%hd", &characterDefinition->xAdvance);
-}
-
-void CCBMFontConfiguration::parseKerningEntry(std::string line)
-{        
-    //////////////////////////////////////////////////////////////////////////
-    // line to parse:
-    // kerning first=121  second=44  amount=-7
-    //////////////////////////////////////////////////////////////////////////
-
-    // first
-    int first;
-    int index = line.find("first=");
-    int index2 = line.find(' ', index);
-    std::string value = line.substr(index, index2-index);
-    sscanf(value.c_str(), "first=%d", &first);
-
-    // second
-    int second;
-    index = line.find("second=");
-    index2 = line.find(' ', index);
-    value = line.substr(index, index2-index);
-    sscanf(value.c_str(), "second=%d", &second);
-
-    // amount
-    int amount;
-    index = line.find("amount=");
-    index2 = line.find(' ', index);
-    value = line.substr(index, index2-index);
-    sscanf(value.c_str(), "amount=%d", &amount);
-
-    tCCKerningHashElement *element = (tCCKerningHashElement *)calloc( sizeof( *element ), 1 );
-    element->amount = amount;
-    element->key = (first<<16) | (second&0xffff);
-    HASH_ADD_INT(m_pKerningDictionary,key, element);
+
+    return true;
 }
+
 //
 //CCLabelBMFont
 //
@@ -546,6 +922,7 @@ CCLabelBMFont::CCLabelBMFont()
 , m_bCascadeColorEnabled(true)
 , m_bCascadeOpacityEnabled(true)
 , m_bIsOpacityModifyRGB(false)
+, m_bQuadOnly(false)
 {
 
 }
@@ -561,19 +938,16 @@ CCLabelBMFont::~CCLabelBMFont()
 // LabelBMFont - Atlas generation
 int CCLabelBMFont::kerningAmountForFirst(unsigned short first, unsigned short second)
 {
-    int ret = 0;
-    unsigned int key = (first<<16) | (second & 0xffff);
-
-    if( m_pConfiguration->m_pKerningDictionary ) {
-        tCCKerningHashElement *element = NULL;
-        HASH_FIND_INT(m_pConfiguration->m_pKerningDictionary, &key, element);        
-        if(element)
-            ret = element->amount;
-    }
-    return ret;
+    return m_pConfiguration->kerningAmountForFirst(first, second);
 }
 
 void CCLabelBMFont::createFontChars()
+{
+    layoutFontChars();
+    updateFontChars();
+}
+
+void CCLabelBMFont::layoutFontChars()
 {
     int nextFontPositionX = 0;
     int nextFontPositionY = 0;
@@ -587,13 +961,12 @@ void CCLabelBMFont::createFontChars()
 
     unsigned int quantityOfLines = 1;
     unsigned int stringLen = m_sString ? cc_wcslen(m_sString) : 0;
+    m_tFontChars.resize(stringLen);
     if (stringLen == 0)
     {
         return;
     }
 
-    set<unsigned int> *charSet = m_pConfiguration->getCharacterSet();
-
     for (unsigned int i = 0; i < stringLen - 1; ++i)
     {
         unsigned short c = m_sString[i];
@@ -612,6 +985,10 @@ void CCLabelBMFont::createFontChars()
     for (unsigned int i= 0; i < stringLen; i++)
     {
         unsigned short c = m_sString[i];
+        FontChar& fontChar = m_tFontChars[i];
+        fontChar.visible = false;
+        fontChar.rect = CCRectZero;
+        fontChar.position = CCPointZero;
 
         if (c == '\n')
         {
@@ -620,7 +997,8 @@ void CCLabelBMFont::createFontChars()
             continue;
         }
         
-        if (charSet->find(c) == charSet->end())
+        const ccBMFontDef *pFontDef = m_pConfiguration->fontDefForCharacter(c);
+        if (! pFontDef)
         {
             CCLOGWARN("cocos2d::CCLabelBMFont: Attempted to use character not defined in this bitmap: %d", c);
             continue;      
@@ -628,18 +1006,7 @@ void CCLabelBMFont::createFontChars()
 
         kerningAmount = this->kerningAmountForFirst(prev, c);
         
-        tCCFontDefHashElement *element = NULL;
-
-        // unichar is a short, and an int is needed on HASH_FIND_INT
-        unsigned int key = c;
-        HASH_FIND_INT(m_pConfiguration->m_pFontDefDictionary, &key, element);
-        if (! element)
-        {
-            CCLOGWARN("cocos2d::CCLabelBMFont: characer not found %d", c);
-            continue;
-        }
-
-        fontDef = element->fontDef;
+        fontDef = *pFontDef;
 
         rect = fontDef.rect;
         rect = CC_RECT_PIXELS_TO_POINTS(rect);
@@ -647,52 +1014,14 @@ void CCLabelBMFont::createFontChars()
         rect.origin.x += m_tImageOffset.x;
         rect.origin.y += m_tImageOffset.y;
 
-        CCSprite *fontChar;
-
-        bool hasSprite = true;
-        fontChar = (CCSprite*)(this->getChildByTag(i));
-        if(fontChar )
-        {
-            // Reusing previous Sprite
-			fontChar->setVisible(true);
-        }
-        else
-        {
-            // New Sprite ? Set correct color, opacity, etc...
-            if( 0 )
-            {
-				/* WIP: Doesn't support many features yet.
-				 But this code is super fast. It doesn't create any sprite.
-				 Ideal for big labels.
-				 */
-				fontChar = m_pReusedChar;
-				fontChar->setBatchNode(NULL);
-				hasSprite = false;
-			}
-            else
-            {
-                fontChar = new CCSprite();
-                fontChar->initWithTexture(m_pobTextureAtlas->getTexture(), rect);
-                addChild(fontChar, i, i);
-                fontChar->release();
-			}
-            
-            // Apply label properties
-			fontChar->setOpacityModifyRGB(m_bIsOpacityModifyRGB);
-            
-			// Color MUST be set before opacity, since opacity might change color if OpacityModifyRGB is on
-			fontChar->updateDisplayedColor(m_tDisplayedColor);
-			fontChar->updateDisplayedOpacity(m_cDisplayedOpacity);
-        }
-
-        // updating previous sprite
-        fontChar->setTextureRect(rect, false, rect.size);
-
         // See issue 1343. cast( signed short + unsigned integer ) == unsigned integer (sign is lost!)
         int yOffset = m_pConfiguration->m_nCommonHeight - fontDef.yOffset;
         CCPoint fontPos = ccp( (float)nextFontPositionX + fontDef.xOffset + fontDef.rect.size.width*0.5f + kerningAmount,
             (float)nextFontPositionY + yOffset - rect.size.height*0.5f * CC_CONTENT_SCALE_FACTOR() );
-        fontChar->setPosition(CC_POINT_PIXELS_TO_POINTS(fontPos));
+
+        fontChar.visible = true;
+        fontChar.rect = rect;
+        fontChar.position = CC_POINT_PIXELS_TO_POINTS(fontPos);
 
         // update kerning
         nextFontPositionX += fontDef.xAdvance + kerningAmount;
@@ -702,11 +1031,6 @@ void CCLabelBMFont::createFontChars()
         {
             longestLine = nextFontPositionX;
         }
-        
-        if (! hasSprite)
-        {
-            updateQuadFromSprite(fontChar, i);
-        }
     }
 
     // If the last character processed has an xAdvance which is less that the width of the characters image, then we need
@@ -725,6 +1049,158 @@ void CCLabelBMFont::createFontChars()
     this->setContentSize(CC_SIZE_PIXELS_TO_POINTS(tmpSize));
 }
 
+void CCLabelBMFont::updateFontChars()
+{
+    unsigned int uCount = m_tFontChars.size();
+
+    if (m_bQuadOnly)
+    {
+        // only rewrite the quads showing another glyph or position than before
+        unsigned int uQuad = 0;
+        bool bChanged = false;
+        for (unsigned int i = 0; i < uCount; i++)
+        {
+            const FontChar& fontChar = m_tFontChars[i];
+            if (! fontChar.visible)
+            {
+                continue;
+            }
+
+            if (uQuad >= m_tQuadChars.size())
+            {
+                m_tQuadChars.push_back(fontChar);
+            }
+            else if (m_tQuadChars[uQuad].rect.equals(fontChar.rect) && m_tQuadChars[uQuad].position.equals(fontChar.position))
+            {
+                uQuad++;
+                continue;
+            }
+            else
+            {
+                m_tQuadChars[uQuad] = fontChar;
+            }
+
+            m_pReusedChar->setTextureRect(fontChar.rect, false, fontChar.rect.size);
+            m_pReusedChar->setPosition(fontChar.position);
+            updateQuadFromSprite(m_pReusedChar, uQuad);
+            uQuad++;
+            bChanged = true;
+        }
+
+        m_tQuadChars.resize(uQuad);
+        unsigned int uTotalQuads = m_pobTextureAtlas->getTotalQuads();
+        if (uTotalQuads > uQuad)
+        {
+            m_pobTextureAtlas->removeQuadsAtIndex(uQuad, uTotalQuads - uQuad);
+            bChanged = true;
+        }
+
+        // the quads are written through m_pReusedChar, which has no parent to tell
+        if (bChanged)
+        {
+            setBitmapCacheDirty();
+        }
+        return;
+    }
+
+    // the sprite of each character is the child tagged with its index
+    vector<CCSprite*> sprites(uCount, (CCSprite*)NULL);
+    CCObject* pObj = NULL;
+    CCARRAY_FOREACH(m_pChildren, pObj)
+    {
+        CCSprite *pChild = (CCSprite*)pObj;
+        int nTag = pChild->getTag();
+        if (nTag >= 0 && nTag < (int)uCount && m_tFontChars[nTag].visible && ! sprites[nTag])
+        {
+            sprites[nTag] = pChild;
+        }
+        else if (pChild->isVisible())
+        {
+            pChild->setVisible(false);
+        }
+    }
+
+    for (unsigned int i = 0; i < uCount; i++)
+    {
+        const FontChar& fontChar = m_tFontChars[i];
+        if (! fontChar.visible)
+        {
+            continue;
+        }
+
+        CCSprite *pSprite = sprites[i];
+        if (pSprite)
+        {
+            // Reusing previous Sprite
+            if (! pSprite->isVisible())
+            {
+                pSprite->setVisible(true);
+            }
+        }
+        else
+        {
+            // New Sprite ? Set correct color, opacity, etc...
+            pSprite = new CCSprite();
+            pSprite->initWithTexture(m_pobTextureAtlas->getTexture(), fontChar.rect);
+            addChild(pSprite, i, i);
+            pSprite->release();
+
+            // Apply label properties
+            pSprite->setOpacityModifyRGB(m_bIsOpacityModifyRGB);
+
+            // Color MUST be set before opacity, since opacity might change color if OpacityModifyRGB is on
+            pSprite->updateDisplayedColor(m_tDisplayedColor);
+            pSprite->updateDisplayedOpacity(m_cDisplayedOpacity);
+        }
+
+        // updating previous sprite, which only has to be transformed again if it changed
+        if (! pSprite->getTextureRect().equals(fontChar.rect) || pSprite->isTextureRectRotated())
+        {
+            pSprite->setTextureRect(fontChar.rect, false, fontChar.rect.size);
+        }
+        if (! pSprite->getPosition().equals(fontChar.position))
+        {
+            pSprite->setPosition(fontChar.position);
+        }
+    }
+}
+
+void CCLabelBMFont::updateReusedCharColor()
+{
+    // the color is written in the quads by updateFontChars, the atlas index is reset so that it is not written now
+    m_pReusedChar->setAtlasIndex(CCSpriteIndexNotInitialized);
+    m_pReusedChar->setOpacityModifyRGB(m_bIsOpacityModifyRGB);
+    m_pReusedChar->updateDisplayedColor(m_tDisplayedColor);
+    m_pReusedChar->updateDisplayedOpacity(m_cDisplayedOpacity);
+    m_tQuadChars.clear();
+}
+
+void CCLabelBMFont::setQuadOnly(bool bQuadOnly)
+{
+    if (m_bQuadOnly == bQuadOnly)
+    {
+        return;
+    }
+
+    m_bQuadOnly = bQuadOnly;
+    if (m_bQuadOnly)
+    {
+        removeAllChildrenWithCleanup(true);
+        updateReusedCharColor();
+    }
+    else
+    {
+        m_pobTextureAtlas->removeAllQuads();
+        m_tQuadChars.clear();
+    }
+    updateFontChars();
+}
+
+bool CCLabelBMFont::isQuadOnly()
+{
+    return m_bQuadOnly;
+}
+
 //LabelBMFont - CCLabelProtocol protocol
 void CCLabelBMFont::setString(const char *newString)
 {
@@ -751,33 +1227,25 @@ void CCLabelBMFont::setString(unsigned short *newString, bool needUpdateLabel)
         unsigned short* tmp = m_sString;
         m_sString = copyUTF16StringN(newString);
         CC_SAFE_DELETE_ARRAY(tmp);
+        this->createFontChars();
     }
     else
     {
         unsigned short* tmp = m_sInitialString;
         m_sInitialString = copyUTF16StringN(newString);
         CC_SAFE_DELETE_ARRAY(tmp);
-    }
-    
-    if (m_pChildren && m_pChildren->count() != 0)
-    {
-        CCObject* child;
-        CCARRAY_FOREACH(m_pChildren, child)
-        {
-            CCNode* pNode = (CCNode*) child;
-            if (pNode)
-            {
-                pNode->setVisible(false);
-            }
-        }
-    }
-    this->createFontChars();
-    
-    if (needUpdateLabel) {
         updateLabel();
     }
 }
 
+void CCLabelBMFont::setLayoutString(unsigned short *newString)
+{
+    unsigned short* tmp = m_sString;
+    m_sString = copyUTF16StringN(newString);
+    CC_SAFE_DELETE_ARRAY(tmp);
+    layoutFontChars();
+}
+
 const char* CCLabelBMFont::getString(void)
 {
     return m_sInitialStringUTF8.c_str();
@@ -843,6 +1311,11 @@ void CCLabelBMFont::setOpacity(GLubyte opacity)
 void CCLabelBMFont::setOpacityModifyRGB(bool var)
 {
     m_bIsOpacityModifyRGB = var;
+    if (m_bQuadOnly)
+    {
+        updateReusedCharColor();
+        updateFontChars();
+    }
     if (m_pChildren && m_pChildren->count() != 0)
     {
         CCObject* child;
@@ -868,6 +1341,11 @@ bool CCLabelBMFont::isOpacityModifyRGB()
 void CCLabelBMFont::updateDisplayedOpacity(GLubyte parentOpacity)
 {
 	m_cDisplayedOpacity = m_cRealOpacity * parentOpacity/255.0;
+    if (m_bQuadOnly)
+    {
+        updateReusedCharColor();
+        updateFontChars();
+    }
     
 	CCObject* pObj;
 	CCARRAY_FOREACH(m_pChildren, pObj)
@@ -882,6 +1360,11 @@ void CCLabelBMFont::updateDisplayedColor(const ccColor3B& parentColor)
 	m_tDisplayedColor.r = m_tRealColor.r * parentColor.r/255.0;
 	m_tDisplayedColor.g = m_tRealColor.g * parentColor.g/255.0;
 	m_tDisplayedColor.b = m_tRealColor.b * parentColor.b/255.0;
+    if (m_bQuadOnly)
+    {
+        updateReusedCharColor();
+        updateFontChars();
+    }
     
     CCObject* pObj;
 	CCARRAY_FOREACH(m_pChildren, pObj)
@@ -924,7 +1407,8 @@ void CCLabelBMFont::setAnchorPoint(const CCPoint& point)
 // LabelBMFont - Alignment
 void CCLabelBMFont::updateLabel()
 {
-    this->setString(m_sInitialString, false);
+    // the characters are laid out, wrapped and aligned in m_tFontChars, then updated once
+    this->setLayoutString(m_sInitialString);
 
     if (m_fWidth > 0)
     {
@@ -941,21 +1425,25 @@ void CCLabelBMFont::updateLabel()
         float startOfLine = -1, startOfWord = -1;
         int skip = 0;
 
-        CCArray* children = getChildren();
-        for (unsigned int j = 0; j < children->count(); j++)
+        unsigned int visibleCount = 0;
+        for (unsigned int j = 0; j < m_tFontChars.size(); j++)
+        {
+            if (m_tFontChars[j].visible)
+                visibleCount++;
+        }
+
+        for (unsigned int j = 0; j < visibleCount; j++)
         {
-            CCSprite* characterSprite;
             unsigned int justSkipped = 0;
             
-            while (!(characterSprite = (CCSprite*)this->getChildByTag(j + skip + justSkipped)))
+            while (!m_tFontChars[j + skip + justSkipped].visible)
             {
                 justSkipped++;
             }
             
             skip += justSkipped;
             
-            if (!characterSprite->isVisible())
-                continue;
+            const FontChar& characterSprite = m_tFontChars[j + skip];
 
             if (i >= stringLength)
                 break;
@@ -1091,7 +1579,7 @@ void CCLabelBMFont::updateLabel()
 
         str_new[size] = '\0';
 
-        this->setString(str_new, false);
+        this->setLayoutString(str_new);
         
         CC_SAFE_DELETE_ARRAY(str_new);
     }
@@ -1119,11 +1607,11 @@ void CCLabelBMFont::updateLabel()
                 int index = i + line_length - 1 + lineNumber;
                 if (index < 0) continue;
 
-                CCSprite* lastChar = (CCSprite*)getChildByTag(index);
-                if ( lastChar == NULL )
+                if (index >= (int)m_tFontChars.size() || !m_tFontChars[index].visible)
                     continue;
+                const FontChar& lastChar = m_tFontChars[index];
 
-                lineWidth = lastChar->getPosition().x + lastChar->getContentSize().width/2.0f;
+                lineWidth = lastChar.position.x + lastChar.rect.size.width/2.0f;
 
                 float shift = 0;
                 switch (m_pAlignment)
@@ -1143,10 +1631,9 @@ void CCLabelBMFont::updateLabel()
                     for (unsigned j = 0; j < line_length; j++)
                     {
                         index = i + j + lineNumber;
-                        if (index < 0) continue;
+                        if (index < 0 || index >= (int)m_tFontChars.size()) continue;
 
-                        CCSprite* characterSprite = (CCSprite*)getChildByTag(index);
-                        characterSprite->setPosition(ccpAdd(characterSprite->getPosition(), ccp(shift, 0.0f)));
+                        m_tFontChars[index].position.x += shift;
                     }
                 }
 
@@ -1160,6 +1647,8 @@ void CCLabelBMFont::updateLabel()
             last_line.push_back(m_sString[ctr]);
         }
     }
+
+    updateFontChars();
 }
 
 // LabelBMFont - Alignment
@@ -1199,14 +1688,15 @@ void CCLabelBMFont::setScaleY(float scaleY)
     updateLabel();
 }
 
-float CCLabelBMFont::getLetterPosXLeft( CCSprite* sp )
+// characters have an anchor point of (0.5, 0.5)
+float CCLabelBMFont::getLetterPosXLeft( const FontChar& fontChar )
 {
-    return sp->getPosition().x * m_fScaleX - (sp->getContentSize().width * m_fScaleX * sp->getAnchorPoint().x);
+    return fontChar.position.x * m_fScaleX - (fontChar.rect.size.width * m_fScaleX * 0.5f);
 }
 
-float CCLabelBMFont::getLetterPosXRight( CCSprite* sp )
+float CCLabelBMFont::getLetterPosXRight( const FontChar& fontChar )
 {
-    return sp->getPosition().x * m_fScaleX + (sp->getContentSize().width * m_fScaleX * sp->getAnchorPoint().x);
+    return fontChar.position.x * m_fScaleX + (fontChar.rect.size.width * m_fScaleX * 0.5f);
 }
 
 // LabelBMFont - FntFile
@@ -1225,6 +1715,7 @@ void CCLabelBMFont::setFntFile(const char* fntFile)
         m_pConfiguration = newConf;
 
         this->setTexture(CCTextureCache::sharedTextureCache()->addImage(m_pConfiguration->getAtlasName()));
+        m_tQuadChars.clear();
         this->createFontChars();
     }
 }
@@ -34,7 +34,6 @@ Use any of these editors to generate BMFonts:
 #define __CCBITMAP_FONT_ATLAS_H__
 
 #include "sprite_nodes/CCSpriteBatchNode.h"
-#include "support/data_support/uthash.h"
 #include <map>
 #include <sstream>
 #include <iostream>
@@ -53,8 +52,6 @@ enum {
     kCCLabelAutomaticWidth = -1,
 };
 
-struct _FontDefHashElement;
-
 /**
 @struct ccBMFontDef
 BMFont definition
@@ -87,30 +84,29 @@ typedef struct _BMFontPadding {
     int bottom;
 } ccBMFontPadding;
 
-typedef struct _FontDefHashElement
-{
-	unsigned int	key;		// key. Font Unicode value
-	ccBMFontDef		fontDef;	// font definition
-	UT_hash_handle	hh;
-} tCCFontDefHashElement;
-
-// Equal function for targetSet.
-typedef struct _KerningHashElement
-{
-	int				key;		// key for the hash. 16-bit for 1st element, 16-bit for 2nd element
-	int				amount;
-	UT_hash_handle	hh;
-} tCCKerningHashElement;
+/** @struct ccBMFontKerning
+BMFont kerning between two characters
+@since v2.1.4
+*/
+typedef struct _BMFontKerning {
+    //! 16-bit for the 1st character, 16-bit for the 2nd character
+    unsigned int key;
+    //! how much the x position should be adjusted when drawing the 2nd character after the 1st one
+    int amount;
+} ccBMFontKerning;
 
 /** @brief CCBMFontConfiguration has parsed configuration of the the .fnt file
+
+Both the text and the binary formats of the AngelCode BMFont tool are supported.
+The binary format (version 3) is read into the character and kerning tables without parsing.
 @since v0.8
 */
 class CC_DLL CCBMFontConfiguration : public CCObject
 {
     // XXX: Creating a public interface so that the bitmapFontArray[] is accessible
 public://@public
-    // BMFont definitions
-    tCCFontDefHashElement *m_pFontDefDictionary;
+    //! BMFont definitions, sorted by charID
+    std::vector<ccBMFontDef> m_tFontDefs;
 
     //! FNTConfig: Common Height Should be signed (issue #1343)
     int m_nCommonHeight;
@@ -118,11 +114,11 @@ public://@public
     ccBMFontPadding    m_tPadding;
     //! atlas name
     std::string m_sAtlasName;
-    //! values for kerning
-    tCCKerningHashElement *m_pKerningDictionary;
+    //! values for kerning, sorted by key
+    std::vector<ccBMFontKerning> m_tKernings;
     
-    // Character Set defines the letters that actually exist in the font
-    std::set<unsigned int> *m_pCharacterSet;
+    // Character Set defines the letters that actually exist in the font, created by getCharacterSet()
+    mutable std::set<unsigned int> *m_pCharacterSet;
 public:
     CCBMFontConfiguration();
     virtual ~CCBMFontConfiguration();
@@ -133,20 +129,36 @@ public:
 
     /** initializes a BitmapFontConfiguration with a FNT file */
     bool initWithFNTfile(const char *FNTfile);
+
+    /** initializes a BitmapFontConfiguration with the contents of a FNT file that was read already.
+     FNTfile is used to locate the atlas image.
+     @since v2.1.4
+     */
+    bool initWithFNTfile(const char *FNTfile, const char *pData, unsigned long uSize);
     
     inline const char* getAtlasName(){ return m_sAtlasName.c_str(); }
     inline void setAtlasName(const char* atlasName) { m_sAtlasName = atlasName; }
     
     std::set<unsigned int>* getCharacterSet() const;
+
+    /** Returns the definition of a character, or NULL if the font does not have it
+     @since v2.1.4
+     */
+    const ccBMFontDef* fontDefForCharacter(unsigned int uCharacter) const;
+
+    /** Returns the kerning amount between two characters
+     @since v2.1.4
+     */
+    int kerningAmountForFirst(unsigned short first, unsigned short second) const;
 private:
-    std::set<unsigned int>* parseConfigFile(const char *controlFile);
-    void parseCharacterDefinition(std::string line, ccBMFontDef *characterDefinition);
-    void parseInfoArguments(std::string line);
-    void parseCommonArguments(std::string line);
-    void parseImageFileName(std::string line, const char *fntFile);
-    void parseKerningEntry(std::string line);
-    void purgeKerningDictionary();
-    void purgeFontDefDictionary();
+    friend class CCBMFontConfigurationAsyncLoader;
+
+    bool parseConfigFile(const char *controlFile);
+    // only fills the tables and logs, so that it can run on any thread; the atlas name is set with the page file name
+    bool parseConfigData(const char *pData, unsigned long uSize, int nMaxTextureSize, std::string& pageFile);
+    bool parseTextConfigData(const char *pData, unsigned long uSize, int nMaxTextureSize, std::string& pageFile);
+    bool parseBinaryConfigData(const unsigned char *pData, unsigned long uSize, int nMaxTextureSize, std::string& pageFile);
+    void sortTables();
 };
 
 /** @brief CCLabelBMFont is a subclass of CCSpriteBatchNode.
@@ -161,6 +173,10 @@ Features:
 - It can be used as part of a menu item.
 - anchorPoint can be used to align the "label"
 - Supports AngelCode text format
+- In quad-only mode, characters are quads of the texture atlas instead of CCSprite children,
+  which is faster for labels that change often, like scores and timers
+
+Changing the string only updates the characters whose glyph or position changed.
 
 Limitations:
 - All inner characters are using an anchorPoint of (0.5f, 0.5f) and it is not recommend to change it
@@ -210,6 +226,15 @@ public:
 
     /** updates the font chars based on the string to render */
     void createFontChars();
+
+    /** In quad-only mode the characters are not CCSprite children of the label: their quads are
+     written directly in the texture atlas, and only the quads of the characters that changed are
+     rewritten when the string changes. The characters can not be moved, tinted or animated one by one.
+     @since v2.1.4
+     */
+    void setQuadOnly(bool bQuadOnly);
+    bool isQuadOnly();
+
     // super method
     virtual void setString(const char *newString);
     virtual void setString(const char *newString, bool needUpdateLabel);
@@ -248,10 +273,26 @@ public:
 private:
     char * atlasNameFromFntFile(const char *fntFile);
     int kerningAmountForFirst(unsigned short first, unsigned short second);
-    float getLetterPosXLeft( CCSprite* characterSprite );
-    float getLetterPosXRight( CCSprite* characterSprite );
     
 protected:
+    /** position and texture rect of a character, in points */
+    typedef struct _FontChar
+    {
+        bool visible;
+        CCRect rect;
+        CCPoint position;
+    } FontChar;
+
+    float getLetterPosXLeft( const FontChar& fontChar );
+    float getLetterPosXRight( const FontChar& fontChar );
+
+    /** lays m_sString out in m_tFontChars, without updating the characters */
+    void layoutFontChars();
+    /** updates the sprites or quads of the characters which differ from m_tFontChars */
+    void updateFontChars();
+    void updateReusedCharColor();
+    void setLayoutString(unsigned short *newString);
+
     virtual void setString(unsigned short *newString, bool needUpdateLabel);
     // string to render
     unsigned short* m_sString;
@@ -287,11 +328,24 @@ protected:
     /** conforms to CCRGBAProtocol protocol */
     bool        m_bIsOpacityModifyRGB;
 
+    // layout of m_sString, by character index
+    std::vector<FontChar> m_tFontChars;
+    // in quad-only mode, the character each quad of the texture atlas shows
+    std::vector<FontChar> m_tQuadChars;
+    bool m_bQuadOnly;
 };
 
 /** Free function that parses a FNT file a place it on the cache
 */
 CC_DLL CCBMFontConfiguration * FNTConfigLoadFile( const char *file );
+/** Free function that reads and parses a FNT file without blocking, places it on the cache
+ and loads its atlas with CCTextureCache::addImageAsync().
+ The selector is called on the main thread with the CCBMFontConfiguration, or with NULL if the file
+ can't be parsed. If the FNT file is cached already, the selector is called right away.
+ @return The id of the file read, it can be cancelled with CCFileUtils::cancelFileDataAsync().
+ @since v2.1.4
+ */
+CC_DLL unsigned int FNTConfigLoadFileAsync( const char *file, CCObject *target, SEL_CallFuncO selector );
 /** Purges the FNT config cache
 */
 CC_DLL void FNTConfigRemoveCache( void );
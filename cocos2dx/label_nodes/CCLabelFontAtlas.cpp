@@ -0,0 +1,586 @@
+/****************************************************************************
+Copyright (c) 2013 cocos2d-x.org
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+#include "CCLabelFontAtlas.h"
+#include "cocoa/CCArray.h"
+#include "cocoa/CCString.h"
+#include "cocoa/CCAffineTransform.h"
+#include "textures/CCTextureAtlas.h"
+#include "textures/CCTexture2D.h"
+#include "shaders/CCShaderCache.h"
+#include "shaders/CCGLProgram.h"
+#include "shaders/ccGLStateCache.h"
+#include "support/CCPointExtension.h"
+#include "effects/CCGrid.h"
+#include "kazmath/GL/matrix.h"
+#include "CCDirector.h"
+
+NS_CC_BEGIN
+
+static void setQuadColor(ccV3F_C4B_T2F_Quad& quad, const ccColor4B& color)
+{
+    quad.bl.colors = color;
+    quad.br.colors = color;
+    quad.tl.colors = color;
+    quad.tr.colors = color;
+}
+
+//
+// CCLabelFontAtlas
+//
+CCLabelFontAtlas::CCLabelFontAtlas()
+: m_hAlignment(kCCTextAlignmentCenter)
+, m_vAlignment(kCCVerticalTextAlignmentTop)
+, m_fFontSize(0.0)
+, m_string("")
+, m_pFontAtlas(NULL)
+, m_pTextureAtlases(NULL)
+{
+}
+
+CCLabelFontAtlas::~CCLabelFontAtlas()
+{
+    CC_SAFE_RELEASE(m_pFontAtlas);
+    CC_SAFE_RELEASE(m_pTextureAtlases);
+}
+
+CCLabelFontAtlas* CCLabelFontAtlas::create(const char *string, const char *fontName, float fontSize)
+{
+    return CCLabelFontAtlas::create(string, fontName, fontSize,
+                                    CCSizeZero, kCCTextAlignmentLeft, kCCVerticalTextAlignmentTop);
+}
+
+CCLabelFontAtlas* CCLabelFontAtlas::create(const char *string, const char *fontName, float fontSize,
+                                           const CCSize& dimensions, CCTextAlignment hAlignment)
+{
+    return CCLabelFontAtlas::create(string, fontName, fontSize, dimensions, hAlignment, kCCVerticalTextAlignmentTop);
+}
+
+CCLabelFontAtlas* CCLabelFontAtlas::create(const char *string, const char *fontName, float fontSize,
+                                           const CCSize& dimensions, CCTextAlignment hAlignment,
+                                           CCVerticalTextAlignment vAlignment)
+{
+    CCLabelFontAtlas *pRet = new CCLabelFontAtlas();
+    if (pRet && pRet->initWithString(string, fontName, fontSize, dimensions, hAlignment, vAlignment))
+    {
+        pRet->autorelease();
+        return pRet;
+    }
+    CC_SAFE_DELETE(pRet);
+    return NULL;
+}
+
+bool CCLabelFontAtlas::initWithString(const char *string, const char *fontName, float fontSize,
+                                      const CCSize& dimensions, CCTextAlignment hAlignment,
+                                      CCVerticalTextAlignment vAlignment)
+{
+    CCAssert(string != NULL, "Invalid string");
+
+    if (CCNodeRGBA::init())
+    {
+        this->setShaderProgram(CCShaderCache::sharedShaderCache()->programForKey(kCCShader_PositionTextureA8Color));
+        this->setAnchorPoint(ccp(0.5f, 0.5f));
+
+        m_pTextureAtlases = new CCArray();
+        m_tDimensions = dimensions;
+        m_hAlignment = hAlignment;
+        m_vAlignment = vAlignment;
+        m_sFontName = fontName;
+        m_fFontSize = fontSize;
+        m_string = string;
+
+        this->updateFontAtlas();
+        if (! m_pFontAtlas)
+        {
+            return false;
+        }
+        this->updateQuads();
+        return true;
+    }
+
+    return false;
+}
+
+const char* CCLabelFontAtlas::description()
+{
+    return CCString::createWithFormat("<CCLabelFontAtlas | FontName = %s, FontSize = %.1f>", m_sFontName.c_str(), m_fFontSize)->getCString();
+}
+
+void CCLabelFontAtlas::setString(const char *string)
+{
+    CCAssert(string != NULL, "Invalid string");
+
+    if (m_string.compare(string))
+    {
+        m_string = string;
+        this->updateQuads();
+    }
+}
+
+const char* CCLabelFontAtlas::getString(void)
+{
+    return m_string.c_str();
+}
+
+CCTextAlignment CCLabelFontAtlas::getHorizontalAlignment()
+{
+    return m_hAlignment;
+}
+
+void CCLabelFontAtlas::setHorizontalAlignment(CCTextAlignment alignment)
+{
+    if (alignment != m_hAlignment)
+    {
+        m_hAlignment = alignment;
+        this->updateQuads();
+    }
+}
+
+CCVerticalTextAlignment CCLabelFontAtlas::getVerticalAlignment()
+{
+    return m_vAlignment;
+}
+
+void CCLabelFontAtlas::setVerticalAlignment(CCVerticalTextAlignment verticalAlignment)
+{
+    if (verticalAlignment != m_vAlignment)
+    {
+        m_vAlignment = verticalAlignment;
+        this->updateQuads();
+    }
+}
+
+CCSize CCLabelFontAtlas::getDimensions()
+{
+    return m_tDimensions;
+}
+
+void CCLabelFontAtlas::setDimensions(const CCSize &dim)
+{
+    if (dim.width != m_tDimensions.width || dim.height != m_tDimensions.height)
+    {
+        m_tDimensions = dim;
+        this->updateQuads();
+    }
+}
+
+float CCLabelFontAtlas::getFontSize()
+{
+    return m_fFontSize;
+}
+
+void CCLabelFontAtlas::setFontSize(float fontSize)
+{
+    if (m_fFontSize != fontSize)
+    {
+        m_fFontSize = fontSize;
+        this->updateFontAtlas();
+        this->updateQuads();
+    }
+}
+
+const char* CCLabelFontAtlas::getFontName()
+{
+    return m_sFontName.c_str();
+}
+
+void CCLabelFontAtlas::setFontName(const char *fontName)
+{
+    if (m_sFontName.compare(fontName))
+    {
+        m_sFontName = fontName;
+        this->updateFontAtlas();
+        this->updateQuads();
+    }
+}
+
+CCFontAtlas* CCLabelFontAtlas::getFontAtlas()
+{
+    return m_pFontAtlas;
+}
+
+CCTextureAtlas* CCLabelFontAtlas::getTextureAtlasForPage(unsigned int uPage)
+{
+    if (uPage >= m_pTextureAtlases->count())
+    {
+        return NULL;
+    }
+    return (CCTextureAtlas*)m_pTextureAtlases->objectAtIndex(uPage);
+}
+
+void CCLabelFontAtlas::updateFontAtlas()
+{
+    // same size as the texture CCLabelTTF would create
+    CCFontAtlas *pFontAtlas = CCFontAtlas::fontAtlas(m_sFontName.c_str(), (int)(m_fFontSize * CC_CONTENT_SCALE_FACTOR()));
+    CC_SAFE_RETAIN(pFontAtlas);
+    CC_SAFE_RELEASE(m_pFontAtlas);
+    m_pFontAtlas = pFontAtlas;
+}
+
+void CCLabelFontAtlas::updateQuads()
+{
+    CCObject *pObj = NULL;
+    CCARRAY_FOREACH(m_pTextureAtlases, pObj)
+    {
+        ((CCTextureAtlas*)pObj)->removeAllQuads();
+    }
+
+    if (! m_pFontAtlas)
+    {
+        setContentSize(m_tDimensions);
+        return;
+    }
+
+    // lay the text out like CCImage::initWithString does, in pixels
+    CCSize dimensions = CC_SIZE_POINTS_TO_PIXELS(m_tDimensions);
+    int nMaxLineWidth = 0;
+    if (! m_pFontAtlas->layoutString(m_string.c_str(), (int)dimensions.width, m_lines, &nMaxLineWidth))
+    {
+        m_lines.clear();
+    }
+
+    int nWidth = MAX(nMaxLineWidth, (int)dimensions.width);
+    int nTextHeight = m_pFontAtlas->getFontHeight();
+    if (! m_lines.empty())
+    {
+        nTextHeight += m_pFontAtlas->getLineHeight() * (m_lines.size() - 1);
+    }
+    int nHeight = MAX(nTextHeight, (int)dimensions.height);
+
+    int nBaseline = m_pFontAtlas->getBaseline();
+    if (m_vAlignment == kCCVerticalTextAlignmentCenter)
+    {
+        nBaseline += (nHeight - nTextHeight) / 2;
+    }
+    else if (m_vAlignment == kCCVerticalTextAlignmentBottom)
+    {
+        nBaseline += nHeight - nTextHeight;
+    }
+
+    // make room for the pages rasterized by the layout
+    while (m_pTextureAtlases->count() < m_pFontAtlas->getPageCount())
+    {
+        CCTexture2D *pPage = m_pFontAtlas->getPage(m_pTextureAtlases->count());
+        m_pTextureAtlases->addObject(CCTextureAtlas::createWithTexture(pPage, 16));
+    }
+    for (unsigned int uPage = 0; uPage < m_pFontAtlas->getPageCount(); ++uPage)
+    {
+        // the font of the label may have changed
+        CCTextureAtlas *pTextureAtlas = (CCTextureAtlas*)m_pTextureAtlases->objectAtIndex(uPage);
+        if (pTextureAtlas->getTexture() != m_pFontAtlas->getPage(uPage))
+        {
+            pTextureAtlas->setTexture(m_pFontAtlas->getPage(uPage));
+        }
+    }
+
+    float fScale = CC_CONTENT_SCALE_FACTOR();
+    float fPageSize = (float)CC_FONT_ATLAS_PAGE_SIZE;
+    ccV3F_C4B_T2F_Quad quad;
+    memset(&quad, 0, sizeof(quad));
+
+    for (unsigned int uLine = 0; uLine < m_lines.size(); ++uLine)
+    {
+        const ccGlyphLine& line = m_lines[uLine];
+        int nLineStart = 0;
+        if (m_hAlignment == kCCTextAlignmentCenter)
+        {
+            nLineStart = (nWidth - line.width) / 2;
+        }
+        else if (m_hAlignment == kCCTextAlignmentRight)
+        {
+            nLineStart = nWidth - line.width;
+        }
+
+        for (unsigned int i = 0; i < line.glyphs.size(); ++i)
+        {
+            const ccGlyphDef *pGlyph = line.glyphs[i].glyph;
+            if (pGlyph->page == kCCFontAtlasNoPage)
+            {
+                continue;
+            }
+
+            // rows outside of the label are cut, like they are from the texture of a CCLabelTTF
+            int nLeft = nLineStart + line.glyphs[i].x;
+            int nTop = nBaseline - pGlyph->bearingY;
+            int nFirstRow = MAX(0, -nTop);
+            int nLastRow = MIN((int)pGlyph->rect.size.height, nHeight - nTop);
+            if (nFirstRow >= nLastRow)
+            {
+                continue;
+            }
+
+            float left = nLeft / fScale;
+            float right = (nLeft + pGlyph->rect.size.width) / fScale;
+            float top = (nHeight - nTop - nFirstRow) / fScale;
+            float bottom = (nHeight - nTop - nLastRow) / fScale;
+            quad.tl.vertices = vertex3(left, top, 0);
+            quad.tr.vertices = vertex3(right, top, 0);
+            quad.bl.vertices = vertex3(left, bottom, 0);
+            quad.br.vertices = vertex3(right, bottom, 0);
+
+            float texLeft = pGlyph->rect.origin.x / fPageSize;
+            float texRight = (pGlyph->rect.origin.x + pGlyph->rect.size.width) / fPageSize;
+            float texTop = (pGlyph->rect.origin.y + nFirstRow) / fPageSize;
+            float texBottom = (pGlyph->rect.origin.y + nLastRow) / fPageSize;
+            quad.tl.texCoords = tex2(texLeft, texTop);
+            quad.tr.texCoords = tex2(texRight, texTop);
+            quad.bl.texCoords = tex2(texLeft, texBottom);
+            quad.br.texCoords = tex2(texRight, texBottom);
+
+            CCTextureAtlas *pTextureAtlas = (CCTextureAtlas*)m_pTextureAtlases->objectAtIndex(pGlyph->page);
+            unsigned int uIndex = pTextureAtlas->getTotalQuads();
+            if (uIndex == pTextureAtlas->getCapacity())
+            {
+                pTextureAtlas->resizeCapacity(uIndex * 2);
+            }
+            pTextureAtlas->updateQuad(&quad, uIndex);
+        }
+        nBaseline += m_pFontAtlas->getLineHeight();
+    }
+
+    setContentSize(CCSizeMake(nWidth / fScale, nHeight / fScale));
+    updateColor();
+}
+
+void CCLabelFontAtlas::updateColor()
+{
+    ccColor4B color = ccc4(_displayedColor.r, _displayedColor.g, _displayedColor.b, _displayedOpacity);
+    CCObject *pObj = NULL;
+    CCARRAY_FOREACH(m_pTextureAtlases, pObj)
+    {
+        CCTextureAtlas *pTextureAtlas = (CCTextureAtlas*)pObj;
+        ccV3F_C4B_T2F_Quad *pQuads = pTextureAtlas->getQuads();
+        unsigned int uCount = pTextureAtlas->getTotalQuads();
+        for (unsigned int i = 0; i < uCount; ++i)
+        {
+            setQuadColor(pQuads[i], color);
+        }
+        pTextureAtlas->setDirty(true);
+    }
+}
+
+void CCLabelFontAtlas::setColor(const ccColor3B& color)
+{
+    CCNodeRGBA::setColor(color);
+    updateColor();
+}
+
+void CCLabelFontAtlas::updateDisplayedColor(const ccColor3B& parentColor)
+{
+    CCNodeRGBA::updateDisplayedColor(parentColor);
+    updateColor();
+}
+
+void CCLabelFontAtlas::setOpacity(GLubyte opacity)
+{
+    CCNodeRGBA::setOpacity(opacity);
+    updateColor();
+}
+
+void CCLabelFontAtlas::updateDisplayedOpacity(GLubyte parentOpacity)
+{
+    CCNodeRGBA::updateDisplayedOpacity(parentOpacity);
+    updateColor();
+}
+
+void CCLabelFontAtlas::draw(void)
+{
+    if (! m_pFontAtlas)
+    {
+        return;
+    }
+
+    // glyphs rasterized for this label or others are uploaded once per frame
+    m_pFontAtlas->updatePages();
+
+    CC_NODE_DRAW_SETUP();
+    ccGLBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+    CCObject *pObj = NULL;
+    CCARRAY_FOREACH(m_pTextureAtlases, pObj)
+    {
+        ((CCTextureAtlas*)pObj)->drawQuads();
+    }
+}
+
+//
+// CCFontAtlasBatchNode
+//
+CCFontAtlasBatchNode::CCFontAtlasBatchNode()
+: m_pTextureAtlases(NULL)
+{
+}
+
+CCFontAtlasBatchNode::~CCFontAtlasBatchNode()
+{
+    CC_SAFE_RELEASE(m_pTextureAtlases);
+}
+
+CCFontAtlasBatchNode* CCFontAtlasBatchNode::create()
+{
+    CCFontAtlasBatchNode *pRet = new CCFontAtlasBatchNode();
+    if (pRet && pRet->init())
+    {
+        pRet->autorelease();
+        return pRet;
+    }
+    CC_SAFE_DELETE(pRet);
+    return NULL;
+}
+
+bool CCFontAtlasBatchNode::init()
+{
+    m_pTextureAtlases = new CCArray();
+    setShaderProgram(CCShaderCache::sharedShaderCache()->programForKey(kCCShader_PositionTextureA8Color));
+    return true;
+}
+
+void CCFontAtlasBatchNode::addChild(CCNode * child)
+{
+    CCNode::addChild(child);
+}
+
+void CCFontAtlasBatchNode::addChild(CCNode * child, int zOrder)
+{
+    CCNode::addChild(child, zOrder);
+}
+
+void CCFontAtlasBatchNode::addChild(CCNode * child, int zOrder, int tag)
+{
+    CCAssert(dynamic_cast<CCLabelFontAtlas*>(child) != NULL, "CCFontAtlasBatchNode only supports CCLabelFontAtlas as children");
+    CCNode::addChild(child, zOrder, tag);
+}
+
+void CCFontAtlasBatchNode::visit()
+{
+    // CAREFUL:
+    // This visit is almost identical to CCNode#visit
+    // with the exception that it doesn't call visit on it's children
+    if (!m_bVisible)
+    {
+        return;
+    }
+
+    kmGLPushMatrix();
+
+    if ( m_pGrid && m_pGrid->isActive())
+    {
+        m_pGrid->beforeDraw();
+        transformAncestors();
+    }
+
+    transform();
+
+    draw();
+
+    if ( m_pGrid && m_pGrid->isActive())
+    {
+        m_pGrid->afterDraw(this);
+    }
+
+    kmGLPopMatrix();
+}
+
+CCTextureAtlas* CCFontAtlasBatchNode::textureAtlasForTexture(CCTexture2D *pTexture)
+{
+    CCObject *pObj = NULL;
+    CCARRAY_FOREACH(m_pTextureAtlases, pObj)
+    {
+        if (((CCTextureAtlas*)pObj)->getTexture() == pTexture)
+        {
+            return (CCTextureAtlas*)pObj;
+        }
+    }
+
+    CCTextureAtlas *pTextureAtlas = CCTextureAtlas::createWithTexture(pTexture, 64);
+    m_pTextureAtlases->addObject(pTextureAtlas);
+    return pTextureAtlas;
+}
+
+void CCFontAtlasBatchNode::draw(void)
+{
+    if (! m_pChildren || m_pChildren->count() == 0)
+    {
+        return;
+    }
+
+    sortAllChildren();
+
+    // gather the quads of the visible labels, in the coordinates of the batch node
+    CCObject *pObj = NULL;
+    CCARRAY_FOREACH(m_pChildren, pObj)
+    {
+        CCLabelFontAtlas *pLabel = (CCLabelFontAtlas*)pObj;
+        CCFontAtlas *pFontAtlas = pLabel->getFontAtlas();
+        if (! pLabel->isVisible() || ! pFontAtlas)
+        {
+            continue;
+        }
+        pFontAtlas->updatePages();
+
+        CCAffineTransform transform = pLabel->nodeToParentTransform();
+        float z = pLabel->getVertexZ();
+        for (unsigned int uPage = 0; uPage < pFontAtlas->getPageCount(); ++uPage)
+        {
+            CCTextureAtlas *pLabelQuads = pLabel->getTextureAtlasForPage(uPage);
+            if (! pLabelQuads || pLabelQuads->getTotalQuads() == 0)
+            {
+                continue;
+            }
+
+            CCTextureAtlas *pTextureAtlas = textureAtlasForTexture(pFontAtlas->getPage(uPage));
+            unsigned int uTotal = pTextureAtlas->getTotalQuads() + pLabelQuads->getTotalQuads();
+            if (uTotal > pTextureAtlas->getCapacity())
+            {
+                pTextureAtlas->resizeCapacity(MAX(uTotal, pTextureAtlas->getCapacity() * 2));
+            }
+
+            ccV3F_C4B_T2F_Quad *pQuads = pLabelQuads->getQuads();
+            for (unsigned int i = 0; i < pLabelQuads->getTotalQuads(); ++i)
+            {
+                ccV3F_C4B_T2F_Quad quad = pQuads[i];
+                CCPoint bl = CCPointApplyAffineTransform(ccp(quad.bl.vertices.x, quad.bl.vertices.y), transform);
+                CCPoint br = CCPointApplyAffineTransform(ccp(quad.br.vertices.x, quad.br.vertices.y), transform);
+                CCPoint tl = CCPointApplyAffineTransform(ccp(quad.tl.vertices.x, quad.tl.vertices.y), transform);
+                CCPoint tr = CCPointApplyAffineTransform(ccp(quad.tr.vertices.x, quad.tr.vertices.y), transform);
+                quad.bl.vertices = vertex3(bl.x, bl.y, z);
+                quad.br.vertices = vertex3(br.x, br.y, z);
+                quad.tl.vertices = vertex3(tl.x, tl.y, z);
+                quad.tr.vertices = vertex3(tr.x, tr.y, z);
+                pTextureAtlas->updateQuad(&quad, pTextureAtlas->getTotalQuads());
+            }
+        }
+    }
+
+    CC_NODE_DRAW_SETUP();
+    ccGLBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+    CCARRAY_FOREACH(m_pTextureAtlases, pObj)
+    {
+        CCTextureAtlas *pTextureAtlas = (CCTextureAtlas*)pObj;
+        pTextureAtlas->drawQuads();
+        pTextureAtlas->removeAllQuads();
+    }
+}
+
+NS_CC_END
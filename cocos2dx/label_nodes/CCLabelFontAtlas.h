@@ -0,0 +1,170 @@
+/****************************************************************************
+Copyright (c) 2013 cocos2d-x.org
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+#ifndef __CCLABEL_FONT_ATLAS_H__
+#define __CCLABEL_FONT_ATLAS_H__
+
+#include "base_nodes/CCNode.h"
+#include "CCProtocols.h"
+#include "label_nodes/CCFontAtlas.h"
+
+NS_CC_BEGIN
+
+class CCTextureAtlas;
+
+/**
+ * @addtogroup GUI
+ * @{
+ * @addtogroup label
+ * @{
+ */
+
+/** @brief CCLabelFontAtlas is a TrueType label drawn from the glyphs of a shared CCFontAtlas.
+
+ It has the API and the layout of CCLabelTTF, but instead of rasterizing the whole string into
+ a new texture each time it changes, every character is a quad referencing the font atlas.
+ Changing the string only updates the quads, and labels of the same font can be drawn
+ together by a CCFontAtlasBatchNode.
+
+ @warning The font atlas is only built on Linux.
+ @since v2.1.4
+ */
+class CC_DLL CCLabelFontAtlas : public CCNodeRGBA, public CCLabelProtocol
+{
+public:
+    CCLabelFontAtlas();
+    virtual ~CCLabelFontAtlas();
+    const char* description();
+
+    /** creates a CCLabelFontAtlas with a font name and font size in points */
+    static CCLabelFontAtlas* create(const char *string, const char *fontName, float fontSize);
+
+    /** creates a CCLabelFontAtlas from a fontname, horizontal alignment, dimension in points, and font size in points */
+    static CCLabelFontAtlas* create(const char *string, const char *fontName, float fontSize,
+                                    const CCSize& dimensions, CCTextAlignment hAlignment);
+
+    /** creates a CCLabelFontAtlas from a fontname, alignment, dimension in points and font size in points */
+    static CCLabelFontAtlas* create(const char *string, const char *fontName, float fontSize,
+                                    const CCSize& dimensions, CCTextAlignment hAlignment,
+                                    CCVerticalTextAlignment vAlignment);
+
+    /** initializes the CCLabelFontAtlas with a font name, alignment, dimension and font size */
+    bool initWithString(const char *string, const char *fontName, float fontSize,
+                        const CCSize& dimensions, CCTextAlignment hAlignment,
+                        CCVerticalTextAlignment vAlignment);
+
+    /** changes the string to render. Only the quads of the label are updated. */
+    virtual void setString(const char *label);
+    virtual const char* getString(void);
+
+    CCTextAlignment getHorizontalAlignment();
+    void setHorizontalAlignment(CCTextAlignment alignment);
+
+    CCVerticalTextAlignment getVerticalAlignment();
+    void setVerticalAlignment(CCVerticalTextAlignment verticalAlignment);
+
+    CCSize getDimensions();
+    void setDimensions(const CCSize &dim);
+
+    float getFontSize();
+    void setFontSize(float fontSize);
+
+    const char* getFontName();
+    void setFontName(const char *fontName);
+
+    /** The font atlas the glyphs of the label come from */
+    CCFontAtlas* getFontAtlas();
+
+    /** The quads of the label using a page of the font atlas, NULL if there are none */
+    CCTextureAtlas* getTextureAtlasForPage(unsigned int uPage);
+
+    virtual void draw(void);
+
+    virtual void setColor(const ccColor3B& color);
+    virtual void updateDisplayedColor(const ccColor3B& parentColor);
+    virtual void setOpacity(GLubyte opacity);
+    virtual void updateDisplayedOpacity(GLubyte parentOpacity);
+
+protected:
+    void updateFontAtlas();
+    void updateQuads();
+    void updateColor();
+
+    /** Dimensions of the label in Points */
+    CCSize m_tDimensions;
+    /** The alignment of the label */
+    CCTextAlignment         m_hAlignment;
+    /** The vertical alignment of the label */
+    CCVerticalTextAlignment m_vAlignment;
+    /** Font name used in the label */
+    std::string m_sFontName;
+    /** Font size of the label */
+    float m_fFontSize;
+
+    std::string m_string;
+
+    CCFontAtlas *m_pFontAtlas;
+    /** quads of the label, one CCTextureAtlas per page of the font atlas */
+    CCArray *m_pTextureAtlases;
+    /** lines of the last layout, kept to reuse their memory */
+    std::vector<ccGlyphLine> m_lines;
+};
+
+/** @brief CCFontAtlasBatchNode draws all its CCLabelFontAtlas children with one OpenGL call per font atlas page.
+
+ Only CCLabelFontAtlas can be added to it, and their own children are not drawn.
+ Labels are drawn in z order within a page, but the pages are drawn one after the other,
+ so labels of different fonts which overlap may not be drawn in z order.
+ @since v2.1.4
+ */
+class CC_DLL CCFontAtlasBatchNode : public CCNode
+{
+public:
+    CCFontAtlasBatchNode();
+    virtual ~CCFontAtlasBatchNode();
+
+    static CCFontAtlasBatchNode* create();
+
+    virtual bool init();
+
+    virtual void addChild(CCNode * child);
+    virtual void addChild(CCNode * child, int zOrder);
+    virtual void addChild(CCNode * child, int zOrder, int tag);
+
+    virtual void visit(void);
+    virtual void draw(void);
+
+private:
+    CCTextureAtlas* textureAtlasForTexture(CCTexture2D *pTexture);
+
+    /** quads of the children, one CCTextureAtlas per page texture */
+    CCArray *m_pTextureAtlases;
+};
+
+// end of label group
+/// @}
+/// @}
+
+NS_CC_END
+
+#endif //__CCLABEL_FONT_ATLAS_H__
@@ -760,6 +760,8 @@ void CCLayerColor::changeHeight(GLfloat h)
 
 void CCLayerColor::updateColor()
 {
+    setBitmapCacheDirty();
+
     for( unsigned int i=0; i < 4; i++ )
     {
         m_pSquareColors[i].r = _displayedColor.r / 255.0f;
@@ -0,0 +1,368 @@
+/****************************************************************************
+Copyright (c) 2013 cocos2d-x.org
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+#include "CCClipStack.h"
+#include "CCGL.h"
+#include "shaders/ccGLStateCache.h"
+#include "draw_nodes/CCDrawingPrimitives.h"
+#include "support/CCPointExtension.h"
+#include "kazmath/GL/matrix.h"
+#include "kazmath/vec4.h"
+#include <vector>
+#include <math.h>
+#include <float.h>
+#include <string.h>
+#include <limits.h>
+
+NS_CC_BEGIN
+
+// distance under which the corners of a rectangle on the screen are aligned, in pixels
+#define kCCClipAlignmentTolerance   0.05f
+
+typedef enum {
+    // nothing to restore: stencil clip without stencil buffer
+    kCCClipNone,
+    kCCClipScissor,
+    kCCClipStencil,
+    kCCClipSuspended,
+} ccClipKind;
+
+typedef struct _ccClipState
+{
+    //! how this state was pushed
+    ccClipKind  eKind;
+    bool        bScissor;
+    //! scissor rectangle in pixels: x, y, width, height
+    GLint       nScissor[4];
+    //! the content is drawn where the stencil buffer has this value, 0 if the stencil test is not used
+    GLint       nStencilRef;
+    //! depth mask to restore when the shape of a stencil clip is drawn
+    GLboolean   bDepthMask;
+} ccClipState;
+
+static std::vector<ccClipState> s_tClipStack;
+static ccClipState s_tClip = { kCCClipNone, false, { 0, 0, 0, 0 }, 0, GL_TRUE };
+static GLint s_nStencilBits = -1;
+static unsigned int s_uScissorClips = 0;
+static unsigned int s_uStencilClips = 0;
+
+static void applyClip(const ccClipState& clip)
+{
+    if (clip.bScissor)
+    {
+        ccGLSetCapability(GL_SCISSOR_TEST, true);
+        ccGLScissor(clip.nScissor[0], clip.nScissor[1], MAX(clip.nScissor[2], 0), MAX(clip.nScissor[3], 0));
+    }
+    else
+    {
+        ccGLSetCapability(GL_SCISSOR_TEST, false);
+    }
+
+    if (clip.nStencilRef > 0)
+    {
+        ccGLSetCapability(GL_STENCIL_TEST, true);
+        ccGLStencilFunc(GL_EQUAL, clip.nStencilRef, ~0);
+        ccGLStencilOp(GL_KEEP, GL_KEEP, GL_KEEP);
+    }
+    else
+    {
+        ccGLSetCapability(GL_STENCIL_TEST, false);
+    }
+}
+
+static void pushClip(ccClipKind eKind)
+{
+    // the batched primitives belong to the current clip
+    ccDrawFlush();
+    s_tClipStack.push_back(s_tClip);
+    s_tClip.eKind = eKind;
+}
+
+// while writing into the stencil buffer, the color and depth buffers are not written,
+// the depth mask is saved in the current clip and restored afterwards,
+// it is read from GL as the application may have changed it directly
+static void setStencilWriting(bool bWriting)
+{
+    if (bWriting)
+    {
+        glGetBooleanv(GL_DEPTH_WRITEMASK, &s_tClip.bDepthMask);
+        glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+        ccGLDepthMask(GL_FALSE);
+    }
+    else
+    {
+        glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+        ccGLDepthMask(s_tClip.bDepthMask);
+    }
+}
+
+// draws a rectangle covering the viewport, the scissor test still applies
+static void drawViewportRect()
+{
+    kmGLMatrixMode(KM_GL_PROJECTION);
+    kmGLPushMatrix();
+    kmGLLoadIdentity();
+    kmGLMatrixMode(KM_GL_MODELVIEW);
+    kmGLPushMatrix();
+    kmGLLoadIdentity();
+
+    ccDrawSolidRect(ccp(-1, -1), ccp(1, 1), ccc4f(1, 1, 1, 1));
+    ccDrawFlush();
+
+    kmGLPopMatrix();
+    kmGLMatrixMode(KM_GL_PROJECTION);
+    kmGLPopMatrix();
+    kmGLMatrixMode(KM_GL_MODELVIEW);
+}
+
+// the rectangle in pixels of the frame buffer, false if it is not axis-aligned on the screen
+static bool windowRect(const CCRect& rect, GLint *pRect)
+{
+    kmMat4 projection, modelview, mvp;
+    kmGLGetMatrix(KM_GL_PROJECTION, &projection);
+    kmGLGetMatrix(KM_GL_MODELVIEW, &modelview);
+    kmMat4Multiply(&mvp, &projection, &modelview);
+
+    GLint viewport[4];
+    ccGLGetViewport(viewport);
+
+    const float px[4] = { rect.getMinX(), rect.getMaxX(), rect.getMaxX(), rect.getMinX() };
+    const float py[4] = { rect.getMinY(), rect.getMinY(), rect.getMaxY(), rect.getMaxY() };
+    float wx[4], wy[4];
+    for (int i = 0; i < 4; i++)
+    {
+        kmVec4 corner, clip;
+        kmVec4Fill(&corner, px[i], py[i], 0, 1);
+        kmVec4Transform(&clip, &corner, &mvp);
+        if (clip.w <= FLT_EPSILON)
+        {
+            return false;
+        }
+        wx[i] = viewport[0] + (clip.x / clip.w + 1) * 0.5f * viewport[2];
+        wy[i] = viewport[1] + (clip.y / clip.w + 1) * 0.5f * viewport[3];
+    }
+
+    // each side must be horizontal or vertical
+    for (int i = 0; i < 4; i++)
+    {
+        int j = (i + 1) % 4;
+        if (fabsf(wx[i] - wx[j]) > kCCClipAlignmentTolerance && fabsf(wy[i] - wy[j]) > kCCClipAlignmentTolerance)
+        {
+            return false;
+        }
+    }
+
+    // the pixels whose center is inside the rectangle, like the rasterization of the stencil
+    float minX = MIN(MIN(wx[0], wx[1]), MIN(wx[2], wx[3]));
+    float maxX = MAX(MAX(wx[0], wx[1]), MAX(wx[2], wx[3]));
+    float minY = MIN(MIN(wy[0], wy[1]), MIN(wy[2], wy[3]));
+    float maxY = MAX(MAX(wy[0], wy[1]), MAX(wy[2], wy[3]));
+    pRect[0] = (GLint)floorf(minX + 0.5f);
+    pRect[1] = (GLint)floorf(minY + 0.5f);
+    pRect[2] = (GLint)floorf(maxX + 0.5f) - pRect[0];
+    pRect[3] = (GLint)floorf(maxY + 0.5f) - pRect[1];
+    return true;
+}
+
+void ccClipPushRect(const CCRect& rect)
+{
+    GLint scissor[4];
+    if (windowRect(rect, scissor))
+    {
+        pushClip(kCCClipScissor);
+        if (s_tClip.bScissor)
+        {
+            GLint x = MAX(scissor[0], s_tClip.nScissor[0]);
+            GLint y = MAX(scissor[1], s_tClip.nScissor[1]);
+            GLint xx = MIN(scissor[0] + scissor[2], s_tClip.nScissor[0] + s_tClip.nScissor[2]);
+            GLint yy = MIN(scissor[1] + scissor[3], s_tClip.nScissor[1] + s_tClip.nScissor[3]);
+            scissor[0] = x;
+            scissor[1] = y;
+            scissor[2] = MAX(xx - x, 0);
+            scissor[3] = MAX(yy - y, 0);
+        }
+        memcpy(s_tClip.nScissor, scissor, sizeof(scissor));
+        s_tClip.bScissor = true;
+        s_uScissorClips++;
+
+        applyClip(s_tClip);
+    }
+    else if (ccClipPushStencil(false))
+    {
+        ccDrawSolidRect(rect.origin, ccp(rect.getMaxX(), rect.getMaxY()), ccc4f(1, 1, 1, 1));
+        ccClipBeginContent();
+    }
+}
+
+bool ccClipPushStencil(bool bInverted)
+{
+    // get (only once) the number of bits of the stencil buffer
+    if (s_nStencilBits < 0)
+    {
+        glGetIntegerv(GL_STENCIL_BITS, &s_nStencilBits);
+        if (s_nStencilBits <= 0)
+        {
+            CCLOG("Stencil buffer is not enabled.");
+        }
+    }
+
+    GLint nMaxRef = s_nStencilBits < 31 ? (1 << s_nStencilBits) - 1 : INT_MAX;
+    if (s_nStencilBits <= 0 || s_tClip.nStencilRef >= nMaxRef)
+    {
+        if (s_nStencilBits > 0)
+        {
+            // warn once
+            static bool once = true;
+            if (once)
+            {
+                CCLOG("Nesting more than %d stencils is not supported. Everything will be drawn without stencil for this node and its childs.", nMaxRef);
+                once = false;
+            }
+        }
+        pushClip(kCCClipNone);
+        return false;
+    }
+
+    pushClip(kCCClipStencil);
+    GLint nRef = s_tClip.nStencilRef + 1;
+
+    ccGLSetCapability(GL_STENCIL_TEST, true);
+    ccGLStencilMask(~0);
+    setStencilWriting(true);
+
+    if (nRef == 1)
+    {
+        // the first stencil clip clears the stencil buffer, in the scissor rectangle only
+        glClearStencil(bInverted ? 1 : 0);
+        glClear(GL_STENCIL_BUFFER_BIT);
+        glClearStencil(0);
+    }
+    else if (bInverted)
+    {
+        // the area of the enclosing clip goes up to the new reference value,
+        // the shape brings it back down
+        ccGLStencilFunc(GL_EQUAL, nRef - 1, ~0);
+        ccGLStencilOp(GL_KEEP, GL_INCR, GL_INCR);
+        drawViewportRect();
+    }
+
+    // each pixel is changed once, overlapping parts of the shape don't pass the test any more
+    if (bInverted)
+    {
+        ccGLStencilFunc(GL_EQUAL, nRef, ~0);
+        ccGLStencilOp(GL_KEEP, GL_DECR, GL_DECR);
+    }
+    else
+    {
+        ccGLStencilFunc(GL_EQUAL, nRef - 1, ~0);
+        ccGLStencilOp(GL_KEEP, GL_INCR, GL_INCR);
+    }
+
+    s_tClip.nStencilRef = nRef;
+    s_uStencilClips++;
+    return true;
+}
+
+void ccClipBeginContent(void)
+{
+    CCAssert(s_tClip.eKind == kCCClipStencil || s_tClip.eKind == kCCClipNone, "ccClipBeginContent: no stencil clip pushed");
+    if (s_tClip.eKind == kCCClipStencil)
+    {
+        ccDrawFlush();
+        setStencilWriting(false);
+        applyClip(s_tClip);
+    }
+}
+
+void ccClipPop(void)
+{
+    CCAssert(!s_tClipStack.empty(), "ccClipPop: no clip pushed");
+    if (s_tClipStack.empty())
+    {
+        return;
+    }
+
+    ccDrawFlush();
+    if (s_tClip.eKind == kCCClipStencil)
+    {
+        if (s_tClip.nStencilRef > 1)
+        {
+            // brings the area of the clip back to the reference value of the enclosing one,
+            // the first stencil clip doesn't need it as the next one will clear the stencil buffer
+            setStencilWriting(true);
+            ccGLStencilFunc(GL_LESS, s_tClip.nStencilRef - 1, ~0);
+            ccGLStencilOp(GL_KEEP, GL_REPLACE, GL_REPLACE);
+            drawViewportRect();
+        }
+        setStencilWriting(false);
+    }
+
+    ccClipKind eKind = s_tClip.eKind;
+    s_tClip = s_tClipStack.back();
+    s_tClipStack.pop_back();
+    if (eKind != kCCClipNone)
+    {
+        applyClip(s_tClip);
+    }
+}
+
+bool ccClipIsEmpty(void)
+{
+    return s_tClip.bScissor && (s_tClip.nScissor[2] <= 0 || s_tClip.nScissor[3] <= 0);
+}
+
+void ccClipSuspend(void)
+{
+    // without clip, the GL state is left to the caller
+    if (s_tClipStack.empty())
+    {
+        pushClip(kCCClipNone);
+        return;
+    }
+
+    pushClip(kCCClipSuspended);
+    s_tClip.bScissor = false;
+    s_tClip.nStencilRef = 0;
+    applyClip(s_tClip);
+}
+
+void ccClipResume(void)
+{
+    CCAssert(s_tClip.eKind == kCCClipSuspended || s_tClip.eKind == kCCClipNone, "ccClipResume: the clips are not suspended");
+    ccClipPop();
+}
+
+void ccClipGetStats(unsigned int *pScissorClips, unsigned int *pStencilClips)
+{
+    if (pScissorClips)
+    {
+        *pScissorClips = s_uScissorClips;
+    }
+    if (pStencilClips)
+    {
+        *pStencilClips = s_uStencilClips;
+    }
+}
+
+NS_CC_END
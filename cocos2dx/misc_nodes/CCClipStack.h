@@ -0,0 +1,90 @@
+/****************************************************************************
+Copyright (c) 2013 cocos2d-x.org
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+#ifndef __MISCNODE_CCCLIP_STACK_H__
+#define __MISCNODE_CCCLIP_STACK_H__
+
+#include "ccMacros.h"
+#include "cocoa/CCGeometry.h"
+
+NS_CC_BEGIN
+
+/**
+ * @addtogroup misc_nodes
+ * @{
+ */
+
+/** @file CCClipStack.h
+ The clip stack is shared by CCClippingNode and the scroll views: the drawing is clipped by the intersection
+ of the clips pushed and not popped yet.
+
+ A rectangle that stays axis-aligned on the screen is clipped with the scissor test, by intersecting it with
+ the current scissor rectangle: it costs no pass and no stencil. Other shapes are drawn into the stencil buffer,
+ each nested stencil clip using the next reference value, so up to 2^n - 1 stencil clips can be nested
+ with n stencil bits.
+
+ The scissor and stencil tests are owned by the clip stack while it is not empty.
+ Each push must be balanced by a ccClipPop().
+ @since v2.1.4
+ */
+
+/** Pushes a rectangle in the coordinates of the current modelview matrix.
+ The scissor test is used if the rectangle is axis-aligned on the screen, the stencil buffer otherwise.
+ */
+void CC_DLL ccClipPushRect(const CCRect& rect);
+
+/** Pushes a stencil clip: the drawing until ccClipBeginContent() writes the shape into the stencil buffer,
+ without drawing into the color and depth buffers.
+ If bInverted is true, the content will be drawn where the shape is not drawn.
+ Returns false if there is no stencil buffer or too many stencil clips are nested: the shape should not be drawn,
+ the content is not clipped, and the clip must still be popped.
+ */
+bool CC_DLL ccClipPushStencil(bool bInverted);
+
+/** Ends the drawing of the shape of a stencil clip, the following drawing is clipped by it */
+void CC_DLL ccClipBeginContent(void);
+
+/** Pops the last clip pushed, and restores the clip around it */
+void CC_DLL ccClipPop(void);
+
+/** Returns true if the current scissor rectangle is empty: nothing can be drawn, the content can be skipped */
+bool CC_DLL ccClipIsEmpty(void);
+
+/** Suspends the clips while drawing into another frame buffer, like CCRenderTexture does.
+ Must be balanced by ccClipResume().
+ */
+void CC_DLL ccClipSuspend(void);
+
+/** Restores the clips suspended by ccClipSuspend() */
+void CC_DLL ccClipResume(void);
+
+/** Returns the number of clips pushed since the start with the scissor test and with the stencil buffer */
+void CC_DLL ccClipGetStats(unsigned int *pScissorClips, unsigned int *pStencilClips);
+
+// end of misc_nodes group
+/// @}
+
+NS_CC_END
+
+#endif // __MISCNODE_CCCLIP_STACK_H__
@@ -32,11 +32,13 @@
 #include "CCDirector.h"
 #include "support/CCPointExtension.h"
 #include "draw_nodes/CCDrawingPrimitives.h"
+#include "CCClipStack.h"
+#include "layers_scenes_transitions_nodes/CCLayer.h"
+#include "sprite_nodes/CCSprite.h"
+#include "effects/CCGrid.h"
 
 NS_CC_BEGIN
 
-static GLint g_sStencilBits = -1;
-
 static void setProgram(CCNode *n, CCGLProgram *p)
 {
     n->setShaderProgram(p);
@@ -53,6 +55,8 @@ CCClippingNode::CCClippingNode()
 : m_pStencil(NULL)
 , m_fAlphaThreshold(0.0f)
 , m_bInverted(false)
+, m_bClippingToRect(false)
+, m_obClippingRect(CCRectZero)
 {}
 
 CCClippingNode::~CCClippingNode()
@@ -103,17 +107,7 @@ bool CCClippingNode::init(CCNode *pStencil)
     
     m_fAlphaThreshold = 1;
     m_bInverted = false;
-    // get (only once) the number of bits of the stencil buffer
-    static bool once = true;
-    if (once)
-    {
-        glGetIntegerv(GL_STENCIL_BITS, &g_sStencilBits);
-        if (g_sStencilBits <= 0)
-        {
-            CCLOG("Stencil buffer is not enabled.");
-        }
-        once = false;
-    }
+    m_bClippingToRect = false;
     
     return true;
 }
@@ -121,34 +115,50 @@ bool CCClippingNode::init(CCNode *pStencil)
 void CCClippingNode::onEnter()
 {
     CCNode::onEnter();
-    m_pStencil->onEnter();
+    if (m_pStencil)
+    {
+        m_pStencil->onEnter();
+    }
 }
 
 void CCClippingNode::onEnterTransitionDidFinish()
 {
     CCNode::onEnterTransitionDidFinish();
-    m_pStencil->onEnterTransitionDidFinish();
+    if (m_pStencil)
+    {
+        m_pStencil->onEnterTransitionDidFinish();
+    }
 }
 
 void CCClippingNode::onExitTransitionDidStart()
 {
-    m_pStencil->onExitTransitionDidStart();
+    if (m_pStencil)
+    {
+        m_pStencil->onExitTransitionDidStart();
+    }
     CCNode::onExitTransitionDidStart();
 }
 
 void CCClippingNode::onExit()
 {
-    m_pStencil->onExit();
+    if (m_pStencil)
+    {
+        m_pStencil->onExit();
+    }
     CCNode::onExit();
 }
 
 void CCClippingNode::visit()
 {
-    // if stencil buffer disabled
-    if (g_sStencilBits < 1)
+    // quick return if not visible, the stencil is not drawn either
+    if (!m_bVisible)
     {
-        // draw everything, as if there where no stencil
-        CCNode::visit();
+        return;
+    }
+    
+    if (m_bClippingToRect)
+    {
+        visitInRect(m_obClippingRect, false);
         return;
     }
     
@@ -165,109 +175,33 @@ void CCClippingNode::visit()
         return;
     }
     
-    // store the current stencil layer (position in the stencil buffer),
-    // this will allow nesting up to n CCClippingNode,
-    // where n is the number of bits of the stencil buffer.
-    static GLint layer = -1;
-    
-    // all the _stencilBits are in use?
-    if (layer + 1 == g_sStencilBits)
+    // a rectangle doesn't need the stencil buffer while it stays axis-aligned
+    CCRect rect;
+    if (stencilRect(rect))
     {
-        // warn once
-        static bool once = true;
-        if (once)
-        {
-            char warning[200];
-            snprintf(warning, 50, "Nesting more than %d stencils is not supported. Everything will be drawn without stencil for this node and its childs.", g_sStencilBits);
-            CCLOG(warning);
-            
-            once = false;
-        }
-        // draw everything, as if there where no stencil
-        CCNode::visit();
+        visitInRect(rect, true);
         return;
     }
     
-    ///////////////////////////////////
-    // INIT
-    
-    // increment the current layer
-    layer++;
-    
-    // mask of the current layer (ie: for layer 3: 00000100)
-    GLint mask_layer = 0x1 << layer;
-    // mask of all layers less than the current (ie: for layer 3: 00000011)
-    GLint mask_layer_l = mask_layer - 1;
-    // mask of all layers less than or equal to the current (ie: for layer 3: 00000111)
-    GLint mask_layer_le = mask_layer | mask_layer_l;
-    
-    // manually save the stencil state
-    GLboolean currentStencilEnabled = GL_FALSE;
-    GLuint currentStencilWriteMask = ~0;
-    GLenum currentStencilFunc = GL_ALWAYS;
-    GLint currentStencilRef = 0;
-    GLuint currentStencilValueMask = ~0;
-    GLenum currentStencilFail = GL_KEEP;
-    GLenum currentStencilPassDepthFail = GL_KEEP;
-    GLenum currentStencilPassDepthPass = GL_KEEP;
-    currentStencilEnabled = glIsEnabled(GL_STENCIL_TEST);
-    glGetIntegerv(GL_STENCIL_WRITEMASK, (GLint *)&currentStencilWriteMask);
-    glGetIntegerv(GL_STENCIL_FUNC, (GLint *)&currentStencilFunc);
-    glGetIntegerv(GL_STENCIL_REF, &currentStencilRef);
-    glGetIntegerv(GL_STENCIL_VALUE_MASK, (GLint *)&currentStencilValueMask);
-    glGetIntegerv(GL_STENCIL_FAIL, (GLint *)&currentStencilFail);
-    glGetIntegerv(GL_STENCIL_PASS_DEPTH_FAIL, (GLint *)&currentStencilPassDepthFail);
-    glGetIntegerv(GL_STENCIL_PASS_DEPTH_PASS, (GLint *)&currentStencilPassDepthPass);
-    
-    // enable stencil use
-    glEnable(GL_STENCIL_TEST);
-    // check for OpenGL error while enabling stencil test
-    CHECK_GL_ERROR_DEBUG();
-    
-    // all bits on the stencil buffer are readonly, except the current layer bit,
-    // this means that operation like glClear or glStencilOp will be masked with this value
-    glStencilMask(mask_layer);
-    
-    // manually save the depth test state
-    //GLboolean currentDepthTestEnabled = GL_TRUE;
-    GLboolean currentDepthWriteMask = GL_TRUE;
-    //currentDepthTestEnabled = glIsEnabled(GL_DEPTH_TEST);
-    glGetBooleanv(GL_DEPTH_WRITEMASK, &currentDepthWriteMask);
-    
-    // disable depth test while drawing the stencil
-    //glDisable(GL_DEPTH_TEST);
-    // disable update to the depth buffer while drawing the stencil,
-    // as the stencil is not meant to be rendered in the real scene,
-    // it should never prevent something else to be drawn,
-    // only disabling depth buffer update should do
-    glDepthMask(GL_FALSE);
-    
-    ///////////////////////////////////
-    // CLEAR STENCIL BUFFER
-    
-    // manually clear the stencil buffer by drawing a fullscreen rectangle on it
-    // setup the stencil test func like this:
-    // for each pixel in the fullscreen rectangle
-    //     never draw it into the frame buffer
-    //     if not in inverted mode: set the current layer value to 0 in the stencil buffer
-    //     if in inverted mode: set the current layer value to 1 in the stencil buffer
-    glStencilFunc(GL_NEVER, mask_layer, mask_layer);
-    glStencilOp(!m_bInverted ? GL_ZERO : GL_REPLACE, GL_KEEP, GL_KEEP);
-    
-    // draw a fullscreen solid rectangle to clear the stencil buffer
-    //ccDrawSolidRect(CCPointZero, ccpFromSize([[CCDirector sharedDirector] winSize]), ccc4f(1, 1, 1, 1));
-    ccDrawSolidRect(CCPointZero, ccpFromSize(CCDirector::sharedDirector()->getWinSize()), ccc4f(1, 1, 1, 1));
-    
     ///////////////////////////////////
     // DRAW CLIPPING STENCIL
     
-    // setup the stencil test func like this:
-    // for each pixel in the stencil node
-    //     never draw it into the frame buffer
-    //     if not in inverted mode: set the current layer value to 1 in the stencil buffer
-    //     if in inverted mode: set the current layer value to 0 in the stencil buffer
-    glStencilFunc(GL_NEVER, mask_layer, mask_layer);
-    glStencilOp(!m_bInverted ? GL_REPLACE : GL_ZERO, GL_KEEP, GL_KEEP);
+    // the stencil node is drawn into the stencil buffer only, with the next reference value of the clip stack
+    if (!ccClipPushStencil(m_bInverted))
+    {
+        // no stencil buffer or all the reference values are in use:
+        // draw everything, as if there where no stencil
+        CCNode::visit();
+        ccClipPop();
+        return;
+    }
+    
+    // nothing can be drawn out of the scissor rectangle of the enclosing clips
+    if (ccClipIsEmpty())
+    {
+        ccClipPop();
+        return;
+    }
     
     // enable alpha test only if the alpha threshold < 1,
     // indeed if alpha threshold == 1, every pixel will be drawn anyways
@@ -324,41 +258,71 @@ void CCClippingNode::visit()
 #endif
     }
     
-    // restore the depth test state
-    glDepthMask(currentDepthWriteMask);
-    //if (currentDepthTestEnabled) {
-    //    glEnable(GL_DEPTH_TEST);
-    //}
-    
     ///////////////////////////////////
     // DRAW CONTENT
     
-    // setup the stencil test func like this:
-    // for each pixel of this node and its childs
-    //     if all layers less than or equals to the current are set to 1 in the stencil buffer
-    //         draw the pixel and keep the current layer in the stencil buffer
-    //     else
-    //         do not draw the pixel but keep the current layer in the stencil buffer
-    glStencilFunc(GL_EQUAL, mask_layer_le, mask_layer_le);
-    glStencilOp(GL_KEEP, GL_KEEP, GL_KEEP);
-    
-    // draw (according to the stencil test func) this node and its childs
+    // draw this node and its childs where the stencil buffer has the reference value of the clip
+    ccClipBeginContent();
     CCNode::visit();
     
     ///////////////////////////////////
     // CLEANUP
     
-    // manually restore the stencil state
-    glStencilFunc(currentStencilFunc, currentStencilRef, currentStencilValueMask);
-    glStencilOp(currentStencilFail, currentStencilPassDepthFail, currentStencilPassDepthPass);
-    glStencilMask(currentStencilWriteMask);
-    if (!currentStencilEnabled)
+    // restore the stencil buffer and the clip of the enclosing clipping nodes
+    ccClipPop();
+}
+
+bool CCClippingNode::stencilRect(CCRect& rect)
+{
+    // the stencil must be drawn entirely and alone
+    if (m_bInverted || m_fAlphaThreshold < 1 || m_pStencil->getChildrenCount() > 0)
+    {
+        return false;
+    }
+    CCGridBase *pGrid = m_pStencil->getGrid();
+    if (pGrid && pGrid->isActive())
+    {
+        return false;
+    }
+    
+    if (dynamic_cast<CCLayerColor*>(m_pStencil))
+    {
+        const CCSize& size = m_pStencil->getContentSize();
+        rect = CCRectMake(0, 0, size.width, size.height);
+        return true;
+    }
+    
+    CCSprite *pSprite = dynamic_cast<CCSprite*>(m_pStencil);
+    if (pSprite && !pSprite->getBatchNode())
+    {
+        // the quad of a sprite which is not in a batch node is in the sprite coordinates
+        const ccV3F_C4B_T2F_Quad& quad = pSprite->getQuad();
+        rect = CCRectMake(MIN(quad.bl.vertices.x, quad.tr.vertices.x), MIN(quad.bl.vertices.y, quad.tr.vertices.y),
+                          fabsf(quad.tr.vertices.x - quad.bl.vertices.x), fabsf(quad.tr.vertices.y - quad.bl.vertices.y));
+        return true;
+    }
+    
+    return false;
+}
+
+void CCClippingNode::visitInRect(const CCRect& rect, bool bStencilCoordinates)
+{
+    kmGLPushMatrix();
+    transform();
+    if (bStencilCoordinates)
+    {
+        m_pStencil->transform();
+    }
+    ccClipPushRect(rect);
+    kmGLPopMatrix();
+    
+    // skip the content out of the scissor rectangle
+    if (!ccClipIsEmpty())
     {
-        glDisable(GL_STENCIL_TEST);
+        CCNode::visit();
     }
     
-    // we are done using this layer, decrement
-    layer--;
+    ccClipPop();
 }
 
 CCNode* CCClippingNode::getStencil() const
@@ -393,4 +357,25 @@ void CCClippingNode::setInverted(bool bInverted)
     m_bInverted = bInverted;
 }
 
+void CCClippingNode::setClippingRect(const CCRect& rect)
+{
+    m_obClippingRect = rect;
+    m_bClippingToRect = true;
+}
+
+const CCRect& CCClippingNode::getClippingRect() const
+{
+    return m_obClippingRect;
+}
+
+bool CCClippingNode::hasClippingRect() const
+{
+    return m_bClippingToRect;
+}
+
+void CCClippingNode::removeClippingRect()
+{
+    m_bClippingToRect = false;
+}
+
 NS_CC_END
@@ -37,6 +37,9 @@ NS_CC_BEGIN
  It draws its content (childs) clipped using a stencil.
  The stencil is an other CCNode that will not be drawn.
  The clipping is done using the alpha part of the stencil (adjusted with an alphaThreshold).
+ A stencil that is a color layer or a sprite without childs, with the alpha test disabled and not inverted,
+ is a rectangle: like a clipping rectangle, it is clipped with the scissor test when it stays axis-aligned
+ on the screen, without drawing into the stencil buffer (see CCClipStack.h).
  */
 class CC_DLL CCClippingNode : public CCNode
 {
@@ -44,6 +47,8 @@ protected:
     CCNode* m_pStencil;
     GLfloat m_fAlphaThreshold;
     bool    m_bInverted;
+    bool    m_bClippingToRect;
+    CCRect  m_obClippingRect;
     
 public:
     /** Creates and initializes a clipping node without a stencil.
@@ -94,8 +99,30 @@ public:
     bool isInverted() const;
     void setInverted(bool bInverted);
     
+    /** Clips to a rectangle in the coordinates of the clipping node instead of the stencil.
+     The scissor test is used while the rectangle is axis-aligned on the screen.
+     @since v2.1.4
+     */
+    void setClippingRect(const CCRect& rect);
+    const CCRect& getClippingRect() const;
+    
+    /** Returns true if the clipping node clips to the rectangle set by setClippingRect()
+     @since v2.1.4
+     */
+    bool hasClippingRect() const;
+    
+    /** Clips with the stencil again, instead of the rectangle set by setClippingRect()
+     @since v2.1.4
+     */
+    void removeClippingRect();
+    
 private:
     CCClippingNode();
+    
+    // the rectangle of a stencil which is drawn entirely, in its coordinates
+    bool stencilRect(CCRect& rect);
+    // draws the content clipped by the rectangle pushed by ccClipPushRect()
+    void visitInRect(const CCRect& rect, bool bStencilCoordinates);
 };
 
 NS_CC_END
@@ -31,6 +31,12 @@ THE SOFTWARE.
 
 #include "support/CCVertex.h"
 #include "support/CCPointExtension.h"
+#include "support/CCNotificationCenter.h"
+#include "effects/CCGrid.h"
+#include "CCEventType.h"
+
+// extern
+#include "kazmath/GL/matrix.h"
 
 NS_CC_BEGIN
 
@@ -44,12 +50,12 @@ CCMotionStreak::CCMotionStreak()
 , m_fMinSeg(0.0f)
 , m_uMaxPoints(0)
 , m_uNuPoints(0)
-, m_uPreviousNuPoints(0)
+, m_uFirstPoint(0)
 , m_pPointVertexes(NULL)
 , m_pPointState(NULL)
 , m_pVertices(NULL)
-, m_pColorPointer(NULL)
-, m_pTexCoords(NULL)
+, m_uVbo(0)
+, m_bDirty(false)
 {
     m_tBlendFunc.src = GL_SRC_ALPHA;
     m_tBlendFunc.dst = GL_ONE_MINUS_SRC_ALPHA;
@@ -61,8 +67,13 @@ CCMotionStreak::~CCMotionStreak()
     CC_SAFE_FREE(m_pPointState);
     CC_SAFE_FREE(m_pPointVertexes);
     CC_SAFE_FREE(m_pVertices);
-    CC_SAFE_FREE(m_pColorPointer);
-    CC_SAFE_FREE(m_pTexCoords);
+
+    if (m_uVbo)
+    {
+        ccGLDeleteBuffers(1, &m_uVbo);
+    }
+
+    CCNotificationCenter::sharedNotificationCenter()->removeObserver(this, EVNET_COME_TO_FOREGROUND);
 }
 
 CCMotionStreak* CCMotionStreak::create(float fade, float minSeg, float stroke, ccColor3B color, const char* path)
@@ -116,12 +127,11 @@ bool CCMotionStreak::initWithFade(float fade, float minSeg, float stroke, ccColo
 
     m_uMaxPoints = (int)(fade*60.0f)+2;
     m_uNuPoints = 0;
+    m_uFirstPoint = 0;
     m_pPointState = (float *)malloc(sizeof(float) * m_uMaxPoints);
     m_pPointVertexes = (CCPoint*)malloc(sizeof(CCPoint) * m_uMaxPoints);
 
-    m_pVertices = (ccVertex2F*)malloc(sizeof(ccVertex2F) * m_uMaxPoints * 2);
-    m_pTexCoords = (ccTex2F*)malloc(sizeof(ccTex2F) * m_uMaxPoints * 2);
-    m_pColorPointer =  (GLubyte*)malloc(sizeof(GLubyte) * m_uMaxPoints * 2 * 4);
+    m_pVertices = (ccV2F_C4B_T2F*)malloc(sizeof(ccV2F_C4B_T2F) * m_uMaxPoints * 2);
 
     // Set blend mode
     m_tBlendFunc.src = GL_SRC_ALPHA;
@@ -134,6 +144,12 @@ bool CCMotionStreak::initWithFade(float fade, float minSeg, float stroke, ccColo
     setColor(color);
     scheduleUpdate();
 
+    // the vertex buffer object is created by the first draw
+    CCNotificationCenter::sharedNotificationCenter()->addObserver(this,
+                                                                  callfuncO_selector(CCMotionStreak::listenBackToForeground),
+                                                                  EVNET_COME_TO_FOREGROUND,
+                                                                  NULL);
+
     return true;
 }
 
@@ -148,10 +164,13 @@ void CCMotionStreak::tintWithColor(ccColor3B colors)
     setColor(colors);
 
     // Fast assignation
-    for(unsigned int i = 0; i<m_uNuPoints*2; i++) 
+    for(unsigned int i = 0; i<m_uNuPoints; i++) 
     {
-        *((ccColor3B*) (m_pColorPointer+i*4)) = colors;
+        ccV2F_C4B_T2F *pVertices = m_pVertices + ringIndex(i)*2;
+        *((ccColor3B*) &pVertices[0].colors) = colors;
+        *((ccColor3B*) &pVertices[1].colors) = colors;
     }
+    m_bDirty = true;
 }
 
 CCTexture2D* CCMotionStreak::getTexture(void)
@@ -209,52 +228,29 @@ void CCMotionStreak::update(float delta)
     
     delta *= m_fFadeDelta;
 
-    unsigned int newIdx, newIdx2, i, i2;
+    unsigned int i, idx;
     unsigned int mov = 0;
 
-    // Update current points
+    // Update current points, the oldest ones fade out first
     for(i = 0; i<m_uNuPoints; i++)
     {
-        m_pPointState[i]-=delta;
+        idx = ringIndex(i);
+        m_pPointState[idx]-=delta;
 
-        if(m_pPointState[i] <= 0)
+        if(m_pPointState[idx] <= 0)
             mov++;
         else
         {
-            newIdx = i-mov;
-
-            if(mov>0)
-            {
-                // Move data
-                m_pPointState[newIdx] = m_pPointState[i];
-
-                // Move point
-                m_pPointVertexes[newIdx] = m_pPointVertexes[i];
-
-                // Move vertices
-                i2 = i*2;
-                newIdx2 = newIdx*2;
-                m_pVertices[newIdx2] = m_pVertices[i2];
-                m_pVertices[newIdx2+1] = m_pVertices[i2+1];
-
-                // Move color
-                i2 *= 4;
-                newIdx2 *= 4;
-                m_pColorPointer[newIdx2+0] = m_pColorPointer[i2+0];
-                m_pColorPointer[newIdx2+1] = m_pColorPointer[i2+1];
-                m_pColorPointer[newIdx2+2] = m_pColorPointer[i2+2];
-                m_pColorPointer[newIdx2+4] = m_pColorPointer[i2+4];
-                m_pColorPointer[newIdx2+5] = m_pColorPointer[i2+5];
-                m_pColorPointer[newIdx2+6] = m_pColorPointer[i2+6];
-            }else
-                newIdx2 = newIdx*8;
-
-            const GLubyte op = (GLubyte)(m_pPointState[newIdx] * 255.0f);
-            m_pColorPointer[newIdx2+3] = op;
-            m_pColorPointer[newIdx2+7] = op;
+            const GLubyte op = (GLubyte)(m_pPointState[idx] * 255.0f);
+            m_pVertices[idx*2].colors.a = op;
+            m_pVertices[idx*2+1].colors.a = op;
         }
     }
+
+    // Remove them from the start of the ring
+    m_uFirstPoint = ringIndex(mov);
     m_uNuPoints-=mov;
+    bool bChanged = (m_uNuPoints > 0 || mov > 0);
 
     // Append new point
     bool appendNewPoint = true;
@@ -265,8 +261,8 @@ void CCMotionStreak::update(float delta)
 
     else if(m_uNuPoints>0)
     {
-        bool a1 = ccpDistanceSQ(m_pPointVertexes[m_uNuPoints-1], m_tPositionR) < m_fMinSeg;
-        bool a2 = (m_uNuPoints == 1) ? false : (ccpDistanceSQ(m_pPointVertexes[m_uNuPoints-2], m_tPositionR) < (m_fMinSeg * 2.0f));
+        bool a1 = ccpDistanceSQ(m_pPointVertexes[ringIndex(m_uNuPoints-1)], m_tPositionR) < m_fMinSeg;
+        bool a2 = (m_uNuPoints == 1) ? false : (ccpDistanceSQ(m_pPointVertexes[ringIndex(m_uNuPoints-2)], m_tPositionR) < (m_fMinSeg * 2.0f));
         if(a1 || a2)
         {
             appendNewPoint = false;
@@ -275,54 +271,144 @@ void CCMotionStreak::update(float delta)
 
     if(appendNewPoint)
     {
-        m_pPointVertexes[m_uNuPoints] = m_tPositionR;
-        m_pPointState[m_uNuPoints] = 1.0f;
+        idx = ringIndex(m_uNuPoints);
+        m_pPointVertexes[idx] = m_tPositionR;
+        m_pPointState[idx] = 1.0f;
 
         // Color assignment
-        const unsigned int offset = m_uNuPoints*8;
-        *((ccColor3B*)(m_pColorPointer + offset)) = _displayedColor;
-        *((ccColor3B*)(m_pColorPointer + offset+4)) = _displayedColor;
+        ccV2F_C4B_T2F *pVertices = m_pVertices + idx*2;
+        *((ccColor3B*) &pVertices[0].colors) = _displayedColor;
+        *((ccColor3B*) &pVertices[1].colors) = _displayedColor;
 
         // Opacity
-        m_pColorPointer[offset+3] = 255;
-        m_pColorPointer[offset+7] = 255;
+        pVertices[0].colors.a = 255;
+        pVertices[1].colors.a = 255;
+
+        m_uNuPoints ++;
 
-        // Generate polygon
-        if(m_uNuPoints > 0 && m_bFastMode )
+        // Generate polygon of the new segment
+        if(m_uNuPoints > 1 && m_bFastMode )
         {
-            if(m_uNuPoints > 1)
-            {
-                ccVertexLineToPolygon(m_pPointVertexes, m_fStroke, m_pVertices, m_uNuPoints, 1);
-            }
-            else
-            {
-                ccVertexLineToPolygon(m_pPointVertexes, m_fStroke, m_pVertices, 0, 2);
-            }
+            updatePolygon(m_uNuPoints > 2 ? m_uNuPoints-1 : 0);
         }
-
-        m_uNuPoints ++;
+        bChanged = true;
     }
 
     if( ! m_bFastMode )
     {
-        ccVertexLineToPolygon(m_pPointVertexes, m_fStroke, m_pVertices, 0, m_uNuPoints);
+        updatePolygon(0);
     }
 
-    // Updated Tex Coords only if they are different than previous step
-    if( m_uNuPoints  && m_uPreviousNuPoints != m_uNuPoints ) {
+    // The tex coords follow the position of the points from the oldest one
+    if( bChanged ) {
         float texDelta = 1.0f / m_uNuPoints;
         for( i=0; i < m_uNuPoints; i++ ) {
-            m_pTexCoords[i*2] = tex2(0, texDelta*i);
-            m_pTexCoords[i*2+1] = tex2(1, texDelta*i);
+            idx = ringIndex(i)*2;
+            m_pVertices[idx].texCoords = tex2(0, texDelta*i);
+            m_pVertices[idx+1].texCoords = tex2(1, texDelta*i);
+        }
+
+        m_bDirty = true;
+    }
+}
+
+void CCMotionStreak::updatePolygon(unsigned int uFrom)
+{
+    if(m_uNuPoints<=1) return;
+
+    float stroke = m_fStroke * 0.5f;
+    unsigned int nuPointsMinus = m_uNuPoints-1;
+
+    for(unsigned int i = uFrom; i<m_uNuPoints; i++)
+    {
+        CCPoint p1 = m_pPointVertexes[ringIndex(i)];
+        CCPoint perpVector;
+
+        if(i == 0)
+            perpVector = ccpPerp(ccpNormalize(ccpSub(p1, m_pPointVertexes[ringIndex(i+1)])));
+        else if(i == nuPointsMinus)
+            perpVector = ccpPerp(ccpNormalize(ccpSub(m_pPointVertexes[ringIndex(i-1)], p1)));
+        else
+        {
+            CCPoint p2 = m_pPointVertexes[ringIndex(i+1)];
+            CCPoint p0 = m_pPointVertexes[ringIndex(i-1)];
+
+            CCPoint p2p1 = ccpNormalize(ccpSub(p2, p1));
+            CCPoint p0p1 = ccpNormalize(ccpSub(p0, p1));
+
+            // Calculate angle between vectors
+            float angle = acosf(ccpDot(p2p1, p0p1));
+
+            if(angle < CC_DEGREES_TO_RADIANS(70))
+                perpVector = ccpPerp(ccpNormalize(ccpMidpoint(p2p1, p0p1)));
+            else if(angle < CC_DEGREES_TO_RADIANS(170))
+                perpVector = ccpNormalize(ccpMidpoint(p2p1, p0p1));
+            else
+                perpVector = ccpPerp(ccpNormalize(ccpSub(p2, p0)));
         }
+        perpVector = ccpMult(perpVector, stroke);
 
-        m_uPreviousNuPoints = m_uNuPoints;
+        ccV2F_C4B_T2F *pVertices = m_pVertices + ringIndex(i)*2;
+        pVertices[0].vertices = vertex2(p1.x+perpVector.x, p1.y+perpVector.y);
+        pVertices[1].vertices = vertex2(p1.x-perpVector.x, p1.y-perpVector.y);
+    }
+
+    // Validate vertexes
+    for(unsigned int i = (uFrom==0) ? 0 : uFrom-1; i<nuPointsMinus; i++)
+    {
+        ccV2F_C4B_T2F *pVertices = m_pVertices + ringIndex(i)*2;
+        ccV2F_C4B_T2F *pNext = m_pVertices + ringIndex(i+1)*2;
+
+        ccVertex2F p1 = pVertices[0].vertices;
+        ccVertex2F p2 = pVertices[1].vertices;
+        ccVertex2F p3 = pNext[0].vertices;
+        ccVertex2F p4 = pNext[1].vertices;
+
+        float s;
+        bool fixVertex = !ccVertexLineIntersect(p1.x, p1.y, p4.x, p4.y, p2.x, p2.y, p3.x, p3.y, &s);
+        if(!fixVertex)
+            if (s<0.0f || s>1.0f)
+                fixVertex = true;
+
+        if(fixVertex)
+        {
+            pNext[0].vertices = p4;
+            pNext[1].vertices = p3;
+        }
     }
 }
 
 void CCMotionStreak::reset()
 {
     m_uNuPoints = 0;
+    m_uFirstPoint = 0;
+}
+
+unsigned int CCMotionStreak::getVertexCount(void)
+{
+    return m_uNuPoints > 1 ? m_uNuPoints*2 : 0;
+}
+
+unsigned int CCMotionStreak::copyVertices(ccV2F_C4B_T2F *pOut)
+{
+    unsigned int uCount = getVertexCount();
+    if (uCount)
+    {
+        // the points may wrap around the end of the ring
+        unsigned int uFirst = MIN(m_uNuPoints, m_uMaxPoints - m_uFirstPoint);
+        memcpy(pOut, m_pVertices + m_uFirstPoint*2, sizeof(ccV2F_C4B_T2F) * uFirst*2);
+        memcpy(pOut + uFirst*2, m_pVertices, sizeof(ccV2F_C4B_T2F) * (m_uNuPoints - uFirst)*2);
+    }
+    return uCount;
+}
+
+void CCMotionStreak::listenBackToForeground(CCObject *obj)
+{
+    CC_UNUSED_PARAM(obj);
+
+    // the buffer was lost with the GL context
+    m_uVbo = 0;
+    m_bDirty = true;
 }
 
 void CCMotionStreak::draw()
@@ -337,14 +423,271 @@ void CCMotionStreak::draw()
 
     ccGLBindTexture2D( m_pTexture->getName() );
 
-    glVertexAttribPointer(kCCVertexAttrib_Position, 2, GL_FLOAT, GL_FALSE, 0, m_pVertices);
-    glVertexAttribPointer(kCCVertexAttrib_TexCoords, 2, GL_FLOAT, GL_FALSE, 0, m_pTexCoords);
-    glVertexAttribPointer(kCCVertexAttrib_Color, 4, GL_UNSIGNED_BYTE, GL_TRUE, 0, m_pColorPointer);
+    if (! m_uVbo)
+    {
+        glGenBuffers(1, &m_uVbo);
+        ccGLBindBuffer(GL_ARRAY_BUFFER, m_uVbo);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(ccV2F_C4B_T2F) * m_uMaxPoints * 2, NULL, GL_DYNAMIC_DRAW);
+        m_bDirty = true;
+    }
+    else
+    {
+        ccGLBindBuffer(GL_ARRAY_BUFFER, m_uVbo);
+    }
+
+    if (m_bDirty)
+    {
+        // the strip starts at the start of the buffer, the part of the ring after its end follows
+        unsigned int uFirst = MIN(m_uNuPoints, m_uMaxPoints - m_uFirstPoint);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(ccV2F_C4B_T2F) * uFirst*2, m_pVertices + m_uFirstPoint*2);
+        if (uFirst < m_uNuPoints)
+        {
+            glBufferSubData(GL_ARRAY_BUFFER, sizeof(ccV2F_C4B_T2F) * uFirst*2,
+                            sizeof(ccV2F_C4B_T2F) * (m_uNuPoints - uFirst)*2, m_pVertices);
+        }
+        m_bDirty = false;
+    }
+
+    glVertexAttribPointer(kCCVertexAttrib_Position, 2, GL_FLOAT, GL_FALSE, sizeof(ccV2F_C4B_T2F), (GLvoid *)offsetof(ccV2F_C4B_T2F, vertices));
+    glVertexAttribPointer(kCCVertexAttrib_TexCoords, 2, GL_FLOAT, GL_FALSE, sizeof(ccV2F_C4B_T2F), (GLvoid *)offsetof(ccV2F_C4B_T2F, texCoords));
+    glVertexAttribPointer(kCCVertexAttrib_Color, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(ccV2F_C4B_T2F), (GLvoid *)offsetof(ccV2F_C4B_T2F, colors));
 
     glDrawArrays(GL_TRIANGLE_STRIP, 0, (GLsizei)m_uNuPoints*2);
 
+    ccGLBindBuffer(GL_ARRAY_BUFFER, 0);
+
     CC_INCREMENT_GL_DRAWS(1);
 }
 
-NS_CC_END
+//
+// CCMotionStreakBatchNode
+//
+
+CCMotionStreakBatchNode::CCMotionStreakBatchNode()
+: m_pTexture(NULL)
+, m_uVbo(0)
+, m_uVboCapacity(0)
+{
+    m_tBlendFunc.src = GL_SRC_ALPHA;
+    m_tBlendFunc.dst = GL_ONE_MINUS_SRC_ALPHA;
+}
+
+CCMotionStreakBatchNode::~CCMotionStreakBatchNode()
+{
+    CC_SAFE_RELEASE(m_pTexture);
 
+    if (m_uVbo)
+    {
+        ccGLDeleteBuffers(1, &m_uVbo);
+    }
+
+    CCNotificationCenter::sharedNotificationCenter()->removeObserver(this, EVNET_COME_TO_FOREGROUND);
+}
+
+CCMotionStreakBatchNode* CCMotionStreakBatchNode::createWithTexture(CCTexture2D* texture)
+{
+    CCMotionStreakBatchNode *pRet = new CCMotionStreakBatchNode();
+    if (pRet && pRet->initWithTexture(texture))
+    {
+        pRet->autorelease();
+        return pRet;
+    }
+
+    CC_SAFE_DELETE(pRet);
+    return NULL;
+}
+
+CCMotionStreakBatchNode* CCMotionStreakBatchNode::create(const char* file)
+{
+    CCAssert(file != NULL, "Invalid filename");
+
+    CCTexture2D *texture = CCTextureCache::sharedTextureCache()->addImage(file);
+    return texture ? createWithTexture(texture) : NULL;
+}
+
+bool CCMotionStreakBatchNode::initWithTexture(CCTexture2D* texture)
+{
+    CCAssert(texture != NULL, "CCTexture2D must be non-NULL");
+
+    setTexture(texture);
+    setShaderProgram(CCShaderCache::sharedShaderCache()->programForKey(kCCShader_PositionTextureColor));
+
+    CCNotificationCenter::sharedNotificationCenter()->addObserver(this,
+                                                                  callfuncO_selector(CCMotionStreakBatchNode::listenBackToForeground),
+                                                                  EVNET_COME_TO_FOREGROUND,
+                                                                  NULL);
+    return true;
+}
+
+void CCMotionStreakBatchNode::addChild(CCNode *child)
+{
+    CCNode::addChild(child);
+}
+
+void CCMotionStreakBatchNode::addChild(CCNode *child, int zOrder)
+{
+    CCNode::addChild(child, zOrder);
+}
+
+void CCMotionStreakBatchNode::addChild(CCNode *child, int zOrder, int tag)
+{
+    CCMotionStreak *pStreak = dynamic_cast<CCMotionStreak*>(child);
+    CCAssert(pStreak != NULL, "CCMotionStreakBatchNode only supports CCMotionStreaks as children");
+    CCAssert(pStreak->getTexture()->getName() == m_pTexture->getName(), "CCMotionStreak is not using the same texture id");
+    CC_UNUSED_PARAM(pStreak);
+
+    CCNode::addChild(child, zOrder, tag);
+}
+
+void CCMotionStreakBatchNode::visit()
+{
+    // like CCSpriteBatchNode, the children are not visited: draw() collects their vertices
+    if (! m_bVisible)
+    {
+        return;
+    }
+
+    kmGLPushMatrix();
+
+    if (m_pGrid && m_pGrid->isActive())
+    {
+        m_pGrid->beforeDraw();
+        transformAncestors();
+    }
+
+    sortAllChildren();
+    transform();
+
+    draw();
+
+    if (m_pGrid && m_pGrid->isActive())
+    {
+        m_pGrid->afterDraw(this);
+    }
+
+    kmGLPopMatrix();
+    setOrderOfArrival(0);
+}
+
+void CCMotionStreakBatchNode::draw()
+{
+    m_tVertices.clear();
+
+    if (! m_pChildren)
+    {
+        return;
+    }
+
+    CCAffineTransform identity = CCAffineTransformMakeIdentity();
+    CCObject* pObj = NULL;
+    CCARRAY_FOREACH(m_pChildren, pObj)
+    {
+        CCMotionStreak *pStreak = (CCMotionStreak*)pObj;
+        unsigned int uCount = pStreak->getVertexCount();
+        if (! pStreak->isVisible() || uCount == 0)
+        {
+            continue;
+        }
+
+        // the strips are joined by repeating the last vertex of a strip and the first one of the next:
+        // the strips have an even number of vertices, the triangles in between are degenerate
+        unsigned int uStart = m_tVertices.size();
+        unsigned int uJoin = uStart ? 2 : 0;
+        m_tVertices.resize(uStart + uJoin + uCount);
+        ccV2F_C4B_T2F *pVertices = &m_tVertices[uStart + uJoin];
+        pStreak->copyVertices(pVertices);
+        if (uJoin)
+        {
+            m_tVertices[uStart] = m_tVertices[uStart - 1];
+            m_tVertices[uStart + 1] = pVertices[0];
+        }
+
+        CCAffineTransform t = pStreak->nodeToParentTransform();
+        if (! CCAffineTransformEqualToTransform(t, identity))
+        {
+            for (unsigned int i = 0; i < uCount; i++)
+            {
+                CCPoint pt = CCPointApplyAffineTransform(ccp(pVertices[i].vertices.x, pVertices[i].vertices.y), t);
+                pVertices[i].vertices = vertex2(pt.x, pt.y);
+            }
+            if (uJoin)
+            {
+                m_tVertices[uStart + 1] = pVertices[0];
+            }
+        }
+    }
+
+    if (m_tVertices.empty())
+    {
+        return;
+    }
+
+    CC_NODE_DRAW_SETUP();
+
+    ccGLEnableVertexAttribs(kCCVertexAttribFlag_PosColorTex );
+    ccGLBlendFunc( m_tBlendFunc.src, m_tBlendFunc.dst );
+
+    ccGLBindTexture2D( m_pTexture->getName() );
+
+    if (! m_uVbo)
+    {
+        glGenBuffers(1, &m_uVbo);
+        m_uVboCapacity = 0;
+    }
+    ccGLBindBuffer(GL_ARRAY_BUFFER, m_uVbo);
+
+    // the vertices are streamed: the buffer only grows
+    unsigned int uCount = m_tVertices.size();
+    if (uCount > m_uVboCapacity)
+    {
+        m_uVboCapacity = MAX(uCount, m_uVboCapacity * 2);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(ccV2F_C4B_T2F) * m_uVboCapacity, NULL, GL_STREAM_DRAW);
+    }
+    glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(ccV2F_C4B_T2F) * uCount, &m_tVertices[0]);
+
+    glVertexAttribPointer(kCCVertexAttrib_Position, 2, GL_FLOAT, GL_FALSE, sizeof(ccV2F_C4B_T2F), (GLvoid *)offsetof(ccV2F_C4B_T2F, vertices));
+    glVertexAttribPointer(kCCVertexAttrib_TexCoords, 2, GL_FLOAT, GL_FALSE, sizeof(ccV2F_C4B_T2F), (GLvoid *)offsetof(ccV2F_C4B_T2F, texCoords));
+    glVertexAttribPointer(kCCVertexAttrib_Color, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(ccV2F_C4B_T2F), (GLvoid *)offsetof(ccV2F_C4B_T2F, colors));
+
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, (GLsizei)uCount);
+
+    ccGLBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    CC_INCREMENT_GL_DRAWS(1);
+}
+
+void CCMotionStreakBatchNode::listenBackToForeground(CCObject *obj)
+{
+    CC_UNUSED_PARAM(obj);
+
+    // the buffer was lost with the GL context
+    m_uVbo = 0;
+    m_uVboCapacity = 0;
+}
+
+CCTexture2D* CCMotionStreakBatchNode::getTexture(void)
+{
+    return m_pTexture;
+}
+
+void CCMotionStreakBatchNode::setTexture(CCTexture2D *texture)
+{
+    if (m_pTexture != texture)
+    {
+        CC_SAFE_RETAIN(texture);
+        CC_SAFE_RELEASE(m_pTexture);
+        m_pTexture = texture;
+    }
+}
+
+void CCMotionStreakBatchNode::setBlendFunc(ccBlendFunc blendFunc)
+{
+    m_tBlendFunc = blendFunc;
+}
+
+ccBlendFunc CCMotionStreakBatchNode::getBlendFunc(void)
+{
+    return m_tBlendFunc;
+}
+
+NS_CC_END
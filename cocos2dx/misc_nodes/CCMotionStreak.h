@@ -29,6 +29,7 @@ THE SOFTWARE.
 #include "textures/CCTexture2D.h"
 #include "ccTypes.h"
 #include "base_nodes/CCNode.h"
+#include <vector>
 
 NS_CC_BEGIN
 
@@ -39,6 +40,10 @@ NS_CC_BEGIN
 
 /** MotionStreak.
  Creates a trailing path.
+
+ The points of the path are kept in a ring: the new points are appended at its end and the points that
+ faded out are removed from its start, without moving the others. In fast mode, only the vertices of the
+ new points are computed. The vertices are streamed into a vertex buffer object when they change.
  */
 class CC_DLL CCMotionStreak : public CCNodeRGBA, public CCTextureProtocol
 {
@@ -86,10 +91,35 @@ public:
     { 
         m_bStartingPositionInitialized = bStartingPositionInitialized; 
     }
+
+    /** number of vertices of the triangle strip of the streak, 0 if there is nothing to draw
+     @since v2.1.4
+     */
+    unsigned int getVertexCount(void);
+
+    /** copies the vertices of the triangle strip, from the oldest point to the newest one,
+     and returns the number of vertices copied. pOut must have room for getVertexCount() vertices.
+     @since v2.1.4
+     */
+    unsigned int copyVertices(ccV2F_C4B_T2F *pOut);
+
+    /** the vertex buffer object is created again when the GL context is recreated
+     @since v2.1.4
+     */
+    void listenBackToForeground(CCObject *obj);
 protected:
     bool m_bFastMode;
     bool m_bStartingPositionInitialized;
 private:
+    // index in the ring of the uIndex-th point from the oldest one
+    inline unsigned int ringIndex(unsigned int uIndex)
+    {
+        uIndex += m_uFirstPoint;
+        return uIndex >= m_uMaxPoints ? uIndex - m_uMaxPoints : uIndex;
+    }
+    // computes the vertices of the points from the uFrom-th one, like ccVertexLineToPolygon()
+    void updatePolygon(unsigned int uFrom);
+
     /** texture used for the motion streak */
     CCTexture2D* m_pTexture;
     ccBlendFunc m_tBlendFunc;
@@ -101,16 +131,64 @@ private:
 
     unsigned int m_uMaxPoints;
     unsigned int m_uNuPoints;
-    unsigned int m_uPreviousNuPoints;
+    /** index in the ring of the oldest point */
+    unsigned int m_uFirstPoint;
 
     /** Pointers */
     CCPoint* m_pPointVertexes;
     float* m_pPointState;
 
     // Opengl
-    ccVertex2F* m_pVertices;
-    GLubyte* m_pColorPointer;
-    ccTex2F* m_pTexCoords;
+    /** two vertices by point, at the same index in the ring as the point */
+    ccV2F_C4B_T2F* m_pVertices;
+    GLuint m_uVbo;
+    /** the vertices changed since they were uploaded */
+    bool m_bDirty;
+};
+
+/** CCMotionStreakBatchNode draws the motion streaks added to it as children with one draw call.
+ The streaks must use the texture of the batch node, their triangle strips are joined by degenerate
+ triangles. The blend function of the batch node is used, and the children of the streaks are not drawn.
+ @since v2.1.4
+ */
+class CC_DLL CCMotionStreakBatchNode : public CCNode, public CCTextureProtocol
+{
+public:
+    CCMotionStreakBatchNode();
+    virtual ~CCMotionStreakBatchNode();
+
+    /** creates a batch node for the streaks using the texture */
+    static CCMotionStreakBatchNode* createWithTexture(CCTexture2D* texture);
+    /** creates a batch node for the streaks using the texture of the file */
+    static CCMotionStreakBatchNode* create(const char* file);
+
+    bool initWithTexture(CCTexture2D* texture);
+
+    virtual void addChild(CCNode *child);
+    virtual void addChild(CCNode *child, int zOrder);
+    virtual void addChild(CCNode *child, int zOrder, int tag);
+
+    virtual void visit();
+    virtual void draw();
+
+    virtual CCTexture2D* getTexture(void);
+    virtual void setTexture(CCTexture2D *texture);
+    virtual void setBlendFunc(ccBlendFunc blendFunc);
+    virtual ccBlendFunc getBlendFunc(void);
+
+    /** number of vertices drawn by the last draw */
+    inline unsigned int getVertexCount(void) { return (unsigned int)m_tVertices.size(); }
+
+    /** the vertex buffer object is created again when the GL context is recreated */
+    void listenBackToForeground(CCObject *obj);
+
+private:
+    CCTexture2D* m_pTexture;
+    ccBlendFunc m_tBlendFunc;
+    std::vector<ccV2F_C4B_T2F> m_tVertices;
+    GLuint m_uVbo;
+    /** number of vertices the vertex buffer object can hold */
+    unsigned int m_uVboCapacity;
 };
 
 // end of misc_nodes group
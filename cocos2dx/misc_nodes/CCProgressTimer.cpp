@@ -33,6 +33,9 @@ THE SOFTWARE.
 #include "CCDirector.h"
 #include "support/TransformUtils.h"
 #include "draw_nodes/CCDrawingPrimitives.h"
+#include "support/CCNotificationCenter.h"
+#include "effects/CCGrid.h"
+#include "CCEventType.h"
 // extern
 #include "kazmath/GL/matrix.h"
 
@@ -51,10 +54,14 @@ CCProgressTimer::CCProgressTimer()
 ,m_pSprite(NULL)
 ,m_nVertexDataCount(0)
 ,m_pVertexData(NULL)
+,m_nValidVertexCount(0)
+,m_bRadialShaderMode(false)
 ,m_tMidpoint(0,0)
 ,m_tBarChangeRate(0,0)
 ,m_bReverseDirection(false)
-{}
+{
+    m_tVertexColor = ccc4(0, 0, 0, 0);
+}
 
 CCProgressTimer* CCProgressTimer::create(CCSprite* sp)
 {
@@ -75,8 +82,14 @@ CCProgressTimer* CCProgressTimer::create(CCSprite* sp)
 bool CCProgressTimer::initWithSprite(CCSprite* sp)
 {
     setPercentage(0.0f);
-    m_pVertexData = NULL;
+
+    //    The buffer is allocated once for the largest geometry
+    if (!m_pVertexData) {
+        m_pVertexData = (ccV2F_C4B_T2F*)calloc(kCCProgressTimerMaxVertices, sizeof(ccV2F_C4B_T2F));
+        CCAssert( m_pVertexData, "CCProgressTimer. Not enough memory");
+    }
     m_nVertexDataCount = 0;
+    m_nValidVertexCount = 0;
 
     setAnchorPoint(ccp(0.5f,0.5f));
     m_eType = kCCProgressTimerTypeRadial;
@@ -113,12 +126,8 @@ void CCProgressTimer::setSprite(CCSprite *pSprite)
         m_pSprite = pSprite;
         setContentSize(m_pSprite->getContentSize());
 
-        //    Every time we set a new sprite, we free the current vertex data
-        if (m_pVertexData)
-        {
-            CC_SAFE_FREE(m_pVertexData);
-            m_nVertexDataCount = 0;
-        }
+        //    Every time we set a new sprite, we invalidate the current vertex data
+        invalidateVertexData();
     }        
 }
 
@@ -126,13 +135,8 @@ void CCProgressTimer::setType(CCProgressTimerType type)
 {
     if (type != m_eType)
     {
-        //    release all previous information
-        if (m_pVertexData)
-        {
-            CC_SAFE_FREE(m_pVertexData);
-            m_pVertexData = NULL;
-            m_nVertexDataCount = 0;
-        }
+        //    invalidate all previous information
+        invalidateVertexData();
 
         m_eType = type;
     }
@@ -143,9 +147,27 @@ void CCProgressTimer::setReverseProgress(bool reverse)
     if( m_bReverseDirection != reverse ) {
         m_bReverseDirection = reverse;
 
-        //    release all previous information
-        CC_SAFE_FREE(m_pVertexData);
-        m_nVertexDataCount = 0;
+        //    invalidate all previous information
+        invalidateVertexData();
+    }
+}
+
+void CCProgressTimer::invalidateVertexData(void)
+{
+    m_nVertexDataCount = 0;
+    m_nValidVertexCount = 0;
+}
+
+void CCProgressTimer::setRadialShaderMode(bool bEnabled)
+{
+    if (m_bRadialShaderMode != bEnabled)
+    {
+        m_bRadialShaderMode = bEnabled;
+        m_nValidVertexCount = 0;
+        if (m_nVertexDataCount)
+        {
+            updateProgress();
+        }
     }
 }
 
@@ -200,10 +222,13 @@ void CCProgressTimer::updateColor(void)
         return;
     }
 
-    if (m_pVertexData)
+    //    Only when the color of the sprite changed, the whole buffer so the vertices
+    //    computed later have the color too
+    ccColor4B sc = m_pSprite->getQuad().tl.colors;
+    if (m_pVertexData && (sc.r != m_tVertexColor.r || sc.g != m_tVertexColor.g || sc.b != m_tVertexColor.b || sc.a != m_tVertexColor.a))
     {
-        ccColor4B sc = m_pSprite->getQuad().tl.colors;
-        for (int i = 0; i < m_nVertexDataCount; ++i)
+        m_tVertexColor = sc;
+        for (int i = 0; i < kCCProgressTimerMaxVertices; ++i)
         {
             m_pVertexData[i].colors = sc;
         }            
@@ -212,6 +237,8 @@ void CCProgressTimer::updateColor(void)
 
 void CCProgressTimer::updateProgress(void)
 {
+    setBitmapCacheDirty();
+
     switch (m_eType)
     {
     case kCCProgressTimerTypeRadial:
@@ -238,13 +265,15 @@ CCPoint CCProgressTimer::getMidpoint(void)
 void CCProgressTimer::setMidpoint(CCPoint midPoint)
 {
     m_tMidpoint = ccpClamp(midPoint, CCPointZero, ccp(1,1));
+    //    computed again by the next update
+    m_nValidVertexCount = 0;
 }
 
 ///
 //    Update does the work of mapping the texture onto the triangles
 //    It now doesn't occur the cost of free/alloc data every update cycle.
-//    It also only changes the percentage point but no other points if they have not
-//    been modified.
+//    It also only changes the percentage point and the edges swept since the last
+//    update, but no other points if they have not been modified.
 //    
 //    It now deals with flipped texture. If you run into this problem, just use the
 //    sprite property and enable the methods flipX, flipY.
@@ -254,6 +283,24 @@ void CCProgressTimer::updateRadial(void)
     if (!m_pSprite) {
         return;
     }
+    updateColor();
+
+    if (m_bRadialShaderMode) {
+        //    The shader discards the part of the quad that is not swept, the percentage is
+        //    a uniform: the vertices only change with the sprite
+        if (m_nValidVertexCount != 4) {
+            for (int i = 0; i < 4; ++i) {
+                //    TOPLEFT, BOTLEFT, TOPRIGHT, BOTRIGHT
+                CCPoint alphaPoint = ccp(i / 2, 1 - i % 2);
+                m_pVertexData[i].texCoords = textureCoordFromAlphaPoint(alphaPoint);
+                m_pVertexData[i].vertices = vertexFromAlphaPoint(alphaPoint);
+            }
+            m_nValidVertexCount = 4;
+        }
+        m_nVertexDataCount = 4;
+        return;
+    }
+
     float alpha = m_fPercentage / 100.f;
 
     float angle = 2.f*((float)M_PI) * ( m_bReverseDirection ? alpha : 1.0f - alpha);
@@ -333,43 +380,31 @@ void CCProgressTimer::updateRadial(void)
 
     //    The size of the vertex data is the index from the hitpoint
     //    the 3 is for the m_tMidpoint, 12 o'clock point and hitpoint position.
+    m_nVertexDataCount = index + 3;
 
-    bool sameIndexCount = true;
-    if(m_nVertexDataCount != index + 3){
-        sameIndexCount = false;
-        CC_SAFE_FREE(m_pVertexData);
-        m_nVertexDataCount = 0;
-    }
-
-
-    if(!m_pVertexData) {
-        m_nVertexDataCount = index + 3;
-        m_pVertexData = (ccV2F_C4B_T2F*)malloc(m_nVertexDataCount * sizeof(ccV2F_C4B_T2F));
-        CCAssert( m_pVertexData, "CCProgressTimer. Not enough memory");
-    }
-    updateColor();
-
-    if (!sameIndexCount) {
-
-        //    First we populate the array with the m_tMidpoint, then all
-        //    vertices/texcoords/colors of the 12 'o clock start and edges and the hitpoint
+    //    First we populate the array with the m_tMidpoint, then all
+    //    vertices/texcoords of the 12 'o clock start and edges and the hitpoint.
+    //    The ones still valid from the previous update are kept
+    if (m_nValidVertexCount < 2) {
         m_pVertexData[0].texCoords = textureCoordFromAlphaPoint(m_tMidpoint);
         m_pVertexData[0].vertices = vertexFromAlphaPoint(m_tMidpoint);
 
         m_pVertexData[1].texCoords = textureCoordFromAlphaPoint(topMid);
         m_pVertexData[1].vertices = vertexFromAlphaPoint(topMid);
 
-        for(int i = 0; i < index; ++i){
-            CCPoint alphaPoint = boundaryTexCoord(i);
-            m_pVertexData[i+2].texCoords = textureCoordFromAlphaPoint(alphaPoint);
-            m_pVertexData[i+2].vertices = vertexFromAlphaPoint(alphaPoint);
-        }
+        m_nValidVertexCount = 2;
     }
 
-    //    hitpoint will go last
+    for(int i = m_nValidVertexCount - 2; i < index; ++i){
+        CCPoint alphaPoint = boundaryTexCoord(i);
+        m_pVertexData[i+2].texCoords = textureCoordFromAlphaPoint(alphaPoint);
+        m_pVertexData[i+2].vertices = vertexFromAlphaPoint(alphaPoint);
+    }
+
+    //    hitpoint will go last, in place of the next edge
     m_pVertexData[m_nVertexDataCount - 1].texCoords = textureCoordFromAlphaPoint(hit);
     m_pVertexData[m_nVertexDataCount - 1].vertices = vertexFromAlphaPoint(hit);
-
+    m_nValidVertexCount = m_nVertexDataCount - 1;
 }
 
 ///
@@ -412,12 +447,11 @@ void CCProgressTimer::updateBar(void)
     }
 
 
+    updateColor();
+
     if (!m_bReverseDirection) {
-        if(!m_pVertexData) {
-            m_nVertexDataCount = 4;
-            m_pVertexData = (ccV2F_C4B_T2F*)malloc(m_nVertexDataCount * sizeof(ccV2F_C4B_T2F));
-            CCAssert( m_pVertexData, "CCProgressTimer. Not enough memory");
-        }
+        m_nVertexDataCount = 4;
+
         //    TOPLEFT
         m_pVertexData[0].texCoords = textureCoordFromAlphaPoint(ccp(min.x,max.y));
         m_pVertexData[0].vertices = vertexFromAlphaPoint(ccp(min.x,max.y));
@@ -434,10 +468,12 @@ void CCProgressTimer::updateBar(void)
         m_pVertexData[3].texCoords = textureCoordFromAlphaPoint(ccp(max.x,min.y));
         m_pVertexData[3].vertices = vertexFromAlphaPoint(ccp(max.x,min.y));
     } else {
-        if(!m_pVertexData) {
-            m_nVertexDataCount = 8;
-            m_pVertexData = (ccV2F_C4B_T2F*)malloc(m_nVertexDataCount * sizeof(ccV2F_C4B_T2F));
-            CCAssert( m_pVertexData, "CCProgressTimer. Not enough memory");
+        m_nVertexDataCount = 8;
+
+        //    The outer vertices don't move with the percentage
+        if(m_nValidVertexCount != 8) {
+            m_nValidVertexCount = 8;
+
             //    TOPLEFT 1
             m_pVertexData[0].texCoords = textureCoordFromAlphaPoint(ccp(0,1));
             m_pVertexData[0].vertices = vertexFromAlphaPoint(ccp(0,1));
@@ -471,7 +507,6 @@ void CCProgressTimer::updateBar(void)
         m_pVertexData[5].texCoords = textureCoordFromAlphaPoint(ccp(max.x,min.y));
         m_pVertexData[5].vertices = vertexFromAlphaPoint(ccp(max.x,min.y));
     }
-    updateColor();
 }
 
 CCPoint CCProgressTimer::boundaryTexCoord(char index)
@@ -488,9 +523,15 @@ CCPoint CCProgressTimer::boundaryTexCoord(char index)
 
 void CCProgressTimer::draw(void)
 {
-    if( ! m_pVertexData || ! m_pSprite)
+    if( ! m_nVertexDataCount || ! m_pSprite)
         return;
 
+    if (m_bRadialShaderMode && m_eType == kCCProgressTimerTypeRadial)
+    {
+        drawRadialShaderMode();
+        return;
+    }
+
     CC_NODE_DRAW_SETUP();
 
     ccGLBlendFunc( m_pSprite->getBlendFunc().src, m_pSprite->getBlendFunc().dst );
@@ -524,4 +565,309 @@ void CCProgressTimer::draw(void)
     CC_INCREMENT_GL_DRAWS(1);
 }
 
+void CCProgressTimer::drawRadialShaderMode(void)
+{
+    CCGLProgram *pProgram = CCShaderCache::sharedShaderCache()->programForKey(kCCShader_PositionTextureColorRadialProgress);
+    pProgram->use();
+    pProgram->setUniformsForBuiltins();
+
+    //    The unit square of the alpha points, from the BOTLEFT and TOPRIGHT vertices
+    ccVertex2F origin = m_pVertexData[1].vertices;
+    float width = m_pVertexData[2].vertices.x - origin.x;
+    float height = m_pVertexData[2].vertices.y - origin.y;
+    pProgram->setUniformLocationWith4f(pProgram->getUniformLocationForName(kCCUniformProgressRect),
+                                       origin.x, origin.y, width ? 1.f / width : 0.f, height ? 1.f / height : 0.f);
+    pProgram->setUniformLocationWith2f(pProgram->getUniformLocationForName(kCCUniformProgressMidpoint), m_tMidpoint.x, m_tMidpoint.y);
+
+    //    The angle is swept clockwise from 12 o'clock, counter-clockwise in reverse direction.
+    //    At 100% the angle is larger than a turn so that no fragment is discarded
+    float alpha = m_fPercentage / 100.f;
+    float sweep = alpha < 1.f ? 2.f*((float)M_PI) * alpha : 4.f*((float)M_PI);
+    pProgram->setUniformLocationWith2f(pProgram->getUniformLocationForName(kCCUniformProgressSweep), sweep, m_bReverseDirection ? -1.f : 1.f);
+
+    ccGLBlendFunc( m_pSprite->getBlendFunc().src, m_pSprite->getBlendFunc().dst );
+
+    ccGLEnableVertexAttribs(kCCVertexAttribFlag_PosColorTex );
+
+    ccGLBindTexture2D( m_pSprite->getTexture()->getName() );
+
+    glVertexAttribPointer( kCCVertexAttrib_Position, 2, GL_FLOAT, GL_FALSE, sizeof(m_pVertexData[0]) , &m_pVertexData[0].vertices);
+    glVertexAttribPointer( kCCVertexAttrib_TexCoords, 2, GL_FLOAT, GL_FALSE, sizeof(m_pVertexData[0]), &m_pVertexData[0].texCoords);
+    glVertexAttribPointer( kCCVertexAttrib_Color, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(m_pVertexData[0]), &m_pVertexData[0].colors);
+
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+
+    CC_INCREMENT_GL_DRAWS(1);
+}
+
+unsigned int CCProgressTimer::getTriangleVertexCount(void)
+{
+    if (! m_nVertexDataCount || ! m_pSprite)
+    {
+        return 0;
+    }
+
+    if (m_eType == kCCProgressTimerTypeRadial)
+    {
+        //    a fan, or a quad clipped by the shader that can't be batched
+        return m_bRadialShaderMode ? 0 : (m_nVertexDataCount - 2) * 3;
+    }
+
+    //    one or two strips of 4 vertices
+    return (m_nVertexDataCount / 4) * 6;
+}
+
+void CCProgressTimer::copyTriangles(ccV2F_C4B_T2F *pOut, const CCAffineTransform& transform)
+{
+    unsigned int uCount = getTriangleVertexCount();
+    if (! uCount)
+    {
+        return;
+    }
+
+    ccV2F_C4B_T2F vertices[kCCProgressTimerMaxVertices];
+    for (int i = 0; i < m_nVertexDataCount; ++i)
+    {
+        vertices[i] = m_pVertexData[i];
+        CCPoint pt = CCPointApplyAffineTransform(ccp(vertices[i].vertices.x, vertices[i].vertices.y), transform);
+        vertices[i].vertices = vertex2(pt.x, pt.y);
+    }
+
+    if (m_eType == kCCProgressTimerTypeRadial)
+    {
+        for (int i = 1; i < m_nVertexDataCount - 1; ++i)
+        {
+            *pOut++ = vertices[0];
+            *pOut++ = vertices[i];
+            *pOut++ = vertices[i+1];
+        }
+    }
+    else
+    {
+        for (int i = 0; i < m_nVertexDataCount; i += 4)
+        {
+            *pOut++ = vertices[i];
+            *pOut++ = vertices[i+1];
+            *pOut++ = vertices[i+2];
+            *pOut++ = vertices[i+2];
+            *pOut++ = vertices[i+1];
+            *pOut++ = vertices[i+3];
+        }
+    }
+}
+
+//
+// CCProgressTimerBatchNode
+//
+
+CCProgressTimerBatchNode::CCProgressTimerBatchNode()
+: m_pTexture(NULL)
+, m_uVbo(0)
+, m_uVboCapacity(0)
+{
+    m_tBlendFunc.src = CC_BLEND_SRC;
+    m_tBlendFunc.dst = CC_BLEND_DST;
+}
+
+CCProgressTimerBatchNode::~CCProgressTimerBatchNode()
+{
+    CC_SAFE_RELEASE(m_pTexture);
+
+    if (m_uVbo)
+    {
+        ccGLDeleteBuffers(1, &m_uVbo);
+    }
+
+    CCNotificationCenter::sharedNotificationCenter()->removeObserver(this, EVNET_COME_TO_FOREGROUND);
+}
+
+CCProgressTimerBatchNode* CCProgressTimerBatchNode::createWithTexture(CCTexture2D* texture)
+{
+    CCProgressTimerBatchNode *pRet = new CCProgressTimerBatchNode();
+    if (pRet && pRet->initWithTexture(texture))
+    {
+        pRet->autorelease();
+        return pRet;
+    }
+
+    CC_SAFE_DELETE(pRet);
+    return NULL;
+}
+
+CCProgressTimerBatchNode* CCProgressTimerBatchNode::create(const char* file)
+{
+    CCAssert(file != NULL, "Invalid filename");
+
+    CCTexture2D *texture = CCTextureCache::sharedTextureCache()->addImage(file);
+    return texture ? createWithTexture(texture) : NULL;
+}
+
+bool CCProgressTimerBatchNode::initWithTexture(CCTexture2D* texture)
+{
+    CCAssert(texture != NULL, "CCTexture2D must be non-NULL");
+
+    setTexture(texture);
+    setShaderProgram(CCShaderCache::sharedShaderCache()->programForKey(kCCShader_PositionTextureColor));
+
+    CCNotificationCenter::sharedNotificationCenter()->addObserver(this,
+                                                                  callfuncO_selector(CCProgressTimerBatchNode::listenBackToForeground),
+                                                                  EVNET_COME_TO_FOREGROUND,
+                                                                  NULL);
+    return true;
+}
+
+void CCProgressTimerBatchNode::addChild(CCNode *child)
+{
+    CCNode::addChild(child);
+}
+
+void CCProgressTimerBatchNode::addChild(CCNode *child, int zOrder)
+{
+    CCNode::addChild(child, zOrder);
+}
+
+void CCProgressTimerBatchNode::addChild(CCNode *child, int zOrder, int tag)
+{
+    CCProgressTimer *pTimer = dynamic_cast<CCProgressTimer*>(child);
+    CCAssert(pTimer != NULL, "CCProgressTimerBatchNode only supports CCProgressTimers as children");
+    CCAssert(pTimer->getSprite()->getTexture()->getName() == m_pTexture->getName(), "CCProgressTimer is not using the same texture id");
+    CCAssert(! pTimer->isRadialShaderMode(), "CCProgressTimer in radial shader mode can't be batched");
+    CC_UNUSED_PARAM(pTimer);
+
+    CCNode::addChild(child, zOrder, tag);
+}
+
+void CCProgressTimerBatchNode::visit()
+{
+    // like CCSpriteBatchNode, the children are not visited: draw() collects their vertices
+    if (! m_bVisible)
+    {
+        return;
+    }
+
+    kmGLPushMatrix();
+
+    if (m_pGrid && m_pGrid->isActive())
+    {
+        m_pGrid->beforeDraw();
+        transformAncestors();
+    }
+
+    sortAllChildren();
+    transform();
+
+    draw();
+
+    if (m_pGrid && m_pGrid->isActive())
+    {
+        m_pGrid->afterDraw(this);
+    }
+
+    kmGLPopMatrix();
+    setOrderOfArrival(0);
+}
+
+void CCProgressTimerBatchNode::draw()
+{
+    m_tVertices.clear();
+
+    if (! m_pChildren)
+    {
+        return;
+    }
+
+    CCObject* pObj = NULL;
+    CCARRAY_FOREACH(m_pChildren, pObj)
+    {
+        CCProgressTimer *pTimer = (CCProgressTimer*)pObj;
+        unsigned int uCount = pTimer->getTriangleVertexCount();
+        if (! pTimer->isVisible() || uCount == 0)
+        {
+            continue;
+        }
+
+        unsigned int uStart = m_tVertices.size();
+        m_tVertices.resize(uStart + uCount);
+        pTimer->copyTriangles(&m_tVertices[uStart], pTimer->nodeToParentTransform());
+    }
+
+    if (m_tVertices.empty())
+    {
+        return;
+    }
+
+    CC_NODE_DRAW_SETUP();
+
+    ccGLEnableVertexAttribs(kCCVertexAttribFlag_PosColorTex );
+    ccGLBlendFunc( m_tBlendFunc.src, m_tBlendFunc.dst );
+
+    ccGLBindTexture2D( m_pTexture->getName() );
+
+    if (! m_uVbo)
+    {
+        glGenBuffers(1, &m_uVbo);
+        m_uVboCapacity = 0;
+    }
+    ccGLBindBuffer(GL_ARRAY_BUFFER, m_uVbo);
+
+    // the vertices are streamed: the buffer only grows
+    unsigned int uCount = m_tVertices.size();
+    if (uCount > m_uVboCapacity)
+    {
+        m_uVboCapacity = MAX(uCount, m_uVboCapacity * 2);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(ccV2F_C4B_T2F) * m_uVboCapacity, NULL, GL_STREAM_DRAW);
+    }
+    glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(ccV2F_C4B_T2F) * uCount, &m_tVertices[0]);
+
+    glVertexAttribPointer(kCCVertexAttrib_Position, 2, GL_FLOAT, GL_FALSE, sizeof(ccV2F_C4B_T2F), (GLvoid *)offsetof(ccV2F_C4B_T2F, vertices));
+    glVertexAttribPointer(kCCVertexAttrib_TexCoords, 2, GL_FLOAT, GL_FALSE, sizeof(ccV2F_C4B_T2F), (GLvoid *)offsetof(ccV2F_C4B_T2F, texCoords));
+    glVertexAttribPointer(kCCVertexAttrib_Color, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(ccV2F_C4B_T2F), (GLvoid *)offsetof(ccV2F_C4B_T2F, colors));
+
+    glDrawArrays(GL_TRIANGLES, 0, (GLsizei)uCount);
+
+    ccGLBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    CC_INCREMENT_GL_DRAWS(1);
+}
+
+void CCProgressTimerBatchNode::listenBackToForeground(CCObject *obj)
+{
+    CC_UNUSED_PARAM(obj);
+
+    // the buffer was lost with the GL context
+    m_uVbo = 0;
+    m_uVboCapacity = 0;
+}
+
+CCTexture2D* CCProgressTimerBatchNode::getTexture(void)
+{
+    return m_pTexture;
+}
+
+void CCProgressTimerBatchNode::setTexture(CCTexture2D *texture)
+{
+    if (m_pTexture != texture)
+    {
+        CC_SAFE_RETAIN(texture);
+        CC_SAFE_RELEASE(m_pTexture);
+        m_pTexture = texture;
+    }
+
+    if (m_pTexture && ! m_pTexture->hasPremultipliedAlpha())
+    {
+        m_tBlendFunc.src = GL_SRC_ALPHA;
+        m_tBlendFunc.dst = GL_ONE_MINUS_SRC_ALPHA;
+    }
+}
+
+void CCProgressTimerBatchNode::setBlendFunc(ccBlendFunc blendFunc)
+{
+    m_tBlendFunc = blendFunc;
+}
+
+ccBlendFunc CCProgressTimerBatchNode::getBlendFunc(void)
+{
+    return m_tBlendFunc;
+}
+
 NS_CC_END
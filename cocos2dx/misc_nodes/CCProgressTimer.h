@@ -26,6 +26,7 @@ THE SOFTWARE.
 #define __MISC_NODE_CCPROGRESS_TIMER_H__
 
 #include "sprite_nodes/CCSprite.h"
+#include <vector>
 
 NS_CC_BEGIN
 
@@ -44,10 +45,17 @@ typedef enum {
     kCCProgressTimerTypeBar,
 } CCProgressTimerType;
 
+/** maximum number of vertices of a progress timer */
+#define kCCProgressTimerMaxVertices 8
+
 /**
  @brief CCProgressTimer is a subclass of CCNode.
  It renders the inner sprite according to the percentage.
  The progress can be Radial, Horizontal or vertical.
+
+ The vertices are kept in a buffer of kCCProgressTimerMaxVertices vertices allocated once. When the percentage
+ changes, a radial progress only computes the vertices of the edges swept since the last update and the
+ vertex on the edge at the percentage.
  @since v0.99.1
  */
 class CC_DLL CCProgressTimer : public CCNodeRGBA
@@ -80,7 +88,34 @@ public:
     virtual bool isOpacityModifyRGB(void);
     
     inline bool isReverseDirection() { return m_bReverseDirection; };
-    inline void setReverseDirection(bool value) { m_bReverseDirection = value; };
+    inline void setReverseDirection(bool value)
+    {
+        if (m_bReverseDirection != value)
+        {
+            m_bReverseDirection = value;
+            // computed again by the next update
+            m_nValidVertexCount = 0;
+        }
+    };
+
+    /** When enabled, a radial progress draws the whole quad of the sprite and its shader discards
+     the part that is not swept yet: a change of the percentage only changes a uniform.
+     A timer in this mode can't be drawn by a CCProgressTimerBatchNode.
+     @since v2.1.4
+     */
+    void setRadialShaderMode(bool bEnabled);
+    inline bool isRadialShaderMode(void) { return m_bRadialShaderMode; }
+
+    /** number of vertices of the timer drawn as GL_TRIANGLES, 0 if there is nothing to draw
+     @since v2.1.4
+     */
+    unsigned int getTriangleVertexCount(void);
+
+    /** copies the vertices of the timer as GL_TRIANGLES, with their positions transformed by transform.
+     pOut must have room for getTriangleVertexCount() vertices.
+     @since v2.1.4
+     */
+    void copyTriangles(ccV2F_C4B_T2F *pOut, const CCAffineTransform& transform);
 
 public:
     /** Creates a progress timer with the sprite as the shape the timer goes through */
@@ -93,6 +128,9 @@ protected:
     void updateRadial(void);
     void updateColor(void);
     CCPoint boundaryTexCoord(char index);
+    // the vertices must be computed again, nothing is drawn until the next update
+    void invalidateVertexData(void);
+    void drawRadialShaderMode(void);
 
 protected:
     CCProgressTimerType m_eType;
@@ -100,6 +138,11 @@ protected:
     CCSprite *m_pSprite;
     int m_nVertexDataCount;
     ccV2F_C4B_T2F *m_pVertexData;
+    /** number of vertices at the start of m_pVertexData that are up to date */
+    int m_nValidVertexCount;
+    /** color of the vertices */
+    ccColor4B m_tVertexColor;
+    bool m_bRadialShaderMode;
 
     /**
      *    Midpoint is used to modify the progress start position.
@@ -124,6 +167,51 @@ protected:
     bool m_bReverseDirection;
 };
 
+/** CCProgressTimerBatchNode draws the progress timers added to it as children with one draw call.
+ The sprites of the timers must use the texture of the batch node. The blend function of the batch node
+ is used, and the children of the timers are not drawn.
+ @since v2.1.4
+ */
+class CC_DLL CCProgressTimerBatchNode : public CCNode, public CCTextureProtocol
+{
+public:
+    CCProgressTimerBatchNode();
+    virtual ~CCProgressTimerBatchNode();
+
+    /** creates a batch node for the timers using the texture */
+    static CCProgressTimerBatchNode* createWithTexture(CCTexture2D* texture);
+    /** creates a batch node for the timers using the texture of the file */
+    static CCProgressTimerBatchNode* create(const char* file);
+
+    bool initWithTexture(CCTexture2D* texture);
+
+    virtual void addChild(CCNode *child);
+    virtual void addChild(CCNode *child, int zOrder);
+    virtual void addChild(CCNode *child, int zOrder, int tag);
+
+    virtual void visit();
+    virtual void draw();
+
+    virtual CCTexture2D* getTexture(void);
+    virtual void setTexture(CCTexture2D *texture);
+    virtual void setBlendFunc(ccBlendFunc blendFunc);
+    virtual ccBlendFunc getBlendFunc(void);
+
+    /** number of vertices drawn by the last draw */
+    inline unsigned int getVertexCount(void) { return (unsigned int)m_tVertices.size(); }
+
+    /** the vertex buffer object is created again when the GL context is recreated */
+    void listenBackToForeground(CCObject *obj);
+
+private:
+    CCTexture2D* m_pTexture;
+    ccBlendFunc m_tBlendFunc;
+    std::vector<ccV2F_C4B_T2F> m_tVertices;
+    GLuint m_uVbo;
+    /** number of vertices the vertex buffer object can hold */
+    unsigned int m_uVboCapacity;
+};
+
 // end of misc_nodes group
 /// @}
 
@@ -25,6 +25,7 @@ THE SOFTWARE.
 
 #include "CCConfiguration.h"
 #include "misc_nodes/CCRenderTexture.h"
+#include "misc_nodes/CCClipStack.h"
 #include "CCDirector.h"
 #include "platform/platform.h"
 #include "platform/CCImage.h"
@@ -361,6 +362,9 @@ bool CCRenderTexture::initWithWidthAndHeight(int w, int h, CCTexture2DPixelForma
 
 void CCRenderTexture::begin()
 {
+    // the clips of the scene don't apply to the texture
+    ccClipSuspend();
+
     kmGLMatrixMode(KM_GL_PROJECTION);
 	kmGLPushMatrix();
 	kmGLMatrixMode(KM_GL_MODELVIEW);
@@ -377,7 +381,7 @@ void CCRenderTexture::begin()
     float heightRatio = size.height / texSize.height;
 
     // Adjust the orthographic projection and viewport
-    glViewport(0, 0, (GLsizei)texSize.width, (GLsizei)texSize.height);
+    ccGLViewport(0, 0, (GLsizei)texSize.width, (GLsizei)texSize.height);
 
 
     kmMat4 orthoMatrix;
@@ -472,6 +476,8 @@ void CCRenderTexture::end()
 	kmGLPopMatrix();
 	kmGLMatrixMode(KM_GL_MODELVIEW);
 	kmGLPopMatrix();
+
+    ccClipResume();
 }
 
 void CCRenderTexture::clear(float r, float g, float b, float a)
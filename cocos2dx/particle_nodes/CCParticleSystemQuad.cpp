@@ -93,7 +93,7 @@ CCParticleSystemQuad::~CCParticleSystemQuad()
     {
         CC_SAFE_FREE(m_pQuads);
         CC_SAFE_FREE(m_pIndices);
-        glDeleteBuffers(2, &m_pBuffersVBO[0]);
+        ccGLDeleteBuffers(2, &m_pBuffersVBO[0]);
 #if CC_TEXTURE_ATLAS_USE_VAO
         glDeleteVertexArrays(1, &m_uVAOname);
 #endif
@@ -320,7 +320,7 @@ void CCParticleSystemQuad::updateQuadWithParticle(tCCParticle* particle, const C
 }
 void CCParticleSystemQuad::postStep()
 {
-    glBindBuffer(GL_ARRAY_BUFFER, m_pBuffersVBO[0]);
+    ccGLBindBuffer(GL_ARRAY_BUFFER, m_pBuffersVBO[0]);
 	
 	// Option 1: Sub Data
     glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(m_pQuads[0])*m_uTotalParticles, m_pQuads);
@@ -334,7 +334,7 @@ void CCParticleSystemQuad::postStep()
 	// memcpy(buf, m_pQuads, sizeof(m_pQuads[0])*m_uTotalParticles);
 	// glUnmapBuffer(GL_ARRAY_BUFFER);
     
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	ccGLBindBuffer(GL_ARRAY_BUFFER, 0);
     
 	CHECK_GL_ERROR_DEBUG();
 }
@@ -358,13 +358,13 @@ void CCParticleSystemQuad::draw()
     ccGLBindVAO(m_uVAOname);
 
 #if CC_REBIND_INDICES_BUFFER
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_pBuffersVBO[1]);
+    ccGLBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_pBuffersVBO[1]);
 #endif
 
     glDrawElements(GL_TRIANGLES, (GLsizei) m_uParticleIdx*6, GL_UNSIGNED_SHORT, 0);
 
 #if CC_REBIND_INDICES_BUFFER
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    ccGLBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 #endif
 
 #else
@@ -376,7 +376,7 @@ void CCParticleSystemQuad::draw()
 
     ccGLEnableVertexAttribs( kCCVertexAttribFlag_PosColorTex );
 
-    glBindBuffer(GL_ARRAY_BUFFER, m_pBuffersVBO[0]);
+    ccGLBindBuffer(GL_ARRAY_BUFFER, m_pBuffersVBO[0]);
     // vertices
     glVertexAttribPointer(kCCVertexAttrib_Position, 3, GL_FLOAT, GL_FALSE, kQuadSize, (GLvoid*) offsetof( ccV3F_C4B_T2F, vertices));
     // colors
@@ -384,12 +384,12 @@ void CCParticleSystemQuad::draw()
     // tex coords
     glVertexAttribPointer(kCCVertexAttrib_TexCoords, 2, GL_FLOAT, GL_FALSE, kQuadSize, (GLvoid*) offsetof( ccV3F_C4B_T2F, texCoords));
     
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_pBuffersVBO[1]);
+    ccGLBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_pBuffersVBO[1]);
 
     glDrawElements(GL_TRIANGLES, (GLsizei) m_uParticleIdx*6, GL_UNSIGNED_SHORT, 0);
 
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    ccGLBindBuffer(GL_ARRAY_BUFFER, 0);
+    ccGLBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 
 #endif
 
@@ -468,7 +468,7 @@ void CCParticleSystemQuad::setTotalParticles(unsigned int tp)
 void CCParticleSystemQuad::setupVBOandVAO()
 {
     // clean VAO
-    glDeleteBuffers(2, &m_pBuffersVBO[0]);
+    ccGLDeleteBuffers(2, &m_pBuffersVBO[0]);
     glDeleteVertexArrays(1, &m_uVAOname);
     
     glGenVertexArrays(1, &m_uVAOname);
@@ -478,7 +478,7 @@ void CCParticleSystemQuad::setupVBOandVAO()
 
     glGenBuffers(2, &m_pBuffersVBO[0]);
 
-    glBindBuffer(GL_ARRAY_BUFFER, m_pBuffersVBO[0]);
+    ccGLBindBuffer(GL_ARRAY_BUFFER, m_pBuffersVBO[0]);
     glBufferData(GL_ARRAY_BUFFER, sizeof(m_pQuads[0]) * m_uTotalParticles, m_pQuads, GL_DYNAMIC_DRAW);
 
     // vertices
@@ -493,13 +493,13 @@ void CCParticleSystemQuad::setupVBOandVAO()
     glEnableVertexAttribArray(kCCVertexAttrib_TexCoords);
     glVertexAttribPointer(kCCVertexAttrib_TexCoords, 2, GL_FLOAT, GL_FALSE, kQuadSize, (GLvoid*) offsetof( ccV3F_C4B_T2F, texCoords));
 
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_pBuffersVBO[1]);
+    ccGLBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_pBuffersVBO[1]);
     glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(m_pIndices[0]) * m_uTotalParticles * 6, m_pIndices, GL_STATIC_DRAW);
 
     // Must unbind the VAO before changing the element buffer.
     ccGLBindVAO(0);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    ccGLBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    ccGLBindBuffer(GL_ARRAY_BUFFER, 0);
 
     CHECK_GL_ERROR_DEBUG();
 }
@@ -507,17 +507,17 @@ void CCParticleSystemQuad::setupVBOandVAO()
 
 void CCParticleSystemQuad::setupVBO()
 {
-    glDeleteBuffers(2, &m_pBuffersVBO[0]);
+    ccGLDeleteBuffers(2, &m_pBuffersVBO[0]);
     
     glGenBuffers(2, &m_pBuffersVBO[0]);
 
-    glBindBuffer(GL_ARRAY_BUFFER, m_pBuffersVBO[0]);
+    ccGLBindBuffer(GL_ARRAY_BUFFER, m_pBuffersVBO[0]);
     glBufferData(GL_ARRAY_BUFFER, sizeof(m_pQuads[0]) * m_uTotalParticles, m_pQuads, GL_DYNAMIC_DRAW);
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    ccGLBindBuffer(GL_ARRAY_BUFFER, 0);
 
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_pBuffersVBO[1]);
+    ccGLBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_pBuffersVBO[1]);
     glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(m_pIndices[0]) * m_uTotalParticles * 6, m_pIndices, GL_STATIC_DRAW);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    ccGLBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 
     CHECK_GL_ERROR_DEBUG();
 }
@@ -590,7 +590,7 @@ void CCParticleSystemQuad::setBatchNode(CCParticleBatchNode * batchNode)
             CC_SAFE_FREE(m_pQuads);
             CC_SAFE_FREE(m_pIndices);
 
-            glDeleteBuffers(2, &m_pBuffersVBO[0]);
+            ccGLDeleteBuffers(2, &m_pBuffersVBO[0]);
 #if CC_TEXTURE_ATLAS_USE_VAO
             glDeleteVertexArrays(1, &m_uVAOname);
 #endif
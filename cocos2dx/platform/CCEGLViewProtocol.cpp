@@ -2,6 +2,7 @@
 #include "touch_dispatcher/CCTouchDispatcher.h"
 #include "touch_dispatcher/CCTouch.h"
 #include "CCDirector.h"
+#include "shaders/ccGLStateCache.h"
 #include "cocoa/CCSet.h"
 #include "cocoa/CCDictionary.h"
 #include "cocoa/CCInteger.h"
@@ -150,7 +151,7 @@ void CCEGLViewProtocol::setTouchDelegate(EGLTouchDelegate * pDelegate)
 
 void CCEGLViewProtocol::setViewPortInPoints(float x , float y , float w , float h)
 {
-    glViewport((GLint)(x * m_fScaleX + m_obViewPortRect.origin.x),
+    ccGLViewport((GLint)(x * m_fScaleX + m_obViewPortRect.origin.x),
                (GLint)(y * m_fScaleY + m_obViewPortRect.origin.y),
                (GLsizei)(w * m_fScaleX),
                (GLsizei)(h * m_fScaleY));
@@ -158,7 +159,7 @@ void CCEGLViewProtocol::setViewPortInPoints(float x , float y , float w , float
 
 void CCEGLViewProtocol::setScissorInPoints(float x , float y , float w , float h)
 {
-    glScissor((GLint)(x * m_fScaleX + m_obViewPortRect.origin.x),
+    ccGLScissor((GLint)(x * m_fScaleX + m_obViewPortRect.origin.x),
               (GLint)(y * m_fScaleY + m_obViewPortRect.origin.y),
               (GLsizei)(w * m_fScaleX),
               (GLsizei)(h * m_fScaleY));
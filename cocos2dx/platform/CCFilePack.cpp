@@ -0,0 +1,345 @@
+/****************************************************************************
+Copyright (c) 2013 cocos2d-x.org
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+#include "CCFilePack.h"
+#include "CCFileUtils.h"
+#include "ccMacros.h"
+#include <zlib.h>
+#include <string.h>
+
+#if (CC_TARGET_PLATFORM == CC_PLATFORM_WIN32)
+    #include <windows.h>
+    #define CC_FILE_PACK_USE_MMAP   0
+    #define CC_FILE_PACK_USE_WIN32_MAPPING  1
+#elif (CC_TARGET_PLATFORM == CC_PLATFORM_NACL) || (CC_TARGET_PLATFORM == CC_PLATFORM_MARMALADE)
+    #define CC_FILE_PACK_USE_MMAP   0
+    #define CC_FILE_PACK_USE_WIN32_MAPPING  0
+#else
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <fcntl.h>
+    #include <unistd.h>
+    #define CC_FILE_PACK_USE_MMAP   1
+    #define CC_FILE_PACK_USE_WIN32_MAPPING  0
+#endif
+
+NS_CC_BEGIN
+
+// CCFileView
+
+CCFileView::CCFileView()
+: m_pBytes(NULL)
+, m_uSize(0)
+, m_pOwnedBuffer(NULL)
+{
+}
+
+void CCFileView::initWithBuffer(unsigned char *pBuffer, unsigned long uSize)
+{
+    m_pOwnedBuffer = pBuffer;
+    m_pBytes = pBuffer;
+    m_uSize = pBuffer ? uSize : 0;
+}
+
+void CCFileView::initWithMappedBytes(const unsigned char *pBytes, unsigned long uSize)
+{
+    m_pOwnedBuffer = NULL;
+    m_pBytes = pBytes;
+    m_uSize = pBytes ? uSize : 0;
+}
+
+void CCFileView::release()
+{
+    CC_SAFE_DELETE_ARRAY(m_pOwnedBuffer);
+    m_pBytes = NULL;
+    m_uSize = 0;
+}
+
+// CCFilePack
+
+#if CC_FILE_PACK_USE_WIN32_MAPPING
+typedef struct _Win32Mapping
+{
+    HANDLE file;
+    HANDLE mapping;
+} Win32Mapping;
+#endif
+
+CCFilePack::CCFilePack()
+: m_pData(NULL)
+, m_uSize(0)
+, m_pMapping(NULL)
+, m_pHeader(NULL)
+, m_pEntries(NULL)
+{
+}
+
+CCFilePack::~CCFilePack()
+{
+    close();
+}
+
+void CCFilePack::close()
+{
+    if (m_pMapping)
+    {
+#if CC_FILE_PACK_USE_MMAP
+        munmap((void*)m_pData, m_uSize);
+#elif CC_FILE_PACK_USE_WIN32_MAPPING
+        Win32Mapping *pMapping = (Win32Mapping*)m_pMapping;
+        UnmapViewOfFile(m_pData);
+        CloseHandle(pMapping->mapping);
+        CloseHandle(pMapping->file);
+        delete pMapping;
+#endif
+        m_pMapping = NULL;
+    }
+    else
+    {
+        unsigned char *pData = (unsigned char*)m_pData;
+        CC_SAFE_DELETE_ARRAY(pData);
+    }
+
+    m_pData = NULL;
+    m_uSize = 0;
+    m_pHeader = NULL;
+    m_pEntries = NULL;
+}
+
+bool CCFilePack::initWithFile(const char *pszPath)
+{
+    close();
+    m_strPath = pszPath;
+
+#if CC_FILE_PACK_USE_MMAP
+    int fd = open(pszPath, O_RDONLY);
+    if (fd >= 0)
+    {
+        struct stat st;
+        if (fstat(fd, &st) == 0 && st.st_size > 0)
+        {
+            void *pData = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+            if (pData != MAP_FAILED)
+            {
+                m_pData = (const unsigned char*)pData;
+                m_uSize = st.st_size;
+                // any non NULL value, munmap only needs the address and size
+                m_pMapping = pData;
+            }
+        }
+        // the mapping stays valid after the descriptor is closed
+        ::close(fd);
+    }
+#elif CC_FILE_PACK_USE_WIN32_MAPPING
+    HANDLE hFile = CreateFileA(pszPath, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (hFile != INVALID_HANDLE_VALUE)
+    {
+        HANDLE hMapping = CreateFileMappingA(hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+        void *pData = hMapping ? MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0) : NULL;
+        if (pData)
+        {
+            Win32Mapping *pMapping = new Win32Mapping();
+            pMapping->file = hFile;
+            pMapping->mapping = hMapping;
+            m_pData = (const unsigned char*)pData;
+            m_uSize = GetFileSize(hFile, NULL);
+            m_pMapping = pMapping;
+        }
+        else
+        {
+            if (hMapping)
+            {
+                CloseHandle(hMapping);
+            }
+            CloseHandle(hFile);
+        }
+    }
+#endif
+
+    if (! m_pData)
+    {
+        // not a plain file (e.g. inside the apk) or no mapping on this platform
+        unsigned long uSize = 0;
+        m_pData = CCFileUtils::sharedFileUtils()->getFileData(pszPath, "rb", &uSize);
+        m_uSize = uSize;
+    }
+
+    if (! m_pData || ! validate())
+    {
+        CCLOG("cocos2d: CCFilePack: %s is not a valid file pack", pszPath);
+        close();
+        return false;
+    }
+
+    return true;
+}
+
+bool CCFilePack::validate()
+{
+    bool bRet = false;
+    do
+    {
+        CC_BREAK_IF(m_uSize < sizeof(ccFilePackHeader));
+
+        const ccFilePackHeader *pHeader = (const ccFilePackHeader*)m_pData;
+        CC_BREAK_IF(memcmp(pHeader->magic, CC_FILE_PACK_MAGIC, 4) != 0);
+        CC_BREAK_IF(pHeader->version != CC_FILE_PACK_VERSION);
+        // written so that nothing overflows when unsigned long is 32 bits
+        CC_BREAK_IF(pHeader->indexOffset > m_uSize);
+        CC_BREAK_IF(pHeader->entryCount > (m_uSize - pHeader->indexOffset) / sizeof(ccFilePackEntry));
+        CC_BREAK_IF(pHeader->namesOffset > m_uSize);
+        CC_BREAK_IF(pHeader->namesSize > m_uSize - pHeader->namesOffset);
+
+        const ccFilePackEntry *pEntries = (const ccFilePackEntry*)(m_pData + pHeader->indexOffset);
+        unsigned int i = 0;
+        for (; i < pHeader->entryCount; ++i)
+        {
+            const ccFilePackEntry *pEntry = pEntries + i;
+            CC_BREAK_IF(pEntry->nameOffset >= pHeader->namesSize);
+            CC_BREAK_IF(pEntry->nameLength >= pHeader->namesSize - pEntry->nameOffset);
+            CC_BREAK_IF(pEntry->offset > m_uSize);
+            CC_BREAK_IF(pEntry->compressedSize > m_uSize - pEntry->offset);
+            // views on uncompressed entries expose size bytes of the pack
+            CC_BREAK_IF(pEntry->compression == kCCFilePackCompressionNone && pEntry->size != pEntry->compressedSize);
+            // getFileData() allocates size + 1 bytes
+            CC_BREAK_IF(pEntry->size == 0xffffffff);
+        }
+        CC_BREAK_IF(i != pHeader->entryCount);
+
+        m_pHeader = pHeader;
+        m_pEntries = pEntries;
+        bRet = true;
+    } while (0);
+
+    return bRet;
+}
+
+unsigned int CCFilePack::getEntryCount() const
+{
+    return m_pHeader ? m_pHeader->entryCount : 0;
+}
+
+unsigned int CCFilePack::hashName(const char *pszName, unsigned int uLength)
+{
+    // FNV-1a
+    unsigned int hash = 2166136261u;
+    for (unsigned int i = 0; i < uLength; ++i)
+    {
+        hash ^= (unsigned char)pszName[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+const char* CCFilePack::getEntryName(const ccFilePackEntry *pEntry) const
+{
+    return (const char*)(m_pData + m_pHeader->namesOffset + pEntry->nameOffset);
+}
+
+const ccFilePackEntry* CCFilePack::findEntry(const char *pszFileName) const
+{
+    if (! m_pEntries || ! pszFileName)
+    {
+        return NULL;
+    }
+
+    unsigned int uLength = strlen(pszFileName);
+    unsigned int hash = hashName(pszFileName, uLength);
+
+    // lower bound of the hash
+    unsigned int lo = 0;
+    unsigned int hi = m_pHeader->entryCount;
+    while (lo < hi)
+    {
+        unsigned int mid = lo + (hi - lo) / 2;
+        if (m_pEntries[mid].hash < hash)
+        {
+            lo = mid + 1;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+
+    for (unsigned int i = lo; i < m_pHeader->entryCount && m_pEntries[i].hash == hash; ++i)
+    {
+        const ccFilePackEntry *pEntry = m_pEntries + i;
+        if (pEntry->nameLength == uLength && memcmp(getEntryName(pEntry), pszFileName, uLength) == 0)
+        {
+            return pEntry;
+        }
+    }
+
+    return NULL;
+}
+
+bool CCFilePack::getFileView(const ccFilePackEntry *pEntry, CCFileView& view) const
+{
+    if (pEntry->compression == kCCFilePackCompressionNone)
+    {
+        view.initWithMappedBytes(m_pData + pEntry->offset, pEntry->size);
+        return true;
+    }
+
+    unsigned long uSize = 0;
+    unsigned char *pBuffer = getFileData(pEntry, &uSize);
+    view.initWithBuffer(pBuffer, uSize);
+    return pBuffer != NULL;
+}
+
+unsigned char* CCFilePack::getFileData(const ccFilePackEntry *pEntry, unsigned long *pSize) const
+{
+    *pSize = 0;
+    // one extra byte, so that text files can be parsed in place
+    unsigned char *pBuffer = new unsigned char[pEntry->size + 1];
+    pBuffer[pEntry->size] = 0;
+
+    switch (pEntry->compression)
+    {
+    case kCCFilePackCompressionNone:
+        memcpy(pBuffer, m_pData + pEntry->offset, pEntry->size);
+        break;
+    case kCCFilePackCompressionZlib:
+        {
+            uLongf uDestLen = pEntry->size;
+            if (uncompress(pBuffer, &uDestLen, m_pData + pEntry->offset, pEntry->compressedSize) != Z_OK || uDestLen != pEntry->size)
+            {
+                CCLOG("cocos2d: CCFilePack: can not inflate %s", getEntryName(pEntry));
+                CC_SAFE_DELETE_ARRAY(pBuffer);
+                return NULL;
+            }
+        }
+        break;
+    default:
+        CCLOG("cocos2d: CCFilePack: unsupported compression %u for %s", pEntry->compression, getEntryName(pEntry));
+        CC_SAFE_DELETE_ARRAY(pBuffer);
+        return NULL;
+    }
+
+    *pSize = pEntry->size;
+    return pBuffer;
+}
+
+NS_CC_END
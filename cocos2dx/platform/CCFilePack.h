@@ -0,0 +1,158 @@
+/****************************************************************************
+Copyright (c) 2013 cocos2d-x.org
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+#ifndef __CC_FILE_PACK_H__
+#define __CC_FILE_PACK_H__
+
+#include "CCPlatformMacros.h"
+#include <string>
+
+NS_CC_BEGIN
+
+/**
+ * @addtogroup platform
+ * @{
+ */
+
+/* File pack layout, all integers are little endian. Packs are built by tools/file-pack/ccpack.py.
+ *
+ *  ccFilePackHeader
+ *  ccFilePackEntry[entryCount]     at indexOffset, sorted by (hash, name)
+ *  names                           at namesOffset, NUL terminated
+ *  entry data                      each entry starts at a multiple of CC_FILE_PACK_ALIGNMENT
+ */
+#define CC_FILE_PACK_MAGIC          "CCPK"
+#define CC_FILE_PACK_VERSION        1
+#define CC_FILE_PACK_ALIGNMENT      16
+
+enum {
+    kCCFilePackCompressionNone = 0,
+    kCCFilePackCompressionZlib = 1,
+};
+
+typedef struct _ccFilePackHeader
+{
+    char            magic[4];
+    unsigned int    version;
+    unsigned int    entryCount;
+    unsigned int    indexOffset;
+    unsigned int    namesOffset;
+    unsigned int    namesSize;
+    unsigned int    reserved[2];
+} ccFilePackHeader;
+
+typedef struct _ccFilePackEntry
+{
+    // FNV-1a hash of the name
+    unsigned int    hash;
+    unsigned int    nameOffset;
+    unsigned int    nameLength;
+    unsigned int    compression;
+    unsigned int    offset;
+    unsigned int    compressedSize;
+    unsigned int    size;
+    unsigned int    reserved;
+} ccFilePackEntry;
+
+/** @brief Read-only view on the contents of a file.
+
+ Views on uncompressed entries of a file pack point straight into the mapped pack,
+ other views own a buffer. Call release() exactly once when done with the data.
+ @since v2.1.4
+ */
+class CC_DLL CCFileView
+{
+public:
+    CCFileView();
+
+    /** Takes ownership of a buffer allocated with new[] */
+    void initWithBuffer(unsigned char *pBuffer, unsigned long uSize);
+    /** Points at memory that stays valid while the file pack is mounted */
+    void initWithMappedBytes(const unsigned char *pBytes, unsigned long uSize);
+
+    const unsigned char* getBytes() const { return m_pBytes; }
+    unsigned long getSize() const { return m_uSize; }
+    bool isNull() const { return m_pBytes == NULL; }
+    /** true if no copy of the data was made */
+    bool isMapped() const { return m_pBytes != NULL && m_pOwnedBuffer == NULL; }
+
+    void release();
+
+private:
+    const unsigned char *m_pBytes;
+    unsigned long m_uSize;
+    unsigned char *m_pOwnedBuffer;
+};
+
+/** @brief A read-only archive of files, mapped into memory.
+
+ Lookups are lock free, so files can be read from any thread while the pack is mounted.
+ @since v2.1.4
+ */
+class CC_DLL CCFilePack
+{
+public:
+    CCFilePack();
+    ~CCFilePack();
+
+    /** Maps the pack at pszPath. Packs that can't be mapped (e.g. inside the apk) are read into memory. */
+    bool initWithFile(const char *pszPath);
+
+    const std::string& getPath() const { return m_strPath; }
+    unsigned int getEntryCount() const;
+
+    /** Returns the entry of a file, or NULL if the pack doesn't contain it */
+    const ccFilePackEntry* findEntry(const char *pszFileName) const;
+    /** Name of an entry, NUL terminated */
+    const char* getEntryName(const ccFilePackEntry *pEntry) const;
+
+    /** Gets a view on the data of an entry. Compressed entries are inflated into a new buffer */
+    bool getFileView(const ccFilePackEntry *pEntry, CCFileView& view) const;
+
+    /** Gets a copy of the data of an entry.
+     @warning Recall: you are responsible for calling delete[] on any Non-NULL pointer returned.
+     */
+    unsigned char* getFileData(const ccFilePackEntry *pEntry, unsigned long *pSize) const;
+
+    static unsigned int hashName(const char *pszName, unsigned int uLength);
+
+private:
+    bool validate();
+    void close();
+
+    std::string m_strPath;
+    const unsigned char *m_pData;
+    unsigned long m_uSize;
+    // platform handle of the mapping, NULL if m_pData was read into memory
+    void *m_pMapping;
+    const ccFilePackHeader *m_pHeader;
+    const ccFilePackEntry *m_pEntries;
+};
+
+// end of platform group
+/// @}
+
+NS_CC_END
+
+#endif    // __CC_FILE_PACK_H__
@@ -24,11 +24,21 @@ THE SOFTWARE.
 
 #include "CCFileUtils.h"
 #include "CCDirector.h"
+#include "CCScheduler.h"
+#include "platform/platform.h"
+#include "platform/CCThread.h"
+#include "cocoa/CCArray.h"
 #include "cocoa/CCDictionary.h"
 #include "cocoa/CCString.h"
-#include "CCSAXParser.h"
+#include "CCPlistParser.h"
 #include "support/zip_support/unzip.h"
-#include <stack>
+#include "support/zip_support/ZipUtils.h"
+#include <map>
+#include <deque>
+#include <algorithm>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <pthread.h>
 
 using namespace std;
 
@@ -36,404 +46,739 @@ using namespace std;
 
 NS_CC_BEGIN
 
-typedef enum 
+CCDictionary* CCFileUtils::createCCDictionaryWithContentsOfFile(const std::string& filename)
 {
-    SAX_NONE = 0,
-    SAX_KEY,
-    SAX_DICT,
-    SAX_INT,
-    SAX_REAL,
-    SAX_STRING,
-    SAX_ARRAY
-}CCSAXState;
+    std::string fullPath = fullPathForFilename(filename.c_str());
+    unsigned long uSize = 0;
+    unsigned char* pBuffer = getFileData(fullPath.c_str(), "rt", &uSize);
+    CCPlistParser parser;
+    CCDictionary* pRet = parser.dictionaryWithData((const char*)pBuffer, uSize);
+    CC_SAFE_DELETE_ARRAY(pBuffer);
+    return pRet;
+}
 
-typedef enum
+CCArray* CCFileUtils::createCCArrayWithContentsOfFile(const std::string& filename)
 {
-    SAX_RESULT_NONE = 0,
-    SAX_RESULT_DICT,
-    SAX_RESULT_ARRAY
-}CCSAXResult;
+    std::string fullPath = fullPathForFilename(filename.c_str());
+    unsigned long uSize = 0;
+    unsigned char* pBuffer = getFileData(fullPath.c_str(), "rt", &uSize);
+    CCPlistParser parser;
+    CCArray* pRet = parser.arrayWithData((const char*)pBuffer, uSize);
+    CC_SAFE_DELETE_ARRAY(pBuffer);
+    return pRet;
+}
 
-class CCDictMaker : public CCSAXDelegator
+CCDictionary* CCFileUtils::createCCDictionaryWithData(const char* pData, unsigned long uSize)
 {
-public:
-    CCSAXResult m_eResultType;
-    CCArray* m_pRootArray;
-    CCDictionary *m_pRootDict;
-    CCDictionary *m_pCurDict;
-    std::stack<CCDictionary*> m_tDictStack;
-    std::string m_sCurKey;   ///< parsed key
-    std::string m_sCurValue; // parsed value
-    CCSAXState m_tState;
-    CCArray* m_pArray;
-
-    std::stack<CCArray*> m_tArrayStack;
-    std::stack<CCSAXState>  m_tStateStack;
+    CCPlistParser parser;
+    return parser.dictionaryWithData(pData, uSize);
+}
 
-public:
-    CCDictMaker()        
-        : m_eResultType(SAX_RESULT_NONE),
-          m_pRootArray(NULL), 
-          m_pRootDict(NULL),
-          m_pCurDict(NULL),
-          m_tState(SAX_NONE),
-          m_pArray(NULL)
+#else
+NS_CC_BEGIN
+
+/* The subclass CCFileUtilsIOS and CCFileUtilsMac should override these two method. */
+CCDictionary* CCFileUtils::createCCDictionaryWithContentsOfFile(const std::string& filename) {return NULL;}
+CCArray* CCFileUtils::createCCArrayWithContentsOfFile(const std::string& filename) {return NULL;}
+CCDictionary* CCFileUtils::createCCDictionaryWithData(const char* pData, unsigned long uSize) {return NULL;}
+
+#endif /* (CC_TARGET_PLATFORM != CC_PLATFORM_IOS) && (CC_TARGET_PLATFORM != CC_PLATFORM_MAC) */
+
+
+CCFileUtils* CCFileUtils::s_sharedFileUtils = NULL;
+
+static void stopFileDataThreads();
+
+void CCFileUtils::purgeFileUtils()
+{
+    if (s_sharedFileUtils)
     {
+        s_sharedFileUtils->cancelAllFileDataAsync(NULL);
     }
+    // the I/O threads read through the instance, they must be gone before it is deleted
+    stopFileDataThreads();
+    CC_SAFE_DELETE(s_sharedFileUtils);
+}
 
-    ~CCDictMaker()
+CCFileUtils::CCFileUtils()
+: m_pFilenameLookupDict(NULL)
+{
+}
+
+CCFileUtils::~CCFileUtils()
+{
+    cancelAllFileDataAsync(NULL);
+    CC_SAFE_RELEASE(m_pFilenameLookupDict);
+    removeAllFilePacks();
+}
+
+bool CCFileUtils::init()
+{
+    m_searchPathArray.push_back(m_strDefaultResRootPath);
+    m_searchResolutionsOrderArray.push_back("");
+    return true;
+}
+
+// Archives read through getFileDataFromZip() stay mounted, so that their central directory
+// is parsed only once instead of on every read. An archive that changed on disk is mounted again.
+// A mounted archive is reference counted: the table holds one reference and every reader holds
+// another one while it reads, so a remount or purge never deletes an archive that is still in use.
+typedef struct _MountedZipFile
+{
+    ZipFile      *zipFile;
+    time_t       modificationTime;
+    off_t        size;
+    unsigned int referenceCount;
+} MountedZipFile;
+
+typedef std::map<std::string, MountedZipFile*> MountedZipFiles;
+static MountedZipFiles s_mountedZipFiles;
+static pthread_mutex_t s_mountedZipFilesMutex = PTHREAD_MUTEX_INITIALIZER;
+
+// must be called with s_mountedZipFilesMutex locked
+static void releaseMountedZipFileLocked(MountedZipFile *pMounted)
+{
+    CCAssert(pMounted->referenceCount > 0, "CCFileUtils: mounted zip file released too often");
+    if (--pMounted->referenceCount == 0)
     {
+        CC_SAFE_DELETE(pMounted->zipFile);
+        delete pMounted;
     }
+}
 
-    CCDictionary* dictionaryWithContentsOfFile(const char *pFileName)
+// returns the mounted archive retained; give it back with releaseMountedZipFile()
+static MountedZipFile* mountZipFile(const char* pszZipFilePath)
+{
+    struct stat st;
+    if (stat(pszZipFilePath, &st) != 0)
     {
-        m_eResultType = SAX_RESULT_DICT;
-        CCSAXParser parser;
+        return NULL;
+    }
 
-        if (false == parser.init("UTF-8"))
+    MountedZipFile *pMounted = NULL;
+    pthread_mutex_lock(&s_mountedZipFilesMutex);
+    MountedZipFiles::iterator it = s_mountedZipFiles.find(pszZipFilePath);
+    if (it != s_mountedZipFiles.end()
+        && it->second->modificationTime == st.st_mtime
+        && it->second->size == st.st_size)
+    {
+        pMounted = it->second;
+    }
+    else
+    {
+        if (it != s_mountedZipFiles.end())
         {
-            return NULL;
+            // readers of the old archive keep it alive until they are done
+            releaseMountedZipFileLocked(it->second);
         }
-        parser.setDelegator(this);
 
-        parser.parse(pFileName);
-        return m_pRootDict;
+        pMounted = new MountedZipFile();
+        pMounted->zipFile = new ZipFile(pszZipFilePath);
+        pMounted->modificationTime = st.st_mtime;
+        pMounted->size = st.st_size;
+        pMounted->referenceCount = 1;
+        s_mountedZipFiles[pszZipFilePath] = pMounted;
     }
+    ++pMounted->referenceCount;
+    pthread_mutex_unlock(&s_mountedZipFilesMutex);
+
+    return pMounted;
+}
 
-    CCArray* arrayWithContentsOfFile(const char* pFileName)
+static void releaseMountedZipFile(MountedZipFile *pMounted)
+{
+    pthread_mutex_lock(&s_mountedZipFilesMutex);
+    releaseMountedZipFileLocked(pMounted);
+    pthread_mutex_unlock(&s_mountedZipFilesMutex);
+}
+
+static void unmountAllZipFiles()
+{
+    pthread_mutex_lock(&s_mountedZipFilesMutex);
+    for (MountedZipFiles::iterator it = s_mountedZipFiles.begin(); it != s_mountedZipFiles.end(); ++it)
     {
-        m_eResultType = SAX_RESULT_ARRAY;
-        CCSAXParser parser;
+        releaseMountedZipFileLocked(it->second);
+    }
+    s_mountedZipFiles.clear();
+    pthread_mutex_unlock(&s_mountedZipFilesMutex);
+}
 
-        if (false == parser.init("UTF-8"))
-        {
-            return NULL;
-        }
-        parser.setDelegator(this);
+void CCFileUtils::purgeCachedEntries()
+{
+    m_fullPathCache.clear();
+    m_missingFileCache.clear();
+    unmountAllZipFiles();
+}
+
+unsigned char* CCFileUtils::getFileData(const char* pszFileName, const char* pszMode, unsigned long * pSize)
+{
+    unsigned char * pBuffer = NULL;
+    CCAssert(pszFileName != NULL && pSize != NULL && pszMode != NULL, "Invalid parameters.");
+    *pSize = 0;
+    do
+    {
+        // read the file from hardware
+        std::string fullPath = fullPathForFilename(pszFileName);
+        FILE *fp = fopen(fullPath.c_str(), pszMode);
+        CC_BREAK_IF(!fp);
+        
+        fseek(fp,0,SEEK_END);
+        *pSize = ftell(fp);
+        fseek(fp,0,SEEK_SET);
+        pBuffer = new unsigned char[*pSize];
+        *pSize = fread(pBuffer,sizeof(unsigned char), *pSize,fp);
+        fclose(fp);
+    } while (0);
+
+    if (! pBuffer && ! m_filePacks.empty())
+    {
+        pBuffer = getFileDataFromFilePacks(pszFileName, pSize);
+    }
+    
+    if (! pBuffer)
+    {
+        std::string msg = "Get data from file(";
+        msg.append(pszFileName).append(") failed!");
+        
+        CCLOG(msg.c_str());
+    }
+    return pBuffer;
+}
+
+unsigned char* CCFileUtils::getFileDataFromFullPath(const char* pszFullPath, unsigned long * pSize)
+{
+    unsigned char * pBuffer = NULL;
+    *pSize = 0;
+    do
+    {
+        FILE *fp = fopen(pszFullPath, "rb");
+        CC_BREAK_IF(!fp);
+
+        fseek(fp,0,SEEK_END);
+        *pSize = ftell(fp);
+        fseek(fp,0,SEEK_SET);
+        pBuffer = new unsigned char[*pSize];
+        *pSize = fread(pBuffer,sizeof(unsigned char), *pSize,fp);
+        fclose(fp);
+    } while (0);
+
+    return pBuffer;
+}
+
+unsigned char* CCFileUtils::getFileDataFromZip(const char* pszZipFilePath, const char* pszFileName, unsigned long * pSize)
+{
+    unsigned char * pBuffer = NULL;
+    *pSize = 0;
+
+    do 
+    {
+        CC_BREAK_IF(!pszZipFilePath || !pszFileName);
+        CC_BREAK_IF(strlen(pszZipFilePath) == 0);
+
+        MountedZipFile *pMounted = mountZipFile(pszZipFilePath);
+        CC_BREAK_IF(!pMounted);
+
+        pBuffer = pMounted->zipFile->getFileData(pszFileName, pSize);
+        releaseMountedZipFile(pMounted);
+    } while (0);
+
+    return pBuffer;
+}
+
+bool CCFileUtils::addFilePack(const char* pszPackPath)
+{
+    CCAssert(pszPackPath != NULL, "CCFileUtils: Invalid path");
 
-        parser.parse(pFileName);
-        return m_pArray;
+    std::string fullPath = fullPathForFilename(pszPackPath);
+    CCFilePack *pFilePack = new CCFilePack();
+    if (! pFilePack->initWithFile(fullPath.c_str()))
+    {
+        delete pFilePack;
+        return false;
     }
 
-    void startElement(void *ctx, const char *name, const char **atts)
+    CCLOG("cocos2d: CCFileUtils: mounted %s, %u files", fullPath.c_str(), pFilePack->getEntryCount());
+    m_filePacks.push_back(pFilePack);
+    return true;
+}
+
+void CCFileUtils::removeAllFilePacks()
+{
+    for (std::vector<CCFilePack*>::iterator iter = m_filePacks.begin(); iter != m_filePacks.end(); ++iter)
+    {
+        delete *iter;
+    }
+    m_filePacks.clear();
+}
+
+const ccFilePackEntry* CCFileUtils::findFilePackEntry(const char* pszFileName, CCFilePack** ppFilePack)
+{
+    std::string newFilename = getNewFilename(pszFileName);
+    // pack entries are relative to the resource root
+    if (! m_strDefaultResRootPath.empty() && newFilename.find(m_strDefaultResRootPath) == 0)
     {
-        CC_UNUSED_PARAM(ctx);
-        CC_UNUSED_PARAM(atts);
-        std::string sName((char*)name);
-        if( sName == "dict" )
+        newFilename = newFilename.substr(m_strDefaultResRootPath.length());
+    }
+
+    std::string file = newFilename;
+    std::string file_path = "";
+    size_t pos = newFilename.find_last_of("/");
+    if (pos != std::string::npos)
+    {
+        file_path = newFilename.substr(0, pos+1);
+        file = newFilename.substr(pos+1);
+    }
+
+    for (std::vector<std::string>::iterator resOrderIter = m_searchResolutionsOrderArray.begin();
+         resOrderIter != m_searchResolutionsOrderArray.end();
+         ++resOrderIter)
+    {
+        std::string entryName = file_path + *resOrderIter + file;
+        for (std::vector<CCFilePack*>::iterator iter = m_filePacks.begin(); iter != m_filePacks.end(); ++iter)
         {
-            m_pCurDict = new CCDictionary();
-            if(m_eResultType == SAX_RESULT_DICT && m_pRootDict == NULL)
+            const ccFilePackEntry *pEntry = (*iter)->findEntry(entryName.c_str());
+            if (pEntry)
             {
-                // Because it will call m_pCurDict->release() later, so retain here.
-                m_pRootDict = m_pCurDict;
-                m_pRootDict->retain();
+                *ppFilePack = *iter;
+                return pEntry;
             }
-            m_tState = SAX_DICT;
+        }
+    }
 
-            CCSAXState preState = SAX_NONE;
-            if (! m_tStateStack.empty())
-            {
-                preState = m_tStateStack.top();
-            }
+    return NULL;
+}
 
-            if (SAX_ARRAY == preState)
-            {
-                // add the dictionary into the array
-                m_pArray->addObject(m_pCurDict);
-            }
-            else if (SAX_DICT == preState)
-            {
-                // add the dictionary into the pre dictionary
-                CCAssert(! m_tDictStack.empty(), "The state is wrong!");
-                CCDictionary* pPreDict = m_tDictStack.top();
-                pPreDict->setObject(m_pCurDict, m_sCurKey.c_str());
-            }
+unsigned char* CCFileUtils::getFileDataFromFilePacks(const char* pszFileName, unsigned long * pSize)
+{
+    unsigned long uSize = 0;
+    unsigned char *pBuffer = NULL;
 
-            m_pCurDict->release();
+    CCFilePack *pFilePack = NULL;
+    const ccFilePackEntry *pEntry = findFilePackEntry(pszFileName, &pFilePack);
+    if (pEntry)
+    {
+        pBuffer = pFilePack->getFileData(pEntry, &uSize);
+    }
 
-            // record the dict state
-            m_tStateStack.push(m_tState);
-            m_tDictStack.push(m_pCurDict);
-        }
-        else if(sName == "key")
+    if (pSize)
+    {
+        *pSize = uSize;
+    }
+    return pBuffer;
+}
+
+CCFileView CCFileUtils::getFileView(const char* pszFileName)
+{
+    CCFileView view;
+
+    if (! m_filePacks.empty())
+    {
+        std::string fullPath = fullPathForFilename(pszFileName);
+        // loose files and apk assets override pack entries, as in getFileData()
+        if (! isFileExist(fullPath))
         {
-            m_tState = SAX_KEY;
+            CCFilePack *pFilePack = NULL;
+            const ccFilePackEntry *pEntry = findFilePackEntry(pszFileName, &pFilePack);
+            if (pEntry)
+            {
+                pFilePack->getFileView(pEntry, view);
+                return view;
+            }
         }
-        else if(sName == "integer")
+    }
+
+    unsigned long uSize = 0;
+    unsigned char *pBuffer = getFileData(pszFileName, "rb", &uSize);
+    view.initWithBuffer(pBuffer, uSize);
+    return view;
+}
+
+// CCAsyncFileData
+
+CCAsyncFileData::CCAsyncFileData(unsigned int uRequestId, const std::string& fileName)
+: m_uRequestId(uRequestId)
+, m_strFileName(fileName)
+, m_pBuffer(NULL)
+, m_uSize(0)
+{
+}
+
+CCAsyncFileData::~CCAsyncFileData()
+{
+    CC_SAFE_DELETE_ARRAY(m_pBuffer);
+}
+
+unsigned char* CCAsyncFileData::detachBuffer()
+{
+    unsigned char *pBuffer = m_pBuffer;
+    m_pBuffer = NULL;
+    m_uSize = 0;
+    return pBuffer;
+}
+
+void CCAsyncFileData::setBuffer(unsigned char* pBuffer, unsigned long uSize)
+{
+    CC_SAFE_DELETE_ARRAY(m_pBuffer);
+    m_pBuffer = pBuffer;
+    m_uSize = uSize;
+}
+
+// Asynchronous file reads
+//
+// Every file of a request is a job for the I/O threads. When the last file of a request
+// has been read, the request is queued for CCFileDataAsyncLoader::update, which calls
+// the selectors on the main thread and spends a bounded amount of time per frame.
+
+#define CC_FILE_DATA_ASYNC_THREADS      2
+// milliseconds of callbacks per frame, at least one request is delivered every frame
+#define CC_FILE_DATA_ASYNC_BUDGET       4.0
+
+typedef struct _FileDataRequest
+{
+    unsigned int                requestId;
+    CCObject                    *target;
+    SEL_CallFuncO               selector;
+    bool                        isBatch;
+    bool                        cancelled;
+    std::vector<std::string>    fileNames;
+    // resolved on the main thread, the path caches and the file pack lookup aren't thread safe
+    std::vector<std::string>    fullPaths;
+    std::vector<CCFilePack*>    packs;
+    std::vector<const ccFilePackEntry*> packEntries;
+    std::vector<unsigned char*> buffers;
+    std::vector<unsigned long>  sizes;
+    // files that have not been read yet
+    unsigned int                remaining;
+} FileDataRequest;
+
+typedef struct _FileDataJob
+{
+    FileDataRequest             *request;
+    unsigned int                index;
+} FileDataJob;
+
+static pthread_mutex_t                  s_fileDataMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t                   s_fileDataCondition = PTHREAD_COND_INITIALIZER;
+static std::vector<pthread_t>           s_fileDataThreads;
+static bool                             s_bFileDataQuit = false;
+static std::deque<FileDataJob>          s_fileDataJobs[kCCFileDataPriorityCount];
+static std::deque<FileDataRequest*>     s_fileDataCompleted;
+// requests of the main thread that have not been delivered yet
+static std::map<unsigned int, FileDataRequest*> s_fileDataRequests;
+static unsigned int                     s_uFileDataLastRequestId = 0;
+
+static bool popFileDataJob(FileDataJob& job)
+{
+    for (int i = 0; i < kCCFileDataPriorityCount; ++i)
+    {
+        if (! s_fileDataJobs[i].empty())
         {
-            m_tState = SAX_INT;
+            job = s_fileDataJobs[i].front();
+            s_fileDataJobs[i].pop_front();
+            return true;
         }
-        else if(sName == "real")
+    }
+
+    return false;
+}
+
+static void* readFileData(void* data)
+{
+    // create autorelease pool for iOS
+    CCThread thread;
+    thread.createAutoreleasePool();
+
+    while (true)
+    {
+        FileDataJob job;
+
+        pthread_mutex_lock(&s_fileDataMutex);
+        while (! s_bFileDataQuit && ! popFileDataJob(job))
         {
-            m_tState = SAX_REAL;
+            pthread_cond_wait(&s_fileDataCondition, &s_fileDataMutex);
         }
-        else if(sName == "string")
+        if (s_bFileDataQuit)
         {
-            m_tState = SAX_STRING;
+            pthread_mutex_unlock(&s_fileDataMutex);
+            break;
         }
-        else if (sName == "array")
+        bool bCancelled = job.request->cancelled;
+        pthread_mutex_unlock(&s_fileDataMutex);
+
+        unsigned char *pBuffer = NULL;
+        unsigned long uSize = 0;
+        if (! bCancelled)
         {
-            m_tState = SAX_ARRAY;
-            m_pArray = new CCArray();
-            if (m_eResultType == SAX_RESULT_ARRAY && m_pRootArray == NULL)
+            pBuffer = CCFileUtils::sharedFileUtils()->getFileDataFromFullPath(job.request->fullPaths[job.index].c_str(), &uSize);
+            const ccFilePackEntry *pEntry = job.request->packEntries[job.index];
+            if (! pBuffer && pEntry)
             {
-                m_pRootArray = m_pArray;
-                m_pRootArray->retain();
-            }
-            CCSAXState preState = SAX_NONE;
-            if (! m_tStateStack.empty())
-            {
-                preState = m_tStateStack.top();
+                pBuffer = job.request->packs[job.index]->getFileData(pEntry, &uSize);
             }
+        }
 
-            if (preState == SAX_DICT)
-            {
-                m_pCurDict->setObject(m_pArray, m_sCurKey.c_str());
-            }
-            else if (preState == SAX_ARRAY)
-            {
-                CCAssert(! m_tArrayStack.empty(), "The state is wrong!");
-                CCArray* pPreArray = m_tArrayStack.top();
-                pPreArray->addObject(m_pArray);
-            }
-            m_pArray->release();
-            // record the array state
-            m_tStateStack.push(m_tState);
-            m_tArrayStack.push(m_pArray);
+        pthread_mutex_lock(&s_fileDataMutex);
+        job.request->buffers[job.index] = pBuffer;
+        job.request->sizes[job.index] = pBuffer ? uSize : 0;
+        if (--job.request->remaining == 0)
+        {
+            s_fileDataCompleted.push_back(job.request);
         }
-        else
+        pthread_mutex_unlock(&s_fileDataMutex);
+    }
+
+    return 0;
+}
+
+static void deleteFileDataRequest(FileDataRequest *request)
+{
+    for (unsigned int i = 0; i < request->buffers.size(); ++i)
+    {
+        CC_SAFE_DELETE_ARRAY(request->buffers[i]);
+    }
+    delete request;
+}
+
+class CCFileDataAsyncLoader : public CCObject
+{
+public:
+    CCFileDataAsyncLoader()
+    : m_bScheduled(false)
+    {
+    }
+
+    static CCFileDataAsyncLoader* sharedLoader()
+    {
+        static CCFileDataAsyncLoader *s_pLoader = NULL;
+        if (! s_pLoader)
         {
-            m_tState = SAX_NONE;
+            s_pLoader = new CCFileDataAsyncLoader();
         }
+        return s_pLoader;
     }
 
-    void endElement(void *ctx, const char *name)
+    unsigned int addRequest(CCFileUtils *pFileUtils, const std::vector<std::string>& fileNames, bool isBatch, CCObject *target, SEL_CallFuncO selector, ccFileDataPriority priority)
     {
-        CC_UNUSED_PARAM(ctx);
-        CCSAXState curState = m_tStateStack.empty() ? SAX_DICT : m_tStateStack.top();
-        std::string sName((char*)name);
-        if( sName == "dict" )
+        if (priority < kCCFileDataPriorityHigh || priority >= kCCFileDataPriorityCount)
         {
-            m_tStateStack.pop();
-            m_tDictStack.pop();
-            if ( !m_tDictStack.empty())
-            {
-                m_pCurDict = m_tDictStack.top();
-            }
+            priority = kCCFileDataPriorityNormal;
         }
-        else if (sName == "array")
+
+        FileDataRequest *request = new FileDataRequest();
+        request->requestId = ++s_uFileDataLastRequestId;
+        request->target = target;
+        request->selector = selector;
+        request->isBatch = isBatch;
+        request->cancelled = false;
+        request->fileNames = fileNames;
+        request->fullPaths.reserve(fileNames.size());
+        request->packs.resize(fileNames.size(), NULL);
+        request->packEntries.resize(fileNames.size(), NULL);
+        for (unsigned int i = 0; i < fileNames.size(); ++i)
         {
-            m_tStateStack.pop();
-            m_tArrayStack.pop();
-            if (! m_tArrayStack.empty())
+            request->fullPaths.push_back(pFileUtils->fullPathForFilename(fileNames[i].c_str()));
+            if (! pFileUtils->m_filePacks.empty())
             {
-                m_pArray = m_tArrayStack.top();
+                request->packEntries[i] = pFileUtils->findFilePackEntry(fileNames[i].c_str(), &request->packs[i]);
             }
         }
-        else if (sName == "true")
+        request->buffers.resize(fileNames.size(), NULL);
+        request->sizes.resize(fileNames.size(), 0);
+        request->remaining = fileNames.size();
+        CC_SAFE_RETAIN(target);
+
+        s_fileDataRequests[request->requestId] = request;
+
+        if (s_fileDataThreads.empty())
         {
-            CCString *str = new CCString("1");
-            if (SAX_ARRAY == curState)
+            for (int i = 0; i < CC_FILE_DATA_ASYNC_THREADS; ++i)
             {
-                m_pArray->addObject(str);
-            }
-            else if (SAX_DICT == curState)
-            {
-                m_pCurDict->setObject(str, m_sCurKey.c_str());
+                pthread_t thread;
+                if (pthread_create(&thread, NULL, readFileData, NULL) == 0)
+                {
+                    s_fileDataThreads.push_back(thread);
+                }
             }
-            str->release();
         }
-        else if (sName == "false")
+
+        pthread_mutex_lock(&s_fileDataMutex);
+        if (fileNames.empty())
+        {
+            // an empty batch, delivered with the next update
+            s_fileDataCompleted.push_back(request);
+        }
+        for (unsigned int i = 0; i < fileNames.size(); ++i)
         {
-            CCString *str = new CCString("0");
-            if (SAX_ARRAY == curState)
+            FileDataJob job = { request, i };
+            s_fileDataJobs[priority].push_back(job);
+        }
+        pthread_mutex_unlock(&s_fileDataMutex);
+        pthread_cond_broadcast(&s_fileDataCondition);
+
+        if (! m_bScheduled)
+        {
+            m_bScheduled = true;
+            CCDirector::sharedDirector()->getScheduler()->scheduleSelector(schedule_selector(CCFileDataAsyncLoader::update), this, 0, false);
+        }
+
+        return request->requestId;
+    }
+
+    void cancel(FileDataRequest *request)
+    {
+        pthread_mutex_lock(&s_fileDataMutex);
+        request->cancelled = true;
+        pthread_mutex_unlock(&s_fileDataMutex);
+
+        // the request itself is deleted by update once the I/O threads are done with it
+        CC_SAFE_RELEASE_NULL(request->target);
+        request->selector = NULL;
+    }
+
+    void update(float dt)
+    {
+        struct cc_timeval start;
+        struct cc_timeval now;
+        CCTime::gettimeofdayCocos2d(&start, NULL);
+
+        while (true)
+        {
+            FileDataRequest *request = NULL;
+            pthread_mutex_lock(&s_fileDataMutex);
+            if (! s_fileDataCompleted.empty())
             {
-                m_pArray->addObject(str);
+                request = s_fileDataCompleted.front();
+                s_fileDataCompleted.pop_front();
             }
-            else if (SAX_DICT == curState)
+            pthread_mutex_unlock(&s_fileDataMutex);
+
+            if (! request)
             {
-                m_pCurDict->setObject(str, m_sCurKey.c_str());
+                break;
             }
-            str->release();
-        }
-        else if (sName == "string" || sName == "integer" || sName == "real")
-        {
-            CCString* pStrValue = new CCString(m_sCurValue);
 
-            if (SAX_ARRAY == curState)
+            s_fileDataRequests.erase(request->requestId);
+            if (! request->cancelled)
             {
-                m_pArray->addObject(pStrValue);
+                deliver(request);
             }
-            else if (SAX_DICT == curState)
+            deleteFileDataRequest(request);
+
+            CCTime::gettimeofdayCocos2d(&now, NULL);
+            if (CCTime::timersubCocos2d(&start, &now) >= CC_FILE_DATA_ASYNC_BUDGET)
             {
-                m_pCurDict->setObject(pStrValue, m_sCurKey.c_str());
+                break;
             }
+        }
 
-            pStrValue->release();
-            m_sCurValue.clear();
+        if (s_fileDataRequests.empty())
+        {
+            unscheduleUpdate();
         }
-        
-        m_tState = SAX_NONE;
     }
 
-    void textHandler(void *ctx, const char *ch, int len)
+    void unscheduleUpdate()
     {
-        CC_UNUSED_PARAM(ctx);
-        if (m_tState == SAX_NONE)
+        if (m_bScheduled)
         {
-            return;
+            m_bScheduled = false;
+            CCDirector::sharedDirector()->getScheduler()->unscheduleSelector(schedule_selector(CCFileDataAsyncLoader::update), this);
         }
+    }
 
-        CCSAXState curState = m_tStateStack.empty() ? SAX_DICT : m_tStateStack.top();
-        CCString *pText = new CCString(std::string((char*)ch,0,len));
+private:
+    void deliver(FileDataRequest *request)
+    {
+        CCArray *pResults = CCArray::createWithCapacity(request->fileNames.size());
+        for (unsigned int i = 0; i < request->fileNames.size(); ++i)
+        {
+            CCAsyncFileData *pData = new CCAsyncFileData(request->requestId, request->fileNames[i]);
+            pData->setBuffer(request->buffers[i], request->sizes[i]);
+            request->buffers[i] = NULL;
+            pResults->addObject(pData);
+            pData->release();
+        }
 
-        switch(m_tState)
+        CCObject *target = request->target;
+        SEL_CallFuncO selector = request->selector;
+        request->target = NULL;
+        if (target && selector)
         {
-        case SAX_KEY:
-            m_sCurKey = pText->getCString();
-            break;
-        case SAX_INT:
-        case SAX_REAL:
-        case SAX_STRING:
-            {
-                if (curState == SAX_DICT)
-                {
-                    CCAssert(!m_sCurKey.empty(), "key not found : <integer/real>");
-                }
-                
-                m_sCurValue.append(pText->getCString());
-            }
-            break;
-        default:
-            break;
+            (target->*selector)(request->isBatch ? (CCObject*)pResults : pResults->objectAtIndex(0));
         }
-        pText->release();
+        CC_SAFE_RELEASE(target);
     }
-};
 
-CCDictionary* CCFileUtils::createCCDictionaryWithContentsOfFile(const std::string& filename)
-{
-    std::string fullPath = fullPathForFilename(filename.c_str());
-    CCDictMaker tMaker;
-    return tMaker.dictionaryWithContentsOfFile(fullPath.c_str());
-}
+    bool m_bScheduled;
+};
 
-CCArray* CCFileUtils::createCCArrayWithContentsOfFile(const std::string& filename)
+// Stops and joins the I/O threads, the requests that were not delivered yet are dropped.
+// The threads are started again by the next request.
+static void stopFileDataThreads()
 {
-    std::string fullPath = fullPathForFilename(filename.c_str());
-    CCDictMaker tMaker;
-    return tMaker.arrayWithContentsOfFile(fullPath.c_str());
-}
-
-#else
-NS_CC_BEGIN
-
-/* The subclass CCFileUtilsIOS and CCFileUtilsMac should override these two method. */
-CCDictionary* CCFileUtils::createCCDictionaryWithContentsOfFile(const std::string& filename) {return NULL;}
-CCArray* CCFileUtils::createCCArrayWithContentsOfFile(const std::string& filename) {return NULL;}
-
-#endif /* (CC_TARGET_PLATFORM != CC_PLATFORM_IOS) && (CC_TARGET_PLATFORM != CC_PLATFORM_MAC) */
+    if (s_fileDataThreads.empty() && s_fileDataRequests.empty())
+    {
+        return;
+    }
 
+    pthread_mutex_lock(&s_fileDataMutex);
+    s_bFileDataQuit = true;
+    pthread_mutex_unlock(&s_fileDataMutex);
+    pthread_cond_broadcast(&s_fileDataCondition);
 
-CCFileUtils* CCFileUtils::s_sharedFileUtils = NULL;
+    for (std::vector<pthread_t>::iterator iter = s_fileDataThreads.begin(); iter != s_fileDataThreads.end(); ++iter)
+    {
+        pthread_join(*iter, NULL);
+    }
+    s_fileDataThreads.clear();
+    s_bFileDataQuit = false;
 
-void CCFileUtils::purgeFileUtils()
-{
-    CC_SAFE_DELETE(s_sharedFileUtils);
-}
+    for (int i = 0; i < kCCFileDataPriorityCount; ++i)
+    {
+        s_fileDataJobs[i].clear();
+    }
+    s_fileDataCompleted.clear();
+    for (std::map<unsigned int, FileDataRequest*>::iterator iter = s_fileDataRequests.begin(); iter != s_fileDataRequests.end(); ++iter)
+    {
+        CC_SAFE_RELEASE(iter->second->target);
+        deleteFileDataRequest(iter->second);
+    }
+    s_fileDataRequests.clear();
 
-CCFileUtils::CCFileUtils()
-: m_pFilenameLookupDict(NULL)
-{
+    CCFileDataAsyncLoader::sharedLoader()->unscheduleUpdate();
 }
 
-CCFileUtils::~CCFileUtils()
+unsigned int CCFileUtils::getFileDataAsync(const char* pszFileName, CCObject* pTarget, SEL_CallFuncO pSelector, ccFileDataPriority priority)
 {
-    CC_SAFE_RELEASE(m_pFilenameLookupDict);
-}
+    CCAssert(pszFileName != NULL, "CCFileUtils: Invalid path");
 
-bool CCFileUtils::init()
-{
-    m_searchPathArray.push_back(m_strDefaultResRootPath);
-    m_searchResolutionsOrderArray.push_back("");
-    return true;
+    std::vector<std::string> fileNames(1, pszFileName);
+    return CCFileDataAsyncLoader::sharedLoader()->addRequest(this, fileNames, false, pTarget, pSelector, priority);
 }
 
-void CCFileUtils::purgeCachedEntries()
+unsigned int CCFileUtils::getFileDataAsync(const std::vector<std::string>& fileNames, CCObject* pTarget, SEL_CallFuncO pSelector, ccFileDataPriority priority)
 {
-    m_fullPathCache.clear();
+    return CCFileDataAsyncLoader::sharedLoader()->addRequest(this, fileNames, true, pTarget, pSelector, priority);
 }
 
-unsigned char* CCFileUtils::getFileData(const char* pszFileName, const char* pszMode, unsigned long * pSize)
+void CCFileUtils::cancelFileDataAsync(unsigned int uRequestId)
 {
-    unsigned char * pBuffer = NULL;
-    CCAssert(pszFileName != NULL && pSize != NULL && pszMode != NULL, "Invalid parameters.");
-    *pSize = 0;
-    do
+    std::map<unsigned int, FileDataRequest*>::iterator iter = s_fileDataRequests.find(uRequestId);
+    if (iter != s_fileDataRequests.end())
     {
-        // read the file from hardware
-        std::string fullPath = fullPathForFilename(pszFileName);
-        FILE *fp = fopen(fullPath.c_str(), pszMode);
-        CC_BREAK_IF(!fp);
-        
-        fseek(fp,0,SEEK_END);
-        *pSize = ftell(fp);
-        fseek(fp,0,SEEK_SET);
-        pBuffer = new unsigned char[*pSize];
-        *pSize = fread(pBuffer,sizeof(unsigned char), *pSize,fp);
-        fclose(fp);
-    } while (0);
-    
-    if (! pBuffer)
-    {
-        std::string msg = "Get data from file(";
-        msg.append(pszFileName).append(") failed!");
-        
-        CCLOG(msg.c_str());
+        CCFileDataAsyncLoader::sharedLoader()->cancel(iter->second);
     }
-    return pBuffer;
 }
 
-unsigned char* CCFileUtils::getFileDataFromZip(const char* pszZipFilePath, const char* pszFileName, unsigned long * pSize)
+void CCFileUtils::cancelAllFileDataAsync(CCObject* pTarget)
 {
-    unsigned char * pBuffer = NULL;
-    unzFile pFile = NULL;
-    *pSize = 0;
-
-    do 
-    {
-        CC_BREAK_IF(!pszZipFilePath || !pszFileName);
-        CC_BREAK_IF(strlen(pszZipFilePath) == 0);
-
-        pFile = unzOpen(pszZipFilePath);
-        CC_BREAK_IF(!pFile);
-
-        int nRet = unzLocateFile(pFile, pszFileName, 1);
-        CC_BREAK_IF(UNZ_OK != nRet);
-
-        char szFilePathA[260];
-        unz_file_info FileInfo;
-        nRet = unzGetCurrentFileInfo(pFile, &FileInfo, szFilePathA, sizeof(szFilePathA), NULL, 0, NULL, 0);
-        CC_BREAK_IF(UNZ_OK != nRet);
-
-        nRet = unzOpenCurrentFile(pFile);
-        CC_BREAK_IF(UNZ_OK != nRet);
-
-        pBuffer = new unsigned char[FileInfo.uncompressed_size];
-        int CC_UNUSED nSize = unzReadCurrentFile(pFile, pBuffer, FileInfo.uncompressed_size);
-        CCAssert(nSize == 0 || nSize == (int)FileInfo.uncompressed_size, "the file size is wrong");
-
-        *pSize = FileInfo.uncompressed_size;
-        unzCloseCurrentFile(pFile);
-    } while (0);
-
-    if (pFile)
+    for (std::map<unsigned int, FileDataRequest*>::iterator iter = s_fileDataRequests.begin(); iter != s_fileDataRequests.end(); ++iter)
     {
-        unzClose(pFile);
+        if (pTarget == NULL || iter->second->target == pTarget)
+        {
+            CCFileDataAsyncLoader::sharedLoader()->cancel(iter->second);
+        }
     }
-
-    return pBuffer;
 }
 
 std::string CCFileUtils::getNewFilename(const char* pszFileName)
@@ -493,6 +838,11 @@ std::string CCFileUtils::fullPathForFilename(const char* pszFileName)
         return cacheIter->second;
     }
     
+    if (m_missingFileCache.find(pszFileName) != m_missingFileCache.end())
+    {
+        return pszFileName;
+    }
+    
     // Get the new file name.
     std::string newFilename = getNewFilename(pszFileName);
     
@@ -505,7 +855,10 @@ std::string CCFileUtils::fullPathForFilename(const char* pszFileName)
             
             //CCLOG("\n\nSEARCHING: %s, %s, %s", newFilename.c_str(), resOrderIter->c_str(), searchPathsIter->c_str());
             
-            fullpath = this->getPathForFilename(newFilename, *resOrderIter, *searchPathsIter);
+            if (! findInResourceManifest(newFilename, *resOrderIter, *searchPathsIter, fullpath))
+            {
+                fullpath = this->getPathForFilename(newFilename, *resOrderIter, *searchPathsIter);
+            }
             
             if (fullpath.length() > 0)
             {
@@ -517,10 +870,119 @@ std::string CCFileUtils::fullPathForFilename(const char* pszFileName)
         }
     }
     
+    if (! m_resourceManifest.empty())
+    {
+        m_missingFileCache.insert(pszFileName);
+    }
+    
     // The file wasn't found, return the file name passed in.
     return pszFileName;
 }
 
+bool CCFileUtils::findInResourceManifest(const std::string& filename, const std::string& resolutionDirectory, const std::string& searchPath, std::string& fullPath)
+{
+    if (m_resourceManifest.empty())
+    {
+        return false;
+    }
+
+    // the manifest only knows the files below the resource root
+    if (m_strDefaultResRootPath.empty() ? isAbsolutePath(searchPath)
+                                        : searchPath.compare(0, m_strDefaultResRootPath.length(), m_strDefaultResRootPath) != 0)
+    {
+        return false;
+    }
+
+    std::string file = filename;
+    std::string file_path = "";
+    size_t pos = filename.find_last_of("/");
+    if (pos != std::string::npos)
+    {
+        file_path = filename.substr(0, pos+1);
+        file = filename.substr(pos+1);
+    }
+
+    std::string relativePath = searchPath.substr(m_strDefaultResRootPath.length());
+    relativePath += file_path;
+    relativePath += resolutionDirectory;
+    relativePath += file;
+
+    if (m_resourceManifest.find(relativePath) != m_resourceManifest.end())
+    {
+#if (CC_TARGET_PLATFORM == CC_PLATFORM_IOS) || (CC_TARGET_PLATFORM == CC_PLATFORM_MAC)
+        // relative search paths are resolved by the bundle
+        fullPath = getPathForFilename(filename, resolutionDirectory, searchPath);
+#else
+        fullPath = m_strDefaultResRootPath + relativePath;
+#endif
+    }
+    else
+    {
+        fullPath = "";
+    }
+    return true;
+}
+
+void CCFileUtils::updateFullPathCache(bool bAppended)
+{
+    // files found earlier in the search order are still found first
+    if (! bAppended)
+    {
+        m_fullPathCache.clear();
+    }
+    m_missingFileCache.clear();
+}
+
+bool CCFileUtils::loadResourceManifest(const char* pszManifestFile)
+{
+    unsigned long uSize = 0;
+    std::string fullPath = fullPathForFilename(pszManifestFile);
+    unsigned char* pBuffer = getFileData(fullPath.c_str(), "rb", &uSize);
+    if (! pBuffer)
+    {
+        return false;
+    }
+
+    std::set<std::string> manifest;
+    const char* pLine = (const char*)pBuffer;
+    const char* pEnd = pLine + uSize;
+    while (pLine < pEnd)
+    {
+        const char* pLineEnd = (const char*)memchr(pLine, '\n', pEnd - pLine);
+        if (! pLineEnd)
+        {
+            pLineEnd = pEnd;
+        }
+
+        const char* pLast = pLineEnd;
+        while (pLast > pLine && (pLast[-1] == '\r' || pLast[-1] == ' ' || pLast[-1] == '\t'))
+        {
+            --pLast;
+        }
+        if (pLast > pLine && *pLine != '#')
+        {
+            manifest.insert(manifest.end(), std::string(pLine, pLast - pLine));
+        }
+
+        pLine = pLineEnd + 1;
+    }
+    CC_SAFE_DELETE_ARRAY(pBuffer);
+
+    m_resourceManifest.swap(manifest);
+    m_fullPathCache.clear();
+    m_missingFileCache.clear();
+
+    CCLOG("cocos2d: CCFileUtils: loaded resource manifest %s, %u files", fullPath.c_str(), (unsigned int)m_resourceManifest.size());
+    return true;
+}
+
+void CCFileUtils::removeResourceManifest()
+{
+    m_resourceManifest.clear();
+    m_fullPathCache.clear();
+    m_missingFileCache.clear();
+}
+
 const char* CCFileUtils::fullPathFromRelativeFile(const char *pszFilename, const char *pszRelativeFile)
 {
     std::string relativeFile = pszRelativeFile;
@@ -553,11 +1015,16 @@ void CCFileUtils::setSearchResolutionsOrder(const std::vector<std::string>& sear
     {
         m_searchResolutionsOrderArray.push_back("");
     }
+
+    // resolution directories are tried for every search path, so even appended ones can come before files found already
+    updateFullPathCache(false);
 }
 
 void CCFileUtils::addSearchResolutionsOrder(const char* order)
 {
     m_searchResolutionsOrderArray.push_back(order);
+    // tried for every search path, so it can come before files that were found already
+    updateFullPathCache(false);
 }
 
 const std::vector<std::string>& CCFileUtils::getSearchResolutionsOrder()
@@ -573,8 +1040,8 @@ const std::vector<std::string>& CCFileUtils::getSearchPaths()
 void CCFileUtils::setSearchPaths(const std::vector<std::string>& searchPaths)
 {
     bool bExistDefaultRootPath = false;
-    
-    m_searchPathArray.clear();
+    std::vector<std::string> oldSearchPaths;
+    oldSearchPaths.swap(m_searchPathArray);
     for (std::vector<std::string>::const_iterator iter = searchPaths.begin(); iter != searchPaths.end(); ++iter)
     {
         std::string strPrefix;
@@ -600,6 +1067,9 @@ void CCFileUtils::setSearchPaths(const std::vector<std::string>& searchPaths)
         //CCLOG("Default root path doesn't exist, adding it.");
         m_searchPathArray.push_back(m_strDefaultResRootPath);
     }
+
+    updateFullPathCache(oldSearchPaths.size() <= m_searchPathArray.size()
+                        && std::equal(oldSearchPaths.begin(), oldSearchPaths.end(), m_searchPathArray.begin()));
 }
 
 void CCFileUtils::addSearchPath(const char* path_)
@@ -616,6 +1086,7 @@ void CCFileUtils::addSearchPath(const char* path_)
         path += "/";
     }
     m_searchPathArray.push_back(path);
+    updateFullPathCache(true);
 }
 
 void CCFileUtils::setFilenameLookupDictionary(CCDictionary* pFilenameLookupDict)
@@ -623,6 +1094,7 @@ void CCFileUtils::setFilenameLookupDictionary(CCDictionary* pFilenameLookupDict)
     CC_SAFE_RELEASE(m_pFilenameLookupDict);
     m_pFilenameLookupDict = pFilenameLookupDict;
     CC_SAFE_RETAIN(m_pFilenameLookupDict);
+    updateFullPathCache(false);
 }
 
 void CCFileUtils::loadFilenameLookupDictionaryFromFile(const char* filename)
@@ -27,9 +27,12 @@ THE SOFTWARE.
 #include <string>
 #include <vector>
 #include <map>
+#include <set>
 #include "CCPlatformMacros.h"
 #include "ccTypes.h"
 #include "ccTypeInfo.h"
+#include "CCFilePack.h"
+#include "cocoa/CCObject.h"
 
 NS_CC_BEGIN
 
@@ -40,11 +43,52 @@ class CCArray;
  * @{
  */
 
+/** Priorities of asynchronous file reads, higher priority requests are read first.
+ @since v2.1.4
+ */
+typedef enum {
+    kCCFileDataPriorityHigh = 0,
+    kCCFileDataPriorityNormal,
+    kCCFileDataPriorityLow,
+    kCCFileDataPriorityCount,
+} ccFileDataPriority;
+
+/** @brief The result of an asynchronous file read, passed to the selector of CCFileUtils::getFileDataAsync().
+
+ The object owns the buffer. Retain the object, or take the buffer with detachBuffer(), to keep the data.
+ @since v2.1.4
+ */
+class CC_DLL CCAsyncFileData : public CCObject
+{
+public:
+    CCAsyncFileData(unsigned int uRequestId, const std::string& fileName);
+    virtual ~CCAsyncFileData();
+
+    unsigned int getRequestId() const { return m_uRequestId; }
+    /** The file name that was passed to getFileDataAsync() */
+    const std::string& getFileName() const { return m_strFileName; }
+    /** The data, or NULL if the file could not be read */
+    unsigned char* getBuffer() const { return m_pBuffer; }
+    unsigned long getSize() const { return m_uSize; }
+
+    /** Takes ownership of the buffer, you are responsible for calling delete[] on it */
+    unsigned char* detachBuffer();
+
+    void setBuffer(unsigned char* pBuffer, unsigned long uSize);
+
+private:
+    unsigned int m_uRequestId;
+    std::string m_strFileName;
+    unsigned char* m_pBuffer;
+    unsigned long m_uSize;
+};
+
 //! @brief  Helper class to handle file operations
 class CC_DLL CCFileUtils : public TypeInfo
 {
     friend class CCArray;
     friend class CCDictionary;
+    friend class CCFileDataAsyncLoader;
 public:
     /**
      *  Returns an unique ID for this class.
@@ -63,6 +107,7 @@ public:
     
     /**
      *  Destroys the instance of CCFileUtils.
+     *  The I/O threads of getFileDataAsync() are stopped and joined first.
      */
     static void purgeFileUtils();
     
@@ -92,8 +137,21 @@ public:
      */
     virtual unsigned char* getFileData(const char* pszFileName, const char* pszMode, unsigned long * pSize);
 
+    /**
+     *  Reads a file by a path that fullPathForFilename() already returned, without resolving it again.
+     *  It doesn't use the search paths, the path caches or the file packs, so the I/O threads of
+     *  getFileDataAsync() can call it while the main thread changes them.
+     *
+     *  @warning Recall: you are responsible for calling delete[] on any Non-NULL pointer returned.
+     *  @since v2.1.4
+     */
+    virtual unsigned char* getFileDataFromFullPath(const char* pszFullPath, unsigned long * pSize);
+
     /**
      *  Gets resource file data from a zip file.
+     *  The zip file is mounted on first use: its central directory is indexed once and kept
+     *  until purgeCachedEntries() is called or the zip file changes on disk.
+     *  It is safe to call from several threads at once.
      *
      *  @param[in]  pszFileName The resource file name which contains the relative path of the zip file.
      *  @param[out] pSize If the file read operation succeeds, it will be the data size, otherwise 0.
@@ -102,6 +160,70 @@ public:
      */
     virtual unsigned char* getFileDataFromZip(const char* pszZipFilePath, const char* pszFileName, unsigned long * pSize);
 
+    /**
+     *  Mounts a file pack built by tools/file-pack/ccpack.py.
+     *  Files that can't be found on the search paths are looked up in the mounted packs,
+     *  in the order the packs were added, so loose files always override pack entries.
+     *  Pack entries are named relative to the resource root and resolved with the
+     *  resolution directories, like loose files.
+     *
+     *  @note Packs must only be added or removed while no other thread reads files.
+     *  @return true if the pack was mounted.
+     *  @since v2.1.4
+     */
+    virtual bool addFilePack(const char* pszPackPath);
+
+    /**
+     *  Unmounts all file packs. Views on mapped entries become invalid.
+     *  @since v2.1.4
+     */
+    virtual void removeAllFilePacks();
+
+    /**
+     *  Gets a read-only view on the contents of a file.
+     *  Uncompressed entries of a mounted file pack are not copied, the view points into the
+     *  mapped pack. Loose files and compressed entries are read into a buffer owned by the view.
+     *  A loose file, or an apk asset on Android, wins over a pack entry of the same name.
+     *  CCImage and CCSAXParser read their files through it.
+     *
+     *  @return The view, which is null if the file can't be read. Call release() on it when done.
+     *  @since v2.1.4
+     */
+    virtual CCFileView getFileView(const char* pszFileName);
+
+    /**
+     *  Reads a file on a pool of I/O threads.
+     *  The selector is called on the main thread with a CCAsyncFileData, whose buffer is NULL if the
+     *  file could not be read. The target is retained until the selector was called or the request was cancelled.
+     *
+     *  @return The id of the request, to pass to cancelFileDataAsync().
+     *  @since v2.1.4
+     */
+    virtual unsigned int getFileDataAsync(const char* pszFileName, CCObject* pTarget, SEL_CallFuncO pSelector,
+                                          ccFileDataPriority priority = kCCFileDataPriorityNormal);
+
+    /**
+     *  Reads several files on the I/O threads and calls the selector once, on the main thread,
+     *  with a CCArray of CCAsyncFileData in the order of the file names.
+     *
+     *  @return The id of the request, to pass to cancelFileDataAsync().
+     *  @since v2.1.4
+     */
+    virtual unsigned int getFileDataAsync(const std::vector<std::string>& fileNames, CCObject* pTarget, SEL_CallFuncO pSelector,
+                                          ccFileDataPriority priority = kCCFileDataPriorityNormal);
+
+    /**
+     *  Cancels a request of getFileDataAsync(). Its selector will not be called.
+     *  @since v2.1.4
+     */
+    virtual void cancelFileDataAsync(unsigned int uRequestId);
+
+    /**
+     *  Cancels all requests of getFileDataAsync() for a target, or all requests if pTarget is NULL.
+     *  @since v2.1.4
+     */
+    virtual void cancelAllFileDataAsync(CCObject* pTarget);
+
     
     /** Returns the fullpath for a given filename.
      
@@ -190,6 +312,32 @@ public:
      *  @since v2.1
      */
     virtual void setFilenameLookupDictionary(CCDictionary* pFilenameLookupDict);
+
+    /**
+     *  Loads a resource manifest, a list of every file below the resource root, built by
+     *  tools/resource-manifest/genmanifest.py.
+     *
+     *  While a manifest is loaded, fullPathForFilename() checks candidates below the resource root
+     *  against the manifest instead of the file system, and also caches files that could not be found.
+     *  Search paths outside the resource root (e.g. the writable path) are still probed.
+     *
+     * @code
+     * # cocos2d-x resource manifest 1
+     * fonts/arial16.fnt
+     * hd/Images/grossini.png
+     * @endcode
+     *
+     *  @note Call purgeCachedEntries() after adding files to the search paths at runtime.
+     *  @return true if the manifest was loaded.
+     *  @since v2.1.4
+     */
+    virtual bool loadResourceManifest(const char* pszManifestFile);
+
+    /**
+     *  Unloads the resource manifest, file searches probe the file system again.
+     *  @since v2.1.4
+     */
+    virtual void removeResourceManifest();
     
     /**
      *  Gets full path from a file name and the path of the reletive file.
@@ -339,6 +487,30 @@ protected:
      *  @return The full path of the file, if the file can't be found, it will return an empty string.
      */
     virtual std::string getFullPathForDirectoryAndFilename(const std::string& strDirectory, const std::string& strFilename);
+
+    /**
+     *  Checks a candidate of fullPathForFilename() against the resource manifest.
+     *  @return false if the manifest doesn't cover the search path, otherwise true, and fullPath is the
+     *          full path of the file or an empty string if it doesn't exist.
+     */
+    bool findInResourceManifest(const std::string& filename, const std::string& resolutionDirectory, const std::string& searchPath, std::string& fullPath);
+
+    /**
+     *  Drops the cached file searches that the new search paths or resolution directories can change.
+     *  If search paths were only appended, only files that were not found are dropped.
+     */
+    void updateFullPathCache(bool bAppended);
+
+    /**
+     *  Finds the entry of a file in the mounted file packs, using the resolution directories.
+     *  @return The entry, or NULL if no pack contains the file.
+     */
+    const ccFilePackEntry* findFilePackEntry(const char* pszFileName, CCFilePack** ppFilePack);
+
+    /**
+     *  Gets a copy of a file from the mounted file packs, or NULL if no pack contains it.
+     */
+    unsigned char* getFileDataFromFilePacks(const char* pszFileName, unsigned long * pSize);
     
     /**
      *  Creates a dictionary by the contents of a file.
@@ -351,6 +523,12 @@ protected:
      *  @note This method is used internally.
      */
     virtual CCArray* createCCArrayWithContentsOfFile(const std::string& filename);
+
+    /**
+     *  Creates a dictionary by the contents of a plist in memory.
+     *  @note This method is used internally.
+     */
+    virtual CCDictionary* createCCDictionaryWithData(const char* pData, unsigned long uSize);
     
     /** Dictionary used to lookup filenames based on a key.
      *  It is used internally by the following methods:
@@ -387,6 +565,21 @@ protected:
      *  This variable is used for improving the performance of file search.
      */
     std::map<std::string, std::string> m_fullPathCache;
+
+    /**
+     *  Files that could not be found. Only used while a resource manifest is loaded.
+     */
+    std::set<std::string> m_missingFileCache;
+
+    /**
+     *  The paths of all files below the resource root, see loadResourceManifest().
+     */
+    std::set<std::string> m_resourceManifest;
+
+    /**
+     *  The mounted file packs, see addFilePack().
+     */
+    std::vector<CCFilePack*> m_filePacks;
     
     /**
      *  The singleton pointer of CCFileUtils.
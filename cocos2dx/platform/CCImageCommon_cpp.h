@@ -93,27 +93,27 @@ CCImage::~CCImage()
 bool CCImage::initWithImageFile(const char * strPath, EImageFormat eImgFmt/* = eFmtPng*/)
 {
     bool bRet = false;
-    unsigned long nSize = 0;
     std::string fullPath = CCFileUtils::sharedFileUtils()->fullPathForFilename(strPath);
-    unsigned char* pBuffer = CCFileUtils::sharedFileUtils()->getFileData(fullPath.c_str(), "rb", &nSize);
-    if (pBuffer != NULL && nSize > 0)
+    // images stored uncompressed in a file pack are decoded straight from the mapped pack
+    CCFileView view = CCFileUtils::sharedFileUtils()->getFileView(fullPath.c_str());
+    if (! view.isNull() && view.getSize() > 0)
     {
-        bRet = initWithImageData(pBuffer, nSize, eImgFmt);
+        // the decoders only read the data
+        bRet = initWithImageData((void*)view.getBytes(), view.getSize(), eImgFmt);
     }
-    CC_SAFE_DELETE_ARRAY(pBuffer);
+    view.release();
     return bRet;
 }
 
 bool CCImage::initWithImageFileThreadSafe(const char *fullpath, EImageFormat imageType)
 {
     bool bRet = false;
-    unsigned long nSize = 0;
-    unsigned char *pBuffer = CCFileUtils::sharedFileUtils()->getFileData(fullpath, "rb", &nSize);
-    if (pBuffer != NULL && nSize > 0)
+    CCFileView view = CCFileUtils::sharedFileUtils()->getFileView(fullpath);
+    if (! view.isNull() && view.getSize() > 0)
     {
-        bRet = initWithImageData(pBuffer, nSize, imageType);
+        bRet = initWithImageData((void*)view.getBytes(), view.getSize(), imageType);
     }
-    CC_SAFE_DELETE_ARRAY(pBuffer);
+    view.release();
     return bRet;
 }
 
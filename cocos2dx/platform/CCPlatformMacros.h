@@ -79,12 +79,17 @@ Enable it if you want to cache the texture data.
 Basically,it's only enabled in android
 
 It's new in cocos2d-x since v0.99.5
+It can be forced on other platforms (e.g. -DCC_ENABLE_CACHE_TEXTURE_DATA=1) to exercise
+the texture reload path after a simulated context loss; the linux makefiles do so
+with CACHE_TEXTURE_DATA=1.
 */
+#ifndef CC_ENABLE_CACHE_TEXTURE_DATA
 #if (CC_TARGET_PLATFORM == CC_PLATFORM_ANDROID)
     #define CC_ENABLE_CACHE_TEXTURE_DATA       0
 #else
     #define CC_ENABLE_CACHE_TEXTURE_DATA       0
 #endif
+#endif
 
 #if (CC_TARGET_PLATFORM == CC_PLATFORM_ANDROID) || (CC_TARGET_PLATFORM == CC_PLATFORM_WIN32)
     /* Application will crash in glDrawElements function on some win32 computers and some android devices.
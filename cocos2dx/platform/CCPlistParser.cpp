@@ -0,0 +1,555 @@
+/****************************************************************************
+Copyright (c) 2013 cocos2d-x.org
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+#include "CCPlistParser.h"
+#include "cocoa/CCArray.h"
+#include "cocoa/CCDictionary.h"
+#include "cocoa/CCString.h"
+#include <string.h>
+#include <stdlib.h>
+
+NS_CC_BEGIN
+
+#define PLIST_TAG_IS(__tag__, __name__) \
+    ((__tag__).length == (int)(sizeof(__name__) - 1) && memcmp((__tag__).name, __name__, sizeof(__name__) - 1) == 0)
+
+static inline bool isWhitespace(char c)
+{
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+static inline bool startsWith(const char *p, const char *pEnd, const char *prefix, int length)
+{
+    return pEnd - p >= length && memcmp(p, prefix, length) == 0;
+}
+
+// returns the position right after the first occurrence of pattern, or NULL
+static const char* skipPast(const char *p, const char *pEnd, const char *pattern, int length)
+{
+    while (pEnd - p >= length)
+    {
+        const char *pFound = (const char*)memchr(p, pattern[0], pEnd - p - length + 1);
+        if (! pFound)
+        {
+            break;
+        }
+        if (memcmp(pFound, pattern, length) == 0)
+        {
+            return pFound + length;
+        }
+        p = pFound + 1;
+    }
+    return NULL;
+}
+
+static void appendUTF8(std::vector<char>& out, unsigned long c)
+{
+    if (c < 0x80)
+    {
+        out.push_back((char)c);
+    }
+    else if (c < 0x800)
+    {
+        out.push_back((char)(0xc0 | (c >> 6)));
+        out.push_back((char)(0x80 | (c & 0x3f)));
+    }
+    else if (c < 0x10000)
+    {
+        out.push_back((char)(0xe0 | (c >> 12)));
+        out.push_back((char)(0x80 | ((c >> 6) & 0x3f)));
+        out.push_back((char)(0x80 | (c & 0x3f)));
+    }
+    else if (c < 0x110000)
+    {
+        out.push_back((char)(0xf0 | (c >> 18)));
+        out.push_back((char)(0x80 | ((c >> 12) & 0x3f)));
+        out.push_back((char)(0x80 | ((c >> 6) & 0x3f)));
+        out.push_back((char)(0x80 | (c & 0x3f)));
+    }
+}
+
+CCPlistParser::CCPlistParser()
+: m_pCurrent(NULL)
+, m_pEnd(NULL)
+, m_bError(false)
+{
+}
+
+CCDictionary* CCPlistParser::dictionaryWithData(const char *pData, unsigned long uSize)
+{
+    CCObject *pRoot = parseRoot(pData, uSize);
+    CCDictionary *pDict = dynamic_cast<CCDictionary*>(pRoot);
+    if (! pDict)
+    {
+        CC_SAFE_RELEASE(pRoot);
+    }
+    return pDict;
+}
+
+CCArray* CCPlistParser::arrayWithData(const char *pData, unsigned long uSize)
+{
+    CCObject *pRoot = parseRoot(pData, uSize);
+    CCArray *pArray = dynamic_cast<CCArray*>(pRoot);
+    if (! pArray)
+    {
+        CC_SAFE_RELEASE(pRoot);
+    }
+    return pArray;
+}
+
+CCObject* CCPlistParser::parseRoot(const char *pData, unsigned long uSize)
+{
+    m_pCurrent = pData;
+    m_pEnd = pData + uSize;
+    m_bError = false;
+    m_text.clear();
+
+    if (! pData)
+    {
+        return NULL;
+    }
+
+    // skip the UTF-8 byte order mark
+    if (startsWith(m_pCurrent, m_pEnd, "\xef\xbb\xbf", 3))
+    {
+        m_pCurrent += 3;
+    }
+
+    Tag tag;
+    while (readTag(tag))
+    {
+        // the <plist> element only wraps the root object
+        if (tag.closing || PLIST_TAG_IS(tag, "plist"))
+        {
+            continue;
+        }
+
+        CCObject *pRoot = parseValue(tag);
+        if (pRoot || m_bError)
+        {
+            return pRoot;
+        }
+    }
+    return NULL;
+}
+
+CCObject* CCPlistParser::parseValue(const Tag& tag)
+{
+    if (PLIST_TAG_IS(tag, "dict"))
+    {
+        return tag.empty ? new CCDictionary() : parseDictionary();
+    }
+    else if (PLIST_TAG_IS(tag, "array"))
+    {
+        return tag.empty ? new CCArray() : parseArray();
+    }
+    else if (PLIST_TAG_IS(tag, "string") || PLIST_TAG_IS(tag, "integer") || PLIST_TAG_IS(tag, "real"))
+    {
+        const char *pText = NULL;
+        int nLength = 0;
+        if (! readText(tag, &pText, &nLength))
+        {
+            return NULL;
+        }
+
+        CCString *pString = new CCString();
+        pString->m_sString.assign(pText, nLength);
+        return pString;
+    }
+    else if (PLIST_TAG_IS(tag, "true") || PLIST_TAG_IS(tag, "false"))
+    {
+        if (! skipElement(tag))
+        {
+            return NULL;
+        }
+        return new CCString(tag.name[0] == 't' ? "1" : "0");
+    }
+
+    // <date>, <data> and anything unknown are not supported by CCDictionary
+    skipElement(tag);
+    return NULL;
+}
+
+CCObject* CCPlistParser::parseDictionary()
+{
+    CCDictionary *pDict = new CCDictionary();
+    std::string key;
+    bool bHasKey = false;
+
+    Tag tag;
+    while (readTag(tag))
+    {
+        if (tag.closing)
+        {
+            if (PLIST_TAG_IS(tag, "dict"))
+            {
+                return pDict;
+            }
+            break;
+        }
+
+        if (PLIST_TAG_IS(tag, "key"))
+        {
+            const char *pText = NULL;
+            int nLength = 0;
+            if (! readText(tag, &pText, &nLength))
+            {
+                break;
+            }
+            key.assign(pText, nLength);
+            bHasKey = true;
+            continue;
+        }
+
+        CCObject *pValue = parseValue(tag);
+        if (m_bError)
+        {
+            break;
+        }
+        if (pValue)
+        {
+            if (bHasKey && ! key.empty())
+            {
+                pDict->setObject(pValue, key);
+            }
+            pValue->release();
+        }
+        bHasKey = false;
+    }
+
+    m_bError = true;
+    pDict->release();
+    return NULL;
+}
+
+CCObject* CCPlistParser::parseArray()
+{
+    CCArray *pArray = new CCArray();
+
+    Tag tag;
+    while (readTag(tag))
+    {
+        if (tag.closing)
+        {
+            if (PLIST_TAG_IS(tag, "array"))
+            {
+                return pArray;
+            }
+            break;
+        }
+
+        CCObject *pValue = parseValue(tag);
+        if (m_bError)
+        {
+            break;
+        }
+        if (pValue)
+        {
+            pArray->addObject(pValue);
+            pValue->release();
+        }
+    }
+
+    m_bError = true;
+    pArray->release();
+    return NULL;
+}
+
+void CCPlistParser::skipWhitespace()
+{
+    while (m_pCurrent < m_pEnd && isWhitespace(*m_pCurrent))
+    {
+        ++m_pCurrent;
+    }
+}
+
+bool CCPlistParser::skipMarkup()
+{
+    const char *p = m_pCurrent;
+    if (startsWith(p, m_pEnd, "<?", 2))
+    {
+        p = skipPast(p + 2, m_pEnd, "?>", 2);
+    }
+    else if (startsWith(p, m_pEnd, "<!--", 4))
+    {
+        p = skipPast(p + 4, m_pEnd, "-->", 3);
+    }
+    else if (startsWith(p, m_pEnd, "<![CDATA[", 9))
+    {
+        p = skipPast(p + 9, m_pEnd, "]]>", 3);
+    }
+    else if (startsWith(p, m_pEnd, "<!", 2))
+    {
+        p = skipPast(p + 2, m_pEnd, ">", 1);
+    }
+    else
+    {
+        return false;
+    }
+
+    if (! p)
+    {
+        m_bError = true;
+        m_pCurrent = m_pEnd;
+        return false;
+    }
+    m_pCurrent = p;
+    return true;
+}
+
+bool CCPlistParser::readTag(Tag& tag)
+{
+    while (! m_bError)
+    {
+        // text between elements is insignificant in a plist
+        const char *p = (const char*)memchr(m_pCurrent, '<', m_pEnd - m_pCurrent);
+        if (! p)
+        {
+            m_pCurrent = m_pEnd;
+            return false;
+        }
+        m_pCurrent = p;
+
+        if (skipMarkup())
+        {
+            continue;
+        }
+        if (m_bError)
+        {
+            return false;
+        }
+
+        ++p;
+        tag.closing = (p < m_pEnd && *p == '/');
+        if (tag.closing)
+        {
+            ++p;
+        }
+
+        tag.name = p;
+        while (p < m_pEnd && ! isWhitespace(*p) && *p != '/' && *p != '>')
+        {
+            ++p;
+        }
+        tag.length = (int)(p - tag.name);
+
+        // attributes are not used by plists, skip them
+        char quote = 0;
+        while (p < m_pEnd && (quote || *p != '>'))
+        {
+            if (quote)
+            {
+                if (*p == quote)
+                {
+                    quote = 0;
+                }
+            }
+            else if (*p == '"' || *p == '\'')
+            {
+                quote = *p;
+            }
+            ++p;
+        }
+        if (p >= m_pEnd || tag.length == 0)
+        {
+            m_bError = true;
+            return false;
+        }
+
+        tag.empty = (p[-1] == '/');
+        m_pCurrent = p + 1;
+        return true;
+    }
+    return false;
+}
+
+bool CCPlistParser::readText(const Tag& tag, const char **ppText, int *pLength)
+{
+    *ppText = "";
+    *pLength = 0;
+    if (tag.empty)
+    {
+        return true;
+    }
+
+    // Common case: plain text followed by the closing tag, which is referenced in place.
+    const char *p = m_pCurrent;
+    while (p < m_pEnd && *p != '<' && *p != '&' && *p != '\r')
+    {
+        ++p;
+    }
+
+    if (startsWith(p, m_pEnd, "</", 2))
+    {
+        *ppText = m_pCurrent;
+        *pLength = (int)(p - m_pCurrent);
+        m_pCurrent = p;
+    }
+    else
+    {
+        // entities, CDATA sections or comments: decode into the text buffer
+        m_text.clear();
+        while (true)
+        {
+            p = (const char*)memchr(m_pCurrent, '<', m_pEnd - m_pCurrent);
+            if (! p)
+            {
+                m_bError = true;
+                return false;
+            }
+            decodeText(m_pCurrent, p);
+            m_pCurrent = p;
+
+            if (startsWith(p, m_pEnd, "<![CDATA[", 9))
+            {
+                const char *pEnd = skipPast(p + 9, m_pEnd, "]]>", 3);
+                if (! pEnd)
+                {
+                    m_bError = true;
+                    return false;
+                }
+                m_text.insert(m_text.end(), p + 9, pEnd - 3);
+                m_pCurrent = pEnd;
+            }
+            else if (startsWith(p, m_pEnd, "<!--", 4))
+            {
+                skipMarkup();
+            }
+            else
+            {
+                break;
+            }
+        }
+
+        if (! m_text.empty())
+        {
+            *ppText = &m_text[0];
+            *pLength = (int)m_text.size();
+        }
+    }
+
+    // the element must not contain children
+    Tag closeTag;
+    const char *pStart = m_pCurrent;
+    if (! readTag(closeTag) || ! closeTag.closing
+        || closeTag.length != tag.length || memcmp(closeTag.name, tag.name, tag.length) != 0)
+    {
+        m_pCurrent = pStart;
+        m_bError = true;
+        return false;
+    }
+    return true;
+}
+
+bool CCPlistParser::skipElement(const Tag& tag)
+{
+    if (tag.empty)
+    {
+        return true;
+    }
+
+    int nDepth = 1;
+    Tag child;
+    while (nDepth > 0 && readTag(child))
+    {
+        if (child.closing)
+        {
+            --nDepth;
+        }
+        else if (! child.empty)
+        {
+            ++nDepth;
+        }
+    }
+
+    if (nDepth > 0)
+    {
+        m_bError = true;
+        return false;
+    }
+    return true;
+}
+
+void CCPlistParser::decodeText(const char *pText, const char *pEnd)
+{
+    while (pText < pEnd)
+    {
+        char c = *pText++;
+        if (c == '\r')
+        {
+            // XML line ending normalization
+            m_text.push_back('\n');
+            if (pText < pEnd && *pText == '\n')
+            {
+                ++pText;
+            }
+            continue;
+        }
+        if (c != '&')
+        {
+            m_text.push_back(c);
+            continue;
+        }
+
+        const char *pSemicolon = (const char*)memchr(pText, ';', pEnd - pText);
+        int nLength = pSemicolon ? (int)(pSemicolon - pText) : 0;
+        if (nLength == 2 && memcmp(pText, "lt", 2) == 0)
+        {
+            m_text.push_back('<');
+        }
+        else if (nLength == 2 && memcmp(pText, "gt", 2) == 0)
+        {
+            m_text.push_back('>');
+        }
+        else if (nLength == 3 && memcmp(pText, "amp", 3) == 0)
+        {
+            m_text.push_back('&');
+        }
+        else if (nLength == 4 && memcmp(pText, "quot", 4) == 0)
+        {
+            m_text.push_back('"');
+        }
+        else if (nLength == 4 && memcmp(pText, "apos", 4) == 0)
+        {
+            m_text.push_back('\'');
+        }
+        else if (nLength > 1 && nLength < 10 && pText[0] == '#')
+        {
+            char number[10];
+            memcpy(number, pText + 1, nLength - 1);
+            number[nLength - 1] = '\0';
+            bool bHex = (number[0] == 'x' || number[0] == 'X');
+            appendUTF8(m_text, strtoul(bHex ? number + 1 : number, NULL, bHex ? 16 : 10));
+        }
+        else
+        {
+            // not an entity we know, keep it as it is
+            m_text.push_back('&');
+            continue;
+        }
+        pText = pSemicolon + 1;
+    }
+}
+
+NS_CC_END
@@ -0,0 +1,102 @@
+/****************************************************************************
+Copyright (c) 2013 cocos2d-x.org
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+#ifndef __CC_PLIST_PARSER_H__
+#define __CC_PLIST_PARSER_H__
+
+#include "CCPlatformMacros.h"
+#include <string>
+#include <vector>
+
+NS_CC_BEGIN
+
+class CCObject;
+class CCDictionary;
+class CCArray;
+
+/**
+ * @addtogroup platform
+ * @{
+ */
+
+/** @brief Parses XML property lists straight into CCDictionary / CCArray / CCString objects.
+
+ The plist is read in a single pass, without building a DOM and without SAX callbacks.
+ Text is referenced in the input where possible; text with entities or CDATA sections
+ is decoded into a buffer that is reused for the whole parse.
+
+ Supports <dict>, <array>, <key>, <string>, <integer>, <real>, <true/> and <false/>.
+ Numbers and booleans become CCStrings ("1" and "0" for booleans), like CCDictionary expects.
+ Other elements (<date>, <data>) are skipped.
+ @since v2.1.4
+ */
+class CC_DLL CCPlistParser
+{
+public:
+    CCPlistParser();
+
+    /** Parses a plist whose root is a dictionary.
+     @return The dictionary, which isn't an autorelease object, or NULL if the data is not a valid plist.
+     */
+    CCDictionary* dictionaryWithData(const char *pData, unsigned long uSize);
+
+    /** Parses a plist whose root is an array.
+     @return The array, which isn't an autorelease object, or NULL if the data is not a valid plist.
+     */
+    CCArray* arrayWithData(const char *pData, unsigned long uSize);
+
+private:
+    typedef struct _Tag
+    {
+        const char *name;
+        int         length;
+        bool        closing;
+        bool        empty;
+    } Tag;
+
+    CCObject* parseRoot(const char *pData, unsigned long uSize);
+    CCObject* parseValue(const Tag& tag);
+    CCObject* parseDictionary();
+    CCObject* parseArray();
+
+    bool readTag(Tag& tag);
+    bool readText(const Tag& tag, const char **ppText, int *pLength);
+    bool skipElement(const Tag& tag);
+    void skipWhitespace();
+    bool skipMarkup();
+    void decodeText(const char *pText, const char *pEnd);
+
+    const char *m_pCurrent;
+    const char *m_pEnd;
+    bool m_bError;
+    // decoded text, reused by every element
+    std::vector<char> m_text;
+};
+
+// end of platform group
+/// @}
+
+NS_CC_END
+
+#endif    // __CC_PLIST_PARSER_H__
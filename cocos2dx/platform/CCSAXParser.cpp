@@ -115,13 +115,13 @@ bool CCSAXParser::parse(const char* pXMLData, unsigned int uDataLength)
 bool CCSAXParser::parse(const char *pszFile)
 {
     bool bRet = false;
-    unsigned long size = 0;
-    char* pBuffer = (char*)CCFileUtils::sharedFileUtils()->getFileData(pszFile, "rt", &size);
-    if (pBuffer != NULL && size > 0)
+    // plists stored uncompressed in a file pack are parsed without an extra copy
+    CCFileView view = CCFileUtils::sharedFileUtils()->getFileView(pszFile);
+    if (! view.isNull() && view.getSize() > 0)
     {
-        bRet = parse(pBuffer, size);
+        bRet = parse((const char*)view.getBytes(), view.getSize());
     }
-    CC_SAFE_DELETE_ARRAY(pBuffer);
+    view.release();
     return bRet;
 }
 
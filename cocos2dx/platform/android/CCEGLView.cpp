@@ -45,12 +45,24 @@ PFNGLDELETEVERTEXARRAYSOESPROC glDeleteVertexArraysOESEXT = 0;
 
 #endif
 
+#if CC_ENABLE_PROGRAM_BINARY_CACHE
+
+#include <EGL/egl.h>
+PFNGLGETPROGRAMBINARYOESPROC glGetProgramBinaryOESEXT = 0;
+PFNGLPROGRAMBINARYOESPROC glProgramBinaryOESEXT = 0;
+
+#endif
+
 void initExtensions() {
 #if CC_TEXTURE_ATLAS_USE_VAO
      glGenVertexArraysOESEXT = (PFNGLGENVERTEXARRAYSOESPROC)eglGetProcAddress("glGenVertexArraysOES");
      glBindVertexArrayOESEXT = (PFNGLBINDVERTEXARRAYOESPROC)eglGetProcAddress("glBindVertexArrayOES");
      glDeleteVertexArraysOESEXT = (PFNGLDELETEVERTEXARRAYSOESPROC)eglGetProcAddress("glDeleteVertexArraysOES");
 #endif
+#if CC_ENABLE_PROGRAM_BINARY_CACHE
+     glGetProgramBinaryOESEXT = (PFNGLGETPROGRAMBINARYOESPROC)eglGetProcAddress("glGetProgramBinaryOES");
+     glProgramBinaryOESEXT = (PFNGLPROGRAMBINARYOESPROC)eglGetProcAddress("glProgramBinaryOES");
+#endif
 }
 
 NS_CC_BEGIN
@@ -148,6 +148,11 @@ unsigned char* CCFileUtilsAndroid::getFileData(const char* pszFileName, const ch
         } while (0);        
     }
 
+    if (! pData && ! m_filePacks.empty())
+    {
+        pData = getFileDataFromFilePacks(pszFileName, pSize);
+    }
+
     if (! pData)
     {
         std::string msg = "Get data from file(";
@@ -158,6 +163,18 @@ unsigned char* CCFileUtilsAndroid::getFileData(const char* pszFileName, const ch
     return pData;
 }
 
+unsigned char* CCFileUtilsAndroid::getFileDataFromFullPath(const char* pszFullPath, unsigned long * pSize)
+{
+    // relative full paths are apk assets
+    if (pszFullPath[0] != '/')
+    {
+        *pSize = 0;
+        return s_pZipFile->getFileData(pszFullPath, pSize);
+    }
+
+    return CCFileUtils::getFileDataFromFullPath(pszFullPath, pSize);
+}
+
 string CCFileUtilsAndroid::getWritablePath()
 {
     // Fix for Nexus 10 (Android 4.2 multi-user environment)
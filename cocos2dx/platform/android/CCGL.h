@@ -61,5 +61,11 @@ extern PFNGLDELETEVERTEXARRAYSOESPROC glDeleteVertexArraysOESEXT;
 #define glBindVertexArrayOES glBindVertexArrayOESEXT
 #define glDeleteVertexArraysOES glDeleteVertexArraysOESEXT
 
+extern PFNGLGETPROGRAMBINARYOESPROC glGetProgramBinaryOESEXT;
+extern PFNGLPROGRAMBINARYOESPROC glProgramBinaryOESEXT;
+
+#define glGetProgramBinaryOES glGetProgramBinaryOESEXT
+#define glProgramBinaryOES glProgramBinaryOESEXT
+
 
 #endif // __CCGL_H__
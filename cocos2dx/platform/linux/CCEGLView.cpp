@@ -10,6 +10,7 @@
 #include "GL/glfw.h"
 #include "ccMacros.h"
 #include "CCDirector.h"
+#include "shaders/ccGLStateCache.h"
 #include "touch_dispatcher/CCTouch.h"
 #include "touch_dispatcher/CCTouchDispatcher.h"
 #include "text_input_node/CCIMEDispatcher.h"
@@ -255,7 +256,7 @@ float CCEGLView::getFrameZoomFactor()
 
 void CCEGLView::setViewPortInPoints(float x , float y , float w , float h)
 {
-    glViewport((GLint)(x * m_fScaleX * m_fFrameZoomFactor+ m_obViewPortRect.origin.x * m_fFrameZoomFactor),
+    ccGLViewport((GLint)(x * m_fScaleX * m_fFrameZoomFactor+ m_obViewPortRect.origin.x * m_fFrameZoomFactor),
         (GLint)(y * m_fScaleY * m_fFrameZoomFactor + m_obViewPortRect.origin.y * m_fFrameZoomFactor),
         (GLsizei)(w * m_fScaleX * m_fFrameZoomFactor),
         (GLsizei)(h * m_fScaleY * m_fFrameZoomFactor));
@@ -263,7 +264,7 @@ void CCEGLView::setViewPortInPoints(float x , float y , float w , float h)
 
 void CCEGLView::setScissorInPoints(float x , float y , float w , float h)
 {
-    glScissor((GLint)(x * m_fScaleX * m_fFrameZoomFactor + m_obViewPortRect.origin.x * m_fFrameZoomFactor),
+    ccGLScissor((GLint)(x * m_fScaleX * m_fFrameZoomFactor + m_obViewPortRect.origin.x * m_fFrameZoomFactor),
               (GLint)(y * m_fScaleY * m_fFrameZoomFactor + m_obViewPortRect.origin.y * m_fFrameZoomFactor),
               (GLsizei)(w * m_fScaleX * m_fFrameZoomFactor),
               (GLsizei)(h * m_fScaleY * m_fFrameZoomFactor));
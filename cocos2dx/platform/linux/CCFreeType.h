@@ -0,0 +1,95 @@
+/****************************************************************************
+Copyright (c) 2013 cocos2d-x.org
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+
+#ifndef __CC_FREETYPE_LINUX_H__
+#define __CC_FREETYPE_LINUX_H__
+
+#include "platform/CCPlatformMacros.h"
+#include <string>
+
+#include "ft2build.h"
+#include FT_FREETYPE_H
+
+NS_CC_BEGIN
+
+/** FreeType helpers shared by CCImage::initWithString and CCFontAtlas. */
+
+/** Maximum number of faces kept open by ccFreeTypeSharedFace */
+#define CC_FREETYPE_FACE_CACHE_SIZE         16
+
+/** Maximum size in bytes of the glyphs kept by ccFreeTypeCachedGlyph */
+#define CC_FREETYPE_GLYPH_CACHE_SIZE        (1024 * 1024)
+
+/** @struct ccFreeTypeGlyph
+ Metrics and 8 bit gray bitmap of a rendered glyph, in pixels.
+ */
+typedef struct _ccFreeTypeGlyph
+{
+    FT_UInt index;
+    int width;
+    int bearingX;
+    int bearingY;
+    int advance;
+    int bitmapWidth;
+    int bitmapRows;
+    //! bitmapWidth * bitmapRows bytes, without padding
+    unsigned char *bitmap;
+} ccFreeTypeGlyph;
+
+/** The FreeType library of the application, NULL if FreeType could not be initialized. */
+FT_Library ccFreeTypeLibrary();
+
+/** The font file for a font name: a .ttf file shipped with the application,
+ or the best match among the fonts installed on the system.
+ */
+std::string ccFreeTypeFontFile(const char *pFontName);
+
+/** Opens a face of the font with the unicode charmap and the pixel size selected.
+ Falls back to FreeSerif if the font can not be opened.
+ @return The face, which must be released with FT_Done_Face, or NULL.
+ */
+FT_Face ccFreeTypeNewFace(const char *pFontName, int nPixelSize);
+
+/** Returns a face of the font at a pixel size from a cache of the last used faces,
+ opening it with ccFreeTypeNewFace if needed.
+ @return The face, owned by the cache and valid until the next call, or NULL.
+ @since v2.1.4
+ */
+FT_Face ccFreeTypeSharedFace(const char *pFontName, int nPixelSize);
+
+/** Returns a glyph of a face returned by ccFreeTypeSharedFace from a cache of the
+ last used glyphs, rendering it if needed.
+ @return The glyph, owned by the cache and valid until the next call, or NULL.
+ @since v2.1.4
+ */
+const ccFreeTypeGlyph* ccFreeTypeCachedGlyph(FT_Face face, FT_UInt uGlyphIndex);
+
+/** Closes the faces and releases the glyphs of the caches.
+ @since v2.1.4
+ */
+void ccFreeTypePurgeCache();
+
+NS_CC_END
+
+#endif    // __CC_FREETYPE_LINUX_H__
@@ -4,6 +4,8 @@
 #include <vector>
 #include <string>
 #include <sstream>
+#include <list>
+#include <map>
 #include <fontconfig/fontconfig.h>
 
 #include "platform/CCFileUtils.h"
@@ -12,15 +14,13 @@
 #include "platform/CCImageCommon_cpp.h"
 #include "platform/CCImage.h"
 #include "platform/linux/CCApplication.h"
+#include "platform/linux/CCFreeType.h"
 
-#include "ft2build.h"
 #include "CCStdC.h"
 
-#include FT_FREETYPE_H
-
 using namespace std;
 
-// as FcFontMatch is quite an expensive call, cache the results of getFontFile
+// as FcFontMatch is quite an expensive call, cache the results of ccFreeTypeFontFile
 static std::map<std::string, std::string> fontCache;
 
 struct LineBreakGlyph {
@@ -53,19 +53,257 @@ struct LineBreakLine {
 };
 
 NS_CC_BEGIN
+
+class FreeTypeLibrary
+{
+public:
+	FreeTypeLibrary() : glyphCacheSize(0) {
+		if ( FT_Init_FreeType( &library ) ) {
+			library = NULL;
+		}
+		FcInit();
+	}
+
+	~FreeTypeLibrary() {
+		purgeCache();
+		if ( library ) {
+			FT_Done_FreeType(library);
+		}
+		FcFini();
+	}
+
+	FT_Face sharedFace(const char* pFontName, int nPixelSize) {
+		FaceKey key(pFontName, nPixelSize);
+		for ( std::list<FaceEntry>::iterator it = faces.begin(); it != faces.end(); ++it ) {
+			if ( it->key == key ) {
+				// most recently used faces are at the front
+				faces.splice(faces.begin(), faces, it);
+				return it->face;
+			}
+		}
+
+		FT_Face face = ccFreeTypeNewFace(pFontName, nPixelSize);
+		if ( ! face ) {
+			return NULL;
+		}
+		if ( faces.size() >= CC_FREETYPE_FACE_CACHE_SIZE ) {
+			removeFace(faces.back().face);
+			faces.pop_back();
+		}
+		FaceEntry entry;
+		entry.key = key;
+		entry.face = face;
+		faces.push_front(entry);
+		return face;
+	}
+
+	const ccFreeTypeGlyph* cachedGlyph(FT_Face face, FT_UInt glyphIndex) {
+		GlyphKey key(face, glyphIndex);
+		std::map<GlyphKey, std::list<GlyphEntry>::iterator>::iterator found = glyphIndices.find(key);
+		if ( found != glyphIndices.end() ) {
+			glyphs.splice(glyphs.begin(), glyphs, found->second);
+			return &found->second->glyph;
+		}
+
+		if ( FT_Load_Glyph(face, glyphIndex, FT_LOAD_RENDER) ) {
+			return NULL;
+		}
+
+		FT_GlyphSlot slot = face->glyph;
+		GlyphEntry entry;
+		entry.key = key;
+		ccFreeTypeGlyph& glyph = entry.glyph;
+		glyph.index = glyphIndex;
+		glyph.width = slot->metrics.width >> 6;
+		glyph.bearingX = slot->metrics.horiBearingX >> 6;
+		glyph.bearingY = slot->metrics.horiBearingY >> 6;
+		glyph.advance = slot->metrics.horiAdvance >> 6;
+		glyph.bitmapWidth = slot->bitmap.width;
+		glyph.bitmapRows = slot->bitmap.rows;
+		glyph.bitmap = NULL;
+		if ( glyph.bitmapWidth > 0 && glyph.bitmapRows > 0 ) {
+			glyph.bitmap = new unsigned char[glyph.bitmapWidth * glyph.bitmapRows];
+			for ( int y = 0; y < glyph.bitmapRows; ++y ) {
+				memcpy(glyph.bitmap + y * glyph.bitmapWidth, slot->bitmap.buffer + y * slot->bitmap.pitch, glyph.bitmapWidth);
+			}
+		}
+
+		glyphs.push_front(entry);
+		glyphIndices[key] = glyphs.begin();
+		glyphCacheSize += glyphSize(glyph);
+
+		// drop the least recently used glyphs, but never the new one
+		while ( glyphCacheSize > CC_FREETYPE_GLYPH_CACHE_SIZE && glyphs.size() > 1 ) {
+			removeGlyph(glyphIndices.find(glyphs.back().key));
+		}
+		return &glyphs.front().glyph;
+	}
+
+	void purgeCache() {
+		while ( ! glyphIndices.empty() ) {
+			removeGlyph(glyphIndices.begin());
+		}
+		for ( std::list<FaceEntry>::iterator it = faces.begin(); it != faces.end(); ++it ) {
+			FT_Done_Face(it->face);
+		}
+		faces.clear();
+	}
+
+	FT_Library library;
+
+private:
+	typedef std::pair<std::string, int> FaceKey;
+	typedef std::pair<FT_Face, FT_UInt> GlyphKey;
+
+	struct FaceEntry {
+		FaceKey key;
+		FT_Face face;
+	};
+
+	struct GlyphEntry {
+		GlyphKey key;
+		ccFreeTypeGlyph glyph;
+	};
+
+	static int glyphSize(const ccFreeTypeGlyph& glyph) {
+		return sizeof(ccFreeTypeGlyph) + glyph.bitmapWidth * glyph.bitmapRows;
+	}
+
+	void removeGlyph(std::map<GlyphKey, std::list<GlyphEntry>::iterator>::iterator it) {
+		glyphCacheSize -= glyphSize(it->second->glyph);
+		delete [] it->second->glyph.bitmap;
+		glyphs.erase(it->second);
+		glyphIndices.erase(it);
+	}
+
+	// closes a face and forgets its glyphs, as a new face may get the same address
+	void removeFace(FT_Face face) {
+		std::map<GlyphKey, std::list<GlyphEntry>::iterator>::iterator it = glyphIndices.lower_bound(GlyphKey(face, 0));
+		while ( it != glyphIndices.end() && it->first.first == face ) {
+			removeGlyph(it++);
+		}
+		FT_Done_Face(face);
+	}
+
+	std::list<FaceEntry> faces;
+	std::list<GlyphEntry> glyphs;
+	std::map<GlyphKey, std::list<GlyphEntry>::iterator> glyphIndices;
+	int glyphCacheSize;
+};
+
+static FreeTypeLibrary& sharedFreeTypeLibrary()
+{
+	static FreeTypeLibrary s_library;
+	return s_library;
+}
+
+FT_Library ccFreeTypeLibrary()
+{
+	return sharedFreeTypeLibrary().library;
+}
+
+std::string ccFreeTypeFontFile(const char* family_name)
+{
+	std::string fontPath = family_name;
+
+	std::map<std::string, std::string>::iterator it = fontCache.find(family_name);
+	if ( it != fontCache.end() ) {
+		return it->second;
+	}
+
+	// check if the parameter is a font file shipped with the application
+	std::string lowerCasePath = fontPath;
+	std::transform(lowerCasePath.begin(), lowerCasePath.end(), lowerCasePath.begin(), ::tolower);
+	if ( lowerCasePath.find(".ttf") != std::string::npos ) {
+		fontPath = cocos2d::CCFileUtils::sharedFileUtils()->fullPathForFilename(fontPath.c_str());
+
+		FILE *f = fopen(fontPath.c_str(), "r");
+		if ( f ) {
+			fclose(f);
+			fontCache.insert(std::pair<std::string, std::string>(family_name, fontPath));
+			return fontPath;
+		}
+	}
+
+	// use fontconfig to match the parameter against the fonts installed on the system
+	ccFreeTypeLibrary();
+	FcPattern *pattern = FcPatternBuild (0, FC_FAMILY, FcTypeString, family_name, (char *) 0);
+	FcConfigSubstitute(0, pattern, FcMatchPattern);
+	FcDefaultSubstitute(pattern);
+
+	FcResult result;
+	FcPattern *font = FcFontMatch(0, pattern, &result);
+	if ( font ) {
+		FcChar8 *s = NULL;
+		if ( FcPatternGetString(font, FC_FILE, 0, &s) == FcResultMatch ) {
+			fontPath = (const char*)s;
+
+			FcPatternDestroy(font);
+			FcPatternDestroy(pattern);
+
+			fontCache.insert(std::pair<std::string, std::string>(family_name, fontPath));
+			return fontPath;
+		}
+		FcPatternDestroy(font);
+	}
+	FcPatternDestroy(pattern);
+
+	return family_name;
+}
+
+FT_Face ccFreeTypeNewFace(const char* pFontName, int nPixelSize)
+{
+	FT_Library library = ccFreeTypeLibrary();
+	if ( ! library ) {
+		return NULL;
+	}
+
+	FT_Face face;
+	std::string fontfile = ccFreeTypeFontFile(pFontName);
+	if ( FT_New_Face(library, fontfile.c_str(), 0, &face) ) {
+		//no valid font found use default
+		if ( FT_New_Face(library, "/usr/share/fonts/truetype/freefont/FreeSerif.ttf", 0, &face) ) {
+			return NULL;
+		}
+	}
+
+	//select utf8 charmap
+	if ( FT_Select_Charmap(face, FT_ENCODING_UNICODE) ) {
+		FT_Done_Face(face);
+		return NULL;
+	}
+
+	if ( FT_Set_Pixel_Sizes(face, nPixelSize, nPixelSize) ) {
+		FT_Done_Face(face);
+		return NULL;
+	}
+	return face;
+}
+
+FT_Face ccFreeTypeSharedFace(const char* pFontName, int nPixelSize)
+{
+	return sharedFreeTypeLibrary().sharedFace(pFontName, nPixelSize);
+}
+
+const ccFreeTypeGlyph* ccFreeTypeCachedGlyph(FT_Face face, FT_UInt uGlyphIndex)
+{
+	return sharedFreeTypeLibrary().cachedGlyph(face, uGlyphIndex);
+}
+
+void ccFreeTypePurgeCache()
+{
+	sharedFreeTypeLibrary().purgeCache();
+}
+
 class BitmapDC
 {
 public:
 	BitmapDC() {
-		libError = FT_Init_FreeType( &library );
-		FcInit();
 		m_pData = NULL;
 		reset();
 	}
 
 	~BitmapDC() {
-		FT_Done_FreeType(library);
-		FcFini();
 		//data will be deleted by CCImage
 //		if (m_pData) {
 //			delete m_pData;
@@ -155,12 +393,13 @@ public:
             }
 
 			glyphIndex = FT_Get_Char_Index(face, unicode);
-			if (FT_Load_Glyph(face, glyphIndex, FT_LOAD_DEFAULT)) {
+			const ccFreeTypeGlyph* cachedGlyph = ccFreeTypeCachedGlyph(face, glyphIndex);
+			if (! cachedGlyph) {
 				return false;
 			}
 
 			if (isspace(unicode)) {
-				currentPaintPosition += face->glyph->metrics.horiAdvance >> 6;
+				currentPaintPosition += cachedGlyph->advance;
 				prevGlyphIndex = glyphIndex;
 				prevCharacter = unicode;
 				lastBreakIndex = currentLine.glyphs.size();
@@ -169,9 +408,9 @@ public:
 
 			LineBreakGlyph glyph;
 			glyph.glyphIndex = glyphIndex;
-			glyph.glyphWidth = face->glyph->metrics.width >> 6;
-			glyph.bearingX = face->glyph->metrics.horiBearingX >> 6;
-			glyph.horizAdvance = face->glyph->metrics.horiAdvance >> 6;
+			glyph.glyphWidth = cachedGlyph->width;
+			glyph.bearingX = cachedGlyph->bearingX;
+			glyph.horizAdvance = cachedGlyph->advance;
 			glyph.kerning = 0;
 
 			if (prevGlyphIndex != 0 && hasKerning) {
@@ -266,80 +505,14 @@ public:
 		return baseLinePos;
 	}
 
-    std::string getFontFile(const char* family_name) {
-    	std::string fontPath = family_name;
-
-    	std::map<std::string, std::string>::iterator it = fontCache.find(family_name);
-    	if ( it != fontCache.end() ) {
-    		return it->second;
-    	}
-
-    	// check if the parameter is a font file shipped with the application
-    	std::string lowerCasePath = fontPath;
-    	std::transform(lowerCasePath.begin(), lowerCasePath.end(), lowerCasePath.begin(), ::tolower);
-    	if ( lowerCasePath.find(".ttf") != std::string::npos ) {
-    		fontPath = cocos2d::CCFileUtils::sharedFileUtils()->fullPathForFilename(fontPath.c_str());
-
-    		FILE *f = fopen(fontPath.c_str(), "r");
-    		if ( f ) {
-    			fclose(f);
-    			fontCache.insert(std::pair<std::string, std::string>(family_name, fontPath));
-    			return fontPath;
-    		}
-    	}
-
-    	// use fontconfig to match the parameter against the fonts installed on the system
-    	FcPattern *pattern = FcPatternBuild (0, FC_FAMILY, FcTypeString, family_name, (char *) 0);
-    	FcConfigSubstitute(0, pattern, FcMatchPattern);
-    	FcDefaultSubstitute(pattern);
-
-    	FcResult result;
-    	FcPattern *font = FcFontMatch(0, pattern, &result);
-    	if ( font ) {
-    		FcChar8 *s = NULL;
-    		if ( FcPatternGetString(font, FC_FILE, 0, &s) == FcResultMatch ) {
-    			fontPath = (const char*)s;
-
-    			FcPatternDestroy(font);
-    			FcPatternDestroy(pattern);
-
-    			fontCache.insert(std::pair<std::string, std::string>(family_name, fontPath));
-    			return fontPath;
-    		}
-    		FcPatternDestroy(font);
-    	}
-    	FcPatternDestroy(pattern);
-
-    	return family_name;
-    }
-
 	bool getBitmap(const char *text, int nWidth, int nHeight, CCImage::ETextAlign eAlignMask, const char * pFontName, float fontSize) {
-		if (libError) {
-			return false;
-		}
-
-		FT_Face face;
-		std::string fontfile = getFontFile(pFontName);
-		if ( FT_New_Face(library, fontfile.c_str(), 0, &face) ) {
-			//no valid font found use default
-			if ( FT_New_Face(library, "/usr/share/fonts/truetype/freefont/FreeSerif.ttf", 0, &face) ) {
-				return false;
-			}
-		}
-
-		//select utf8 charmap
-		if ( FT_Select_Charmap(face, FT_ENCODING_UNICODE) ) {
-			FT_Done_Face(face);
-			return false;
-		}
-
-		if ( FT_Set_Pixel_Sizes(face, fontSize, fontSize) ) {
-			FT_Done_Face(face);
+		// the face and the glyphs are cached, so they are not loaded again for each string
+		FT_Face face = ccFreeTypeSharedFace(pFontName, fontSize);
+		if ( ! face ) {
 			return false;
 		}
 
 		if ( divideString(face, text, nWidth, nHeight) == false ) {
-			FT_Done_Face(face);
 			return false;
 		}
 
@@ -366,17 +539,17 @@ public:
 
 			int glyphCount = textLines.at(line).glyphs.size();
 			for (int i = 0; i < glyphCount; i++) {
-				LineBreakGlyph glyph = textLines.at(line).glyphs.at(i);
+				const LineBreakGlyph& glyph = textLines.at(line).glyphs.at(i);
 
-				if (FT_Load_Glyph(face, glyph.glyphIndex, FT_LOAD_RENDER)) {
+				const ccFreeTypeGlyph* cachedGlyph = ccFreeTypeCachedGlyph(face, glyph.glyphIndex);
+				if (! cachedGlyph) {
 					continue;
 				}
 
-				FT_Bitmap& bitmap = face->glyph->bitmap;
-				int yoffset = iCurYCursor - (face->glyph->metrics.horiBearingY >> 6);
+				int yoffset = iCurYCursor - cachedGlyph->bearingY;
 				int xoffset = iCurXCursor + glyph.paintPosition;
 
-				for (int y = 0; y < bitmap.rows; ++y) {
+				for (int y = 0; y < cachedGlyph->bitmapRows; ++y) {
                     int iY = yoffset + y;
                     if (iY>=iMaxLineHeight) {
                         //exceed the height truncate
@@ -384,10 +557,10 @@ public:
                     }
                     iY *= iMaxLineWidth;
 
-                    int bitmap_y = y * bitmap.width;
+                    const unsigned char* bitmap_y = cachedGlyph->bitmap + y * cachedGlyph->bitmapWidth;
 
-					for (int x = 0; x < bitmap.width; ++x) {
-						unsigned char cTemp = bitmap.buffer[bitmap_y + x];
+					for (int x = 0; x < cachedGlyph->bitmapWidth; ++x) {
+						unsigned char cTemp = bitmap_y[x];
 						if (cTemp == 0) {
 							continue;
 						}
@@ -402,17 +575,11 @@ public:
 			// step to next line
 			iCurYCursor += lineHeight;
 		}
-
-		//  free face
-		FT_Done_Face(face);
 		return true;
 	}
 
 public:
-	FT_Library library;
-
 	unsigned char *m_pData;
-	int libError;
 	std::vector<LineBreakLine> textLines;
 	int iMaxLineWidth;
 	int iMaxLineHeight;
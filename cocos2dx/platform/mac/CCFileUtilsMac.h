@@ -49,6 +49,7 @@ public:
     
     virtual CCDictionary* createCCDictionaryWithContentsOfFile(const std::string& filename);
     virtual CCArray* createCCArrayWithContentsOfFile(const std::string& filename);
+    virtual CCDictionary* createCCDictionaryWithData(const char* pData, unsigned long uSize);
 
 };
 
@@ -236,6 +236,28 @@ CCDictionary* CCFileUtilsMac::createCCDictionaryWithContentsOfFile(const std::st
     return pRet;
 }
 
+CCDictionary* CCFileUtilsMac::createCCDictionaryWithData(const char* pData, unsigned long uSize)
+{
+    NSData* pPlistData = [NSData dataWithBytesNoCopy:(void*)pData length:uSize freeWhenDone:NO];
+    id pPlist = [NSPropertyListSerialization propertyListFromData:pPlistData
+                                                 mutabilityOption:NSPropertyListImmutable
+                                                           format:NULL
+                                                 errorDescription:NULL];
+    if (! [pPlist isKindOfClass:[NSDictionary class]])
+    {
+        return NULL;
+    }
+
+    NSDictionary* pDict = (NSDictionary*)pPlist;
+    CCDictionary* pRet = new CCDictionary();
+    for (id key in [pDict allKeys]) {
+        id value = [pDict objectForKey:key];
+        addValueToCCDict(key, value, pRet);
+    }
+
+    return pRet;
+}
+
 CCArray* CCFileUtilsMac::createCCArrayWithContentsOfFile(const std::string& filename)
 {
     //    NSString* pPath = [NSString stringWithUTF8String:pFileName];
@@ -26,6 +26,7 @@ THE SOFTWARE.
 #include "CCGL.h"
 #include "ccMacros.h"
 #include "CCDirector.h"
+#include "shaders/ccGLStateCache.h"
 #include "CCInstance.h"
 #include "touch_dispatcher/CCTouch.h"
 #include "touch_dispatcher/CCTouchDispatcher.h"
@@ -158,7 +159,7 @@ void CCEGLView::setFrameSize(float width, float height)
 
 void CCEGLView::setViewPortInPoints(float x , float y , float w , float h)
 {
-    glViewport((GLint)(x * m_fScaleX * m_fFrameZoomFactor+ m_obViewPortRect.origin.x * m_fFrameZoomFactor),
+    ccGLViewport((GLint)(x * m_fScaleX * m_fFrameZoomFactor+ m_obViewPortRect.origin.x * m_fFrameZoomFactor),
             (GLint)(y * m_fScaleY * m_fFrameZoomFactor + m_obViewPortRect.origin.y * m_fFrameZoomFactor),
             (GLsizei)(w * m_fScaleX * m_fFrameZoomFactor),
             (GLsizei)(h * m_fScaleY * m_fFrameZoomFactor));
@@ -166,7 +167,7 @@ void CCEGLView::setViewPortInPoints(float x , float y , float w , float h)
 
 void CCEGLView::setScissorInPoints(float x , float y , float w , float h)
 {
-    glScissor((GLint)(x * m_fScaleX * m_fFrameZoomFactor + m_obViewPortRect.origin.x * m_fFrameZoomFactor),
+    ccGLScissor((GLint)(x * m_fScaleX * m_fFrameZoomFactor + m_obViewPortRect.origin.x * m_fFrameZoomFactor),
             (GLint)(y * m_fScaleY * m_fFrameZoomFactor + m_obViewPortRect.origin.y * m_fFrameZoomFactor),
             (GLsizei)(w * m_fScaleX * m_fFrameZoomFactor),
             (GLsizei)(h * m_fScaleY * m_fFrameZoomFactor));
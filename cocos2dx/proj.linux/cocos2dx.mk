@@ -7,6 +7,12 @@ CXXFLAGS += -MMD -Wall -Werror -fPIC
 ARFLAGS = cr
 
 DEFINES += -DLINUX
+# make CACHE_TEXTURE_DATA=1 keeps texture data on desktop too, so the texture
+# reload path (and the TextureReloadAsync test) can be run after a simulated
+# context loss
+ifeq ($(CACHE_TEXTURE_DATA),1)
+DEFINES += -DCC_ENABLE_CACHE_TEXTURE_DATA=1
+endif
 
 ifdef USE_BOX2D
 DEFINES += -DCC_ENABLE_BOX2D_INTEGRATION=1
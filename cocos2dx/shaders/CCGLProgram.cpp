@@ -32,6 +32,9 @@ THE SOFTWARE.
 #include "platform/CCFileUtils.h"
 #include "support/data_support/uthash.h"
 #include "cocoa/CCString.h"
+#include "support/CCProfiling.h"
+#include "CCConfiguration.h"
+#include <stdio.h>
 // extern
 #include "kazmath/GL/matrix.h"
 #include "kazmath/kazmath.h"
@@ -51,6 +54,11 @@ CCGLProgram::CCGLProgram()
 , m_uFragShader(0)
 , m_pHashForUniforms(NULL)
 , m_bUsesTime(false)
+, m_bDeferred(false)
+, m_bLoadedFromBinary(false)
+, m_fLoadTime(0.0f)
+, m_pVertSource(NULL)
+, m_pFragSource(NULL)
 {
     memset(m_uUniforms, 0, sizeof(m_uUniforms));
 }
@@ -120,6 +128,229 @@ bool CCGLProgram::initWithVertexShaderByteArray(const GLchar* vShaderByteArray,
     return true;
 }
 
+bool CCGLProgram::initWithVertexShaderByteArrayDeferred(const GLchar* vShaderByteArray, const GLchar* fShaderByteArray)
+{
+    m_uVertShader = m_uFragShader = 0;
+    m_pVertSource = vShaderByteArray;
+    m_pFragSource = fShaderByteArray;
+    m_tAttributes.clear();
+
+    m_bDeferred = true;
+    m_bLoadedFromBinary = false;
+    m_fLoadTime = 0.0f;
+
+    return true;
+}
+
+bool CCGLProgram::load()
+{
+    if (! m_bDeferred)
+    {
+        return m_uProgram != 0;
+    }
+    m_bDeferred = false;
+
+    CC_PROFILER_START("CCGLProgram - load");
+
+    struct cc_timeval start, end;
+    CCTime::gettimeofdayCocos2d(&start, NULL);
+
+    bool bLinked = false;
+
+#if CC_ENABLE_PROGRAM_BINARY_CACHE
+    std::string binaryPath = binaryCachePath();
+    m_bLoadedFromBinary = bLinked = (! binaryPath.empty() && loadBinary(binaryPath));
+#endif
+
+    if (! bLinked)
+    {
+        initWithVertexShaderByteArray(m_pVertSource, m_pFragSource);
+
+        for (unsigned int i = 0; i < m_tAttributes.size(); ++i)
+        {
+            glBindAttribLocation(m_uProgram, m_tAttributes[i].second, m_tAttributes[i].first.c_str());
+        }
+
+        bLinked = link();
+
+#if CC_ENABLE_PROGRAM_BINARY_CACHE
+        if (bLinked && ! binaryPath.empty())
+        {
+            saveBinary(binaryPath);
+        }
+#endif
+    }
+
+    if (bLinked)
+    {
+        updateUniforms();
+    }
+
+    CHECK_GL_ERROR_DEBUG();
+
+    CCTime::gettimeofdayCocos2d(&end, NULL);
+    m_fLoadTime = (float)CCTime::timersubCocos2d(&start, &end);
+
+    CC_PROFILER_STOP("CCGLProgram - load");
+
+    CCLOG("cocos2d: CCGLProgram: program %u %s in %.2f ms", m_uProgram, m_bLoadedFromBinary ? "read from the binary cache" : "compiled", m_fLoadTime);
+
+    return bLinked;
+}
+
+#if CC_ENABLE_PROGRAM_BINARY_CACHE
+
+// header of the files of the program binary cache
+static const char s_pszBinaryMagic[4] = { 'C', 'C', 'P', 'B' };
+
+static unsigned int hashBytes(unsigned int hash, const char* pBytes)
+{
+    // FNV-1a, hashing the terminating 0 too so that consecutive strings can't be confused
+    if (! pBytes)
+    {
+        pBytes = "";
+    }
+
+    do
+    {
+        hash ^= (unsigned char)*pBytes;
+        hash *= 16777619u;
+    } while (*pBytes++);
+
+    return hash;
+}
+
+std::string CCGLProgram::binaryCachePath()
+{
+    static int s_nBinarySupport = -1;
+    if (s_nBinarySupport < 0)
+    {
+        GLint nFormats = 0;
+        if (CCConfiguration::sharedConfiguration()->checkForGLExtension("GL_OES_get_program_binary")
+            && glGetProgramBinaryOES && glProgramBinaryOES)
+        {
+            glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS_OES, &nFormats);
+        }
+        s_nBinarySupport = (nFormats > 0) ? 1 : 0;
+        CCLOG("cocos2d: CCGLProgram: program binary cache %s", s_nBinarySupport ? "enabled" : "not supported");
+    }
+
+    if (! s_nBinarySupport || ! m_pVertSource || ! m_pFragSource)
+    {
+        return "";
+    }
+
+    // a binary is only valid for the same sources and attributes on the same driver
+    unsigned int hash = 2166136261u;
+    hash = hashBytes(hash, (const char*)glGetString(GL_VENDOR));
+    hash = hashBytes(hash, (const char*)glGetString(GL_RENDERER));
+    hash = hashBytes(hash, (const char*)glGetString(GL_VERSION));
+    hash = hashBytes(hash, m_pVertSource);
+    hash = hashBytes(hash, m_pFragSource);
+    for (unsigned int i = 0; i < m_tAttributes.size(); ++i)
+    {
+        char szIndex[16];
+        sprintf(szIndex, "%u", m_tAttributes[i].second);
+        hash = hashBytes(hash, m_tAttributes[i].first.c_str());
+        hash = hashBytes(hash, szIndex);
+    }
+
+    char szName[32];
+    sprintf(szName, "ccprogram-%08x.bin", hash);
+    return CCFileUtils::sharedFileUtils()->getWritablePath() + szName;
+}
+
+bool CCGLProgram::loadBinary(const std::string& path)
+{
+    bool bRet = false;
+    unsigned char* pData = NULL;
+    FILE* fp = fopen(path.c_str(), "rb");
+
+    do
+    {
+        CC_BREAK_IF(! fp);
+
+        char magic[4];
+        unsigned int header[2] = { 0, 0 };  // format, length
+        CC_BREAK_IF(fread(magic, sizeof(magic), 1, fp) != 1 || memcmp(magic, s_pszBinaryMagic, sizeof(magic)) != 0);
+        CC_BREAK_IF(fread(header, sizeof(header), 1, fp) != 1 || header[1] == 0);
+
+        pData = (unsigned char*)malloc(header[1]);
+        CC_BREAK_IF(! pData || fread(pData, header[1], 1, fp) != 1);
+
+        m_uProgram = glCreateProgram();
+        glProgramBinaryOES(m_uProgram, (GLenum)header[0], pData, (GLint)header[1]);
+
+        // the driver refuses the binaries of another version of itself
+        GLint status = GL_FALSE;
+        glGetProgramiv(m_uProgram, GL_LINK_STATUS, &status);
+        if (status != GL_TRUE)
+        {
+            CCLOG("cocos2d: CCGLProgram: the program binary %s is out of date, compiling the program", path.c_str());
+            ccGLDeleteProgram(m_uProgram);
+            m_uProgram = 0;
+            break;
+        }
+
+        bRet = true;
+    } while (0);
+
+    if (fp)
+    {
+        fclose(fp);
+        if (! bRet)
+        {
+            remove(path.c_str());
+        }
+    }
+    free(pData);
+
+    return bRet;
+}
+
+void CCGLProgram::saveBinary(const std::string& path)
+{
+    unsigned char* pData = NULL;
+    FILE* fp = NULL;
+
+    do
+    {
+        GLint length = 0;
+        glGetProgramiv(m_uProgram, GL_PROGRAM_BINARY_LENGTH_OES, &length);
+        CC_BREAK_IF(length <= 0);
+
+        pData = (unsigned char*)malloc(length);
+        CC_BREAK_IF(! pData);
+
+        GLsizei written = 0;
+        GLenum format = 0;
+        glGetProgramBinaryOES(m_uProgram, length, &written, &format, pData);
+        CC_BREAK_IF(written <= 0);
+
+        fp = fopen(path.c_str(), "wb");
+        CC_BREAK_IF(! fp);
+
+        unsigned int header[2] = { (unsigned int)format, (unsigned int)written };
+        if (fwrite(s_pszBinaryMagic, sizeof(s_pszBinaryMagic), 1, fp) != 1
+            || fwrite(header, sizeof(header), 1, fp) != 1
+            || fwrite(pData, written, 1, fp) != 1)
+        {
+            CCLOG("cocos2d: CCGLProgram: failed to write the program binary %s", path.c_str());
+            fclose(fp);
+            fp = NULL;
+            remove(path.c_str());
+        }
+    } while (0);
+
+    if (fp)
+    {
+        fclose(fp);
+    }
+    free(pData);
+}
+
+#endif // CC_ENABLE_PROGRAM_BINARY_CACHE
+
 bool CCGLProgram::initWithVertexShaderFilename(const char* vShaderFilename, const char* fShaderFilename)
 {
     const GLchar * vertexSource = (GLchar*) CCString::createWithContentsOfFile(CCFileUtils::sharedFileUtils()->fullPathForFilename(vShaderFilename).c_str())->getCString();
@@ -189,11 +420,23 @@ bool CCGLProgram::compileShader(GLuint * shader, GLenum type, const GLchar* sour
 
 void CCGLProgram::addAttribute(const char* attributeName, GLuint index)
 {
+    if (m_bDeferred)
+    {
+        m_tAttributes.push_back(std::make_pair(std::string(attributeName), index));
+        return;
+    }
+
     glBindAttribLocation(m_uProgram, index, attributeName);
 }
 
 void CCGLProgram::updateUniforms()
 {
+    if (m_bDeferred)
+    {
+        // done by load()
+        return;
+    }
+
     m_uUniforms[kCCUniformPMatrix] = glGetUniformLocation(m_uProgram, kCCUniformPMatrix_s);
 	m_uUniforms[kCCUniformMVMatrix] = glGetUniformLocation(m_uProgram, kCCUniformMVMatrix_s);
 	m_uUniforms[kCCUniformMVPMatrix] = glGetUniformLocation(m_uProgram, kCCUniformMVPMatrix_s);
@@ -220,6 +463,12 @@ void CCGLProgram::updateUniforms()
 
 bool CCGLProgram::link()
 {
+    if (m_bDeferred)
+    {
+        // done by load()
+        return true;
+    }
+
     CCAssert(m_uProgram != 0, "Cannot link invalid program");
     
     GLint status = GL_TRUE;
@@ -254,6 +503,11 @@ bool CCGLProgram::link()
 
 void CCGLProgram::use()
 {
+    if (m_bDeferred)
+    {
+        load();
+    }
+
     ccGLUseProgram(m_uProgram);
 }
 
@@ -327,12 +581,18 @@ bool CCGLProgram::updateUniformLocation(GLint location, GLvoid* data, unsigned i
         }
     }
 
+    ccGLCountStateCall(kCCGLStateUniform, ! updated);
     return updated;
 }
 
 GLint CCGLProgram::getUniformLocationForName(const char* name)
 {
     CCAssert(name != NULL, "Invalid uniform name" );
+
+    if (m_bDeferred)
+    {
+        load();
+    }
     CCAssert(m_uProgram != 0, "Invalid operation. Cannot get uniform location when program is not initialized");
     
     return glGetUniformLocation(m_uProgram, name);
@@ -497,6 +757,11 @@ void CCGLProgram::setUniformLocationWithMatrix4fv(GLint location, GLfloat* matri
 
 void CCGLProgram::setUniformsForBuiltins()
 {
+    if (m_bDeferred)
+    {
+        load();
+    }
+
     kmMat4 matrixP;
 	kmMat4 matrixMV;
 	kmMat4 matrixMVP;
@@ -532,6 +797,9 @@ void CCGLProgram::setUniformsForBuiltins()
 void CCGLProgram::reset()
 {
     m_uVertShader = m_uFragShader = 0;
+    m_bDeferred = false;
+    m_bLoadedFromBinary = false;
+    m_fLoadTime = 0.0f;
     memset(m_uUniforms, 0, sizeof(m_uUniforms));
     
 
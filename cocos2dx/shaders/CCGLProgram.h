@@ -32,6 +32,8 @@ THE SOFTWARE.
 #include "cocoa/CCObject.h"
 
 #include "CCGL.h"
+#include <string>
+#include <vector>
 
 NS_CC_BEGIN
 
@@ -69,6 +71,7 @@ enum {
 #define kCCShader_PositionTextureA8Color            "ShaderPositionTextureA8Color"
 #define kCCShader_Position_uColor                   "ShaderPosition_uColor"
 #define kCCShader_PositionLengthTexureColor         "ShaderPositionLengthTextureColor"
+#define kCCShader_PositionTextureColorRadialProgress "ShaderPositionTextureColorRadialProgress"
 
 // uniform names
 #define kCCUniformPMatrix_s				"CC_PMatrix"
@@ -80,6 +83,9 @@ enum {
 #define kCCUniformRandom01_s			"CC_Random01"
 #define kCCUniformSampler_s				"CC_Texture0"
 #define kCCUniformAlphaTestValue		"CC_alpha_value"
+#define kCCUniformProgressRect			"CC_progress_rect"
+#define kCCUniformProgressMidpoint		"CC_progress_midpoint"
+#define kCCUniformProgressSweep			"CC_progress_sweep"
 
 // Attribute names
 #define    kCCAttributeNameColor           "a_color"
@@ -104,6 +110,13 @@ public:
     virtual ~CCGLProgram();
     /** Initializes the CCGLProgram with a vertex and fragment with bytes array */
     bool initWithVertexShaderByteArray(const GLchar* vShaderByteArray, const GLchar* fShaderByteArray);
+    /** Initializes the CCGLProgram with a vertex and fragment with bytes array, without compiling them.
+     The shaders are compiled and linked with the attributes added by addAttribute(), or the program is read from the
+     program binary cache when CC_ENABLE_PROGRAM_BINARY_CACHE is enabled, the first time the program is used.
+     link() and updateUniforms() are done at that time too. The byte arrays must stay valid until then.
+     @since v2.1.4
+     */
+    bool initWithVertexShaderByteArrayDeferred(const GLchar* vShaderByteArray, const GLchar* fShaderByteArray);
     /** Initializes the CCGLProgram with a vertex and fragment with contents of filenames */
     bool initWithVertexShaderFilename(const char* vShaderFilename, const char* fShaderFilename);
     /**  It will add a new attribute to the shader */
@@ -112,6 +125,11 @@ public:
     bool link();
     /** it will call glUseProgram() */
     void use();
+    /** compiles and links a program initialized by initWithVertexShaderByteArrayDeferred(), if it isn't done yet.
+     It is done by use(), getProgram() and getUniformLocationForName() when needed.
+     @since v2.1.4
+     */
+    bool load();
 /** It will create 4 uniforms:
     - kCCUniformPMatrix
     - kCCUniformMVMatrix
@@ -186,13 +204,33 @@ public:
     // when opengl context lost, so don't call it.
     void reset();
     
-    inline const GLuint getProgram() { return m_uProgram; }
+    inline const GLuint getProgram() { if (m_bDeferred) load(); return m_uProgram; }
+
+    /** whether the program is compiled and linked, a deferred program isn't until it is used
+     @since v2.1.4
+     */
+    inline bool isLoaded() { return ! m_bDeferred; }
+
+    /** whether the deferred program was read from the program binary cache instead of being compiled
+     @since v2.1.4
+     */
+    inline bool isLoadedFromBinary() { return m_bLoadedFromBinary; }
+
+    /** milliseconds taken to compile and link the deferred program, or to read it from the program binary cache
+     @since v2.1.4
+     */
+    inline float getLoadTime() { return m_fLoadTime; }
 
 private:
     bool updateUniformLocation(GLint location, GLvoid* data, unsigned int bytes);
     const char* description();
     bool compileShader(GLuint * shader, GLenum type, const GLchar* source);
     const char* logForOpenGLObject(GLuint object, GLInfoFunction infoFunc, GLLogFunction logFunc);
+#if CC_ENABLE_PROGRAM_BINARY_CACHE
+    std::string binaryCachePath();
+    bool loadBinary(const std::string& path);
+    void saveBinary(const std::string& path);
+#endif
 
 private:
     GLuint            m_uProgram;
@@ -201,6 +239,14 @@ private:
     GLint             m_uUniforms[kCCUniform_MAX];
     struct _hashUniformEntry* m_pHashForUniforms;
     bool              m_bUsesTime;
+
+    // deferred program
+    bool              m_bDeferred;
+    bool              m_bLoadedFromBinary;
+    float             m_fLoadTime;
+    const GLchar*     m_pVertSource;
+    const GLchar*     m_pFragSource;
+    std::vector<std::pair<std::string, GLuint> > m_tAttributes;
 };
 
 // end of shaders group
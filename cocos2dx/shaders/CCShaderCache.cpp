@@ -40,6 +40,7 @@ enum {
     kCCShaderType_PositionTextureA8Color,
     kCCShaderType_Position_uColor,
     kCCShaderType_PositionLengthTexureColor,
+    kCCShaderType_PositionTextureColorRadialProgress,
     
     kCCShaderType_MAX,
 };
@@ -151,6 +152,15 @@ void CCShaderCache::loadDefaultShaders()
     
     m_pPrograms->setObject(p, kCCShader_PositionLengthTexureColor);
     p->release();
+
+    //
+    // Position Texture Color, clipped to the swept part of a radial progress
+    //
+    p = new CCGLProgram();
+    loadDefaultShader(p, kCCShaderType_PositionTextureColorRadialProgress);
+
+    m_pPrograms->setObject(p, kCCShader_PositionTextureColorRadialProgress);
+    p->release();
 }
 
 void CCShaderCache::reloadDefaultShaders()
@@ -207,14 +217,69 @@ void CCShaderCache::reloadDefaultShaders()
 	//
     p = programForKey(kCCShader_PositionLengthTexureColor);
     p->reset();
-    loadDefaultShader(p, kCCShaderType_Position_uColor);
+    loadDefaultShader(p, kCCShaderType_PositionLengthTexureColor);
+
+    //
+    // Position Texture Color, clipped to the swept part of a radial progress
+    //
+    p = programForKey(kCCShader_PositionTextureColorRadialProgress);
+    p->reset();
+    loadDefaultShader(p, kCCShaderType_PositionTextureColorRadialProgress);
+}
+
+void CCShaderCache::preloadPrograms()
+{
+    CCDictElement* pElement = NULL;
+    CCDICT_FOREACH(m_pPrograms, pElement)
+    {
+        ((CCGLProgram*)pElement->getObject())->load();
+    }
+}
+
+unsigned int CCShaderCache::getLoadedProgramCount()
+{
+    unsigned int uCount = 0;
+    CCDictElement* pElement = NULL;
+    CCDICT_FOREACH(m_pPrograms, pElement)
+    {
+        if (((CCGLProgram*)pElement->getObject())->isLoaded())
+        {
+            ++uCount;
+        }
+    }
+    return uCount;
+}
+
+unsigned int CCShaderCache::getBinaryProgramCount()
+{
+    unsigned int uCount = 0;
+    CCDictElement* pElement = NULL;
+    CCDICT_FOREACH(m_pPrograms, pElement)
+    {
+        if (((CCGLProgram*)pElement->getObject())->isLoadedFromBinary())
+        {
+            ++uCount;
+        }
+    }
+    return uCount;
+}
+
+float CCShaderCache::getProgramLoadTime()
+{
+    float fTime = 0.0f;
+    CCDictElement* pElement = NULL;
+    CCDICT_FOREACH(m_pPrograms, pElement)
+    {
+        fTime += ((CCGLProgram*)pElement->getObject())->getLoadTime();
+    }
+    return fTime;
 }
 
 void CCShaderCache::loadDefaultShader(CCGLProgram *p, int type)
 {
     switch (type) {
         case kCCShaderType_PositionTextureColor:
-            p->initWithVertexShaderByteArray(ccPositionTextureColor_vert, ccPositionTextureColor_frag);
+            p->initWithVertexShaderByteArrayDeferred(ccPositionTextureColor_vert, ccPositionTextureColor_frag);
             
             p->addAttribute(kCCAttributeNamePosition, kCCVertexAttrib_Position);
             p->addAttribute(kCCAttributeNameColor, kCCVertexAttrib_Color);
@@ -222,7 +287,7 @@ void CCShaderCache::loadDefaultShader(CCGLProgram *p, int type)
             
             break;
         case kCCShaderType_PositionTextureColorAlphaTest:
-            p->initWithVertexShaderByteArray(ccPositionTextureColor_vert, ccPositionTextureColorAlphaTest_frag);
+            p->initWithVertexShaderByteArrayDeferred(ccPositionTextureColor_vert, ccPositionTextureColorAlphaTest_frag);
             
             p->addAttribute(kCCAttributeNamePosition, kCCVertexAttrib_Position);
             p->addAttribute(kCCAttributeNameColor, kCCVertexAttrib_Color);
@@ -230,28 +295,28 @@ void CCShaderCache::loadDefaultShader(CCGLProgram *p, int type)
 
             break;
         case kCCShaderType_PositionColor:  
-            p->initWithVertexShaderByteArray(ccPositionColor_vert ,ccPositionColor_frag);
+            p->initWithVertexShaderByteArrayDeferred(ccPositionColor_vert ,ccPositionColor_frag);
             
             p->addAttribute(kCCAttributeNamePosition, kCCVertexAttrib_Position);
             p->addAttribute(kCCAttributeNameColor, kCCVertexAttrib_Color);
 
             break;
         case kCCShaderType_PositionTexture:
-            p->initWithVertexShaderByteArray(ccPositionTexture_vert ,ccPositionTexture_frag);
+            p->initWithVertexShaderByteArrayDeferred(ccPositionTexture_vert ,ccPositionTexture_frag);
             
             p->addAttribute(kCCAttributeNamePosition, kCCVertexAttrib_Position);
             p->addAttribute(kCCAttributeNameTexCoord, kCCVertexAttrib_TexCoords);
 
             break;
         case kCCShaderType_PositionTexture_uColor:
-            p->initWithVertexShaderByteArray(ccPositionTexture_uColor_vert, ccPositionTexture_uColor_frag);
+            p->initWithVertexShaderByteArrayDeferred(ccPositionTexture_uColor_vert, ccPositionTexture_uColor_frag);
             
             p->addAttribute(kCCAttributeNamePosition, kCCVertexAttrib_Position);
             p->addAttribute(kCCAttributeNameTexCoord, kCCVertexAttrib_TexCoords);
 
             break;
         case kCCShaderType_PositionTextureA8Color:
-            p->initWithVertexShaderByteArray(ccPositionTextureA8Color_vert, ccPositionTextureA8Color_frag);
+            p->initWithVertexShaderByteArrayDeferred(ccPositionTextureA8Color_vert, ccPositionTextureA8Color_frag);
             
             p->addAttribute(kCCAttributeNamePosition, kCCVertexAttrib_Position);
             p->addAttribute(kCCAttributeNameColor, kCCVertexAttrib_Color);
@@ -259,28 +324,35 @@ void CCShaderCache::loadDefaultShader(CCGLProgram *p, int type)
 
             break;
         case kCCShaderType_Position_uColor:
-            p->initWithVertexShaderByteArray(ccPosition_uColor_vert, ccPosition_uColor_frag);    
+            p->initWithVertexShaderByteArrayDeferred(ccPosition_uColor_vert, ccPosition_uColor_frag);    
             
             p->addAttribute("aVertex", kCCVertexAttrib_Position);    
             
             break;
         case kCCShaderType_PositionLengthTexureColor:
-            p->initWithVertexShaderByteArray(ccPositionColorLengthTexture_vert, ccPositionColorLengthTexture_frag);
+            p->initWithVertexShaderByteArrayDeferred(ccPositionColorLengthTexture_vert, ccPositionColorLengthTexture_frag);
             
             p->addAttribute(kCCAttributeNamePosition, kCCVertexAttrib_Position);
             p->addAttribute(kCCAttributeNameTexCoord, kCCVertexAttrib_TexCoords);
             p->addAttribute(kCCAttributeNameColor, kCCVertexAttrib_Color);
             
+            break;
+        case kCCShaderType_PositionTextureColorRadialProgress:
+            p->initWithVertexShaderByteArrayDeferred(ccPositionTextureColorRadialProgress_vert, ccPositionTextureColorRadialProgress_frag);
+
+            p->addAttribute(kCCAttributeNamePosition, kCCVertexAttrib_Position);
+            p->addAttribute(kCCAttributeNameColor, kCCVertexAttrib_Color);
+            p->addAttribute(kCCAttributeNameTexCoord, kCCVertexAttrib_TexCoords);
+
             break;
         default:
             CCLOG("cocos2d: %s:%d, error shader type", __FUNCTION__, __LINE__);
             return;
     }
     
+    // compiled and linked by CCGLProgram::load() the first time the program is used
     p->link();
     p->updateUniforms();
-    
-    CHECK_GL_ERROR_DEBUG();
 }
 
 CCGLProgram* CCShaderCache::programForKey(const char* key)
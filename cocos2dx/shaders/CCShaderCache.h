@@ -54,12 +54,32 @@ public:
     /** purges the cache. It releases the retained instance. */
     static void purgeSharedShaderCache();
 
-    /** loads the default shaders */
+    /** loads the default shaders. They are compiled the first time they are used, see CCGLProgram::initWithVertexShaderByteArrayDeferred() */
     void loadDefaultShaders();
     
-    /** reload the default shaders */
+    /** reload the default shaders. They are compiled again the first time they are used */
     void reloadDefaultShaders();
 
+    /** compiles the programs of the cache that are not compiled yet, to avoid doing it during the game.
+     @since v2.1.4
+     */
+    void preloadPrograms();
+
+    /** number of programs of the cache that are compiled, or read from the program binary cache
+     @since v2.1.4
+     */
+    unsigned int getLoadedProgramCount();
+
+    /** number of programs of the cache that were read from the program binary cache instead of being compiled
+     @since v2.1.4
+     */
+    unsigned int getBinaryProgramCount();
+
+    /** milliseconds taken to compile or read the programs of the cache that are loaded
+     @since v2.1.4
+     */
+    float getProgramLoadTime();
+
     /** returns a GL program for a given key */
     CCGLProgram * programForKey(const char* key);
 
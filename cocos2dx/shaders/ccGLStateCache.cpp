@@ -40,6 +40,12 @@ static bool        s_bVertexAttribPosition = false;
 static bool        s_bVertexAttribColor = false;
 static bool        s_bVertexAttribTexCoords = false;
 
+// GL calls made and skipped, during the current frame and the last one
+static unsigned int s_uIssuedCalls[kCCGLStateCount] = {0};
+static unsigned int s_uFilteredCalls[kCCGLStateCount] = {0};
+static unsigned int s_uLastIssuedCalls[kCCGLStateCount] = {0};
+static unsigned int s_uLastFilteredCalls[kCCGLStateCount] = {0};
+
 
 #if CC_ENABLE_GL_STATE_CACHE
 
@@ -53,6 +59,29 @@ static int       s_eGLServerState = 0;
 #if CC_TEXTURE_ATLAS_USE_VAO
 static GLuint    s_uVAO = 0;
 #endif
+static GLuint    s_uCurrentArrayBuffer = -1;
+static GLuint    s_uCurrentElementArrayBuffer = -1;
+static GLenum    s_eActiveTexture = -1;
+
+// the capabilities that are cached, -1 when their state is unknown
+#define kCCCachedCapabilityCount 5
+static const GLenum s_eCachedCapabilities[kCCCachedCapabilityCount] = { GL_BLEND, GL_DEPTH_TEST, GL_STENCIL_TEST, GL_SCISSOR_TEST, GL_CULL_FACE };
+static int       s_nCapabilityState[kCCCachedCapabilityCount] = { -1, -1, -1, -1, -1 };
+
+static bool      s_bViewportValid = false;
+static GLint     s_nViewport[4];
+static bool      s_bScissorValid = false;
+static GLint     s_nScissor[4];
+static GLenum    s_eDepthFunc = -1;
+static int       s_nDepthMask = -1;
+static bool      s_bStencilFuncValid = false;
+static GLenum    s_eStencilFunc;
+static GLint     s_nStencilRef;
+static GLuint    s_uStencilValueMask;
+static bool      s_bStencilOpValid = false;
+static GLenum    s_eStencilOp[3];
+static bool      s_bStencilMaskValid = false;
+static GLuint    s_uStencilWriteMask;
 #endif // CC_ENABLE_GL_STATE_CACHE
 
 // GL State Cache functions
@@ -76,6 +105,21 @@ void ccGLInvalidateStateCache( void )
     s_eBlendingSource = -1;
     s_eBlendingDest = -1;
     s_eGLServerState = 0;
+
+    s_uCurrentArrayBuffer = -1;
+    s_uCurrentElementArrayBuffer = -1;
+    s_eActiveTexture = -1;
+    for( int i=0; i < kCCCachedCapabilityCount; i++ )
+    {
+        s_nCapabilityState[i] = -1;
+    }
+    s_bViewportValid = false;
+    s_bScissorValid = false;
+    s_eDepthFunc = -1;
+    s_nDepthMask = -1;
+    s_bStencilFuncValid = false;
+    s_bStencilOpValid = false;
+    s_bStencilMaskValid = false;
 #endif
 }
 
@@ -97,9 +141,15 @@ void ccGLUseProgram( GLuint program )
     if( program != s_uCurrentShaderProgram ) {
         s_uCurrentShaderProgram = program;
         glUseProgram(program);
+        ccGLCountStateCall(kCCGLStateProgram, false);
+    }
+    else
+    {
+        ccGLCountStateCall(kCCGLStateProgram, true);
     }
 #else
     glUseProgram(program);
+    ccGLCountStateCall(kCCGLStateProgram, false);
 #endif // CC_ENABLE_GL_STATE_CACHE
 }
 
@@ -107,12 +157,13 @@ static void SetBlending(GLenum sfactor, GLenum dfactor)
 {
 	if (sfactor == GL_ONE && dfactor == GL_ZERO)
     {
-		glDisable(GL_BLEND);
+		ccGLSetCapability(GL_BLEND, false);
 	}
     else
     {
-		glEnable(GL_BLEND);
+		ccGLSetCapability(GL_BLEND, true);
 		glBlendFunc(sfactor, dfactor);
+		ccGLCountStateCall(kCCGLStateBlend, false);
 	}
 }
 
@@ -125,6 +176,10 @@ void ccGLBlendFunc(GLenum sfactor, GLenum dfactor)
         s_eBlendingDest = dfactor;
         SetBlending(sfactor, dfactor);
     }
+    else
+    {
+        ccGLCountStateCall(kCCGLStateBlend, true);
+    }
 #else
     SetBlending( sfactor, dfactor );
 #endif // CC_ENABLE_GL_STATE_CACHE
@@ -152,12 +207,18 @@ void ccGLBindTexture2DN(GLuint textureUnit, GLuint textureId)
     if (s_uCurrentBoundTexture[textureUnit] != textureId)
     {
         s_uCurrentBoundTexture[textureUnit] = textureId;
-        glActiveTexture(GL_TEXTURE0 + textureUnit);
+        ccGLActiveTexture(GL_TEXTURE0 + textureUnit);
         glBindTexture(GL_TEXTURE_2D, textureId);
+        ccGLCountStateCall(kCCGLStateTexture, false);
+    }
+    else
+    {
+        ccGLCountStateCall(kCCGLStateTexture, true);
     }
 #else
-    glActiveTexture(GL_TEXTURE0 + textureUnit);
+    ccGLActiveTexture(GL_TEXTURE0 + textureUnit);
     glBindTexture(GL_TEXTURE_2D, textureId);
+    ccGLCountStateCall(kCCGLStateTexture, false);
 #endif
 }
 
@@ -188,9 +249,18 @@ void ccGLBindVAO(GLuint vaoId)
 	{
 		s_uVAO = vaoId;
 		glBindVertexArray(vaoId);
+		ccGLCountStateCall(kCCGLStateVAO, false);
+
+		// the element array buffer binding is part of the vertex array state
+		s_uCurrentElementArrayBuffer = -1;
+	}
+	else
+	{
+		ccGLCountStateCall(kCCGLStateVAO, true);
 	}
 #else
 	glBindVertexArray(vaoId);
+	ccGLCountStateCall(kCCGLStateVAO, false);
 #endif // CC_ENABLE_GL_STATE_CACHE
     
 #endif
@@ -237,6 +307,11 @@ void ccGLEnableVertexAttribs( unsigned int flags )
             glDisableVertexAttribArray( kCCVertexAttrib_Position );
 
         s_bVertexAttribPosition = enablePosition;
+        ccGLCountStateCall(kCCGLStateVertexAttribs, false);
+    }
+    else
+    {
+        ccGLCountStateCall(kCCGLStateVertexAttribs, true);
     }
 
     /* Color */
@@ -249,6 +324,11 @@ void ccGLEnableVertexAttribs( unsigned int flags )
             glDisableVertexAttribArray( kCCVertexAttrib_Color );
 
         s_bVertexAttribColor = enableColor;
+        ccGLCountStateCall(kCCGLStateVertexAttribs, false);
+    }
+    else
+    {
+        ccGLCountStateCall(kCCGLStateVertexAttribs, true);
     }
 
     /* Tex Coords */
@@ -261,6 +341,11 @@ void ccGLEnableVertexAttribs( unsigned int flags )
             glDisableVertexAttribArray( kCCVertexAttrib_TexCoords );
 
         s_bVertexAttribTexCoords = enableTexCoords;
+        ccGLCountStateCall(kCCGLStateVertexAttribs, false);
+    }
+    else
+    {
+        ccGLCountStateCall(kCCGLStateVertexAttribs, true);
     }
 }
 
@@ -271,4 +356,268 @@ void ccSetProjectionMatrixDirty( void )
     s_uCurrentProjectionMatrix = -1;
 }
 
+//#pragma mark - GL Buffer functions
+
+void ccGLBindBuffer(GLenum target, GLuint buffer)
+{
+#if CC_ENABLE_GL_STATE_CACHE
+    GLuint *current = NULL;
+    if (target == GL_ARRAY_BUFFER)
+    {
+        current = &s_uCurrentArrayBuffer;
+    }
+    else if (target == GL_ELEMENT_ARRAY_BUFFER)
+    {
+        current = &s_uCurrentElementArrayBuffer;
+    }
+
+    if (current && *current == buffer)
+    {
+        ccGLCountStateCall(kCCGLStateBuffer, true);
+        return;
+    }
+
+    if (current)
+    {
+        *current = buffer;
+    }
+#endif // CC_ENABLE_GL_STATE_CACHE
+
+    glBindBuffer(target, buffer);
+    ccGLCountStateCall(kCCGLStateBuffer, false);
+}
+
+void ccGLDeleteBuffers(GLsizei n, const GLuint *buffers)
+{
+#if CC_ENABLE_GL_STATE_CACHE
+    // GL unbinds the buffers it deletes
+    for (GLsizei i = 0; i < n; i++)
+    {
+        if (buffers[i] == s_uCurrentArrayBuffer)
+        {
+            s_uCurrentArrayBuffer = 0;
+        }
+        if (buffers[i] == s_uCurrentElementArrayBuffer)
+        {
+            s_uCurrentElementArrayBuffer = 0;
+        }
+    }
+#endif // CC_ENABLE_GL_STATE_CACHE
+
+    glDeleteBuffers(n, buffers);
+}
+
+//#pragma mark - GL server side state functions
+
+void ccGLActiveTexture(GLenum texture)
+{
+#if CC_ENABLE_GL_STATE_CACHE
+    if (s_eActiveTexture == texture)
+    {
+        ccGLCountStateCall(kCCGLStateTexture, true);
+        return;
+    }
+    s_eActiveTexture = texture;
+#endif // CC_ENABLE_GL_STATE_CACHE
+
+    glActiveTexture(texture);
+    ccGLCountStateCall(kCCGLStateTexture, false);
+}
+
+void ccGLSetCapability(GLenum capability, bool enabled)
+{
+#if CC_ENABLE_GL_STATE_CACHE
+    for (int i = 0; i < kCCCachedCapabilityCount; i++)
+    {
+        if (s_eCachedCapabilities[i] == capability)
+        {
+            if (s_nCapabilityState[i] == (enabled ? 1 : 0))
+            {
+                ccGLCountStateCall(kCCGLStateCapability, true);
+                return;
+            }
+            s_nCapabilityState[i] = enabled ? 1 : 0;
+            break;
+        }
+    }
+#endif // CC_ENABLE_GL_STATE_CACHE
+
+    if (enabled)
+    {
+        glEnable(capability);
+    }
+    else
+    {
+        glDisable(capability);
+    }
+    ccGLCountStateCall(kCCGLStateCapability, false);
+}
+
+void ccGLViewport(GLint x, GLint y, GLsizei width, GLsizei height)
+{
+#if CC_ENABLE_GL_STATE_CACHE
+    GLint viewport[4] = { x, y, width, height };
+    if (s_bViewportValid && memcmp(s_nViewport, viewport, sizeof(viewport)) == 0)
+    {
+        ccGLCountStateCall(kCCGLStateViewport, true);
+        return;
+    }
+    memcpy(s_nViewport, viewport, sizeof(viewport));
+    s_bViewportValid = true;
+#endif // CC_ENABLE_GL_STATE_CACHE
+
+    glViewport(x, y, width, height);
+    ccGLCountStateCall(kCCGLStateViewport, false);
+}
+
+void ccGLGetViewport(GLint *viewport)
+{
+#if CC_ENABLE_GL_STATE_CACHE
+    if (s_bViewportValid)
+    {
+        memcpy(viewport, s_nViewport, sizeof(s_nViewport));
+        return;
+    }
+    glGetIntegerv(GL_VIEWPORT, s_nViewport);
+    s_bViewportValid = true;
+    memcpy(viewport, s_nViewport, sizeof(s_nViewport));
+#else
+    glGetIntegerv(GL_VIEWPORT, viewport);
+#endif // CC_ENABLE_GL_STATE_CACHE
+}
+
+void ccGLScissor(GLint x, GLint y, GLsizei width, GLsizei height)
+{
+#if CC_ENABLE_GL_STATE_CACHE
+    GLint scissor[4] = { x, y, width, height };
+    if (s_bScissorValid && memcmp(s_nScissor, scissor, sizeof(scissor)) == 0)
+    {
+        ccGLCountStateCall(kCCGLStateViewport, true);
+        return;
+    }
+    memcpy(s_nScissor, scissor, sizeof(scissor));
+    s_bScissorValid = true;
+#endif // CC_ENABLE_GL_STATE_CACHE
+
+    glScissor(x, y, width, height);
+    ccGLCountStateCall(kCCGLStateViewport, false);
+}
+
+void ccGLDepthFunc(GLenum func)
+{
+#if CC_ENABLE_GL_STATE_CACHE
+    if (s_eDepthFunc == func)
+    {
+        ccGLCountStateCall(kCCGLStateDepthStencil, true);
+        return;
+    }
+    s_eDepthFunc = func;
+#endif // CC_ENABLE_GL_STATE_CACHE
+
+    glDepthFunc(func);
+    ccGLCountStateCall(kCCGLStateDepthStencil, false);
+}
+
+void ccGLDepthMask(GLboolean flag)
+{
+#if CC_ENABLE_GL_STATE_CACHE
+    if (s_nDepthMask == (flag ? 1 : 0))
+    {
+        ccGLCountStateCall(kCCGLStateDepthStencil, true);
+        return;
+    }
+    s_nDepthMask = flag ? 1 : 0;
+#endif // CC_ENABLE_GL_STATE_CACHE
+
+    glDepthMask(flag);
+    ccGLCountStateCall(kCCGLStateDepthStencil, false);
+}
+
+void ccGLStencilFunc(GLenum func, GLint ref, GLuint mask)
+{
+#if CC_ENABLE_GL_STATE_CACHE
+    if (s_bStencilFuncValid && s_eStencilFunc == func && s_nStencilRef == ref && s_uStencilValueMask == mask)
+    {
+        ccGLCountStateCall(kCCGLStateDepthStencil, true);
+        return;
+    }
+    s_eStencilFunc = func;
+    s_nStencilRef = ref;
+    s_uStencilValueMask = mask;
+    s_bStencilFuncValid = true;
+#endif // CC_ENABLE_GL_STATE_CACHE
+
+    glStencilFunc(func, ref, mask);
+    ccGLCountStateCall(kCCGLStateDepthStencil, false);
+}
+
+void ccGLStencilOp(GLenum fail, GLenum zfail, GLenum zpass)
+{
+#if CC_ENABLE_GL_STATE_CACHE
+    if (s_bStencilOpValid && s_eStencilOp[0] == fail && s_eStencilOp[1] == zfail && s_eStencilOp[2] == zpass)
+    {
+        ccGLCountStateCall(kCCGLStateDepthStencil, true);
+        return;
+    }
+    s_eStencilOp[0] = fail;
+    s_eStencilOp[1] = zfail;
+    s_eStencilOp[2] = zpass;
+    s_bStencilOpValid = true;
+#endif // CC_ENABLE_GL_STATE_CACHE
+
+    glStencilOp(fail, zfail, zpass);
+    ccGLCountStateCall(kCCGLStateDepthStencil, false);
+}
+
+void ccGLStencilMask(GLuint mask)
+{
+#if CC_ENABLE_GL_STATE_CACHE
+    if (s_bStencilMaskValid && s_uStencilWriteMask == mask)
+    {
+        ccGLCountStateCall(kCCGLStateDepthStencil, true);
+        return;
+    }
+    s_uStencilWriteMask = mask;
+    s_bStencilMaskValid = true;
+#endif // CC_ENABLE_GL_STATE_CACHE
+
+    glStencilMask(mask);
+    ccGLCountStateCall(kCCGLStateDepthStencil, false);
+}
+
+//#pragma mark - GL state statistics
+
+void ccGLCountStateCall(ccGLStateCategory category, bool filtered)
+{
+    if (filtered)
+    {
+        ++s_uFilteredCalls[category];
+    }
+    else
+    {
+        ++s_uIssuedCalls[category];
+    }
+}
+
+void ccGLGetStateStats(ccGLStateCategory category, unsigned int *pIssued, unsigned int *pFiltered)
+{
+    CCAssert(category < kCCGLStateCount, "invalid GL state category");
+    if (pIssued)
+    {
+        *pIssued = s_uLastIssuedCalls[category];
+    }
+    if (pFiltered)
+    {
+        *pFiltered = s_uLastFilteredCalls[category];
+    }
+}
+
+void ccGLEndStateStatsFrame(void)
+{
+    memcpy(s_uLastIssuedCalls, s_uIssuedCalls, sizeof(s_uIssuedCalls));
+    memcpy(s_uLastFilteredCalls, s_uFilteredCalls, sizeof(s_uFilteredCalls));
+    memset(s_uIssuedCalls, 0, sizeof(s_uIssuedCalls));
+    memset(s_uFilteredCalls, 0, sizeof(s_uFilteredCalls));
+}
+
 NS_CC_END
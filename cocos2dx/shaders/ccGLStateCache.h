@@ -64,7 +64,37 @@ typedef enum {
 
 } ccGLServerState;
 
+/** kinds of GL calls counted by the state cache
+ @since v2.1.4
+ */
+typedef enum {
+    //! glUseProgram
+    kCCGLStateProgram = 0,
+    //! glBindTexture, glActiveTexture
+    kCCGLStateTexture,
+    //! glBlendFunc
+    kCCGLStateBlend,
+    //! glEnableVertexAttribArray, glDisableVertexAttribArray
+    kCCGLStateVertexAttribs,
+    //! glBindVertexArray
+    kCCGLStateVAO,
+    //! glBindBuffer
+    kCCGLStateBuffer,
+    //! glEnable, glDisable
+    kCCGLStateCapability,
+    //! glViewport, glScissor
+    kCCGLStateViewport,
+    //! glDepthFunc, glDepthMask, glStencilFunc, glStencilOp, glStencilMask
+    kCCGLStateDepthStencil,
+    //! glUniform*, filtered by CCGLProgram
+    kCCGLStateUniform,
+
+    kCCGLStateCount,
+} ccGLStateCategory;
+
 /** @file ccGLStateCache.h
+ The ccGL functions skip the GL calls that would not change the state, if CC_ENABLE_GL_STATE_CACHE is enabled.
+ A state changed by calling GL directly must be followed by ccGLInvalidateStateCache().
 */
 
 /** Invalidates the GL state cache.
@@ -152,6 +182,96 @@ void CC_DLL ccGLBindVAO(GLuint vaoId);
  */
 void CC_DLL ccGLEnable( ccGLServerState flags );
 
+/** If the buffer is not already bound to the target, it binds it.
+ The GL_ARRAY_BUFFER and GL_ELEMENT_ARRAY_BUFFER bindings are cached.
+ If CC_ENABLE_GL_STATE_CACHE is disabled, it will call glBindBuffer() directly.
+ @since v2.1.4
+ */
+void CC_DLL ccGLBindBuffer(GLenum target, GLuint buffer);
+
+/** Deletes buffers. If one of them is bound, it invalidates its binding.
+ If CC_ENABLE_GL_STATE_CACHE is disabled, it will call glDeleteBuffers() directly.
+ @since v2.1.4
+ */
+void CC_DLL ccGLDeleteBuffers(GLsizei n, const GLuint *buffers);
+
+/** Selects the active texture unit in case it is different than the current one.
+ If CC_ENABLE_GL_STATE_CACHE is disabled, it will call glActiveTexture() directly.
+ @since v2.1.4
+ */
+void CC_DLL ccGLActiveTexture(GLenum texture);
+
+/** Enables or disables a server side capability in case it is not already.
+ GL_BLEND, GL_DEPTH_TEST, GL_STENCIL_TEST, GL_SCISSOR_TEST and GL_CULL_FACE are cached.
+ If CC_ENABLE_GL_STATE_CACHE is disabled, it will call glEnable() or glDisable() directly.
+ @since v2.1.4
+ */
+void CC_DLL ccGLSetCapability(GLenum capability, bool enabled);
+
+/** Sets the viewport in case it is different than the current one.
+ If CC_ENABLE_GL_STATE_CACHE is disabled, it will call glViewport() directly.
+ @since v2.1.4
+ */
+void CC_DLL ccGLViewport(GLint x, GLint y, GLsizei width, GLsizei height);
+
+/** Gets the current viewport: x, y, width and height.
+ It is read from GL only if CC_ENABLE_GL_STATE_CACHE is disabled or the viewport is not cached yet.
+ @since v2.1.4
+ */
+void CC_DLL ccGLGetViewport(GLint *viewport);
+
+/** Sets the scissor box in case it is different than the current one.
+ If CC_ENABLE_GL_STATE_CACHE is disabled, it will call glScissor() directly.
+ @since v2.1.4
+ */
+void CC_DLL ccGLScissor(GLint x, GLint y, GLsizei width, GLsizei height);
+
+/** Sets the depth function in case it is different than the current one.
+ If CC_ENABLE_GL_STATE_CACHE is disabled, it will call glDepthFunc() directly.
+ @since v2.1.4
+ */
+void CC_DLL ccGLDepthFunc(GLenum func);
+
+/** Enables or disables writing into the depth buffer in case it is not already.
+ If CC_ENABLE_GL_STATE_CACHE is disabled, it will call glDepthMask() directly.
+ @since v2.1.4
+ */
+void CC_DLL ccGLDepthMask(GLboolean flag);
+
+/** Sets the stencil test function in case it is different than the current one.
+ If CC_ENABLE_GL_STATE_CACHE is disabled, it will call glStencilFunc() directly.
+ @since v2.1.4
+ */
+void CC_DLL ccGLStencilFunc(GLenum func, GLint ref, GLuint mask);
+
+/** Sets the stencil test actions in case they are different than the current ones.
+ If CC_ENABLE_GL_STATE_CACHE is disabled, it will call glStencilOp() directly.
+ @since v2.1.4
+ */
+void CC_DLL ccGLStencilOp(GLenum fail, GLenum zfail, GLenum zpass);
+
+/** Sets the stencil write mask in case it is different than the current one.
+ If CC_ENABLE_GL_STATE_CACHE is disabled, it will call glStencilMask() directly.
+ @since v2.1.4
+ */
+void CC_DLL ccGLStencilMask(GLuint mask);
+
+/** Counts a GL call of a category, made or skipped because it would not change the state.
+ It is called by the ccGL functions and by CCGLProgram for the uniforms.
+ @since v2.1.4
+ */
+void CC_DLL ccGLCountStateCall(ccGLStateCategory category, bool filtered);
+
+/** Returns the number of GL calls of a category made and skipped during the last frame.
+ @since v2.1.4
+ */
+void CC_DLL ccGLGetStateStats(ccGLStateCategory category, unsigned int *pIssued, unsigned int *pFiltered);
+
+/** Ends the frame of the GL calls counted by ccGLGetStateStats(). It is called by CCDirector after each frame.
+ @since v2.1.4
+ */
+void CC_DLL ccGLEndStateStatsFrame(void);
+
 // end of shaders group
 /// @}
 
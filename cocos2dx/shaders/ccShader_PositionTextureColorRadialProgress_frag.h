@@ -0,0 +1,51 @@
+/*
+ * cocos2d-x   http://www.cocos2d-x.org
+ *
+ * Copyright (c) 2013 cocos2d-x.org
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+"																	\n\
+#ifdef GL_ES														\n\
+precision mediump float;											\n\
+#endif																\n\
+																	\n\
+varying vec4 v_fragmentColor;										\n\
+varying vec2 v_texCoord;											\n\
+varying vec2 v_progressPoint;										\n\
+uniform sampler2D CC_Texture0;										\n\
+// center of the progress in the unit square of the quad			\n\
+uniform vec2 CC_progress_midpoint;									\n\
+// swept angle in radians, 1 clockwise or -1 counter-clockwise		\n\
+uniform vec2 CC_progress_sweep;										\n\
+																	\n\
+void main()															\n\
+{																	\n\
+    vec2 d = v_progressPoint - CC_progress_midpoint;				\n\
+    // angle from 12 o'clock in the direction of the progress		\n\
+    float angle = atan(d.x * CC_progress_sweep.y, d.y);				\n\
+    if (angle < 0.0)												\n\
+        angle += 6.2831853;											\n\
+    if (angle >= CC_progress_sweep.x)								\n\
+        discard;													\n\
+																	\n\
+    gl_FragColor = v_fragmentColor * texture2D(CC_Texture0, v_texCoord);	\n\
+}																	\n\
+";
@@ -74,4 +74,9 @@ const GLchar * ccPositionColorLengthTexture_frag =
 const GLchar * ccPositionColorLengthTexture_vert =
 #include "ccShader_PositionColorLengthTexture_vert.h"
 
+const GLchar * ccPositionTextureColorRadialProgress_frag =
+#include "ccShader_PositionTextureColorRadialProgress_frag.h"
+const GLchar * ccPositionTextureColorRadialProgress_vert =
+#include "ccShader_PositionTextureColorRadialProgress_vert.h"
+
 NS_CC_END
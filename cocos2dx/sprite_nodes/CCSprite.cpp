@@ -313,6 +313,7 @@ void CCSprite::setTextureRect(const CCRect& rect)
 void CCSprite::setTextureRect(const CCRect& rect, bool rotated, const CCSize& untrimmedSize)
 {
     m_bRectRotated = rotated;
+    setBitmapCacheDirty();
 
     setContentSize(untrimmedSize);
     setVertexRect(rect);
@@ -892,6 +893,8 @@ bool CCSprite::isFlipY(void)
 
 void CCSprite::updateColor(void)
 {
+    setBitmapCacheDirty();
+
     ccColor4B color4 = { _displayedColor.r, _displayedColor.g, _displayedColor.b, _displayedOpacity };
     
     // special opacity for premultiplied textures
@@ -1086,6 +1089,7 @@ void CCSprite::setTexture(CCTexture2D *texture)
         CC_SAFE_RELEASE(m_pobTexture);
         m_pobTexture = texture;
         updateBlendFunc();
+        setBitmapCacheDirty();
     }
 }
 
@@ -45,6 +45,101 @@ NS_CC_BEGIN
 
 static CCSpriteFrameCache *pSharedSpriteFrameCache = NULL;
 
+// Binary sprite sheets, written by tools/sprite-sheet/plist2ccsf.py from plists of the formats 0 - 3.
+// All values are 32 bit little endian. Frames hold the values CCSpriteFrame::initWithTexture() takes.
+#define CC_SPRITE_SHEET_MAGIC       "CCSF"
+#define CC_SPRITE_SHEET_VERSION     1
+#define CC_SPRITE_SHEET_NO_NAME     0xffffffff
+
+typedef struct _ccSpriteSheetHeader
+{
+    char            magic[4];
+    unsigned int    version;
+    unsigned int    frameCount;
+    unsigned int    aliasCount;
+    unsigned int    framesOffset;
+    unsigned int    aliasesOffset;
+    unsigned int    namesOffset;
+    unsigned int    namesSize;
+    unsigned int    textureNameOffset;
+    unsigned int    reserved;
+} ccSpriteSheetHeader;
+
+typedef struct _ccSpriteSheetFrame
+{
+    unsigned int    nameOffset;
+    float           x;
+    float           y;
+    float           width;
+    float           height;
+    float           offsetX;
+    float           offsetY;
+    float           originalWidth;
+    float           originalHeight;
+    unsigned int    rotated;
+} ccSpriteSheetFrame;
+
+typedef struct _ccSpriteSheetAlias
+{
+    unsigned int    nameOffset;
+    unsigned int    frameIndex;
+} ccSpriteSheetAlias;
+
+// returns the header of a valid binary sprite sheet, NULL for anything else
+static const ccSpriteSheetHeader* spriteSheetHeader(const unsigned char* pData, unsigned long uSize)
+{
+    const ccSpriteSheetHeader *pHeader = (const ccSpriteSheetHeader*)pData;
+    do
+    {
+        CC_BREAK_IF(pData == NULL || uSize < sizeof(ccSpriteSheetHeader));
+        CC_BREAK_IF(memcmp(pHeader->magic, CC_SPRITE_SHEET_MAGIC, 4) != 0);
+        CC_BREAK_IF(pHeader->version != CC_SPRITE_SHEET_VERSION);
+        CC_BREAK_IF(pHeader->framesOffset % 4 != 0 || pHeader->aliasesOffset % 4 != 0);
+        CC_BREAK_IF(pHeader->framesOffset > uSize || (uSize - pHeader->framesOffset) / sizeof(ccSpriteSheetFrame) < pHeader->frameCount);
+        CC_BREAK_IF(pHeader->aliasesOffset > uSize || (uSize - pHeader->aliasesOffset) / sizeof(ccSpriteSheetAlias) < pHeader->aliasCount);
+        CC_BREAK_IF(pHeader->namesOffset > uSize || uSize - pHeader->namesOffset < pHeader->namesSize);
+        // every name is NUL terminated inside the names block
+        CC_BREAK_IF(pHeader->namesSize == 0 || pData[pHeader->namesOffset + pHeader->namesSize - 1] != 0);
+
+        return pHeader;
+    } while (0);
+
+    return NULL;
+}
+
+static const char* spriteSheetName(const ccSpriteSheetHeader *pHeader, unsigned int uNameOffset)
+{
+    if (uNameOffset >= pHeader->namesSize)
+    {
+        return NULL;
+    }
+    return (const char*)pHeader + pHeader->namesOffset + uNameOffset;
+}
+
+// Reads a sprite sheet. Binary sheets are returned, plists are parsed into *ppDict.
+// The dictionary is not autoreleased, so sheets can be read off the main thread.
+// @warning you are responsible for calling delete[] on any Non-NULL pointer returned,
+// and release() on any Non-NULL *ppDict.
+static unsigned char* readSpriteSheet(const char *pszFile, unsigned long *pSize, CCDictionary **ppDict)
+{
+    *ppDict = NULL;
+
+    std::string fullPath = CCFileUtils::sharedFileUtils()->fullPathForFilename(pszFile);
+    unsigned char *pData = CCFileUtils::sharedFileUtils()->getFileData(fullPath.c_str(), "rb", pSize);
+    if (spriteSheetHeader(pData, *pSize))
+    {
+        return pData;
+    }
+
+    if (pData)
+    {
+        *ppDict = CCDictionary::createWithDataThreadSafe((const char*)pData, *pSize);
+    }
+    CC_SAFE_DELETE_ARRAY(pData);
+    *pSize = 0;
+    return NULL;
+}
+
 CCSpriteFrameCache* CCSpriteFrameCache::sharedSpriteFrameCache(void)
 {
     if (! pSharedSpriteFrameCache)
@@ -201,14 +296,73 @@ void CCSpriteFrameCache::addSpriteFramesWithDictionary(CCDictionary* dictionary,
     }
 }
 
-void CCSpriteFrameCache::addSpriteFramesWithFile(const char *pszPlist, CCTexture2D *pobTexture)
+void CCSpriteFrameCache::addSpriteFramesWithBinaryData(const unsigned char* pData, unsigned long uSize, CCTexture2D *pobTexture)
 {
-    std::string fullPath = CCFileUtils::sharedFileUtils()->fullPathForFilename(pszPlist);
-    CCDictionary *dict = CCDictionary::createWithContentsOfFileThreadSafe(fullPath.c_str());
+    const ccSpriteSheetHeader *pHeader = spriteSheetHeader(pData, uSize);
+    CCAssert(pHeader, "CCSpriteFrameCache: invalid binary sprite sheet");
+    if (! pHeader)
+    {
+        return;
+    }
+
+    const ccSpriteSheetFrame *pFrames = (const ccSpriteSheetFrame*)(pData + pHeader->framesOffset);
+    for (unsigned int i = 0; i < pHeader->frameCount; ++i)
+    {
+        const ccSpriteSheetFrame *pFrame = pFrames + i;
+        const char *pszName = spriteSheetName(pHeader, pFrame->nameOffset);
+        if (! pszName || m_pSpriteFrames->objectForKey(pszName))
+        {
+            continue;
+        }
+
+        CCSpriteFrame *spriteFrame = new CCSpriteFrame();
+        spriteFrame->initWithTexture(pobTexture,
+                                     CCRectMake(pFrame->x, pFrame->y, pFrame->width, pFrame->height),
+                                     pFrame->rotated != 0,
+                                     CCPointMake(pFrame->offsetX, pFrame->offsetY),
+                                     CCSizeMake(pFrame->originalWidth, pFrame->originalHeight));
+        m_pSpriteFrames->setObject(spriteFrame, pszName);
+        spriteFrame->release();
+    }
+
+    const ccSpriteSheetAlias *pAliases = (const ccSpriteSheetAlias*)(pData + pHeader->aliasesOffset);
+    for (unsigned int i = 0; i < pHeader->aliasCount; ++i)
+    {
+        const char *pszAlias = spriteSheetName(pHeader, pAliases[i].nameOffset);
+        if (! pszAlias || pAliases[i].frameIndex >= pHeader->frameCount)
+        {
+            continue;
+        }
+        const char *pszFrameName = spriteSheetName(pHeader, pFrames[pAliases[i].frameIndex].nameOffset);
+        if (! pszFrameName)
+        {
+            continue;
+        }
 
-    addSpriteFramesWithDictionary(dict, pobTexture);
+        if (m_pSpriteFramesAliases->objectForKey(pszAlias))
+        {
+            CCLOGWARN("cocos2d: WARNING: an alias with name %s already exists", pszAlias);
+        }
+        m_pSpriteFramesAliases->setObject(CCString::create(pszFrameName), pszAlias);
+    }
+}
 
-    dict->release();
+void CCSpriteFrameCache::addSpriteFramesWithFile(const char *pszPlist, CCTexture2D *pobTexture)
+{
+    unsigned long uSize = 0;
+    CCDictionary *dict = NULL;
+    unsigned char *pData = readSpriteSheet(pszPlist, &uSize, &dict);
+
+    if (pData)
+    {
+        addSpriteFramesWithBinaryData(pData, uSize, pobTexture);
+        CC_SAFE_DELETE_ARRAY(pData);
+    }
+    else if (dict)
+    {
+        addSpriteFramesWithDictionary(dict, pobTexture);
+        dict->release();
+    }
 }
 
 void CCSpriteFrameCache::addSpriteFramesWithFile(const char* plist, const char* textureFileName)
@@ -232,16 +386,33 @@ void CCSpriteFrameCache::addSpriteFramesWithFile(const char *pszPlist)
 
     if (m_pLoadedFileNames->find(pszPlist) == m_pLoadedFileNames->end())
     {
-        std::string fullPath = CCFileUtils::sharedFileUtils()->fullPathForFilename(pszPlist);
-        CCDictionary *dict = CCDictionary::createWithContentsOfFileThreadSafe(fullPath.c_str());
+        unsigned long uSize = 0;
+        CCDictionary *dict = NULL;
+        unsigned char *pData = readSpriteSheet(pszPlist, &uSize, &dict);
+        if (! pData && ! dict)
+        {
+            CCLOG("cocos2d: CCSpriteFrameCache: Couldn't load %s", pszPlist);
+            return;
+        }
 
         string texturePath("");
 
-        CCDictionary* metadataDict = (CCDictionary*)dict->objectForKey("metadata");
-        if (metadataDict)
+        if (pData)
         {
-            // try to read  texture file name from meta data
-            texturePath = metadataDict->valueForKey("textureFileName")->getCString();
+            const ccSpriteSheetHeader *pHeader = spriteSheetHeader(pData, uSize);
+            if (pHeader->textureNameOffset != CC_SPRITE_SHEET_NO_NAME && spriteSheetName(pHeader, pHeader->textureNameOffset))
+            {
+                texturePath = spriteSheetName(pHeader, pHeader->textureNameOffset);
+            }
+        }
+        else
+        {
+            CCDictionary* metadataDict = (CCDictionary*)dict->objectForKey("metadata");
+            if (metadataDict)
+            {
+                // try to read  texture file name from meta data
+                texturePath = metadataDict->valueForKey("textureFileName")->getCString();
+            }
         }
 
         if (! texturePath.empty())
@@ -268,7 +439,14 @@ void CCSpriteFrameCache::addSpriteFramesWithFile(const char *pszPlist)
 
         if (pTexture)
         {
-            addSpriteFramesWithDictionary(dict, pTexture);
+            if (pData)
+            {
+                addSpriteFramesWithBinaryData(pData, uSize, pTexture);
+            }
+            else
+            {
+                addSpriteFramesWithDictionary(dict, pTexture);
+            }
             m_pLoadedFileNames->insert(pszPlist);
         }
         else
@@ -276,7 +454,8 @@ void CCSpriteFrameCache::addSpriteFramesWithFile(const char *pszPlist)
             CCLOG("cocos2d: CCSpriteFrameCache: Couldn't load texture");
         }
 
-        dict->release();
+        CC_SAFE_DELETE_ARRAY(pData);
+        CC_SAFE_RELEASE(dict);
     }
 
 }
@@ -343,10 +522,20 @@ void CCSpriteFrameCache::removeSpriteFrameByName(const char *pszName)
 
 void CCSpriteFrameCache::removeSpriteFramesFromFile(const char* plist)
 {
-    std::string fullPath = CCFileUtils::sharedFileUtils()->fullPathForFilename(plist);
-    CCDictionary* dict = CCDictionary::createWithContentsOfFileThreadSafe(fullPath.c_str());
+    unsigned long uSize = 0;
+    CCDictionary *dict = NULL;
+    unsigned char *pData = readSpriteSheet(plist, &uSize, &dict);
 
-    removeSpriteFramesFromDictionary((CCDictionary*)dict);
+    if (pData)
+    {
+        removeSpriteFramesFromBinaryData(pData, uSize);
+        CC_SAFE_DELETE_ARRAY(pData);
+    }
+    else if (dict)
+    {
+        removeSpriteFramesFromDictionary(dict);
+        dict->release();
+    }
 
     // remove it from the cache
     set<string>::iterator ret = m_pLoadedFileNames->find(plist);
@@ -354,8 +543,6 @@ void CCSpriteFrameCache::removeSpriteFramesFromFile(const char* plist)
     {
         m_pLoadedFileNames->erase(ret);
     }
-
-    dict->release();
 }
 
 void CCSpriteFrameCache::removeSpriteFramesFromDictionary(CCDictionary* dictionary)
@@ -375,6 +562,25 @@ void CCSpriteFrameCache::removeSpriteFramesFromDictionary(CCDictionary* dictiona
     m_pSpriteFrames->removeObjectsForKeys(keysToRemove);
 }
 
+void CCSpriteFrameCache::removeSpriteFramesFromBinaryData(const unsigned char* pData, unsigned long uSize)
+{
+    const ccSpriteSheetHeader *pHeader = spriteSheetHeader(pData, uSize);
+    if (! pHeader)
+    {
+        return;
+    }
+
+    const ccSpriteSheetFrame *pFrames = (const ccSpriteSheetFrame*)(pData + pHeader->framesOffset);
+    for (unsigned int i = 0; i < pHeader->frameCount; ++i)
+    {
+        const char *pszName = spriteSheetName(pHeader, pFrames[i].nameOffset);
+        if (pszName)
+        {
+            m_pSpriteFrames->removeObjectForKey(pszName);
+        }
+    }
+}
+
 void CCSpriteFrameCache::removeSpriteFramesFromTexture(CCTexture2D* texture)
 {
     CCArray* keysToRemove = CCArray::create();
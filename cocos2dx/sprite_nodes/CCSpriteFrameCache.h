@@ -68,10 +68,16 @@ private:
     /*Adds multiple Sprite Frames with a dictionary. The texture will be associated with the created sprite frames.
      */
     void addSpriteFramesWithDictionary(CCDictionary* pobDictionary, CCTexture2D *pobTexture);
+    /*Adds multiple Sprite Frames with a binary sprite sheet. The texture will be associated with the created sprite frames.
+     */
+    void addSpriteFramesWithBinaryData(const unsigned char* pData, unsigned long uSize, CCTexture2D *pobTexture);
 public:
     /** Adds multiple Sprite Frames from a plist file.
      * A texture will be loaded automatically. The texture name will composed by replacing the .plist suffix with .png
      * If you want to use another texture, you should use the addSpriteFramesWithFile:texture method.
+     *
+     * The file may also be a binary sprite sheet converted by tools/sprite-sheet/plist2ccsf.py,
+     * which is loaded without parsing XML. This applies to all the methods taking a plist file. (since v2.1.4)
      */
     void addSpriteFramesWithFile(const char *pszPlist);
 
@@ -117,6 +123,10 @@ private:
     * @since v0.99.5
     */
     void removeSpriteFramesFromDictionary(CCDictionary* dictionary);
+    /** Removes multiple Sprite Frames of a binary sprite sheet.
+    * @since v2.1.4
+    */
+    void removeSpriteFramesFromBinaryData(const unsigned char* pData, unsigned long uSize);
 public:
     /** Removes all Sprite Frames associated with the specified textures.
     * It is convenient to call this method when a specific texture needs to be removed.
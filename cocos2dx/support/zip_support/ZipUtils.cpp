@@ -29,7 +29,10 @@ THE SOFTWARE.
 #include "ccMacros.h"
 #include "platform/CCFileUtils.h"
 #include "unzip.h"
-#include <map>
+#include "support/data_support/uthash.h"
+#include <string.h>
+#include <vector>
+#include <pthread.h>
 
 NS_CC_BEGIN
 
@@ -292,21 +295,90 @@ struct ZipEntryInfo
 {
     unz_file_pos pos;
     uLong uncompressed_size;
+    // points into ZipFilePrivate::names
+    const char *name;
+    UT_hash_handle hh;
 };
 
 class ZipFilePrivate
 {
 public:
+    ZipFilePrivate()
+    : zipFile(NULL)
+    , fileList(NULL)
+    {
+        pthread_mutex_init(&handlesMutex, NULL);
+    }
+
+    ~ZipFilePrivate()
+    {
+        clearFileList();
+        for (std::vector<unzFile>::iterator it = freeHandles.begin(); it != freeHandles.end(); ++it)
+        {
+            unzClose(*it);
+        }
+        pthread_mutex_destroy(&handlesMutex);
+    }
+
+    void clearFileList()
+    {
+        HASH_CLEAR(hh, fileList);
+        entries.clear();
+        names.clear();
+    }
+
+    const ZipEntryInfo *findEntry(const std::string &fileName) const
+    {
+        ZipEntryInfo *entry = NULL;
+        HASH_FIND(hh, fileList, fileName.c_str(), fileName.length(), entry);
+        return entry;
+    }
+
+    // Every reader works on a handle of its own, so that loaders on different threads
+    // don't seek each other's current file. Handles are reused once released.
+    unzFile acquireHandle()
+    {
+        unzFile handle = NULL;
+        pthread_mutex_lock(&handlesMutex);
+        if (! freeHandles.empty())
+        {
+            handle = freeHandles.back();
+            freeHandles.pop_back();
+        }
+        pthread_mutex_unlock(&handlesMutex);
+
+        if (! handle)
+        {
+            handle = unzOpen(zipFileName.c_str());
+        }
+        return handle;
+    }
+
+    void releaseHandle(unzFile handle)
+    {
+        pthread_mutex_lock(&handlesMutex);
+        freeHandles.push_back(handle);
+        pthread_mutex_unlock(&handlesMutex);
+    }
+
+    std::string zipFileName;
+
+    // only used to build the file list
     unzFile zipFile;
 
-    // std::unordered_map is faster if available on the platform
-    typedef std::map<std::string, struct ZipEntryInfo> FileListContainer;
-    FileListContainer fileList;
+    // the central directory is parsed once into this hash, keyed by file name
+    std::vector<ZipEntryInfo> entries;
+    std::vector<char> names;
+    ZipEntryInfo *fileList;
+
+    std::vector<unzFile> freeHandles;
+    pthread_mutex_t handlesMutex;
 };
 
 ZipFile::ZipFile(const std::string &zipFile, const std::string &filter)
     : m_data(new ZipFilePrivate)
 {
+    m_data->zipFileName = zipFile;
     m_data->zipFile = unzOpen(zipFile.c_str());
     if (m_data->zipFile)
     {
@@ -332,11 +404,19 @@ bool ZipFile::setFilter(const std::string &filter)
         CC_BREAK_IF(!m_data->zipFile);
 
         // clear existing file list
-        m_data->fileList.clear();
+        m_data->clearFileList();
+
+        unz_global_info64 globalInfo;
+        if (unzGetGlobalInfo64(m_data->zipFile, &globalInfo) == UNZ_OK)
+        {
+            m_data->entries.reserve((size_t)globalInfo.number_entry);
+        }
 
         // UNZ_MAXFILENAMEINZIP + 1 - it is done so in unzLocateFile
         char szCurrentFileName[UNZ_MAXFILENAMEINZIP + 1];
         unz_file_info64 fileInfo;
+        // offsets of the names in m_data->names, the entries point into it once it stops growing
+        std::vector<size_t> nameOffsets;
 
         // go through all files and store position information about the required files
         int err = unzGoToFirstFile64(m_data->zipFile, &fileInfo,
@@ -347,21 +427,39 @@ bool ZipFile::setFilter(const std::string &filter)
             int posErr = unzGetFilePos(m_data->zipFile, &posInfo);
             if (posErr == UNZ_OK)
             {
-                std::string currentFileName = szCurrentFileName;
                 // cache info about filtered files only (like 'assets/')
                 if (filter.empty()
-                    || currentFileName.substr(0, filter.length()) == filter)
+                    || strncmp(szCurrentFileName, filter.c_str(), filter.length()) == 0)
                 {
                     ZipEntryInfo entry;
                     entry.pos = posInfo;
                     entry.uncompressed_size = (uLong)fileInfo.uncompressed_size;
-                    m_data->fileList[currentFileName] = entry;
+                    entry.name = NULL;
+                    m_data->entries.push_back(entry);
+
+                    nameOffsets.push_back(m_data->names.size());
+                    m_data->names.insert(m_data->names.end(), szCurrentFileName, szCurrentFileName + strlen(szCurrentFileName) + 1);
                 }
             }
             // next file - also get the information about it
             err = unzGoToNextFile64(m_data->zipFile, &fileInfo,
                     szCurrentFileName, sizeof(szCurrentFileName) - 1);
         }
+
+        for (size_t i = 0; i < m_data->entries.size(); ++i)
+        {
+            ZipEntryInfo *entry = &m_data->entries[i];
+            entry->name = &m_data->names[nameOffsets[i]];
+
+            ZipEntryInfo *existing = NULL;
+            HASH_FIND(hh, m_data->fileList, entry->name, strlen(entry->name), existing);
+            if (existing)
+            {
+                // the last entry of a name wins, as it did with the map
+                HASH_DEL(m_data->fileList, existing);
+            }
+            HASH_ADD_KEYPTR(hh, m_data->fileList, entry->name, strlen(entry->name), entry);
+        }
         ret = true;
 
     } while(false);
@@ -376,7 +474,7 @@ bool ZipFile::fileExists(const std::string &fileName) const
     {
         CC_BREAK_IF(!m_data);
 
-        ret = m_data->fileList.find(fileName) != m_data->fileList.end();
+        ret = m_data->findEntry(fileName) != NULL;
     } while(false);
 
     return ret;
@@ -390,34 +488,49 @@ unsigned char *ZipFile::getFileData(const std::string &fileName, unsigned long *
         *pSize = 0;
     }
 
+    unzFile handle = NULL;
     do
     {
         CC_BREAK_IF(!m_data->zipFile);
         CC_BREAK_IF(fileName.empty());
 
-        ZipFilePrivate::FileListContainer::const_iterator it = m_data->fileList.find(fileName);
-        CC_BREAK_IF(it ==  m_data->fileList.end());
+        const ZipEntryInfo *entry = m_data->findEntry(fileName);
+        CC_BREAK_IF(!entry);
+
+        unz_file_pos pos = entry->pos;
+        uLong uncompressed_size = entry->uncompressed_size;
 
-        ZipEntryInfo fileInfo = it->second;
+        handle = m_data->acquireHandle();
+        CC_BREAK_IF(!handle);
 
-        int nRet = unzGoToFilePos(m_data->zipFile, &fileInfo.pos);
+        int nRet = unzGoToFilePos(handle, &pos);
         CC_BREAK_IF(UNZ_OK != nRet);
 
-        nRet = unzOpenCurrentFile(m_data->zipFile);
+        nRet = unzOpenCurrentFile(handle);
         CC_BREAK_IF(UNZ_OK != nRet);
 
-        pBuffer = new unsigned char[fileInfo.uncompressed_size];
-        int CC_UNUSED nSize = unzReadCurrentFile(m_data->zipFile, pBuffer, fileInfo.uncompressed_size);
-        CCAssert(nSize == 0 || nSize == (int)fileInfo.uncompressed_size, "the file size is wrong");
+        pBuffer = new unsigned char[uncompressed_size];
+        int CC_UNUSED nSize = unzReadCurrentFile(handle, pBuffer, uncompressed_size);
+        CCAssert(nSize == 0 || nSize == (int)uncompressed_size, "the file size is wrong");
 
         if (pSize)
         {
-            *pSize = fileInfo.uncompressed_size;
+            *pSize = uncompressed_size;
         }
-        unzCloseCurrentFile(m_data->zipFile);
+        unzCloseCurrentFile(handle);
     } while (0);
 
+    if (handle)
+    {
+        m_data->releaseHandle(handle);
+    }
+
     return pBuffer;
 }
 
+unsigned long ZipFile::getFileCount() const
+{
+    return m_data ? HASH_COUNT(m_data->fileList) : 0;
+}
+
 NS_CC_END
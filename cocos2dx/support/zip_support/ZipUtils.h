@@ -102,6 +102,10 @@ namespace cocos2d
     * It will cache the file list of a particular zip file with positions inside an archive,
     * so it would be much faster to read some particular files or to check their existance.
     *
+    * The file list is parsed once from the central directory into a hash. fileExists() and
+    * getFileData() may be called from several threads at once, each read uses an unzFile
+    * handle of its own. setFilter() must not run concurrently with them.
+    *
     * @since v2.0.5
     */
     class ZipFile
@@ -151,6 +155,13 @@ namespace cocos2d
         */
         unsigned char *getFileData(const std::string &fileName, unsigned long *pSize);
 
+        /**
+        * Number of files that passed the filter.
+        *
+        * @since v2.1.4
+        */
+        unsigned long getFileCount() const;
+
     private:
         /** Internal data like zip file pointer / file list array and so on */
         ZipFilePrivate *m_data;
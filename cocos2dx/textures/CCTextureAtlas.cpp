@@ -58,7 +58,7 @@ CCTextureAtlas::~CCTextureAtlas()
     CC_SAFE_FREE(m_pQuads);
     CC_SAFE_FREE(m_pIndices);
 
-    glDeleteBuffers(2, m_pBuffersVBO);
+    ccGLDeleteBuffers(2, m_pBuffersVBO);
 
 #if CC_TEXTURE_ATLAS_USE_VAO
     glDeleteVertexArrays(1, &m_uVAOname);
@@ -251,7 +251,7 @@ void CCTextureAtlas::setupVBOandVAO()
 
     glGenBuffers(2, &m_pBuffersVBO[0]);
 
-    glBindBuffer(GL_ARRAY_BUFFER, m_pBuffersVBO[0]);
+    ccGLBindBuffer(GL_ARRAY_BUFFER, m_pBuffersVBO[0]);
     glBufferData(GL_ARRAY_BUFFER, sizeof(m_pQuads[0]) * m_uCapacity, m_pQuads, GL_DYNAMIC_DRAW);
 
     // vertices
@@ -266,13 +266,13 @@ void CCTextureAtlas::setupVBOandVAO()
     glEnableVertexAttribArray(kCCVertexAttrib_TexCoords);
     glVertexAttribPointer(kCCVertexAttrib_TexCoords, 2, GL_FLOAT, GL_FALSE, kQuadSize, (GLvoid*) offsetof( ccV3F_C4B_T2F, texCoords));
 
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_pBuffersVBO[1]);
+    ccGLBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_pBuffersVBO[1]);
     glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(m_pIndices[0]) * m_uCapacity * 6, m_pIndices, GL_STATIC_DRAW);
 
     // Must unbind the VAO before changing the element buffer.
     ccGLBindVAO(0);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    ccGLBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    ccGLBindBuffer(GL_ARRAY_BUFFER, 0);
 
     CHECK_GL_ERROR_DEBUG();
 }
@@ -290,13 +290,13 @@ void CCTextureAtlas::mapBuffers()
     // Avoid changing the element buffer for whatever VAO might be bound.
 	ccGLBindVAO(0);
     
-    glBindBuffer(GL_ARRAY_BUFFER, m_pBuffersVBO[0]);
+    ccGLBindBuffer(GL_ARRAY_BUFFER, m_pBuffersVBO[0]);
     glBufferData(GL_ARRAY_BUFFER, sizeof(m_pQuads[0]) * m_uCapacity, m_pQuads, GL_DYNAMIC_DRAW);
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    ccGLBindBuffer(GL_ARRAY_BUFFER, 0);
 
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_pBuffersVBO[1]);
+    ccGLBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_pBuffersVBO[1]);
     glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(m_pIndices[0]) * m_uCapacity * 6, m_pIndices, GL_STATIC_DRAW);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    ccGLBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 
     CHECK_GL_ERROR_DEBUG();
 }
@@ -601,7 +601,7 @@ void CCTextureAtlas::drawNumberOfQuads(unsigned int n, unsigned int start)
     // XXX: update is done in draw... perhaps it should be done in a timer
     if (m_bDirty) 
     {
-        glBindBuffer(GL_ARRAY_BUFFER, m_pBuffersVBO[0]);
+        ccGLBindBuffer(GL_ARRAY_BUFFER, m_pBuffersVBO[0]);
         // option 1: subdata
         //glBufferSubData(GL_ARRAY_BUFFER, sizeof(m_pQuads[0])*start, sizeof(m_pQuads[0]) * n , &m_pQuads[start] );
 		
@@ -609,12 +609,13 @@ void CCTextureAtlas::drawNumberOfQuads(unsigned int n, unsigned int start)
         //		glBufferData(GL_ARRAY_BUFFER, sizeof(quads_[0]) * (n-start), &quads_[start], GL_DYNAMIC_DRAW);
 		
 		// option 3: orphaning + glMapBuffer
-		glBufferData(GL_ARRAY_BUFFER, sizeof(m_pQuads[0]) * (n-start), NULL, GL_DYNAMIC_DRAW);
+		// all the quads are uploaded, the ones that are not drawn now may be drawn before the next change
+		glBufferData(GL_ARRAY_BUFFER, sizeof(m_pQuads[0]) * m_uTotalQuads, NULL, GL_DYNAMIC_DRAW);
 		void *buf = glMapBuffer(GL_ARRAY_BUFFER, GL_WRITE_ONLY);
-		memcpy(buf, m_pQuads, sizeof(m_pQuads[0])* (n-start));
+		memcpy(buf, m_pQuads, sizeof(m_pQuads[0]) * m_uTotalQuads);
 		glUnmapBuffer(GL_ARRAY_BUFFER);
 		
-		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		ccGLBindBuffer(GL_ARRAY_BUFFER, 0);
 
         m_bDirty = false;
     }
@@ -622,7 +623,7 @@ void CCTextureAtlas::drawNumberOfQuads(unsigned int n, unsigned int start)
     ccGLBindVAO(m_uVAOname);
 
 #if CC_REBIND_INDICES_BUFFER
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_pBuffersVBO[1]);
+    ccGLBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_pBuffersVBO[1]);
 #endif
 
 #if CC_TEXTURE_ATLAS_USE_TRIANGLE_STRIP
@@ -632,7 +633,7 @@ void CCTextureAtlas::drawNumberOfQuads(unsigned int n, unsigned int start)
 #endif // CC_TEXTURE_ATLAS_USE_TRIANGLE_STRIP
 
 #if CC_REBIND_INDICES_BUFFER
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    ccGLBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 #endif
 
 //    glBindVertexArray(0);
@@ -644,12 +645,13 @@ void CCTextureAtlas::drawNumberOfQuads(unsigned int n, unsigned int start)
     //
 
 #define kQuadSize sizeof(m_pQuads[0].bl)
-    glBindBuffer(GL_ARRAY_BUFFER, m_pBuffersVBO[0]);
+    ccGLBindBuffer(GL_ARRAY_BUFFER, m_pBuffersVBO[0]);
 
     // XXX: update is done in draw... perhaps it should be done in a timer
     if (m_bDirty) 
     {
-        glBufferSubData(GL_ARRAY_BUFFER, sizeof(m_pQuads[0])*start, sizeof(m_pQuads[0]) * n , &m_pQuads[start] );
+        // all the quads are uploaded, the ones that are not drawn now may be drawn before the next change
+        glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(m_pQuads[0]) * m_uTotalQuads, m_pQuads);
         m_bDirty = false;
     }
 
@@ -664,7 +666,7 @@ void CCTextureAtlas::drawNumberOfQuads(unsigned int n, unsigned int start)
     // tex coords
     glVertexAttribPointer(kCCVertexAttrib_TexCoords, 2, GL_FLOAT, GL_FALSE, kQuadSize, (GLvoid*) offsetof(ccV3F_C4B_T2F, texCoords));
 
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_pBuffersVBO[1]);
+    ccGLBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_pBuffersVBO[1]);
 
 #if CC_TEXTURE_ATLAS_USE_TRIANGLE_STRIP
     glDrawElements(GL_TRIANGLE_STRIP, (GLsizei)n*6, GL_UNSIGNED_SHORT, (GLvoid*) (start*6*sizeof(m_pIndices[0])));
@@ -672,8 +674,8 @@ void CCTextureAtlas::drawNumberOfQuads(unsigned int n, unsigned int start)
     glDrawElements(GL_TRIANGLES, (GLsizei)n*6, GL_UNSIGNED_SHORT, (GLvoid*) (start*6*sizeof(m_pIndices[0])));
 #endif // CC_TEXTURE_ATLAS_USE_TRIANGLE_STRIP
 
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    ccGLBindBuffer(GL_ARRAY_BUFFER, 0);
+    ccGLBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 
 #endif // CC_TEXTURE_ATLAS_USE_VAO
 
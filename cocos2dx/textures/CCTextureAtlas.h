@@ -80,6 +80,15 @@ public:
 
     const char* description();
 
+    /** whether or not the array buffer of the VBO needs to be updated
+     @since v2.1.4
+     */
+    inline bool isDirty(void) { return m_bDirty; }
+    /** specify if the array buffer of the VBO needs to be updated, after changing the quads returned by getQuads()
+     @since v2.1.4
+     */
+    inline void setDirty(bool bDirty) { m_bDirty = bDirty; }
+
     /** creates a TextureAtlas with an filename and with an initial capacity for Quads.
     * The TextureAtlas capacity can be increased in runtime.
     */
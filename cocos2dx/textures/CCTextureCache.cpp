@@ -41,7 +41,15 @@ THE SOFTWARE.
 #include <cctype>
 #include <queue>
 #include <list>
+#include <set>
+#include <deque>
+#include <vector>
 #include <pthread.h>
+#if CC_ENABLE_CACHE_TEXTURE_DATA
+    #include "base_nodes/CCNode.h"
+    #include "layers_scenes_transitions_nodes/CCScene.h"
+    #include "CCProtocols.h"
+#endif
 
 using namespace std;
 
@@ -608,6 +616,27 @@ void CCTextureCache::reloadAllTextures()
 #endif
 }
 
+void CCTextureCache::reloadAllTexturesAsync(CCObject *target, SEL_CallFunc selector)
+{
+#if CC_ENABLE_CACHE_TEXTURE_DATA
+    VolatileTexture::reloadAllTexturesAsync(target, selector);
+#else
+    if (target && selector)
+    {
+        (target->*selector)();
+    }
+#endif
+}
+
+float CCTextureCache::getReloadProgress()
+{
+#if CC_ENABLE_CACHE_TEXTURE_DATA
+    return VolatileTexture::getReloadProgress();
+#else
+    return 1.0f;
+#endif
+}
+
 void CCTextureCache::dumpCachedTextureInfo()
 {
     unsigned int count = 0;
@@ -642,6 +671,7 @@ bool VolatileTexture::isReloading = false;
 
 VolatileTexture::VolatileTexture(CCTexture2D *t)
 : texture(t)
+, uiImage(NULL)
 , m_eCashedImageType(kInvalid)
 , m_pTextureData(NULL)
 , m_PixelFormat(kTexture2DPixelFormat_RGBA8888)
@@ -651,8 +681,8 @@ VolatileTexture::VolatileTexture(CCTexture2D *t)
 , m_vAlignment(kCCVerticalTextAlignmentCenter)
 , m_strFontName("")
 , m_strText("")
-, uiImage(NULL)
 , m_fFontSize(0.0f)
+, m_bReloadPending(false)
 {
     m_size = CCSizeMake(0, 0);
     m_texParams.minFilter = GL_LINEAR;
@@ -681,14 +711,17 @@ void VolatileTexture::addImageTexture(CCTexture2D *tt, const char* imageFileName
     vt->m_strFileName = imageFileName;
     vt->m_FmtImage    = format;
     vt->m_PixelFormat = tt->getPixelFormat();
+    vt->m_bReloadPending = false;
 }
 
 void VolatileTexture::addCCImage(CCTexture2D *tt, CCImage *image)
 {
     VolatileTexture *vt = findVolotileTexture(tt);
     image->retain();
+    CC_SAFE_RELEASE(vt->uiImage);
     vt->uiImage = image;
     vt->m_eCashedImageType = kImage;
+    vt->m_bReloadPending = false;
 }
 
 VolatileTexture* VolatileTexture::findVolotileTexture(CCTexture2D *tt)
@@ -726,6 +759,7 @@ void VolatileTexture::addDataTexture(CCTexture2D *tt, void* data, CCTexture2DPix
     vt->m_pTextureData = data;
     vt->m_PixelFormat = pixelFormat;
     vt->m_TextureSize = contentSize;
+    vt->m_bReloadPending = false;
 }
 
 void VolatileTexture::addStringTexture(CCTexture2D *tt, const char* text, const CCSize& dimensions, CCTextAlignment alignment, 
@@ -745,6 +779,7 @@ void VolatileTexture::addStringTexture(CCTexture2D *tt, const char* text, const
     vt->m_vAlignment  = vAlignment;
     vt->m_fFontSize   = fontSize;
     vt->m_strText     = text;
+    vt->m_bReloadPending = false;
 }
 
 void VolatileTexture::setTexParameters(CCTexture2D *t, ccTexParams *texParams) 
@@ -776,89 +811,515 @@ void VolatileTexture::removeTexture(CCTexture2D *t)
     }
 }
 
-void VolatileTexture::reloadAllTextures()
+static bool isPVRFile(const std::string& filename)
 {
-    isReloading = true;
+    std::string lowerCase(filename);
+    for (unsigned int i = 0; i < lowerCase.length(); ++i)
+    {
+        lowerCase[i] = tolower(lowerCase[i]);
+    }
 
-    CCLOG("reload all texture");
-    std::list<VolatileTexture *>::iterator iter = textures.begin();
+    return std::string::npos != lowerCase.find(".pvr");
+}
 
-    while (iter != textures.end())
-    {
-        VolatileTexture *vt = *iter++;
+void VolatileTexture::reloadTexture()
+{
+    isReloading = true;
 
-        switch (vt->m_eCashedImageType)
+    switch (m_eCashedImageType)
+    {
+    case kImageFile:
         {
-        case kImageFile:
+            if (isPVRFile(m_strFileName)) 
             {
-                std::string lowerCase(vt->m_strFileName.c_str());
-                for (unsigned int i = 0; i < lowerCase.length(); ++i)
-                {
-                    lowerCase[i] = tolower(lowerCase[i]);
-                }
+                CCTexture2DPixelFormat oldPixelFormat = CCTexture2D::defaultAlphaPixelFormat();
+                CCTexture2D::setDefaultAlphaPixelFormat(m_PixelFormat);
+
+                texture->initWithPVRFile(m_strFileName.c_str());
+                CCTexture2D::setDefaultAlphaPixelFormat(oldPixelFormat);
+            } 
+            else 
+            {
+                CCImage* pImage = new CCImage();
+                unsigned long nSize = 0;
+                unsigned char* pBuffer = CCFileUtils::sharedFileUtils()->getFileData(m_strFileName.c_str(), "rb", &nSize);
 
-                if (std::string::npos != lowerCase.find(".pvr")) 
+                if (pImage && pImage->initWithImageData((void*)pBuffer, nSize, m_FmtImage))
                 {
                     CCTexture2DPixelFormat oldPixelFormat = CCTexture2D::defaultAlphaPixelFormat();
-                    CCTexture2D::setDefaultAlphaPixelFormat(vt->m_PixelFormat);
-
-                    vt->texture->initWithPVRFile(vt->m_strFileName.c_str());
+                    CCTexture2D::setDefaultAlphaPixelFormat(m_PixelFormat);
+                    texture->initWithImage(pImage);
                     CCTexture2D::setDefaultAlphaPixelFormat(oldPixelFormat);
-                } 
-                else 
-                {
-                    CCImage* pImage = new CCImage();
-                    unsigned long nSize = 0;
-                    unsigned char* pBuffer = CCFileUtils::sharedFileUtils()->getFileData(vt->m_strFileName.c_str(), "rb", &nSize);
-
-                    if (pImage && pImage->initWithImageData((void*)pBuffer, nSize, vt->m_FmtImage))
-                    {
-                        CCTexture2DPixelFormat oldPixelFormat = CCTexture2D::defaultAlphaPixelFormat();
-                        CCTexture2D::setDefaultAlphaPixelFormat(vt->m_PixelFormat);
-                        vt->texture->initWithImage(pImage);
-                        CCTexture2D::setDefaultAlphaPixelFormat(oldPixelFormat);
-                    }
-
-                    CC_SAFE_DELETE_ARRAY(pBuffer);
-                    CC_SAFE_RELEASE(pImage);
                 }
+
+                CC_SAFE_DELETE_ARRAY(pBuffer);
+                CC_SAFE_RELEASE(pImage);
             }
+        }
+        break;
+    case kImageData:
+        {
+            texture->initWithData(m_pTextureData, 
+                                  m_PixelFormat, 
+                                  m_TextureSize.width, 
+                                  m_TextureSize.height, 
+                                  m_TextureSize);
+        }
+        break;
+    case kString:
+        {
+            texture->initWithString(m_strText.c_str(),
+                                    m_strFontName.c_str(),
+                                    m_fFontSize,
+                                    m_size,
+                                    m_alignment,
+                                    m_vAlignment
+                                    );
+        }
+        break;
+    case kImage:
+        {
+            texture->initWithImage(uiImage);
+        }
+        break;
+    default:
+        break;
+    }
+    texture->setTexParameters(&m_texParams);
+    m_bReloadPending = false;
+
+    isReloading = false;
+}
+
+void VolatileTexture::reloadTextureWithImage(CCImage *image)
+{
+    isReloading = true;
+
+    CCTexture2DPixelFormat oldPixelFormat = CCTexture2D::defaultAlphaPixelFormat();
+    CCTexture2D::setDefaultAlphaPixelFormat(m_PixelFormat);
+    texture->initWithImage(image);
+    CCTexture2D::setDefaultAlphaPixelFormat(oldPixelFormat);
+
+    texture->setTexParameters(&m_texParams);
+    m_bReloadPending = false;
+
+    isReloading = false;
+}
+
+// VolatileTexture - asynchronous reload
+//
+// Image files are decoded into CCImages by a pool of worker threads. Everything that has
+// to touch GL (uploads, PVR files, string textures) is done by VolatileTextureReloader::update,
+// which is scheduled on the GL thread and spends a bounded amount of time per frame.
+
+#define CC_VOLATILE_TEXTURE_RELOAD_THREADS     2
+// milliseconds of uploads per frame while a reload is in progress
+#define CC_VOLATILE_TEXTURE_RELOAD_BUDGET      8.0
+
+typedef enum {
+    kReloadPriorityRunningScene = 0,
+    kReloadPriorityOther,
+    kReloadPriorityCount,
+} ccReloadPriority;
+
+typedef struct _ReloadJob
+{
+    VolatileTexture         *volatileTexture;
+    CCTexture2D             *texture;
+    std::string             filename;
+    CCImage::EImageFormat   imageType;
+    CCImage                 *image;
+    unsigned int            generation;
+    int                     priority;
+} ReloadJob;
+
+static pthread_mutex_t          s_reloadMutex;
+static pthread_cond_t           s_reloadCondition;
+static std::vector<pthread_t>   s_reloadThreads;
+static bool                     s_bReloadQuit = false;
+// increased every time a reload starts, results of older reloads are dropped
+static unsigned int             s_uReloadGeneration = 0;
+// jobs waiting for a worker, and decoded jobs waiting for the GL thread
+static std::deque<ReloadJob*>   s_reloadDecodeQueue[kReloadPriorityCount];
+static std::deque<ReloadJob*>   s_reloadUploadQueue[kReloadPriorityCount];
+
+static ReloadJob* popReloadJob(std::deque<ReloadJob*> *queues)
+{
+    for (int i = 0; i < kReloadPriorityCount; ++i)
+    {
+        if (! queues[i].empty())
+        {
+            ReloadJob *job = queues[i].front();
+            queues[i].pop_front();
+            return job;
+        }
+    }
+
+    return NULL;
+}
+
+static void* decodeVolatileTextures(void* data)
+{
+    // create autorelease pool for iOS
+    CCThread thread;
+    thread.createAutoreleasePool();
+
+    while (true)
+    {
+        ReloadJob *job = NULL;
+
+        pthread_mutex_lock(&s_reloadMutex);
+        while (! s_bReloadQuit && (job = popReloadJob(s_reloadDecodeQueue)) == NULL)
+        {
+            pthread_cond_wait(&s_reloadCondition, &s_reloadMutex);
+        }
+        pthread_mutex_unlock(&s_reloadMutex);
+
+        if (job == NULL)
+        {
             break;
-        case kImageData:
+        }
+
+        CCImage *pImage = new CCImage();
+        if (! pImage->initWithImageFileThreadSafe(job->filename.c_str(), job->imageType))
+        {
+            CCLOG("cocos2d: VolatileTexture: can not decode %s", job->filename.c_str());
+            CC_SAFE_RELEASE_NULL(pImage);
+        }
+        job->image = pImage;
+
+        pthread_mutex_lock(&s_reloadMutex);
+        s_reloadUploadQueue[job->priority].push_back(job);
+        pthread_mutex_unlock(&s_reloadMutex);
+    }
+
+    return 0;
+}
+
+static void collectTexturesInNode(CCNode *pNode, std::set<CCTexture2D*>& textures)
+{
+    CCTextureProtocol *pTextureNode = dynamic_cast<CCTextureProtocol*>(pNode);
+    if (pTextureNode && pTextureNode->getTexture())
+    {
+        textures.insert(pTextureNode->getTexture());
+    }
+
+    CCObject *pChild = NULL;
+    CCARRAY_FOREACH(pNode->getChildren(), pChild)
+    {
+        collectTexturesInNode((CCNode*)pChild, textures);
+    }
+}
+
+class VolatileTextureReloader : public CCObject
+{
+public:
+    VolatileTextureReloader()
+    : m_pTarget(NULL)
+    , m_pSelector(NULL)
+    , m_nTotal(0)
+    , m_nRestored(0)
+    , m_nRunningSceneRemaining(0)
+    , m_bRunning(false)
+    {
+        pthread_mutex_init(&s_reloadMutex, NULL);
+        pthread_cond_init(&s_reloadCondition, NULL);
+    }
+
+    static VolatileTextureReloader* sharedReloader()
+    {
+        static VolatileTextureReloader *s_pReloader = NULL;
+        if (! s_pReloader)
+        {
+            s_pReloader = new VolatileTextureReloader();
+        }
+        return s_pReloader;
+    }
+
+    void start(CCObject *target, SEL_CallFunc selector)
+    {
+        cancel();
+
+        std::set<CCTexture2D*> sceneTextures;
+        CCScene *pRunningScene = CCDirector::sharedDirector()->getRunningScene();
+        if (pRunningScene)
+        {
+            collectTexturesInNode(pRunningScene, sceneTextures);
+        }
+
+        CC_SAFE_RETAIN(target);
+        m_pTarget = target;
+        m_pSelector = selector;
+        m_nTotal = 0;
+        m_nRestored = 0;
+        m_nRunningSceneRemaining = 0;
+
+        pthread_mutex_lock(&s_reloadMutex);
+        ++s_uReloadGeneration;
+        std::list<VolatileTexture *>::iterator iter = VolatileTexture::textures.begin();
+        while (iter != VolatileTexture::textures.end())
+        {
+            VolatileTexture *vt = *iter++;
+
+            ReloadJob *job = new ReloadJob();
+            job->volatileTexture = vt;
+            job->texture = vt->texture;
+            job->image = NULL;
+            job->generation = s_uReloadGeneration;
+            job->priority = sceneTextures.count(vt->texture) ? kReloadPriorityRunningScene : kReloadPriorityOther;
+            // keeps the VolatileTexture alive until the job is done
+            job->texture->retain();
+            vt->m_bReloadPending = true;
+
+            if (job->priority == kReloadPriorityRunningScene)
             {
-                vt->texture->initWithData(vt->m_pTextureData, 
-                                          vt->m_PixelFormat, 
-                                          vt->m_TextureSize.width, 
-                                          vt->m_TextureSize.height, 
-                                          vt->m_TextureSize);
+                ++m_nRunningSceneRemaining;
             }
-            break;
-        case kString:
+            ++m_nTotal;
+
+            if (vt->m_eCashedImageType == VolatileTexture::kImageFile && ! isPVRFile(vt->m_strFileName))
             {
-                vt->texture->initWithString(vt->m_strText.c_str(),
-                                            vt->m_strFontName.c_str(),
-                                            vt->m_fFontSize,
-                                            vt->m_size,
-                                            vt->m_alignment,
-                                            vt->m_vAlignment
-                                            );
+                job->filename = vt->m_strFileName;
+                job->imageType = vt->m_FmtImage;
+                s_reloadDecodeQueue[job->priority].push_back(job);
             }
-            break;
-        case kImage:
+            else
             {
-                vt->texture->initWithImage(vt->uiImage);
+                // nothing to decode, restored on the GL thread
+                s_reloadUploadQueue[job->priority].push_back(job);
             }
-            break;
-        default:
-            break;
         }
-        vt->texture->setTexParameters(&vt->m_texParams);
+        s_bReloadQuit = false;
+        pthread_mutex_unlock(&s_reloadMutex);
+
+        CCLOG("cocos2d: VolatileTexture: reloading %d textures, %d used by the running scene", m_nTotal, m_nRunningSceneRemaining);
+
+        if (s_reloadThreads.empty())
+        {
+            for (int i = 0; i < CC_VOLATILE_TEXTURE_RELOAD_THREADS; ++i)
+            {
+                pthread_t thread;
+                if (pthread_create(&thread, NULL, decodeVolatileTextures, NULL) == 0)
+                {
+                    s_reloadThreads.push_back(thread);
+                }
+            }
+        }
+        pthread_cond_broadcast(&s_reloadCondition);
+
+        if (! m_bRunning)
+        {
+            m_bRunning = true;
+            CCDirector::sharedDirector()->getScheduler()->scheduleSelector(schedule_selector(VolatileTextureReloader::update), this, 0, false);
+        }
+
+        // no worker thread could be created, do it the old way
+        if (s_reloadThreads.empty())
+        {
+            finish(true);
+        }
     }
 
-    isReloading = false;
+    void update(float dt)
+    {
+        struct cc_timeval start;
+        struct cc_timeval now;
+        CCTime::gettimeofdayCocos2d(&start, NULL);
+
+        while (true)
+        {
+            pthread_mutex_lock(&s_reloadMutex);
+            ReloadJob *job = popReloadJob(s_reloadUploadQueue);
+            pthread_mutex_unlock(&s_reloadMutex);
+
+            if (job == NULL)
+            {
+                break;
+            }
+
+            restore(job);
+
+            CCTime::gettimeofdayCocos2d(&now, NULL);
+            if (CCTime::timersubCocos2d(&start, &now) > CC_VOLATILE_TEXTURE_RELOAD_BUDGET)
+            {
+                break;
+            }
+        }
+
+        notifyIfRunningSceneRestored();
+
+        if (m_nRestored == m_nTotal)
+        {
+            finish(false);
+        }
+    }
+
+    // drops every job of the current reload, called before a new reload starts
+    void cancel()
+    {
+        if (! m_bRunning)
+        {
+            return;
+        }
+
+        std::vector<ReloadJob*> jobs;
+        pthread_mutex_lock(&s_reloadMutex);
+        for (int i = 0; i < kReloadPriorityCount; ++i)
+        {
+            jobs.insert(jobs.end(), s_reloadDecodeQueue[i].begin(), s_reloadDecodeQueue[i].end());
+            jobs.insert(jobs.end(), s_reloadUploadQueue[i].begin(), s_reloadUploadQueue[i].end());
+            s_reloadDecodeQueue[i].clear();
+            s_reloadUploadQueue[i].clear();
+        }
+        // jobs that are being decoded right now are dropped by update()
+        ++s_uReloadGeneration;
+        pthread_mutex_unlock(&s_reloadMutex);
+
+        for (std::vector<ReloadJob*>::iterator iter = jobs.begin(); iter != jobs.end(); ++iter)
+        {
+            discard(*iter);
+        }
+
+        m_nTotal = 0;
+        m_nRestored = 0;
+        m_nRunningSceneRemaining = 0;
+        CC_SAFE_RELEASE_NULL(m_pTarget);
+        m_pSelector = NULL;
+    }
+
+    // restores everything that is left, synchronously if bSync is true
+    void finish(bool bSync)
+    {
+        if (bSync)
+        {
+            ReloadJob *job = NULL;
+            pthread_mutex_lock(&s_reloadMutex);
+            while ((job = popReloadJob(s_reloadDecodeQueue)) != NULL)
+            {
+                s_reloadUploadQueue[job->priority].push_back(job);
+            }
+            pthread_mutex_unlock(&s_reloadMutex);
+        }
+
+        pthread_mutex_lock(&s_reloadMutex);
+        s_bReloadQuit = true;
+        pthread_mutex_unlock(&s_reloadMutex);
+        pthread_cond_broadcast(&s_reloadCondition);
+
+        for (std::vector<pthread_t>::iterator iter = s_reloadThreads.begin(); iter != s_reloadThreads.end(); ++iter)
+        {
+            pthread_join(*iter, NULL);
+        }
+        s_reloadThreads.clear();
+
+        // the workers are gone, drain what they left behind
+        ReloadJob *job = NULL;
+        while ((job = popReloadJob(s_reloadUploadQueue)) != NULL)
+        {
+            restore(job);
+        }
+        notifyIfRunningSceneRestored();
+
+        if (m_bRunning)
+        {
+            m_bRunning = false;
+            CCDirector::sharedDirector()->getScheduler()->unscheduleSelector(schedule_selector(VolatileTextureReloader::update), this);
+            CCLOG("cocos2d: VolatileTexture: reloaded %d textures", m_nRestored);
+        }
+    }
+
+    float getProgress()
+    {
+        return (m_bRunning && m_nTotal > 0) ? (float)m_nRestored / m_nTotal : 1.0f;
+    }
+
+private:
+    void restore(ReloadJob *job)
+    {
+        if (job->generation != s_uReloadGeneration)
+        {
+            discard(job);
+            return;
+        }
+
+        VolatileTexture *vt = job->volatileTexture;
+        // the texture was recreated in the new context while the job was queued
+        if (vt->m_bReloadPending)
+        {
+            if (job->image && vt->m_eCashedImageType == VolatileTexture::kImageFile && vt->m_strFileName == job->filename)
+            {
+                vt->reloadTextureWithImage(job->image);
+            }
+            else
+            {
+                vt->reloadTexture();
+            }
+        }
+
+        ++m_nRestored;
+        if (job->priority == kReloadPriorityRunningScene)
+        {
+            --m_nRunningSceneRemaining;
+        }
+
+        discard(job);
+    }
+
+    void discard(ReloadJob *job)
+    {
+        CC_SAFE_RELEASE(job->image);
+        job->texture->release();
+        delete job;
+    }
+
+    void notifyIfRunningSceneRestored()
+    {
+        if (m_nRunningSceneRemaining == 0 && m_pTarget)
+        {
+            CCObject *target = m_pTarget;
+            m_pTarget = NULL;
+
+            if (m_pSelector)
+            {
+                (target->*m_pSelector)();
+            }
+            target->release();
+        }
+    }
+
+    CCObject        *m_pTarget;
+    SEL_CallFunc    m_pSelector;
+    int             m_nTotal;
+    int             m_nRestored;
+    int             m_nRunningSceneRemaining;
+    bool            m_bRunning;
+};
+
+void VolatileTexture::reloadAllTextures()
+{
+    CCLOG("reload all texture");
+
+    VolatileTextureReloader::sharedReloader()->cancel();
+    VolatileTextureReloader::sharedReloader()->finish(true);
+
+    std::list<VolatileTexture *>::iterator iter = textures.begin();
+    while (iter != textures.end())
+    {
+        VolatileTexture *vt = *iter++;
+        vt->reloadTexture();
+    }
+}
+
+void VolatileTexture::reloadAllTexturesAsync(CCObject *target, SEL_CallFunc selector)
+{
+    VolatileTextureReloader::sharedReloader()->start(target, selector);
+}
+
+float VolatileTexture::getReloadProgress()
+{
+    return VolatileTextureReloader::sharedReloader()->getProgress();
 }
 
 #endif // CC_ENABLE_CACHE_TEXTURE_DATA
 
 NS_CC_END
-
@@ -159,12 +159,32 @@ public:
     It's only useful when the value of CC_ENABLE_CACHE_TEXTURE_DATA is 1
     */
     static void reloadAllTextures();
+
+    /** Reload all textures without blocking the GL thread.
+    Image files are decoded on worker threads, textures used by the running scene first,
+    and uploaded on the GL thread as they arrive. The selector is called once every texture
+    of the running scene has been restored.
+    It's only useful when the value of CC_ENABLE_CACHE_TEXTURE_DATA is 1, otherwise the
+    selector is called immediately.
+    @since v2.1.4
+    */
+    static void reloadAllTexturesAsync(CCObject *target, SEL_CallFunc selector);
+
+    /** Returns the progress of the current reload, in the range [0, 1].
+    Returns 1 if no reload is in progress.
+    @since v2.1.4
+    */
+    static float getReloadProgress();
 };
 
 #if CC_ENABLE_CACHE_TEXTURE_DATA
 
+class VolatileTextureReloader;
+
 class VolatileTexture
 {
+friend class VolatileTextureReloader;
+
 typedef enum {
     kInvalid = 0,
     kImageFile,
@@ -186,6 +206,8 @@ public:
     static void setTexParameters(CCTexture2D *t, ccTexParams *texParams);
     static void removeTexture(CCTexture2D *t);
     static void reloadAllTextures();
+    static void reloadAllTexturesAsync(CCObject *target, SEL_CallFunc selector);
+    static float getReloadProgress();
 
 public:
     static std::list<VolatileTexture*> textures;
@@ -196,6 +218,11 @@ private:
     // if not found, create a new one
     static VolatileTexture* findVolotileTexture(CCTexture2D *tt);
 
+    // recreates the GL texture from the cached data, synchronously
+    void reloadTexture();
+    // recreates the GL texture from an image decoded by a reload worker
+    void reloadTextureWithImage(CCImage *image);
+
 protected:
     CCTexture2D *texture;
     
@@ -217,6 +244,9 @@ protected:
     std::string     m_strFontName;
     std::string     m_strText;
     float           m_fFontSize;
+
+    // queued by reloadAllTexturesAsync and not yet restored
+    bool            m_bReloadPending;
 };
 
 #endif
@@ -31,11 +31,16 @@ THE SOFTWARE.
 #include "shaders/CCShaderCache.h"
 #include "shaders/CCGLProgram.h"
 #include "support/CCPointExtension.h"
-#include "support/data_support/ccCArray.h"
+#include "textures/CCTextureAtlas.h"
 #include "CCDirector.h"
+#include "kazmath/GL/matrix.h"
+#include <algorithm>
+#include <float.h>
 
 NS_CC_BEGIN
 
+// largest range of gids looked up through a table by tilesWithGIDs()
+#define kCCTMXGIDTableMaxSize   65536
 
 // CCTMXLayer - init & alloc & dealloc
 
@@ -51,10 +56,7 @@ CCTMXLayer * CCTMXLayer::create(CCTMXTilesetInfo *tilesetInfo, CCTMXLayerInfo *l
 }
 bool CCTMXLayer::initWithTilesetInfo(CCTMXTilesetInfo *tilesetInfo, CCTMXLayerInfo *layerInfo, CCTMXMapInfo *mapInfo)
 {    
-    // XXX: is 35% a good estimate ?
     CCSize size = layerInfo->m_tLayerSize;
-    float totalNumberOfTiles = size.width * size.height;
-    float capacity = totalNumberOfTiles * 0.35f + 1; // 35 percent is occupied ?
 
     CCTexture2D *texture = NULL;
     if( tilesetInfo )
@@ -62,7 +64,8 @@ bool CCTMXLayer::initWithTilesetInfo(CCTMXTilesetInfo *tilesetInfo, CCTMXLayerIn
         texture = CCTextureCache::sharedTextureCache()->addImage(tilesetInfo->m_sSourceImage.c_str());
     }
 
-    if (CCSpriteBatchNode::initWithTexture(texture, (unsigned int)capacity))
+    // the tiles are drawn by the chunks, the batch node only holds the tiles turned into sprites
+    if (CCSpriteBatchNode::initWithTexture(texture, kDefaultSpriteBatchCapacity))
     {
         // layerInfo
         m_sLayerName = layerInfo->m_sName;
@@ -86,8 +89,6 @@ bool CCTMXLayer::initWithTilesetInfo(CCTMXTilesetInfo *tilesetInfo, CCTMXLayerIn
         CCPoint offset = this->calculateLayerOffset(layerInfo->m_tOffset);
         this->setPosition(CC_POINT_PIXELS_TO_POINTS(offset));
 
-        m_pAtlasIndexArray = ccCArrayNew((unsigned int)totalNumberOfTiles);
-
         this->setContentSize(CC_SIZE_PIXELS_TO_POINTS(CCSizeMake(m_tLayerSize.width * m_tMapTileSize.width, m_tLayerSize.height * m_tMapTileSize.height)));
 
         m_bUseAutomaticVertexZ = false;
@@ -106,7 +107,10 @@ CCTMXLayer::CCTMXLayer()
 ,m_pProperties(NULL)
 ,m_sLayerName("")
 ,m_pReusedTile(NULL)
-,m_pAtlasIndexArray(NULL)    
+,m_uChunkColumns(0)
+,m_uChunkRows(0)
+,m_uDrawnChunkCount(0)
+,m_uBuiltChunkCount(0)
 {}
 
 CCTMXLayer::~CCTMXLayer()
@@ -115,10 +119,9 @@ CCTMXLayer::~CCTMXLayer()
     CC_SAFE_RELEASE(m_pReusedTile);
     CC_SAFE_RELEASE(m_pProperties);
 
-    if (m_pAtlasIndexArray)
+    for (unsigned int i = 0; i < m_tChunks.size(); ++i)
     {
-        ccCArrayFree(m_pAtlasIndexArray);
-        m_pAtlasIndexArray = NULL;
+        CC_SAFE_RELEASE(m_tChunks[i].pAtlas);
     }
 
     CC_SAFE_DELETE_ARRAY(m_pTiles);
@@ -140,15 +143,18 @@ void CCTMXLayer::releaseMap()
 {
     if (m_pTiles)
     {
+        // the chunks can't be built without the tiles
+        for (unsigned int i = 0; i < m_tChunks.size(); ++i)
+        {
+            if (m_tChunks[i].bDirty)
+            {
+                buildChunk(i);
+            }
+        }
+
         delete [] m_pTiles;
         m_pTiles = NULL;
     }
-
-    if (m_pAtlasIndexArray)
-    {
-        ccCArrayFree(m_pAtlasIndexArray);
-        m_pAtlasIndexArray = NULL;
-    }
 }
 
 // CCTMXLayer - setup Tiles
@@ -169,31 +175,29 @@ void CCTMXLayer::setupTiles()
     // Parse cocos2d properties
     this->parseInternalProperties();
 
-    for (unsigned int y=0; y < m_tLayerSize.height; y++) 
+    unsigned int uTileCount = (unsigned int)(m_tLayerSize.width * m_tLayerSize.height);
+    for (unsigned int pos = 0; pos < uTileCount; pos++) 
     {
-        for (unsigned int x=0; x < m_tLayerSize.width; x++) 
-        {
-            unsigned int pos = (unsigned int)(x + m_tLayerSize.width * y);
-            unsigned int gid = m_pTiles[ pos ];
+        unsigned int gid = m_pTiles[ pos ];
 
-            // gid are stored in little endian.
-            // if host is big endian, then swap
-            //if( o == CFByteOrderBigEndian )
-            //    gid = CFSwapInt32( gid );
-            /* We support little endian.*/
+        // gid are stored in little endian.
+        // if host is big endian, then swap
+        //if( o == CFByteOrderBigEndian )
+        //    gid = CFSwapInt32( gid );
+        /* We support little endian.*/
 
-            // XXX: gid == 0 --> empty tile
-            if (gid != 0) 
-            {
-                this->appendTileForGID(gid, ccp(x, y));
-
-                // Optimization: update min and max GID rendered by the layer
-                m_uMinGID = MIN(gid, m_uMinGID);
-                m_uMaxGID = MAX(gid, m_uMaxGID);
-            }
+        // XXX: gid == 0 --> empty tile
+        if (gid != 0) 
+        {
+            // Optimization: update min and max GID rendered by the layer
+            m_uMinGID = MIN(gid, m_uMinGID);
+            m_uMaxGID = MAX(gid, m_uMaxGID);
         }
     }
 
+    // the quads of the chunks are built when they come into view
+    this->setupChunks();
+
     CCAssert( m_uMaxGID >= m_pTileSet->m_uFirstGid &&
         m_uMinGID >= m_pTileSet->m_uFirstGid, "TMX: Only 1 tileset per layer is supported");    
 }
@@ -320,7 +324,7 @@ CCSprite* CCTMXLayer::reusedTileWithRect(CCRect rect)
 CCSprite * CCTMXLayer::tileAt(const CCPoint& pos)
 {
     CCAssert(pos.x < m_tLayerSize.width && pos.y < m_tLayerSize.height && pos.x >=0 && pos.y >=0, "TMXLayer: invalid position");
-    CCAssert(m_pTiles && m_pAtlasIndexArray, "TMXLayer: the tiles map has been released");
+    CCAssert(m_pTiles, "TMXLayer: the tiles map has been released");
 
     CCSprite *tile = NULL;
     unsigned int gid = this->tileGIDAt(pos);
@@ -345,9 +349,10 @@ CCSprite * CCTMXLayer::tileAt(const CCPoint& pos)
             tile->setAnchorPoint(CCPointZero);
             tile->setOpacity(m_cOpacity);
 
-            unsigned int indexForZ = atlasIndexForExistantZ(z);
-            this->addSpriteWithoutQuad(tile, indexForZ, z);
+            // the sprite draws the tile instead of its chunk
+            CCSpriteBatchNode::addChild(tile, z, z);
             tile->release();
+            setChunkDirtyForTile(pos);
         }
     }
     
@@ -362,7 +367,7 @@ unsigned int CCTMXLayer::tileGIDAt(const CCPoint& pos)
 unsigned int CCTMXLayer::tileGIDAt(const CCPoint& pos, ccTMXTileFlags* flags)
 {
     CCAssert(pos.x < m_tLayerSize.width && pos.y < m_tLayerSize.height && pos.x >=0 && pos.y >=0, "TMXLayer: invalid position");
-    CCAssert(m_pTiles && m_pAtlasIndexArray, "TMXLayer: the tiles map has been released");
+    CCAssert(m_pTiles, "TMXLayer: the tiles map has been released");
 
     int idx = (int)(pos.x + pos.y * m_tLayerSize.width);
     // Bits on the far end of the 32-bit global tile ID are used for tile flags
@@ -377,125 +382,6 @@ unsigned int CCTMXLayer::tileGIDAt(const CCPoint& pos, ccTMXTileFlags* flags)
     return (tile & kCCFlippedMask);
 }
 
-// CCTMXLayer - adding helper methods
-CCSprite * CCTMXLayer::insertTileForGID(unsigned int gid, const CCPoint& pos)
-{
-    CCRect rect = m_pTileSet->rectForGID(gid);
-    rect = CC_RECT_PIXELS_TO_POINTS(rect);
-
-    intptr_t z = (intptr_t)(pos.x + pos.y * m_tLayerSize.width);
-
-    CCSprite *tile = reusedTileWithRect(rect);
-
-    setupTileSprite(tile, pos, gid);
-
-    // get atlas index
-    unsigned int indexForZ = atlasIndexForNewZ(z);
-
-    // Optimization: add the quad without adding a child
-    this->insertQuadFromSprite(tile, indexForZ);
-
-    // insert it into the local atlasindex array
-    ccCArrayInsertValueAtIndex(m_pAtlasIndexArray, (void*)z, indexForZ);
-
-    // update possible children
-    if (m_pChildren && m_pChildren->count()>0)
-    {
-        CCObject* pObject = NULL;
-        CCARRAY_FOREACH(m_pChildren, pObject)
-        {
-            CCSprite* pChild = (CCSprite*) pObject;
-            if (pChild)
-            {
-                unsigned int ai = pChild->getAtlasIndex();
-                if ( ai >= indexForZ )
-                {
-                    pChild->setAtlasIndex(ai+1);
-                }
-            }
-        }
-    }
-    m_pTiles[z] = gid;
-    return tile;
-}
-CCSprite * CCTMXLayer::updateTileForGID(unsigned int gid, const CCPoint& pos)    
-{
-    CCRect rect = m_pTileSet->rectForGID(gid);
-    rect = CCRectMake(rect.origin.x / m_fContentScaleFactor, rect.origin.y / m_fContentScaleFactor, rect.size.width/ m_fContentScaleFactor, rect.size.height/ m_fContentScaleFactor);
-    int z = (int)(pos.x + pos.y * m_tLayerSize.width);
-
-    CCSprite *tile = reusedTileWithRect(rect);
-
-    setupTileSprite(tile ,pos ,gid);
-
-    // get atlas index
-    unsigned int indexForZ = atlasIndexForExistantZ(z);
-    tile->setAtlasIndex(indexForZ);
-    tile->setDirty(true);
-    tile->updateTransform();
-    m_pTiles[z] = gid;
-
-    return tile;
-}
-
-// used only when parsing the map. useless after the map was parsed
-// since lot's of assumptions are no longer true
-CCSprite * CCTMXLayer::appendTileForGID(unsigned int gid, const CCPoint& pos)
-{
-    CCRect rect = m_pTileSet->rectForGID(gid);
-    rect = CC_RECT_PIXELS_TO_POINTS(rect);
-
-    intptr_t z = (intptr_t)(pos.x + pos.y * m_tLayerSize.width);
-
-    CCSprite *tile = reusedTileWithRect(rect);
-
-    setupTileSprite(tile ,pos ,gid);
-
-    // optimization:
-    // The difference between appendTileForGID and insertTileforGID is that append is faster, since
-    // it appends the tile at the end of the texture atlas
-    unsigned int indexForZ = m_pAtlasIndexArray->num;
-
-    // don't add it using the "standard" way.
-    insertQuadFromSprite(tile, indexForZ);
-
-    // append should be after addQuadFromSprite since it modifies the quantity values
-    ccCArrayInsertValueAtIndex(m_pAtlasIndexArray, (void*)z, indexForZ);
-
-    return tile;
-}
-
-// CCTMXLayer - atlasIndex and Z
-static inline int compareInts(const void * a, const void * b)
-{
-    return ((*(int*)a) - (*(int*)b));
-}
-unsigned int CCTMXLayer::atlasIndexForExistantZ(unsigned int z)
-{
-    int key=z;
-    int *item = (int*)bsearch((void*)&key, (void*)&m_pAtlasIndexArray->arr[0], m_pAtlasIndexArray->num, sizeof(void*), compareInts);
-
-    CCAssert(item, "TMX atlas index not found. Shall not happen");
-
-    int index = ((size_t)item - (size_t)m_pAtlasIndexArray->arr) / sizeof(void*);
-    return index;
-}
-unsigned int CCTMXLayer::atlasIndexForNewZ(int z)
-{
-    // XXX: This can be improved with a sort of binary search
-    unsigned int i=0;
-    for (i=0; i< m_pAtlasIndexArray->num ; i++) 
-    {
-        int val = (size_t) m_pAtlasIndexArray->arr[i];
-        if (z < val)
-        {
-            break;
-        }
-    } 
-    
-    return i;
-}
-
 // CCTMXLayer - adding / remove tiles
 void CCTMXLayer::setTileGID(unsigned int gid, const CCPoint& pos)
 {
@@ -505,7 +391,7 @@ void CCTMXLayer::setTileGID(unsigned int gid, const CCPoint& pos)
 void CCTMXLayer::setTileGID(unsigned int gid, const CCPoint& pos, ccTMXTileFlags flags)
 {
     CCAssert(pos.x < m_tLayerSize.width && pos.y < m_tLayerSize.height && pos.x >=0 && pos.y >=0, "TMXLayer: invalid position");
-    CCAssert(m_pTiles && m_pAtlasIndexArray, "TMXLayer: the tiles map has been released");
+    CCAssert(m_pTiles, "TMXLayer: the tiles map has been released");
     CCAssert(gid == 0 || gid >= m_pTileSet->m_uFirstGid, "TMXLayer: invalid gid" );
 
     ccTMXTileFlags currentFlags;
@@ -520,12 +406,7 @@ void CCTMXLayer::setTileGID(unsigned int gid, const CCPoint& pos, ccTMXTileFlags
         {
             removeTileAt(pos);
         }
-        // empty tile. create a new one
-        else if (currentGID == 0)
-        {
-            insertTileForGID(gidAndFlags, pos);
-        }
-        // modifying an existing tile with a non-empty tile
+        // modifying an empty or an existing tile with a non-empty tile
         else 
         {
             unsigned int z = (unsigned int)(pos.x + pos.y * m_tLayerSize.width);
@@ -544,7 +425,8 @@ void CCTMXLayer::setTileGID(unsigned int gid, const CCPoint& pos, ccTMXTileFlags
             } 
             else 
             {
-                updateTileForGID(gidAndFlags, pos);
+                m_pTiles[z] = gidAndFlags;
+                setChunkDirtyForTile(pos);
             }
         }
     }
@@ -567,31 +449,28 @@ void CCTMXLayer::removeChild(CCNode* node, bool cleanup)
 
     CCAssert(m_pChildren->containsObject(sprite), "Tile does not belong to TMXLayer");
 
-    unsigned int atlasIndex = sprite->getAtlasIndex();
-    unsigned int zz = (size_t)m_pAtlasIndexArray->arr[atlasIndex];
-    m_pTiles[zz] = 0;
-    ccCArrayRemoveValueAtIndex(m_pAtlasIndexArray, atlasIndex);
+    // the tag of a tile sprite is its index in the map
+    if (m_pTiles)
+    {
+        m_pTiles[sprite->getTag()] = 0;
+    }
     CCSpriteBatchNode::removeChild(sprite, cleanup);
 }
 void CCTMXLayer::removeTileAt(const CCPoint& pos)
 {
     CCAssert(pos.x < m_tLayerSize.width && pos.y < m_tLayerSize.height && pos.x >=0 && pos.y >=0, "TMXLayer: invalid position");
-    CCAssert(m_pTiles && m_pAtlasIndexArray, "TMXLayer: the tiles map has been released");
+    CCAssert(m_pTiles, "TMXLayer: the tiles map has been released");
 
     unsigned int gid = tileGIDAt(pos);
 
     if (gid) 
     {
         unsigned int z = (unsigned int)(pos.x + pos.y * m_tLayerSize.width);
-        unsigned int atlasIndex = atlasIndexForExistantZ(z);
 
         // remove tile from GID map
         m_pTiles[z] = 0;
 
-        // remove tile from atlas position array
-        ccCArrayRemoveValueAtIndex(m_pAtlasIndexArray, atlasIndex);
-
-        // remove it from sprites and/or texture atlas
+        // remove it from sprites and/or its chunk
         CCSprite *sprite = (CCSprite*)getChildByTag(z);
         if (sprite)
         {
@@ -599,27 +478,567 @@ void CCTMXLayer::removeTileAt(const CCPoint& pos)
         }
         else 
         {
-            m_pobTextureAtlas->removeQuadAtIndex(atlasIndex);
+            setChunkDirtyForTile(pos);
+        }
+    }
+}
 
-            // update possible children
-            if (m_pChildren && m_pChildren->count()>0)
+void CCTMXLayer::setTileGIDs(const CCRect& rect, const unsigned int *gids)
+{
+    CCAssert(gids, "TMXLayer: invalid gids");
+    setTilesInRect(rect, gids, 0);
+}
+
+void CCTMXLayer::fillRect(const CCRect& rect, unsigned int gid)
+{
+    setTilesInRect(rect, NULL, gid);
+}
+
+void CCTMXLayer::fillRect(const CCRect& rect, unsigned int gid, ccTMXTileFlags flags)
+{
+    setTilesInRect(rect, NULL, gid | flags);
+}
+
+// sets the tiles of the rect to gids, or to gidAndFlags if gids is NULL
+void CCTMXLayer::setTilesInRect(const CCRect& rect, const unsigned int *gids, unsigned int gidAndFlags)
+{
+    CCAssert(rect.origin.x >= 0 && rect.origin.y >= 0 && rect.getMaxX() <= m_tLayerSize.width && rect.getMaxY() <= m_tLayerSize.height,
+        "TMXLayer: invalid rect");
+    CCAssert(m_pTiles, "TMXLayer: the tiles map has been released");
+
+    unsigned int x0 = (unsigned int)rect.origin.x;
+    unsigned int y0 = (unsigned int)rect.origin.y;
+    unsigned int uWidth = (unsigned int)rect.size.width;
+    unsigned int uHeight = (unsigned int)rect.size.height;
+    unsigned int uLayerWidth = (unsigned int)m_tLayerSize.width;
+
+    // tiles turned into sprites go through setTileGID(), like buildChunk() finds them
+    std::vector<unsigned int> spriteTiles;
+    if (m_pChildren && m_pChildren->count() > 0)
+    {
+        CCObject* pObject = NULL;
+        CCARRAY_FOREACH(m_pChildren, pObject)
+        {
+            unsigned int z = (unsigned int)((CCNode*)pObject)->getTag();
+            if (z % uLayerWidth >= x0 && z % uLayerWidth < x0 + uWidth && z / uLayerWidth >= y0 && z / uLayerWidth < y0 + uHeight)
             {
-                CCObject* pObject = NULL;
-                CCARRAY_FOREACH(m_pChildren, pObject)
-                {
-                    CCSprite* pChild = (CCSprite*) pObject;
-                    if (pChild)
-                    {
-                        unsigned int ai = pChild->getAtlasIndex();
-                        if ( ai >= atlasIndex )
-                        {
-                            pChild->setAtlasIndex(ai-1);
-                        }
-                    }
-                }
+                spriteTiles.push_back(z);
+            }
+        }
+        std::sort(spriteTiles.begin(), spriteTiles.end());
+    }
+
+    for (unsigned int y = y0; y < y0 + uHeight; ++y)
+    {
+        unsigned int z = x0 + y * uLayerWidth;
+        for (unsigned int x = x0; x < x0 + uWidth; ++x, ++z)
+        {
+            unsigned int tile = gids ? *gids++ : gidAndFlags;
+            CCAssert((tile & kCCFlippedMask) == 0 || (tile & kCCFlippedMask) >= m_pTileSet->m_uFirstGid, "TMXLayer: invalid gid");
+            if (m_pTiles[z] == tile)
+            {
+                continue;
+            }
+
+            if (! spriteTiles.empty() && std::binary_search(spriteTiles.begin(), spriteTiles.end(), z))
+            {
+                setTileGID(tile & kCCFlippedMask, ccp(x, y), (ccTMXTileFlags)(tile & kCCFlipedAll));
+            }
+            else
+            {
+                m_pTiles[z] = tile;
+                m_tChunks[x / CC_TMX_LAYER_CHUNK_SIZE + (y / CC_TMX_LAYER_CHUNK_SIZE) * m_uChunkColumns].bDirty = true;
+            }
+        }
+    }
+}
+
+unsigned int CCTMXLayer::tilesWithGIDs(const CCRect& rect, const std::set<unsigned int>& gids, std::vector<CCPoint>& tileCoordinates)
+{
+    CCAssert(m_pTiles, "TMXLayer: the tiles map has been released");
+    if (gids.empty())
+    {
+        return 0;
+    }
+
+    int x0 = MAX((int)floorf(rect.getMinX()), 0);
+    int y0 = MAX((int)floorf(rect.getMinY()), 0);
+    int x1 = MIN((int)ceilf(rect.getMaxX()), (int)m_tLayerSize.width);
+    int y1 = MIN((int)ceilf(rect.getMaxY()), (int)m_tLayerSize.height);
+
+    GIDMatcher matcher(gids);
+    unsigned int uCount = 0;
+    for (int y = y0; y < y1; ++y)
+    {
+        const unsigned int *pRow = m_pTiles + y * (int)m_tLayerSize.width;
+        for (int x = x0; x < x1; ++x)
+        {
+            if (matcher.matches(pRow[x] & kCCFlippedMask))
+            {
+                tileCoordinates.push_back(ccp(x, y));
+                ++uCount;
             }
         }
     }
+    return uCount;
+}
+
+bool CCTMXLayer::firstTileAlongRay(const CCPoint& from, const CCPoint& to, CCPoint& tileCoordinate)
+{
+    // walks the tiles crossed by the segment, from one tile border to the next (Amanatides & Woo)
+    int x = (int)floorf(from.x);
+    int y = (int)floorf(from.y);
+    int endX = (int)floorf(to.x);
+    int endY = (int)floorf(to.y);
+    float dx = to.x - from.x;
+    float dy = to.y - from.y;
+    int stepX = dx > 0 ? 1 : (dx < 0 ? -1 : 0);
+    int stepY = dy > 0 ? 1 : (dy < 0 ? -1 : 0);
+
+    // parameter of the segment at the next vertical and horizontal tile borders, and between two of them
+    float tMaxX = stepX > 0 ? (x + 1 - from.x) / dx : (stepX < 0 ? (from.x - x) / -dx : FLT_MAX);
+    float tMaxY = stepY > 0 ? (y + 1 - from.y) / dy : (stepY < 0 ? (from.y - y) / -dy : FLT_MAX);
+    float tDeltaX = stepX ? 1 / fabsf(dx) : FLT_MAX;
+    float tDeltaY = stepY ? 1 / fabsf(dy) : FLT_MAX;
+
+    int nWidth = (int)m_tLayerSize.width;
+    int nHeight = (int)m_tLayerSize.height;
+    while (true)
+    {
+        if (x >= 0 && y >= 0 && x < nWidth && y < nHeight && rawTileAt(x, y) != 0)
+        {
+            tileCoordinate = ccp(x, y);
+            return true;
+        }
+
+        if (x == endX && y == endY)
+        {
+            break;
+        }
+
+        if (tMaxX < tMaxY)
+        {
+            CC_BREAK_IF(tMaxX > 1);
+            x += stepX;
+            tMaxX += tDeltaX;
+        }
+        else
+        {
+            CC_BREAK_IF(tMaxY > 1);
+            y += stepY;
+            tMaxY += tDeltaY;
+        }
+    }
+    return false;
+}
+
+unsigned int CCTMXLayer::rawTileAt(unsigned int x, unsigned int y)
+{
+    CCAssert(m_pTiles, "TMXLayer: the tiles map has been released");
+    return m_pTiles[x + y * (unsigned int)m_tLayerSize.width];
+}
+
+CCTMXLayer::GIDMatcher::GIDMatcher(const std::set<unsigned int>& gids)
+: m_uMinGID(1)
+, m_uMaxGID(0)
+, m_bHasLast(false)
+, m_uLastGID(0)
+, m_bLastFound(false)
+{
+    if (gids.empty())
+    {
+        return;
+    }
+
+    // a table of the gids between the smallest and the largest one, the set being sorted,
+    // or a binary search in the sorted gids if they are too far apart
+    m_uMinGID = *gids.begin();
+    m_uMaxGID = *gids.rbegin();
+    if (m_uMaxGID - m_uMinGID < kCCTMXGIDTableMaxSize)
+    {
+        m_tTable.resize(m_uMaxGID - m_uMinGID + 1, 0);
+        for (std::set<unsigned int>::const_iterator it = gids.begin(); it != gids.end(); ++it)
+        {
+            m_tTable[*it - m_uMinGID] = 1;
+        }
+    }
+    else
+    {
+        m_tSortedGIDs.assign(gids.begin(), gids.end());
+    }
+}
+
+bool CCTMXLayer::GIDMatcher::matches(unsigned int gid)
+{
+    if (gid < m_uMinGID || gid > m_uMaxGID)
+    {
+        return false;
+    }
+
+    if (! m_tTable.empty())
+    {
+        return m_tTable[gid - m_uMinGID] != 0;
+    }
+
+    if (! m_bHasLast || gid != m_uLastGID)
+    {
+        m_bLastFound = std::binary_search(m_tSortedGIDs.begin(), m_tSortedGIDs.end(), gid);
+        m_uLastGID = gid;
+        m_bHasLast = true;
+    }
+    return m_bLastFound;
+}
+
+// CCTMXLayer - chunks
+void CCTMXLayer::setupChunks()
+{
+    m_uChunkColumns = ((unsigned int)m_tLayerSize.width + CC_TMX_LAYER_CHUNK_SIZE - 1) / CC_TMX_LAYER_CHUNK_SIZE;
+    m_uChunkRows = ((unsigned int)m_tLayerSize.height + CC_TMX_LAYER_CHUNK_SIZE - 1) / CC_TMX_LAYER_CHUNK_SIZE;
+
+    // tiles can be larger than the map tiles, and rotated tiles are moved by half their size
+    float fMargin = MAX(MAX(m_tMapTileSize.width, m_tMapTileSize.height), MAX(m_pTileSet->m_tTileSize.width, m_pTileSet->m_tTileSize.height));
+    fMargin /= CC_CONTENT_SCALE_FACTOR();
+
+    Chunk chunk;
+    chunk.pAtlas = NULL;
+    chunk.bDirty = true;
+    chunk.uLastVisibleFrame = 0;
+    m_tChunks.assign(m_uChunkColumns * m_uChunkRows, chunk);
+
+    for (unsigned int row = 0; row < m_uChunkRows; ++row)
+    {
+        for (unsigned int column = 0; column < m_uChunkColumns; ++column)
+        {
+            float x0 = (float)(column * CC_TMX_LAYER_CHUNK_SIZE);
+            float y0 = (float)(row * CC_TMX_LAYER_CHUNK_SIZE);
+            float x1 = MIN(x0 + CC_TMX_LAYER_CHUNK_SIZE, m_tLayerSize.width) - 1;
+            float y1 = MIN(y0 + CC_TMX_LAYER_CHUNK_SIZE, m_tLayerSize.height) - 1;
+
+            // the tiles of the corners are the furthest ones in every orientation
+            CCPoint corners[4] = { positionAt(ccp(x0, y0)), positionAt(ccp(x1, y0)), positionAt(ccp(x0, y1)), positionAt(ccp(x1, y1)) };
+            float minX = corners[0].x, maxX = corners[0].x, minY = corners[0].y, maxY = corners[0].y;
+            for (int i = 1; i < 4; ++i)
+            {
+                minX = MIN(minX, corners[i].x);
+                maxX = MAX(maxX, corners[i].x);
+                minY = MIN(minY, corners[i].y);
+                maxY = MAX(maxY, corners[i].y);
+            }
+
+            m_tChunks[column + row * m_uChunkColumns].tBounds = CCRectMake(minX - fMargin, minY - fMargin,
+                maxX - minX + 2 * fMargin, maxY - minY + 2 * fMargin);
+        }
+    }
+}
+
+void CCTMXLayer::setChunkDirtyForTile(const CCPoint& pos)
+{
+    unsigned int column = (unsigned int)pos.x / CC_TMX_LAYER_CHUNK_SIZE;
+    unsigned int row = (unsigned int)pos.y / CC_TMX_LAYER_CHUNK_SIZE;
+    m_tChunks[column + row * m_uChunkColumns].bDirty = true;
+}
+
+void CCTMXLayer::buildChunk(unsigned int uChunk)
+{
+    Chunk& chunk = m_tChunks[uChunk];
+    chunk.bDirty = false;
+
+    unsigned int x0 = (uChunk % m_uChunkColumns) * CC_TMX_LAYER_CHUNK_SIZE;
+    unsigned int y0 = (uChunk / m_uChunkColumns) * CC_TMX_LAYER_CHUNK_SIZE;
+    unsigned int x1 = MIN(x0 + CC_TMX_LAYER_CHUNK_SIZE, (unsigned int)m_tLayerSize.width);
+    unsigned int y1 = MIN(y0 + CC_TMX_LAYER_CHUNK_SIZE, (unsigned int)m_tLayerSize.height);
+    unsigned int uWidth = (unsigned int)m_tLayerSize.width;
+
+    // tiles turned into sprites are drawn by their sprite
+    std::vector<unsigned int> spriteTiles;
+    if (m_pChildren && m_pChildren->count() > 0)
+    {
+        CCObject* pObject = NULL;
+        CCARRAY_FOREACH(m_pChildren, pObject)
+        {
+            unsigned int z = (unsigned int)((CCNode*)pObject)->getTag();
+            if (z % uWidth >= x0 && z % uWidth < x1 && z / uWidth >= y0 && z / uWidth < y1)
+            {
+                spriteTiles.push_back(z);
+            }
+        }
+        std::sort(spriteTiles.begin(), spriteTiles.end());
+    }
+
+    // the sprites are drawn between the quads of the tiles before and after them
+    chunk.tSpriteQuads.assign(spriteTiles.size(), 0);
+    unsigned int uQuads = 0;
+    for (unsigned int y = y0; y < y1; y++)
+    {
+        for (unsigned int x = x0; x < x1; x++)
+        {
+            unsigned int z = x + y * uWidth;
+            std::vector<unsigned int>::iterator it = std::lower_bound(spriteTiles.begin(), spriteTiles.end(), z);
+            if (it != spriteTiles.end() && *it == z)
+            {
+                chunk.tSpriteQuads[it - spriteTiles.begin()] = uQuads;
+            }
+            else if (m_pTiles[z])
+            {
+                ++uQuads;
+            }
+        }
+    }
+    chunk.tSpriteTiles.swap(spriteTiles);
+    const std::vector<unsigned int>& sprites = chunk.tSpriteTiles;
+
+    if (uQuads == 0)
+    {
+        releaseChunk(chunk);
+        chunk.bDirty = false;
+        return;
+    }
+
+    if (! chunk.pAtlas)
+    {
+        chunk.pAtlas = new CCTextureAtlas();
+        chunk.pAtlas->initWithTexture(m_pobTextureAtlas->getTexture(), uQuads);
+        ++m_uBuiltChunkCount;
+    }
+    else
+    {
+        chunk.pAtlas->removeAllQuads();
+        if (chunk.pAtlas->getCapacity() < uQuads)
+        {
+            chunk.pAtlas->resizeCapacity(uQuads);
+        }
+    }
+
+    // the quads are written by the reused tile, in the order of the tiles like the sprites of a batch node
+    unsigned int uIndex = 0;
+    for (unsigned int y = y0; y < y1; y++)
+    {
+        for (unsigned int x = x0; x < x1; x++)
+        {
+            unsigned int z = x + y * uWidth;
+            unsigned int gid = m_pTiles[z];
+            if (! gid || std::binary_search(sprites.begin(), sprites.end(), z))
+            {
+                continue;
+            }
+
+            CCRect rect = m_pTileSet->rectForGID(gid);
+            rect = CC_RECT_PIXELS_TO_POINTS(rect);
+
+            CCSprite *tile = reusedTileWithRect(rect);
+            setupTileSprite(tile, ccp(x, y), gid);
+            tile->setTextureAtlas(chunk.pAtlas);
+            tile->setAtlasIndex(uIndex++);
+            tile->setDirty(true);
+            tile->updateTransform();
+        }
+    }
+}
+
+void CCTMXLayer::releaseChunk(Chunk& chunk)
+{
+    if (chunk.pAtlas)
+    {
+        CC_SAFE_RELEASE_NULL(chunk.pAtlas);
+        --m_uBuiltChunkCount;
+    }
+    chunk.bDirty = true;
+}
+
+// the part of the layer seen through the viewport, in points. false if it can't be known,
+// like when the tiles have different vertex Z or the layer is seen from the side
+bool CCTMXLayer::visibleRect(CCRect& rect)
+{
+    if (m_bUseAutomaticVertexZ)
+    {
+        return false;
+    }
+
+    kmMat4 projection, modelview, matrix, inverse;
+    kmGLGetMatrix(KM_GL_PROJECTION, &projection);
+    kmGLGetMatrix(KM_GL_MODELVIEW, &modelview);
+    kmMat4Multiply(&matrix, &projection, &modelview);
+    if (! kmMat4Inverse(&inverse, &matrix))
+    {
+        return false;
+    }
+
+    float minX = FLT_MAX, maxX = -FLT_MAX, minY = FLT_MAX, maxY = -FLT_MAX;
+    for (int i = 0; i < 4; ++i)
+    {
+        // a corner of the viewport, from the near plane to the far plane
+        kmVec3 corner, nearPoint, farPoint;
+        kmVec3Fill(&corner, (i & 1) ? 1.0f : -1.0f, (i & 2) ? 1.0f : -1.0f, -1.0f);
+        kmVec3TransformCoord(&nearPoint, &corner, &inverse);
+        corner.z = 1.0f;
+        kmVec3TransformCoord(&farPoint, &corner, &inverse);
+
+        // where it crosses the plane of the tiles
+        float fDepth = farPoint.z - nearPoint.z;
+        if (fabsf(fDepth) < FLT_EPSILON)
+        {
+            return false;
+        }
+        float t = (m_nVertexZvalue - nearPoint.z) / fDepth;
+        if (t < 0 || t > 1)
+        {
+            return false;
+        }
+
+        float x = nearPoint.x + (farPoint.x - nearPoint.x) * t;
+        float y = nearPoint.y + (farPoint.y - nearPoint.y) * t;
+        minX = MIN(minX, x);
+        maxX = MAX(maxX, x);
+        minY = MIN(minY, y);
+        maxY = MAX(maxY, y);
+    }
+
+    rect = CCRectMake(minX, minY, maxX - minX, maxY - minY);
+    return true;
+}
+
+// a tile turned into a sprite, drawn with its chunk
+typedef struct _ccTMXSpriteTile
+{
+    unsigned int    uChunk;
+    unsigned int    z;
+    CCSprite        *pSprite;
+} ccTMXSpriteTile;
+
+static bool compareSpriteTiles(const ccTMXSpriteTile& a, const ccTMXSpriteTile& b)
+{
+    return a.uChunk < b.uChunk || (a.uChunk == b.uChunk && a.z < b.z);
+}
+
+void CCTMXLayer::draw(void)
+{
+    CC_PROFILER_START("CCTMXLayer - draw");
+
+    CC_NODE_DRAW_SETUP();
+
+    ccGLBlendFunc( m_blendFunc.src, m_blendFunc.dst );
+
+    // tiles turned into sprites, by chunk and in the order of the tiles
+    std::vector<ccTMXSpriteTile> spriteTiles;
+    std::vector<CCSprite*> lateSprites;
+    if (m_pChildren && m_pChildren->count() > 0)
+    {
+        arrayMakeObjectsPerformSelector(m_pChildren, updateTransform, CCSprite*);
+
+        unsigned int uWidth = (unsigned int)m_tLayerSize.width;
+        spriteTiles.reserve(m_pChildren->count());
+        CCObject* pObject = NULL;
+        CCARRAY_FOREACH(m_pChildren, pObject)
+        {
+            ccTMXSpriteTile spriteTile;
+            spriteTile.pSprite = (CCSprite*)pObject;
+            spriteTile.z = (unsigned int)spriteTile.pSprite->getTag();
+            spriteTile.uChunk = (spriteTile.z % uWidth) / CC_TMX_LAYER_CHUNK_SIZE + (spriteTile.z / uWidth) / CC_TMX_LAYER_CHUNK_SIZE * m_uChunkColumns;
+            spriteTiles.push_back(spriteTile);
+        }
+        std::sort(spriteTiles.begin(), spriteTiles.end(), compareSpriteTiles);
+    }
+
+    CCRect visible;
+    bool bCulling = visibleRect(visible);
+    unsigned int uFrame = CCDirector::sharedDirector()->getTotalFrames();
+
+    m_uDrawnChunkCount = 0;
+    unsigned int uSprite = 0;
+    for (unsigned int i = 0; i < m_tChunks.size(); ++i)
+    {
+        unsigned int uSpriteEnd = uSprite;
+        while (uSpriteEnd < spriteTiles.size() && spriteTiles[uSpriteEnd].uChunk == i)
+        {
+            ++uSpriteEnd;
+        }
+
+        Chunk& chunk = m_tChunks[i];
+        if (bCulling && ! chunk.tBounds.intersectsRect(visible))
+        {
+            // the quads are kept a while in case the chunk comes back into view
+            if (chunk.pAtlas && m_pTiles && uFrame - chunk.uLastVisibleFrame > CC_TMX_LAYER_CHUNK_RELEASE_FRAMES)
+            {
+                releaseChunk(chunk);
+            }
+
+            // the sprites may have been moved into view
+            for (; uSprite < uSpriteEnd; ++uSprite)
+            {
+                lateSprites.push_back(spriteTiles[uSprite].pSprite);
+            }
+            continue;
+        }
+
+        chunk.uLastVisibleFrame = uFrame;
+        if (chunk.bDirty && m_pTiles)
+        {
+            buildChunk(i);
+        }
+
+        unsigned int uQuads = chunk.pAtlas ? chunk.pAtlas->getTotalQuads() : 0;
+        unsigned int uStart = 0;
+        for (; uSprite < uSpriteEnd; ++uSprite)
+        {
+            // the quads of the tiles before the sprite
+            unsigned int z = spriteTiles[uSprite].z;
+            std::vector<unsigned int>::iterator it = std::lower_bound(chunk.tSpriteTiles.begin(), chunk.tSpriteTiles.end(), z);
+            unsigned int uEnd = (it != chunk.tSpriteTiles.end() && *it == z) ? chunk.tSpriteQuads[it - chunk.tSpriteTiles.begin()] : uQuads;
+            uEnd = MIN(uEnd, uQuads);
+            if (uEnd > uStart)
+            {
+                chunk.pAtlas->drawNumberOfQuads(uEnd - uStart, uStart);
+                uStart = uEnd;
+            }
+
+            drawSpriteTile(spriteTiles[uSprite].pSprite);
+        }
+
+        if (uQuads > uStart)
+        {
+            chunk.pAtlas->drawNumberOfQuads(uQuads - uStart, uStart);
+        }
+        if (uQuads > 0)
+        {
+            ++m_uDrawnChunkCount;
+        }
+    }
+
+    // the sprites of the chunks out of view, and the ones outside of the layer
+    for (; uSprite < spriteTiles.size(); ++uSprite)
+    {
+        lateSprites.push_back(spriteTiles[uSprite].pSprite);
+    }
+    for (unsigned int i = 0; i < lateSprites.size(); ++i)
+    {
+        drawSpriteTile(lateSprites[i]);
+    }
+
+    CC_PROFILER_STOP("CCTMXLayer - draw");
+}
+
+// draws the quads of a tile turned into a sprite and of its children, from the atlas of the batch node
+void CCTMXLayer::drawSpriteTile(CCSprite *pSprite)
+{
+    unsigned int uFirst = pSprite->getAtlasIndex();
+    unsigned int uLast = highestAtlasIndexInChild(pSprite);
+    if (uFirst <= uLast && uLast < m_pobTextureAtlas->getTotalQuads())
+    {
+        m_pobTextureAtlas->drawNumberOfQuads(uLast - uFirst + 1, uFirst);
+    }
+}
+
+void CCTMXLayer::setTexture(CCTexture2D *texture)
+{
+    CCSpriteBatchNode::setTexture(texture);
+
+    for (unsigned int i = 0; i < m_tChunks.size(); ++i)
+    {
+        if (m_tChunks[i].pAtlas)
+        {
+            m_tChunks[i].pAtlas->setTexture(texture);
+        }
+    }
 }
 
 //CCTMXLayer - obtaining positions, offset
@@ -30,22 +30,33 @@ THE SOFTWARE.
 #include "base_nodes/CCAtlasNode.h"
 #include "sprite_nodes/CCSpriteBatchNode.h"
 #include "CCTMXXMLParser.h"
+#include <vector>
+#include <set>
 NS_CC_BEGIN
 
 class CCTMXMapInfo;
 class CCTMXLayerInfo;
 class CCTMXTilesetInfo;
-struct _ccCArray;
+class CCTextureAtlas;
 
 /**
  * @addtogroup tilemap_parallax_nodes
  * @{
  */
 
+/** Width and height of the chunks a CCTMXLayer is drawn by, in tiles */
+#define CC_TMX_LAYER_CHUNK_SIZE                 32
+
+/** Number of frames a chunk of a CCTMXLayer stays out of view before its quads are released */
+#define CC_TMX_LAYER_CHUNK_RELEASE_FRAMES       120
+
 /** @brief CCTMXLayer represents the TMX layer.
 
-It is a subclass of CCSpriteBatchNode. By default the tiles are rendered using a CCTextureAtlas.
-If you modify a tile on runtime, then, that tile will become a CCSprite, otherwise no CCSprite objects are created.
+It is a subclass of CCSpriteBatchNode. By default the tiles are rendered using a CCTextureAtlas
+per chunk of CC_TMX_LAYER_CHUNK_SIZE x CC_TMX_LAYER_CHUNK_SIZE tiles. The quads of a chunk are only
+built when the chunk is in view, only the chunks in view are drawn, and changing a tile only rebuilds
+its chunk, so the cost of a layer follows the visible area rather than the size of the map.
+If you get a tile with tileAt(), then, that tile will become a CCSprite, otherwise no CCSprite objects are created.
 The benefits of using CCSprite objects as tiles are:
 - tiles (CCSprite) can be rotated/scaled/moved with a nice API
 
@@ -108,24 +119,24 @@ public:
     - layer->removeChild(sprite, cleanup);
     - or layer->removeTileAt(ccp(x,y));
     */
-    CCSprite* tileAt(const CCPoint& tileCoordinate);
+    virtual CCSprite* tileAt(const CCPoint& tileCoordinate);
 
     /** returns the tile gid at a given tile coordinate.
     if it returns 0, it means that the tile is empty.
     This method requires the the tile map has not been previously released (eg. don't call layer->releaseMap())
     */
-    unsigned int  tileGIDAt(const CCPoint& tileCoordinate);
+    virtual unsigned int tileGIDAt(const CCPoint& tileCoordinate);
 
     /** returns the tile gid at a given tile coordinate. It also returns the tile flags.
      This method requires the the tile map has not been previously released (eg. don't call [layer releaseMap])
      */
-    unsigned int tileGIDAt(const CCPoint& tileCoordinate, ccTMXTileFlags* flags);
+    virtual unsigned int tileGIDAt(const CCPoint& tileCoordinate, ccTMXTileFlags* flags);
 
     /** sets the tile gid (gid = tile global id) at a given tile coordinate.
     The Tile GID can be obtained by using the method "tileGIDAt" or by using the TMX editor -> Tileset Mgr +1.
     If a tile is already placed at that position, then it will be removed.
     */
-    void setTileGID(unsigned int gid, const CCPoint& tileCoordinate);
+    virtual void setTileGID(unsigned int gid, const CCPoint& tileCoordinate);
 
     /** sets the tile gid (gid = tile global id) at a given tile coordinate.
      The Tile GID can be obtained by using the method "tileGIDAt" or by using the TMX editor -> Tileset Mgr +1.
@@ -134,10 +145,38 @@ public:
      Use withFlags if the tile flags need to be changed as well
      */
 
-    void setTileGID(unsigned int gid, const CCPoint& tileCoordinate, ccTMXTileFlags flags);
+    virtual void setTileGID(unsigned int gid, const CCPoint& tileCoordinate, ccTMXTileFlags flags);
 
     /** removes a tile at given tile coordinate */
-    void removeTileAt(const CCPoint& tileCoordinate);
+    virtual void removeTileAt(const CCPoint& tileCoordinate);
+
+    /** sets the tiles of a rectangle of tile coordinates in one pass.
+     gids holds rect.size.width * rect.size.height values row by row, each a gid with its tile flags, 0 removing the tile.
+     The chunks of the changed tiles are rebuilt once, the next time they are drawn.
+     @since v2.1.4
+     */
+    void setTileGIDs(const CCRect& rect, const unsigned int *gids);
+
+    /** sets every tile of a rectangle of tile coordinates to the same gid, 0 removing the tiles
+     @since v2.1.4
+     */
+    void fillRect(const CCRect& rect, unsigned int gid);
+    void fillRect(const CCRect& rect, unsigned int gid, ccTMXTileFlags flags);
+
+    /** adds to tileCoordinates the coordinates of the tiles inside a rectangle of tile coordinates
+     whose gid, without flags, is one of gids. The rectangle is clipped to the layer.
+     @return the number of tiles added
+     @since v2.1.4
+     */
+    virtual unsigned int tilesWithGIDs(const CCRect& rect, const std::set<unsigned int>& gids, std::vector<CCPoint>& tileCoordinates);
+
+    /** finds the first non-empty tile crossed by the segment between two points in tile coordinates,
+     where the tile (x, y) covers [x, x + 1) x [y, y + 1). The tiles are visited in order from the start,
+     the ones out of the layer being skipped.
+     @return true and the coordinate of the tile in tileCoordinate if there is one
+     @since v2.1.4
+     */
+    bool firstTileAlongRay(const CCPoint& from, const CCPoint& to, CCPoint& tileCoordinate);
 
     /** returns the position in points of a given tile coordinate */
     CCPoint positionAt(const CCPoint& tileCoordinate);
@@ -157,17 +196,76 @@ public:
 
     inline const char* getLayerName(){ return m_sLayerName.c_str(); }
     inline void setLayerName(const char *layerName){ m_sLayerName = layerName; }
-private:
+
+    /** draws the chunks in view, the tiles turned into sprites being drawn with their chunk in the order of the tiles
+     @since v2.1.4
+     */
+    virtual void draw(void);
+
+    // super method
+    virtual void setTexture(CCTexture2D *texture);
+
+    /** number of chunks drawn by the last frame
+     @since v2.1.4
+     */
+    inline unsigned int getDrawnChunkCount() { return m_uDrawnChunkCount; }
+
+    /** number of chunks whose quads are built
+     @since v2.1.4
+     */
+    inline unsigned int getBuiltChunkCount() { return m_uBuiltChunkCount; }
+protected:
+    typedef struct _Chunk
+    {
+        //! quads of the tiles of the chunk, NULL if they are not built or if the chunk is empty
+        CCTextureAtlas *pAtlas;
+        //! the quads don't match the tiles any more
+        bool            bDirty;
+        //! last frame the chunk was in view
+        unsigned int    uLastVisibleFrame;
+        //! area the tiles of the chunk can cover, in points
+        CCRect          tBounds;
+        //! tiles of the chunk turned into sprites, sorted, when the quads were built
+        std::vector<unsigned int> tSpriteTiles;
+        //! number of quads of the chunk before each tile of tSpriteTiles
+        std::vector<unsigned int> tSpriteQuads;
+    } Chunk;
+
+    /* matches gids without flags against a set of gids, for tilesWithGIDs() */
+    class GIDMatcher
+    {
+    public:
+        GIDMatcher(const std::set<unsigned int>& gids);
+        bool matches(unsigned int gid);
+    private:
+        unsigned int                m_uMinGID;
+        unsigned int                m_uMaxGID;
+        //! a flag by gid between the smallest and the largest one, empty if they are too far apart
+        std::vector<unsigned char>  m_tTable;
+        //! the sorted gids, if there is no table
+        std::vector<unsigned int>   m_tSortedGIDs;
+        //! neighbour tiles often have the same gid, the last search is kept
+        bool                        m_bHasLast;
+        unsigned int                m_uLastGID;
+        bool                        m_bLastFound;
+    };
+
     CCPoint positionForIsoAt(const CCPoint& pos);
     CCPoint positionForOrthoAt(const CCPoint& pos);
     CCPoint positionForHexAt(const CCPoint& pos);
 
     CCPoint calculateLayerOffset(const CCPoint& offset);
 
-    /* optimization methods */
-    CCSprite* appendTileForGID(unsigned int gid, const CCPoint& pos);
-    CCSprite* insertTileForGID(unsigned int gid, const CCPoint& pos);
-    CCSprite* updateTileForGID(unsigned int gid, const CCPoint& pos);
+    /* chunks */
+    void setupChunks();
+    void setChunkDirtyForTile(const CCPoint& pos);
+    virtual void setTilesInRect(const CCRect& rect, const unsigned int *gids, unsigned int gidAndFlags);
+    /* the gid and flags of a tile inside the layer */
+    virtual unsigned int rawTileAt(unsigned int x, unsigned int y);
+    void buildChunk(unsigned int uChunk);
+    void releaseChunk(Chunk& chunk);
+    void drawSpriteTile(CCSprite *pSprite);
+    bool visibleRect(CCRect& rect);
 
     /* The layer recognizes some special properties, like cc_vertez */
     void parseInternalProperties();
@@ -175,10 +273,6 @@ private:
     CCSprite* reusedTileWithRect(CCRect rect);
     int vertexZForPos(const CCPoint& pos);
 
-    // index
-    unsigned int atlasIndexForExistantZ(unsigned int z);
-    unsigned int atlasIndexForNewZ(int z);
-protected:
     //! name of the layer
     std::string m_sLayerName;
     //! TMX Layer supports opacity
@@ -193,7 +287,13 @@ protected:
 
     //! used for optimization
     CCSprite            *m_pReusedTile;
-    ccCArray            *m_pAtlasIndexArray;
+
+    //! chunks of the layer, row by row
+    std::vector<Chunk>  m_tChunks;
+    unsigned int        m_uChunkColumns;
+    unsigned int        m_uChunkRows;
+    unsigned int        m_uDrawnChunkCount;
+    unsigned int        m_uBuiltChunkCount;
     
     // used for retina display
     float               m_fContentScaleFactor;            
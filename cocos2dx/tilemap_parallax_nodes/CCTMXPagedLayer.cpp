@@ -0,0 +1,1298 @@
+/****************************************************************************
+Copyright (c) 2013 cocos2d-x.org
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+#include "CCTMXPagedLayer.h"
+#include "CCTMXXMLParser.h"
+#include "sprite_nodes/CCSprite.h"
+#include "textures/CCTextureAtlas.h"
+#include "shaders/CCGLProgram.h"
+#include "shaders/ccGLStateCache.h"
+#include "platform/CCFileUtils.h"
+#include "support/CCPointExtension.h"
+#include "cocoa/CCString.h"
+#include "CCDirector.h"
+#include <deque>
+#include <limits.h>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+
+NS_CC_BEGIN
+
+// CCTMXPageFile - page file format
+//
+// The header holds the layer, its map and its tileset, then the slot of every page row by row:
+// 0 for an empty page, otherwise the page is stored at the start of the pages plus (slot - 1) times
+// the size of a page. The pages are stored uncompressed so a changed page is written back in place,
+// a page getting its first tiles being added at the end of the file. The values are stored in the
+// byte order of the device.
+
+#define CC_TMX_PAGE_FILE_VERSION        1
+
+static bool writeUInt(FILE *fp, unsigned int uValue)
+{
+    return fwrite(&uValue, sizeof(uValue), 1, fp) == 1;
+}
+
+static bool writeFloat(FILE *fp, float fValue)
+{
+    return fwrite(&fValue, sizeof(fValue), 1, fp) == 1;
+}
+
+static bool writeString(FILE *fp, const std::string& str)
+{
+    return writeUInt(fp, (unsigned int)str.size()) && (str.empty() || fwrite(str.c_str(), str.size(), 1, fp) == 1);
+}
+
+static bool readUInt(FILE *fp, unsigned int& uValue)
+{
+    return fread(&uValue, sizeof(uValue), 1, fp) == 1;
+}
+
+static bool readFloat(FILE *fp, float& fValue)
+{
+    return fread(&fValue, sizeof(fValue), 1, fp) == 1;
+}
+
+static bool readString(FILE *fp, std::string& str)
+{
+    unsigned int uLength = 0;
+    if (! readUInt(fp, uLength) || uLength > 0xffff)
+    {
+        return false;
+    }
+
+    str.resize(uLength);
+    return uLength == 0 || fread(&str[0], uLength, 1, fp) == 1;
+}
+
+/** @brief CCTMXPageFile reads and writes the pages of a page file, in the background or not.
+ The file and the slots are only used with m_tFileMutex locked, the queues with m_tQueueMutex locked,
+ in this order when both are needed.
+ */
+class CCTMXPageFile
+{
+public:
+    CCTMXPageFile()
+    : m_pFile(NULL)
+    , m_bReadOnly(false)
+    , m_uPageSize(0)
+    , m_uPageColumns(0)
+    , m_uPageRows(0)
+    , m_uSlotCount(0)
+    , m_lSlotsOffset(0)
+    , m_lPagesOffset(0)
+    , m_bThreadStarted(false)
+    , m_bQuit(false)
+    , m_uLastRequestId(0)
+    {
+        pthread_mutex_init(&m_tFileMutex, NULL);
+        pthread_mutex_init(&m_tQueueMutex, NULL);
+        pthread_cond_init(&m_tCondition, NULL);
+    }
+
+    ~CCTMXPageFile()
+    {
+        if (m_bThreadStarted)
+        {
+            pthread_mutex_lock(&m_tQueueMutex);
+            m_bQuit = true;
+            pthread_mutex_unlock(&m_tQueueMutex);
+            pthread_cond_signal(&m_tCondition);
+            pthread_join(m_tThread, NULL);
+        }
+
+        flush();
+
+        for (unsigned int i = 0; i < m_tLoaded.size(); ++i)
+        {
+            CC_SAFE_DELETE_ARRAY(m_tLoaded[i].pTiles);
+        }
+
+        if (m_pFile)
+        {
+            fclose(m_pFile);
+        }
+
+        pthread_cond_destroy(&m_tCondition);
+        pthread_mutex_destroy(&m_tQueueMutex);
+        pthread_mutex_destroy(&m_tFileMutex);
+    }
+
+    static bool writeHeader(FILE *fp, CCTMXTilesetInfo *tilesetInfo, CCTMXLayerInfo *layerInfo, CCTMXMapInfo *mapInfo, unsigned int uPageSize)
+    {
+        bool bRet = fwrite("CCTP", 4, 1, fp) == 1
+            && writeUInt(fp, CC_TMX_PAGE_FILE_VERSION)
+            && writeUInt(fp, (unsigned int)mapInfo->getOrientation())
+            && writeFloat(fp, mapInfo->getTileSize().width)
+            && writeFloat(fp, mapInfo->getTileSize().height)
+            && writeString(fp, layerInfo->m_sName)
+            && writeUInt(fp, (unsigned int)layerInfo->m_tLayerSize.width)
+            && writeUInt(fp, (unsigned int)layerInfo->m_tLayerSize.height)
+            && writeUInt(fp, layerInfo->m_cOpacity)
+            && writeFloat(fp, layerInfo->m_tOffset.x)
+            && writeFloat(fp, layerInfo->m_tOffset.y)
+            && writeString(fp, tilesetInfo->m_sName)
+            && writeUInt(fp, tilesetInfo->m_uFirstGid)
+            && writeFloat(fp, tilesetInfo->m_tTileSize.width)
+            && writeFloat(fp, tilesetInfo->m_tTileSize.height)
+            && writeUInt(fp, tilesetInfo->m_uSpacing)
+            && writeUInt(fp, tilesetInfo->m_uMargin)
+            && writeString(fp, tilesetInfo->m_sSourceImage);
+
+        CCDictionary *pProperties = layerInfo->getProperties();
+        bRet = bRet && writeUInt(fp, pProperties ? pProperties->count() : 0);
+        if (pProperties)
+        {
+            CCDictElement *pElement = NULL;
+            CCDICT_FOREACH(pProperties, pElement)
+            {
+                CCString *pValue = dynamic_cast<CCString*>(pElement->getObject());
+                bRet = bRet && writeString(fp, pElement->getStrKey()) && writeString(fp, pValue ? pValue->getCString() : "");
+            }
+        }
+
+        return bRet && writeUInt(fp, uPageSize);
+    }
+
+    bool open(const char *pszPath, CCTMXTilesetInfo *tilesetInfo, CCTMXLayerInfo *layerInfo, CCTMXMapInfo *mapInfo)
+    {
+        bool bRet = false;
+        do
+        {
+            m_pFile = fopen(pszPath, "r+b");
+            if (! m_pFile)
+            {
+                m_pFile = fopen(pszPath, "rb");
+                m_bReadOnly = true;
+            }
+            CC_BREAK_IF(! m_pFile);
+
+            char magic[4];
+            unsigned int uVersion = 0;
+            CC_BREAK_IF(fread(magic, 4, 1, m_pFile) != 1 || memcmp(magic, "CCTP", 4) != 0);
+            CC_BREAK_IF(! readUInt(m_pFile, uVersion) || uVersion != CC_TMX_PAGE_FILE_VERSION);
+
+            unsigned int uOrientation = 0, uWidth = 0, uHeight = 0, uOpacity = 0, uPropertyCount = 0;
+            CCSize tileSize;
+            CC_BREAK_IF(! readUInt(m_pFile, uOrientation)
+                || ! readFloat(m_pFile, tileSize.width)
+                || ! readFloat(m_pFile, tileSize.height)
+                || ! readString(m_pFile, layerInfo->m_sName)
+                || ! readUInt(m_pFile, uWidth)
+                || ! readUInt(m_pFile, uHeight)
+                || ! readUInt(m_pFile, uOpacity)
+                || ! readFloat(m_pFile, layerInfo->m_tOffset.x)
+                || ! readFloat(m_pFile, layerInfo->m_tOffset.y)
+                || ! readString(m_pFile, tilesetInfo->m_sName)
+                || ! readUInt(m_pFile, tilesetInfo->m_uFirstGid)
+                || ! readFloat(m_pFile, tilesetInfo->m_tTileSize.width)
+                || ! readFloat(m_pFile, tilesetInfo->m_tTileSize.height)
+                || ! readUInt(m_pFile, tilesetInfo->m_uSpacing)
+                || ! readUInt(m_pFile, tilesetInfo->m_uMargin)
+                || ! readString(m_pFile, tilesetInfo->m_sSourceImage)
+                || ! readUInt(m_pFile, uPropertyCount));
+
+            mapInfo->setOrientation((int)uOrientation);
+            mapInfo->setTileSize(tileSize);
+            mapInfo->setMapSize(CCSizeMake((float)uWidth, (float)uHeight));
+            layerInfo->m_tLayerSize = CCSizeMake((float)uWidth, (float)uHeight);
+            layerInfo->m_cOpacity = (unsigned char)uOpacity;
+            layerInfo->m_bVisible = true;
+
+            unsigned int i = 0;
+            for (; i < uPropertyCount; ++i)
+            {
+                std::string key, value;
+                if (! readString(m_pFile, key) || ! readString(m_pFile, value))
+                {
+                    break;
+                }
+                layerInfo->getProperties()->setObject(CCString::create(value), key);
+            }
+            CC_BREAK_IF(i != uPropertyCount);
+
+            CC_BREAK_IF(! readUInt(m_pFile, m_uPageSize) || m_uPageSize == 0 || uWidth == 0 || uHeight == 0);
+            m_uPageColumns = (uWidth + m_uPageSize - 1) / m_uPageSize;
+            m_uPageRows = (uHeight + m_uPageSize - 1) / m_uPageSize;
+
+            m_tSlots.resize(m_uPageColumns * m_uPageRows);
+            m_lSlotsOffset = ftell(m_pFile);
+            CC_BREAK_IF(fread(&m_tSlots[0], sizeof(unsigned int), m_tSlots.size(), m_pFile) != m_tSlots.size());
+            m_lPagesOffset = ftell(m_pFile);
+
+            m_uSlotCount = 0;
+            for (i = 0; i < m_tSlots.size(); ++i)
+            {
+                m_uSlotCount = MAX(m_uSlotCount, m_tSlots[i]);
+            }
+
+            bRet = true;
+        } while (0);
+
+        if (! bRet)
+        {
+            CCLOG("cocos2d: CCTMXPagedLayer: can't read the page file %s", pszPath);
+        }
+        else if (m_bReadOnly)
+        {
+            CCLOG("cocos2d: CCTMXPagedLayer: %s is read only, the changed pages will be kept in memory", pszPath);
+        }
+        return bRet;
+    }
+
+    inline bool isReadOnly() { return m_bReadOnly; }
+    inline unsigned int getPageSize() { return m_uPageSize; }
+    inline unsigned int getPageColumns() { return m_uPageColumns; }
+    inline unsigned int getPageRows() { return m_uPageRows; }
+
+    /** reads a page without waiting for the background thread. A page waiting to be written is given back
+     with bModified set instead, as it is newer than the page file.
+     @return the tiles, NULL if the page is empty
+     */
+    unsigned int* readPage(unsigned int uPage, bool& bModified)
+    {
+        unsigned int *pTiles = NULL;
+
+        pthread_mutex_lock(&m_tFileMutex);
+        pthread_mutex_lock(&m_tQueueMutex);
+        bModified = takePendingWrite(uPage, pTiles);
+        pthread_mutex_unlock(&m_tQueueMutex);
+        if (! bModified)
+        {
+            pTiles = readPageData(uPage);
+        }
+        pthread_mutex_unlock(&m_tFileMutex);
+
+        return pTiles;
+    }
+
+    /** asks the background thread to read a page. A page waiting to be written is given back in ppModified instead.
+     @return the id of the request, 0 if the page was given back
+     */
+    unsigned int requestPage(unsigned int uPage, unsigned int **ppModified)
+    {
+        unsigned int uRequestId = 0;
+
+        pthread_mutex_lock(&m_tQueueMutex);
+        if (! takePendingWrite(uPage, *ppModified))
+        {
+            uRequestId = ++m_uLastRequestId;
+            PageRequest request = { uPage, uRequestId, NULL };
+            m_tRequests.push_back(request);
+        }
+        pthread_mutex_unlock(&m_tQueueMutex);
+
+        if (uRequestId)
+        {
+            startThread();
+            pthread_cond_signal(&m_tCondition);
+        }
+        return uRequestId;
+    }
+
+    /** asks the background thread to write a page, the tiles are deleted once written */
+    void writePage(unsigned int uPage, unsigned int *pTiles)
+    {
+        pthread_mutex_lock(&m_tQueueMutex);
+        m_tWrites[uPage] = pTiles;
+        pthread_mutex_unlock(&m_tQueueMutex);
+
+        startThread();
+        pthread_cond_signal(&m_tCondition);
+    }
+
+    /** writes a page without waiting for the background thread, the tiles are not deleted */
+    void writePageNow(unsigned int uPage, const unsigned int *pTiles)
+    {
+        pthread_mutex_lock(&m_tFileMutex);
+        writePageData(uPage, pTiles);
+        pthread_mutex_unlock(&m_tFileMutex);
+    }
+
+    /** gives a page read by the background thread */
+    bool popLoadedPage(unsigned int& uPage, unsigned int& uRequestId, unsigned int*& pTiles)
+    {
+        bool bRet = false;
+
+        pthread_mutex_lock(&m_tQueueMutex);
+        if (! m_tLoaded.empty())
+        {
+            uPage = m_tLoaded.front().uPage;
+            uRequestId = m_tLoaded.front().uRequestId;
+            pTiles = m_tLoaded.front().pTiles;
+            m_tLoaded.pop_front();
+            bRet = true;
+        }
+        pthread_mutex_unlock(&m_tQueueMutex);
+
+        return bRet;
+    }
+
+    /** writes the pages waiting for the background thread */
+    void flush()
+    {
+        pthread_mutex_lock(&m_tFileMutex);
+        pthread_mutex_lock(&m_tQueueMutex);
+        std::map<unsigned int, unsigned int*> writes;
+        writes.swap(m_tWrites);
+        pthread_mutex_unlock(&m_tQueueMutex);
+
+        for (std::map<unsigned int, unsigned int*>::iterator it = writes.begin(); it != writes.end(); ++it)
+        {
+            writePageData(it->first, it->second);
+            delete [] it->second;
+        }
+        if (m_pFile)
+        {
+            fflush(m_pFile);
+        }
+        pthread_mutex_unlock(&m_tFileMutex);
+    }
+
+private:
+    typedef struct _PageRequest
+    {
+        unsigned int    uPage;
+        unsigned int    uRequestId;
+        unsigned int    *pTiles;
+    } PageRequest;
+
+    void startThread()
+    {
+        if (! m_bThreadStarted)
+        {
+            m_bThreadStarted = pthread_create(&m_tThread, NULL, loadPages, this) == 0;
+        }
+    }
+
+    static void* loadPages(void *data)
+    {
+        CCTMXPageFile *pPageFile = (CCTMXPageFile*)data;
+
+        while (true)
+        {
+            pthread_mutex_lock(&pPageFile->m_tQueueMutex);
+            while (! pPageFile->m_bQuit && pPageFile->m_tRequests.empty() && pPageFile->m_tWrites.empty())
+            {
+                pthread_cond_wait(&pPageFile->m_tCondition, &pPageFile->m_tQueueMutex);
+            }
+            bool bQuit = pPageFile->m_bQuit;
+            pthread_mutex_unlock(&pPageFile->m_tQueueMutex);
+
+            if (bQuit)
+            {
+                break;
+            }
+
+            // the pages are written first, so that a page read again after being changed is read as changed
+            pthread_mutex_lock(&pPageFile->m_tFileMutex);
+            pthread_mutex_lock(&pPageFile->m_tQueueMutex);
+            unsigned int uPage = 0;
+            unsigned int *pWrite = NULL;
+            bool bRead = false;
+            PageRequest request;
+            if (! pPageFile->m_tWrites.empty())
+            {
+                uPage = pPageFile->m_tWrites.begin()->first;
+                pWrite = pPageFile->m_tWrites.begin()->second;
+                pPageFile->m_tWrites.erase(pPageFile->m_tWrites.begin());
+            }
+            else if (! pPageFile->m_tRequests.empty())
+            {
+                request = pPageFile->m_tRequests.front();
+                pPageFile->m_tRequests.pop_front();
+                bRead = true;
+            }
+            pthread_mutex_unlock(&pPageFile->m_tQueueMutex);
+
+            if (pWrite)
+            {
+                pPageFile->writePageData(uPage, pWrite);
+                delete [] pWrite;
+            }
+            else if (bRead)
+            {
+                request.pTiles = pPageFile->readPageData(request.uPage);
+            }
+            pthread_mutex_unlock(&pPageFile->m_tFileMutex);
+
+            if (bRead)
+            {
+                pthread_mutex_lock(&pPageFile->m_tQueueMutex);
+                pPageFile->m_tLoaded.push_back(request);
+                pthread_mutex_unlock(&pPageFile->m_tQueueMutex);
+            }
+        }
+
+        return 0;
+    }
+
+    // with m_tQueueMutex locked
+    bool takePendingWrite(unsigned int uPage, unsigned int*& pTiles)
+    {
+        std::map<unsigned int, unsigned int*>::iterator it = m_tWrites.find(uPage);
+        if (it == m_tWrites.end())
+        {
+            return false;
+        }
+
+        pTiles = it->second;
+        m_tWrites.erase(it);
+        return true;
+    }
+
+    // with m_tFileMutex locked
+    unsigned int* readPageData(unsigned int uPage)
+    {
+        unsigned int uSlot = m_tSlots[uPage];
+        if (uSlot == 0)
+        {
+            return NULL;
+        }
+
+        unsigned int uTileCount = m_uPageSize * m_uPageSize;
+        unsigned int *pTiles = new unsigned int[uTileCount];
+        if (fseek(m_pFile, m_lPagesOffset + (long)(uSlot - 1) * uTileCount * sizeof(unsigned int), SEEK_SET) != 0
+            || fread(pTiles, sizeof(unsigned int), uTileCount, m_pFile) != uTileCount)
+        {
+            CCLOG("cocos2d: CCTMXPagedLayer: can't read the page %u", uPage);
+            memset(pTiles, 0, uTileCount * sizeof(unsigned int));
+        }
+        return pTiles;
+    }
+
+    // with m_tFileMutex locked
+    void writePageData(unsigned int uPage, const unsigned int *pTiles)
+    {
+        unsigned int uTileCount = m_uPageSize * m_uPageSize;
+        unsigned int uSlot = m_tSlots[uPage];
+        if (uSlot == 0)
+        {
+            unsigned int i = 0;
+            while (pTiles && i < uTileCount && pTiles[i] == 0)
+            {
+                ++i;
+            }
+            // an empty page stays without slot
+            if (! pTiles || i == uTileCount)
+            {
+                return;
+            }
+
+            uSlot = ++m_uSlotCount;
+            m_tSlots[uPage] = uSlot;
+            if (fseek(m_pFile, m_lSlotsOffset + (long)uPage * sizeof(unsigned int), SEEK_SET) != 0
+                || ! writeUInt(m_pFile, uSlot))
+            {
+                CCLOG("cocos2d: CCTMXPagedLayer: can't write the slot of the page %u", uPage);
+            }
+        }
+
+        bool bWritten = fseek(m_pFile, m_lPagesOffset + (long)(uSlot - 1) * uTileCount * sizeof(unsigned int), SEEK_SET) == 0;
+        if (pTiles)
+        {
+            bWritten = bWritten && fwrite(pTiles, sizeof(unsigned int), uTileCount, m_pFile) == uTileCount;
+        }
+        else
+        {
+            std::vector<unsigned int> zeros(uTileCount, 0);
+            bWritten = bWritten && fwrite(&zeros[0], sizeof(unsigned int), uTileCount, m_pFile) == uTileCount;
+        }
+
+        if (! bWritten)
+        {
+            CCLOG("cocos2d: CCTMXPagedLayer: can't write the page %u", uPage);
+        }
+    }
+
+    FILE                                    *m_pFile;
+    bool                                    m_bReadOnly;
+    unsigned int                            m_uPageSize;
+    unsigned int                            m_uPageColumns;
+    unsigned int                            m_uPageRows;
+    std::vector<unsigned int>               m_tSlots;
+    unsigned int                            m_uSlotCount;
+    long                                    m_lSlotsOffset;
+    long                                    m_lPagesOffset;
+
+    pthread_t                               m_tThread;
+    bool                                    m_bThreadStarted;
+    pthread_mutex_t                         m_tFileMutex;
+    pthread_mutex_t                         m_tQueueMutex;
+    pthread_cond_t                          m_tCondition;
+    bool                                    m_bQuit;
+    unsigned int                            m_uLastRequestId;
+    std::deque<PageRequest>                 m_tRequests;
+    std::deque<PageRequest>                 m_tLoaded;
+    std::map<unsigned int, unsigned int*>   m_tWrites;
+};
+
+// CCTMXPagedLayer - page files
+
+bool CCTMXPagedLayer::createPageFile(const char *pszPageFile, CCTMXTilesetInfo *tilesetInfo, CCTMXLayerInfo *layerInfo, CCTMXMapInfo *mapInfo,
+                                     unsigned int uPageSize)
+{
+    CCAssert(pszPageFile && tilesetInfo && layerInfo && mapInfo, "CCTMXPagedLayer: invalid parameters");
+    CCAssert(uPageSize > 0, "CCTMXPagedLayer: invalid page size");
+
+    FILE *fp = fopen(pszPageFile, "wb");
+    if (! fp)
+    {
+        CCLOG("cocos2d: CCTMXPagedLayer: can't create the page file %s", pszPageFile);
+        return false;
+    }
+
+    unsigned int uWidth = (unsigned int)layerInfo->m_tLayerSize.width;
+    unsigned int uHeight = (unsigned int)layerInfo->m_tLayerSize.height;
+    unsigned int uColumns = (uWidth + uPageSize - 1) / uPageSize;
+    unsigned int uRows = (uHeight + uPageSize - 1) / uPageSize;
+
+    bool bRet = CCTMXPageFile::writeHeader(fp, tilesetInfo, layerInfo, mapInfo, uPageSize);
+    long lSlotsOffset = ftell(fp);
+
+    // the slots are written once the pages are known
+    std::vector<unsigned int> slots(uColumns * uRows, 0);
+    bRet = bRet && (slots.empty() || fwrite(&slots[0], sizeof(unsigned int), slots.size(), fp) == slots.size());
+
+    if (layerInfo->m_pTiles)
+    {
+        std::vector<unsigned int> page(uPageSize * uPageSize);
+        unsigned int uSlotCount = 0;
+        for (unsigned int uPage = 0; bRet && uPage < slots.size(); ++uPage)
+        {
+            unsigned int x0 = (uPage % uColumns) * uPageSize;
+            unsigned int y0 = (uPage / uColumns) * uPageSize;
+            unsigned int uPageWidth = MIN(uPageSize, uWidth - x0);
+            unsigned int uPageHeight = MIN(uPageSize, uHeight - y0);
+
+            bool bEmpty = true;
+            std::fill(page.begin(), page.end(), 0);
+            for (unsigned int y = 0; y < uPageHeight; ++y)
+            {
+                const unsigned int *pRow = layerInfo->m_pTiles + (y0 + y) * uWidth + x0;
+                for (unsigned int x = 0; x < uPageWidth; ++x)
+                {
+                    page[x + y * uPageSize] = pRow[x];
+                    bEmpty = bEmpty && pRow[x] == 0;
+                }
+            }
+
+            if (! bEmpty)
+            {
+                slots[uPage] = ++uSlotCount;
+                bRet = fwrite(&page[0], sizeof(unsigned int), page.size(), fp) == page.size();
+            }
+        }
+
+        bRet = bRet && fseek(fp, lSlotsOffset, SEEK_SET) == 0
+            && fwrite(&slots[0], sizeof(unsigned int), slots.size(), fp) == slots.size();
+    }
+
+    fclose(fp);
+
+    if (! bRet)
+    {
+        CCLOG("cocos2d: CCTMXPagedLayer: can't write the page file %s", pszPageFile);
+        remove(pszPageFile);
+    }
+    return bRet;
+}
+
+bool CCTMXPagedLayer::createPageFile(const char *pszPageFile, const char *tmxFile, const char *layerName, unsigned int uPageSize)
+{
+    CCTMXMapInfo *mapInfo = CCTMXMapInfo::formatWithTMXFile(tmxFile);
+    if (! mapInfo)
+    {
+        return false;
+    }
+
+    CCTMXLayerInfo *layerInfo = NULL;
+    CCObject *pObject = NULL;
+    CCARRAY_FOREACH(mapInfo->getLayers(), pObject)
+    {
+        CCTMXLayerInfo *pInfo = (CCTMXLayerInfo*)pObject;
+        if (pInfo->m_sName == layerName)
+        {
+            layerInfo = pInfo;
+            break;
+        }
+    }
+
+    if (! layerInfo || ! layerInfo->m_pTiles)
+    {
+        CCLOG("cocos2d: CCTMXPagedLayer: %s has no layer %s", tmxFile, layerName);
+        return false;
+    }
+
+    // like CCTMXTiledMap, the last tileset that the first tile belongs to
+    unsigned int uTileCount = (unsigned int)(layerInfo->m_tLayerSize.width * layerInfo->m_tLayerSize.height);
+    unsigned int gid = 0;
+    for (unsigned int i = 0; i < uTileCount && gid == 0; ++i)
+    {
+        gid = layerInfo->m_pTiles[i] & kCCFlippedMask;
+    }
+
+    CCTMXTilesetInfo *tilesetInfo = NULL;
+    CCARRAY_FOREACH_REVERSE(mapInfo->getTilesets(), pObject)
+    {
+        CCTMXTilesetInfo *pInfo = (CCTMXTilesetInfo*)pObject;
+        if (gid >= pInfo->m_uFirstGid)
+        {
+            tilesetInfo = pInfo;
+            break;
+        }
+    }
+
+    if (! tilesetInfo)
+    {
+        CCLOG("cocos2d: CCTMXPagedLayer: the layer %s of %s has no tileset", layerName, tmxFile);
+        return false;
+    }
+
+    return createPageFile(pszPageFile, tilesetInfo, layerInfo, mapInfo, uPageSize);
+}
+
+// CCTMXPagedLayer - init & alloc & dealloc
+
+CCTMXPagedLayer* CCTMXPagedLayer::create(const char *pszPageFile)
+{
+    CCTMXPagedLayer *pRet = new CCTMXPagedLayer();
+    if (pRet->initWithPageFile(pszPageFile))
+    {
+        pRet->autorelease();
+        return pRet;
+    }
+    CC_SAFE_DELETE(pRet);
+    return NULL;
+}
+
+CCTMXPagedLayer::CCTMXPagedLayer()
+: m_pPageFile(NULL)
+, m_uPageSize(0)
+, m_uPageColumns(0)
+, m_uPageRows(0)
+, m_uMaxResidentPages(CC_TMX_PAGED_LAYER_MAX_PAGES)
+, m_uLoadedPageCount(0)
+, m_uSyncLoadedPageCount(0)
+, m_uEvictedPageCount(0)
+, m_uWrittenPageCount(0)
+{
+}
+
+CCTMXPagedLayer::~CCTMXPagedLayer()
+{
+    if (m_pPageFile && ! m_pPageFile->isReadOnly())
+    {
+        flush();
+    }
+
+    for (std::map<unsigned int, Page>::iterator it = m_tPages.begin(); it != m_tPages.end(); ++it)
+    {
+        CC_SAFE_RELEASE(it->second.pAtlas);
+        CC_SAFE_DELETE_ARRAY(it->second.pTiles);
+    }
+
+    // waits for the background thread
+    CC_SAFE_DELETE(m_pPageFile);
+}
+
+bool CCTMXPagedLayer::initWithPageFile(const char *pszPageFile)
+{
+    bool bRet = false;
+    CCTMXPageFile *pPageFile = new CCTMXPageFile();
+    do
+    {
+        CCTMXTilesetInfo *tilesetInfo = new CCTMXTilesetInfo();
+        tilesetInfo->autorelease();
+        CCTMXLayerInfo *layerInfo = new CCTMXLayerInfo();
+        layerInfo->autorelease();
+        CCTMXMapInfo *mapInfo = new CCTMXMapInfo();
+        mapInfo->autorelease();
+
+        std::string fullPath = CCFileUtils::sharedFileUtils()->fullPathForFilename(pszPageFile);
+        CC_BREAK_IF(! pPageFile->open(fullPath.c_str(), tilesetInfo, layerInfo, mapInfo));
+        CC_BREAK_IF(! initWithTilesetInfo(tilesetInfo, layerInfo, mapInfo));
+        CC_BREAK_IF(! m_pobTextureAtlas->getTexture());
+
+        m_pPageFile = pPageFile;
+        m_uPageSize = pPageFile->getPageSize();
+        m_uPageColumns = pPageFile->getPageColumns();
+        m_uPageRows = pPageFile->getPageRows();
+
+        // like setupTiles()
+        m_pTileSet->m_tImageSize = m_pobTextureAtlas->getTexture()->getContentSizeInPixels();
+        m_pobTextureAtlas->getTexture()->setAliasTexParameters();
+        parseInternalProperties();
+
+        // tiles can be larger than the map tiles, and rotated tiles are moved by half their size
+        float fMargin = MAX(MAX(m_tMapTileSize.width, m_tMapTileSize.height), MAX(m_pTileSet->m_tTileSize.width, m_pTileSet->m_tTileSize.height));
+        fMargin /= CC_CONTENT_SCALE_FACTOR();
+
+        m_tPageBounds.resize(m_uPageColumns * m_uPageRows);
+        for (unsigned int row = 0; row < m_uPageRows; ++row)
+        {
+            for (unsigned int column = 0; column < m_uPageColumns; ++column)
+            {
+                float x0 = (float)(column * m_uPageSize);
+                float y0 = (float)(row * m_uPageSize);
+                float x1 = MIN(x0 + m_uPageSize, m_tLayerSize.width) - 1;
+                float y1 = MIN(y0 + m_uPageSize, m_tLayerSize.height) - 1;
+
+                // the tiles of the corners are the furthest ones in every orientation
+                CCPoint corners[4] = { positionAt(ccp(x0, y0)), positionAt(ccp(x1, y0)), positionAt(ccp(x0, y1)), positionAt(ccp(x1, y1)) };
+                float minX = corners[0].x, maxX = corners[0].x, minY = corners[0].y, maxY = corners[0].y;
+                for (int i = 1; i < 4; ++i)
+                {
+                    minX = MIN(minX, corners[i].x);
+                    maxX = MAX(maxX, corners[i].x);
+                    minY = MIN(minY, corners[i].y);
+                    maxY = MAX(maxY, corners[i].y);
+                }
+
+                m_tPageBounds[column + row * m_uPageColumns] = CCRectMake(minX - fMargin, minY - fMargin,
+                    maxX - minX + 2 * fMargin, maxY - minY + 2 * fMargin);
+            }
+        }
+
+        bRet = true;
+    } while (0);
+
+    if (! bRet)
+    {
+        CC_SAFE_DELETE(pPageFile);
+        m_pPageFile = NULL;
+    }
+    return bRet;
+}
+
+void CCTMXPagedLayer::setMaxResidentPages(unsigned int uMaxResidentPages)
+{
+    m_uMaxResidentPages = MAX(uMaxResidentPages, 1);
+    evictPages();
+}
+
+unsigned int CCTMXPagedLayer::getResidentBytes()
+{
+    unsigned int uBytes = 0;
+    for (std::map<unsigned int, Page>::iterator it = m_tPages.begin(); it != m_tPages.end(); ++it)
+    {
+        if (it->second.pTiles)
+        {
+            uBytes += m_uPageSize * m_uPageSize * sizeof(unsigned int);
+        }
+    }
+    return uBytes;
+}
+
+// CCTMXPagedLayer - tiles
+
+CCSprite* CCTMXPagedLayer::tileAt(const CCPoint& pos)
+{
+    CC_UNUSED_PARAM(pos);
+    CCLOG("cocos2d: CCTMXPagedLayer: the tiles of %s can't be turned into sprites", m_sLayerName.c_str());
+    return NULL;
+}
+
+unsigned int CCTMXPagedLayer::tileGIDAt(const CCPoint& pos)
+{
+    return tileGIDAt(pos, NULL);
+}
+
+unsigned int CCTMXPagedLayer::tileGIDAt(const CCPoint& pos, ccTMXTileFlags* flags)
+{
+    CCAssert(pos.x < m_tLayerSize.width && pos.y < m_tLayerSize.height && pos.x >=0 && pos.y >=0, "TMXLayer: invalid position");
+
+    unsigned int uIndex = 0;
+    Page& page = pageAt(pos, uIndex);
+    unsigned int tile = page.pTiles ? page.pTiles[uIndex] : 0;
+
+    if (flags)
+    {
+        *flags = (ccTMXTileFlags)(tile & kCCFlipedAll);
+    }
+    return (tile & kCCFlippedMask);
+}
+
+void CCTMXPagedLayer::setTileGID(unsigned int gid, const CCPoint& pos)
+{
+    setTileGID(gid, pos, (ccTMXTileFlags)0);
+}
+
+void CCTMXPagedLayer::setTileGID(unsigned int gid, const CCPoint& pos, ccTMXTileFlags flags)
+{
+    CCAssert(pos.x < m_tLayerSize.width && pos.y < m_tLayerSize.height && pos.x >=0 && pos.y >=0, "TMXLayer: invalid position");
+    CCAssert(gid == 0 || gid >= m_pTileSet->m_uFirstGid, "TMXLayer: invalid gid" );
+
+    unsigned int gidAndFlags = gid ? gid | flags : 0;
+    unsigned int uIndex = 0;
+    Page& page = pageAt(pos, uIndex);
+    if ((page.pTiles ? page.pTiles[uIndex] : 0) == gidAndFlags)
+    {
+        return;
+    }
+
+    if (! page.pTiles)
+    {
+        page.pTiles = new unsigned int[m_uPageSize * m_uPageSize];
+        memset(page.pTiles, 0, m_uPageSize * m_uPageSize * sizeof(unsigned int));
+    }
+    page.pTiles[uIndex] = gidAndFlags;
+    page.bModified = true;
+    page.bDirty = true;
+}
+
+void CCTMXPagedLayer::removeTileAt(const CCPoint& pos)
+{
+    setTileGID(0, pos);
+}
+
+unsigned int CCTMXPagedLayer::rawTileAt(unsigned int x, unsigned int y)
+{
+    unsigned int uIndex = 0;
+    Page& page = pageAt(ccp(x, y), uIndex);
+    return page.pTiles ? page.pTiles[uIndex] : 0;
+}
+
+// sets the tiles page by page, each page being read once
+void CCTMXPagedLayer::setTilesInRect(const CCRect& rect, const unsigned int *gids, unsigned int gidAndFlags)
+{
+    CCAssert(rect.origin.x >= 0 && rect.origin.y >= 0 && rect.getMaxX() <= m_tLayerSize.width && rect.getMaxY() <= m_tLayerSize.height,
+        "TMXLayer: invalid rect");
+
+    unsigned int x0 = (unsigned int)rect.origin.x;
+    unsigned int y0 = (unsigned int)rect.origin.y;
+    unsigned int x1 = x0 + (unsigned int)rect.size.width;
+    unsigned int y1 = y0 + (unsigned int)rect.size.height;
+    unsigned int uWidth = x1 - x0;
+
+    for (unsigned int py = y0 / m_uPageSize; py * m_uPageSize < y1; ++py)
+    {
+        for (unsigned int px = x0 / m_uPageSize; px * m_uPageSize < x1; ++px)
+        {
+            Page& page = residentPage(px + py * m_uPageColumns);
+            unsigned int tx0 = MAX(x0, px * m_uPageSize);
+            unsigned int ty0 = MAX(y0, py * m_uPageSize);
+            unsigned int tx1 = MIN(x1, (px + 1) * m_uPageSize);
+            unsigned int ty1 = MIN(y1, (py + 1) * m_uPageSize);
+
+            for (unsigned int y = ty0; y < ty1; ++y)
+            {
+                for (unsigned int x = tx0; x < tx1; ++x)
+                {
+                    unsigned int tile = gids ? gids[(x - x0) + (y - y0) * uWidth] : gidAndFlags;
+                    CCAssert((tile & kCCFlippedMask) == 0 || (tile & kCCFlippedMask) >= m_pTileSet->m_uFirstGid, "TMXLayer: invalid gid");
+                    unsigned int uIndex = (x - px * m_uPageSize) + (y - py * m_uPageSize) * m_uPageSize;
+                    if ((page.pTiles ? page.pTiles[uIndex] : 0) == tile)
+                    {
+                        continue;
+                    }
+
+                    if (! page.pTiles)
+                    {
+                        page.pTiles = new unsigned int[m_uPageSize * m_uPageSize];
+                        memset(page.pTiles, 0, m_uPageSize * m_uPageSize * sizeof(unsigned int));
+                    }
+                    page.pTiles[uIndex] = tile;
+                    page.bModified = true;
+                    page.bDirty = true;
+                }
+            }
+        }
+    }
+}
+
+unsigned int CCTMXPagedLayer::tilesWithGIDs(const CCRect& rect, const std::set<unsigned int>& gids, std::vector<CCPoint>& tileCoordinates)
+{
+    if (gids.empty())
+    {
+        return 0;
+    }
+
+    int x0 = MAX((int)floorf(rect.getMinX()), 0);
+    int y0 = MAX((int)floorf(rect.getMinY()), 0);
+    int x1 = MIN((int)ceilf(rect.getMaxX()), (int)m_tLayerSize.width);
+    int y1 = MIN((int)ceilf(rect.getMaxY()), (int)m_tLayerSize.height);
+    if (x0 >= x1 || y0 >= y1)
+    {
+        return 0;
+    }
+
+    // row by row like CCTMXLayer, each row crossing the pages in memory
+    GIDMatcher matcher(gids);
+    bool bEmptyMatches = matcher.matches(0);
+    unsigned int uCount = 0;
+    for (int y = y0; y < y1; ++y)
+    {
+        for (int x = x0; x < x1; )
+        {
+            unsigned int uIndex = 0;
+            Page& page = pageAt(ccp(x, y), uIndex);
+            int xEnd = MIN(x1, (int)((x / m_uPageSize + 1) * m_uPageSize));
+            if (! page.pTiles)
+            {
+                // the tiles of an empty page are 0
+                for (; x < xEnd; ++x)
+                {
+                    if (bEmptyMatches)
+                    {
+                        tileCoordinates.push_back(ccp(x, y));
+                        ++uCount;
+                    }
+                }
+                continue;
+            }
+
+            for (const unsigned int *pTile = page.pTiles + uIndex; x < xEnd; ++x, ++pTile)
+            {
+                if (matcher.matches(*pTile & kCCFlippedMask))
+                {
+                    tileCoordinates.push_back(ccp(x, y));
+                    ++uCount;
+                }
+            }
+        }
+    }
+    return uCount;
+}
+
+void CCTMXPagedLayer::preloadRect(const CCRect& rect)
+{
+    int x0 = MAX((int)rect.getMinX(), 0) / (int)m_uPageSize;
+    int y0 = MAX((int)rect.getMinY(), 0) / (int)m_uPageSize;
+    int x1 = MIN((int)ceilf(rect.getMaxX()), (int)m_tLayerSize.width) - 1;
+    int y1 = MIN((int)ceilf(rect.getMaxY()), (int)m_tLayerSize.height) - 1;
+
+    for (int row = y0; row <= y1 / (int)m_uPageSize && y1 >= 0; ++row)
+    {
+        for (int column = x0; column <= x1 / (int)m_uPageSize && x1 >= 0; ++column)
+        {
+            requestPage(column + row * m_uPageColumns);
+        }
+    }
+}
+
+void CCTMXPagedLayer::flush()
+{
+    if (m_pPageFile->isReadOnly())
+    {
+        CCLOG("cocos2d: CCTMXPagedLayer: the page file of %s is read only", m_sLayerName.c_str());
+        return;
+    }
+
+    for (std::map<unsigned int, Page>::iterator it = m_tPages.begin(); it != m_tPages.end(); ++it)
+    {
+        if (it->second.bModified)
+        {
+            m_pPageFile->writePageNow(it->first, it->second.pTiles);
+            it->second.bModified = false;
+            ++m_uWrittenPageCount;
+        }
+    }
+    m_pPageFile->flush();
+}
+
+// CCTMXPagedLayer - pages
+
+CCTMXPagedLayer::Page& CCTMXPagedLayer::pageAt(const CCPoint& pos, unsigned int& uIndex)
+{
+    unsigned int x = (unsigned int)pos.x;
+    unsigned int y = (unsigned int)pos.y;
+    uIndex = (x % m_uPageSize) + (y % m_uPageSize) * m_uPageSize;
+    return residentPage(x / m_uPageSize + (y / m_uPageSize) * m_uPageColumns);
+}
+
+CCTMXPagedLayer::Page& CCTMXPagedLayer::residentPage(unsigned int uPage)
+{
+    std::map<unsigned int, Page>::iterator it = m_tPages.find(uPage);
+    if (it != m_tPages.end())
+    {
+        m_tLRU.splice(m_tLRU.begin(), m_tLRU, it->second.tLRU);
+        return it->second;
+    }
+
+    // a page being read in the background is read again, the first one read is kept
+    m_tRequestedPages.erase(uPage);
+
+    bool bModified = false;
+    unsigned int *pTiles = m_pPageFile->readPage(uPage, bModified);
+    if (! bModified)
+    {
+        ++m_uLoadedPageCount;
+        ++m_uSyncLoadedPageCount;
+    }
+
+    Page& page = addPage(uPage, pTiles, bModified);
+    evictPages();
+    return page;
+}
+
+CCTMXPagedLayer::Page& CCTMXPagedLayer::addPage(unsigned int uPage, unsigned int *pTiles, bool bModified)
+{
+    Page& page = m_tPages[uPage];
+    page.pTiles = pTiles;
+    page.pAtlas = NULL;
+    page.bDirty = true;
+    page.bModified = bModified;
+    page.uLastVisibleFrame = UINT_MAX;
+    m_tLRU.push_front(uPage);
+    page.tLRU = m_tLRU.begin();
+    return page;
+}
+
+void CCTMXPagedLayer::requestPage(unsigned int uPage)
+{
+    if (m_tPages.find(uPage) != m_tPages.end() || m_tRequestedPages.find(uPage) != m_tRequestedPages.end())
+    {
+        return;
+    }
+
+    unsigned int *pTiles = NULL;
+    unsigned int uRequestId = m_pPageFile->requestPage(uPage, &pTiles);
+    if (uRequestId)
+    {
+        m_tRequestedPages[uPage] = uRequestId;
+    }
+    else
+    {
+        // the page was waiting to be written
+        addPage(uPage, pTiles, true);
+        evictPages();
+    }
+}
+
+void CCTMXPagedLayer::adoptLoadedPages()
+{
+    unsigned int uPage = 0;
+    unsigned int uRequestId = 0;
+    unsigned int *pTiles = NULL;
+    while (m_pPageFile->popLoadedPage(uPage, uRequestId, pTiles))
+    {
+        // pages read again since the request are newer
+        std::map<unsigned int, unsigned int>::iterator it = m_tRequestedPages.find(uPage);
+        if (it == m_tRequestedPages.end() || it->second != uRequestId)
+        {
+            CC_SAFE_DELETE_ARRAY(pTiles);
+            continue;
+        }
+
+        m_tRequestedPages.erase(it);
+        addPage(uPage, pTiles, false);
+        ++m_uLoadedPageCount;
+    }
+
+    evictPages();
+}
+
+void CCTMXPagedLayer::evictPages()
+{
+    unsigned int uFrame = CCDirector::sharedDirector()->getTotalFrames();
+    bool bReadOnly = m_pPageFile->isReadOnly();
+
+    // the least recently used first, the pages drawn by this frame and the last used one are kept
+    std::list<unsigned int>::iterator it = m_tLRU.end();
+    while (m_tPages.size() > m_uMaxResidentPages && it != m_tLRU.begin())
+    {
+        --it;
+        if (it == m_tLRU.begin())
+        {
+            break;
+        }
+
+        Page& page = m_tPages[*it];
+        if (page.uLastVisibleFrame == uFrame || (bReadOnly && page.bModified))
+        {
+            continue;
+        }
+
+        releaseAtlas(page);
+        if (page.bModified)
+        {
+            m_pPageFile->writePage(*it, page.pTiles);
+            ++m_uWrittenPageCount;
+        }
+        else
+        {
+            CC_SAFE_DELETE_ARRAY(page.pTiles);
+        }
+
+        m_tPages.erase(*it);
+        it = m_tLRU.erase(it);
+        ++m_uEvictedPageCount;
+    }
+}
+
+void CCTMXPagedLayer::buildPage(unsigned int uPage, Page& page)
+{
+    page.bDirty = false;
+
+    unsigned int uTileCount = m_uPageSize * m_uPageSize;
+    unsigned int uQuads = 0;
+    for (unsigned int i = 0; page.pTiles && i < uTileCount; ++i)
+    {
+        if (page.pTiles[i])
+        {
+            ++uQuads;
+        }
+    }
+
+    if (uQuads == 0)
+    {
+        releaseAtlas(page);
+        page.bDirty = false;
+        return;
+    }
+
+    if (! page.pAtlas)
+    {
+        page.pAtlas = new CCTextureAtlas();
+        page.pAtlas->initWithTexture(m_pobTextureAtlas->getTexture(), uQuads);
+        ++m_uBuiltChunkCount;
+    }
+    else
+    {
+        page.pAtlas->removeAllQuads();
+        if (page.pAtlas->getCapacity() < uQuads)
+        {
+            page.pAtlas->resizeCapacity(uQuads);
+        }
+    }
+
+    // the quads are written by the reused tile, like the chunks of CCTMXLayer
+    unsigned int x0 = (uPage % m_uPageColumns) * m_uPageSize;
+    unsigned int y0 = (uPage / m_uPageColumns) * m_uPageSize;
+    unsigned int uIndex = 0;
+    for (unsigned int i = 0; i < uTileCount; ++i)
+    {
+        unsigned int gid = page.pTiles[i];
+        if (! gid)
+        {
+            continue;
+        }
+
+        CCRect rect = m_pTileSet->rectForGID(gid);
+        rect = CC_RECT_PIXELS_TO_POINTS(rect);
+
+        CCSprite *tile = reusedTileWithRect(rect);
+        setupTileSprite(tile, ccp(x0 + i % m_uPageSize, y0 + i / m_uPageSize), gid);
+        tile->setTextureAtlas(page.pAtlas);
+        tile->setAtlasIndex(uIndex++);
+        tile->setDirty(true);
+        tile->updateTransform();
+    }
+}
+
+void CCTMXPagedLayer::releaseAtlas(Page& page)
+{
+    if (page.pAtlas)
+    {
+        CC_SAFE_RELEASE_NULL(page.pAtlas);
+        --m_uBuiltChunkCount;
+    }
+    page.bDirty = true;
+}
+
+void CCTMXPagedLayer::draw(void)
+{
+    CC_PROFILER_START("CCTMXPagedLayer - draw");
+
+    adoptLoadedPages();
+
+    CC_NODE_DRAW_SETUP();
+
+    ccGLBlendFunc( m_blendFunc.src, m_blendFunc.dst );
+
+    unsigned int uFrame = CCDirector::sharedDirector()->getTotalFrames();
+    m_uDrawnChunkCount = 0;
+
+    CCRect visible;
+    if (visibleRect(visible))
+    {
+        // the pages a page away from the view are read in the background
+        float fMargin = m_uPageSize * MAX(m_tMapTileSize.width, m_tMapTileSize.height) / CC_CONTENT_SCALE_FACTOR();
+        CCRect preload = CCRectMake(visible.origin.x - fMargin, visible.origin.y - fMargin,
+            visible.size.width + 2 * fMargin, visible.size.height + 2 * fMargin);
+
+        for (unsigned int i = 0; i < m_tPageBounds.size(); ++i)
+        {
+            if (! m_tPageBounds[i].intersectsRect(preload))
+            {
+                continue;
+            }
+
+            if (! m_tPageBounds[i].intersectsRect(visible))
+            {
+                requestPage(i);
+                continue;
+            }
+
+            Page& page = residentPage(i);
+            page.uLastVisibleFrame = uFrame;
+            if (page.bDirty)
+            {
+                buildPage(i, page);
+            }
+
+            if (page.pAtlas && page.pAtlas->getTotalQuads() > 0)
+            {
+                page.pAtlas->drawQuads();
+                ++m_uDrawnChunkCount;
+            }
+        }
+    }
+    else
+    {
+        // like CCTMXLayer, everything is drawn when the visible area can't be known: the pages in memory
+        for (std::map<unsigned int, Page>::iterator it = m_tPages.begin(); it != m_tPages.end(); ++it)
+        {
+            Page& page = it->second;
+            page.uLastVisibleFrame = uFrame;
+            if (page.bDirty)
+            {
+                buildPage(it->first, page);
+            }
+
+            if (page.pAtlas && page.pAtlas->getTotalQuads() > 0)
+            {
+                page.pAtlas->drawQuads();
+                ++m_uDrawnChunkCount;
+            }
+        }
+    }
+
+    // the quads are kept a while in case the page comes back into view
+    for (std::map<unsigned int, Page>::iterator it = m_tPages.begin(); it != m_tPages.end(); ++it)
+    {
+        if (it->second.pAtlas && uFrame - it->second.uLastVisibleFrame > CC_TMX_LAYER_CHUNK_RELEASE_FRAMES)
+        {
+            releaseAtlas(it->second);
+        }
+    }
+
+    evictPages();
+
+    CC_PROFILER_STOP("CCTMXPagedLayer - draw");
+}
+
+NS_CC_END
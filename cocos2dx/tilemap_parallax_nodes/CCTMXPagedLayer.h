@@ -0,0 +1,191 @@
+/****************************************************************************
+Copyright (c) 2013 cocos2d-x.org
+
+http://www.cocos2d-x.org
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+****************************************************************************/
+#ifndef __CCTMX_PAGED_LAYER_H__
+#define __CCTMX_PAGED_LAYER_H__
+
+#include "CCTMXLayer.h"
+#include <map>
+#include <list>
+
+NS_CC_BEGIN
+
+class CCTMXPageFile;
+
+/**
+ * @addtogroup tilemap_parallax_nodes
+ * @{
+ */
+
+/** Default width and height of the pages of a page file, in tiles */
+#define CC_TMX_PAGED_LAYER_PAGE_SIZE            64
+
+/** Default number of pages a CCTMXPagedLayer keeps in memory */
+#define CC_TMX_PAGED_LAYER_MAX_PAGES            64
+
+/** @brief CCTMXPagedLayer is a CCTMXLayer whose tiles are read from a page file, for layers too large to be kept in memory.
+
+The page file stores the layer by square pages of tiles, the pages without tiles taking no space. Only the pages
+around the view and the last used ones are kept in memory: the pages coming into view are read by a background thread
+a page ahead, and the least recently used pages are released when there are more than getMaxResidentPages() of them.
+The pages changed by setTileGID() are written back to the page file when they are released or by flush().
+
+A page file is created from a layer of a TMX file or from a layer info with createPageFile(). The tiles are stored in the
+byte order of the device, the file must be a regular file, like in CCFileUtils::getWritablePath(), to be edited.
+
+The tile methods of CCTMXLayer read and write the pages, reading the ones that are not in memory, so the layer
+can be used through a CCTMXLayer pointer, but the tiles can't be turned into sprites: tileAt() returns NULL.
+When the visible area can't be computed, like with the "cc_vertexz" "automatic" property, the pages in memory are drawn.
+getDrawnChunkCount() and getBuiltChunkCount() count pages.
+@since v2.1.4
+*/
+class CC_DLL CCTMXPagedLayer : public CCTMXLayer
+{
+public:
+    CCTMXPagedLayer();
+    virtual ~CCTMXPagedLayer();
+
+    /** creates a page file from a layer info. The layer info may have no tiles, for an empty layer.
+     @param tilesetInfo the tileset of the layer, it can't be NULL
+     @param uPageSize width and height of the pages, in tiles
+     */
+    static bool createPageFile(const char *pszPageFile, CCTMXTilesetInfo *tilesetInfo, CCTMXLayerInfo *layerInfo, CCTMXMapInfo *mapInfo,
+                               unsigned int uPageSize = CC_TMX_PAGED_LAYER_PAGE_SIZE);
+
+    /** creates a page file from a layer of a TMX file */
+    static bool createPageFile(const char *pszPageFile, const char *tmxFile, const char *layerName,
+                               unsigned int uPageSize = CC_TMX_PAGED_LAYER_PAGE_SIZE);
+
+    /** creates a CCTMXPagedLayer with a page file */
+    static CCTMXPagedLayer* create(const char *pszPageFile);
+
+    /** initializes a CCTMXPagedLayer with a page file */
+    bool initWithPageFile(const char *pszPageFile);
+
+    /** the tiles of a paged layer can't be turned into sprites, returns NULL */
+    virtual CCSprite* tileAt(const CCPoint& tileCoordinate);
+
+    /** returns the tile gid at a given tile coordinate, reading its page if it is not in memory */
+    virtual unsigned int tileGIDAt(const CCPoint& tileCoordinate);
+    virtual unsigned int tileGIDAt(const CCPoint& tileCoordinate, ccTMXTileFlags* flags);
+
+    /** sets the tile gid at a given tile coordinate, reading its page if it is not in memory */
+    virtual void setTileGID(unsigned int gid, const CCPoint& tileCoordinate);
+    virtual void setTileGID(unsigned int gid, const CCPoint& tileCoordinate, ccTMXTileFlags flags);
+
+    /** removes a tile at given tile coordinate */
+    virtual void removeTileAt(const CCPoint& tileCoordinate);
+
+    /** finds the tiles with some gids in a rectangle page by page, reading the pages that are not in memory */
+    virtual unsigned int tilesWithGIDs(const CCRect& rect, const std::set<unsigned int>& gids, std::vector<CCPoint>& tileCoordinates);
+
+    /** reads in the background the pages of a rectangle of tile coordinates that are not in memory */
+    void preloadRect(const CCRect& rect);
+
+    /** writes the changed pages to the page file */
+    void flush();
+
+    /** draws the pages in view, reading them if needed, and reads the pages around the view in the background */
+    virtual void draw(void);
+
+    /** number of pages kept in memory, the pages in view are kept even if there are more */
+    inline unsigned int getMaxResidentPages() { return m_uMaxResidentPages; }
+    void setMaxResidentPages(unsigned int uMaxResidentPages);
+
+    /** width and height of the pages, in tiles */
+    inline unsigned int getPageSize() { return m_uPageSize; }
+
+    /** number of pages in memory */
+    inline unsigned int getResidentPageCount() { return (unsigned int)m_tPages.size(); }
+
+    /** bytes of the tiles of the pages in memory, the empty pages have no tiles */
+    unsigned int getResidentBytes();
+
+    /** number of pages read from the page file, in the background or not */
+    inline unsigned int getLoadedPageCount() { return m_uLoadedPageCount; }
+
+    /** number of pages read from the page file without waiting for the background thread */
+    inline unsigned int getSyncLoadedPageCount() { return m_uSyncLoadedPageCount; }
+
+    /** number of pages released to keep getMaxResidentPages() pages */
+    inline unsigned int getEvictedPageCount() { return m_uEvictedPageCount; }
+
+    /** number of changed pages written back */
+    inline unsigned int getWrittenPageCount() { return m_uWrittenPageCount; }
+protected:
+    virtual void setTilesInRect(const CCRect& rect, const unsigned int *gids, unsigned int gidAndFlags);
+    virtual unsigned int rawTileAt(unsigned int x, unsigned int y);
+private:
+    typedef struct _Page
+    {
+        //! tiles of the page, row by row, NULL if the page is empty
+        unsigned int    *pTiles;
+        //! quads of the tiles, NULL if they are not built
+        CCTextureAtlas  *pAtlas;
+        //! the quads don't match the tiles any more
+        bool            bDirty;
+        //! the tiles have been changed since the page was read
+        bool            bModified;
+        //! last frame the page was drawn
+        unsigned int    uLastVisibleFrame;
+        //! position in m_tLRU
+        std::list<unsigned int>::iterator tLRU;
+    } Page;
+
+    Page& pageAt(const CCPoint& pos, unsigned int& uIndex);
+    Page& residentPage(unsigned int uPage);
+    Page& addPage(unsigned int uPage, unsigned int *pTiles, bool bModified);
+    void requestPage(unsigned int uPage);
+    void adoptLoadedPages();
+    void evictPages();
+    void buildPage(unsigned int uPage, Page& page);
+    void releaseAtlas(Page& page);
+
+    CCTMXPageFile                       *m_pPageFile;
+    unsigned int                        m_uPageSize;
+    unsigned int                        m_uPageColumns;
+    unsigned int                        m_uPageRows;
+    unsigned int                        m_uMaxResidentPages;
+
+    //! pages in memory, by index row by row
+    std::map<unsigned int, Page>        m_tPages;
+    //! pages in memory, the last used first
+    std::list<unsigned int>             m_tLRU;
+    //! pages asked to the background thread, with the id of the request
+    std::map<unsigned int, unsigned int> m_tRequestedPages;
+    //! area the tiles of each page can cover, in points
+    std::vector<CCRect>                 m_tPageBounds;
+
+    unsigned int                        m_uLoadedPageCount;
+    unsigned int                        m_uSyncLoadedPageCount;
+    unsigned int                        m_uEvictedPageCount;
+    unsigned int                        m_uWrittenPageCount;
+};
+
+// end of tilemap_parallax_nodes group
+/// @}
+
+NS_CC_END
+
+#endif //__CCTMX_PAGED_LAYER_H__
+
@@ -75,6 +75,32 @@ bool CCTMXTiledMap::initWithTMXFile(const char *tmxFile)
     return true;
 }
 
+CCTMXTiledMap* CCTMXTiledMap::createWithMapInfo(CCTMXMapInfo *mapInfo)
+{
+    CCTMXTiledMap *pRet = new CCTMXTiledMap();
+    if (pRet->initWithMapInfo(mapInfo))
+    {
+        pRet->autorelease();
+        return pRet;
+    }
+    CC_SAFE_DELETE(pRet);
+    return NULL;
+}
+
+bool CCTMXTiledMap::initWithMapInfo(CCTMXMapInfo *mapInfo)
+{
+    setContentSize(CCSizeZero);
+
+    if (! mapInfo)
+    {
+        return false;
+    }
+    CCAssert( mapInfo->getTilesets()->count() != 0, "TMXTiledMap: Map not found. Please check the filename.");
+    buildWithMapInfo(mapInfo);
+
+    return true;
+}
+
 bool CCTMXTiledMap::initWithXML(const char* tmxString, const char* resourcePath)
 {
     setContentSize(CCSizeZero);
@@ -134,6 +134,16 @@ public:
     /** initializes a TMX Tiled Map with a TMX formatted XML string and a path to TMX resources */
     bool initWithXML(const char* tmxString, const char* resourcePath);
 
+    /** creates a TMX Tiled Map with a parsed TMX file, e.g. from CCTMXMapInfo::formatWithTMXFileAsync()
+     @since v2.1.4
+     */
+    static CCTMXTiledMap* createWithMapInfo(CCTMXMapInfo *mapInfo);
+
+    /** initializes a TMX Tiled Map with a parsed TMX file
+     @since v2.1.4
+     */
+    bool initWithMapInfo(CCTMXMapInfo *mapInfo);
+
     /** return the TMXLayer for the specific layer */
     CCTMXLayer* layerNamed(const char *layerName);
 
@@ -31,10 +31,12 @@ THE SOFTWARE.
 #include "CCTMXTiledMap.h"
 #include "ccMacros.h"
 #include "platform/CCFileUtils.h"
-#include "support/zip_support/ZipUtils.h"
 #include "support/CCPointExtension.h"
-#include "support/base64.h"
 #include "platform/platform.h"
+#include "textures/CCTextureCache.h"
+#include <set>
+#include <stdio.h>
+#include <zlib.h>
 
 using namespace std;
 /*
@@ -64,6 +66,432 @@ static const char* valueForKey(const char *key, std::map<std::string, std::strin
     }
     return "";
 }
+
+// Decodes the text of a <data> element straight into the tiles of a layer as the parser delivers it.
+// Base64 is decoded in small blocks which are copied or inflated into the tiles, and csv values are
+// written as they are read, so the text, the decoded bytes and the inflated bytes are never kept whole.
+class CCTMXTileDataDecoder
+{
+public:
+    CCTMXTileDataDecoder(unsigned int *pTiles, unsigned int uTileCount, int nLayerAttribs)
+    : m_pTiles(pTiles)
+    , m_uTileCount(uTileCount)
+    , m_nLayerAttribs(nLayerAttribs)
+    , m_pOut((unsigned char*)pTiles)
+    , m_uOutLeft(uTileCount * sizeof(unsigned int))
+    , m_bInflating(false)
+    , m_bError(false)
+    , m_uBits(0)
+    , m_nBitCount(0)
+    , m_bBase64End(false)
+    , m_uValue(0)
+    , m_bDigits(false)
+    , m_uTileIndex(0)
+    {
+        memset(&m_tStream, 0, sizeof(m_tStream));
+        if (m_nLayerAttribs & (TMXLayerAttribGzip | TMXLayerAttribZlib))
+        {
+            // 15 + 32: zlib or gzip header, detected automatically
+            m_bInflating = (inflateInit2(&m_tStream, 15 + 32) == Z_OK);
+            m_bError = ! m_bInflating;
+        }
+    }
+
+    ~CCTMXTileDataDecoder()
+    {
+        if (m_bInflating)
+        {
+            inflateEnd(&m_tStream);
+        }
+    }
+
+    void decode(const char *pText, int nLength)
+    {
+        if (m_bError)
+        {
+            return;
+        }
+
+        if (m_nLayerAttribs & TMXLayerAttribCSV)
+        {
+            decodeCSV(pText, nLength);
+        }
+        else
+        {
+            decodeBase64(pText, nLength);
+        }
+    }
+
+    // returns whether every tile was decoded
+    bool finish()
+    {
+        if (m_nLayerAttribs & TMXLayerAttribCSV)
+        {
+            storeValue();
+            return ! m_bError && m_uTileIndex == m_uTileCount;
+        }
+        return ! m_bError && m_uOutLeft == 0;
+    }
+
+private:
+    void decodeBase64(const char *pText, int nLength)
+    {
+        static signed char s_table[256];
+        static bool s_bTableReady = false;
+        if (! s_bTableReady)
+        {
+            const char *pAlphabet = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+            memset(s_table, -1, sizeof(s_table));
+            for (int i = 0; i < 64; ++i)
+            {
+                s_table[(unsigned char)pAlphabet[i]] = (signed char)i;
+            }
+            s_bTableReady = true;
+        }
+
+        unsigned char block[4096];
+        unsigned int uBlockSize = 0;
+        int i = 0;
+        while (i < nLength && ! m_bBase64End)
+        {
+            if (uBlockSize > sizeof(block) - 3)
+            {
+                output(block, uBlockSize);
+                uBlockSize = 0;
+            }
+
+            // four characters of the alphabet make three bytes
+            if (m_nBitCount == 0 && i + 4 <= nLength)
+            {
+                int a = s_table[(unsigned char)pText[i]];
+                int b = s_table[(unsigned char)pText[i + 1]];
+                int c = s_table[(unsigned char)pText[i + 2]];
+                int d = s_table[(unsigned char)pText[i + 3]];
+                if ((a | b | c | d) >= 0)
+                {
+                    unsigned int uQuad = (a << 18) | (b << 12) | (c << 6) | d;
+                    block[uBlockSize++] = (unsigned char)(uQuad >> 16);
+                    block[uBlockSize++] = (unsigned char)(uQuad >> 8);
+                    block[uBlockSize++] = (unsigned char)uQuad;
+                    i += 4;
+                    continue;
+                }
+            }
+
+            unsigned char ch = (unsigned char)pText[i++];
+            if (ch == '=')
+            {
+                m_bBase64End = true;
+                break;
+            }
+            // skips white spaces like base64Decode does with any character out of the alphabet
+            int nValue = s_table[ch];
+            if (nValue < 0)
+            {
+                continue;
+            }
+
+            m_uBits = (m_uBits << 6) | (unsigned int)nValue;
+            m_nBitCount += 6;
+            if (m_nBitCount >= 8)
+            {
+                m_nBitCount -= 8;
+                block[uBlockSize++] = (unsigned char)(m_uBits >> m_nBitCount);
+            }
+        }
+        output(block, uBlockSize);
+    }
+
+    void output(unsigned char *pBytes, unsigned int uLength)
+    {
+        if (uLength == 0 || m_bError)
+        {
+            return;
+        }
+
+        if (! m_bInflating)
+        {
+            unsigned int uCopied = MIN(uLength, m_uOutLeft);
+            memcpy(m_pOut, pBytes, uCopied);
+            m_pOut += uCopied;
+            m_uOutLeft -= uCopied;
+            return;
+        }
+
+        m_tStream.next_in = pBytes;
+        m_tStream.avail_in = uLength;
+        while (m_tStream.avail_in > 0)
+        {
+            m_tStream.next_out = m_pOut;
+            m_tStream.avail_out = m_uOutLeft;
+            int err = inflate(&m_tStream, Z_NO_FLUSH);
+            m_pOut = m_tStream.next_out;
+            m_uOutLeft = m_tStream.avail_out;
+
+            if (err == Z_STREAM_END || err == Z_BUF_ERROR)
+            {
+                // done, or more data than the layer has tiles: the rest is ignored
+                break;
+            }
+            if (err != Z_OK)
+            {
+                CCLOG("cocos2d: TiledMap: inflate data error %d", err);
+                m_bError = true;
+                break;
+            }
+        }
+    }
+
+    void decodeCSV(const char *pText, int nLength)
+    {
+        for (int i = 0; i < nLength; ++i)
+        {
+            char c = pText[i];
+            if (c >= '0' && c <= '9')
+            {
+                m_uValue = m_uValue * 10 + (unsigned int)(c - '0');
+                m_bDigits = true;
+            }
+            else
+            {
+                storeValue();
+            }
+        }
+    }
+
+    void storeValue()
+    {
+        if (! m_bDigits)
+        {
+            return;
+        }
+        if (m_uTileIndex < m_uTileCount)
+        {
+            m_pTiles[m_uTileIndex++] = m_uValue;
+        }
+        m_uValue = 0;
+        m_bDigits = false;
+    }
+
+    unsigned int *m_pTiles;
+    unsigned int m_uTileCount;
+    int m_nLayerAttribs;
+
+    // base64: bytes of the tiles not written yet
+    unsigned char *m_pOut;
+    unsigned int m_uOutLeft;
+    z_stream m_tStream;
+    bool m_bInflating;
+    bool m_bError;
+    unsigned int m_uBits;
+    int m_nBitCount;
+    bool m_bBase64End;
+
+    // csv: value being read
+    unsigned int m_uValue;
+    bool m_bDigits;
+    unsigned int m_uTileIndex;
+};
+
+// Binary cache of the maps, see CCTMXMapInfo::setBinaryCacheEnabled(). The files are only read by the
+// device which wrote them, so values are stored in the native byte order.
+#define CC_TMX_CACHE_MAGIC          "CCTM"
+#define CC_TMX_CACHE_VERSION        1
+
+static bool s_bBinaryCacheEnabled = false;
+
+static std::string binaryCachePath(const std::string& tmxFullPath)
+{
+    char szName[32] = {0};
+    uLong uPathHash = crc32(0L, (const Bytef*)tmxFullPath.c_str(), (uInt)tmxFullPath.size());
+    sprintf(szName, "cc_tmx_%08x.bin", (unsigned int)uPathHash);
+    return CCFileUtils::sharedFileUtils()->getWritablePath() + szName;
+}
+
+class CCTMXCacheWriter
+{
+public:
+    void writeUInt(unsigned int uValue)
+    {
+        m_sData.append((const char*)&uValue, sizeof(uValue));
+    }
+
+    void writeFloat(float fValue)
+    {
+        m_sData.append((const char*)&fValue, sizeof(fValue));
+    }
+
+    void writeString(const std::string& sValue)
+    {
+        writeUInt((unsigned int)sValue.size());
+        m_sData.append(sValue);
+    }
+
+    void writeBytes(const void *pBytes, unsigned int uLength)
+    {
+        m_sData.append((const char*)pBytes, uLength);
+    }
+
+    // properties and objects only hold strings, string dictionaries and arrays
+    void writeObject(CCObject *pObject)
+    {
+        if (CCString *pString = dynamic_cast<CCString*>(pObject))
+        {
+            writeUInt('S');
+            writeString(pString->getCString());
+        }
+        else if (CCDictionary *pDict = dynamic_cast<CCDictionary*>(pObject))
+        {
+            writeUInt('D');
+            writeUInt(pDict->count());
+            CCDictElement *pElement = NULL;
+            CCDICT_FOREACH(pDict, pElement)
+            {
+                writeString(pElement->getStrKey());
+                writeObject(pElement->getObject());
+            }
+        }
+        else if (CCArray *pArray = dynamic_cast<CCArray*>(pObject))
+        {
+            writeUInt('A');
+            writeUInt(pArray->count());
+            CCObject *pChild = NULL;
+            CCARRAY_FOREACH(pArray, pChild)
+            {
+                writeObject(pChild);
+            }
+        }
+        else
+        {
+            writeUInt('N');
+        }
+    }
+
+    const std::string& getData() { return m_sData; }
+
+private:
+    std::string m_sData;
+};
+
+class CCTMXCacheReader
+{
+public:
+    CCTMXCacheReader(const unsigned char *pData, unsigned long uSize)
+    : m_pData(pData)
+    , m_pEnd(pData + uSize)
+    , m_bValid(pData != NULL)
+    {
+    }
+
+    unsigned int readUInt()
+    {
+        unsigned int uValue = 0;
+        readBytes(&uValue, sizeof(uValue));
+        return uValue;
+    }
+
+    float readFloat()
+    {
+        float fValue = 0;
+        readBytes(&fValue, sizeof(fValue));
+        return fValue;
+    }
+
+    std::string readString()
+    {
+        unsigned int uLength = readUInt();
+        if (! m_bValid || (unsigned long)(m_pEnd - m_pData) < uLength)
+        {
+            m_bValid = false;
+            return "";
+        }
+        std::string sValue((const char*)m_pData, uLength);
+        m_pData += uLength;
+        return sValue;
+    }
+
+    void readBytes(void *pBytes, unsigned int uLength)
+    {
+        if (! m_bValid || (unsigned long)(m_pEnd - m_pData) < uLength)
+        {
+            m_bValid = false;
+            return;
+        }
+        memcpy(pBytes, m_pData, uLength);
+        m_pData += uLength;
+    }
+
+    // @return a new object, which the caller releases, or NULL
+    CCObject* readObject()
+    {
+        unsigned int uType = readUInt();
+        if (uType == 'S')
+        {
+            return new CCString(readString());
+        }
+        else if (uType == 'D')
+        {
+            CCDictionary *pDict = new CCDictionary();
+            readElements(pDict);
+            return pDict;
+        }
+        else if (uType == 'A')
+        {
+            unsigned int uCount = readUInt();
+            CCArray *pArray = new CCArray();
+            pArray->initWithCapacity(MIN(uCount, 256));
+            for (unsigned int i = 0; i < uCount && m_bValid; ++i)
+            {
+                CCObject *pChild = readObject();
+                if (pChild)
+                {
+                    pArray->addObject(pChild);
+                    pChild->release();
+                }
+            }
+            return pArray;
+        }
+        else if (uType != 'N')
+        {
+            m_bValid = false;
+        }
+        return NULL;
+    }
+
+    // reads a string dictionary written by writeObject() into pDict
+    void readDictionary(CCDictionary *pDict)
+    {
+        if (readUInt() != 'D')
+        {
+            m_bValid = false;
+            return;
+        }
+        readElements(pDict);
+    }
+
+    bool isValid() { return m_bValid; }
+
+private:
+    void readElements(CCDictionary *pDict)
+    {
+        unsigned int uCount = readUInt();
+        for (unsigned int i = 0; i < uCount && m_bValid; ++i)
+        {
+            std::string sKey = readString();
+            CCObject *pObject = readObject();
+            if (pObject)
+            {
+                pDict->setObject(pObject, sKey);
+                pObject->release();
+            }
+        }
+    }
+
+    const unsigned char *m_pData;
+    const unsigned char *m_pEnd;
+    bool m_bValid;
+};
+
 // implementation CCTMXLayerInfo
 CCTMXLayerInfo::CCTMXLayerInfo()
 : m_sName("")
@@ -149,6 +577,104 @@ CCTMXMapInfo * CCTMXMapInfo::formatWithXML(const char* tmxString, const char* re
     return NULL;
 }
 
+// Parses the tmx file read by CCFileUtils, then waits for the tileset images
+class CCTMXMapInfoAsyncLoader : public CCObject
+{
+public:
+    CCTMXMapInfoAsyncLoader(const char *tmxFile, CCObject *target, SEL_CallFuncO selector)
+    : m_sTMXFile(tmxFile)
+    , m_pTarget(target)
+    , m_pSelector(selector)
+    , m_pMapInfo(NULL)
+    , m_nPendingTextures(0)
+    {
+        CC_SAFE_RETAIN(m_pTarget);
+    }
+
+    virtual ~CCTMXMapInfoAsyncLoader()
+    {
+        CC_SAFE_RELEASE(m_pMapInfo);
+        CC_SAFE_RELEASE(m_pTarget);
+    }
+
+    void fileDataLoaded(CCObject *pObject)
+    {
+        CCAsyncFileData *pData = (CCAsyncFileData*)pObject;
+        if (pData->getBuffer())
+        {
+            m_pMapInfo = new CCTMXMapInfo();
+            if (! m_pMapInfo->initWithTMXFile(m_sTMXFile.c_str(), (const char*)pData->getBuffer(), pData->getSize()))
+            {
+                CC_SAFE_RELEASE_NULL(m_pMapInfo);
+            }
+        }
+
+        if (! m_pMapInfo)
+        {
+            done();
+            return;
+        }
+
+        std::set<std::string> images;
+        CCObject *pObj = NULL;
+        CCARRAY_FOREACH(m_pMapInfo->getTilesets(), pObj)
+        {
+            CCTMXTilesetInfo *pTileset = (CCTMXTilesetInfo*)pObj;
+            if (! pTileset->m_sSourceImage.empty())
+            {
+                images.insert(pTileset->m_sSourceImage);
+            }
+        }
+
+        m_nPendingTextures = images.size() + 1;
+        for (std::set<std::string>::iterator iter = images.begin(); iter != images.end(); ++iter)
+        {
+            CCTextureCache::sharedTextureCache()->addImageAsync(iter->c_str(), this,
+                callfuncO_selector(CCTMXMapInfoAsyncLoader::textureLoaded));
+        }
+        // addImageAsync calls back right away for cached textures
+        textureLoaded(NULL);
+    }
+
+    void textureLoaded(CCObject *pTexture)
+    {
+        if (--m_nPendingTextures == 0)
+        {
+            done();
+        }
+    }
+
+private:
+    void done()
+    {
+        if (m_pMapInfo)
+        {
+            m_pMapInfo->autorelease();
+        }
+
+        if (m_pTarget && m_pSelector)
+        {
+            (m_pTarget->*m_pSelector)(m_pMapInfo);
+        }
+        m_pMapInfo = NULL;
+    }
+
+    std::string m_sTMXFile;
+    CCObject *m_pTarget;
+    SEL_CallFuncO m_pSelector;
+    CCTMXMapInfo *m_pMapInfo;
+    int m_nPendingTextures;
+};
+
+unsigned int CCTMXMapInfo::formatWithTMXFileAsync(const char *tmxFile, CCObject *target, SEL_CallFuncO selector)
+{
+    CCTMXMapInfoAsyncLoader *pLoader = new CCTMXMapInfoAsyncLoader(tmxFile, target, selector);
+    unsigned int uRequestId = CCFileUtils::sharedFileUtils()->getFileDataAsync(tmxFile, pLoader,
+        callfuncO_selector(CCTMXMapInfoAsyncLoader::fileDataLoaded));
+    pLoader->release();
+    return uRequestId;
+}
+
 void CCTMXMapInfo::internalInit(const char* tmxFileName, const char* resourcePath)
 {
     m_pTilesets = CCArray::create();
@@ -187,9 +713,52 @@ bool CCTMXMapInfo::initWithXML(const char* tmxString, const char* resourcePath)
 }
 
 bool CCTMXMapInfo::initWithTMXFile(const char *tmxFile)
+{
+    std::string fullPath = CCFileUtils::sharedFileUtils()->fullPathForFilename(tmxFile);
+    unsigned long uSize = 0;
+    unsigned char *pData = CCFileUtils::sharedFileUtils()->getFileData(fullPath.c_str(), "rb", &uSize);
+    if (! pData)
+    {
+        internalInit(tmxFile, NULL);
+        return false;
+    }
+
+    bool bRet = initWithTMXFile(tmxFile, (const char*)pData, uSize);
+    CC_SAFE_DELETE_ARRAY(pData);
+    return bRet;
+}
+
+bool CCTMXMapInfo::initWithTMXFile(const char *tmxFile, const char *pData, unsigned long uSize)
 {
     internalInit(tmxFile, NULL);
-    return parseXMLFile(m_sTMXFileName.c_str());
+
+    unsigned int uHash = 0;
+    if (s_bBinaryCacheEnabled)
+    {
+        uHash = (unsigned int)crc32(0L, (const Bytef*)pData, (uInt)uSize);
+        if (loadBinaryCache(uHash, uSize))
+        {
+            return true;
+        }
+    }
+
+    CCSAXParser parser;
+    if (false == parser.init("UTF-8") )
+    {
+        return false;
+    }
+    parser.setDelegator(this);
+
+    if (! parser.parse(pData, uSize))
+    {
+        return false;
+    }
+
+    if (s_bBinaryCacheEnabled && ! m_bHasExternalTilesets)
+    {
+        saveBinaryCache(uHash, uSize);
+    }
+    return true;
 }
 
 CCTMXMapInfo::CCTMXMapInfo()
@@ -203,6 +772,8 @@ CCTMXMapInfo::CCTMXMapInfo()
 , m_pProperties(NULL)
 , m_pTileProperties(NULL)
 , m_uCurrentFirstGID(0)
+, m_pTileDataDecoder(NULL)
+, m_bHasExternalTilesets(false)
 {
 }
 
@@ -214,6 +785,7 @@ CCTMXMapInfo::~CCTMXMapInfo()
     CC_SAFE_RELEASE(m_pProperties);
     CC_SAFE_RELEASE(m_pTileProperties);
     CC_SAFE_RELEASE(m_pObjectGroups);
+    CC_SAFE_DELETE(m_pTileDataDecoder);
 }
 
 CCArray* CCTMXMapInfo::getLayers()
@@ -276,6 +848,247 @@ void CCTMXMapInfo::setTileProperties(CCDictionary* tileProperties)
     m_pTileProperties = tileProperties;
 }
 
+void CCTMXMapInfo::setBinaryCacheEnabled(bool bEnabled)
+{
+    s_bBinaryCacheEnabled = bEnabled;
+}
+
+bool CCTMXMapInfo::isBinaryCacheEnabled()
+{
+    return s_bBinaryCacheEnabled;
+}
+
+void CCTMXMapInfo::removeBinaryCache(const char *tmxFile)
+{
+    std::string path = binaryCachePath(CCFileUtils::sharedFileUtils()->fullPathForFilename(tmxFile));
+    remove(path.c_str());
+}
+
+void CCTMXMapInfo::saveBinaryCache(unsigned int uHash, unsigned long uSize)
+{
+    CCTMXCacheWriter writer;
+    writer.writeBytes(CC_TMX_CACHE_MAGIC, 4);
+    writer.writeUInt(CC_TMX_CACHE_VERSION);
+    writer.writeUInt((unsigned int)uSize);
+    writer.writeUInt(uHash);
+    writer.writeString(m_sTMXFileName);
+
+    writer.writeUInt((unsigned int)m_nOrientation);
+    writer.writeFloat(m_tMapSize.width);
+    writer.writeFloat(m_tMapSize.height);
+    writer.writeFloat(m_tTileSize.width);
+    writer.writeFloat(m_tTileSize.height);
+    writer.writeObject(m_pProperties);
+
+    // tile properties are the only dictionary with integer keys
+    writer.writeUInt(m_pTileProperties->count());
+    CCDictElement *pElement = NULL;
+    CCDICT_FOREACH(m_pTileProperties, pElement)
+    {
+        writer.writeUInt((unsigned int)pElement->getIntKey());
+        writer.writeObject(pElement->getObject());
+    }
+
+    CCObject *pObj = NULL;
+    writer.writeUInt(m_pTilesets->count());
+    CCARRAY_FOREACH(m_pTilesets, pObj)
+    {
+        CCTMXTilesetInfo *pTileset = (CCTMXTilesetInfo*)pObj;
+        writer.writeString(pTileset->m_sName);
+        writer.writeUInt(pTileset->m_uFirstGid);
+        writer.writeFloat(pTileset->m_tTileSize.width);
+        writer.writeFloat(pTileset->m_tTileSize.height);
+        writer.writeUInt(pTileset->m_uSpacing);
+        writer.writeUInt(pTileset->m_uMargin);
+        writer.writeString(pTileset->m_sSourceImage);
+        writer.writeFloat(pTileset->m_tImageSize.width);
+        writer.writeFloat(pTileset->m_tImageSize.height);
+    }
+
+    writer.writeUInt(m_pLayers->count());
+    CCARRAY_FOREACH(m_pLayers, pObj)
+    {
+        CCTMXLayerInfo *pLayer = (CCTMXLayerInfo*)pObj;
+        unsigned int uTileCount = pLayer->m_pTiles ? (unsigned int)(pLayer->m_tLayerSize.width * pLayer->m_tLayerSize.height) : 0;
+        writer.writeString(pLayer->m_sName);
+        writer.writeFloat(pLayer->m_tLayerSize.width);
+        writer.writeFloat(pLayer->m_tLayerSize.height);
+        writer.writeUInt(pLayer->m_bVisible ? 1 : 0);
+        writer.writeUInt(pLayer->m_cOpacity);
+        writer.writeFloat(pLayer->m_tOffset.x);
+        writer.writeFloat(pLayer->m_tOffset.y);
+        writer.writeObject(pLayer->getProperties());
+        writer.writeUInt(uTileCount);
+        writer.writeBytes(pLayer->m_pTiles, uTileCount * sizeof(unsigned int));
+    }
+
+    writer.writeUInt(m_pObjectGroups->count());
+    CCARRAY_FOREACH(m_pObjectGroups, pObj)
+    {
+        CCTMXObjectGroup *pGroup = (CCTMXObjectGroup*)pObj;
+        writer.writeString(pGroup->getGroupName());
+        writer.writeFloat(pGroup->getPositionOffset().x);
+        writer.writeFloat(pGroup->getPositionOffset().y);
+        writer.writeObject(pGroup->getProperties());
+        writer.writeObject(pGroup->getObjects());
+    }
+
+    std::string path = binaryCachePath(m_sTMXFileName);
+    FILE *fp = fopen(path.c_str(), "wb");
+    if (! fp)
+    {
+        CCLOG("cocos2d: TMXFormat: can't write the cache file %s", path.c_str());
+        return;
+    }
+    const std::string& data = writer.getData();
+    if (fwrite(data.data(), 1, data.size(), fp) != data.size())
+    {
+        CCLOG("cocos2d: TMXFormat: can't write the cache file %s", path.c_str());
+    }
+    fclose(fp);
+}
+
+bool CCTMXMapInfo::loadBinaryCache(unsigned int uHash, unsigned long uSize)
+{
+    std::string path = binaryCachePath(m_sTMXFileName);
+    if (! CCFileUtils::sharedFileUtils()->isFileExist(path))
+    {
+        return false;
+    }
+
+    unsigned long uCacheSize = 0;
+    unsigned char *pData = CCFileUtils::sharedFileUtils()->getFileData(path.c_str(), "rb", &uCacheSize);
+    CCTMXCacheReader reader(pData, uCacheSize);
+
+    bool bRet = false;
+    do
+    {
+        char magic[4] = {0};
+        reader.readBytes(magic, 4);
+        CC_BREAK_IF(memcmp(magic, CC_TMX_CACHE_MAGIC, 4) != 0);
+        CC_BREAK_IF(reader.readUInt() != CC_TMX_CACHE_VERSION);
+        CC_BREAK_IF(reader.readUInt() != (unsigned int)uSize);
+        CC_BREAK_IF(reader.readUInt() != uHash);
+        CC_BREAK_IF(reader.readString() != m_sTMXFileName);
+
+        int nOrientation = (int)reader.readUInt();
+        CCSize mapSize, tileSize;
+        mapSize.width = reader.readFloat();
+        mapSize.height = reader.readFloat();
+        tileSize.width = reader.readFloat();
+        tileSize.height = reader.readFloat();
+
+        CCDictionary *pProperties = CCDictionary::create();
+        reader.readDictionary(pProperties);
+
+        CCDictionary *pTileProperties = CCDictionary::create();
+        unsigned int uCount = reader.readUInt();
+        for (unsigned int i = 0; i < uCount && reader.isValid(); ++i)
+        {
+            unsigned int uGID = reader.readUInt();
+            CCObject *pObject = reader.readObject();
+            if (pObject)
+            {
+                pTileProperties->setObject(pObject, (intptr_t)uGID);
+                pObject->release();
+            }
+        }
+
+        CCArray *pTilesets = CCArray::create();
+        uCount = reader.readUInt();
+        for (unsigned int i = 0; i < uCount && reader.isValid(); ++i)
+        {
+            CCTMXTilesetInfo *pTileset = new CCTMXTilesetInfo();
+            pTileset->m_sName = reader.readString();
+            pTileset->m_uFirstGid = reader.readUInt();
+            pTileset->m_tTileSize.width = reader.readFloat();
+            pTileset->m_tTileSize.height = reader.readFloat();
+            pTileset->m_uSpacing = reader.readUInt();
+            pTileset->m_uMargin = reader.readUInt();
+            pTileset->m_sSourceImage = reader.readString();
+            pTileset->m_tImageSize.width = reader.readFloat();
+            pTileset->m_tImageSize.height = reader.readFloat();
+            pTilesets->addObject(pTileset);
+            pTileset->release();
+        }
+
+        CCArray *pLayers = CCArray::create();
+        bool bTilesValid = true;
+        uCount = reader.readUInt();
+        for (unsigned int i = 0; i < uCount && reader.isValid() && bTilesValid; ++i)
+        {
+            CCTMXLayerInfo *pLayer = new CCTMXLayerInfo();
+            pLayers->addObject(pLayer);
+            pLayer->release();
+
+            pLayer->m_sName = reader.readString();
+            pLayer->m_tLayerSize.width = reader.readFloat();
+            pLayer->m_tLayerSize.height = reader.readFloat();
+            pLayer->m_bVisible = reader.readUInt() != 0;
+            pLayer->m_cOpacity = (unsigned char)reader.readUInt();
+            pLayer->m_tOffset.x = reader.readFloat();
+            pLayer->m_tOffset.y = reader.readFloat();
+            reader.readDictionary(pLayer->getProperties());
+
+            unsigned int uTileCount = reader.readUInt();
+            if (uTileCount == 0)
+            {
+                continue;
+            }
+            if (uTileCount != (unsigned int)(pLayer->m_tLayerSize.width * pLayer->m_tLayerSize.height)
+                || uTileCount > uCacheSize / sizeof(unsigned int))
+            {
+                bTilesValid = false;
+                break;
+            }
+            pLayer->m_pTiles = new unsigned int[uTileCount];
+            reader.readBytes(pLayer->m_pTiles, uTileCount * sizeof(unsigned int));
+        }
+        CC_BREAK_IF(! bTilesValid);
+
+        CCArray *pObjectGroups = CCArray::create();
+        uCount = reader.readUInt();
+        for (unsigned int i = 0; i < uCount && reader.isValid(); ++i)
+        {
+            CCTMXObjectGroup *pGroup = new CCTMXObjectGroup();
+            pObjectGroups->addObject(pGroup);
+            pGroup->release();
+
+            pGroup->setGroupName(reader.readString().c_str());
+            CCPoint offset;
+            offset.x = reader.readFloat();
+            offset.y = reader.readFloat();
+            pGroup->setPositionOffset(offset);
+            reader.readDictionary(pGroup->getProperties());
+
+            CCObject *pObjects = reader.readObject();
+            if (CCArray *pArray = dynamic_cast<CCArray*>(pObjects))
+            {
+                pGroup->setObjects(pArray);
+            }
+            CC_SAFE_RELEASE(pObjects);
+        }
+        CC_BREAK_IF(! reader.isValid());
+
+        setOrientation(nOrientation);
+        setMapSize(mapSize);
+        setTileSize(tileSize);
+        setProperties(pProperties);
+        setTileProperties(pTileProperties);
+        setTilesets(pTilesets);
+        setLayers(pLayers);
+        setObjectGroups(pObjectGroups);
+        bRet = true;
+    } while (0);
+
+    CC_SAFE_DELETE_ARRAY(pData);
+    if (! bRet)
+    {
+        CCLOG("cocos2d: TMXFormat: the cache file %s is out of date", path.c_str());
+    }
+    return bRet;
+}
+
 bool CCTMXMapInfo::parseXMLString(const char *xmlString)
 {
     int len = strlen(xmlString);
@@ -375,6 +1188,7 @@ void CCTMXMapInfo::startElement(void *ctx, const char *name, const char **atts)
             externalTilesetFilename = CCFileUtils::sharedFileUtils()->fullPathForFilename(externalTilesetFilename.c_str());
             
             m_uCurrentFirstGID = (unsigned int)atoi(valueForKey("firstgid", attributeDict));
+            m_bHasExternalTilesets = true;
             
             pTMXMapInfo->parseXMLFile(externalTilesetFilename.c_str());
         }
@@ -485,11 +1299,11 @@ void CCTMXMapInfo::startElement(void *ctx, const char *name, const char **atts)
         std::string encoding = valueForKey("encoding", attributeDict);
         std::string compression = valueForKey("compression", attributeDict);
 
+        pTMXMapInfo->setLayerAttribs(TMXLayerAttribNone);
         if( encoding == "base64" )
         {
             int layerAttribs = pTMXMapInfo->getLayerAttribs();
             pTMXMapInfo->setLayerAttribs(layerAttribs | TMXLayerAttribBase64);
-            pTMXMapInfo->setStoringCharacters(true);
 
             if( compression == "gzip" )
             {
@@ -501,10 +1315,36 @@ void CCTMXMapInfo::startElement(void *ctx, const char *name, const char **atts)
                 layerAttribs = pTMXMapInfo->getLayerAttribs();
                 pTMXMapInfo->setLayerAttribs(layerAttribs | TMXLayerAttribZlib);
             }
-            CCAssert( compression == "" || compression == "gzip" || compression == "zlib", "TMX: unsupported compression method" );
+            else if (compression != "")
+            {
+                // zstd is not part of the libraries cocos2d-x ships with
+                CCLOG("cocos2d: TMXFormat: Unsupported compression method: %s", compression.c_str());
+                pTMXMapInfo->setLayerAttribs(TMXLayerAttribNone);
+            }
         }
-        CCAssert( pTMXMapInfo->getLayerAttribs() != TMXLayerAttribNone, "TMX tile map: Only base64 and/or gzip/zlib maps are supported" );
+        else if (encoding == "csv")
+        {
+            int layerAttribs = pTMXMapInfo->getLayerAttribs();
+            pTMXMapInfo->setLayerAttribs(layerAttribs | TMXLayerAttribCSV);
+        }
+        CCAssert( pTMXMapInfo->getLayerAttribs() != TMXLayerAttribNone, "TMX tile map: Only base64 and/or gzip/zlib and csv maps are supported" );
 
+        // the tiles are decoded into their final array while the text is parsed,
+        // layers which can't be decoded stay empty
+        CCTMXLayerInfo* layer = (CCTMXLayerInfo*)pTMXMapInfo->getLayers()->lastObject();
+        if (layer && ! layer->m_pTiles)
+        {
+            unsigned int uTileCount = (unsigned int)(layer->m_tLayerSize.width * layer->m_tLayerSize.height);
+            layer->m_pTiles = new unsigned int[uTileCount];
+            memset(layer->m_pTiles, 0, uTileCount * sizeof(unsigned int));
+
+            if (pTMXMapInfo->getLayerAttribs() != TMXLayerAttribNone)
+            {
+                CC_SAFE_DELETE(m_pTileDataDecoder);
+                m_pTileDataDecoder = new CCTMXTileDataDecoder(layer->m_pTiles, uTileCount, pTMXMapInfo->getLayerAttribs());
+                pTMXMapInfo->setStoringCharacters(true);
+            }
+        }
     } 
     else if (elementName == "object")
     {
@@ -694,53 +1534,16 @@ void CCTMXMapInfo::endElement(void *ctx, const char *name)
     CCTMXMapInfo *pTMXMapInfo = this;
     std::string elementName = (char*)name;
 
-    int len = 0;
-
-    if(elementName == "data" && pTMXMapInfo->getLayerAttribs()&TMXLayerAttribBase64) 
+    if(elementName == "data" && m_pTileDataDecoder)
     {
         pTMXMapInfo->setStoringCharacters(false);
 
-        CCTMXLayerInfo* layer = (CCTMXLayerInfo*)pTMXMapInfo->getLayers()->lastObject();
-
-        std::string currentString = pTMXMapInfo->getCurrentString();
-        unsigned char *buffer;
-        len = base64Decode((unsigned char*)currentString.c_str(), (unsigned int)currentString.length(), &buffer);
-        if( ! buffer ) 
+        if (! m_pTileDataDecoder->finish())
         {
-            CCLOG("cocos2d: TiledMap: decode data error");
-            return;
-        }
-
-        if( pTMXMapInfo->getLayerAttribs() & (TMXLayerAttribGzip | TMXLayerAttribZlib) )
-        {
-            unsigned char *deflated;
-            CCSize s = layer->m_tLayerSize;
-            // int sizeHint = s.width * s.height * sizeof(uint32_t);
-            int sizeHint = (int)(s.width * s.height * sizeof(unsigned int));
-
-            int inflatedLen = ZipUtils::ccInflateMemoryWithHint(buffer, len, &deflated, sizeHint);
-            CCAssert(inflatedLen == sizeHint, "");
-
-            inflatedLen = (size_t)&inflatedLen; // XXX: to avoid warnings in compiler
-            
-            delete [] buffer;
-            buffer = NULL;
-
-            if( ! deflated ) 
-            {
-                CCLOG("cocos2d: TiledMap: inflate data error");
-                return;
-            }
-
-            layer->m_pTiles = (unsigned int*) deflated;
+            CCLOG("cocos2d: TiledMap: decode data error in layer %s",
+                  ((CCTMXLayerInfo*)pTMXMapInfo->getLayers()->lastObject())->m_sName.c_str());
         }
-        else
-        {
-            layer->m_pTiles = (unsigned int*) buffer;
-        }
-
-        pTMXMapInfo->setCurrentString("");
-
+        CC_SAFE_DELETE(m_pTileDataDecoder);
     } 
     else if (elementName == "map")
     {
@@ -767,16 +1570,14 @@ void CCTMXMapInfo::endElement(void *ctx, const char *name)
 void CCTMXMapInfo::textHandler(void *ctx, const char *ch, int len)
 {
     CC_UNUSED_PARAM(ctx);
-    CCTMXMapInfo *pTMXMapInfo = this;
-    std::string pText((char*)ch,0,len);
-
-    if (pTMXMapInfo->getStoringCharacters())
+    if (m_pTileDataDecoder)
     {
-        std::string currentString = pTMXMapInfo->getCurrentString();
-        currentString += pText;
-        pTMXMapInfo->setCurrentString(currentString.c_str());
+        m_pTileDataDecoder->decode(ch, len);
+    }
+    else if (m_bStoringCharacters)
+    {
+        m_sCurrentString.append(ch, len);
     }
 }
 
 NS_CC_END
-
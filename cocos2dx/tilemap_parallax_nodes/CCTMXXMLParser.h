@@ -38,6 +38,7 @@ THE SOFTWARE.
 NS_CC_BEGIN
 
 class CCTMXObjectGroup;
+class CCTMXTileDataDecoder;
 
 /** @file
 * Internal TMX parser
@@ -57,6 +58,7 @@ enum {
     TMXLayerAttribBase64 = 1 << 1,
     TMXLayerAttribGzip = 1 << 2,
     TMXLayerAttribZlib = 1 << 3,
+    TMXLayerAttribCSV = 1 << 4,
 };
 
 enum {
@@ -177,8 +179,20 @@ public:
     static CCTMXMapInfo * formatWithTMXFile(const char *tmxFile);
     /** creates a TMX Format with an XML string and a TMX resource path */
     static CCTMXMapInfo * formatWithXML(const char* tmxString, const char* resourcePath);
+    /** reads and parses a tmx file without blocking, and loads its tileset images with CCTextureCache::addImageAsync().
+     The selector is called on the main thread with the CCTMXMapInfo, which is an autorelease object,
+     or with NULL if the file can't be parsed. External tilesets (tsx) are still read synchronously.
+     @return The id of the file read, it can be cancelled with CCFileUtils::cancelFileDataAsync().
+     @since v2.1.4
+     */
+    static unsigned int formatWithTMXFileAsync(const char *tmxFile, CCObject *target, SEL_CallFuncO selector);
     /** initializes a TMX format with a  tmx file */
     bool initWithTMXFile(const char *tmxFile);
+    /** initializes a TMX format with the contents of a tmx file that was read already.
+     If the binary cache is enabled, the map is restored from it when its hash matches the contents.
+     @since v2.1.4
+     */
+    bool initWithTMXFile(const char *tmxFile, const char *pData, unsigned long uSize);
     /** initializes a TMX format with an XML string and a TMX resource path */
     bool initWithXML(const char* tmxString, const char* resourcePath);
     /** initializes parsing of an XML file, either a tmx (Map) file or tsx (Tileset) file */
@@ -186,6 +200,19 @@ public:
     /* initializes parsing of an XML string, either a tmx (Map) string or tsx (Tileset) string */
     bool parseXMLString(const char *xmlString);
 
+    /** Enables a cache of the maps loaded from tmx files, in binary files of the writable path.
+     A map is written to the cache the first time it is parsed, and restored from it with a single
+     read as long as the crc32 of the tmx file is the same. Maps using external tilesets (tsx)
+     are not cached, since changes to the tileset files could not be detected. Disabled by default.
+     @since v2.1.4
+     */
+    static void setBinaryCacheEnabled(bool bEnabled);
+    static bool isBinaryCacheEnabled();
+    /** Removes the cache file of a tmx file, if any
+     @since v2.1.4
+     */
+    static void removeBinaryCache(const char *tmxFile);
+
     CCDictionary* getTileProperties();
     void setTileProperties(CCDictionary* tileProperties);
 
@@ -200,6 +227,8 @@ public:
     inline void setTMXFileName(const char *fileName){ m_sTMXFileName = fileName; }
 private:
     void internalInit(const char* tmxFileName, const char* resourcePath);
+    bool loadBinaryCache(unsigned int uHash, unsigned long uSize);
+    void saveBinaryCache(unsigned int uHash, unsigned long uSize);
 protected:
     //! tmx filename
     std::string m_sTMXFileName;
@@ -210,6 +239,10 @@ protected:
     //! tile properties
     CCDictionary* m_pTileProperties;
     unsigned int m_uCurrentFirstGID;
+    //! decodes the <data> element being parsed into the tiles of the last layer
+    CCTMXTileDataDecoder *m_pTileDataDecoder;
+    //! whether a tsx file was parsed for the map
+    bool m_bHasExternalTilesets;
 };
 
 // end of tilemap_parallax_nodes group
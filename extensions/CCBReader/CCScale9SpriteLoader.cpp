@@ -41,8 +41,7 @@ void CCScale9SpriteLoader::onHandlePropTypeByte(CCNode * pNode, CCNode * pParent
 
 void CCScale9SpriteLoader::onHandlePropTypeBlendFunc(CCNode * pNode, CCNode * pParent, const char * pPropertyName, ccBlendFunc pCCBlendFunc, CCBReader * pCCBReader) {
     if(strcmp(pPropertyName, PROPERTY_BLENDFUNC) == 0) {
-        // TODO Not exported by CocosBuilder yet!
-        // ((CCScale9Sprite *)pNode)->setBlendFunc(pCCBlendFunc);
+        ((CCScale9Sprite *)pNode)->setBlendFunc(pCCBlendFunc);
     } else {
         CCNodeLoader::onHandlePropTypeBlendFunc(pNode, pParent, pPropertyName, pCCBlendFunc, pCCBReader);
     }
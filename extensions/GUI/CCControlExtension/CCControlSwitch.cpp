@@ -161,12 +161,10 @@ void CCControlSwitchSprite::draw()
     ccGLBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
     getShaderProgram()->setUniformsForBuiltins();
 
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture( GL_TEXTURE_2D, getTexture()->getName());
+    ccGLBindTexture2DN(0, getTexture()->getName());
     glUniform1i(m_uTextureLocation, 0);
 
-    glActiveTexture(GL_TEXTURE1);
-    glBindTexture( GL_TEXTURE_2D, m_pMaskTexture->getName() );
+    ccGLBindTexture2DN(1, m_pMaskTexture->getName());
     glUniform1i(m_uMaskLocation, 1);
 
 #define kQuadSize sizeof(m_sQuad.bl)
@@ -185,7 +183,7 @@ void CCControlSwitchSprite::draw()
     glVertexAttribPointer(kCCVertexAttrib_Color, 4, GL_UNSIGNED_BYTE, GL_TRUE, kQuadSize, (void*)(offset + diff));
 
     glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);    
-    glActiveTexture(GL_TEXTURE0);
+    ccGLActiveTexture(GL_TEXTURE0);
 }
 
 void CCControlSwitchSprite::needsLayout()
@@ -29,73 +29,38 @@ THE SOFTWARE.
 
 NS_CC_EXT_BEGIN
 
-enum positions
-{
-    pCentre = 0,
-    pTop,
-    pLeft,
-    pRight,
-    pBottom,
-    pTopRight,
-    pTopLeft,
-    pBottomRight,
-    pBottomLeft
-};
-
 CCScale9Sprite::CCScale9Sprite()
 : m_insetLeft(0)
 , m_insetTop(0)
 , m_insetRight(0)
 , m_insetBottom(0)
-, m_bSpritesGenerated(false)
 , m_bSpriteFrameRotated(false)
 , m_positionsAreDirty(false)
-, _scale9Image(NULL)
-, _topLeft(NULL)
-, _top(NULL)
-, _topRight(NULL)
-, _left(NULL)
-, _centre(NULL)
-, _right(NULL)
-, _bottomLeft(NULL)
-, _bottom(NULL)
-, _bottomRight(NULL)
+, m_pTexture(NULL)
 , _opacityModifyRGB(false)
-, _opacity(255)
-, _color(ccWHITE)
 {
-
+    m_sBlendFunc.src = CC_BLEND_SRC;
+    m_sBlendFunc.dst = CC_BLEND_DST;
+    memset(m_sVertices, 0, sizeof(m_sVertices));
 }
 
 CCScale9Sprite::~CCScale9Sprite()
 {
-    CC_SAFE_RELEASE(_topLeft);
-    CC_SAFE_RELEASE(_top);
-    CC_SAFE_RELEASE(_topRight);
-    CC_SAFE_RELEASE(_left);
-    CC_SAFE_RELEASE(_centre);
-    CC_SAFE_RELEASE(_right);
-    CC_SAFE_RELEASE(_bottomLeft);
-    CC_SAFE_RELEASE(_bottom);
-    CC_SAFE_RELEASE(_bottomRight);
-    CC_SAFE_RELEASE(_scale9Image);
+    CC_SAFE_RELEASE(m_pTexture);
 }
 
 bool CCScale9Sprite::init()
 {
-    return this->initWithBatchNode(NULL, CCRectZero, CCRectZero);
+    return this->initWithTexture(NULL, CCRectZero, false, CCRectZero);
 }
 
-bool CCScale9Sprite::initWithBatchNode(CCSpriteBatchNode* batchnode, CCRect rect, CCRect capInsets)
+bool CCScale9Sprite::initWithTexture(CCTexture2D* texture, CCRect rect, bool rotated, CCRect capInsets)
 {
-    return this->initWithBatchNode(batchnode, rect, false, capInsets);
-}
+    this->setShaderProgram(CCShaderCache::sharedShaderCache()->programForKey(kCCShader_PositionTextureColor));
 
-bool CCScale9Sprite::initWithBatchNode(CCSpriteBatchNode* batchnode, CCRect rect, bool rotated, CCRect capInsets)
-{
-    if(batchnode)
+    if(texture)
     {
-        this->updateWithBatchNode(batchnode, rect, rotated, capInsets);
+        this->updateWithTexture(texture, rect, rotated, capInsets);
         this->setAnchorPoint(ccp(0.5f, 0.5f));
     }
     this->m_positionsAreDirty = true;
@@ -103,53 +68,47 @@ bool CCScale9Sprite::initWithBatchNode(CCSpriteBatchNode* batchnode, CCRect rect
     return true;
 }
 
-#define    TRANSLATE_X(x, y, xtranslate) \
-    x+=xtranslate;                       \
+bool CCScale9Sprite::initWithBatchNode(CCSpriteBatchNode* batchnode, CCRect rect, CCRect capInsets)
+{
+    return this->initWithBatchNode(batchnode, rect, false, capInsets);
+}
 
-#define    TRANSLATE_Y(x, y, ytranslate) \
-    y+=ytranslate;                       \
+bool CCScale9Sprite::initWithBatchNode(CCSpriteBatchNode* batchnode, CCRect rect, bool rotated, CCRect capInsets)
+{
+    return this->initWithTexture(batchnode ? batchnode->getTexture() : NULL, rect, rotated, capInsets);
+}
 
 bool CCScale9Sprite::updateWithBatchNode(CCSpriteBatchNode* batchnode, CCRect rect, bool rotated, CCRect capInsets)
 {
-    GLubyte opacity = getOpacity();
-    ccColor3B color = getColor();
-
-    // Release old sprites
-    this->removeAllChildrenWithCleanup(true);
+    CCAssert(batchnode != NULL, "CCSpriteBatchNode must be non-NULL");
+    return this->updateWithTexture(batchnode->getTexture(), rect, rotated, capInsets);
+}
 
-    CC_SAFE_RELEASE(this->_centre);
-    CC_SAFE_RELEASE(this->_top);
-    CC_SAFE_RELEASE(this->_topLeft);
-    CC_SAFE_RELEASE(this->_topRight);
-    CC_SAFE_RELEASE(this->_left);
-    CC_SAFE_RELEASE(this->_right);
-    CC_SAFE_RELEASE(this->_bottomLeft);
-    CC_SAFE_RELEASE(this->_bottom);
-    CC_SAFE_RELEASE(this->_bottomRight);
+bool CCScale9Sprite::updateWithTexture(CCTexture2D* texture, CCRect rect, bool rotated, CCRect capInsets)
+{
+    CCAssert(texture != NULL, "CCTexture2D must be non-NULL");
 
-    
-    if(this->_scale9Image != batchnode)
+    if (m_pTexture != texture)
     {
-        CC_SAFE_RELEASE(this->_scale9Image);
-        _scale9Image = batchnode;
-        CC_SAFE_RETAIN(_scale9Image);
+        CC_SAFE_RETAIN(texture);
+        CC_SAFE_RELEASE(m_pTexture);
+        m_pTexture = texture;
     }
 
-    _scale9Image->removeAllChildrenWithCleanup(true);
-
     m_capInsets = capInsets;
     
     // If there is no given rect
     if ( rect.equals(CCRectZero) )
     {
         // Get the texture size as original
-        CCSize textureSize = _scale9Image->getTextureAtlas()->getTexture()->getContentSize();
+        CCSize textureSize = m_pTexture->getContentSize();
     
         rect = CCRectMake(0, 0, textureSize.width, textureSize.height);
     }
     
     // Set the given rect's size as original size
     m_spriteRect = rect;
+    m_bSpriteFrameRotated = rotated;
     m_originalSize = rect.size;
     m_preferredSize = m_originalSize;
     m_capInsetsInternal = capInsets;
@@ -164,305 +123,190 @@ bool CCScale9Sprite::updateWithBatchNode(CCSpriteBatchNode* batchnode, CCRect re
         m_capInsetsInternal = CCRectMake(w/3, h/3, w/3, h/3);
     }
 
+    // same defaults as CCSprite
+    if (! m_pTexture->hasPremultipliedAlpha())
+    {
+        m_sBlendFunc.src = GL_SRC_ALPHA;
+        m_sBlendFunc.dst = GL_ONE_MINUS_SRC_ALPHA;
+        _opacityModifyRGB = false;
+    }
+    else
+    {
+        m_sBlendFunc.src = CC_BLEND_SRC;
+        m_sBlendFunc.dst = CC_BLEND_DST;
+        _opacityModifyRGB = true;
+    }
+
+    this->updateTexCoords();
+    this->updateColor();
+    this->setContentSize(rect.size);
+    this->setBitmapCacheDirty();
+
+    return true;
+}
+
+void CCScale9Sprite::setContentSize(const CCSize &size)
+{
+    CCNode::setContentSize(size);
+    this->m_positionsAreDirty = true;
+}
+
+void CCScale9Sprite::updateTexCoords()
+{
     float left_w = m_capInsetsInternal.origin.x;
     float center_w = m_capInsetsInternal.size.width;
-    float right_w = rect.size.width - (left_w + center_w);
 
     float top_h = m_capInsetsInternal.origin.y;
     float center_h = m_capInsetsInternal.size.height;
-    float bottom_h = rect.size.height - (top_h + center_h);
-
-    // calculate rects
-
-    // ... top row
-    float x = 0.0;
-    float y = 0.0;
-
-    // top left
-    CCRect lefttopbounds = CCRectMake(x, y,
-                                      left_w, top_h);
-
-    // top center
-    TRANSLATE_X(x, y, left_w);
-    CCRect centertopbounds = CCRectMake(x, y,
-                                        center_w, top_h);
-        
-    // top right
-    TRANSLATE_X(x, y, center_w);
-    CCRect righttopbounds = CCRectMake(x, y,
-                                       right_w, top_h);
-
-    // ... center row
-    x = 0.0;
-    y = 0.0;
-    TRANSLATE_Y(x, y, top_h);
-
-    // center left
-    CCRect leftcenterbounds = CCRectMake(x, y,
-                                         left_w, center_h);
-
-    // center center
-    TRANSLATE_X(x, y, left_w);
-    CCRect centerbounds = CCRectMake(x, y,
-                                     center_w, center_h);
-
-    // center right
-    TRANSLATE_X(x, y, center_w);
-    CCRect rightcenterbounds = CCRectMake(x, y,
-                                          right_w, center_h);
-
-    // ... bottom row
-    x = 0.0;
-    y = 0.0;
-    TRANSLATE_Y(x, y, top_h);
-    TRANSLATE_Y(x, y, center_h);
-
-    // bottom left
-    CCRect leftbottombounds = CCRectMake(x, y,
-                                         left_w, bottom_h);
-
-    // bottom center
-    TRANSLATE_X(x, y, left_w);
-    CCRect centerbottombounds = CCRectMake(x, y,
-                                           center_w, bottom_h);
-
-    // bottom right
-    TRANSLATE_X(x, y, center_w);
-    CCRect rightbottombounds = CCRectMake(x, y,
-                                          right_w, bottom_h);
-
-    if (!rotated) {
-        // CCLog("!rotated");
-
-        CCAffineTransform t = CCAffineTransformMakeIdentity();
-        t = CCAffineTransformTranslate(t, rect.origin.x, rect.origin.y);
-
-        centerbounds = CCRectApplyAffineTransform(centerbounds, t);
-        rightbottombounds = CCRectApplyAffineTransform(rightbottombounds, t);
-        leftbottombounds = CCRectApplyAffineTransform(leftbottombounds, t);
-        righttopbounds = CCRectApplyAffineTransform(righttopbounds, t);
-        lefttopbounds = CCRectApplyAffineTransform(lefttopbounds, t);
-        rightcenterbounds = CCRectApplyAffineTransform(rightcenterbounds, t);
-        leftcenterbounds = CCRectApplyAffineTransform(leftcenterbounds, t);
-        centerbottombounds = CCRectApplyAffineTransform(centerbottombounds, t);
-        centertopbounds = CCRectApplyAffineTransform(centertopbounds, t);
-
-        // Centre
-        _centre = new CCSprite();
-        _centre->initWithTexture(_scale9Image->getTexture(), centerbounds);
-        _scale9Image->addChild(_centre, 0, pCentre);
-        
-        // Top
-        _top = new CCSprite();
-        _top->initWithTexture(_scale9Image->getTexture(), centertopbounds);
-        _scale9Image->addChild(_top, 1, pTop);
-        
-        // Bottom
-        _bottom = new CCSprite();
-        _bottom->initWithTexture(_scale9Image->getTexture(), centerbottombounds);
-        _scale9Image->addChild(_bottom, 1, pBottom);
-        
-        // Left
-        _left = new CCSprite();
-        _left->initWithTexture(_scale9Image->getTexture(), leftcenterbounds);
-        _scale9Image->addChild(_left, 1, pLeft);
-        
-        // Right
-        _right = new CCSprite();
-        _right->initWithTexture(_scale9Image->getTexture(), rightcenterbounds);
-        _scale9Image->addChild(_right, 1, pRight);
-        
-        // Top left
-        _topLeft = new CCSprite();
-        _topLeft->initWithTexture(_scale9Image->getTexture(), lefttopbounds);
-        _scale9Image->addChild(_topLeft, 2, pTopLeft);
-        
-        // Top right
-        _topRight = new CCSprite();
-        _topRight->initWithTexture(_scale9Image->getTexture(), righttopbounds);
-        _scale9Image->addChild(_topRight, 2, pTopRight);
-        
-        // Bottom left
-        _bottomLeft = new CCSprite();
-        _bottomLeft->initWithTexture(_scale9Image->getTexture(), leftbottombounds);
-        _scale9Image->addChild(_bottomLeft, 2, pBottomLeft);
-        
-        // Bottom right
-        _bottomRight = new CCSprite();
-        _bottomRight->initWithTexture(_scale9Image->getTexture(), rightbottombounds);
-        _scale9Image->addChild(_bottomRight, 2, pBottomRight);
-    } else {
-        // set up transformation of coordinates
-        // to handle the case where the sprite is stored rotated
-        // in the spritesheet
-        // CCLog("rotated");
-
-        CCAffineTransform t = CCAffineTransformMakeIdentity();
-
-        CCRect rotatedcenterbounds = centerbounds;
-        CCRect rotatedrightbottombounds = rightbottombounds;
-        CCRect rotatedleftbottombounds = leftbottombounds;
-        CCRect rotatedrighttopbounds = righttopbounds;
-        CCRect rotatedlefttopbounds = lefttopbounds;
-        CCRect rotatedrightcenterbounds = rightcenterbounds;
-        CCRect rotatedleftcenterbounds = leftcenterbounds;
-        CCRect rotatedcenterbottombounds = centerbottombounds;
-        CCRect rotatedcentertopbounds = centertopbounds;
-        
-        t = CCAffineTransformTranslate(t, rect.size.height+rect.origin.x, rect.origin.y);
-        t = CCAffineTransformRotate(t, 1.57079633f);
-        
-        centerbounds = CCRectApplyAffineTransform(centerbounds, t);
-        rightbottombounds = CCRectApplyAffineTransform(rightbottombounds, t);
-        leftbottombounds = CCRectApplyAffineTransform(leftbottombounds, t);
-        righttopbounds = CCRectApplyAffineTransform(righttopbounds, t);
-        lefttopbounds = CCRectApplyAffineTransform(lefttopbounds, t);
-        rightcenterbounds = CCRectApplyAffineTransform(rightcenterbounds, t);
-        leftcenterbounds = CCRectApplyAffineTransform(leftcenterbounds, t);
-        centerbottombounds = CCRectApplyAffineTransform(centerbottombounds, t);
-        centertopbounds = CCRectApplyAffineTransform(centertopbounds, t);
-
-        rotatedcenterbounds.origin = centerbounds.origin;
-        rotatedrightbottombounds.origin = rightbottombounds.origin;
-        rotatedleftbottombounds.origin = leftbottombounds.origin;
-        rotatedrighttopbounds.origin = righttopbounds.origin;
-        rotatedlefttopbounds.origin = lefttopbounds.origin;
-        rotatedrightcenterbounds.origin = rightcenterbounds.origin;
-        rotatedleftcenterbounds.origin = leftcenterbounds.origin;
-        rotatedcenterbottombounds.origin = centerbottombounds.origin;
-        rotatedcentertopbounds.origin = centertopbounds.origin;
-
-        // Centre
-        _centre = new CCSprite();
-        _centre->initWithTexture(_scale9Image->getTexture(), rotatedcenterbounds, true);
-        _scale9Image->addChild(_centre, 0, pCentre);
-        
-        // Top
-        _top = new CCSprite();
-        _top->initWithTexture(_scale9Image->getTexture(), rotatedcentertopbounds, true);
-        _scale9Image->addChild(_top, 1, pTop);
-        
-        // Bottom
-        _bottom = new CCSprite();
-        _bottom->initWithTexture(_scale9Image->getTexture(), rotatedcenterbottombounds, true);
-        _scale9Image->addChild(_bottom, 1, pBottom);
-        
-        // Left
-        _left = new CCSprite();
-        _left->initWithTexture(_scale9Image->getTexture(), rotatedleftcenterbounds, true);
-        _scale9Image->addChild(_left, 1, pLeft);
-        
-        // Right
-        _right = new CCSprite();
-        _right->initWithTexture(_scale9Image->getTexture(), rotatedrightcenterbounds, true);
-        _scale9Image->addChild(_right, 1, pRight);
-        
-        // Top left
-        _topLeft = new CCSprite();
-        _topLeft->initWithTexture(_scale9Image->getTexture(), rotatedlefttopbounds, true);
-        _scale9Image->addChild(_topLeft, 2, pTopLeft);
-        
-        // Top right
-        _topRight = new CCSprite();
-        _topRight->initWithTexture(_scale9Image->getTexture(), rotatedrighttopbounds, true);
-        _scale9Image->addChild(_topRight, 2, pTopRight);
-        
-        // Bottom left
-        _bottomLeft = new CCSprite();
-        _bottomLeft->initWithTexture(_scale9Image->getTexture(), rotatedleftbottombounds, true);
-        _scale9Image->addChild(_bottomLeft, 2, pBottomLeft);
-        
-        // Bottom right
-        _bottomRight = new CCSprite();
-        _bottomRight->initWithTexture(_scale9Image->getTexture(), rotatedrightbottombounds, true);
-        _scale9Image->addChild(_bottomRight, 2, pBottomRight);
+    float bottom_h = m_spriteRect.size.height - (top_h + center_h);
+
+    // offsets of the slices in the sprite, from its bottom left corner, in pixels
+    float scale = CC_CONTENT_SCALE_FACTOR();
+    float xs[4] = { 0, left_w * scale, (left_w + center_w) * scale, m_spriteRect.size.width * scale };
+    float ys[4] = { 0, bottom_h * scale, (bottom_h + center_h) * scale, m_spriteRect.size.height * scale };
+
+    CCRect rect = CC_RECT_POINTS_TO_PIXELS(m_spriteRect);
+    float atlasWidth = (float)m_pTexture->getPixelsWide();
+    float atlasHeight = (float)m_pTexture->getPixelsHigh();
+
+    for (int j = 0; j < 4; j++)
+    {
+        for (int i = 0; i < 4; i++)
+        {
+            ccTex2F& tex = m_sVertices[j * 4 + i].texCoords;
+            if (m_bSpriteFrameRotated)
+            {
+                // the sprite is stored rotated by 90 degrees clockwise in the texture
+                tex.u = (rect.origin.x + ys[j]) / atlasWidth;
+                tex.v = (rect.origin.y + xs[i]) / atlasHeight;
+            }
+            else
+            {
+                tex.u = (rect.origin.x + xs[i]) / atlasWidth;
+                tex.v = (rect.origin.y + rect.size.height - ys[j]) / atlasHeight;
+            }
+        }
     }
+}
 
-    this->setContentSize(rect.size);
-    this->addChild(_scale9Image);
-    
-    if (m_bSpritesGenerated)
+void CCScale9Sprite::updatePositions()
+{
+    CCSize size = this->m_obContentSize;
+
+    float left_w = m_capInsetsInternal.origin.x;
+    float right_w = m_spriteRect.size.width - (left_w + m_capInsetsInternal.size.width);
+    float top_h = m_capInsetsInternal.origin.y;
+    float bottom_h = m_spriteRect.size.height - (top_h + m_capInsetsInternal.size.height);
+
+    float xs[4] = { 0, left_w, size.width - right_w, size.width };
+    float ys[4] = { 0, bottom_h, size.height - top_h, size.height };
+
+    // the caps are shrunk when the sprite is smaller than them
+    if (size.width < left_w + right_w && left_w + right_w > 0)
+    {
+        xs[1] = xs[2] = left_w * size.width / (left_w + right_w);
+    }
+    if (size.height < top_h + bottom_h && top_h + bottom_h > 0)
+    {
+        ys[1] = ys[2] = bottom_h * size.height / (top_h + bottom_h);
+    }
+
+    for (int j = 0; j < 4; j++)
+    {
+        for (int i = 0; i < 4; i++)
         {
-            // Restore color and opacity
-            this->setOpacity(opacity);
-            this->setColor(color);
+            m_sVertices[j * 4 + i].vertices = vertex3(xs[i], ys[j], 0);
         }
-    m_bSpritesGenerated = true;
+    }
+    m_positionsAreDirty = false;
+}
 
-    return true;
+void CCScale9Sprite::updateColor()
+{
+    ccColor4B color4 = { _displayedColor.r, _displayedColor.g, _displayedColor.b, _displayedOpacity };
+
+    // special opacity for premultiplied textures
+    if (_opacityModifyRGB)
+    {
+        color4.r *= _displayedOpacity/255.0f;
+        color4.g *= _displayedOpacity/255.0f;
+        color4.b *= _displayedOpacity/255.0f;
+    }
+
+    for (int i = 0; i < 16; i++)
+    {
+        m_sVertices[i].colors = color4;
+    }
 }
 
-void CCScale9Sprite::setContentSize(const CCSize &size)
+const ccV3F_C4B_T2F* CCScale9Sprite::getVertices()
 {
-    CCNode::setContentSize(size);
-    this->m_positionsAreDirty = true;
+    if (m_positionsAreDirty)
+    {
+        this->updatePositions();
+    }
+    return m_sVertices;
 }
 
-void CCScale9Sprite::updatePositions()
+const GLushort* CCScale9Sprite::getIndices()
+{
+    // 2 triangles for each slice, the vertex v of a slice is followed by v+1 on its right and v+4 above it
+    static const GLushort s_pIndices[54] =
+    {
+        0, 1, 5,  0, 5, 4,      1, 2, 6,  1, 6, 5,      2, 3, 7,  2, 7, 6,
+        4, 5, 9,  4, 9, 8,      5, 6, 10, 5, 10, 9,     6, 7, 11, 6, 11, 10,
+        8, 9, 13, 8, 13, 12,    9, 10, 14, 9, 14, 13,   10, 11, 15, 10, 15, 14
+    };
+    return s_pIndices;
+}
+
+void CCScale9Sprite::draw()
 {
-    // Check that instances are non-NULL
-    if(!((_topLeft) &&
-         (_topRight) &&
-         (_bottomRight) &&
-         (_bottomLeft) &&
-         (_centre))) {
-        // if any of the above sprites are NULL, return
+    if (! m_pTexture)
+    {
         return;
     }
 
-    CCSize size = this->m_obContentSize;
+    const ccV3F_C4B_T2F* vertices = this->getVertices();
 
-    float sizableWidth = size.width - _topLeft->getContentSize().width - _topRight->getContentSize().width;
-    float sizableHeight = size.height - _topLeft->getContentSize().height - _bottomRight->getContentSize().height;
-    
-    float horizontalScale = sizableWidth/_centre->getContentSize().width;
-    float verticalScale = sizableHeight/_centre->getContentSize().height;
-
-    _centre->setScaleX(horizontalScale);
-    _centre->setScaleY(verticalScale);
-
-    float rescaledWidth = _centre->getContentSize().width * horizontalScale;
-    float rescaledHeight = _centre->getContentSize().height * verticalScale;
-
-    float leftWidth = _bottomLeft->getContentSize().width;
-    float bottomHeight = _bottomLeft->getContentSize().height;
-
-    _bottomLeft->setAnchorPoint(ccp(0,0));
-    _bottomRight->setAnchorPoint(ccp(0,0));
-    _topLeft->setAnchorPoint(ccp(0,0));
-    _topRight->setAnchorPoint(ccp(0,0));
-    _left->setAnchorPoint(ccp(0,0));
-    _right->setAnchorPoint(ccp(0,0));
-    _top->setAnchorPoint(ccp(0,0));
-    _bottom->setAnchorPoint(ccp(0,0));
-    _centre->setAnchorPoint(ccp(0,0));
-
-    // Position corners
-    _bottomLeft->setPosition(ccp(0,0));
-    _bottomRight->setPosition(ccp(leftWidth+rescaledWidth,0));
-    _topLeft->setPosition(ccp(0, bottomHeight+rescaledHeight));
-    _topRight->setPosition(ccp(leftWidth+rescaledWidth, bottomHeight+rescaledHeight));
-
-    // Scale and position borders
-    _left->setPosition(ccp(0, bottomHeight));
-    _left->setScaleY(verticalScale);
-    _right->setPosition(ccp(leftWidth+rescaledWidth,bottomHeight));
-    _right->setScaleY(verticalScale);
-    _bottom->setPosition(ccp(leftWidth,0));
-    _bottom->setScaleX(horizontalScale);
-    _top->setPosition(ccp(leftWidth,bottomHeight+rescaledHeight));
-    _top->setScaleX(horizontalScale);
-
-    // Position centre
-    _centre->setPosition(ccp(leftWidth, bottomHeight));
+    CC_NODE_DRAW_SETUP();
+
+    ccGLBlendFunc( m_sBlendFunc.src, m_sBlendFunc.dst );
+    ccGLBindTexture2D( m_pTexture->getName() );
+    ccGLEnableVertexAttribs( kCCVertexAttribFlag_PosColorTex );
+
+    // the vertices are client arrays
+    ccGLBindBuffer(GL_ARRAY_BUFFER, 0);
+    ccGLBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+#define kVertexSize sizeof(ccV3F_C4B_T2F)
+    long offset = (long)vertices;
+
+    // vertex
+    int diff = offsetof( ccV3F_C4B_T2F, vertices);
+    glVertexAttribPointer(kCCVertexAttrib_Position, 3, GL_FLOAT, GL_FALSE, kVertexSize, (void*) (offset + diff));
+
+    // texCoods
+    diff = offsetof( ccV3F_C4B_T2F, texCoords);
+    glVertexAttribPointer(kCCVertexAttrib_TexCoords, 2, GL_FLOAT, GL_FALSE, kVertexSize, (void*)(offset + diff));
+
+    // color
+    diff = offsetof( ccV3F_C4B_T2F, colors);
+    glVertexAttribPointer(kCCVertexAttrib_Color, 4, GL_UNSIGNED_BYTE, GL_TRUE, kVertexSize, (void*)(offset + diff));
+
+    glDrawElements(GL_TRIANGLES, 54, GL_UNSIGNED_SHORT, getIndices());
+
+    CHECK_GL_ERROR_DEBUG();
+
+    CC_INCREMENT_GL_DRAWS(1);
 }
 
 bool CCScale9Sprite::initWithFile(const char* file, CCRect rect,  CCRect capInsets)
 {
     CCAssert(file != NULL, "Invalid file for sprite");
     
-    CCSpriteBatchNode *batchnode = CCSpriteBatchNode::create(file, 9);
-    bool pReturn = this->initWithBatchNode(batchnode, rect, capInsets);
+    CCTexture2D *texture = CCTextureCache::sharedTextureCache()->addImage(file);
+    bool pReturn = this->initWithTexture(texture, rect, false, capInsets);
     return pReturn;
 }
 
@@ -540,10 +384,7 @@ bool CCScale9Sprite::initWithSpriteFrame(CCSpriteFrame* spriteFrame, CCRect capI
     CCTexture2D* texture = spriteFrame->getTexture();
     CCAssert(texture != NULL, "CCTexture must be not nil");
 
-    CCSpriteBatchNode *batchnode = CCSpriteBatchNode::createWithTexture(texture, 9);
-    CCAssert(batchnode != NULL, "CCSpriteBatchNode must be not nil");
-
-    bool pReturn = this->initWithBatchNode(batchnode, spriteFrame->getRect(), spriteFrame->isRotated(), capInsets);
+    bool pReturn = this->initWithTexture(texture, spriteFrame->getRect(), spriteFrame->isRotated(), capInsets);
     return pReturn;
 }
 
@@ -628,7 +469,7 @@ CCScale9Sprite* CCScale9Sprite::createWithSpriteFrameName(const char* spriteFram
 CCScale9Sprite* CCScale9Sprite::resizableSpriteWithCapInsets(CCRect capInsets)
 {
     CCScale9Sprite* pReturn = new CCScale9Sprite();
-    if ( pReturn && pReturn->initWithBatchNode(_scale9Image, m_spriteRect, capInsets) )
+    if ( pReturn && pReturn->initWithTexture(m_pTexture, m_spriteRect, m_bSpriteFrameRotated, capInsets) )
     {
         pReturn->autorelease();
         return pReturn;
@@ -668,7 +509,7 @@ CCSize CCScale9Sprite::getPreferredSize()
 void CCScale9Sprite::setCapInsets(CCRect capInsets)
 {
     CCSize contentSize = this->m_obContentSize;
-    this->updateWithBatchNode(this->_scale9Image, this->m_spriteRect, m_bSpriteFrameRotated, capInsets);
+    this->updateWithTexture(m_pTexture, this->m_spriteRect, m_bSpriteFrameRotated, capInsets);
     this->setContentSize(contentSize);
 }
 
@@ -686,20 +527,11 @@ void CCScale9Sprite::updateCapInset()
     }
     else
     {
-        if (m_bSpriteFrameRotated)
-        {
-            insets = CCRectMake(m_insetBottom,
-                m_insetLeft,
-                m_spriteRect.size.width-m_insetRight-m_insetLeft,
-                m_spriteRect.size.height-m_insetTop-m_insetBottom);
-        }
-        else
-        {
-            insets = CCRectMake(m_insetLeft,
-                m_insetTop,
-                m_spriteRect.size.width-m_insetLeft-m_insetRight,
-                m_spriteRect.size.height-m_insetTop-m_insetBottom);
-        }
+        // the insets are in the coordinates of the sprite, even if it is rotated in the texture
+        insets = CCRectMake(m_insetLeft,
+            m_insetTop,
+            m_spriteRect.size.width-m_insetLeft-m_insetRight,
+            m_spriteRect.size.height-m_insetTop-m_insetBottom);
     }
     this->setCapInsets(insets);
 }
@@ -707,16 +539,7 @@ void CCScale9Sprite::updateCapInset()
 void CCScale9Sprite::setOpacityModifyRGB(bool var)
 {
     _opacityModifyRGB = var;
-    CCObject* child;
-    CCArray* children = _scale9Image->getChildren();
-    CCARRAY_FOREACH(children, child)
-    {
-        CCRGBAProtocol* pNode = dynamic_cast<CCRGBAProtocol*>(child);
-        if (pNode)
-        {
-            pNode->setOpacityModifyRGB(_opacityModifyRGB);
-        }
-    }
+    this->updateColor();
 }
 bool CCScale9Sprite::isOpacityModifyRGB()
 {
@@ -725,8 +548,7 @@ bool CCScale9Sprite::isOpacityModifyRGB()
 
 void CCScale9Sprite::setSpriteFrame(CCSpriteFrame * spriteFrame)
 {
-    CCSpriteBatchNode * batchnode = CCSpriteBatchNode::createWithTexture(spriteFrame->getTexture(), 9);
-    this->updateWithBatchNode(batchnode, spriteFrame->getRect(), spriteFrame->isRotated(), CCRectZero);
+    this->updateWithTexture(spriteFrame->getTexture(), spriteFrame->getRect(), spriteFrame->isRotated(), CCRectZero);
 
     // Reset insets
     this->m_insetLeft = 0;
@@ -779,46 +601,337 @@ void CCScale9Sprite::setInsetBottom(float insetBottom)
     this->updateCapInset();
 }
 
-void CCScale9Sprite::visit()
+void CCScale9Sprite::setColor(const ccColor3B& color)
 {
-    if(this->m_positionsAreDirty)
-    {
-        this->updatePositions();
-        this->m_positionsAreDirty = false;
-    }
-    CCNode::visit();
+    CCNodeRGBA::setColor(color);
+    this->updateColor();
 }
 
-void CCScale9Sprite::setColor(const ccColor3B& color)
+void CCScale9Sprite::setOpacity(GLubyte opacity)
+{
+    CCNodeRGBA::setOpacity(opacity);
+    this->updateColor();
+}
+
+void CCScale9Sprite::updateDisplayedColor(const ccColor3B& parentColor)
+{
+    CCNodeRGBA::updateDisplayedColor(parentColor);
+    this->updateColor();
+}
+
+void CCScale9Sprite::updateDisplayedOpacity(GLubyte parentOpacity)
 {
-    _color = color;
+    CCNodeRGBA::updateDisplayedOpacity(parentOpacity);
+    this->updateColor();
+}
+
+CCTexture2D* CCScale9Sprite::getTexture()
+{
+    return m_pTexture;
+}
+
+void CCScale9Sprite::setTexture(CCTexture2D *texture)
+{
+    CCSize contentSize = this->m_obContentSize;
+    this->updateWithTexture(texture, m_spriteRect, m_bSpriteFrameRotated, m_capInsets);
+    this->setContentSize(contentSize);
+}
+
+void CCScale9Sprite::setBlendFunc(ccBlendFunc blendFunc)
+{
+    m_sBlendFunc = blendFunc;
+}
+
+ccBlendFunc CCScale9Sprite::getBlendFunc()
+{
+    return m_sBlendFunc;
+}
+
+//
+// CCScale9BatchNode
+//
 
-    CCObject* child;
-    CCArray* children = _scale9Image->getChildren();
-    CCARRAY_FOREACH(children, child)
+// indices of the quad of a sprite, in the order of ccV3F_C4B_T2F_Quad: tl, bl, tr, br
+static const GLushort s_pQuadIndices[6] = { 0, 1, 2, 3, 2, 1 };
+
+// whether the batch node can draw a node and all of its children
+static bool isBatchable(CCNode* pNode)
+{
+    if (dynamic_cast<CCScale9Sprite*>(pNode) == NULL && dynamic_cast<CCSprite*>(pNode) == NULL)
+    {
+        return false;
+    }
+
+    CCObject* pObj = NULL;
+    CCARRAY_FOREACH(pNode->getChildren(), pObj)
     {
-        CCRGBAProtocol* pNode = dynamic_cast<CCRGBAProtocol*>(child);
-        if (pNode)
+        if (! isBatchable((CCNode*)pObj))
         {
-            pNode->setColor(color);
+            return false;
         }
     }
+    return true;
 }
 
-void CCScale9Sprite::setOpacity(GLubyte opacity)
+CCScale9BatchNode::CCScale9BatchNode()
+: m_pTexture(NULL)
+, m_uVertexCount(0)
 {
-    _opacity = opacity;
+    m_sBlendFunc.src = CC_BLEND_SRC;
+    m_sBlendFunc.dst = CC_BLEND_DST;
+}
 
-    CCObject* child;
-    CCArray* children = _scale9Image->getChildren();
-    CCARRAY_FOREACH(children, child)
+CCScale9BatchNode::~CCScale9BatchNode()
+{
+    CC_SAFE_RELEASE(m_pTexture);
+}
+
+CCScale9BatchNode* CCScale9BatchNode::createWithTexture(CCTexture2D* texture)
+{
+    CCScale9BatchNode* pReturn = new CCScale9BatchNode();
+    if (pReturn && pReturn->initWithTexture(texture))
     {
-        CCRGBAProtocol* pNode = dynamic_cast<CCRGBAProtocol*>(child);
-        if (pNode)
+        pReturn->autorelease();
+        return pReturn;
+    }
+    CC_SAFE_DELETE(pReturn);
+    return NULL;
+}
+
+CCScale9BatchNode* CCScale9BatchNode::create(const char* file)
+{
+    CCAssert(file != NULL, "Invalid file for batch node");
+
+    CCTexture2D* texture = CCTextureCache::sharedTextureCache()->addImage(file);
+    return texture ? createWithTexture(texture) : NULL;
+}
+
+bool CCScale9BatchNode::initWithTexture(CCTexture2D* texture)
+{
+    CCAssert(texture != NULL, "CCTexture2D must be non-NULL");
+
+    this->setTexture(texture);
+    this->setShaderProgram(CCShaderCache::sharedShaderCache()->programForKey(kCCShader_PositionTextureColor));
+    return true;
+}
+
+void CCScale9BatchNode::addChild(CCNode *child)
+{
+    CCNode::addChild(child);
+}
+
+void CCScale9BatchNode::addChild(CCNode *child, int zOrder)
+{
+    CCNode::addChild(child, zOrder);
+}
+
+void CCScale9BatchNode::addChild(CCNode *child, int zOrder, int tag)
+{
+    CCAssert(isBatchable(child),
+             "CCScale9BatchNode only supports CCScale9Sprites and CCSprites as children and grandchildren");
+
+    CCNode::addChild(child, zOrder, tag);
+}
+
+void CCScale9BatchNode::visit()
+{
+    // like CCSpriteBatchNode, the children are not visited: draw() collects their vertices
+    if (! m_bVisible)
+    {
+        return;
+    }
+
+    kmGLPushMatrix();
+
+    if (m_pGrid && m_pGrid->isActive())
+    {
+        m_pGrid->beforeDraw();
+        transformAncestors();
+    }
+
+    sortAllChildren();
+    transform();
+
+    draw();
+
+    if (m_pGrid && m_pGrid->isActive())
+    {
+        m_pGrid->afterDraw(this);
+    }
+
+    kmGLPopMatrix();
+    setOrderOfArrival(0);
+}
+
+void CCScale9BatchNode::draw()
+{
+    m_uVertexCount = 0;
+    m_tVertices.clear();
+    m_tIndices.clear();
+
+    if (! m_pChildren)
+    {
+        return;
+    }
+
+    CCAffineTransform identity = CCAffineTransformMakeIdentity();
+    CCObject* pObj = NULL;
+    CCARRAY_FOREACH(m_pChildren, pObj)
+    {
+        this->appendNode((CCNode*)pObj, identity);
+    }
+
+    this->flush();
+}
+
+void CCScale9BatchNode::appendNode(CCNode* pNode, const CCAffineTransform& parentTransform)
+{
+    if (! pNode->isVisible())
+    {
+        return;
+    }
+
+    CCAffineTransform t = CCAffineTransformConcat(pNode->nodeToParentTransform(), parentTransform);
+
+    pNode->sortAllChildren();
+    CCArray* pChildren = pNode->getChildren();
+    unsigned int uCount = pChildren ? pChildren->count() : 0;
+    unsigned int i = 0;
+
+    // children with a negative z order are drawn below their parent
+    for (; i < uCount; i++)
+    {
+        CCNode* pChild = (CCNode*)pChildren->objectAtIndex(i);
+        if (pChild->getZOrder() >= 0)
+        {
+            break;
+        }
+        this->appendNode(pChild, t);
+    }
+
+    CCScale9Sprite* pScale9 = dynamic_cast<CCScale9Sprite*>(pNode);
+    if (pScale9)
+    {
+        if (pScale9->getTexture())
+        {
+            CCAssert(pScale9->getTexture()->getName() == m_pTexture->getName(),
+                     "CCScale9Sprite is not using the same texture id");
+            this->appendVertices(pScale9->getVertices(), 16, CCScale9Sprite::getIndices(), 54, t);
+        }
+    }
+    else
+    {
+        // a child added to a grandchild doesn't go through addChild(), such nodes are skipped
+        CCSprite* pSprite = dynamic_cast<CCSprite*>(pNode);
+        CCAssert(pSprite, "CCScale9BatchNode only supports CCScale9Sprites and CCSprites as children and grandchildren");
+        if (pSprite)
         {
-            pNode->setOpacity(opacity);
+            CCAssert(pSprite->getTexture()->getName() == m_pTexture->getName(),
+                     "CCSprite is not using the same texture id");
+            ccV3F_C4B_T2F_Quad quad = pSprite->getQuad();
+            this->appendVertices(&quad.tl, 4, s_pQuadIndices, 6, t);
         }
     }
+
+    for (; i < uCount; i++)
+    {
+        this->appendNode((CCNode*)pChildren->objectAtIndex(i), t);
+    }
+}
+
+void CCScale9BatchNode::appendVertices(const ccV3F_C4B_T2F* pVertices, unsigned int uVertexCount,
+                                       const GLushort* pIndices, unsigned int uIndexCount, const CCAffineTransform& transform)
+{
+    // the indices are 16 bits
+    if (m_tVertices.size() + uVertexCount > 65536)
+    {
+        this->flush();
+    }
+
+    GLushort uBase = (GLushort)m_tVertices.size();
+    for (unsigned int i = 0; i < uVertexCount; i++)
+    {
+        ccV3F_C4B_T2F vertex = pVertices[i];
+        CCPoint pt = CCPointApplyAffineTransform(ccp(vertex.vertices.x, vertex.vertices.y), transform);
+        vertex.vertices.x = pt.x;
+        vertex.vertices.y = pt.y;
+        m_tVertices.push_back(vertex);
+    }
+
+    for (unsigned int i = 0; i < uIndexCount; i++)
+    {
+        m_tIndices.push_back(uBase + pIndices[i]);
+    }
+}
+
+void CCScale9BatchNode::flush()
+{
+    if (m_tIndices.empty())
+    {
+        return;
+    }
+
+    CC_NODE_DRAW_SETUP();
+
+    ccGLBlendFunc( m_sBlendFunc.src, m_sBlendFunc.dst );
+    ccGLBindTexture2D( m_pTexture->getName() );
+    ccGLEnableVertexAttribs( kCCVertexAttribFlag_PosColorTex );
+
+    // the vertices are client arrays
+    ccGLBindBuffer(GL_ARRAY_BUFFER, 0);
+    ccGLBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+    long offset = (long)&m_tVertices[0];
+
+    // vertex
+    int diff = offsetof( ccV3F_C4B_T2F, vertices);
+    glVertexAttribPointer(kCCVertexAttrib_Position, 3, GL_FLOAT, GL_FALSE, kVertexSize, (void*) (offset + diff));
+
+    // texCoods
+    diff = offsetof( ccV3F_C4B_T2F, texCoords);
+    glVertexAttribPointer(kCCVertexAttrib_TexCoords, 2, GL_FLOAT, GL_FALSE, kVertexSize, (void*)(offset + diff));
+
+    // color
+    diff = offsetof( ccV3F_C4B_T2F, colors);
+    glVertexAttribPointer(kCCVertexAttrib_Color, 4, GL_UNSIGNED_BYTE, GL_TRUE, kVertexSize, (void*)(offset + diff));
+
+    glDrawElements(GL_TRIANGLES, (GLsizei)m_tIndices.size(), GL_UNSIGNED_SHORT, &m_tIndices[0]);
+
+    CHECK_GL_ERROR_DEBUG();
+
+    CC_INCREMENT_GL_DRAWS(1);
+
+    m_uVertexCount += m_tVertices.size();
+    m_tVertices.clear();
+    m_tIndices.clear();
+}
+
+CCTexture2D* CCScale9BatchNode::getTexture()
+{
+    return m_pTexture;
+}
+
+void CCScale9BatchNode::setTexture(CCTexture2D *texture)
+{
+    CC_SAFE_RETAIN(texture);
+    CC_SAFE_RELEASE(m_pTexture);
+    m_pTexture = texture;
+
+    if (m_pTexture && ! m_pTexture->hasPremultipliedAlpha())
+    {
+        m_sBlendFunc.src = GL_SRC_ALPHA;
+        m_sBlendFunc.dst = GL_ONE_MINUS_SRC_ALPHA;
+    }
+}
+
+void CCScale9BatchNode::setBlendFunc(ccBlendFunc blendFunc)
+{
+    m_sBlendFunc = blendFunc;
+}
+
+ccBlendFunc CCScale9BatchNode::getBlendFunc()
+{
+    return m_sBlendFunc;
 }
 
 NS_CC_EXT_END
@@ -30,6 +30,7 @@ THE SOFTWARE.
 
 #include "cocos2d.h"
 #include "ExtensionMacros.h"
+#include <vector>
 
 NS_CC_EXT_BEGIN
 
@@ -48,9 +49,14 @@ NS_CC_EXT_BEGIN
  * you can ensure that the sprite does not become distorted when
  * scaled.
  *
+ * The 9 slices are drawn as one mesh of 16 vertices and 54 indices,
+ * resizing the sprite or changing its color only updates the vertices.
+ * The 9-slice sprites and the sprites sharing a texture can be drawn
+ * in one draw call by a CCScale9BatchNode.
+ *
  * @see http://yannickloriot.com/library/ios/cccontrolextension/Classes/CCScale9Sprite.html
  */
-class CCScale9Sprite : public CCNodeRGBA
+class CCScale9Sprite : public CCNodeRGBA, public CCTextureProtocol
 {
 public:
     CCScale9Sprite();
@@ -79,37 +85,39 @@ public:
     CC_PROPERTY(float, m_insetBottom, InsetBottom);
 
 protected:
-    bool m_bSpritesGenerated;
     CCRect m_spriteRect;
     bool   m_bSpriteFrameRotated;
     CCRect m_capInsetsInternal;
     bool m_positionsAreDirty;
     
-    CCSpriteBatchNode* _scale9Image;
-    CCSprite* _topLeft;
-    CCSprite* _top;
-    CCSprite* _topRight;
-    CCSprite* _left;
-    CCSprite* _centre;
-    CCSprite* _right;
-    CCSprite* _bottomLeft;
-    CCSprite* _bottom;
-    CCSprite* _bottomRight;
+    CCTexture2D* m_pTexture;
+    ccBlendFunc m_sBlendFunc;
+    //! vertices of the 9 slices, 4 rows of 4 from the bottom left corner
+    ccV3F_C4B_T2F m_sVertices[16];
 
     bool _opacityModifyRGB;
-    GLubyte _opacity;
-    ccColor3B _color;
     
     void updateCapInset();
     void updatePositions();
+    void updateTexCoords();
+    void updateColor();
 
 public:
     
     virtual void setContentSize(const CCSize & size);
-    virtual void visit();
+    virtual void draw();
     
     virtual bool init();
 
+    /**
+     * Initializes a 9-slice sprite with a texture, the rectangle of the sprite in the
+     * texture and the cap insets.
+     *
+     * @param rotated true if the sprite is rotated in the texture, like in a sprite sheet.
+     * @since v2.1.4
+     */
+    virtual bool initWithTexture(CCTexture2D* texture, CCRect rect, bool rotated, CCRect capInsets);
+
     virtual bool initWithBatchNode(CCSpriteBatchNode* batchnode, CCRect rect, bool rotated, CCRect capInsets);
     virtual bool initWithBatchNode(CCSpriteBatchNode* batchnode, CCRect rect, CCRect capInsets);
     /**
@@ -310,9 +318,86 @@ public:
     virtual void setOpacity(GLubyte opacity);
     virtual void setColor(const ccColor3B& color);
 
+    virtual void updateDisplayedOpacity(GLubyte parentOpacity);
+    virtual void updateDisplayedColor(const ccColor3B& parentColor);
+
+    /** uses the texture of the batch node, only the texture is used */
     virtual bool updateWithBatchNode(CCSpriteBatchNode* batchnode, CCRect rect, bool rotated, CCRect capInsets);
 
+    /** changes the texture, the rectangle of the sprite in the texture and the cap insets
+     @since v2.1.4
+     */
+    virtual bool updateWithTexture(CCTexture2D* texture, CCRect rect, bool rotated, CCRect capInsets);
+
     virtual void setSpriteFrame(CCSpriteFrame * spriteFrame);
+
+    // CCTextureProtocol
+    virtual CCTexture2D* getTexture(void);
+    virtual void setTexture(CCTexture2D *texture);
+    virtual void setBlendFunc(ccBlendFunc blendFunc);
+    virtual ccBlendFunc getBlendFunc(void);
+
+    /** returns the 16 vertices of the mesh, in the coordinates of the 9-slice sprite
+     @since v2.1.4
+     */
+    const ccV3F_C4B_T2F* getVertices();
+
+    /** returns the 54 indices of the triangles of the mesh
+     @since v2.1.4
+     */
+    static const GLushort* getIndices();
+};
+
+/**
+ * CCScale9BatchNode draws its CCScale9Sprite and CCSprite childs in one draw call.
+ *
+ * The childs and their childs must be 9-slice sprites or sprites using the texture of the
+ * batch node, and their shader and blend function are not used: the batch node draws them
+ * with its own. Their vertices are transformed into the coordinates of the batch node
+ * every frame, so they can move, resize and change color freely. Other nodes are
+ * rejected by addChild() and not drawn.
+ * @since v2.1.4
+ */
+class CCScale9BatchNode : public CCNode, public CCTextureProtocol
+{
+public:
+    CCScale9BatchNode();
+    virtual ~CCScale9BatchNode();
+
+    /** creates a CCScale9BatchNode drawing with a texture */
+    static CCScale9BatchNode* createWithTexture(CCTexture2D* texture);
+
+    /** creates a CCScale9BatchNode drawing with the texture of an image file */
+    static CCScale9BatchNode* create(const char* file);
+
+    bool initWithTexture(CCTexture2D* texture);
+
+    virtual void addChild(CCNode * child);
+    virtual void addChild(CCNode * child, int zOrder);
+    virtual void addChild(CCNode * child, int zOrder, int tag);
+    virtual void visit();
+    virtual void draw();
+
+    // CCTextureProtocol
+    virtual CCTexture2D* getTexture(void);
+    virtual void setTexture(CCTexture2D *texture);
+    virtual void setBlendFunc(ccBlendFunc blendFunc);
+    virtual ccBlendFunc getBlendFunc(void);
+
+    /** number of vertices drawn in the last frame */
+    inline unsigned int getVertexCount() { return m_uVertexCount; }
+
+private:
+    void appendNode(CCNode* pNode, const CCAffineTransform& parentTransform);
+    void appendVertices(const ccV3F_C4B_T2F* pVertices, unsigned int uVertexCount,
+                        const GLushort* pIndices, unsigned int uIndexCount, const CCAffineTransform& transform);
+    void flush();
+
+    CCTexture2D* m_pTexture;
+    ccBlendFunc m_sBlendFunc;
+    std::vector<ccV3F_C4B_T2F> m_tVertices;
+    std::vector<GLushort> m_tIndices;
+    unsigned int m_uVertexCount;
 };
 
 // end of GUI group
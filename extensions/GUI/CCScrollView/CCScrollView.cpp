@@ -494,24 +494,9 @@ void CCScrollView::beforeDraw()
 {
     if (m_bClippingToBounds)
     {
-		m_bScissorRestored = false;
-        CCRect frame = getViewRect();
-        if (CCEGLView::sharedOpenGLView()->isScissorEnabled()) {
-            m_bScissorRestored = true;
-            m_tParentScissorRect = CCEGLView::sharedOpenGLView()->getScissorRect();
-            //set the intersection of m_tParentScissorRect and frame as the new scissor rect
-            if (frame.intersectsRect(m_tParentScissorRect)) {
-                float x = MAX(frame.origin.x, m_tParentScissorRect.origin.x);
-                float y = MAX(frame.origin.y, m_tParentScissorRect.origin.y);
-                float xx = MIN(frame.origin.x+frame.size.width, m_tParentScissorRect.origin.x+m_tParentScissorRect.size.width);
-                float yy = MIN(frame.origin.y+frame.size.height, m_tParentScissorRect.origin.y+m_tParentScissorRect.size.height);
-                CCEGLView::sharedOpenGLView()->setScissorInPoints(x, y, xx-x, yy-y);
-            }
-        }
-        else {
-            glEnable(GL_SCISSOR_TEST);
-            CCEGLView::sharedOpenGLView()->setScissorInPoints(frame.origin.x, frame.origin.y, frame.size.width, frame.size.height);
-        }
+        // the view rectangle is intersected with the enclosing clips, with the scissor test
+        // unless the scroll view is rotated on the screen
+        ccClipPushRect(CCRectMake(0, 0, m_tViewSize.width, m_tViewSize.height));
     }
 }
 
@@ -523,12 +508,7 @@ void CCScrollView::afterDraw()
 {
     if (m_bClippingToBounds)
     {
-        if (m_bScissorRestored) {//restore the parent's scissor rect
-            CCEGLView::sharedOpenGLView()->setScissorInPoints(m_tParentScissorRect.origin.x, m_tParentScissorRect.origin.y, m_tParentScissorRect.size.width, m_tParentScissorRect.size.height);
-        }
-        else {
-            glDisable(GL_SCISSOR_TEST);
-        }
+        ccClipPop();
     }
 }
 
@@ -551,7 +531,11 @@ void CCScrollView::visit()
 	this->transform();
     this->beforeDraw();
 
-	if(m_pChildren)
+    if (m_bClippingToBounds && ccClipIsEmpty())
+    {
+        // nothing can be drawn out of the clip
+    }
+	else if(m_pChildren)
     {
 		ccArray *arrayData = m_pChildren->data;
 		unsigned int i=0;
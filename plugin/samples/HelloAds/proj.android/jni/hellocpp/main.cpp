@@ -1,6 +1,5 @@
 #include "AppDelegate.h"
 #include "cocos2d.h"
-#include "CCEventType.h"
 #include "platform/android/jni/JniHelper.h"
 #include <jni.h>
 #include <android/log.h>
@@ -33,13 +32,7 @@ void Java_org_cocos2dx_lib_Cocos2dxRenderer_nativeInit(JNIEnv*  env, jobject thi
     }
     else
     {
-        ccDrawInit();
-        ccGLInvalidateStateCache();
-          
-        CCShaderCache::sharedShaderCache()->reloadDefaultShaders();
-        CCTextureCache::reloadAllTextures();
-        CCNotificationCenter::sharedNotificationCenter()->postNotification(EVNET_COME_TO_FOREGROUND, NULL);
-        CCDirector::sharedDirector()->setGLDefaultValues(); 
+        CCDirector::sharedDirector()->restoreGLContext();
     }
 }
 
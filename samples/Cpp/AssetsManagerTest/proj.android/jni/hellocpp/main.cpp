@@ -31,13 +31,7 @@ void Java_org_cocos2dx_lib_Cocos2dxRenderer_nativeInit(JNIEnv*  env, jobject thi
     /*
     else
     {
-        ccDrawInit();
-        ccGLInvalidateStateCache();
-        
-        CCShaderCache::sharedShaderCache()->reloadDefaultShaders();
-        CCTextureCache::reloadAllTextures();
-        CCNotificationCenter::sharedNotificationCenter()->postNotification(EVNET_COME_TO_FOREGROUND, NULL);
-        CCDirector::sharedDirector()->setGLDefaultValues(); 
+        CCDirector::sharedDirector()->restoreGLContext();
     }
     */
 }
@@ -75,6 +75,8 @@ Classes/PerformanceTest/PerformanceParticleTest.cpp \
 Classes/PerformanceTest/PerformanceSpriteTest.cpp \
 Classes/PerformanceTest/PerformanceTest.cpp \
 Classes/PerformanceTest/PerformanceTextureTest.cpp \
+Classes/PerformanceTest/PerformanceLoadingTest.cpp \
+Classes/PerformanceTest/PerformanceGridTest.cpp \
 Classes/PerformanceTest/PerformanceTouchesTest.cpp \
 Classes/RenderTextureTest/RenderTextureTest.cpp \
 Classes/RotateWorldTest/RotateWorldTest.cpp \
@@ -3,7 +3,7 @@
 
 static int sceneIdx = -1; 
 
-#define MAX_LAYER    7
+#define MAX_LAYER    8
 
 CCLayer* nextAction();
 CCLayer* backAction();
@@ -20,6 +20,7 @@ CCLayer* createLayer(int nIndex)
         case 4: return new SpriteProgressBarVarious();
         case 5: return new SpriteProgressBarTintAndFade();
         case 6: return new SpriteProgressWithSpriteFrame();
+        case 7: return new SpriteProgressBatchAndShader();
     }
 
     return NULL;
@@ -473,3 +474,51 @@ std::string SpriteProgressWithSpriteFrame::subtitle()
 {
     return "Progress With Sprite Frame";
 }
+
+//------------------------------------------------------------------
+//
+// SpriteProgressBatchAndShader
+//
+//------------------------------------------------------------------
+void SpriteProgressBatchAndShader::onEnter()
+{
+    SpriteDemo::onEnter();
+
+    CCSize s = CCDirector::sharedDirector()->getWinSize();
+
+    // radial and bar timers sharing a texture, drawn in one batch
+    CCProgressTimerBatchNode *batch = CCProgressTimerBatchNode::create(s_pPathBlock);
+    addChild(batch);
+
+    for (int i = 0; i < 12; i++)
+    {
+        CCProgressTimer *timer = CCProgressTimer::create(CCSprite::create(s_pPathBlock, CCRectMake(32 * (i % 2), 32 * (i / 2 % 2), 32, 32)));
+        timer->setType(i < 8 ? kCCProgressTimerTypeRadial : kCCProgressTimerTypeBar);
+        timer->setReverseProgress(i % 2 == 1);
+        timer->setMidpoint(ccp(0, 0.5f));
+        timer->setBarChangeRate(ccp(1, 0));
+        timer->setPosition(ccp(40 + (i % 6) * 44, s.height/2 + 24 - (i / 6) * 48));
+        batch->addChild(timer);
+        timer->runAction(CCRepeatForever::create(CCProgressFromTo::create(1 + i * 0.25f, 0, 100)));
+    }
+
+    // the shader clips the quad, the percentage is a uniform
+    CCProgressTimer *left = CCProgressTimer::create(CCSprite::create(s_pPathSister1));
+    left->setRadialShaderMode(true);
+    addChild(left);
+    left->setPosition(ccp(s.width - 150, s.height/2));
+    left->runAction(CCRepeatForever::create(CCProgressTo::create(2, 100)));
+
+    CCProgressTimer *right = CCProgressTimer::create(CCSprite::create(s_pPathSister1));
+    right->setRadialShaderMode(true);
+    right->setReverseProgress(true);
+    right->setMidpoint(ccp(0.3f, 0.7f));
+    addChild(right);
+    right->setPosition(ccp(s.width - 60, s.height/2));
+    right->runAction(CCRepeatForever::create(CCProgressTo::create(2, 100)));
+}
+
+std::string SpriteProgressBatchAndShader::subtitle()
+{
+    return "Batched timers (left), shader radial (right)";
+}
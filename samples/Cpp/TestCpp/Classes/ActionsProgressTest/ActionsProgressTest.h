@@ -67,6 +67,13 @@ public:
     virtual std::string subtitle();
 };
 
+class SpriteProgressBatchAndShader : public SpriteDemo
+{
+public:
+    virtual void onEnter();
+    virtual std::string subtitle();
+};
+
 class ProgressActionsTestScene : public TestScene
 {
 public:
@@ -24,6 +24,7 @@ TESTLAYER_CREATE_FUNC(SpriteTest);
 TESTLAYER_CREATE_FUNC(SpriteNoAlphaTest);
 TESTLAYER_CREATE_FUNC(SpriteInvertedTest);
 TESTLAYER_CREATE_FUNC(NestedTest);
+TESTLAYER_CREATE_FUNC(ScissorClipTest);
 TESTLAYER_CREATE_FUNC(RawStencilBufferTest);
 TESTLAYER_CREATE_FUNC(RawStencilBufferTest2);
 TESTLAYER_CREATE_FUNC(RawStencilBufferTest3);
@@ -40,6 +41,7 @@ static NEWTESTFUNC createFunctions[] = {
     CF(SpriteNoAlphaTest),
     CF(SpriteInvertedTest),
     CF(NestedTest),
+    CF(ScissorClipTest),
     CF(RawStencilBufferTest),
     CF(RawStencilBufferTest2),
     CF(RawStencilBufferTest3),
@@ -383,7 +385,7 @@ std::string NestedTest::title()
 
 std::string NestedTest::subtitle()
 {
-	return "Nest 9 Clipping Nodes, max is usually 8";
+	return "Nest 9 Clipping Nodes";
 }
 
 void NestedTest::setup()
@@ -419,6 +421,92 @@ void NestedTest::setup()
 
 }
 
+//#pragma mark - ScissorClipTest
+
+std::string ScissorClipTest::title()
+{
+	return "Scissor Clip Test";
+}
+
+std::string ScissorClipTest::subtitle()
+{
+	return "Rectangles use the scissor test, the stencil only while rotated";
+}
+
+void ScissorClipTest::setup()
+{
+    CCSize s = this->getContentSize();
+    
+    // clipping rectangle, moving without rotation most of the time
+    CCClippingNode *outer = CCClippingNode::create();
+    outer->setContentSize(CCSizeMake(280, 180));
+    outer->setClippingRect(CCRectMake(0, 0, 280, 180));
+    outer->setAnchorPoint(ccp(0.5, 0.5));
+    outer->setPosition(ccp(s.width / 2, s.height / 2));
+    outer->runAction(CCRepeatForever::create(CCSequence::create(
+        CCMoveBy::create(2, ccp(40, 0)),
+        CCRotateBy::create(1, 30),
+        CCDelayTime::create(2),
+        CCRotateBy::create(1, -30),
+        CCMoveBy::create(2, ccp(-40, 0)),
+        NULL)));
+    this->addChild(outer);
+    
+    CCSprite *background = CCSprite::create(s_back2);
+    background->setPosition(ccp(140, 90));
+    background->runAction(CCRepeatForever::create(CCSequence::createWithTwoActions(
+        CCMoveBy::create(3, ccp(0, 60)), CCMoveBy::create(3, ccp(0, -60)))));
+    outer->addChild(background);
+    
+    // a color layer stencil is a rectangle too
+    CCLayerColor *stencil = CCLayerColor::create(ccc4(255, 255, 255, 255), 200, 120);
+    stencil->setPosition(ccp(40, 30));
+    CCClippingNode *inner = CCClippingNode::create(stencil);
+    inner->setContentSize(CCSizeMake(280, 180));
+    outer->addChild(inner);
+    
+    // scroll views nested in the clipping nodes intersect their scissor rectangle
+    for (int i = 0; i < 2; i++)
+    {
+        CCLayer *container = CCLayer::create();
+        container->setContentSize(CCSizeMake(160, 400));
+        for (int j = 0; j < 8; j++)
+        {
+            CCSprite *grossini = CCSprite::create(s_pPathGrossini);
+            grossini->setScale(0.5f);
+            grossini->setPosition(ccp(40 + (j % 2) * 80, 25 + j * 50));
+            container->addChild(grossini);
+        }
+        
+        CCScrollView *scrollView = CCScrollView::create(CCSizeMake(80, 100), container);
+        scrollView->setDirection(kCCScrollViewDirectionVertical);
+        scrollView->setPosition(ccp(20 + i * 180, 40));
+        container->runAction(CCRepeatForever::create(CCSequence::createWithTwoActions(
+            CCMoveBy::create(4, ccp(0, -300)), CCMoveBy::create(4, ccp(0, 300)))));
+        inner->addChild(scrollView);
+    }
+    
+    m_pStatsLabel = CCLabelTTF::create("", "Arial", 16);
+    m_pStatsLabel->setPosition(ccp(s.width / 2, s.height / 2 - 120));
+    this->addChild(m_pStatsLabel);
+    
+    ccClipGetStats(&m_uScissorClips, &m_uStencilClips);
+    this->schedule(schedule_selector(ScissorClipTest::updateStats), 1.0f);
+}
+
+void ScissorClipTest::updateStats(float dt)
+{
+    unsigned int uScissorClips, uStencilClips;
+    ccClipGetStats(&uScissorClips, &uStencilClips);
+    
+    char text[80];
+    sprintf(text, "scissor clips: %.0f/s, stencil clips: %.0f/s", (uScissorClips - m_uScissorClips) / dt, (uStencilClips - m_uStencilClips) / dt);
+    m_pStatsLabel->setString(text);
+    
+    m_uScissorClips = uScissorClips;
+    m_uStencilClips = uStencilClips;
+}
+
 //#pragma mark - HoleDemo
 
 HoleDemo::~HoleDemo()
@@ -638,7 +726,7 @@ void RawStencilBufferTest::draw()
     
     CCPoint planeSize = ccpMult(winPoint, 1.0 / _planeCount);
     
-    glEnable(GL_STENCIL_TEST);
+    ccGLSetCapability(GL_STENCIL_TEST, true);
     CHECK_GL_ERROR_DEBUG();
         
     for (int i = 0; i < _planeCount; i++) {
@@ -672,27 +760,27 @@ void RawStencilBufferTest::draw()
         kmGLPopMatrix();
     }
     
-    glDisable(GL_STENCIL_TEST);
+    ccGLSetCapability(GL_STENCIL_TEST, false);
     CHECK_GL_ERROR_DEBUG();
 }
 
 void RawStencilBufferTest::setupStencilForClippingOnPlane(GLint plane)
 {
     GLint planeMask = 0x1 << plane;
-    glStencilMask(planeMask);
+    ccGLStencilMask(planeMask);
     glClearStencil(0x0);
     glClear(GL_STENCIL_BUFFER_BIT);
     glFlush();
-    glStencilFunc(GL_NEVER, planeMask, planeMask);
-    glStencilOp(GL_REPLACE, GL_KEEP, GL_KEEP);
+    ccGLStencilFunc(GL_NEVER, planeMask, planeMask);
+    ccGLStencilOp(GL_REPLACE, GL_KEEP, GL_KEEP);
 }
 
 void RawStencilBufferTest::setupStencilForDrawingOnPlane(GLint plane)
 {
     GLint planeMask = 0x1 << plane;
     GLint equalOrLessPlanesMask = planeMask | (planeMask - 1);
-    glStencilFunc(GL_EQUAL, equalOrLessPlanesMask, equalOrLessPlanesMask);
-    glStencilOp(GL_KEEP, GL_KEEP, GL_KEEP);
+    ccGLStencilFunc(GL_EQUAL, equalOrLessPlanesMask, equalOrLessPlanesMask);
+    ccGLStencilOp(GL_KEEP, GL_KEEP, GL_KEEP);
 }
 
 //@implementation RawStencilBufferTest2
@@ -705,12 +793,12 @@ std::string RawStencilBufferTest2::subtitle()
 void RawStencilBufferTest2::setupStencilForClippingOnPlane(GLint plane)
 {
     RawStencilBufferTest::setupStencilForClippingOnPlane(plane);
-    glDepthMask(GL_FALSE);
+    ccGLDepthMask(GL_FALSE);
 }
 
 void RawStencilBufferTest2::setupStencilForDrawingOnPlane(GLint plane)
 {
-    glDepthMask(GL_TRUE);
+    ccGLDepthMask(GL_TRUE);
     RawStencilBufferTest::setupStencilForDrawingOnPlane(plane);
 }
 
@@ -724,13 +812,13 @@ std::string RawStencilBufferTest3::subtitle()
 void RawStencilBufferTest3::setupStencilForClippingOnPlane(GLint plane)
 {
     RawStencilBufferTest::setupStencilForClippingOnPlane(plane);
-    glDisable(GL_DEPTH_TEST);
-    glDepthMask(GL_FALSE);
+    ccGLSetCapability(GL_DEPTH_TEST, false);
+    ccGLDepthMask(GL_FALSE);
 }
 
 void RawStencilBufferTest3::setupStencilForDrawingOnPlane(GLint plane)
 {
-    glDepthMask(GL_TRUE);
+    ccGLDepthMask(GL_TRUE);
     //glEnable(GL_DEPTH_TEST);
     RawStencilBufferTest::setupStencilForDrawingOnPlane(plane);
 }
@@ -745,7 +833,7 @@ std::string RawStencilBufferTest4::subtitle()
 void RawStencilBufferTest4::setupStencilForClippingOnPlane(GLint plane)
 {
     RawStencilBufferTest::setupStencilForClippingOnPlane(plane);
-    glDepthMask(GL_FALSE);
+    ccGLDepthMask(GL_FALSE);
 
 #if (CC_TARGET_PLATFORM == CC_PLATFORM_WIN32) || (CC_TARGET_PLATFORM == CC_PLATFORM_LINUX) || (CC_TARGET_PLATFORM == CC_PLATFORM_MAC)
     glEnable(GL_ALPHA_TEST);
@@ -763,7 +851,7 @@ void RawStencilBufferTest4::setupStencilForDrawingOnPlane(GLint plane)
 #if (CC_TARGET_PLATFORM == CC_PLATFORM_WIN32) || (CC_TARGET_PLATFORM == CC_PLATFORM_LINUX) || (CC_TARGET_PLATFORM == CC_PLATFORM_MAC)
     glDisable(GL_ALPHA_TEST);
 #endif
-    glDepthMask(GL_TRUE);
+    ccGLDepthMask(GL_TRUE);
     RawStencilBufferTest::setupStencilForDrawingOnPlane(plane);
 }
 
@@ -777,8 +865,8 @@ std::string RawStencilBufferTest5::subtitle()
 void RawStencilBufferTest5::setupStencilForClippingOnPlane(GLint plane)
 {
     RawStencilBufferTest::setupStencilForClippingOnPlane(plane);
-    glDisable(GL_DEPTH_TEST);
-    glDepthMask(GL_FALSE);
+    ccGLSetCapability(GL_DEPTH_TEST, false);
+    ccGLDepthMask(GL_FALSE);
 
 #if (CC_TARGET_PLATFORM == CC_PLATFORM_WIN32) || (CC_TARGET_PLATFORM == CC_PLATFORM_LINUX) || (CC_TARGET_PLATFORM == CC_PLATFORM_MAC)
     glEnable(GL_ALPHA_TEST);
@@ -796,7 +884,7 @@ void RawStencilBufferTest5::setupStencilForDrawingOnPlane(GLint plane)
 #if (CC_TARGET_PLATFORM == CC_PLATFORM_WIN32) || (CC_TARGET_PLATFORM == CC_PLATFORM_LINUX) || (CC_TARGET_PLATFORM == CC_PLATFORM_MAC)
     glDisable(GL_ALPHA_TEST);
 #endif
-    glDepthMask(GL_TRUE);
+    ccGLDepthMask(GL_TRUE);
     //glEnable(GL_DEPTH_TEST);
     RawStencilBufferTest::setupStencilForDrawingOnPlane(plane);
 }
@@ -813,7 +901,7 @@ void RawStencilBufferTest6::setup()
 #if (CC_TARGET_PLATFORM == CC_PLATFORM_WIN32) || (CC_TARGET_PLATFORM == CC_PLATFORM_LINUX) || (CC_TARGET_PLATFORM == CC_PLATFORM_MAC)
     CCPoint winPoint = ccpFromSize(CCDirector::sharedDirector()->getWinSize());
     unsigned char bits = 0;
-    glStencilMask(~0);
+    ccGLStencilMask(~0);
     glClearStencil(0);
     glClear(GL_STENCIL_BUFFER_BIT);
     glFlush();
@@ -821,7 +909,7 @@ void RawStencilBufferTest6::setup()
     CCLabelTTF *clearToZeroLabel = CCLabelTTF::create(CCString::createWithFormat("00=%02x", bits)->getCString(), "Arial", 20);
     clearToZeroLabel->setPosition( ccp((winPoint.x / 3) * 1, winPoint.y - 10) );
     this->addChild(clearToZeroLabel);
-    glStencilMask(0x0F);
+    ccGLStencilMask(0x0F);
     glClearStencil(0xAA);
     glClear(GL_STENCIL_BUFFER_BIT);
     glFlush();
@@ -830,21 +918,21 @@ void RawStencilBufferTest6::setup()
     clearToMaskLabel->setPosition( ccp((winPoint.x / 3) * 2, winPoint.y - 10) );
     this->addChild(clearToMaskLabel);
 #endif
-    glStencilMask(~0);
+    ccGLStencilMask(~0);
     RawStencilBufferTest::setup();
 }
 
 void RawStencilBufferTest6::setupStencilForClippingOnPlane(GLint plane)
 {
     GLint planeMask = 0x1 << plane;
-    glStencilMask(planeMask);
-    glStencilFunc(GL_NEVER, 0, planeMask);
-    glStencilOp(GL_REPLACE, GL_KEEP, GL_KEEP);
+    ccGLStencilMask(planeMask);
+    ccGLStencilFunc(GL_NEVER, 0, planeMask);
+    ccGLStencilOp(GL_REPLACE, GL_KEEP, GL_KEEP);
     ccDrawSolidRect(CCPointZero, ccpFromSize(CCDirector::sharedDirector()->getWinSize()), ccc4f(1, 1, 1, 1));
-    glStencilFunc(GL_NEVER, planeMask, planeMask);
-    glStencilOp(GL_REPLACE, GL_KEEP, GL_KEEP);
-    glDisable(GL_DEPTH_TEST);
-    glDepthMask(GL_FALSE);
+    ccGLStencilFunc(GL_NEVER, planeMask, planeMask);
+    ccGLStencilOp(GL_REPLACE, GL_KEEP, GL_KEEP);
+    ccGLSetCapability(GL_DEPTH_TEST, false);
+    ccGLDepthMask(GL_FALSE);
 #if (CC_TARGET_PLATFORM == CC_PLATFORM_WIN32) || (CC_TARGET_PLATFORM == CC_PLATFORM_LINUX) || (CC_TARGET_PLATFORM == CC_PLATFORM_MAC)
     glEnable(GL_ALPHA_TEST);
     glAlphaFunc(GL_GREATER, _alphaThreshold);
@@ -862,7 +950,7 @@ void RawStencilBufferTest6::setupStencilForDrawingOnPlane(GLint plane)
 #if (CC_TARGET_PLATFORM == CC_PLATFORM_WIN32) || (CC_TARGET_PLATFORM == CC_PLATFORM_LINUX) || (CC_TARGET_PLATFORM == CC_PLATFORM_MAC)
     glDisable(GL_ALPHA_TEST);
 #endif
-    glDepthMask(GL_TRUE);
+    ccGLDepthMask(GL_TRUE);
     //glEnable(GL_DEPTH_TEST);
     RawStencilBufferTest::setupStencilForDrawingOnPlane(plane);
     glFlush();
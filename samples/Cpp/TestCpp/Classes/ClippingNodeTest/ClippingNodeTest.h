@@ -2,6 +2,9 @@
 #define __CLIPPINGNODETEST_H__
 
 #include "../testBasic.h"
+#include "cocos-ext.h"
+
+USING_NS_CC_EXT;
 
 class BaseClippingNodeTest : public CCLayer
 {
@@ -89,6 +92,19 @@ public:
     virtual void setup();
 };
 
+class ScissorClipTest : public BaseClippingNodeTest
+{
+public:
+    virtual std::string title();
+    virtual std::string subtitle();
+    virtual void setup();
+    void updateStats(float dt);
+private:
+    CCLabelTTF *m_pStatsLabel;
+    unsigned int m_uScissorClips;
+    unsigned int m_uStencilClips;
+};
+
 class HoleDemo : public BaseClippingNodeTest
 {
 public:
@@ -16,11 +16,15 @@ static CCLayer* create##className() \
 
 DRAWPRIMITIVES_CREATE_FUNC(DrawPrimitivesTest);
 DRAWPRIMITIVES_CREATE_FUNC(DrawNodeTest);
+DRAWPRIMITIVES_CREATE_FUNC(DrawPrimitivesBatchTest);
+DRAWPRIMITIVES_CREATE_FUNC(DrawNodeShapesTest);
 
 static NEWDRAWPRIMITIVESFUNC createFunctions[] =
 {
     createDrawPrimitivesTest,
     createDrawNodeTest,
+    createDrawPrimitivesBatchTest,
+    createDrawNodeShapesTest,
 };
 
 #define MAX_LAYER    (sizeof(createFunctions) / sizeof(createFunctions[0]))
@@ -317,6 +321,150 @@ string DrawNodeTest::subtitle()
     return "Testing DrawNode - batched draws. Concave polygons are BROKEN";
 }
 
+// DrawPrimitivesBatchTest
+DrawPrimitivesBatchTest::DrawPrimitivesBatchTest()
+: m_bBatched(false)
+{
+    m_pStatsLabel = CCLabelTTF::create("", "Arial", 16);
+    m_pStatsLabel->setPosition(ccp(VisibleRect::center().x, VisibleRect::bottom().y + 30));
+    addChild(m_pStatsLabel, 10);
+
+    schedule(schedule_selector(DrawPrimitivesBatchTest::toggleBatch), 1.0f);
+}
+
+void DrawPrimitivesBatchTest::toggleBatch(float dt)
+{
+    m_bBatched = !m_bBatched;
+}
+
+void DrawPrimitivesBatchTest::draw()
+{
+    CHECK_GL_ERROR_DEBUG();
+
+    ccDrawResetStats();
+
+    if (m_bBatched)
+    {
+        ccDrawBeginBatch();
+    }
+
+    // 20 x 12 cells, each with a rectangle, a line, a circle, a solid poly and a bezier path
+    CCPoint origin = VisibleRect::leftBottom();
+    CCSize size = CCSizeMake(VisibleRect::getVisibleRect().size.width / 20, VisibleRect::getVisibleRect().size.height / 12);
+    for (int y = 0; y < 12; y++)
+    {
+        for (int x = 0; x < 20; x++)
+        {
+            CCPoint p = ccp(origin.x + x * size.width, origin.y + y * size.height);
+            CCPoint q = ccp(p.x + size.width, p.y + size.height);
+            CCPoint center = ccp((p.x + q.x) / 2, (p.y + q.y) / 2);
+
+            ccLineWidth(1);
+            ccDrawColor4B(255, 255, 255, 255);
+            ccDrawRect(p, q);
+
+            ccLineWidth(2);
+            ccDrawColor4B(x * 12, y * 20, 255, 255);
+            ccDrawLine(p, q);
+            ccDrawCircle(center, size.height / 3, 0, 12, false);
+
+            ccDrawSolidRect(ccp(center.x - 3, center.y - 3), ccp(center.x + 3, center.y + 3), ccc4f(1, 0, 0, 1));
+
+            ccDrawColor4B(255, 255, 0, 255);
+            ccDrawQuadBezier(ccp(p.x, q.y), center, q, 8);
+        }
+    }
+
+    if (m_bBatched)
+    {
+        ccDrawEndBatch();
+    }
+
+    // restore original values
+    ccLineWidth(1);
+    ccDrawColor4B(255,255,255,255);
+
+    unsigned int primitives = 0, drawCalls = 0;
+    ccDrawGetStats(&primitives, &drawCalls);
+
+    char stats[100] = {0};
+    sprintf(stats, "%s: %u primitives, %u draw calls", m_bBatched ? "batched" : "immediate", primitives, drawCalls);
+    m_pStatsLabel->setString(stats);
+
+    CHECK_GL_ERROR_DEBUG();
+}
+
+string DrawPrimitivesBatchTest::title()
+{
+    return "draw primitives batch";
+}
+
+string DrawPrimitivesBatchTest::subtitle()
+{
+    return "Switches between immediate and batched draws every second";
+}
+
+// DrawNodeShapesTest
+static CCPoint trailPointAt(float t)
+{
+    CCPoint center = VisibleRect::center();
+    return ccp(center.x + 180 * sinf(t * 1.3f), center.y + 100 * sinf(t * 2.1f));
+}
+
+DrawNodeShapesTest::DrawNodeShapesTest()
+: m_fTime(0)
+, m_uFrames(0)
+, m_uUploadedBytes(0)
+{
+    m_pDrawNode = CCDrawNode::create();
+    addChild(m_pDrawNode, 10);
+
+    m_tLastPoint = trailPointAt(0);
+    m_uHead = m_pDrawNode->addDot(m_tLastPoint, 8, ccc4f(1, 1, 0, 1));
+
+    m_pStatsLabel = CCLabelTTF::create("", "Arial", 16);
+    m_pStatsLabel->setPosition(ccp(VisibleRect::center().x, VisibleRect::bottom().y + 30));
+    addChild(m_pStatsLabel, 20);
+
+    scheduleUpdate();
+}
+
+void DrawNodeShapesTest::update(float dt)
+{
+    m_fTime += dt;
+    CCPoint point = trailPointAt(m_fTime);
+
+    // one segment more, the oldest one less, and the head moved without being tessellated again
+    float hue = fmodf(m_fTime, 3) / 3;
+    m_tTrail.push_back(m_pDrawNode->addSegment(m_tLastPoint, point, 3, ccc4f(hue, 1 - hue, 1, 1)));
+    if (m_tTrail.size() > 300)
+    {
+        m_pDrawNode->removeShape(m_tTrail.front());
+        m_tTrail.erase(m_tTrail.begin());
+    }
+    m_pDrawNode->moveShape(m_uHead, ccpSub(point, m_tLastPoint));
+    m_tLastPoint = point;
+
+    // bytes uploaded by the frames drawn so far
+    if (++m_uFrames % 30 == 0)
+    {
+        char stats[100] = {0};
+        sprintf(stats, "%u shapes, %u bytes uploaded per frame", m_pDrawNode->getShapeCount(), (m_pDrawNode->getUploadedBytes() - m_uUploadedBytes) / 30);
+        m_pStatsLabel->setString(stats);
+        m_uUploadedBytes = m_pDrawNode->getUploadedBytes();
+    }
+}
+
+string DrawNodeShapesTest::title()
+{
+    return "CCDrawNode shapes";
+}
+
+string DrawNodeShapesTest::subtitle()
+{
+    return "A segment is added and one removed each frame, only they are uploaded";
+}
+
 void DrawPrimitivesTestScene::runThisTest()
 {
     CCLayer* pLayer = nextAction();
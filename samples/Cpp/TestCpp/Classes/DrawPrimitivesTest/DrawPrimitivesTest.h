@@ -38,6 +38,43 @@ public:
     virtual std::string subtitle();
 };
 
+class DrawPrimitivesBatchTest : public BaseLayer
+{
+public:
+    DrawPrimitivesBatchTest();
+    
+    virtual std::string title();
+    virtual std::string subtitle();
+    virtual void draw();
+
+    void toggleBatch(float dt);
+
+private:
+    bool m_bBatched;
+    CCLabelTTF *m_pStatsLabel;
+};
+
+class DrawNodeShapesTest : public BaseLayer
+{
+public:
+    DrawNodeShapesTest();
+    
+    virtual std::string title();
+    virtual std::string subtitle();
+
+    void update(float dt);
+
+private:
+    CCDrawNode *m_pDrawNode;
+    CCLabelTTF *m_pStatsLabel;
+    std::vector<unsigned int> m_tTrail;
+    unsigned int m_uHead;
+    float m_fTime;
+    CCPoint m_tLastPoint;
+    unsigned int m_uFrames;
+    unsigned int m_uUploadedBytes;
+};
+
 class DrawPrimitivesTestScene : public TestScene
 {
 public:
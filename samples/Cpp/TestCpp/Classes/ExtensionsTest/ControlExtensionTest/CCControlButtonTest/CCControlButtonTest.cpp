@@ -257,3 +257,98 @@ CCControlButton *CCControlButtonTest_Styling::standardButtonWithTitle(const char
     return button;
 }
 
+
+//CCControlButtonTest_Scale9Batch
+
+#define kScale9BatchColumns 10
+#define kScale9BatchRows    6
+
+CCControlButtonTest_Scale9Batch::CCControlButtonTest_Scale9Batch()
+: m_pPanels(NULL)
+, m_pDisplayValueLabel(NULL)
+, m_bBatched(true)
+, m_fTime(0)
+{
+}
+
+bool CCControlButtonTest_Scale9Batch::init()
+{
+    if (CCControlScene::init())
+    {
+        CCSize screenSize = CCDirector::sharedDirector()->getWinSize();
+
+        m_pDisplayValueLabel = CCLabelTTF::create("", "Marker Felt", 20);
+        m_pDisplayValueLabel->setPosition(ccp(screenSize.width / 2.0f, screenSize.height - 70));
+        addChild(m_pDisplayValueLabel, 2);
+
+        CCMenuItemFont *item = CCMenuItemFont::create("Toggle batching", this, menu_selector(CCControlButtonTest_Scale9Batch::toggleBatchAction));
+        item->setFontSizeObj(20);
+        CCMenu *menu = CCMenu::create(item, NULL);
+        menu->setPosition(ccp(screenSize.width / 2.0f, 50));
+        addChild(menu, 2);
+
+        createPanels();
+        scheduleUpdate();
+        return true;
+    }
+    return false;
+}
+
+void CCControlButtonTest_Scale9Batch::createPanels()
+{
+    if (m_pPanels)
+    {
+        m_pPanels->removeFromParentAndCleanup(true);
+    }
+
+    // The batch node draws all the panels in one draw call, look at the draw calls in the stats
+    if (m_bBatched)
+    {
+        m_pPanels = CCScale9BatchNode::create("extensions/button.png");
+    }
+    else
+    {
+        m_pPanels = CCNode::create();
+    }
+    addChild(m_pPanels, 1);
+
+    CCSize screenSize = CCDirector::sharedDirector()->getWinSize();
+    float w = screenSize.width / kScale9BatchColumns;
+    float h = (screenSize.height - 160) / kScale9BatchRows;
+    for (int i = 0; i < kScale9BatchColumns; i++)
+    {
+        for (int j = 0; j < kScale9BatchRows; j++)
+        {
+            CCScale9Sprite *panel = CCScale9Sprite::create("extensions/button.png");
+            panel->setPosition(ccp(w * (i + 0.5f), 80 + h * (j + 0.5f)));
+            panel->setColor(ccc3(rand() % 128 + 128, rand() % 128 + 128, rand() % 128 + 128));
+            m_pPanels->addChild(panel);
+        }
+    }
+
+    m_pDisplayValueLabel->setString(CCString::createWithFormat("%d panels, %s", kScale9BatchColumns * kScale9BatchRows,
+                                                               m_bBatched ? "in a CCScale9BatchNode" : "not batched")->getCString());
+}
+
+void CCControlButtonTest_Scale9Batch::update(float dt)
+{
+    m_fTime += dt;
+
+    // Resizing only updates the vertices of the panels
+    CCSize screenSize = CCDirector::sharedDirector()->getWinSize();
+    float w = screenSize.width / kScale9BatchColumns;
+    float h = (screenSize.height - 160) / kScale9BatchRows;
+    CCObject *pObj = NULL;
+    int i = 0;
+    CCARRAY_FOREACH(m_pPanels->getChildren(), pObj)
+    {
+        float s = 0.6f + 0.3f * sinf(m_fTime * 2 + i++ * 0.5f);
+        ((CCScale9Sprite *)pObj)->setContentSize(CCSizeMake(w * s, h * s));
+    }
+}
+
+void CCControlButtonTest_Scale9Batch::toggleBatchAction(CCObject *sender)
+{
+    m_bBatched = !m_bBatched;
+    createPanels();
+}
@@ -68,5 +68,22 @@ public:
     CONTROL_SCENE_CREATE_FUNC(CCControlButtonTest_Styling)
 };
 
+class CCControlButtonTest_Scale9Batch : public CCControlScene
+{
+public:
+    CCControlButtonTest_Scale9Batch();
+    bool init();
+    void update(float dt);
+    void toggleBatchAction(CCObject *sender);
+protected:
+    void createPanels();
+
+    CCNode *m_pPanels;
+    CCLabelTTF *m_pDisplayValueLabel;
+    bool m_bBatched;
+    float m_fTime;
+    CONTROL_SCENE_CREATE_FUNC(CCControlButtonTest_Scale9Batch)
+};
+
 
 #endif /* __CCCONTROLBUTTONTEST_H__ */
@@ -42,6 +42,7 @@ enum
     kCCControlButtonTest_HelloVariableSize,
     kCCControlButtonTest_Event,
     kCCControlButtonTest_Styling,
+    kCCControlButtonTest_Scale9Batch,
     kCCControlPotentiometerTest,
     kCCControlStepperTest,
     kCCControlTestMax
@@ -54,6 +55,7 @@ static const char* s_testArray[] = {
     "ControlButtonTest_HelloVariableSize",
     "ControlButtonTest_Event",
     "ControlButtonTest_Styling",
+    "ControlButtonTest_Scale9Batch",
     "ControlPotentiometerTest",
     "CCControlStepperTest"
 };
@@ -108,6 +110,7 @@ CCScene *CCControlSceneManager::currentControlScene()
     case kCCControlButtonTest_HelloVariableSize:return CCControlButtonTest_HelloVariableSize::sceneWithTitle(s_testArray[m_nCurrentControlSceneId]);
     case kCCControlButtonTest_Event:return CCControlButtonTest_Event::sceneWithTitle(s_testArray[m_nCurrentControlSceneId]);
     case kCCControlButtonTest_Styling:return CCControlButtonTest_Styling::sceneWithTitle(s_testArray[m_nCurrentControlSceneId]);
+    case kCCControlButtonTest_Scale9Batch:return CCControlButtonTest_Scale9Batch::sceneWithTitle(s_testArray[m_nCurrentControlSceneId]);
     case kCCControlPotentiometerTest:return CCControlPotentiometerTest::sceneWithTitle(s_testArray[m_nCurrentControlSceneId]);
     case kCCControlStepperTest:return CCControlStepperTest::sceneWithTitle(s_testArray[m_nCurrentControlSceneId]);
     }
@@ -40,7 +40,11 @@ CCLayer* restartAtlasAction();
 
 static int sceneIdx = -1; 
 
-#define MAX_LAYER    27
+#if (CC_TARGET_PLATFORM == CC_PLATFORM_LINUX)
+#define MAX_LAYER    29
+#else
+#define MAX_LAYER    28
+#endif
 
 CCLayer* createAtlasLayer(int nIndex)
 {
@@ -75,6 +79,10 @@ CCLayer* createAtlasLayer(int nIndex)
         case 24: return new Issue1343();
         case 25: return new LabelTTFAlignment();
         case 26: return new LabelBMFontBounds();
+        case 27: return new LabelBMFontQuadOnly();
+#if (CC_TARGET_PLATFORM == CC_PLATFORM_LINUX)
+        case 28: return new LabelFontAtlasTest();
+#endif
     }
 
     return NULL;
@@ -1555,3 +1563,118 @@ void LabelBMFontBounds::draw()
     ccDrawPoly(vertices, 4, true);
 }
 
+// LabelBMFontQuadOnly
+LabelBMFontQuadOnly::LabelBMFontQuadOnly()
+: m_time(0)
+{
+    CCSize s = CCDirector::sharedDirector()->getWinSize();
+
+    m_pLabels = CCArray::create();
+    m_pLabels->retain();
+
+    // left column: sprite characters, right column: quad-only, updated every frame
+    for (int i = 0; i < 10; ++i)
+    {
+        for (int column = 0; column < 2; ++column)
+        {
+            CCLabelBMFont *label = CCLabelBMFont::create("0", "fonts/bitmapFontTest3.fnt");
+            label->setQuadOnly(column == 1);
+            label->setAnchorPoint(ccp(column == 0 ? 1 : 0, 0.5f));
+            label->setPosition(ccp(s.width/2 + (column == 0 ? -20 : 20), s.height - 90 - i * 22));
+            label->setScale(0.5f);
+            addChild(label);
+            m_pLabels->addObject(label);
+        }
+    }
+
+    schedule(schedule_selector(LabelBMFontQuadOnly::step));
+}
+
+LabelBMFontQuadOnly::~LabelBMFontQuadOnly()
+{
+    m_pLabels->release();
+}
+
+void LabelBMFontQuadOnly::step(float dt)
+{
+    m_time += dt;
+    char string[32] = {0};
+    for (unsigned int i = 0; i < m_pLabels->count(); ++i)
+    {
+        sprintf(string, "%08.2f", m_time * (i / 2 + 1) * 10);
+        ((CCLabelBMFont*)m_pLabels->objectAtIndex(i))->setString(string);
+    }
+}
+
+std::string LabelBMFontQuadOnly::title()
+{
+    return "CCLabelBMFont quad-only";
+}
+
+std::string LabelBMFontQuadOnly::subtitle()
+{
+    return "Left: sprite characters. Right: quad-only. Both columns should match";
+}
+
+#if (CC_TARGET_PLATFORM == CC_PLATFORM_LINUX)
+
+// LabelFontAtlasTest
+LabelFontAtlasTest::LabelFontAtlasTest()
+: m_time(0)
+, m_pBatchNode(NULL)
+{
+    CCSize s = CCDirector::sharedDirector()->getWinSize();
+
+    CCLayerColor *layer = CCLayerColor::create(ccc4(128, 128, 128, 255));
+    addChild(layer, -10);
+
+    const char *pText = "Kerning: AV To Wa\nlong lines wrap to the dimensions of the label";
+    CCSize dimensions = CCSizeMake(s.width / 2 - 20, 0);
+
+    CCLabelFontAtlas *pAtlasLabel = CCLabelFontAtlas::create(pText, "fonts/Marker Felt.ttf", 24, dimensions, kCCTextAlignmentCenter);
+    pAtlasLabel->setPosition(ccp(s.width * 3/4, s.height * 2/3));
+    addChild(pAtlasLabel);
+
+    CCLabelTTF *pTTFLabel = CCLabelTTF::create(pText, "fonts/Marker Felt.ttf", 24, dimensions, kCCTextAlignmentCenter);
+    pTTFLabel->setPosition(ccp(s.width/4, s.height * 2/3));
+    addChild(pTTFLabel);
+
+    // counters updated every frame, drawn with one call
+    m_pBatchNode = CCFontAtlasBatchNode::create();
+    addChild(m_pBatchNode);
+    for (int i = 0; i < 4; ++i)
+    {
+        CCLabelFontAtlas *pCounter = CCLabelFontAtlas::create("0", "fonts/Marker Felt.ttf", 20);
+        pCounter->setColor(ccc3(255, 64 * i, 0));
+        pCounter->setRotation(i * 10);
+        pCounter->setPosition(ccp(s.width * (i + 1) / 5, s.height / 4));
+        m_pBatchNode->addChild(pCounter);
+    }
+
+    schedule(schedule_selector(LabelFontAtlasTest::step));
+}
+
+void LabelFontAtlasTest::step(float dt)
+{
+    m_time += dt;
+    char string[32] = {0};
+    CCObject *pObj = NULL;
+    int i = 0;
+    CCARRAY_FOREACH(m_pBatchNode->getChildren(), pObj)
+    {
+        sprintf(string, "%.2f", m_time * (++i));
+        ((CCLabelFontAtlas*)pObj)->setString(string);
+    }
+}
+
+std::string LabelFontAtlasTest::title()
+{
+    return "Testing CCLabelFontAtlas";
+}
+
+std::string LabelFontAtlasTest::subtitle()
+{
+    return "CCLabelTTF (left) and CCLabelFontAtlas (right) should look the same";
+}
+
+#endif // CC_TARGET_PLATFORM == CC_PLATFORM_LINUX
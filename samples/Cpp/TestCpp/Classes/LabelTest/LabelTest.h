@@ -304,6 +304,35 @@ private:
     CCLabelBMFont *label1;
 };
 
+class LabelBMFontQuadOnly : public AtlasDemo
+{
+    float m_time;
+public:
+    LabelBMFontQuadOnly();
+    ~LabelBMFontQuadOnly();
+    void step(float dt);
+
+    virtual std::string title();
+    virtual std::string subtitle();
+private:
+    CCArray *m_pLabels;
+};
+
+#if (CC_TARGET_PLATFORM == CC_PLATFORM_LINUX)
+class LabelFontAtlasTest : public AtlasDemo
+{
+    float m_time;
+public:
+    LabelFontAtlasTest();
+    void step(float dt);
+
+    virtual std::string title();
+    virtual std::string subtitle();
+private:
+    CCFontAtlasBatchNode *m_pBatchNode;
+};
+#endif
+
 // we don't support linebreak mode
 
 #endif
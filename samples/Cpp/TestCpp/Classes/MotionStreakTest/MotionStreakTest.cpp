@@ -146,6 +146,73 @@ std::string Issue1358::subtitle()
     return "The tail should use the texture";
 }
 
+//------------------------------------------------------------------
+//
+// MotionStreakBatchTest
+//
+//------------------------------------------------------------------
+
+#define kStreakBatchCount 20
+
+void MotionStreakBatchTest::onEnter()
+{
+    MotionStreakTest::onEnter();
+
+    CCSize size = CCDirector::sharedDirector()->getWinSize();
+
+    m_pBatch = CCMotionStreakBatchNode::create(s_streak);
+    addChild(m_pBatch);
+
+    for (int i = 0; i < kStreakBatchCount; i++)
+    {
+        ccColor3B color = ccc3(55 + i * 10, 255 - i * 10, 128);
+        CCMotionStreak *pStreak = CCMotionStreak::create(1.0f, 3, 12, color, s_streak);
+        m_pBatch->addChild(pStreak);
+    }
+    streak = (CCMotionStreak*)m_pBatch->getChildren()->objectAtIndex(0);
+
+    m_center = ccp(size.width/2, size.height/2);
+    m_fAngle = 0.0f;
+
+    scheduleUpdate();
+}
+
+void MotionStreakBatchTest::update(float dt)
+{
+    CCSize size = CCDirector::sharedDirector()->getWinSize();
+
+    m_fAngle += dt * 2;
+
+    for (int i = 0; i < kStreakBatchCount; i++)
+    {
+        CCMotionStreak *pStreak = (CCMotionStreak*)m_pBatch->getChildren()->objectAtIndex(i);
+        float fRadius = size.height * (0.1f + 0.35f * i / kStreakBatchCount);
+        float fAngle = m_fAngle * (1.0f + 0.1f * i) + i;
+        pStreak->setPosition(ccp(m_center.x + cosf(fAngle) * fRadius, m_center.y + sinf(fAngle * 1.5f) * fRadius));
+    }
+}
+
+void MotionStreakBatchTest::modeCallback(CCObject* pSender)
+{
+    bool fastMode = streak->isFastMode();
+
+    CCObject* pObj = NULL;
+    CCARRAY_FOREACH(m_pBatch->getChildren(), pObj)
+    {
+        ((CCMotionStreak*)pObj)->setFastMode(! fastMode);
+    }
+}
+
+std::string MotionStreakBatchTest::title()
+{
+    return "CCMotionStreakBatchNode";
+}
+
+std::string MotionStreakBatchTest::subtitle()
+{
+    return "20 streaks drawn with 1 draw call";
+}
+
 //------------------------------------------------------------------
 //
 // MotionStreakTest
@@ -161,7 +228,7 @@ std::string Issue1358::subtitle()
 
 static int sceneIdx = -1; 
 
-#define MAX_LAYER    3
+#define MAX_LAYER    4
 
 CCLayer* createMotionLayer(int nIndex)
 {
@@ -170,6 +237,7 @@ CCLayer* createMotionLayer(int nIndex)
         case 0: return new MotionStreakTest1();
         case 1: return new MotionStreakTest2();
         case 2: return new Issue1358();
+        case 3: return new MotionStreakBatchTest();
     }
 
     return NULL;
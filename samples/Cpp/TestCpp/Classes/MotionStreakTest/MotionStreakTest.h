@@ -19,7 +19,7 @@ public:
     void restartCallback(CCObject* pSender);
     void nextCallback(CCObject* pSender);
     void backCallback(CCObject* pSender);
-    void modeCallback(CCObject* pSender);
+    virtual void modeCallback(CCObject* pSender);
 protected:
     CCMotionStreak *streak;
 };
@@ -61,6 +61,20 @@ private:
     float m_fAngle;
 };
 
+class MotionStreakBatchTest : public MotionStreakTest
+{
+public:
+    virtual std::string title();
+    virtual std::string subtitle();
+    virtual void onEnter();
+    virtual void update(float dt);
+    virtual void modeCallback(CCObject* pSender);
+private:
+    CCMotionStreakBatchNode *m_pBatch;
+    CCPoint m_center;
+    float m_fAngle;
+};
+
 class MotionStreakTestScene : public TestScene
 {
 public:
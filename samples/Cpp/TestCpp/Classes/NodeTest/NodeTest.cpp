@@ -22,7 +22,7 @@ CCLayer* restartCocosNodeAction();
 
 static int sceneIdx = -1; 
 
-#define MAX_LAYER    14
+#define MAX_LAYER    15
 
 CCLayer* createCocosNodeLayer(int nIndex)
 {
@@ -42,6 +42,7 @@ CCLayer* createCocosNodeLayer(int nIndex)
         case 11: return new ConvertToNode();
         case 12: return new NodeOpaqueTest();
         case 13: return new NodeNonOpaqueTest();
+        case 14: return new NodeCacheAsBitmapTest();
     }
 
     return NULL;
@@ -869,6 +870,67 @@ std::string NodeNonOpaqueTest::subtitle()
     return "Node rendered with GL_BLEND enabled";
 }
 
+/// NodeCacheAsBitmapTest
+
+NodeCacheAsBitmapTest::NodeCacheAsBitmapTest()
+: m_pPanel(NULL)
+, m_pStatus(NULL)
+, m_nChangedIcon(0)
+{
+    CCSize s = CCDirector::sharedDirector()->getWinSize();
+
+    // a panel of 40 icons and labels, drawn as a single quad while they don't change
+    m_pPanel = CCLayerColor::create(ccc4(40, 40, 80, 200), 320, 180);
+    m_pPanel->ignoreAnchorPointForPosition(false);
+    m_pPanel->setPosition(ccp(s.width / 2, s.height / 2));
+    addChild(m_pPanel);
+
+    for (int i = 0; i < 40; i++)
+    {
+        CCSprite *icon = CCSprite::create(s_pPathGrossini);
+        icon->setScale(0.3f);
+        icon->setPosition(ccp(20 + (i % 10) * 31, 30 + (i / 10) * 42));
+        m_pPanel->addChild(icon, 0, i);
+
+        CCLabelAtlas *price = CCLabelAtlas::create(CCString::createWithFormat("%d", (i + 1) * 10)->getCString(), "fonts/tuffy_bold_italic-charmap.plist");
+        price->setScale(0.3f);
+        price->setPosition(ccp(8 + (i % 10) * 31, 8 + (i / 10) * 42));
+        m_pPanel->addChild(price);
+    }
+    m_pPanel->setCacheAsBitmap(true);
+
+    // moving the cached panel doesn't draw the cache again, changing an icon does
+    m_pPanel->runAction(CCRepeatForever::create(CCSequence::create(CCRotateBy::create(4, 10), CCRotateBy::create(4, -10), NULL)));
+    schedule(schedule_selector(NodeCacheAsBitmapTest::changeIcon), 1.0f);
+
+    m_pStatus = CCLabelTTF::create("", "Arial", 16);
+    m_pStatus->setPosition(ccp(s.width / 2, 30));
+    addChild(m_pStatus);
+    scheduleUpdate();
+}
+
+void NodeCacheAsBitmapTest::changeIcon(float dt)
+{
+    CCSprite *icon = (CCSprite*)m_pPanel->getChildByTag(m_nChangedIcon % 40);
+    icon->setColor((m_nChangedIcon / 40) % 2 ? ccWHITE : ccRED);
+    m_nChangedIcon++;
+}
+
+void NodeCacheAsBitmapTest::update(float dt)
+{
+    m_pStatus->setString(CCString::createWithFormat("panel drawn into its cache %u times", m_pPanel->getBitmapCacheRenderCount())->getCString());
+}
+
+std::string NodeCacheAsBitmapTest::title()
+{
+    return "Node Cache As Bitmap";
+}
+
+std::string NodeCacheAsBitmapTest::subtitle()
+{
+    return "80 nodes drawn as one quad, redrawn once per second";
+}
+
 void CocosNodeTestScene::runThisTest()
 {
     CCLayer* pLayer = nextCocosNodeAction();
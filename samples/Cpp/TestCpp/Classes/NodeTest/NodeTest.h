@@ -145,6 +145,21 @@ public:
     virtual std::string subtitle();
 };
 
+class NodeCacheAsBitmapTest : public TestCocosNodeDemo
+{
+public:
+    NodeCacheAsBitmapTest();
+    void changeIcon(float dt);
+    virtual void update(float dt);
+    virtual std::string title();
+    virtual std::string subtitle();
+
+private:
+    CCLayerColor *m_pPanel;
+    CCLabelTTF *m_pStatus;
+    int m_nChangedIcon;
+};
+
 class CocosNodeTestScene : public TestScene
 {
 public:
@@ -0,0 +1,166 @@
+#include "PerformanceGridTest.h"
+
+enum
+{
+    TEST_COUNT = 1,
+};
+
+// number of updates timed for each effect
+#define GRID_TEST_UPDATES   50
+// number of threads compared with one thread
+#define GRID_TEST_THREADS   4
+
+static double millisecondsSince(struct cc_timeval *start)
+{
+    struct cc_timeval now;
+    CCTime::gettimeofdayCocos2d(&now, NULL);
+    return CCTime::timersubCocos2d(start, &now);
+}
+
+static CCGridAction* createGridEffect(int nEffect, const CCSize& gridSize, const char **ppName)
+{
+    CCSize s = CCDirector::sharedDirector()->getWinSize();
+    CCPoint center = ccp(s.width / 2, s.height / 2);
+
+    switch (nEffect)
+    {
+    case 0: *ppName = "Waves3D"; return CCWaves3D::create(1, gridSize, 5, 40);
+    case 1: *ppName = "Ripple3D"; return CCRipple3D::create(1, gridSize, center, 240, 4, 160);
+    case 2: *ppName = "Twirl"; return CCTwirl::create(1, gridSize, center, 1, 2.5f);
+    case 3: *ppName = "Liquid"; return CCLiquid::create(1, gridSize, 4, 20);
+    case 4: *ppName = "Lens3D"; return CCLens3D::create(1, gridSize, center, 240);
+    case 5: *ppName = "Waves"; return CCWaves::create(1, gridSize, 4, 20, true, true);
+    case 6: *ppName = "WavesTiles3D"; return CCWavesTiles3D::create(1, gridSize, 4, 120);
+    case 7: *ppName = "JumpTiles3D"; return CCJumpTiles3D::create(1, gridSize, 2, 30);
+    }
+
+    return NULL;
+}
+
+// milliseconds taken by one update of the effect
+static double timeGridEffect(CCGridAction *pAction, CCNode *pTarget)
+{
+    pAction->startWithTarget(pTarget);
+
+    struct cc_timeval start;
+    CCTime::gettimeofdayCocos2d(&start, NULL);
+    for (int i = 0; i < GRID_TEST_UPDATES; ++i)
+    {
+        if (dynamic_cast<CCLens3D*>(pAction))
+        {
+            // the lens is only computed again when it moves
+            ((CCLens3D*)pAction)->setPosition(ccp(100 + i, 100));
+        }
+        pAction->update((float)i / GRID_TEST_UPDATES);
+    }
+    double ms = millisecondsSince(&start) / GRID_TEST_UPDATES;
+
+    pAction->stop();
+    return ms;
+}
+
+////////////////////////////////////////////////////////
+//
+// GridEffectsTest
+//
+////////////////////////////////////////////////////////
+void GridEffectsTest::showCurrentTest()
+{
+    GridEffectsTest* pLayer = new GridEffectsTest(true, TEST_COUNT, m_nCurCase);
+
+    CCScene* pScene = CCScene::create();
+    pScene->addChild(pLayer);
+    pLayer->release();
+
+    CCDirector::sharedDirector()->replaceScene(pScene);
+}
+
+void GridEffectsTest::onEnter()
+{
+    PerformBasicLayer::onEnter();
+
+    CCSize s = CCDirector::sharedDirector()->getWinSize();
+
+    CCLabelTTF *label = CCLabelTTF::create(title().c_str(), "Arial", 40);
+    addChild(label, 1);
+    label->setPosition(ccp(s.width/2, s.height-32));
+    label->setColor(ccc3(255,255,40));
+
+    CCLabelTTF *l = CCLabelTTF::create(subtitle().c_str(), "Thonburi", 16);
+    addChild(l, 1);
+    l->setPosition(ccp(s.width/2, s.height-80));
+
+    m_nResultLines = 0;
+    CCLog("--------");
+    CCLog("%s", title().c_str());
+    performTests();
+}
+
+void GridEffectsTest::addResult(const char* format, ...)
+{
+    char szBuf[256] = {0};
+    va_list ap;
+    va_start(ap, format);
+    vsnprintf(szBuf, sizeof(szBuf) - 1, format, ap);
+    va_end(ap);
+
+    CCLog("  %s", szBuf);
+
+    CCSize s = CCDirector::sharedDirector()->getWinSize();
+    CCLabelTTF *l = CCLabelTTF::create(szBuf, "Arial", 12);
+    addChild(l, 1);
+    l->setPosition(ccp(s.width/2, s.height - 105 - m_nResultLines * 14));
+    ++m_nResultLines;
+}
+
+void GridEffectsTest::performTests()
+{
+    const CCSize gridSizes[] = { CCSizeMake(64, 48), CCSizeMake(128, 96) };
+    unsigned int uThreads = ccGridGetThreads();
+    unsigned int uMinVertices = ccGridGetMinVertices();
+
+    // the effects are not run, the node only holds the grid
+    CCNode *pTarget = CCNode::create();
+    pTarget->setContentSize(CCDirector::sharedDirector()->getWinSize());
+
+    for (unsigned int g = 0; g < sizeof(gridSizes) / sizeof(gridSizes[0]); ++g)
+    {
+        for (int nEffect = 0; nEffect < 8; ++nEffect)
+        {
+            const char *pszName = NULL;
+            CCGridAction *pAction = createGridEffect(nEffect, gridSizes[g], &pszName);
+
+            ccGridSetThreads(1, 0);
+            double serial = timeGridEffect(pAction, pTarget);
+            ccGridSetThreads(GRID_TEST_THREADS, 0);
+            double threaded = timeGridEffect(pAction, pTarget);
+
+            addResult("%s %dx%d: %.3f ms, %d threads %.3f ms", pszName,
+                (int)gridSizes[g].width, (int)gridSizes[g].height, serial, GRID_TEST_THREADS, threaded);
+        }
+    }
+
+    pTarget->setGrid(NULL);
+    ccGridSetThreads(uThreads, uMinVertices);
+}
+
+std::string GridEffectsTest::title()
+{
+    return "Grid effects";
+}
+
+std::string GridEffectsTest::subtitle()
+{
+    return "Time of an update of the grid, see console";
+}
+
+void runGridTest()
+{
+    GridEffectsTest* pLayer = new GridEffectsTest(true, TEST_COUNT, 0);
+
+    CCScene* pScene = CCScene::create();
+    pScene->addChild(pLayer);
+    pLayer->release();
+
+    CCDirector::sharedDirector()->replaceScene(pScene);
+}
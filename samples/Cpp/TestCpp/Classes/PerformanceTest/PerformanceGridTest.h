@@ -0,0 +1,29 @@
+#ifndef __PERFORMANCE_GRID_TEST_H__
+#define __PERFORMANCE_GRID_TEST_H__
+
+#include "PerformanceTest.h"
+
+class GridEffectsTest : public PerformBasicLayer
+{
+public:
+    GridEffectsTest(bool bControlMenuVisible, int nMaxCases = 0, int nCurCase = 0)
+        :PerformBasicLayer(bControlMenuVisible, nMaxCases, nCurCase)
+    {
+    }
+
+    virtual void showCurrentTest();
+    virtual void onEnter();
+
+    std::string title();
+    std::string subtitle();
+
+private:
+    void performTests();
+    void addResult(const char* format, ...);
+
+    int m_nResultLines;
+};
+
+void runGridTest();
+
+#endif
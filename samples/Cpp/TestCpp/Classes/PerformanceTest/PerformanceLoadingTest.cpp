@@ -0,0 +1,1824 @@
+#include "PerformanceLoadingTest.h"
+#include "support/zip_support/unzip.h"
+#include <zlib.h>
+#include <pthread.h>
+#include <algorithm>
+
+enum
+{
+    TEST_COUNT = 11,
+};
+
+static int s_nLoadingCurCase = 0;
+
+static double millisecondsSince(struct cc_timeval *start)
+{
+    struct cc_timeval now;
+    CCTime::gettimeofdayCocos2d(&now, NULL);
+    return CCTime::timersubCocos2d(start, &now);
+}
+
+////////////////////////////////////////////////////////
+//
+// LoadingMenuLayer
+//
+////////////////////////////////////////////////////////
+void LoadingMenuLayer::showCurrentTest()
+{
+    CCLayer* pLayer = NULL;
+
+    switch (m_nCurCase)
+    {
+    case 0:
+        pLayer = new ZipIndexTest(true, TEST_COUNT, m_nCurCase);
+        break;
+    case 1:
+        pLayer = new FilePackTest(true, TEST_COUNT, m_nCurCase);
+        break;
+    case 2:
+        pLayer = new AsyncFileReadTest(true, TEST_COUNT, m_nCurCase);
+        break;
+    case 3:
+        pLayer = new ResourceManifestTest(true, TEST_COUNT, m_nCurCase);
+        break;
+    case 4:
+        pLayer = new BinarySpriteSheetTest(true, TEST_COUNT, m_nCurCase);
+        break;
+    case 5:
+        pLayer = new PlistParserTest(true, TEST_COUNT, m_nCurCase);
+        break;
+    case 6:
+        pLayer = new LabelRenderingTest(true, TEST_COUNT, m_nCurCase);
+        break;
+    case 7:
+        pLayer = new BMFontLoadingTest(true, TEST_COUNT, m_nCurCase);
+        break;
+    case 8:
+        pLayer = new TMXLoadingTest(true, TEST_COUNT, m_nCurCase);
+        break;
+    case 9:
+        pLayer = new PagedTileMapTest(true, TEST_COUNT, m_nCurCase);
+        break;
+    case 10:
+        pLayer = new ShaderLoadingTest(true, TEST_COUNT, m_nCurCase);
+        break;
+    }
+    s_nLoadingCurCase = m_nCurCase;
+
+    if (pLayer)
+    {
+        CCScene* pScene = CCScene::create();
+        pScene->addChild(pLayer);
+        pLayer->release();
+
+        CCDirector::sharedDirector()->replaceScene(pScene);
+    }
+}
+
+void LoadingMenuLayer::onEnter()
+{
+    PerformBasicLayer::onEnter();
+
+    CCSize s = CCDirector::sharedDirector()->getWinSize();
+
+    // Title
+    CCLabelTTF *label = CCLabelTTF::create(title().c_str(), "Arial", 40);
+    addChild(label, 1);
+    label->setPosition(ccp(s.width/2, s.height-32));
+    label->setColor(ccc3(255,255,40));
+
+    // Subtitle
+    std::string strSubTitle = subtitle();
+    if(strSubTitle.length())
+    {
+        CCLabelTTF *l = CCLabelTTF::create(strSubTitle.c_str(), "Thonburi", 16);
+        addChild(l, 1);
+        l->setPosition(ccp(s.width/2, s.height-80));
+    }
+
+    m_nResultLines = 0;
+    CCLog("--------");
+    CCLog("%s", title().c_str());
+    performTests();
+}
+
+void LoadingMenuLayer::addResult(const char* format, ...)
+{
+    char szBuf[256] = {0};
+    va_list ap;
+    va_start(ap, format);
+    vsnprintf(szBuf, sizeof(szBuf) - 1, format, ap);
+    va_end(ap);
+
+    CCLog("  %s", szBuf);
+
+    CCSize s = CCDirector::sharedDirector()->getWinSize();
+    CCLabelTTF *l = CCLabelTTF::create(szBuf, "Arial", 14);
+    addChild(l, 1);
+    l->setPosition(ccp(s.width/2, s.height - 110 - m_nResultLines * 18));
+    ++m_nResultLines;
+}
+
+std::string LoadingMenuLayer::title()
+{
+    return "no title";
+}
+
+std::string LoadingMenuLayer::subtitle()
+{
+    return "no subtitle";
+}
+
+////////////////////////////////////////////////////////
+//
+// ZipIndexTest
+//
+////////////////////////////////////////////////////////
+#define ZIP_INDEX_TEST_ENTRIES   5000
+#define ZIP_INDEX_TEST_THREADS   4
+
+static void writeLE16(FILE *fp, unsigned int v)
+{
+    unsigned char b[2] = { (unsigned char)(v & 0xff), (unsigned char)((v >> 8) & 0xff) };
+    fwrite(b, 1, 2, fp);
+}
+
+static void writeLE32(FILE *fp, unsigned long v)
+{
+    unsigned char b[4] = { (unsigned char)(v & 0xff), (unsigned char)((v >> 8) & 0xff),
+                           (unsigned char)((v >> 16) & 0xff), (unsigned char)((v >> 24) & 0xff) };
+    fwrite(b, 1, 4, fp);
+}
+
+static void zipEntryName(int i, char *szName, size_t size)
+{
+    snprintf(szName, size, "assets/data/dir%02d/entry%05d.txt", i % 50, i);
+}
+
+// writes an archive of small stored entries, like the assets of an apk
+static bool writeTestZip(const std::string& path, int nEntries)
+{
+    FILE *fp = fopen(path.c_str(), "wb");
+    if (! fp)
+    {
+        return false;
+    }
+
+    std::vector<unsigned long> offsets;
+    std::vector<unsigned long> crcs;
+    char szName[64];
+    char szData[64];
+
+    for (int i = 0; i < nEntries; ++i)
+    {
+        zipEntryName(i, szName, sizeof(szName));
+        int nDataLen = snprintf(szData, sizeof(szData), "content of entry %d", i);
+        unsigned long crc = crc32(0, (const Bytef*)szData, nDataLen);
+        offsets.push_back(ftell(fp));
+        crcs.push_back(crc);
+
+        writeLE32(fp, 0x04034b50);
+        writeLE16(fp, 10);              // version needed
+        writeLE16(fp, 0);               // flags
+        writeLE16(fp, 0);               // stored
+        writeLE16(fp, 0);               // time
+        writeLE16(fp, 0);               // date
+        writeLE32(fp, crc);
+        writeLE32(fp, nDataLen);
+        writeLE32(fp, nDataLen);
+        writeLE16(fp, strlen(szName));
+        writeLE16(fp, 0);               // extra
+        fwrite(szName, 1, strlen(szName), fp);
+        fwrite(szData, 1, nDataLen, fp);
+    }
+
+    unsigned long centralStart = ftell(fp);
+    for (int i = 0; i < nEntries; ++i)
+    {
+        zipEntryName(i, szName, sizeof(szName));
+        int nDataLen = snprintf(szData, sizeof(szData), "content of entry %d", i);
+
+        writeLE32(fp, 0x02014b50);
+        writeLE16(fp, 20);              // version made by
+        writeLE16(fp, 10);              // version needed
+        writeLE16(fp, 0);
+        writeLE16(fp, 0);
+        writeLE16(fp, 0);
+        writeLE16(fp, 0);
+        writeLE32(fp, crcs[i]);
+        writeLE32(fp, nDataLen);
+        writeLE32(fp, nDataLen);
+        writeLE16(fp, strlen(szName));
+        writeLE16(fp, 0);               // extra
+        writeLE16(fp, 0);               // comment
+        writeLE16(fp, 0);               // disk
+        writeLE16(fp, 0);               // internal attributes
+        writeLE32(fp, 0);               // external attributes
+        writeLE32(fp, offsets[i]);
+        fwrite(szName, 1, strlen(szName), fp);
+    }
+    unsigned long centralSize = ftell(fp) - centralStart;
+
+    writeLE32(fp, 0x06054b50);
+    writeLE16(fp, 0);
+    writeLE16(fp, 0);
+    writeLE16(fp, nEntries);
+    writeLE16(fp, nEntries);
+    writeLE32(fp, centralSize);
+    writeLE32(fp, centralStart);
+    writeLE16(fp, 0);
+
+    fclose(fp);
+    return true;
+}
+
+// what getFileDataFromZip used to do for every file
+static unsigned char* readWithoutIndex(const char* pszZipFilePath, const char* pszFileName, unsigned long *pSize)
+{
+    unsigned char *pBuffer = NULL;
+    *pSize = 0;
+
+    unzFile pFile = unzOpen(pszZipFilePath);
+    if (! pFile)
+    {
+        return NULL;
+    }
+
+    unz_file_info fileInfo;
+    if (unzLocateFile(pFile, pszFileName, 1) == UNZ_OK
+        && unzGetCurrentFileInfo(pFile, &fileInfo, NULL, 0, NULL, 0, NULL, 0) == UNZ_OK
+        && unzOpenCurrentFile(pFile) == UNZ_OK)
+    {
+        pBuffer = new unsigned char[fileInfo.uncompressed_size];
+        unzReadCurrentFile(pFile, pBuffer, fileInfo.uncompressed_size);
+        *pSize = fileInfo.uncompressed_size;
+        unzCloseCurrentFile(pFile);
+    }
+    unzClose(pFile);
+
+    return pBuffer;
+}
+
+typedef struct _ZipReaderArgs
+{
+    const char *zipPath;
+    int first;
+    int step;
+    int nRead;
+} ZipReaderArgs;
+
+static void* readZipEntries(void *data)
+{
+    ZipReaderArgs *args = (ZipReaderArgs*)data;
+    char szName[64];
+
+    for (int i = args->first; i < ZIP_INDEX_TEST_ENTRIES; i += args->step)
+    {
+        zipEntryName(i, szName, sizeof(szName));
+        unsigned long nSize = 0;
+        unsigned char *pBuffer = CCFileUtils::sharedFileUtils()->getFileDataFromZip(args->zipPath, szName, &nSize);
+        if (pBuffer)
+        {
+            ++args->nRead;
+        }
+        CC_SAFE_DELETE_ARRAY(pBuffer);
+    }
+
+    return 0;
+}
+
+void ZipIndexTest::performTests()
+{
+    CCFileUtils *pFileUtils = CCFileUtils::sharedFileUtils();
+    std::string zipPath = pFileUtils->getWritablePath() + "zip-index-test.zip";
+    if (! writeTestZip(zipPath, ZIP_INDEX_TEST_ENTRIES))
+    {
+        addResult("can not write %s", zipPath.c_str());
+        return;
+    }
+
+    // make sure the archive gets mounted inside the measurement
+    pFileUtils->purgeCachedEntries();
+
+    struct cc_timeval start;
+    char szName[64];
+    int nRead = 0;
+
+    // without index: one central directory scan per file, only a slice of them or it takes forever
+    const int nUnindexed = ZIP_INDEX_TEST_ENTRIES / 10;
+    CCTime::gettimeofdayCocos2d(&start, NULL);
+    for (int i = 0; i < nUnindexed; ++i)
+    {
+        zipEntryName(i * 10, szName, sizeof(szName));
+        unsigned long nSize = 0;
+        unsigned char *pBuffer = readWithoutIndex(zipPath.c_str(), szName, &nSize);
+        nRead += pBuffer ? 1 : 0;
+        CC_SAFE_DELETE_ARRAY(pBuffer);
+    }
+    double unindexed = millisecondsSince(&start);
+    addResult("unzOpen/unzLocateFile: %d of %d files in %.2f ms (%.1f us/file)", nRead, nUnindexed, unindexed, unindexed * 1000 / nUnindexed);
+
+    // mounted: the first read parses the central directory
+    nRead = 0;
+    CCTime::gettimeofdayCocos2d(&start, NULL);
+    for (int i = 0; i < ZIP_INDEX_TEST_ENTRIES; ++i)
+    {
+        zipEntryName(i, szName, sizeof(szName));
+        unsigned long nSize = 0;
+        unsigned char *pBuffer = pFileUtils->getFileDataFromZip(zipPath.c_str(), szName, &nSize);
+        nRead += pBuffer ? 1 : 0;
+        CC_SAFE_DELETE_ARRAY(pBuffer);
+    }
+    double indexed = millisecondsSince(&start);
+    addResult("getFileDataFromZip: %d of %d files in %.2f ms (%.1f us/file)", nRead, ZIP_INDEX_TEST_ENTRIES, indexed, indexed * 1000 / ZIP_INDEX_TEST_ENTRIES);
+
+    // mounted, read by several loader threads at once
+    pthread_t threads[ZIP_INDEX_TEST_THREADS];
+    ZipReaderArgs args[ZIP_INDEX_TEST_THREADS];
+    CCTime::gettimeofdayCocos2d(&start, NULL);
+    for (int i = 0; i < ZIP_INDEX_TEST_THREADS; ++i)
+    {
+        args[i].zipPath = zipPath.c_str();
+        args[i].first = i;
+        args[i].step = ZIP_INDEX_TEST_THREADS;
+        args[i].nRead = 0;
+        pthread_create(&threads[i], NULL, readZipEntries, &args[i]);
+    }
+    nRead = 0;
+    for (int i = 0; i < ZIP_INDEX_TEST_THREADS; ++i)
+    {
+        pthread_join(threads[i], NULL);
+        nRead += args[i].nRead;
+    }
+    double threaded = millisecondsSince(&start);
+    addResult("%d threads: %d of %d files in %.2f ms", ZIP_INDEX_TEST_THREADS, nRead, ZIP_INDEX_TEST_ENTRIES, threaded);
+
+    pFileUtils->purgeCachedEntries();
+    remove(zipPath.c_str());
+}
+
+std::string ZipIndexTest::title()
+{
+    return "Zip index";
+}
+
+std::string ZipIndexTest::subtitle()
+{
+    return "Reading 5000 entries of a zip file. See console";
+}
+
+////////////////////////////////////////////////////////
+//
+// FilePackTest
+//
+////////////////////////////////////////////////////////
+#define FILE_PACK_TEST_ENTRIES      500
+#define FILE_PACK_TEST_ENTRY_SIZE   (16 * 1024)
+
+static void filePackEntryName(int i, char *szName, size_t size)
+{
+    snprintf(szName, size, "file-pack-test/entry%04d.bin", i);
+}
+
+static bool compareFilePackEntries(const ccFilePackEntry& a, const ccFilePackEntry& b)
+{
+    return a.hash < b.hash;
+}
+
+// same layout as tools/file-pack/ccpack.py writes, without compression
+static bool writeTestFilePack(const std::string& path, int nEntries, const unsigned char *pData, unsigned int uDataSize)
+{
+    FILE *fp = fopen(path.c_str(), "wb");
+    if (! fp)
+    {
+        return false;
+    }
+
+    std::string names;
+    std::vector<ccFilePackEntry> entries(nEntries);
+    char szName[64];
+    for (int i = 0; i < nEntries; ++i)
+    {
+        filePackEntryName(i, szName, sizeof(szName));
+        unsigned int uLength = strlen(szName);
+        memset(&entries[i], 0, sizeof(ccFilePackEntry));
+        entries[i].hash = CCFilePack::hashName(szName, uLength);
+        entries[i].nameOffset = names.size();
+        entries[i].nameLength = uLength;
+        entries[i].compression = kCCFilePackCompressionNone;
+        entries[i].compressedSize = uDataSize;
+        entries[i].size = uDataSize;
+        names.append(szName, uLength + 1);
+    }
+    std::sort(entries.begin(), entries.end(), compareFilePackEntries);
+
+    ccFilePackHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, CC_FILE_PACK_MAGIC, 4);
+    header.version = CC_FILE_PACK_VERSION;
+    header.entryCount = nEntries;
+    header.indexOffset = sizeof(header);
+    header.namesOffset = header.indexOffset + nEntries * sizeof(ccFilePackEntry);
+    header.namesSize = names.size();
+
+    // uDataSize is a multiple of the alignment
+    unsigned int uOffset = (header.namesOffset + header.namesSize + CC_FILE_PACK_ALIGNMENT - 1) & ~(CC_FILE_PACK_ALIGNMENT - 1);
+    for (int i = 0; i < nEntries; ++i)
+    {
+        entries[i].offset = uOffset + i * uDataSize;
+    }
+
+    fwrite(&header, sizeof(header), 1, fp);
+    fwrite(&entries[0], sizeof(ccFilePackEntry), nEntries, fp);
+    fwrite(names.data(), 1, names.size(), fp);
+    for (long pos = ftell(fp); pos < (long)uOffset; ++pos)
+    {
+        fputc(0, fp);
+    }
+    for (int i = 0; i < nEntries; ++i)
+    {
+        fwrite(pData, 1, uDataSize, fp);
+    }
+
+    fclose(fp);
+    return true;
+}
+
+void FilePackTest::performTests()
+{
+    CCFileUtils *pFileUtils = CCFileUtils::sharedFileUtils();
+    std::string packPath = pFileUtils->getWritablePath() + "file-pack-test.pack";
+
+    std::vector<unsigned char> data(FILE_PACK_TEST_ENTRY_SIZE);
+    for (unsigned int i = 0; i < data.size(); ++i)
+    {
+        data[i] = (unsigned char)(i * 7);
+    }
+
+    if (! writeTestFilePack(packPath, FILE_PACK_TEST_ENTRIES, &data[0], data.size()))
+    {
+        addResult("can not write %s", packPath.c_str());
+        return;
+    }
+
+    // the same files, loose in the writable path
+    std::vector<std::string> loosePaths;
+    char szName[64];
+    for (int i = 0; i < FILE_PACK_TEST_ENTRIES; ++i)
+    {
+        snprintf(szName, sizeof(szName), "file-pack-test-entry%04d.bin", i);
+        loosePaths.push_back(pFileUtils->getWritablePath() + szName);
+        FILE *fp = fopen(loosePaths.back().c_str(), "wb");
+        if (fp)
+        {
+            fwrite(&data[0], 1, data.size(), fp);
+            fclose(fp);
+        }
+    }
+
+    struct cc_timeval start;
+    unsigned long nBytes = 0;
+
+    CCTime::gettimeofdayCocos2d(&start, NULL);
+    for (int i = 0; i < FILE_PACK_TEST_ENTRIES; ++i)
+    {
+        unsigned long nSize = 0;
+        unsigned char *pBuffer = pFileUtils->getFileData(loosePaths[i].c_str(), "rb", &nSize);
+        nBytes += pBuffer ? nSize : 0;
+        CC_SAFE_DELETE_ARRAY(pBuffer);
+    }
+    double loose = millisecondsSince(&start);
+    addResult("loose files, getFileData: %lu KB in %.2f ms", nBytes / 1024, loose);
+
+    CCTime::gettimeofdayCocos2d(&start, NULL);
+    bool bMounted = pFileUtils->addFilePack(packPath.c_str());
+    double mount = millisecondsSince(&start);
+    if (! bMounted)
+    {
+        addResult("can not mount %s", packPath.c_str());
+    }
+    else
+    {
+        addResult("addFilePack: %d files in %.2f ms", FILE_PACK_TEST_ENTRIES, mount);
+
+        nBytes = 0;
+        CCTime::gettimeofdayCocos2d(&start, NULL);
+        for (int i = 0; i < FILE_PACK_TEST_ENTRIES; ++i)
+        {
+            filePackEntryName(i, szName, sizeof(szName));
+            unsigned long nSize = 0;
+            unsigned char *pBuffer = pFileUtils->getFileData(szName, "rb", &nSize);
+            nBytes += pBuffer ? nSize : 0;
+            CC_SAFE_DELETE_ARRAY(pBuffer);
+        }
+        double copied = millisecondsSince(&start);
+        addResult("file pack, getFileData: %lu KB in %.2f ms", nBytes / 1024, copied);
+
+        nBytes = 0;
+        int nMapped = 0;
+        CCTime::gettimeofdayCocos2d(&start, NULL);
+        for (int i = 0; i < FILE_PACK_TEST_ENTRIES; ++i)
+        {
+            filePackEntryName(i, szName, sizeof(szName));
+            CCFileView view = pFileUtils->getFileView(szName);
+            nBytes += view.getSize();
+            nMapped += view.isMapped() ? 1 : 0;
+            view.release();
+        }
+        double viewed = millisecondsSince(&start);
+        addResult("file pack, getFileView: %lu KB in %.2f ms, %d views without copy", nBytes / 1024, viewed, nMapped);
+
+        pFileUtils->removeAllFilePacks();
+    }
+
+    for (unsigned int i = 0; i < loosePaths.size(); ++i)
+    {
+        remove(loosePaths[i].c_str());
+    }
+    remove(packPath.c_str());
+}
+
+std::string FilePackTest::title()
+{
+    return "File pack";
+}
+
+std::string FilePackTest::subtitle()
+{
+    return "Reading 500 files of 16 KB. See console";
+}
+
+////////////////////////////////////////////////////////
+//
+// AsyncFileReadTest
+//
+////////////////////////////////////////////////////////
+static const char* s_asyncPlists[] = {
+    "animations/animations.plist",
+    "animations/animations-2.plist",
+    "animations/ghosts.plist",
+    "animations/grossini.plist",
+    "animations/grossini-aliases.plist",
+    "animations/grossini_blue.plist",
+    "animations/grossini_family.plist",
+    "animations/grossini_gray.plist",
+    "zwoptex/grossini.plist",
+};
+
+static const char* s_asyncFonts[] = {
+    "fonts/arial-unicode-26.fnt",
+    "fonts/bitmapFontChinese.fnt",
+    "fonts/futura-48.fnt",
+    "fonts/geneva-32.fnt",
+    "fonts/konqa32.fnt",
+    "fonts/markerFelt.fnt",
+};
+
+static const char* s_asyncMaps[] = {
+    "TileMaps/orthogonal-test1.tmx",
+    "TileMaps/orthogonal-test2.tmx",
+    "TileMaps/iso-test.tmx",
+    "TileMaps/iso-test2-uncompressed.tmx",
+    "TileMaps/hexa-test.tmx",
+};
+
+#define ASYNC_COUNT(array)  (int)(sizeof(array) / sizeof(array[0]))
+
+void AsyncFileReadTest::performTests()
+{
+    struct cc_timeval start;
+
+    // synchronous, everything blocks the main thread
+    FNTConfigRemoveCache();
+    CCTime::gettimeofdayCocos2d(&start, NULL);
+    for (int i = 0; i < ASYNC_COUNT(s_asyncPlists); ++i)
+    {
+        CCDictionary::createWithContentsOfFile(s_asyncPlists[i]);
+    }
+    for (int i = 0; i < ASYNC_COUNT(s_asyncFonts); ++i)
+    {
+        FNTConfigLoadFile(s_asyncFonts[i]);
+    }
+    for (int i = 0; i < ASYNC_COUNT(s_asyncMaps); ++i)
+    {
+        CCTMXMapInfo::formatWithTMXFile(s_asyncMaps[i]);
+    }
+    double sync = millisecondsSince(&start);
+    addResult("synchronous: %.2f ms on the main thread", sync);
+
+    // asynchronous, only parsing is done on the main thread
+    FNTConfigRemoveCache();
+    m_nPending = 0;
+    m_nFailed = 0;
+    m_dLongestFrame = 0;
+    CCTime::gettimeofdayCocos2d(&m_tStart, NULL);
+    for (int i = 0; i < ASYNC_COUNT(s_asyncPlists); ++i)
+    {
+        CCDictionary::createWithContentsOfFileAsync(s_asyncPlists[i], this, callfuncO_selector(AsyncFileReadTest::plistLoaded));
+        ++m_nPending;
+    }
+    for (int i = 0; i < ASYNC_COUNT(s_asyncFonts); ++i)
+    {
+        FNTConfigLoadFileAsync(s_asyncFonts[i], this, callfuncO_selector(AsyncFileReadTest::fontLoaded));
+        ++m_nPending;
+    }
+    for (int i = 0; i < ASYNC_COUNT(s_asyncMaps); ++i)
+    {
+        CCTMXMapInfo::formatWithTMXFileAsync(s_asyncMaps[i], this, callfuncO_selector(AsyncFileReadTest::mapLoaded));
+        ++m_nPending;
+    }
+
+    // the raw plists again as one batch, read in parallel and delivered together
+    std::vector<std::string> batch(s_asyncPlists, s_asyncPlists + ASYNC_COUNT(s_asyncPlists));
+    CCFileUtils::sharedFileUtils()->getFileDataAsync(batch, this, callfuncO_selector(AsyncFileReadTest::batchLoaded), kCCFileDataPriorityLow);
+    ++m_nPending;
+
+    double issue = millisecondsSince(&m_tStart);
+    addResult("asynchronous: %d requests issued in %.2f ms", m_nPending, issue);
+
+    CCTime::gettimeofdayCocos2d(&m_tLastFrame, NULL);
+    scheduleUpdate();
+}
+
+void AsyncFileReadTest::update(float dt)
+{
+    double frame = millisecondsSince(&m_tLastFrame);
+    m_dLongestFrame = MAX(m_dLongestFrame, frame);
+    CCTime::gettimeofdayCocos2d(&m_tLastFrame, NULL);
+}
+
+void AsyncFileReadTest::plistLoaded(CCObject* pDict)
+{
+    loaded(pDict != NULL);
+}
+
+void AsyncFileReadTest::batchLoaded(CCObject* pResults)
+{
+    CCArray *pArray = (CCArray*)pResults;
+    bool bSuccess = true;
+    CCObject *pObj = NULL;
+    CCARRAY_FOREACH(pArray, pObj)
+    {
+        bSuccess = bSuccess && ((CCAsyncFileData*)pObj)->getBuffer() != NULL;
+    }
+    loaded(bSuccess);
+}
+
+void AsyncFileReadTest::fontLoaded(CCObject* pConfiguration)
+{
+    loaded(pConfiguration != NULL);
+}
+
+void AsyncFileReadTest::mapLoaded(CCObject* pMapInfo)
+{
+    loaded(pMapInfo != NULL);
+}
+
+void AsyncFileReadTest::loaded(bool bSuccess)
+{
+    m_nFailed += bSuccess ? 0 : 1;
+    if (--m_nPending == 0)
+    {
+        unscheduleUpdate();
+        double total = millisecondsSince(&m_tStart);
+        addResult("all loaded after %.2f ms, %d failed, longest frame %.2f ms", total, m_nFailed, m_dLongestFrame);
+    }
+}
+
+std::string AsyncFileReadTest::title()
+{
+    return "Asynchronous file reads";
+}
+
+std::string AsyncFileReadTest::subtitle()
+{
+    return "plist, FNT and TMX files, with and without blocking. See console";
+}
+
+////////////////////////////////////////////////////////
+//
+// ResourceManifestTest
+//
+////////////////////////////////////////////////////////
+#define RESOURCE_MANIFEST_TEST_MISSING  200
+
+static double resolveAll(const std::vector<std::string>& names, std::vector<std::string>& fullPaths)
+{
+    CCFileUtils *pFileUtils = CCFileUtils::sharedFileUtils();
+    fullPaths.resize(names.size());
+
+    struct cc_timeval start;
+    CCTime::gettimeofdayCocos2d(&start, NULL);
+    for (unsigned int i = 0; i < names.size(); ++i)
+    {
+        fullPaths[i] = pFileUtils->fullPathForFilename(names[i].c_str());
+    }
+    return millisecondsSince(&start);
+}
+
+void ResourceManifestTest::performTests()
+{
+    CCFileUtils *pFileUtils = CCFileUtils::sharedFileUtils();
+
+    // the files of TestCpp, from its manifest, and some that don't exist
+    std::vector<std::string> names;
+    unsigned long nSize = 0;
+    std::string manifestPath = pFileUtils->fullPathForFilename("resources.manifest");
+    unsigned char *pBuffer = pFileUtils->getFileData(manifestPath.c_str(), "rb", &nSize);
+    if (! pBuffer)
+    {
+        addResult("can not read resources.manifest");
+        return;
+    }
+    std::string manifest((const char*)pBuffer, nSize);
+    CC_SAFE_DELETE_ARRAY(pBuffer);
+
+    size_t pos = 0;
+    while (pos < manifest.size())
+    {
+        size_t end = manifest.find('\n', pos);
+        if (end == std::string::npos)
+        {
+            end = manifest.size();
+        }
+        std::string line = manifest.substr(pos, end - pos);
+        if (! line.empty() && line[line.size() - 1] == '\r')
+        {
+            line.erase(line.size() - 1);
+        }
+        if (! line.empty() && line[0] != '#')
+        {
+            names.push_back(line);
+        }
+        pos = end + 1;
+    }
+    int nExisting = names.size();
+    char szName[64];
+    for (int i = 0; i < RESOURCE_MANIFEST_TEST_MISSING; ++i)
+    {
+        snprintf(szName, sizeof(szName), "missing/file%03d.png", i);
+        names.push_back(szName);
+    }
+
+    // what a game with downloadable content and several resolutions searches
+    std::vector<std::string> oldSearchPaths = pFileUtils->getSearchPaths();
+    std::vector<std::string> oldResolutionsOrder = pFileUtils->getSearchResolutionsOrder();
+    std::vector<std::string> searchPaths;
+    searchPaths.push_back("dlc/");
+    searchPaths.push_back("downloaded/");
+    pFileUtils->setSearchPaths(searchPaths);
+    std::vector<std::string> resolutionsOrder;
+    resolutionsOrder.push_back("resources-ipadhd");
+    resolutionsOrder.push_back("resources-ipad");
+    resolutionsOrder.push_back("resources-iphonehd");
+    pFileUtils->setSearchResolutionsOrder(resolutionsOrder);
+
+    addResult("%d files and %d missing ones, %u search paths x %u resolutions",
+              nExisting, RESOURCE_MANIFEST_TEST_MISSING,
+              (unsigned int)pFileUtils->getSearchPaths().size(), (unsigned int)pFileUtils->getSearchResolutionsOrder().size());
+
+    std::vector<std::string> probed;
+    std::vector<std::string> lookedUp;
+
+    pFileUtils->removeResourceManifest();
+    double coldProbing = resolveAll(names, probed);
+    double warmProbing = resolveAll(names, probed);
+    addResult("probing: %.2f ms, again %.2f ms", coldProbing, warmProbing);
+
+    struct cc_timeval start;
+    CCTime::gettimeofdayCocos2d(&start, NULL);
+    bool bLoaded = pFileUtils->loadResourceManifest("resources.manifest");
+    double load = millisecondsSince(&start);
+    if (bLoaded)
+    {
+        double coldManifest = resolveAll(names, lookedUp);
+        double warmManifest = resolveAll(names, lookedUp);
+        addResult("manifest: loaded in %.2f ms, %.2f ms, again %.2f ms", load, coldManifest, warmManifest);
+
+        int nDifferent = 0;
+        for (unsigned int i = 0; i < names.size(); ++i)
+        {
+            nDifferent += probed[i] != lookedUp[i] ? 1 : 0;
+        }
+        addResult("%d paths resolved differently", nDifferent);
+
+        pFileUtils->removeResourceManifest();
+    }
+    else
+    {
+        addResult("can not load resources.manifest");
+    }
+
+    pFileUtils->setSearchPaths(oldSearchPaths);
+    pFileUtils->setSearchResolutionsOrder(oldResolutionsOrder);
+    pFileUtils->purgeCachedEntries();
+}
+
+std::string ResourceManifestTest::title()
+{
+    return "Resource manifest";
+}
+
+std::string ResourceManifestTest::subtitle()
+{
+    return "fullPathForFilename with and without manifest. See console";
+}
+
+////////////////////////////////////////////////////////
+//
+// BinarySpriteSheetTest
+//
+////////////////////////////////////////////////////////
+#define BINARY_SPRITE_SHEET_TEST_LOOPS  50
+
+// converted with tools/sprite-sheet/plist2ccsf.py
+static const char* s_spriteSheets[] = {
+    "animations/grossini",
+    "animations/grossini-aliases",
+    "animations/grossini_family",
+    "zwoptex/grossini",
+    "zwoptex/grossini-generic",
+};
+
+static double loadSpriteSheets(const char* pszExtension)
+{
+    CCSpriteFrameCache *pCache = CCSpriteFrameCache::sharedSpriteFrameCache();
+    struct cc_timeval start;
+    CCTime::gettimeofdayCocos2d(&start, NULL);
+    for (int loop = 0; loop < BINARY_SPRITE_SHEET_TEST_LOOPS; ++loop)
+    {
+        pCache->removeSpriteFrames();
+        for (int i = 0; i < (int)(sizeof(s_spriteSheets) / sizeof(s_spriteSheets[0])); ++i)
+        {
+            std::string file = std::string(s_spriteSheets[i]) + pszExtension;
+            pCache->addSpriteFramesWithFile(file.c_str());
+        }
+    }
+    return millisecondsSince(&start);
+}
+
+typedef std::map<std::string, std::vector<float> > SpriteFrameValues;
+
+static void collectSpriteFrames(SpriteFrameValues& values)
+{
+    CCSpriteFrameCache *pCache = CCSpriteFrameCache::sharedSpriteFrameCache();
+    for (int i = 0; i < (int)(sizeof(s_spriteSheets) / sizeof(s_spriteSheets[0])); ++i)
+    {
+        std::string plist = std::string(s_spriteSheets[i]) + ".plist";
+        CCDictionary *pFrames = (CCDictionary*)CCDictionary::createWithContentsOfFile(plist.c_str())->objectForKey("frames");
+        CCDictElement *pElement = NULL;
+        CCDICT_FOREACH(pFrames, pElement)
+        {
+            CCSpriteFrame *pFrame = pCache->spriteFrameByName(pElement->getStrKey());
+            std::vector<float>& frameValues = values[pElement->getStrKey()];
+            if (pFrame)
+            {
+                CCRect rect = pFrame->getRectInPixels();
+                CCPoint offset = pFrame->getOffsetInPixels();
+                CCSize size = pFrame->getOriginalSizeInPixels();
+                float v[] = { rect.origin.x, rect.origin.y, rect.size.width, rect.size.height,
+                              offset.x, offset.y, size.width, size.height, pFrame->isRotated() ? 1.0f : 0.0f };
+                frameValues.assign(v, v + sizeof(v) / sizeof(v[0]));
+            }
+        }
+    }
+}
+
+void BinarySpriteSheetTest::performTests()
+{
+    CCSpriteFrameCache *pCache = CCSpriteFrameCache::sharedSpriteFrameCache();
+
+    // textures are loaded by the first pass and cached for both measurements
+    loadSpriteSheets(".plist");
+
+    double plist = loadSpriteSheets(".plist");
+    SpriteFrameValues plistFrames;
+    collectSpriteFrames(plistFrames);
+    addResult("plist: %d x %d sheets in %.2f ms", BINARY_SPRITE_SHEET_TEST_LOOPS,
+              (int)(sizeof(s_spriteSheets) / sizeof(s_spriteSheets[0])), plist);
+
+    double binary = loadSpriteSheets(".ccsf");
+    SpriteFrameValues binaryFrames;
+    collectSpriteFrames(binaryFrames);
+    addResult("binary: %d x %d sheets in %.2f ms", BINARY_SPRITE_SHEET_TEST_LOOPS,
+              (int)(sizeof(s_spriteSheets) / sizeof(s_spriteSheets[0])), binary);
+
+    int nDifferent = 0;
+    for (SpriteFrameValues::iterator iter = plistFrames.begin(); iter != plistFrames.end(); ++iter)
+    {
+        nDifferent += (iter->second.empty() || binaryFrames[iter->first] != iter->second) ? 1 : 0;
+    }
+    addResult("%d frames, %d differ", (int)plistFrames.size(), nDifferent);
+
+    pCache->removeSpriteFrames();
+}
+
+std::string BinarySpriteSheetTest::title()
+{
+    return "Binary sprite sheets";
+}
+
+std::string BinarySpriteSheetTest::subtitle()
+{
+    return "addSpriteFramesWithFile with plist and ccsf files. See console";
+}
+
+////////////////////////////////////////////////////////
+//
+// PlistParserTest
+//
+////////////////////////////////////////////////////////
+#define PLIST_PARSER_TEST_LOOPS  20
+
+static const char* s_plists[] = {
+    "animations/animations.plist",
+    "animations/grossini.plist",
+    "animations/grossini_family.plist",
+    "zwoptex/grossini-generic.plist",
+    "Particles/BoilingFoam.plist",
+    "Particles/Phoenix.plist",
+    "Particles/SmallSun.plist",
+};
+
+// How plists were parsed before CCPlistParser: a tinyxml2 document visited by a SAX delegator.
+class SAXPlistBuilder : public CCSAXDelegator
+{
+public:
+    SAXPlistBuilder() : m_pRoot(NULL), m_bText(false) {}
+
+    CCObject* parse(const char* pData, unsigned int uSize)
+    {
+        CCSAXParser parser;
+        parser.init("UTF-8");
+        parser.setDelegator(this);
+        parser.parse(pData, uSize);
+        return m_pRoot;
+    }
+
+    void startElement(void *ctx, const char *name, const char **atts)
+    {
+        std::string sName(name);
+        if (sName == "dict" || sName == "array")
+        {
+            CCObject *pObj = (sName == "dict") ? (CCObject*)new CCDictionary() : (CCObject*)new CCArray();
+            add(pObj);
+            m_stack.push_back(pObj);
+        }
+        m_text.clear();
+        m_bText = (sName == "key" || sName == "string" || sName == "integer" || sName == "real");
+    }
+
+    void endElement(void *ctx, const char *name)
+    {
+        std::string sName(name);
+        if (sName == "dict" || sName == "array")
+        {
+            m_stack.pop_back();
+        }
+        else if (sName == "key")
+        {
+            m_key = m_text;
+        }
+        else if (sName == "string" || sName == "integer" || sName == "real")
+        {
+            add(new CCString(m_text));
+        }
+        else if (sName == "true" || sName == "false")
+        {
+            add(new CCString(sName == "true" ? "1" : "0"));
+        }
+        m_bText = false;
+    }
+
+    void textHandler(void *ctx, const char *s, int len)
+    {
+        if (m_bText)
+        {
+            m_text.append(s, len);
+        }
+    }
+
+private:
+    // takes over the reference of pObj
+    void add(CCObject* pObj)
+    {
+        if (m_stack.empty())
+        {
+            if (! m_pRoot)
+            {
+                m_pRoot = pObj;
+                return;
+            }
+        }
+        else if (CCDictionary *pDict = dynamic_cast<CCDictionary*>(m_stack.back()))
+        {
+            pDict->setObject(pObj, m_key);
+        }
+        else
+        {
+            ((CCArray*)m_stack.back())->addObject(pObj);
+        }
+        pObj->release();
+    }
+
+    CCObject *m_pRoot;
+    std::vector<CCObject*> m_stack;
+    std::string m_key;
+    std::string m_text;
+    bool m_bText;
+};
+
+static bool isSamePlistObject(CCObject* pA, CCObject* pB)
+{
+    CCString *pStringA = dynamic_cast<CCString*>(pA);
+    CCArray *pArrayA = dynamic_cast<CCArray*>(pA);
+    CCDictionary *pDictA = dynamic_cast<CCDictionary*>(pA);
+    if (pStringA)
+    {
+        CCString *pStringB = dynamic_cast<CCString*>(pB);
+        return pStringB && pStringA->m_sString == pStringB->m_sString;
+    }
+    else if (pArrayA)
+    {
+        CCArray *pArrayB = dynamic_cast<CCArray*>(pB);
+        if (! pArrayB || pArrayA->count() != pArrayB->count())
+        {
+            return false;
+        }
+        for (unsigned int i = 0; i < pArrayA->count(); ++i)
+        {
+            if (! isSamePlistObject(pArrayA->objectAtIndex(i), pArrayB->objectAtIndex(i)))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+    else if (pDictA)
+    {
+        CCDictionary *pDictB = dynamic_cast<CCDictionary*>(pB);
+        if (! pDictB || pDictA->count() != pDictB->count())
+        {
+            return false;
+        }
+        CCDictElement *pElement = NULL;
+        CCDICT_FOREACH(pDictA, pElement)
+        {
+            if (! isSamePlistObject(pElement->getObject(), pDictB->objectForKey(pElement->getStrKey())))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+    return false;
+}
+
+void PlistParserTest::performTests()
+{
+    CCFileUtils *pFileUtils = CCFileUtils::sharedFileUtils();
+    std::vector<std::string> contents;
+    double totalBytes = 0;
+    for (int i = 0; i < (int)(sizeof(s_plists) / sizeof(s_plists[0])); ++i)
+    {
+        unsigned long nSize = 0;
+        std::string fullPath = pFileUtils->fullPathForFilename(s_plists[i]);
+        unsigned char *pBuffer = pFileUtils->getFileData(fullPath.c_str(), "rb", &nSize);
+        if (pBuffer)
+        {
+            contents.push_back(std::string((const char*)pBuffer, nSize));
+            totalBytes += nSize;
+        }
+        CC_SAFE_DELETE_ARRAY(pBuffer);
+    }
+    addResult("%d plists, %.1f KB", (int)contents.size(), totalBytes / 1024);
+
+    int nDifferent = 0;
+    for (unsigned int i = 0; i < contents.size(); ++i)
+    {
+        SAXPlistBuilder builder;
+        CCObject *pOld = builder.parse(contents[i].data(), contents[i].size());
+        CCPlistParser parser;
+        CCObject *pNew = parser.dictionaryWithData(contents[i].data(), contents[i].size());
+        nDifferent += isSamePlistObject(pOld, pNew) ? 0 : 1;
+        CC_SAFE_RELEASE(pOld);
+        CC_SAFE_RELEASE(pNew);
+    }
+
+    struct cc_timeval start;
+    CCTime::gettimeofdayCocos2d(&start, NULL);
+    for (int loop = 0; loop < PLIST_PARSER_TEST_LOOPS; ++loop)
+    {
+        for (unsigned int i = 0; i < contents.size(); ++i)
+        {
+            SAXPlistBuilder builder;
+            CCObject *pObj = builder.parse(contents[i].data(), contents[i].size());
+            CC_SAFE_RELEASE(pObj);
+        }
+    }
+    double sax = millisecondsSince(&start);
+
+    CCTime::gettimeofdayCocos2d(&start, NULL);
+    for (int loop = 0; loop < PLIST_PARSER_TEST_LOOPS; ++loop)
+    {
+        for (unsigned int i = 0; i < contents.size(); ++i)
+        {
+            CCPlistParser parser;
+            CCObject *pObj = parser.dictionaryWithData(contents[i].data(), contents[i].size());
+            CC_SAFE_RELEASE(pObj);
+        }
+    }
+    double streaming = millisecondsSince(&start);
+
+    double megabytes = totalBytes * PLIST_PARSER_TEST_LOOPS / (1024 * 1024);
+    addResult("tinyxml2 + SAX: %.2f ms, %.1f MB/s", sax, sax > 0 ? megabytes * 1000 / sax : 0);
+    addResult("CCPlistParser: %.2f ms, %.1f MB/s", streaming, streaming > 0 ? megabytes * 1000 / streaming : 0);
+    addResult("%d plists parsed differently", nDifferent);
+}
+
+std::string PlistParserTest::title()
+{
+    return "Plist parser";
+}
+
+std::string PlistParserTest::subtitle()
+{
+    return "SAX over tinyxml2 against CCPlistParser. See console";
+}
+
+////////////////////////////////////////////////////////
+//
+// LabelRenderingTest
+//
+////////////////////////////////////////////////////////
+#define LABEL_RENDERING_TEST_LABELS   1000
+
+static const char* s_labelFonts[] = {
+    "fonts/Marker Felt.ttf",
+    "fonts/arial.ttf",
+    "fonts/Courier New.ttf",
+};
+
+static const int s_labelFontSizes[] = { 14, 20, 32 };
+
+static const int s_labelFontCount = sizeof(s_labelFonts) / sizeof(s_labelFonts[0]);
+static const int s_labelFontSizeCount = sizeof(s_labelFontSizes) / sizeof(s_labelFontSizes[0]);
+
+// renders LABEL_RENDERING_TEST_LABELS strings never rendered before, like score or name labels
+static double renderLabels(int nFirst, bool bCreateLabels)
+{
+    char szText[64] = {0};
+    struct cc_timeval start;
+    CCTime::gettimeofdayCocos2d(&start, NULL);
+    for (int i = 0; i < LABEL_RENDERING_TEST_LABELS; ++i)
+    {
+        const char *pFont = s_labelFonts[i % s_labelFontCount];
+        int nSize = s_labelFontSizes[(i / s_labelFontCount) % s_labelFontSizeCount];
+        sprintf(szText, "Player %d: %d points", nFirst + i, (nFirst + i) * 37);
+        if (bCreateLabels)
+        {
+            CCLabelTTF::create(szText, pFont, nSize);
+        }
+        else
+        {
+            CCImage image;
+            image.initWithString(szText, 0, 0, CCImage::kAlignCenter, pFont, nSize);
+        }
+    }
+    return millisecondsSince(&start);
+}
+
+void LabelRenderingTest::performTests()
+{
+    double first = renderLabels(0, false);
+    double next = renderLabels(LABEL_RENDERING_TEST_LABELS, false);
+    addResult("CCImage::initWithString: %d labels in %.2f ms, %d more in %.2f ms",
+              LABEL_RENDERING_TEST_LABELS, first, LABEL_RENDERING_TEST_LABELS, next);
+
+    double labels = renderLabels(2 * LABEL_RENDERING_TEST_LABELS, true);
+    addResult("CCLabelTTF::create: %d labels in %.2f ms (%.1f us/label)",
+              LABEL_RENDERING_TEST_LABELS, labels, labels * 1000 / LABEL_RENDERING_TEST_LABELS);
+}
+
+std::string LabelRenderingTest::title()
+{
+    return "Label rendering";
+}
+
+std::string LabelRenderingTest::subtitle()
+{
+    return "1000 distinct labels, 3 fonts x 3 sizes. See console";
+}
+
+////////////////////////////////////////////////////////
+//
+// BMFontLoadingTest
+//
+////////////////////////////////////////////////////////
+#define BMFONT_LOADING_TEST_GLYPHS      8000
+#define BMFONT_LOADING_TEST_KERNINGS    20000
+#define BMFONT_LOADING_TEST_LOOPS       10
+
+static void appendUInt16(std::string& data, unsigned int value)
+{
+    data += (char)(value & 0xff);
+    data += (char)((value >> 8) & 0xff);
+}
+
+static void appendUInt32(std::string& data, unsigned int value)
+{
+    appendUInt16(data, value & 0xffff);
+    appendUInt16(data, value >> 16);
+}
+
+static void appendBlock(std::string& data, char type, const std::string& block)
+{
+    data += type;
+    appendUInt32(data, block.size());
+    data += block;
+}
+
+// writes the same font, like the ones of a CJK game, in the text and in the binary FNT formats
+static bool writeTestFonts(const std::string& textPath, const std::string& binaryPath)
+{
+    std::string text = "info face=\"Test\" size=32 bold=0 italic=0 charset=\"\" unicode=1 stretchH=100 smooth=1 aa=1 padding=1,2,3,4 spacing=1,1\n"
+                       "common lineHeight=37 base=29 scaleW=1024 scaleH=1024 pages=1 packed=0\n"
+                       "page id=0 file=\"bitmapFontTest.png\"\n";
+    std::string info, common, chars, kernings;
+
+    // fontSize, bitField, charSet, stretchH, aa, padding, spacing, outline, fontName
+    appendUInt16(info, 32);
+    info += (char)0x80;
+    info += (char)0;
+    appendUInt16(info, 100);
+    info += (char)1;
+    info += (char)1; info += (char)2; info += (char)3; info += (char)4;
+    info += (char)1; info += (char)1;
+    info += (char)0;
+    info += "Test";
+    info += (char)0;
+
+    // lineHeight, base, scaleW, scaleH, pages, bitField, channels
+    appendUInt16(common, 37);
+    appendUInt16(common, 29);
+    appendUInt16(common, 1024);
+    appendUInt16(common, 1024);
+    appendUInt16(common, 1);
+    common.append(5, (char)0);
+
+    char szLine[256] = {0};
+    sprintf(szLine, "chars count=%d\n", BMFONT_LOADING_TEST_GLYPHS);
+    text += szLine;
+    for (int i = 0; i < BMFONT_LOADING_TEST_GLYPHS; ++i)
+    {
+        int x = (i * 37) % 1000, y = (i * 13) % 1000, w = 8 + i % 20, h = 10 + i % 17;
+        int xOffset = i % 5 - 2, yOffset = i % 9, xAdvance = w + 1;
+        sprintf(szLine, "char id=%-5d x=%-5d y=%-5d width=%-4d height=%-4d xoffset=%-3d yoffset=%-3d xadvance=%-3d page=0  chnl=0\n",
+                i + 32, x, y, w, h, xOffset, yOffset, xAdvance);
+        text += szLine;
+
+        appendUInt32(chars, i + 32);
+        appendUInt16(chars, x);
+        appendUInt16(chars, y);
+        appendUInt16(chars, w);
+        appendUInt16(chars, h);
+        appendUInt16(chars, xOffset & 0xffff);
+        appendUInt16(chars, yOffset);
+        appendUInt16(chars, xAdvance);
+        chars += (char)0;
+        chars += (char)15;
+    }
+
+    sprintf(szLine, "kernings count=%d\n", BMFONT_LOADING_TEST_KERNINGS);
+    text += szLine;
+    for (int i = 0; i < BMFONT_LOADING_TEST_KERNINGS; ++i)
+    {
+        int first = 32 + (i * 7919) % BMFONT_LOADING_TEST_GLYPHS, second = 32 + (i * 104729) % BMFONT_LOADING_TEST_GLYPHS;
+        int amount = i % 7 - 3;
+        sprintf(szLine, "kerning first=%d  second=%d  amount=%d\n", first, second, amount);
+        text += szLine;
+
+        appendUInt32(kernings, first);
+        appendUInt32(kernings, second);
+        appendUInt16(kernings, amount & 0xffff);
+    }
+
+    std::string binary = "BMF";
+    binary += (char)3;
+    appendBlock(binary, 1, info);
+    appendBlock(binary, 2, common);
+    appendBlock(binary, 3, std::string("bitmapFontTest.png", sizeof("bitmapFontTest.png")));
+    appendBlock(binary, 4, chars);
+    appendBlock(binary, 5, kernings);
+
+    FILE *fp = fopen(textPath.c_str(), "wb");
+    if (! fp)
+    {
+        return false;
+    }
+    fwrite(text.data(), 1, text.size(), fp);
+    fclose(fp);
+
+    fp = fopen(binaryPath.c_str(), "wb");
+    if (! fp)
+    {
+        return false;
+    }
+    fwrite(binary.data(), 1, binary.size(), fp);
+    fclose(fp);
+    return true;
+}
+
+static bool isSameFontConfiguration(CCBMFontConfiguration *pFirst, CCBMFontConfiguration *pSecond)
+{
+    if (pFirst->m_nCommonHeight != pSecond->m_nCommonHeight
+        || pFirst->m_tPadding.top != pSecond->m_tPadding.top || pFirst->m_tPadding.left != pSecond->m_tPadding.left
+        || pFirst->m_tPadding.bottom != pSecond->m_tPadding.bottom || pFirst->m_tPadding.right != pSecond->m_tPadding.right
+        || *pFirst->getCharacterSet() != *pSecond->getCharacterSet())
+    {
+        return false;
+    }
+
+    std::set<unsigned int> *pCharacters = pFirst->getCharacterSet();
+    for (std::set<unsigned int>::iterator it = pCharacters->begin(); it != pCharacters->end(); ++it)
+    {
+        const ccBMFontDef *pDef1 = pFirst->fontDefForCharacter(*it);
+        const ccBMFontDef *pDef2 = pSecond->fontDefForCharacter(*it);
+        if (! pDef1->rect.equals(pDef2->rect) || pDef1->xOffset != pDef2->xOffset
+            || pDef1->yOffset != pDef2->yOffset || pDef1->xAdvance != pDef2->xAdvance)
+        {
+            return false;
+        }
+    }
+
+    for (int i = 0; i < BMFONT_LOADING_TEST_KERNINGS; ++i)
+    {
+        unsigned short first = 32 + (i * 7919) % BMFONT_LOADING_TEST_GLYPHS, second = 32 + (i * 104729) % BMFONT_LOADING_TEST_GLYPHS;
+        if (pFirst->kerningAmountForFirst(first, second) != pSecond->kerningAmountForFirst(first, second))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+static double loadFontConfigurations(const std::string& path)
+{
+    struct cc_timeval start;
+    CCTime::gettimeofdayCocos2d(&start, NULL);
+    for (int i = 0; i < BMFONT_LOADING_TEST_LOOPS; ++i)
+    {
+        CCBMFontConfiguration *pConfiguration = new CCBMFontConfiguration();
+        pConfiguration->initWithFNTfile(path.c_str());
+        pConfiguration->release();
+    }
+    return millisecondsSince(&start) / BMFONT_LOADING_TEST_LOOPS;
+}
+
+void BMFontLoadingTest::performTests()
+{
+    std::string writablePath = CCFileUtils::sharedFileUtils()->getWritablePath();
+    std::string textPath = writablePath + "bmfont-loading-test.fnt";
+    std::string binaryPath = writablePath + "bmfont-loading-test-binary.fnt";
+    if (! writeTestFonts(textPath, binaryPath))
+    {
+        addResult("Can not write the test fonts in %s", writablePath.c_str());
+        return;
+    }
+    addResult("%d glyphs, %d kerning pairs", BMFONT_LOADING_TEST_GLYPHS, BMFONT_LOADING_TEST_KERNINGS);
+
+    CCBMFontConfiguration *pText = CCBMFontConfiguration::create(textPath.c_str());
+    CCBMFontConfiguration *pBinary = CCBMFontConfiguration::create(binaryPath.c_str());
+    if (! pText || ! pBinary)
+    {
+        addResult("Can not load the test fonts");
+        return;
+    }
+    addResult("Text and binary fonts are %s", isSameFontConfiguration(pText, pBinary) ? "the same" : "DIFFERENT");
+
+    addResult("Text FNT: %.2f ms", loadFontConfigurations(textPath));
+    addResult("Binary FNT: %.2f ms", loadFontConfigurations(binaryPath));
+
+    remove(textPath.c_str());
+    remove(binaryPath.c_str());
+}
+
+std::string BMFontLoadingTest::title()
+{
+    return "BMFont loading";
+}
+
+std::string BMFontLoadingTest::subtitle()
+{
+    return "Text against binary FNT files. See console";
+}
+
+////////////////////////////////////////////////////////
+//
+// TMXLoadingTest
+//
+////////////////////////////////////////////////////////
+#define TMX_LOADING_TEST_SIZE       1024
+#define TMX_LOADING_TEST_LOOPS      5
+
+static std::string encodeBase64(const unsigned char *pData, unsigned long uLength)
+{
+    static const char *s_alphabet = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    std::string out;
+    out.reserve((uLength + 2) / 3 * 4);
+    for (unsigned long i = 0; i < uLength; i += 3)
+    {
+        unsigned int v = pData[i] << 16;
+        if (i + 1 < uLength) v |= pData[i + 1] << 8;
+        if (i + 2 < uLength) v |= pData[i + 2];
+        out += s_alphabet[(v >> 18) & 63];
+        out += s_alphabet[(v >> 12) & 63];
+        out += i + 1 < uLength ? s_alphabet[(v >> 6) & 63] : '=';
+        out += i + 2 < uLength ? s_alphabet[v & 63] : '=';
+    }
+    return out;
+}
+
+static bool writeTestMap(const std::string& path, const char *pszDataAttributes, const std::string& data)
+{
+    FILE *fp = fopen(path.c_str(), "wb");
+    if (! fp)
+    {
+        return false;
+    }
+    fprintf(fp, "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+                "<map version=\"1.0\" orientation=\"orthogonal\" width=\"%d\" height=\"%d\" tilewidth=\"32\" tileheight=\"32\">\n"
+                " <tileset firstgid=\"1\" name=\"tiles\" tilewidth=\"32\" tileheight=\"32\">\n"
+                "  <image source=\"fixed-ortho-test2.png\"/>\n"
+                " </tileset>\n"
+                " <layer name=\"Layer 0\" width=\"%d\" height=\"%d\">\n"
+                "  <data %s>\n",
+                TMX_LOADING_TEST_SIZE, TMX_LOADING_TEST_SIZE, TMX_LOADING_TEST_SIZE, TMX_LOADING_TEST_SIZE, pszDataAttributes);
+    fwrite(data.data(), 1, data.size(), fp);
+    fprintf(fp, "\n  </data>\n </layer>\n</map>\n");
+    fclose(fp);
+    return true;
+}
+
+// a value of /proc/self/status in KB, like "VmRSS:", or -1 if it can't be read
+static long processMemory(const char *pszKey)
+{
+    long lValue = -1;
+#if (CC_TARGET_PLATFORM == CC_PLATFORM_LINUX)
+    FILE *fp = fopen("/proc/self/status", "r");
+    if (fp)
+    {
+        char szLine[256] = {0};
+        size_t uKeyLength = strlen(pszKey);
+        while (fgets(szLine, sizeof(szLine), fp))
+        {
+            if (strncmp(szLine, pszKey, uKeyLength) == 0)
+            {
+                lValue = atol(szLine + uKeyLength);
+            }
+        }
+        fclose(fp);
+    }
+#endif
+    return lValue;
+}
+
+static void resetPeakMemory()
+{
+#if (CC_TARGET_PLATFORM == CC_PLATFORM_LINUX)
+    // writing 5 to clear_refs resets the peak to the current resident memory
+    FILE *fp = fopen("/proc/self/clear_refs", "w");
+    if (fp)
+    {
+        fputs("5", fp);
+        fclose(fp);
+    }
+#endif
+}
+
+static void testMapLoading(TMXLoadingTest *pTest, const char *pszName, const std::string& path, const std::vector<unsigned int>& tiles)
+{
+    // the peak is measured on the first load, before the heap has room for the map
+    resetPeakMemory();
+    long lBefore = processMemory("VmRSS:");
+    CCTMXMapInfo *pMapInfo = new CCTMXMapInfo();
+    bool bLoaded = pMapInfo->initWithTMXFile(path.c_str());
+    long lPeak = processMemory("VmHWM:");
+
+    CCTMXLayerInfo *pLayer = bLoaded ? (CCTMXLayerInfo*)pMapInfo->getLayers()->lastObject() : NULL;
+    bool bSame = pLayer && pLayer->m_pTiles && memcmp(pLayer->m_pTiles, &tiles[0], tiles.size() * sizeof(unsigned int)) == 0;
+    pMapInfo->release();
+
+    struct cc_timeval start;
+    CCTime::gettimeofdayCocos2d(&start, NULL);
+    for (int i = 0; i < TMX_LOADING_TEST_LOOPS; ++i)
+    {
+        pMapInfo = new CCTMXMapInfo();
+        pMapInfo->initWithTMXFile(path.c_str());
+        pMapInfo->release();
+    }
+    double time = millisecondsSince(&start) / TMX_LOADING_TEST_LOOPS;
+
+    if (lBefore >= 0 && lPeak >= 0)
+    {
+        pTest->addResult("%s: %.2f ms, peak memory +%ld KB%s", pszName, time, lPeak - lBefore, bSame ? "" : ", DIFFERENT TILES");
+    }
+    else
+    {
+        pTest->addResult("%s: %.2f ms%s", pszName, time, bSame ? "" : ", DIFFERENT TILES");
+    }
+}
+
+void TMXLoadingTest::performTests()
+{
+    std::string writablePath = CCFileUtils::sharedFileUtils()->getWritablePath();
+    const char *pszNames[] = { "base64", "base64 zlib", "csv" };
+    std::string paths[] = { writablePath + "tmx-loading-test-base64.tmx",
+                            writablePath + "tmx-loading-test-zlib.tmx",
+                            writablePath + "tmx-loading-test-csv.tmx" };
+
+    // tiles of the 4 x 4 tileset, with some empty and flipped ones
+    std::vector<unsigned int> tiles(TMX_LOADING_TEST_SIZE * TMX_LOADING_TEST_SIZE);
+    for (unsigned int i = 0; i < tiles.size(); ++i)
+    {
+        unsigned int gid = (i * 7 + i / TMX_LOADING_TEST_SIZE) % 17;
+        tiles[i] = (gid != 0 && i % 97 == 0) ? (gid | kCCTMXTileHorizontalFlag) : gid;
+    }
+    const unsigned char *pBytes = (const unsigned char*)&tiles[0];
+    unsigned long uLength = tiles.size() * sizeof(unsigned int);
+
+    uLongf uCompressedLength = compressBound(uLength);
+    std::vector<unsigned char> compressed(uCompressedLength);
+    compress(&compressed[0], &uCompressedLength, pBytes, uLength);
+
+    std::string csv;
+    char szValue[16] = {0};
+    for (unsigned int i = 0; i < tiles.size(); ++i)
+    {
+        sprintf(szValue, i % TMX_LOADING_TEST_SIZE ? ",%u" : (i ? ",\n%u" : "%u"), tiles[i]);
+        csv += szValue;
+    }
+
+    if (! writeTestMap(paths[0], "encoding=\"base64\"", encodeBase64(pBytes, uLength))
+        || ! writeTestMap(paths[1], "encoding=\"base64\" compression=\"zlib\"", encodeBase64(&compressed[0], uCompressedLength))
+        || ! writeTestMap(paths[2], "encoding=\"csv\"", csv))
+    {
+        addResult("Can not write the test maps in %s", writablePath.c_str());
+        return;
+    }
+    addResult("%dx%d tiles, %lu KB of tiles", TMX_LOADING_TEST_SIZE, TMX_LOADING_TEST_SIZE, uLength / 1024);
+
+    for (int i = 0; i < 3; ++i)
+    {
+        testMapLoading(this, pszNames[i], paths[i], tiles);
+    }
+
+    bool bCacheEnabled = CCTMXMapInfo::isBinaryCacheEnabled();
+    CCTMXMapInfo::setBinaryCacheEnabled(true);
+    // writes the cache
+    CCTMXMapInfo::formatWithTMXFile(paths[1].c_str());
+    testMapLoading(this, "base64 zlib, cached", paths[1], tiles);
+    CCTMXMapInfo::setBinaryCacheEnabled(bCacheEnabled);
+    CCTMXMapInfo::removeBinaryCache(paths[1].c_str());
+
+    for (int i = 0; i < 3; ++i)
+    {
+        remove(paths[i].c_str());
+    }
+}
+
+std::string TMXLoadingTest::title()
+{
+    return "TMX loading";
+}
+
+std::string TMXLoadingTest::subtitle()
+{
+    return "1024x1024 map in each encoding, and from the binary cache. See console";
+}
+
+////////////////////////////////////////////////////////
+//
+// PagedTileMapTest
+//
+////////////////////////////////////////////////////////
+#define PAGED_TILE_MAP_TEST_SIZE    10000
+#define PAGED_TILE_MAP_TEST_ROAD    48
+// tiles flown by frame
+#define PAGED_TILE_MAP_TEST_SPEED   8.0f
+
+void PagedTileMapTest::performTests()
+{
+    m_sPageFile = CCFileUtils::sharedFileUtils()->getWritablePath() + "paged-tilemap-test.ccp";
+
+    CCTMXMapInfo *pMapInfo = new CCTMXMapInfo();
+    pMapInfo->autorelease();
+    pMapInfo->setOrientation(CCTMXOrientationOrtho);
+    pMapInfo->setTileSize(CCSizeMake(32, 32));
+
+    CCTMXLayerInfo *pLayerInfo = new CCTMXLayerInfo();
+    pLayerInfo->autorelease();
+    pLayerInfo->m_sName = "world";
+    pLayerInfo->m_tLayerSize = CCSizeMake(PAGED_TILE_MAP_TEST_SIZE, PAGED_TILE_MAP_TEST_SIZE);
+    pLayerInfo->m_cOpacity = 255;
+
+    CCTMXTilesetInfo *pTilesetInfo = new CCTMXTilesetInfo();
+    pTilesetInfo->autorelease();
+    pTilesetInfo->m_sName = "tiles";
+    pTilesetInfo->m_uFirstGid = 1;
+    pTilesetInfo->m_tTileSize = CCSizeMake(32, 32);
+    pTilesetInfo->m_uSpacing = 2;
+    pTilesetInfo->m_uMargin = 2;
+    pTilesetInfo->m_sSourceImage = "TileMaps/fixed-ortho-test2.png";
+
+    if (! CCTMXPagedLayer::createPageFile(m_sPageFile.c_str(), pTilesetInfo, pLayerInfo, pMapInfo))
+    {
+        addResult("Can not write the page file in %s", m_sPageFile.c_str());
+        return;
+    }
+
+    // a road along the diagonal, written through the layer so that the pages go through the LRU
+    struct cc_timeval start;
+    CCTime::gettimeofdayCocos2d(&start, NULL);
+    CCTMXPagedLayer *pLayer = new CCTMXPagedLayer();
+    if (! pLayer->initWithPageFile(m_sPageFile.c_str()))
+    {
+        pLayer->release();
+        addResult("Can not read the page file %s", m_sPageFile.c_str());
+        return;
+    }
+    for (int y = 0; y < PAGED_TILE_MAP_TEST_SIZE; ++y)
+    {
+        for (int x = MAX(y - PAGED_TILE_MAP_TEST_ROAD, 0); x < MIN(y + PAGED_TILE_MAP_TEST_ROAD, PAGED_TILE_MAP_TEST_SIZE); ++x)
+        {
+            pLayer->setTileGID(1 + (x * 7 + y * 3) % 40, ccp(x, y));
+        }
+    }
+    pLayer->flush();
+    addResult("%dx%d tiles, %u pages written in %.2f ms, %u pages in memory at most",
+              PAGED_TILE_MAP_TEST_SIZE, PAGED_TILE_MAP_TEST_SIZE, pLayer->getWrittenPageCount(), millisecondsSince(&start), pLayer->getMaxResidentPages());
+    pLayer->release();
+
+    // flies along the road from a layer without pages in memory
+    m_pLayer = CCTMXPagedLayer::create(m_sPageFile.c_str());
+    addChild(m_pLayer, -1);
+    m_fProgress = 0;
+    m_nFrames = 0;
+    m_uMaxResidentPages = 0;
+    m_uMaxResidentBytes = 0;
+    m_dLongestFrame = 0;
+    CCTime::gettimeofdayCocos2d(&m_tLastFrame, NULL);
+    scheduleUpdate();
+}
+
+void PagedTileMapTest::update(float dt)
+{
+    if (! m_pLayer)
+    {
+        return;
+    }
+
+    // the frames drawn, the first one reads the first pages
+    if (m_nFrames > 1)
+    {
+        m_dLongestFrame = MAX(m_dLongestFrame, millisecondsSince(&m_tLastFrame));
+    }
+    CCTime::gettimeofdayCocos2d(&m_tLastFrame, NULL);
+
+    m_uMaxResidentPages = MAX(m_uMaxResidentPages, m_pLayer->getResidentPageCount());
+    m_uMaxResidentBytes = MAX(m_uMaxResidentBytes, m_pLayer->getResidentBytes());
+
+    m_fProgress += PAGED_TILE_MAP_TEST_SPEED;
+    if (m_fProgress >= PAGED_TILE_MAP_TEST_SIZE - 1)
+    {
+        finish();
+        return;
+    }
+
+    CCSize s = CCDirector::sharedDirector()->getWinSize();
+    CCPoint tile = m_pLayer->positionAt(ccp(m_fProgress, m_fProgress));
+    m_pLayer->setPosition(ccp(s.width / 2 - tile.x, s.height / 2 - tile.y));
+    ++m_nFrames;
+}
+
+void PagedTileMapTest::finish()
+{
+    unscheduleUpdate();
+    addResult("flown in %d frames, longest frame %.2f ms", m_nFrames, m_dLongestFrame);
+    addResult("at most %u pages, %u KB of tiles in memory", m_uMaxResidentPages, m_uMaxResidentBytes / 1024);
+    addResult("%u pages read, %u without waiting, %u released",
+              m_pLayer->getLoadedPageCount(), m_pLayer->getSyncLoadedPageCount(), m_pLayer->getEvictedPageCount());
+
+    removeChild(m_pLayer, true);
+    m_pLayer = NULL;
+    remove(m_sPageFile.c_str());
+}
+
+void PagedTileMapTest::onExit()
+{
+    if (m_pLayer)
+    {
+        unscheduleUpdate();
+        removeChild(m_pLayer, true);
+        m_pLayer = NULL;
+        remove(m_sPageFile.c_str());
+    }
+    LoadingMenuLayer::onExit();
+}
+
+std::string PagedTileMapTest::title()
+{
+    return "Paged tile map";
+}
+
+std::string PagedTileMapTest::subtitle()
+{
+    return "Flying across a 10000x10000 map with bounded memory. See console";
+}
+
+////////////////////////////////////////////////////////
+//
+// ShaderLoadingTest
+//
+////////////////////////////////////////////////////////
+
+// loads programs with the sources of the default shaders, deferred or not
+static double loadPrograms(bool bDeferred, unsigned int* pBinaryCount)
+{
+    const GLchar* sources[][2] = {
+        { ccPositionTextureColor_vert, ccPositionTextureColor_frag },
+        { ccPositionTextureColor_vert, ccPositionTextureColorAlphaTest_frag },
+        { ccPositionColor_vert, ccPositionColor_frag },
+        { ccPositionTexture_vert, ccPositionTexture_frag },
+        { ccPositionTexture_uColor_vert, ccPositionTexture_uColor_frag },
+        { ccPositionTextureA8Color_vert, ccPositionTextureA8Color_frag },
+        { ccPosition_uColor_vert, ccPosition_uColor_frag },
+        { ccPositionColorLengthTexture_vert, ccPositionColorLengthTexture_frag },
+    };
+    const int nPrograms = sizeof(sources) / sizeof(sources[0]);
+
+    struct cc_timeval start;
+    CCTime::gettimeofdayCocos2d(&start, NULL);
+    for (int i = 0; i < nPrograms; ++i)
+    {
+        CCGLProgram* pProgram = new CCGLProgram();
+        if (bDeferred)
+        {
+            pProgram->initWithVertexShaderByteArrayDeferred(sources[i][0], sources[i][1]);
+        }
+        else
+        {
+            pProgram->initWithVertexShaderByteArray(sources[i][0], sources[i][1]);
+        }
+        pProgram->addAttribute(kCCAttributeNamePosition, kCCVertexAttrib_Position);
+        pProgram->link();
+        pProgram->updateUniforms();
+        pProgram->load();
+        if (pProgram->isLoadedFromBinary())
+        {
+            ++*pBinaryCount;
+        }
+        pProgram->release();
+    }
+    return millisecondsSince(&start);
+}
+
+void ShaderLoadingTest::performTests()
+{
+    CCShaderCache* pCache = CCShaderCache::sharedShaderCache();
+    addResult("CCShaderCache: %u default programs used since startup, %u read from the binary cache, in %.2f ms",
+              pCache->getLoadedProgramCount(), pCache->getBinaryProgramCount(), pCache->getProgramLoadTime());
+
+    unsigned int uBinaryCount = 0;
+    double compiled = loadPrograms(false, &uBinaryCount);
+    addResult("compiling the 8 default programs: %.2f ms", compiled);
+
+    double first = loadPrograms(true, &uBinaryCount);
+    double second = loadPrograms(true, &uBinaryCount);
+    addResult("deferred: %.2f ms, again: %.2f ms, %u programs read from the binary cache",
+              first, second, uBinaryCount);
+
+    ccGLUseProgram(0);
+}
+
+std::string ShaderLoadingTest::title()
+{
+    return "Shader loading";
+}
+
+std::string ShaderLoadingTest::subtitle()
+{
+    return "Compiled vs. deferred and binary cached programs. See console";
+}
+
+void runLoadingTest()
+{
+    s_nLoadingCurCase = 0;
+    LoadingMenuLayer* pLayer = new ZipIndexTest(true, TEST_COUNT, s_nLoadingCurCase);
+
+    CCScene* pScene = CCScene::create();
+    pScene->addChild(pLayer);
+    pLayer->release();
+
+    CCDirector::sharedDirector()->replaceScene(pScene);
+}
@@ -0,0 +1,204 @@
+#ifndef __PERFORMANCE_LOADING_TEST_H__
+#define __PERFORMANCE_LOADING_TEST_H__
+
+#include "PerformanceTest.h"
+
+class LoadingMenuLayer : public PerformBasicLayer
+{
+public:
+    LoadingMenuLayer(bool bControlMenuVisible, int nMaxCases = 0, int nCurCase = 0)
+        :PerformBasicLayer(bControlMenuVisible, nMaxCases, nCurCase)
+    {
+    }
+
+    virtual void showCurrentTest();
+
+    virtual void onEnter();
+    virtual std::string title();
+    virtual std::string subtitle();
+    virtual void performTests() = 0;
+
+    // adds a line of results below the subtitle, and logs it
+    void addResult(const char* format, ...);
+
+protected:
+    int m_nResultLines;
+};
+
+class ZipIndexTest : public LoadingMenuLayer
+{
+public:
+    ZipIndexTest(bool bControlMenuVisible, int nMaxCases = 0, int nCurCase = 0)
+        :LoadingMenuLayer(bControlMenuVisible, nMaxCases, nCurCase)
+    {
+    }
+
+    virtual void performTests();
+    virtual std::string title();
+    virtual std::string subtitle();
+};
+
+class FilePackTest : public LoadingMenuLayer
+{
+public:
+    FilePackTest(bool bControlMenuVisible, int nMaxCases = 0, int nCurCase = 0)
+        :LoadingMenuLayer(bControlMenuVisible, nMaxCases, nCurCase)
+    {
+    }
+
+    virtual void performTests();
+    virtual std::string title();
+    virtual std::string subtitle();
+};
+
+class AsyncFileReadTest : public LoadingMenuLayer
+{
+public:
+    AsyncFileReadTest(bool bControlMenuVisible, int nMaxCases = 0, int nCurCase = 0)
+        :LoadingMenuLayer(bControlMenuVisible, nMaxCases, nCurCase)
+    {
+    }
+
+    virtual void performTests();
+    virtual std::string title();
+    virtual std::string subtitle();
+
+    void update(float dt);
+    void plistLoaded(CCObject* pDict);
+    void batchLoaded(CCObject* pResults);
+    void fontLoaded(CCObject* pConfiguration);
+    void mapLoaded(CCObject* pMapInfo);
+
+private:
+    void loaded(bool bSuccess);
+
+    int m_nPending;
+    int m_nFailed;
+    double m_dLongestFrame;
+    struct cc_timeval m_tStart;
+    struct cc_timeval m_tLastFrame;
+};
+
+class ResourceManifestTest : public LoadingMenuLayer
+{
+public:
+    ResourceManifestTest(bool bControlMenuVisible, int nMaxCases = 0, int nCurCase = 0)
+        :LoadingMenuLayer(bControlMenuVisible, nMaxCases, nCurCase)
+    {
+    }
+
+    virtual void performTests();
+    virtual std::string title();
+    virtual std::string subtitle();
+};
+
+class BinarySpriteSheetTest : public LoadingMenuLayer
+{
+public:
+    BinarySpriteSheetTest(bool bControlMenuVisible, int nMaxCases = 0, int nCurCase = 0)
+        :LoadingMenuLayer(bControlMenuVisible, nMaxCases, nCurCase)
+    {
+    }
+
+    virtual void performTests();
+    virtual std::string title();
+    virtual std::string subtitle();
+};
+
+class PlistParserTest : public LoadingMenuLayer
+{
+public:
+    PlistParserTest(bool bControlMenuVisible, int nMaxCases = 0, int nCurCase = 0)
+        :LoadingMenuLayer(bControlMenuVisible, nMaxCases, nCurCase)
+    {
+    }
+
+    virtual void performTests();
+    virtual std::string title();
+    virtual std::string subtitle();
+};
+
+class LabelRenderingTest : public LoadingMenuLayer
+{
+public:
+    LabelRenderingTest(bool bControlMenuVisible, int nMaxCases = 0, int nCurCase = 0)
+        :LoadingMenuLayer(bControlMenuVisible, nMaxCases, nCurCase)
+    {
+    }
+
+    virtual void performTests();
+    virtual std::string title();
+    virtual std::string subtitle();
+};
+
+class BMFontLoadingTest : public LoadingMenuLayer
+{
+public:
+    BMFontLoadingTest(bool bControlMenuVisible, int nMaxCases = 0, int nCurCase = 0)
+        :LoadingMenuLayer(bControlMenuVisible, nMaxCases, nCurCase)
+    {
+    }
+
+    virtual void performTests();
+    virtual std::string title();
+    virtual std::string subtitle();
+};
+
+class TMXLoadingTest : public LoadingMenuLayer
+{
+public:
+    TMXLoadingTest(bool bControlMenuVisible, int nMaxCases = 0, int nCurCase = 0)
+        :LoadingMenuLayer(bControlMenuVisible, nMaxCases, nCurCase)
+    {
+    }
+
+    virtual void performTests();
+    virtual std::string title();
+    virtual std::string subtitle();
+};
+
+class PagedTileMapTest : public LoadingMenuLayer
+{
+public:
+    PagedTileMapTest(bool bControlMenuVisible, int nMaxCases = 0, int nCurCase = 0)
+        :LoadingMenuLayer(bControlMenuVisible, nMaxCases, nCurCase)
+        ,m_pLayer(NULL)
+    {
+    }
+
+    virtual void performTests();
+    virtual std::string title();
+    virtual std::string subtitle();
+    virtual void onExit();
+
+    void update(float dt);
+
+private:
+    void finish();
+
+    std::string m_sPageFile;
+    CCTMXPagedLayer *m_pLayer;
+    float m_fProgress;
+    int m_nFrames;
+    unsigned int m_uMaxResidentPages;
+    unsigned int m_uMaxResidentBytes;
+    double m_dLongestFrame;
+    struct cc_timeval m_tLastFrame;
+};
+
+class ShaderLoadingTest : public LoadingMenuLayer
+{
+public:
+    ShaderLoadingTest(bool bControlMenuVisible, int nMaxCases = 0, int nCurCase = 0)
+        :LoadingMenuLayer(bControlMenuVisible, nMaxCases, nCurCase)
+    {
+    }
+
+    virtual void performTests();
+    virtual std::string title();
+    virtual std::string subtitle();
+};
+
+void runLoadingTest();
+
+#endif
@@ -5,10 +5,12 @@
 #include "PerformanceSpriteTest.h"
 #include "PerformanceTextureTest.h"
 #include "PerformanceTouchesTest.h"
+#include "PerformanceLoadingTest.h"
+#include "PerformanceGridTest.h"
 
 enum
 {
-    MAX_COUNT = 5,
+    MAX_COUNT = 7,
     LINE_SPACE = 40,
     kItemTagBasic = 1000,
 };
@@ -19,7 +21,9 @@ const std::string testsName[MAX_COUNT] =
     "PerformanceParticleTest",
     "PerformanceSpriteTest",
     "PerformanceTextureTest",
-    "PerformanceTouchesTest"
+    "PerformanceTouchesTest",
+    "PerformanceLoadingTest",
+    "PerformanceGridTest"
 };
 
 ////////////////////////////////////////////////////////
@@ -70,6 +74,12 @@ void PerformanceMainLayer::menuCallback(CCObject* pSender)
     case 4:
         runTouchesTest();
         break;
+    case 5:
+        runLoadingTest();
+        break;
+    case 6:
+        runGridTest();
+        break;
     default:
         break;
     }
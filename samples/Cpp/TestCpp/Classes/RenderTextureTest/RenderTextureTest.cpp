@@ -481,25 +481,25 @@ RenderTextureTestDepthStencil::RenderTextureTestDepthStencil()
     sprite->setScale(10);
     CCRenderTexture *rend = CCRenderTexture::create(s.width, s.height, kCCTexture2DPixelFormat_RGBA4444, GL_DEPTH24_STENCIL8);
 
-    glStencilMask(0xFF);
+    ccGLStencilMask(0xFF);
     rend->beginWithClear(0, 0, 0, 0, 0, 0);
 
     //! mark sprite quad into stencil buffer
-    glEnable(GL_STENCIL_TEST);
-    glStencilFunc(GL_ALWAYS, 1, 0xFF);
-    glStencilOp(GL_KEEP, GL_KEEP, GL_REPLACE);
+    ccGLSetCapability(GL_STENCIL_TEST, true);
+    ccGLStencilFunc(GL_ALWAYS, 1, 0xFF);
+    ccGLStencilOp(GL_KEEP, GL_KEEP, GL_REPLACE);
     glColorMask(0, 0, 0, 1);
     sprite->visit();
 
     //! move sprite half width and height, and draw only where not marked
     sprite->setPosition(ccpAdd(sprite->getPosition(), ccpMult(ccp(sprite->getContentSize().width * sprite->getScale(), sprite->getContentSize().height * sprite->getScale()), 0.5)));
-    glStencilFunc(GL_NOTEQUAL, 1, 0xFF);
+    ccGLStencilFunc(GL_NOTEQUAL, 1, 0xFF);
     glColorMask(1, 1, 1, 1);
     sprite->visit();
 
     rend->end();
 
-    glDisable(GL_STENCIL_TEST);
+    ccGLSetCapability(GL_STENCIL_TEST, false);
 
     rend->setPosition(ccp(s.width * 0.5f, s.height * 0.5f));
 
@@ -59,6 +59,7 @@ TESTLAYER_CREATE_FUNC(TextureWEBP);
 TESTLAYER_CREATE_FUNC(TexturePixelFormat);
 TESTLAYER_CREATE_FUNC(TextureBlend);
 TESTLAYER_CREATE_FUNC(TextureAsync);
+TESTLAYER_CREATE_FUNC(TextureReloadAsync);
 TESTLAYER_CREATE_FUNC(TextureGlClamp);
 TESTLAYER_CREATE_FUNC(TextureGlRepeat);
 TESTLAYER_CREATE_FUNC(TextureSizeTest);
@@ -112,6 +113,7 @@ static NEWTEXTURE2DTESTFUNC createFunctions[] =
     createTexturePixelFormat,
     createTextureBlend,
     createTextureAsync,
+    createTextureReloadAsync,
     createTextureGlClamp,
     createTextureGlRepeat,
     createTextureSizeTest,
@@ -1613,6 +1615,109 @@ std::string TextureAsync::subtitle()
     return "Textures should load while an animation is being run";
 }
 
+//------------------------------------------------------------------
+//
+// TextureReloadAsync
+//
+//------------------------------------------------------------------
+void TextureReloadAsync::onEnter()
+{
+    TextureDemo::onEnter();
+
+    CCSize size = CCDirector::sharedDirector()->getWinSize();
+
+    // used by the running scene, restored first
+    for (int i = 0; i < 8; i++)
+    {
+        char szSpriteName[100] = {0};
+        sprintf(szSpriteName, "Images/sprites_test/sprite-0-%d.png", i);
+        CCSprite *sprite = CCSprite::create(szSpriteName);
+        sprite->setPosition(ccp(size.width / 2 + (i - 4) * 40 + 20, size.height / 2));
+        addChild(sprite, 0);
+    }
+
+    // only cached, restored afterwards
+    for (int i = 1; i < 8; i++)
+    {
+        for (int j = 0; j < 8; j++)
+        {
+            char szSpriteName[100] = {0};
+            sprintf(szSpriteName, "Images/sprites_test/sprite-%d-%d.png", i, j);
+            CCTextureCache::sharedTextureCache()->addImage(szSpriteName);
+        }
+    }
+    CCTextureCache::sharedTextureCache()->addImage("Images/background1.jpg");
+    CCTextureCache::sharedTextureCache()->addImage("Images/background2.jpg");
+
+    m_pProgress = CCLabelTTF::create("", "Arial", 16);
+    m_pProgress->setPosition(ccp(size.width / 2, size.height / 2 - 60));
+    addChild(m_pProgress, 10);
+
+    scheduleOnce(schedule_selector(TextureReloadAsync::simulateContextLoss), 1.0f);
+}
+
+TextureReloadAsync::~TextureReloadAsync()
+{
+    CCTextureCache::sharedTextureCache()->removeUnusedTextures();
+}
+
+void TextureReloadAsync::simulateContextLoss(float dt)
+{
+#if CC_ENABLE_CACHE_TEXTURE_DATA
+    // throw away the GL side of every texture, as a context loss would
+    CCDictionary *pTextures = CCTextureCache::sharedTextureCache()->snapshotTextures();
+    CCDictElement *pElement = NULL;
+    CCDICT_FOREACH(pTextures, pElement)
+    {
+        GLuint name = ((CCTexture2D*)pElement->getObject())->getName();
+        ccGLDeleteTexture(name);
+    }
+    pTextures->release();
+    ccGLInvalidateStateCache();
+#endif
+
+    CCTime::gettimeofdayCocos2d(&m_tReloadStart, NULL);
+    CCTextureCache::reloadAllTexturesAsync(this, callfunc_selector(TextureReloadAsync::runningSceneRestored));
+    schedule(schedule_selector(TextureReloadAsync::updateProgress));
+}
+
+void TextureReloadAsync::runningSceneRestored()
+{
+    struct cc_timeval now;
+    CCTime::gettimeofdayCocos2d(&now, NULL);
+    CCLog("TextureReloadAsync: running scene restored after %.2f ms", CCTime::timersubCocos2d(&m_tReloadStart, &now));
+}
+
+void TextureReloadAsync::updateProgress(float dt)
+{
+    float progress = CCTextureCache::getReloadProgress();
+
+    char szProgress[50] = {0};
+    sprintf(szProgress, "reloaded %d%%", (int)(progress * 100));
+    m_pProgress->setString(szProgress);
+
+    if (progress >= 1.0f)
+    {
+        struct cc_timeval now;
+        CCTime::gettimeofdayCocos2d(&now, NULL);
+        CCLog("TextureReloadAsync: all textures restored after %.2f ms", CCTime::timersubCocos2d(&m_tReloadStart, &now));
+        unschedule(schedule_selector(TextureReloadAsync::updateProgress));
+    }
+}
+
+std::string TextureReloadAsync::title()
+{
+    return "Texture Reload Async";
+}
+
+std::string TextureReloadAsync::subtitle()
+{
+#if CC_ENABLE_CACHE_TEXTURE_DATA
+    return "Simulates a context loss, sprites should come back first";
+#else
+    return "Needs CC_ENABLE_CACHE_TEXTURE_DATA to simulate a context loss";
+#endif
+}
 
 //------------------------------------------------------------------
 //
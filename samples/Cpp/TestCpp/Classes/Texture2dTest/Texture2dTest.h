@@ -355,6 +355,21 @@ private:
     int m_nImageOffset;
 };
 
+class TextureReloadAsync : public TextureDemo
+{
+public:
+    virtual ~TextureReloadAsync();
+    virtual std::string title();
+    virtual std::string subtitle();
+    virtual void onEnter();
+    void simulateContextLoss(float dt);
+    void runningSceneRestored();
+    void updateProgress(float dt);
+private:
+    CCLabelTTF *m_pProgress;
+    struct cc_timeval m_tReloadStart;
+};
+
 class TextureGlRepeat : public TextureDemo
 {
 public:
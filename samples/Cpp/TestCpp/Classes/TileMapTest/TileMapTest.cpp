@@ -1355,7 +1355,7 @@ enum
 
 static int sceneIdx = -1; 
 
-#define MAX_LAYER    28
+#define MAX_LAYER    30
 
 CCLayer* createTileMapLayer(int nIndex)
 {
@@ -1389,6 +1389,8 @@ CCLayer* createTileMapLayer(int nIndex)
         case 25: return new TMXBug987();
         case 26: return new TMXBug787();
         case 27: return new TMXGIDObjectsTest();
+        case 28: return new TMXLargeMapTest();
+        case 29: return new TMXBatchEditTest();
     }
 
     return NULL;
@@ -1593,3 +1595,221 @@ string TMXGIDObjectsTest::subtitle()
 {
     return "Tiles are created from an object group";
 }
+
+//------------------------------------------------------------------
+//
+// TMXLargeMapTest
+//
+//------------------------------------------------------------------
+#define LARGE_MAP_SIZE    512
+
+static std::string base64Encode(const unsigned char *pData, unsigned int uLength)
+{
+    static const char s_alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+    std::string ret;
+    ret.reserve((uLength + 2) / 3 * 4);
+    for (unsigned int i = 0; i < uLength; i += 3)
+    {
+        unsigned int value = pData[i] << 16;
+        if (i + 1 < uLength) value |= pData[i + 1] << 8;
+        if (i + 2 < uLength) value |= pData[i + 2];
+
+        ret += s_alphabet[(value >> 18) & 63];
+        ret += s_alphabet[(value >> 12) & 63];
+        ret += i + 1 < uLength ? s_alphabet[(value >> 6) & 63] : '=';
+        ret += i + 2 < uLength ? s_alphabet[value & 63] : '=';
+    }
+    return ret;
+}
+
+TMXLargeMapTest::TMXLargeMapTest()
+{
+    // a 512x512 map of the tiles of orthogonal-test2.tmx, with a few empty tiles
+    std::vector<unsigned char> tiles(LARGE_MAP_SIZE * LARGE_MAP_SIZE * 4, 0);
+    for (unsigned int i = 0; i < LARGE_MAP_SIZE * LARGE_MAP_SIZE; ++i)
+    {
+        unsigned int gid = (i % 7 == 3) ? 0 : 1 + (i * 31 + i / LARGE_MAP_SIZE) % 150;
+        tiles[i * 4] = gid & 0xff;
+        tiles[i * 4 + 1] = (gid >> 8) & 0xff;
+    }
+
+    char szHeader[512] = {0};
+    sprintf(szHeader, "<?xml version=\"1.0\" encoding=\"UTF-8\"?>"
+        "<map version=\"1.0\" orientation=\"orthogonal\" width=\"%d\" height=\"%d\" tilewidth=\"32\" tileheight=\"32\">"
+        "<tileset firstgid=\"1\" name=\"tile 0\" tilewidth=\"32\" tileheight=\"32\" spacing=\"2\" margin=\"2\">"
+        "<image source=\"fixed-ortho-test2.png\"/></tileset>"
+        "<layer name=\"Layer 0\" width=\"%d\" height=\"%d\"><data encoding=\"base64\">",
+        LARGE_MAP_SIZE, LARGE_MAP_SIZE, LARGE_MAP_SIZE, LARGE_MAP_SIZE);
+    std::string xml = szHeader + base64Encode(&tiles[0], tiles.size()) + "</data></layer></map>";
+
+    struct cc_timeval start, now;
+    CCTime::gettimeofdayCocos2d(&start, NULL);
+    CCTMXTiledMap *map = CCTMXTiledMap::createWithXML(xml.c_str(), "TileMaps");
+    CCTime::gettimeofdayCocos2d(&now, NULL);
+    CCLog("TMXLargeMapTest: %dx%d tiles loaded in %.2f ms", LARGE_MAP_SIZE, LARGE_MAP_SIZE, CCTime::timersubCocos2d(&start, &now));
+
+    addChild(map, 0, kTagTileMap);
+
+    CCSize s = map->getContentSize();
+    CCActionInterval *move = CCMoveBy::create(30, ccp(-s.width / 2, -s.height / 2));
+    map->runAction(CCRepeatForever::create(CCSequence::create(move, move->reverse(), NULL)));
+
+    CCSize winSize = CCDirector::sharedDirector()->getWinSize();
+    m_pStats = CCLabelTTF::create("", "Arial", 16);
+    m_pStats->setPosition(ccp(winSize.width / 2, 40));
+    addChild(m_pStats, 1);
+
+    schedule(schedule_selector(TMXLargeMapTest::editTile));
+    schedule(schedule_selector(TMXLargeMapTest::updateStats), 0.5f);
+}
+
+// changes a tile in view every frame, which only rebuilds its chunk
+void TMXLargeMapTest::editTile(float dt)
+{
+    CCTMXTiledMap *map = (CCTMXTiledMap*)getChildByTag(kTagTileMap);
+    CCTMXLayer *layer = map->layerNamed("Layer 0");
+
+    CCSize winSize = CCDirector::sharedDirector()->getWinSize();
+    CCPoint center = map->convertToNodeSpace(ccp(winSize.width / 2, winSize.height / 2));
+    CCSize tileSize = map->getTileSize();
+    int x = (int)(center.x / tileSize.width) + rand() % 9 - 4;
+    int y = LARGE_MAP_SIZE - 1 - (int)(center.y / tileSize.height) + rand() % 9 - 4;
+    if (x >= 0 && x < LARGE_MAP_SIZE && y >= 0 && y < LARGE_MAP_SIZE)
+    {
+        layer->setTileGID(1 + rand() % 150, ccp(x, y));
+    }
+}
+
+void TMXLargeMapTest::updateStats(float dt)
+{
+    CCTMXTiledMap *map = (CCTMXTiledMap*)getChildByTag(kTagTileMap);
+    CCTMXLayer *layer = map->layerNamed("Layer 0");
+
+    char szStats[128] = {0};
+    sprintf(szStats, "%u chunks drawn, %u built", layer->getDrawnChunkCount(), layer->getBuiltChunkCount());
+    m_pStats->setString(szStats);
+}
+
+string TMXLargeMapTest::title()
+{
+    return "TMX large map";
+}
+
+string TMXLargeMapTest::subtitle()
+{
+    return "512x512 tiles, only the chunks in view are drawn";
+}
+
+//------------------------------------------------------------------
+//
+// TMXBatchEditTest
+//
+//------------------------------------------------------------------
+#define BATCH_EDIT_RADIUS       3
+#define BATCH_EDIT_RESET        12
+
+TMXBatchEditTest::TMXBatchEditTest()
+: m_nExplosions(0)
+, m_fRayAngle(0)
+, m_bRayHit(false)
+{
+    CCTMXTiledMap *map = CCTMXTiledMap::create("TileMaps/orthogonal-test2.tmx");
+    addChild(map, -1, kTagTileMap);
+
+    CCTMXLayer *layer = map->layerNamed("Layer 0");
+    CCSize s = layer->getLayerSize();
+    m_tOriginalTiles.assign(layer->getTiles(), layer->getTiles() + (int)(s.width * s.height));
+    for (unsigned int i = 0; i < m_tOriginalTiles.size(); ++i)
+    {
+        if (m_tOriginalTiles[i] != 0)
+        {
+            m_tGIDs.insert(m_tOriginalTiles[i] & kCCFlippedMask);
+        }
+    }
+
+    CCSize winSize = CCDirector::sharedDirector()->getWinSize();
+    m_pStats = CCLabelTTF::create("", "Arial", 16);
+    m_pStats->setPosition(ccp(winSize.width / 2, 40));
+    addChild(m_pStats, 1);
+
+    schedule(schedule_selector(TMXBatchEditTest::explode), 0.3f);
+}
+
+// clears a disc of tiles in view with a single setTileGIDs(), and restores the map from time to time
+void TMXBatchEditTest::explode(float dt)
+{
+    CCTMXTiledMap *map = (CCTMXTiledMap*)getChildByTag(kTagTileMap);
+    CCTMXLayer *layer = map->layerNamed("Layer 0");
+    CCSize s = layer->getLayerSize();
+    CCSize tileSize = map->getTileSize();
+    CCSize winSize = CCDirector::sharedDirector()->getWinSize();
+    int viewWidth = MIN((int)(winSize.width / tileSize.width), (int)s.width);
+    int viewHeight = MIN((int)(winSize.height / tileSize.height), (int)s.height);
+
+    if (++m_nExplosions % BATCH_EDIT_RESET == 0)
+    {
+        layer->setTileGIDs(CCRectMake(0, 0, s.width, s.height), &m_tOriginalTiles[0]);
+    }
+    else
+    {
+        int cx = rand() % viewWidth;
+        int cy = (int)s.height - 1 - rand() % viewHeight;
+        int x0 = MAX(cx - BATCH_EDIT_RADIUS, 0), x1 = MIN(cx + BATCH_EDIT_RADIUS, (int)s.width - 1);
+        int y0 = MAX(cy - BATCH_EDIT_RADIUS, 0), y1 = MIN(cy + BATCH_EDIT_RADIUS, (int)s.height - 1);
+
+        std::vector<unsigned int> gids;
+        for (int y = y0; y <= y1; ++y)
+        {
+            for (int x = x0; x <= x1; ++x)
+            {
+                bool inside = (x - cx) * (x - cx) + (y - cy) * (y - cy) <= BATCH_EDIT_RADIUS * BATCH_EDIT_RADIUS;
+                gids.push_back(inside ? 0 : layer->getTiles()[x + y * (int)s.width]);
+            }
+        }
+        layer->setTileGIDs(CCRectMake(x0, y0, x1 - x0 + 1, y1 - y0 + 1), &gids[0]);
+
+        // a ray from the center of the explosion stops at the first tile left
+        m_fRayAngle += 0.7f;
+        CCPoint from = ccp(cx + 0.5f, cy + 0.5f);
+        CCPoint to = ccpAdd(from, ccpMult(ccpForAngle(m_fRayAngle), (float)viewWidth));
+        CCPoint hit;
+        m_bRayHit = layer->firstTileAlongRay(from, to, hit);
+        m_tRayStart = layer->positionAt(ccp(cx, cy));
+        m_tRayEnd = m_bRayHit ? layer->positionAt(hit) : layer->positionAt(ccp(floorf(to.x), floorf(to.y)));
+    }
+
+    std::vector<CCPoint> tiles;
+    layer->tilesWithGIDs(CCRectMake(0, s.height - viewHeight, viewWidth, viewHeight), m_tGIDs, tiles);
+
+    char szStats[128] = {0};
+    sprintf(szStats, "%u tiles left in view", (unsigned int)tiles.size());
+    m_pStats->setString(szStats);
+}
+
+void TMXBatchEditTest::draw()
+{
+    if (m_nExplosions == 0)
+    {
+        return;
+    }
+
+    CCTMXTiledMap *map = (CCTMXTiledMap*)getChildByTag(kTagTileMap);
+    CCPoint half = ccpMult(ccpFromSize(map->getTileSize()), 0.5f);
+
+    glLineWidth(3);
+    ccDrawColor4B(255, m_bRayHit ? 0 : 255, 0, 255);
+    ccDrawLine(ccpAdd(m_tRayStart, half), ccpAdd(m_tRayEnd, half));
+    glLineWidth(1);
+    ccDrawColor4B(255, 255, 255, 255);
+}
+
+string TMXBatchEditTest::title()
+{
+    return "TMX batch edit";
+}
+
+string TMXBatchEditTest::subtitle()
+{
+    return "Explosions with setTileGIDs(), rays with firstTileAlongRay()";
+}
@@ -284,6 +284,41 @@ public:
     virtual void draw();
 };
 
+class TMXLargeMapTest : public TileDemo
+{
+public:
+    TMXLargeMapTest();
+    virtual std::string title();
+    virtual std::string subtitle();
+
+    void editTile(float dt);
+    void updateStats(float dt);
+
+private:
+    CCLabelTTF *m_pStats;
+};
+
+class TMXBatchEditTest : public TileDemo
+{
+public:
+    TMXBatchEditTest();
+    virtual std::string title();
+    virtual std::string subtitle();
+    virtual void draw();
+
+    void explode(float dt);
+
+private:
+    std::vector<unsigned int> m_tOriginalTiles;
+    std::set<unsigned int> m_tGIDs;
+    CCLabelTTF *m_pStats;
+    int m_nExplosions;
+    float m_fRayAngle;
+    CCPoint m_tRayStart;
+    CCPoint m_tRayEnd;
+    bool m_bRayHit;
+};
+
 class TileMapTestScene : public TestScene
 {
 public:
@@ -2,7 +2,6 @@
 #include "PlayerStatus.h"
 #include "cocos2d.h"
 #include "platform/android/jni/JniHelper.h"
-#include "CCEventType.h"
 #include <jni.h>
 #include <android/log.h>
 
@@ -35,13 +34,7 @@ void Java_org_cocos2dx_lib_Cocos2dxRenderer_nativeInit(JNIEnv*  env, jobject thi
     else
     {
       /*
-        ccDrawInit();
-        ccGLInvalidateStateCache();
-        
-        CCShaderCache::sharedShaderCache()->reloadDefaultShaders();
-	CCTextureCache::reloadAllTextures();
-	CCNotificationCenter::sharedNotificationCenter()->postNotification(EVNET_COME_TO_FOREGROUND, NULL);
-	CCDirector::sharedDirector()->setGLDefaultValues(); 
+        CCDirector::sharedDirector()->restoreGLContext();
       */
     }
 }
@@ -26,7 +26,7 @@ JSBool JSB_glActiveTexture(JSContext *cx, uint32_t argc, jsval *vp) {
 	ok &= JSB_jsval_to_uint32( cx, *argvp++, &arg0 );
 	JSB_PRECONDITION2(ok, cx, JS_FALSE, "Error processing arguments");
 
-	glActiveTexture((GLenum)arg0  );
+	cocos2d::ccGLActiveTexture((GLenum)arg0  );
 	JS_SET_RVAL(cx, vp, JSVAL_VOID);
 	return JS_TRUE;
 }
@@ -78,7 +78,7 @@ JSBool JSB_glBindBuffer(JSContext *cx, uint32_t argc, jsval *vp) {
 	ok &= JSB_jsval_to_uint32( cx, *argvp++, &arg1 );
 	JSB_PRECONDITION2(ok, cx, JS_FALSE, "Error processing arguments");
 
-	glBindBuffer((GLenum)arg0 , (GLuint)arg1  );
+	cocos2d::ccGLBindBuffer((GLenum)arg0 , (GLuint)arg1  );
 	JS_SET_RVAL(cx, vp, JSVAL_VOID);
 	return JS_TRUE;
 }
@@ -1142,7 +1142,7 @@ JSBool JSB_glScissor(JSContext *cx, uint32_t argc, jsval *vp) {
 	ok &= JSB_jsval_to_int32( cx, *argvp++, &arg3 );
 	JSB_PRECONDITION2(ok, cx, JS_FALSE, "Error processing arguments");
 
-	glScissor((GLint)arg0 , (GLint)arg1 , (GLsizei)arg2 , (GLsizei)arg3  );
+	cocos2d::ccGLScissor((GLint)arg0 , (GLint)arg1 , (GLsizei)arg2 , (GLsizei)arg3  );
 	JS_SET_RVAL(cx, vp, JSVAL_VOID);
 	return JS_TRUE;
 }
@@ -1708,7 +1708,7 @@ JSBool JSB_glUseProgram(JSContext *cx, uint32_t argc, jsval *vp) {
 	ok &= JSB_jsval_to_uint32( cx, *argvp++, &arg0 );
 	JSB_PRECONDITION2(ok, cx, JS_FALSE, "Error processing arguments");
 
-	glUseProgram((GLuint)arg0  );
+	cocos2d::ccGLUseProgram((GLuint)arg0  );
 	JS_SET_RVAL(cx, vp, JSVAL_VOID);
 	return JS_TRUE;
 }
@@ -1910,7 +1910,7 @@ JSBool JSB_glViewport(JSContext *cx, uint32_t argc, jsval *vp) {
 	ok &= JSB_jsval_to_int32( cx, *argvp++, &arg3 );
 	JSB_PRECONDITION2(ok, cx, JS_FALSE, "Error processing arguments");
 
-	glViewport((GLint)arg0 , (GLint)arg1 , (GLsizei)arg2 , (GLsizei)arg3  );
+	cocos2d::ccGLViewport((GLint)arg0 , (GLint)arg1 , (GLsizei)arg2 , (GLsizei)arg3  );
 	JS_SET_RVAL(cx, vp, JSVAL_VOID);
 	return JS_TRUE;
 }
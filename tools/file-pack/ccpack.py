@@ -0,0 +1,133 @@
+#!/usr/bin/python
+# ccpack.py
+# Build a file pack that CCFileUtils::addFilePack() can mount.
+# Copyright (c) 2013 cocos2d-x.org
+#
+# The layout is described in cocos2dx/platform/CCFilePack.h:
+#
+#   header      magic "CCPK", version, entryCount, indexOffset, namesOffset, namesSize, 2 x reserved
+#   index       entryCount x (hash, nameOffset, nameLength, compression, offset, compressedSize, size, reserved)
+#               sorted by (hash, name), hash is FNV-1a of the name
+#   names       NUL terminated
+#   data        every entry aligned to ALIGNMENT bytes
+#
+# All integers are 32 bit little endian.
+
+from __future__ import print_function
+
+import sys
+import os
+import struct
+import zlib
+import argparse
+
+MAGIC = b"CCPK"
+VERSION = 1
+ALIGNMENT = 16
+HEADER_FORMAT = "<4s7I"
+ENTRY_FORMAT = "<8I"
+
+COMPRESSION_NONE = 0
+COMPRESSION_ZLIB = 1
+
+# already compressed, deflating them again only costs load time
+STORED_EXTENSIONS = (".png", ".jpg", ".jpeg", ".webp", ".pvr.ccz", ".pvr.gz", ".mp3", ".ogg", ".m4a", ".zip", ".pack")
+
+
+def fnv1a(data):
+    h = 2166136261
+    for b in bytearray(data):
+        h ^= b
+        h = (h * 16777619) & 0xffffffff
+    return h
+
+
+def align(offset):
+    return (offset + ALIGNMENT - 1) & ~(ALIGNMENT - 1)
+
+
+def collect_files(root, excludes):
+    files = []
+    for dirpath, dirnames, filenames in os.walk(root):
+        dirnames.sort()
+        for filename in sorted(filenames):
+            path = os.path.join(dirpath, filename)
+            name = os.path.relpath(path, root).replace(os.sep, "/")
+            if any(name.endswith(ext) for ext in excludes):
+                continue
+            files.append((name, path))
+    return files
+
+
+def build_pack(files, output, prefix="", compress=False, verbose=False):
+    entries = []
+    for name, path in files:
+        with open(path, "rb") as f:
+            data = f.read()
+        name = (prefix + name).encode("utf-8")
+        compression = COMPRESSION_NONE
+        stored = data
+        if compress and not name.lower().endswith(tuple(e.encode("ascii") for e in STORED_EXTENSIONS)):
+            deflated = zlib.compress(data, 9)
+            # keep the entry mappable unless compression pays off
+            if len(deflated) < len(data) * 0.9:
+                compression = COMPRESSION_ZLIB
+                stored = deflated
+        entries.append({"name": name, "hash": fnv1a(name), "compression": compression,
+                        "data": stored, "size": len(data)})
+
+    entries.sort(key=lambda e: (e["hash"], e["name"]))
+
+    header_size = struct.calcsize(HEADER_FORMAT)
+    entry_size = struct.calcsize(ENTRY_FORMAT)
+    index_offset = header_size
+    names_offset = index_offset + entry_size * len(entries)
+
+    names = b""
+    for e in entries:
+        e["nameOffset"] = len(names)
+        names += e["name"] + b"\0"
+
+    offset = align(names_offset + len(names))
+    for e in entries:
+        e["offset"] = offset
+        offset = align(offset + len(e["data"]))
+
+    with open(output, "wb") as out:
+        out.write(struct.pack(HEADER_FORMAT, MAGIC, VERSION, len(entries), index_offset,
+                              names_offset, len(names), 0, 0))
+        for e in entries:
+            out.write(struct.pack(ENTRY_FORMAT, e["hash"], e["nameOffset"], len(e["name"]),
+                                  e["compression"], e["offset"], len(e["data"]), e["size"], 0))
+        out.write(names)
+        for e in entries:
+            out.write(b"\0" * (e["offset"] - out.tell()))
+            out.write(e["data"])
+            if verbose:
+                print("%-60s %8d -> %8d" % (e["name"].decode("utf-8"), e["size"], len(e["data"])))
+
+    total = sum(e["size"] for e in entries)
+    print("%s: %d files, %d bytes of data, %d bytes packed" % (output, len(entries), total, os.path.getsize(output)))
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Build a cocos2d-x file pack from a resource directory.")
+    parser.add_argument("root", help="resource directory, entries are named relative to it")
+    parser.add_argument("output", help="pack file to write")
+    parser.add_argument("-z", "--compress", action="store_true",
+                        help="deflate entries that shrink by more than 10%% (compressed entries are copied on read)")
+    parser.add_argument("-p", "--prefix", default="", help="prepended to every entry name, e.g. 'packed/'")
+    parser.add_argument("-x", "--exclude", action="append", default=[], help="skip files ending with this suffix")
+    parser.add_argument("-v", "--verbose", action="store_true")
+    args = parser.parse_args()
+
+    if not os.path.isdir(args.root):
+        print("%s is not a directory" % args.root, file=sys.stderr)
+        return 1
+
+    build_pack(collect_files(args.root, args.exclude), args.output, args.prefix, args.compress, args.verbose)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
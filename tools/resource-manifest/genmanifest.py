@@ -0,0 +1,63 @@
+#!/usr/bin/python
+# genmanifest.py
+# Write the resource manifest that CCFileUtils::loadResourceManifest() reads.
+# Copyright (c) 2013 cocos2d-x.org
+#
+# The manifest lists every file below the resource directory, one path per line, relative
+# to the resource directory and separated by '/'. Lines starting with '#' are ignored.
+# Regenerate it whenever files are added to or removed from the resources.
+
+from __future__ import print_function
+
+import sys
+import os
+import argparse
+
+HEADER = "# cocos2d-x resource manifest 1"
+
+
+def collect_files(root, excludes):
+    files = []
+    for dirpath, dirnames, filenames in os.walk(root):
+        # hidden directories, e.g. .svn
+        dirnames[:] = [d for d in dirnames if not d.startswith(".")]
+        for filename in filenames:
+            if filename.startswith("."):
+                continue
+            name = os.path.relpath(os.path.join(dirpath, filename), root).replace(os.sep, "/")
+            if any(name.endswith(ext) for ext in excludes):
+                continue
+            files.append(name)
+    return sorted(files)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Write a cocos2d-x resource manifest for a resource directory.")
+    parser.add_argument("root", help="resource directory")
+    parser.add_argument("-o", "--output", default="resources.manifest",
+                        help="manifest file, relative to the resource directory (default: resources.manifest)")
+    parser.add_argument("-x", "--exclude", action="append", default=[], help="skip files ending with this suffix")
+    args = parser.parse_args()
+
+    if not os.path.isdir(args.root):
+        print("%s is not a directory" % args.root, file=sys.stderr)
+        return 1
+
+    output = os.path.join(args.root, args.output)
+    files = collect_files(args.root, args.exclude)
+    manifest = args.output.replace(os.sep, "/")
+    if manifest not in files:
+        files.append(manifest)
+        files.sort()
+
+    with open(output, "w") as f:
+        f.write(HEADER + "\n")
+        for name in files:
+            f.write(name + "\n")
+
+    print("%s: %d files" % (output, len(files)))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
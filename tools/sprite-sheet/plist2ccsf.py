@@ -0,0 +1,124 @@
+#!/usr/bin/python
+# plist2ccsf.py
+# Convert sprite sheet plists (Zwoptex / TexturePacker formats 0 - 3) to binary sprite sheets,
+# which CCSpriteFrameCache::addSpriteFramesWithFile() loads without parsing any XML.
+# Copyright (c) 2013 cocos2d-x.org
+#
+# Layout, all integers and floats are 32 bit little endian:
+#
+#   header      magic "CCSF", version, frameCount, aliasCount, framesOffset, aliasesOffset,
+#               namesOffset, namesSize, textureNameOffset (0xffffffff if none), reserved
+#   frames      frameCount x (nameOffset, x, y, width, height, offsetX, offsetY,
+#                             originalWidth, originalHeight, rotated)
+#   aliases     aliasCount x (nameOffset, frameIndex)
+#   names       NUL terminated
+#
+# Frames hold the values CCSpriteFrame::initWithTexture() is called with.
+
+from __future__ import print_function
+
+import sys
+import os
+import re
+import struct
+import plistlib
+import argparse
+
+MAGIC = b"CCSF"
+VERSION = 1
+NO_NAME = 0xffffffff
+HEADER_FORMAT = "<4s9I"
+FRAME_FORMAT = "<I8fI"
+ALIAS_FORMAT = "<2I"
+
+
+def read_plist(path):
+    with open(path, "rb") as f:
+        if hasattr(plistlib, "load"):
+            return plistlib.load(f)
+        return plistlib.readPlist(f)
+
+
+def numbers(value):
+    """'{{1,2},{3,4}}' -> [1.0, 2.0, 3.0, 4.0], like CCRectFromString()"""
+    return [float(n) for n in re.findall(r"[-+]?[0-9]*\.?[0-9]+(?:[eE][-+]?[0-9]+)?", value)]
+
+
+def convert_frame(format, frame):
+    """returns (rect, rotated, offset, originalSize, aliases)"""
+    if format == 0:
+        ow = abs(int(frame.get("originalWidth", 0)))
+        oh = abs(int(frame.get("originalHeight", 0)))
+        rect = [float(frame["x"]), float(frame["y"]), float(frame["width"]), float(frame["height"])]
+        offset = [float(frame.get("offsetX", 0)), float(frame.get("offsetY", 0))]
+        return rect, False, offset, [float(ow), float(oh)], []
+    if format == 1 or format == 2:
+        rotated = format == 2 and bool(frame.get("rotated", False))
+        return numbers(frame["frame"]), rotated, numbers(frame["offset"]), numbers(frame["sourceSize"]), []
+    if format == 3:
+        size = numbers(frame["spriteSize"])
+        texture_rect = numbers(frame["textureRect"])
+        rect = [texture_rect[0], texture_rect[1], size[0], size[1]]
+        return (rect, bool(frame.get("textureRotated", False)), numbers(frame["spriteOffset"]),
+                numbers(frame["spriteSourceSize"]), list(frame.get("aliases", [])))
+    raise ValueError("format %d is not supported" % format)
+
+
+def convert(plist_path, output):
+    plist = read_plist(plist_path)
+    metadata = plist.get("metadata", {})
+    format = int(metadata.get("format", 0))
+    texture = metadata.get("textureFileName", "")
+
+    names = bytearray()
+
+    def add_name(name):
+        offset = len(names)
+        names.extend(name.encode("utf-8") + b"\0")
+        return offset
+
+    frames = []
+    aliases = []
+    for name in sorted(plist["frames"].keys()):
+        rect, rotated, offset, original, frame_aliases = convert_frame(format, plist["frames"][name])
+        frames.append(struct.pack(FRAME_FORMAT, add_name(name), rect[0], rect[1], rect[2], rect[3],
+                                  offset[0], offset[1], original[0], original[1], 1 if rotated else 0))
+        for alias in frame_aliases:
+            aliases.append(struct.pack(ALIAS_FORMAT, add_name(alias), len(frames) - 1))
+
+    texture_offset = add_name(texture) if texture else NO_NAME
+
+    frames_offset = struct.calcsize(HEADER_FORMAT)
+    aliases_offset = frames_offset + len(frames) * struct.calcsize(FRAME_FORMAT)
+    names_offset = aliases_offset + len(aliases) * struct.calcsize(ALIAS_FORMAT)
+
+    with open(output, "wb") as f:
+        f.write(struct.pack(HEADER_FORMAT, MAGIC, VERSION, len(frames), len(aliases), frames_offset,
+                            aliases_offset, names_offset, len(names), texture_offset, 0))
+        for frame in frames:
+            f.write(frame)
+        for alias in aliases:
+            f.write(alias)
+        f.write(bytes(names))
+
+    print("%s: %d frames, %d aliases, %d bytes (plist %d bytes)" % (output, len(frames), len(aliases),
+          os.path.getsize(output), os.path.getsize(plist_path)))
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Convert sprite sheet plists to binary sprite sheets.")
+    parser.add_argument("plists", nargs="+", help="sprite sheet plists, written next to them with the extension .ccsf")
+    parser.add_argument("-o", "--output", help="output file, only with a single plist")
+    args = parser.parse_args()
+
+    if args.output and len(args.plists) > 1:
+        print("--output needs a single plist", file=sys.stderr)
+        return 1
+
+    for plist in args.plists:
+        convert(plist, args.output or os.path.splitext(plist)[0] + ".ccsf")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())